@@ -235,7 +235,7 @@ class KMeans(PythonWrapper.KMeans) :
     :type cluster_count: int
 
     :param algo: the algorithm used during clustering.
-    :type algo: str, {'elkan', 'lloyd'}, default='lloyd'
+    :type algo: str, {'elkan', 'lloyd', 'minibatch', 'hamerly'}, default='lloyd'
 
     :param init: the algorithm used for selecting initial centers.
     :type init: str, {'k++', 'default'}, default='default'
@@ -251,12 +251,16 @@ class KMeans(PythonWrapper.KMeans) :
 
     :param seed: the initial seed for random
     :type seed: int, default=3306
+
+    :param mini_batch_size: the number of samples in a batch for the 'minibatch' algorithm;
+        in this case max_iteration_count is the number of batches
+    :type mini_batch_size: int, > 0, default=1024
     """
 
     def __init__(self, max_iteration_count, cluster_count, algo='lloyd', init='default', distance='euclid',
-                 thread_count=1, run_count=1, seed=3306):
-        if algo != 'elkan' and algo != 'lloyd':
-            raise ValueError('The `algo` must be one of {`elkan`, `lloyd`}.')
+                 thread_count=1, run_count=1, seed=3306, mini_batch_size=1024):
+        if algo != 'elkan' and algo != 'lloyd' and algo != 'minibatch' and algo != 'hamerly':
+            raise ValueError('The `algo` must be one of {`elkan`, `lloyd`, `minibatch`, `hamerly`}.')
         if init != 'k++' and init != 'default':
             raise ValueError('The `init` must be one of {`k++`, `default`}.')
         if distance != 'euclid' and distance != 'machalanobis' and distance != 'cosine':
@@ -271,8 +275,10 @@ class KMeans(PythonWrapper.KMeans) :
             raise ValueError('The `run_count` must be > 0')
         if not isinstance(seed, int):
             raise ValueError('The `seed` must be integer')
+        if mini_batch_size <= 0:
+            raise ValueError('The `mini_batch_size` must be > 0')
         super().__init__(algo, init, distance, int(max_iteration_count), int(cluster_count), int(thread_count),
-            int(run_count), int(seed))
+            int(run_count), int(seed), int(mini_batch_size))
 
     def clusterize(self, X, weight=None):
         """Performs clustering of the given data.
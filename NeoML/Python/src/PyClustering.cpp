@@ -199,7 +199,7 @@ void InitializeClustering(py::module& m)
 	py::class_<CPyKMeans>(m, "KMeans")
 		.def( py::init(
 			[]( const std::string& algo, const std::string& init, const std::string& distance,
-				int max_iteration_count, int cluster_count, int thread_count, int run_count, int seed )
+				int max_iteration_count, int cluster_count, int thread_count, int run_count, int seed, int mini_batch_size )
 			{
 				CKMeansClustering::CParam p;
 
@@ -208,6 +208,10 @@ void InitializeClustering(py::module& m)
 					p.Algo = CKMeansClustering::KMA_Lloyd;
 				} else if( algo == "elkan" ) {
 					p.Algo = CKMeansClustering::KMA_Elkan;
+				} else if( algo == "minibatch" ) {
+					p.Algo = CKMeansClustering::KMA_MiniBatch;
+				} else if( algo == "hamerly" ) {
+					p.Algo = CKMeansClustering::KMA_Hamerly;
 				}
 				p.Initialization = CKMeansClustering::KMI_Count;
 				if( init == "default" ) {
@@ -229,6 +233,7 @@ void InitializeClustering(py::module& m)
 				p.ThreadCount = thread_count;
 				p.RunCount = run_count;
 				p.Seed = seed;
+				p.MiniBatchSize = mini_batch_size;
 				return new CPyKMeans( p );
 			})
 		)
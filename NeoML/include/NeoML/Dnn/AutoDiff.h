@@ -46,6 +46,44 @@ private:
 
 //------------------------------------------------------------------------------------------------------------
 
+class CTapeGraphImpl;
+
+// The expression recorded on a gradient tape and compiled into a graph.
+// Use it when the same expression (a custom loss function, for example) is calculated on every step:
+// the expression is traced once and then evaluated for the new input values without recording the tape again.
+// The chains of elementwise operations are fused and calculated by small tiles, without storing the intermediate results,
+// and the gradients are calculated in reverse mode (vector-jacobian products) instead of building the jacobians.
+// Only the functions from AutoDiffFunctions.h may be compiled, not the user-defined operations.
+class NEOML_API CTapeGraph {
+public:
+	// Traces the expression which has been calculated using the tape.
+	// The inputs are the blobs whose values may change between the calls: the tape variables and, for example, the labels.
+	// All other blobs used in the expression are copied and treated as constants.
+	// The current values of the inputs are used until SetInput is called.
+	CTapeGraph( const CDnnBlob& expression, const CArray<const CDnnBlob*>& inputs );
+	~CTapeGraph();
+
+	// The number of the inputs
+	int GetInputCount() const;
+	// Sets the new value of the input; the blob should have the same size as the traced one
+	void SetInput( int index, const CDnnBlob& blob );
+
+	// Calculates the expression for the current input values.
+	// The returned blob is overwritten by the next call.
+	CPtr<const CDnnBlob> Run();
+	// Computes the gradient of the expression by the input, as CGradientTape::Gradient does.
+	// Returns 0 if the input is not a tape blob.
+	CPtr<const CDnnBlob> Gradient( int index );
+
+private:
+	CPtr<CTapeGraphImpl> impl;
+
+	CTapeGraph( const CTapeGraph& ) = delete;
+	CTapeGraph& operator=( const CTapeGraph& ) = delete;
+};
+
+//------------------------------------------------------------------------------------------------------------
+
 // The blob with the info needed for gradient calculation.
 class NEOML_API CTapeBlob : public CDnnBlob {
 public:
@@ -206,6 +206,9 @@ protected:
 	virtual void BackwardOnce() = 0;
 	// A virtual method that implements one learning step
 	virtual void LearnOnce();
+	// Indicates that LearnOnce passes the parameter gradients to the solver by itself, using CDnnSolver::AddSparseDiff
+	// In that case paramDiffBlobs are not created
+	virtual bool HasSparseParamDiffs() const { return false; }
 	// Indicates that learning must be performed for the layer on the current step
 	bool IsLearningPerformed() const;
 	// Indicates that learning must be performed for the layer when Learn method is called
@@ -263,6 +266,11 @@ protected:
 	// Fills with zeros the parameters that are less (but not equal) than a given threshold
 	virtual void FilterLayerParams( float /*threshold*/ ) {}
 
+	// Makes the layer use the trainable parameters of another layer of the same type and configuration
+	// The blobs are shared, not copied; used by CDnnExecutionContext
+	// The layers that keep parameters outside of paramBlobs should override this method
+	virtual void ShareParamBlobs( const CBaseLayer& source );
+
 	// Retrieves the reference to the IMathEngine with which the layer was created
 	IMathEngine& MathEngine() const;
 
@@ -383,6 +391,9 @@ private:
 	friend class CDnn;
 	friend class CDnnLayerGraph;
 	friend class CDnnSolver;
+	friend class CCompositeLayer;
+	friend class CDnnExecutionContext;
+	friend class CDnnOptimizer;
 };
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -539,6 +550,17 @@ public:
 	// Enables profiling for all the layers in the network
 	void EnableProfile( bool profile );
 
+	// Static memory planning for inference
+	// When enabled, RunOnce places the outputs of all the layers into one buffer;
+	// the outputs whose lifetimes do not overlap share memory
+	// The plan is built after each reshape, so the runs with the same input sizes allocate no memory for the outputs
+	// Only the outputs connected to the sink layers are valid after the run
+	void EnableStaticMemoryPlanning();
+	void DisableStaticMemoryPlanning();
+	bool IsStaticMemoryPlanningEnabled() const { return isStaticMemoryPlanningEnabled; }
+	// The size of the buffer used by the current plan, in bytes (0 if the plan has not been built)
+	size_t GetMemoryPlanSize() const;
+
 private:
 	// Adds or deletes a layer
 	void AddLayerImpl(CBaseLayer& layer) override;
@@ -580,6 +602,12 @@ private:
 	bool autoRestartMode;
 	// The low memory use mode
 	bool isReuseMemoryMode;
+	// Static memory planning
+	bool isStaticMemoryPlanningEnabled;
+	// Indicates that the memory plan corresponds to the current blob sizes
+	bool isMemoryPlanValid;
+	// The buffer that contains all the outputs planned
+	CPtr<CDnnBlob> memoryPlanBuffer;
 
 	void setProcessingParams(bool isRecurrentMode, int sequenceLength, bool isReverseSequense, bool isBackwardPerformed);
 	void runOnce(int curSequencePos);
@@ -587,6 +615,7 @@ private:
 	void reshape();
 	void rebuild();
 	size_t getOutputBlobsSize() const;
+	void buildMemoryPlan();
 
 	friend class CBaseLayer;
 	friend class CCompositeLayer;
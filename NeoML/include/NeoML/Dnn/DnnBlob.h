@@ -56,6 +56,9 @@ public:
 		int imageHeight, int imageWidth, int imageDepth, int channelsCount );
 	// Creates a "window" blob to represent a subsequence of objects from the parent blob
 	static CDnnBlob* CreateWindowBlob(const CPtr<CDnnBlob>& parent, int windowSize = 1);
+	// Creates a blob that uses the owner's memory starting from the given element
+	// The owner is kept alive while the view exists
+	static CDnnBlob* CreateViewBlob( const CPtr<CDnnBlob>& owner, const CBlobDesc& desc, int offset );
 	// Creates a blob according to the provided descriptor
 	static CDnnBlob* CreateBlob(IMathEngine& mathEngine, const CBlobDesc& pattern);
 	static CDnnBlob* CreateBlob(IMathEngine& mathEngine, TBlobType type, const CBlobDesc& pattern);
@@ -180,11 +183,17 @@ public:
 	static void SplitByBatchLength( IMathEngine& mathEngine, const CPtr<CDnnBlob>& from, const CObjectArray<CDnnBlob>& to );
 	static void SplitByObject( IMathEngine& mathEngine, const CPtr<CDnnBlob>& from, const CObjectArray<CDnnBlob>& to );
 
+	// If the archive is loaded from CMappedArchiveFile and the math engine can access the host memory,
+	// the blob data is not copied: the blob points directly into the read-only mapped file
 	virtual void Serialize( CArchive& );
 
 	// Gets the pointer to the MathEngine on which the blob was created
 	IMathEngine& GetMathEngine() const { return mathEngine; }
 
+	// Indicates if the blob data may not be changed
+	// (the blob points into a read-only memory-mapped file, see Serialize)
+	bool IsReadOnly() const { return parent != 0 ? parent->IsReadOnly() : isReadOnly; }
+
 	// Gets the blob descriptor
 	const CBlobDesc& GetDesc() const { return desc; }
 	// Gets the type of data in the blob
@@ -208,7 +217,7 @@ protected:
 	virtual ~CDnnBlob();
 
 	CDnnBlob( IMathEngine& _mathEngine, const CBlobDesc& _desc, CMemoryHandle _data, bool _dataOwned ) :
-		mathEngine( _mathEngine ), desc( _desc ), data( _data ), dataOwned( _dataOwned ), parentPos( 0 )
+		mathEngine( _mathEngine ), desc( _desc ), data( _data ), dataOwned( _dataOwned ), parentPos( 0 ), isReadOnly( false )
 	{
 		NeoAssert( desc.GetDataType() != CT_Invalid );
 		NeoAssert( &mathEngine == data.GetMathEngine() );
@@ -222,6 +231,9 @@ private:
 
 	CPtr<CDnnBlob> parent;	// parent blob
 	int parentPos;
+	// The object that owns the external memory used by the blob (e.g. the memory-mapped file)
+	CPtr<IObject> externalData;
+	bool isReadOnly;
 
 	void initializeBlob(TBlobType _type, int batchLength, int batchWidth, int listSize, int height, int width,
 		int depth, int channels);
@@ -317,6 +329,7 @@ template<class T>
 inline void CDnnBlob::Fill(typename CBlobType<T>::TDataType value)
 {
 	NeoAssert(GetDataType() == CBlobType<T>::GetType());
+	NeoAssert(!IsReadOnly());
 	mathEngine.VectorFill(GetData<T>(), value, GetDataSize());
 }
 
@@ -324,6 +337,7 @@ template<class T>
 inline void CDnnBlob::FillObject(int num, typename CBlobType<T>::TDataType value)
 {
 	NeoAssert(GetDataType() == CBlobType<T>::GetType());
+	NeoAssert(!IsReadOnly());
 	mathEngine.VectorFill(GetObjectData<T>(num), value, GetObjectSize());
 }
 
@@ -394,6 +408,7 @@ inline CTypedMemoryHandle<T> CDnnBlob::GetObjectData( int objectNum )
 template<class T>
 inline void CDnnBlob::CopyFrom(const T* src)
 {
+	NeoAssert(!IsReadOnly());
 	mathEngine.DataExchangeRaw(GetData<T>(), src, GetDataSize() * sizeof(T));
 }
 
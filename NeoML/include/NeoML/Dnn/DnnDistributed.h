@@ -0,0 +1,99 @@
+/* Copyright © 2021 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <NeoML/NeoMLDefs.h>
+#include <NeoML/Random.h>
+#include <NeoML/Dnn/Dnn.h>
+
+namespace NeoML {
+
+// The interface that provides the input data for the network replicas
+class NEOML_API IDistributedDataset {
+public:
+	virtual ~IDistributedDataset();
+
+	// Sets the input blobs of the source layers of the replica with the given index
+	// The blobs should be created using the replica's math engine (dnn.GetMathEngine())
+	// The method is called from several threads at once, each with its own index
+	virtual void SetInputBatch( CDnn& dnn, int index ) = 0;
+};
+
+// CDistributedTraining trains one network on several CPU math engines (data parallelism)
+// Each math engine holds a replica of the network with its own solver
+// On each step every replica runs forward and backward passes on its part of the data,
+// then the gradients are averaged over the replicas and all the replicas make the same training step
+// Each replica is run by its own thread
+class NEOML_API CDistributedTraining {
+public:
+	// Creates count replicas of the network, each on a new CPU math engine with threadCount threads
+	// threadCount == 0 means that the CPU cores are split evenly between the replicas
+	// The architecture, the trained parameters and the solver with its state are copied from the network
+	// If the network hasn't been initialized yet, the replicas initialize their parameters in the same way
+	// The network must use CDnnXavierInitializer or CDnnUniformInitializer; other initializers are not supported
+	CDistributedTraining( CDnn& dnn, int count, int threadCount = 0 );
+	~CDistributedTraining();
+
+	// The number of the replicas
+	int GetModelCount() const { return cnns.Size(); }
+	// The replica with the given index
+	CDnn& GetModel( int index ) { return *cnns[index]; }
+	const CDnn& GetModel( int index ) const { return *cnns[index]; }
+
+	// The learning rate of the solvers of all replicas
+	float GetLearningRate() const;
+	void SetLearningRate( float newRate );
+
+	// Runs the networks without backward pass
+	void RunOnce( IDistributedDataset& data );
+	// Runs the forward and backward passes; the gradients are accumulated until the Train call
+	void RunAndBackwardOnce( IDistributedDataset& data );
+	// Averages the accumulated gradients over the replicas and trains all of them
+	void Train();
+	// Runs the forward and backward passes and trains the networks
+	void RunAndLearnOnce( IDistributedDataset& data );
+
+	// The loss of the given loss layer averaged over the replicas
+	float GetLastLoss( const CString& layerName ) const;
+	// The outputs of the given sink layer of all replicas
+	void GetLastBlob( const CString& layerName, CObjectArray<CDnnBlob>& blobs ) const;
+
+	// Stores the trained network (the replicas are the same after each training step)
+	void Serialize( CArchive& archive );
+	// Stores the trained network together with the solver
+	void SerializeCheckpoint( CArchive& archive );
+
+private:
+	class CWorkerThreads;
+
+	CArray<IMathEngine*> mathEngines;
+	CPointerArray<CRandom> randoms;
+	CPointerArray<CRandom> initRandoms; // the random generators of the replicas' initializers
+	CPointerArray<CDnn> cnns;
+	CWorkerThreads* threads;
+	// The layers of each replica including the ones inside the composite layers
+	// The layers with the same index in different replicas correspond to each other
+	CPointerArray<CArray<CBaseLayer*>> layers;
+	CMap<CBaseLayer*, int> firstReplicaLayerIndex;
+
+	void collectLayers();
+	void allReduce();
+
+	CDistributedTraining( const CDistributedTraining& );
+	CDistributedTraining& operator=( const CDistributedTraining& );
+};
+
+} // namespace NeoML
@@ -0,0 +1,59 @@
+/* Copyright © 2017-2021 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+
+#pragma once
+
+#include <NeoML/NeoMLDefs.h>
+#include <NeoML/Random.h>
+#include <NeoML/Dnn/Dnn.h>
+
+namespace NeoML {
+
+// CDnnExecutionContext runs inference of a network using the trainable parameters of another network
+// The context holds its own copy of the layer graph with its own input, output and intermediate blobs,
+// while the parameter blobs are shared with the original network (the weights are not copied)
+// Several contexts created from the same network may be run concurrently in different threads
+// (but each context may be used by only one thread at a time)
+// Restrictions:
+//   - the original network should have been run or loaded before the contexts are created
+//   - the original network should not be trained or changed while its contexts are in use
+//   - the contexts should be created from one thread
+//   - the contexts may be used only for inference
+class NEOML_API CDnnExecutionContext {
+public:
+	explicit CDnnExecutionContext( CDnn& dnn );
+
+	// Sets the input blob for the source layer with the given name
+	void SetInputBlob( const char* sourceName, CDnnBlob* blob );
+	// Runs the network
+	void RunOnce();
+	// Gets the result of the sink layer with the given name
+	// The blob is overwritten on the next run
+	const CPtr<CDnnBlob>& GetOutputBlob( const char* sinkName ) const;
+
+	// The internal network; may be used to access the layers
+	CDnn& GetDnn() { return dnn; }
+	const CDnn& GetDnn() const { return dnn; }
+
+private:
+	CRandom random;
+	CDnn dnn;
+
+	CDnnExecutionContext( const CDnnExecutionContext& );
+	CDnnExecutionContext& operator=( const CDnnExecutionContext& );
+};
+
+} // namespace NeoML
@@ -0,0 +1,57 @@
+/* Copyright © 2017-2021 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <NeoML/NeoMLDefs.h>
+
+namespace NeoML {
+
+class CDnn;
+class CBaseLayer;
+
+// CDnnOptimizer simplifies a trained network for inference by merging layers
+// The batch normalization layers that follow convolution or fully connected layers are folded into their weights
+// The activation layers (see ActivationLayers.h and CGELULayer) that follow convolution or fully connected layers
+// are merged into these layers; the activation is passed to the convolution or matrix multiplication
+// and applied to each part of the output right after it is calculated, without a separate pass over the output
+// Only the layers whose output goes into the merged layer alone are affected; the sinks and their names are preserved
+// Only the top-level layers of the network are processed
+// After optimization the network may be used only for inference; it may be serialized as usual
+class NEOML_API CDnnOptimizer {
+public:
+	explicit CDnnOptimizer( CDnn& dnn );
+
+	// Folds the batch normalization layers into the preceding layers
+	// Returns the number of removed layers
+	int FoldBatchNormalization();
+
+	// Merges the activation layers into the preceding layers
+	// Returns the number of removed layers
+	int MergeActivations();
+
+	// Performs all the optimizations
+	// Returns the number of removed layers
+	int Optimize();
+
+private:
+	CDnn& dnn;
+
+	static bool hasParamBlobs( const CBaseLayer& layer );
+	bool hasSingleConsumer( const CBaseLayer& layer ) const;
+	void removeLayer( CBaseLayer& layer, const CBaseLayer& replacement );
+};
+
+} // namespace NeoML
@@ -0,0 +1,107 @@
+/* Copyright © 2017-2021 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <NeoML/NeoMLDefs.h>
+#include <NeoML/Dnn/DnnBlob.h>
+
+namespace NeoML {
+
+class CDnn;
+class CDnnLayerGraph;
+
+// CQuantizedWeights stores the weights of a layer quantized into 8-bit integers
+// The weights matrix (one row per output channel) is quantized symmetrically with a separate scale for each row
+// The layer input is quantized on the fly with the scale and zero point calculated from the range observed on calibration
+// Used by the layers that support quantized inference (CFullyConnectedLayer and CConvLayer)
+class NEOML_API CQuantizedWeights {
+public:
+	explicit CQuantizedWeights( IMathEngine& mathEngine );
+
+	// Calibration: while it is on, the layer passes its inputs to UpdateInputRange
+	bool IsCalibrating() const { return isCalibrating; }
+	void SetCalibrating( bool _isCalibrating ) { isCalibrating = _isCalibrating; }
+	// Extends the input range with the values of the blob
+	void UpdateInputRange( const CDnnBlob& input );
+	// Indicates if the input range has been collected
+	bool HasInputRange() const { return inputMin <= inputMax; }
+	void ResetInputRange();
+
+	// Quantizes the weights; the input range should be collected before that
+	// The weights blob is treated as an ObjectCount * ObjectSize matrix
+	void Quantize( const CDnnBlob& weights );
+	bool IsQuantized() const { return quantizedData != nullptr; }
+	// Removes the quantized weights (the input range is kept)
+	void Reset();
+
+	// Restores the float weights from the quantized representation
+	CPtr<CDnnBlob> Dequantize() const;
+	// Makes this object use the quantized weights of another one (the blobs are shared, not copied)
+	void Share( const CQuantizedWeights& other );
+
+	// The parameters of the quantized representation (valid only if IsQuantized())
+	const CBlobDesc& GetWeightsDesc() const { return weightsDesc; }
+	CConstInt8Handle GetData() const { return CConstInt8Handle( quantizedData->GetData<int>() ); }
+	CConstFloatHandle GetScales() const { return scales->GetData(); }
+	float GetInputScale() const { return inputScale; }
+	int GetInputZeroPoint() const { return inputZeroPoint; }
+
+	void Serialize( CArchive& archive );
+
+private:
+	IMathEngine& mathEngine;
+	bool isCalibrating; // indicates if the input range is being collected
+	float inputMin; // the input range
+	float inputMax;
+	float inputScale; // the input quantization parameters
+	int inputZeroPoint;
+	CBlobDesc weightsDesc; // the original weights size
+	// The quantized weights; 4 8-bit values are packed into each element of the integer blob
+	CPtr<CDnnBlob> quantizedData;
+	CPtr<CDnnBlob> scales; // the scales of the weights matrix rows
+
+	void calcInputQuantization();
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// CDnnQuantizer converts a trained network for 8-bit quantized inference
+// Only the CPU math engine supports quantized inference
+// The fully connected and convolution layers are converted (including the ones inside composite layers)
+// Usage:
+//   CDnnQuantizer quantizer( dnn );
+//   for each calibration sample: set the source blobs, call quantizer.RunCalibration()
+//   quantizer.Quantize();
+// After quantization the network may be used only for inference; it may be serialized as usual
+class NEOML_API CDnnQuantizer {
+public:
+	explicit CDnnQuantizer( CDnn& dnn );
+
+	// Runs the network once on the current data of the source layers and extends the input ranges of the layers
+	void RunCalibration();
+
+	// Quantizes all the layers that have been calibrated
+	// Returns the number of quantized layers
+	int Quantize();
+
+private:
+	CDnn& dnn;
+
+	static void setCalibrating( CDnnLayerGraph& graph, bool isCalibrating );
+	static int quantize( CDnnLayerGraph& graph );
+};
+
+} // namespace NeoML
@@ -23,6 +23,7 @@ namespace NeoML {
 class CDnnBlob;
 class CBaseLayer;
 class CDnn;
+class CDistributedTraining;
 
 // The base optimizer class
 class NEOML_API CDnnSolver : virtual public IObject {
@@ -31,6 +32,13 @@ public:
 	// forSharedWeightsLayer=true should only be used within layers that share weights with other layers.
 	void AddDiff( CBaseLayer* layer, const CObjectArray<CDnnBlob>& paramDiffBlobs, 
 		bool sharedWeights = false );
+	// Stores the gradients that are nonzero only in several objects (rows) of the layer parameter blobs
+	// rows[i] contains the indices of these objects in the i'th parameter blob, without repetitions,
+	// rowDiffBlobs[i] contains their gradients, one object per index
+	// If the solver supports it (see CanTrainRows), only these rows of the parameters are updated,
+	// so the cost of the training step depends on the number of rows and not on the blob size
+	void AddSparseDiff( CBaseLayer* layer, const CArray<CArray<int>>& rows, const CObjectArray<CDnnBlob>& rowDiffBlobs,
+		bool sharedWeights = false );
 
 	// Modifies the trainable parameters of the network layers, 
 	// using the accumulated gradients and previous steps' history (moment, etc.) 
@@ -51,6 +59,21 @@ public:
 	float GetMaxGradientNorm() const { return maxGradientNorm; }
 	void SetMaxGradientNorm(float _maxGradientNorm) { maxGradientNorm = _maxGradientNorm; }
 
+	// The parameter arena mode
+	// When it is on, the parameters of all the trained layers are packed into one contiguous buffer
+	// and the layers' parameter blobs become views of that buffer; the layers calculate their gradients
+	// right in the gradient buffer, and the gradient history is packed the same way. The layers with equal learning rate and regularization multipliers
+	// are then trained in a single TrainLayer call
+	// The arena is rebuilt if a layer replaces its parameter blobs, so the layers must not keep
+	// other references to their parameter blobs. The layers that share the parameters are trained separately
+	// By default is off
+	void EnableParamArena( bool enable );
+	bool IsParamArenaEnabled() const { return isParamArenaEnabled; }
+	// The buffers with the parameters and the gradients of all the layers in the arena
+	// Are null until the first training step in the arena mode
+	CPtr<CDnnBlob> GetParamArena() const { return paramArena; }
+	CPtr<CDnnBlob> GetParamDiffArena() const { return paramDiffArena; }
+
 	// Serialize to archive
 	virtual void Serialize( CArchive& archive, CDnn& dnn );
 
@@ -73,12 +96,30 @@ protected:
 	virtual void TrainLayer( const CBaseLayer* layer, const CObjectArray<CDnnBlob>& paramBlobs,
 		const CObjectArray<CDnnBlob>& paramDiffBlobs, CObjectArray<CDnnBlob>& learningHistory ) = 0;
 
+	// Indicates if the parameters of several layers may be trained in one TrainLayer call in the arena mode
+	// In that case TrainLayer receives the first layer of the group, and each of the blobs spans the whole group
+	// The solvers that use per-layer statistics should return false
+	virtual bool CanTrainLayersTogether() const { return true; }
+
+	// Indicates if the solver may update only the rows of the parameters that have the sparse gradients
+	// In that case TrainLayer receives the blobs that contain only these rows of the parameters and of the history,
+	// one parameter blob at a time; the history should contain one blob per history type per parameter blob,
+	// in the [historyType * paramBlobs.Size() + paramIndex] order. The history of the other rows is not changed
+	// Otherwise the sparse gradients are converted into the usual ones
+	virtual bool CanTrainRows() const { return false; }
+
 private:
+	// Averages the accumulated gradients of the network replicas
+	friend class CDistributedTraining;
+	// Creates the gradient blobs of the layers
+	friend class CBaseLayer;
+
 	IMathEngine& mathEngine;
 	float learningRate;
 	float regularizationL2;
 	float regularizationL1;
 	float maxGradientNorm;
+	bool isParamArenaEnabled;
 
 	// The blobs sum
 	struct CDiffBlobSum {
@@ -94,6 +135,59 @@ private:
 	// Used in the inheriting classes
 	CMap<CBaseLayer*, CObjectArray<CDnnBlob>> layerToGradientHistory;
 
+	// The sum of the sparse gradients
+	struct CSparseDiffSum {
+		CSparseDiffSum() : Count( 0 ) {}
+
+		CArray<CArray<int>> Rows; // the rows of each parameter blob that have the gradients
+		CObjectArray<CDnnBlob> Sum; // the gradients of these rows
+		int Count; // the number of terms in each sum
+	};
+	// The buffers used to add up the gradients from several AddSparseDiff calls
+	CMap<CBaseLayer*, CSparseDiffSum> layerToSparseDiffSum;
+
+	// The layer whose parameters are stored in the arena
+	struct CArenaLayer {
+		CBaseLayer* Layer;
+		int Offset; // the position of the first parameter in the arena
+		int Size; // the total size of the parameters
+		CObjectArray<CDnnBlob> Params; // the views of the parameter arena, the same as the layer's paramBlobs
+		CObjectArray<CDnnBlob> Diffs; // the views of the gradient arena
+		CObjectArray<CDnnBlob> DiffSpan; // one blob spanning all the layer gradients
+	};
+	// The consecutive arena layers with the same learning settings
+	struct CArenaGroup {
+		int FirstLayer;
+		int LayerCount;
+		CObjectArray<CDnnBlob> Params; // one blob spanning the parameters of all the group layers
+		CObjectArray<CDnnBlob> Diffs; // one blob spanning the gradients of all the group layers
+		CObjectArray<CDnnBlob> History; // the gradient history of the whole group
+		bool IsHistoryShared; // the per-layer gradient history entries are views of History
+	};
+
+	CPtr<CDnnBlob> paramArena;
+	CPtr<CDnnBlob> paramDiffArena;
+	CPointerArray<CArenaLayer> arenaLayers;
+	CPointerArray<CArenaGroup> arenaGroups;
+	CMap<CBaseLayer*, int> layerToArenaIndex;
+	// The trained layers that can't be stored in the arena
+	CHashTable<CBaseLayer*> arenaExcludedLayers;
+
+	void createParamDiffBlobs( CBaseLayer& layer, CObjectArray<CDnnBlob>& paramDiffBlobs );
+	bool isArenaValid() const;
+	bool isArenaLayerValid( const CArenaLayer& arenaLayer ) const;
+	bool canAddToArena( const CBaseLayer& layer, const CObjectArray<CDnnBlob>& paramDiffBlobs,
+		const CMap<CDnnBlob*, int>& blobUseCount ) const;
+	void buildArena();
+	void clearArena();
+	void clearArenaHistory();
+	void trainArenaLayers( const CArray<bool>& hasDiff );
+	void packGroupHistory( CArenaGroup& group );
+	void shareGroupHistory( CArenaGroup& group );
+
+	void convertSparseDiffs( bool convertAll );
+	void trainSparseLayer( CBaseLayer* layer, const CSparseDiffSum& diffSum );
+
 	// Clips gradients according to the settings
 	void clipGradients(const CObjectArray<CDnnBlob>& paramDiffBlobs);
 
@@ -162,6 +256,7 @@ public:
 protected:
 	void TrainLayer( const CBaseLayer* layer, const CObjectArray<CDnnBlob>& paramBlobs, 
 		const CObjectArray<CDnnBlob>& paramDiffBlobs, CObjectArray<CDnnBlob>& gradientHistory ) override;
+	bool CanTrainRows() const override { return true; }
 
 private:
 	// Moment decay rate (moment is a weighted sum of previous gradients)
@@ -223,6 +318,8 @@ protected:
 	// Updates the trainable weights of the layer
 	virtual void TrainLayer( const CBaseLayer* layer, const CObjectArray<CDnnBlob>& paramBlobs,
 		const CObjectArray<CDnnBlob>& paramDiffBlobs, CObjectArray<CDnnBlob>& gradientHistory ) override;
+	// Only the rows that have the gradients update their moments
+	bool CanTrainRows() const override { return true; }
 
 private:
 	// The gradientHistory array stores the previous values of gradients of different types
@@ -455,6 +552,8 @@ protected:
 		const CObjectArray<CDnnBlob>& paramDiffBlobs, CObjectArray<CDnnBlob>& gradientHistory ) override;
 
 	void OnTrain() override;
+	// The trust ratio and the weight decay exclusions are per-layer
+	bool CanTrainLayersTogether() const override { return false; }
 
 private:
 	// The gradientHistory array stores the previous values of gradients of different types
@@ -520,6 +619,7 @@ private:
 	void getWeightDecayIndices( const CBaseLayer& layer, int paramsCount, CHashTable<int>& indexes ) const;
 
 	void calcNormalizeMultiplier( const CDnnBlob& weights, const CDnnBlob& update, const CFloatHandle& multiplier ) const;
+	float calcNormalizeMultiplier( float weightNorm, float updateNorm ) const;
 };
 
 template<typename TLayer>
@@ -22,27 +22,23 @@ limitations under the License.
 
 namespace NeoML {
 
-// Supported activation functions
-enum TActivationFunction {
-	AF_Linear = 0,
-	AF_ELU,
-	AF_ReLU,
-	AF_LeakyReLU,
-	AF_Abs,
-	AF_Sigmoid,
-	AF_Tanh,
-	AF_HardTanh,
-	AF_HardSigmoid,
-	AF_Power,
-	AF_HSwish,
-	AF_GELU,
-
-	AF_Count
-};
-
 // Creates an activation layer using the specified activation function
 CPtr<CBaseLayer> NEOML_API CreateActivationLayer( IMathEngine& mathEngine, TActivationFunction type );
 
+// The activation function together with its parameters (see CActivationInfo)
+// Used by the layers that apply an activation to their own output (see CDnnOptimizer)
+struct NEOML_API CActivationDesc : public CActivationInfo {
+	// The default is the identity function
+	explicit CActivationDesc( TActivationFunction type = AF_Linear, float param1 = 1.f, float param2 = 0.f ) :
+		CActivationInfo( type, param1, param2 ) {}
+
+	void Serialize( CArchive& archive );
+};
+
+// Retrieves the description of the activation function calculated by the layer
+// Returns false if the layer is not an activation layer
+bool NEOML_API GetActivationDesc( const CBaseLayer& layer, CActivationDesc& desc );
+
 //------------------------------------------------------------------------------------------------------------
 
 // The layer that uses a linear activation function a*x + b
@@ -64,6 +64,9 @@ private:
 
 	// Indicates if the first step in the sequence is currently under processing
 	bool isProcessingFirstPosition;
+
+	// The recurrent layers may process the whole sequence without running the back link (see CRecurrentLayer)
+	friend class CRecurrentLayer;
 };
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////
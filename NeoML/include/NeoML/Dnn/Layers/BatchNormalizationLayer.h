@@ -63,6 +63,7 @@ protected:
 	void RunOnce() override;
 	void BackwardOnce() override;
 	void LearnOnce() override;
+	void ShareParamBlobs( const CBaseLayer& source ) override;
 
 private:
 	bool isChannelBased;
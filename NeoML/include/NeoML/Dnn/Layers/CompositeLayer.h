@@ -80,6 +80,7 @@ protected:
 	void LearnOnce() override;
 	void OnDnnChanged( CDnn* ) override;
 	void FilterLayerParams( float threshold ) override;
+	void ShareParamBlobs( const CBaseLayer& source ) override;
 	
 	// The network object for the internal layers
 	const CDnn* GetInternalDnn() const { return internalDnn; }
@@ -104,6 +105,8 @@ protected:
 		COutputMapping() : InternalLayerOutput(0) {}
 	};
 	const COutputMapping& GetOutputMapping( int i ) const { return outputMappings[i]; }
+	// The parameter blobs of an internal layer (not copied)
+	static const CObjectArray<CDnnBlob>& GetInternalLayerParams( const CBaseLayer& layer ) { return layer.paramBlobs; }
 
 	// Internal network run and backpropagation (the methods should be overloaded in the derived classes)
 	virtual void RunInternalDnn();
@@ -17,7 +17,9 @@ limitations under the License.
 
 #include <NeoML/NeoMLDefs.h>
 #include <NeoML/Dnn/Layers/BatchNormalizationLayer.h>
+#include <NeoML/Dnn/Layers/ActivationLayers.h>
 #include <NeoML/Dnn/Dnn.h>
+#include <NeoML/Dnn/DnnQuantization.h>
 
 namespace NeoML {
 
@@ -106,6 +108,9 @@ protected:
 	const CPtr<CDnnBlob>& FreeTerms() const { return paramBlobs[1]; }	// free terms matrix
 
 	void FilterLayerParams( float threshold ) override;
+
+	// Called after the filter values have been changed by SetFilterData or FilterLayerParams
+	virtual void OnFilterChanged() {}
 };
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -119,6 +124,23 @@ public:
 
 	void Serialize( CArchive& archive ) override;
 
+	CPtr<CDnnBlob> GetFilterData() const override;
+	void SetFilterData( const CPtr<CDnnBlob>& newFilter ) override;
+
+	// 8-bit quantized inference (see CDnnQuantizer)
+	// While the calibration is enabled the layer collects the range of its input
+	void EnableQuantizationCalibration( bool enable ) { quantizedWeights.SetCalibrating( enable ); }
+	// Replaces the filter with the quantized one; the layer may be used only for inference after that
+	// Returns false if the input range has not been collected
+	// Setting a new filter returns the layer to the float mode
+	bool Quantize();
+	bool IsQuantized() const { return quantizedWeights.IsQuantized(); }
+
+	// The activation function applied to the layer output (the identity by default)
+	// The layer with an activation may be used only for inference (see CDnnOptimizer)
+	const CActivationDesc& GetActivation() const { return activation; }
+	void SetActivation( const CActivationDesc& desc );
+
 protected:
 	virtual ~CConvLayer();
 
@@ -126,9 +148,13 @@ protected:
 	void RunOnce() override;
 	void BackwardOnce() override;
 	void LearnOnce() override;
+	void OnFilterChanged() override;
+	void ShareParamBlobs( const CBaseLayer& source ) override;
 
 private:
 	CConvolutionDesc* convDesc; // the convolution descriptor
+	CQuantizedWeights quantizedWeights; // the quantized filter, used instead of Filter() if quantized
+	CActivationDesc activation; // the activation applied to the output
 
 	void calcOutputBlobSize(int& outputHeight, int& outputWidth) const;
 	void initConvDesc();
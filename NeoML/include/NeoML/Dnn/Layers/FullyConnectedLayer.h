@@ -17,7 +17,9 @@ limitations under the License.
 
 #include <NeoML/NeoMLDefs.h>
 #include <NeoML/Dnn/Layers/BatchNormalizationLayer.h>
+#include <NeoML/Dnn/Layers/ActivationLayers.h>
 #include <NeoML/Dnn/Dnn.h>
+#include <NeoML/Dnn/DnnQuantization.h>
 
 namespace NeoML {
 
@@ -54,6 +56,20 @@ public:
 	bool IsZeroFreeTerm() const { return isZeroFreeTerm; }
 	void SetZeroFreeTerm(bool _isZeroFreeTerm);
 
+	// 8-bit quantized inference (see CDnnQuantizer)
+	// While the calibration is enabled the layer collects the range of its input
+	void EnableQuantizationCalibration( bool enable ) { quantizedWeights.SetCalibrating( enable ); }
+	// Replaces the weights with the quantized ones; the layer may be used only for inference after that
+	// Returns false if the input range has not been collected
+	// Setting new weights returns the layer to the float mode
+	bool Quantize();
+	bool IsQuantized() const { return quantizedWeights.IsQuantized(); }
+
+	// The activation function applied to the layer output (the identity by default)
+	// The layer with an activation may be used only for inference (see CDnnOptimizer)
+	const CActivationDesc& GetActivation() const { return activation; }
+	void SetActivation( const CActivationDesc& desc );
+
 protected:
 	virtual ~CFullyConnectedLayer();
 
@@ -62,6 +78,7 @@ protected:
 	void BackwardOnce() override;
 	void LearnOnce() override;
 	void FilterLayerParams( float threshold ) override;
+	void ShareParamBlobs( const CBaseLayer& source ) override;
 
 	// The filter. The pointer is valid only if the desired parameters are known (either defined externally or obtained on reshape)
 	CPtr<CDnnBlob>& Weights() { return paramBlobs[0]; }
@@ -76,6 +93,8 @@ protected:
 private:
 	int numberOfElements; // the number of elements (neurons) of the fully-connected layer
 	bool isZeroFreeTerm; // indicates if the free term should be set to zero
+	CQuantizedWeights quantizedWeights; // the quantized weights, used instead of Weights() if quantized
+	CActivationDesc activation; // the activation applied to the output
 };
 
 NEOML_API CLayerWrapper<CFullyConnectedLayer> FullyConnected(
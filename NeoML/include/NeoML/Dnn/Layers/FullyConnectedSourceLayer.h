@@ -42,6 +42,14 @@ public:
 	int GetMaxBatchCount() const { return batchCount; }
 	void SetMaxBatchCount( int newMaxBatchCount );
 
+	// The number of batches prepared in advance by a background thread
+	// The thread gathers the vectors of the next batches from the problem and packs them while the network runs,
+	// so RunOnce only copies the prepared batch into math engine memory
+	// 0 by default, which means that the batches are loaded in RunOnce
+	// Changing this value restarts the pass over the problem; the problem must not be modified while it is in use
+	int GetPrefetchBatchCount() const { return prefetchBatchCount; }
+	void SetPrefetchBatchCount( int newPrefetchBatchCount );
+
 	// Retrieves or sets the original problem data
 	// After the layer is connected to the network, you may change the problem 
 	// only if the number of classes and features stays the same
@@ -61,6 +69,8 @@ protected:
 	void LearnOnce() override;
 
 private:
+	class CBatchLoader;
+
 	CPtr<const IProblem> problem; // the current problem
 	CDnnSparseMatrix* batchData; // the batch data
 	CArray<float> batchLabels; // the correct labels for the vectors of the batch
@@ -72,9 +82,16 @@ private:
 	int batchLastLoadedIndex; // the index of the batch that was loaded last
 	int firstVectorInBatchIndex; // the index of the first vector in the current batch
 	TBlobType labelType; // the data type for class labels
+	int prefetchBatchCount; // the number of batches prepared by the background thread
+	CBatchLoader* loader; // the background loader (prefetch mode only)
+	CPtr<CDnnBlob> prefetchedData; // the current prefetched batch in math engine memory
+	CSparseMatrixDesc prefetchedBatchDesc; // the description of the current prefetched batch
 
+	void resetBatches();
 	void loadBatchData();
+	void loadPrefetchedBatch();
 	bool isBatchLoaded( int index ) const;
+	CSparseMatrixDesc getBatchDesc() const;
 };
 
 NEOML_API CLayerWrapper<CFullyConnectedSourceLayer> FullyConnectedSource(
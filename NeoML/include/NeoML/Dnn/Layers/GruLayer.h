@@ -47,6 +47,9 @@ public:
 	void SetGateWeightsData(CDnnBlob* newWeights) { gateLayer->SetWeightsData(newWeights); }
 	void SetGateFreeTermData(CDnnBlob* newFreeTerm) { gateLayer->SetFreeTermData(newFreeTerm); }
 
+protected:
+	void RunOnce() override;
+
 private:
 	// The indices of the gates in the hidden layer output
 	enum TGateOut {
@@ -62,6 +65,8 @@ private:
 	CPtr<CBackLinkLayer> mainBackLink;
 
 	void buildLayer();
+	bool isFusedRunPossible() const;
+	void runFused();
 };
 
 NEOML_API CLayerWrapper<CGruLayer> Gru( int hiddenSize );
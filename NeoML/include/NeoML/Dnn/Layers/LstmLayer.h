@@ -66,6 +66,9 @@ public:
 	bool IsInCompatibilityMode() const { return isInCompatibilityMode; }
 	void SetCompatibilityMode( bool compatibilityMode );
 
+protected:
+	void RunOnce() override;
+
 private:
 	// The gate numbers for the hidden layer output
 	enum TGateOut {
@@ -94,6 +97,8 @@ private:
 
 	void buildLayer(float dropout);
 	void setWeightsData(const CPtr<CDnnBlob>& newWeights);
+	bool isFusedRunPossible() const;
+	void runFused();
 };
 
 NEOML_API CLayerWrapper<CLstmLayer> Lstm(
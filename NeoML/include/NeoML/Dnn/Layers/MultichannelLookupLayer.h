@@ -47,6 +47,13 @@ public:
 	bool IsUseFrameworkLearning() const { return useFrameworkLearning; }
 	void SetUseFrameworkLearning(bool _useFrameworkLearning);
 
+	// Indicates that with the external training only the embeddings used on the step are passed to the solver
+	// (see CDnnSolver::AddSparseDiff) instead of the gradients of the whole tables
+	// The solvers that support it update only these rows, so the cost of the step doesn't depend on the table size
+	// The default value is false
+	bool IsSparseGradientEnabled() const { return isSparseGradientEnabled; }
+	void EnableSparseGradient( bool enable ) { isSparseGradientEnabled = enable; }
+
 	// Initializes the layer data. Called automatically on Reshape, 
 	// however, you may call it in other situations as well (i.e. on Word2VecStep). 
 	// Set the input parameter to 0 to clear the embeddings.
@@ -79,6 +86,8 @@ protected:
 	void RunOnce() override;
 	void BackwardOnce() override;
 	void LearnOnce() override;
+	bool HasSparseParamDiffs() const override { return useFrameworkLearning && isSparseGradientEnabled; }
+	void ShareParamBlobs( const CBaseLayer& source ) override;
 
 private:
 	// The size of stored vectors
@@ -86,10 +95,14 @@ private:
 
 	// Indicates that "external" training should be used
 	bool useFrameworkLearning;
+	// Indicates that only the used embeddings are passed to the solver
+	bool isSparseGradientEnabled;
 
 	CObjectArray<CDnnBlob> ownParams; // "internal" training parameters
 	CObjectArray<CDnnBlob>& getParams() { return useFrameworkLearning ? paramBlobs : ownParams; }
 	const CObjectArray<CDnnBlob>& getParams() const { return useFrameworkLearning ? paramBlobs : ownParams; }
+
+	void learnSparse();
 };
 
 NEOML_API CLayerWrapper<CMultichannelLookupLayer> MultichannelLookup(
@@ -73,10 +73,33 @@ public:
 	int GetOutputSize() const { return outputSize; }
 	void SetOutputSize( int _outputSize );
 
+	// The key/value cache for the autoregressive decoding
+	// When enabled, the layer keeps the projected keys and values of the previous runs
+	// and each run attends to them together with the keys and values passed to the inputs,
+	// so only the new positions should be passed on each step (usually one query, key and value)
+	// This mode is meant for the self-attention: ListSize_Q must be equal to ListSize_V,
+	// the mask input is not supported; instead each new query attends to all the cached positions
+	// and to the new positions up to its own one
+	// The cache is cleared by RestartSequence, so the dnn should not be in auto restart mode
+	// Only the inference on CPU is supported in this mode; the setting is not serialized
+	// By default the cache is disabled
+	bool IsKeyValueCacheEnabled() const { return useKeyValueCache; }
+	void EnableKeyValueCache( bool enable );
+	// The number of positions in the cache
+	int GetCachedLength() const { return cachedLength; }
+
+	// Retrieves or sets the cached keys and values, in the same way as CRecurrentLayer::GetState/SetState
+	// The blobs have the size (1, BatchWidth, GetCachedLength(), 1, 1, 1, GetHiddenSize())
+	void GetState( CObjectArray<CDnnBlob>& state ) const;
+	void SetState( const CObjectArray<CDnnBlob>& state );
+
+	void RestartSequence() override;
+
 	void Serialize( CArchive& archive ) override;
 
 protected:
 	void Reshape() override;
+	void RunOnce() override;
 
 private:
 	// The amount of heads
@@ -89,6 +112,13 @@ private:
 	bool useMask;
 	// Output size
 	int outputSize;
+	// The key/value cache usage
+	bool useKeyValueCache;
+	// The cached projections of the keys and values (1, BatchWidth, capacity, 1, 1, 1, hiddenSize)
+	// Only the first cachedLength positions of each object are valid
+	CPtr<CDnnBlob> keyCache;
+	CPtr<CDnnBlob> valueCache;
+	int cachedLength;
 
 	void create();
 
@@ -115,6 +145,11 @@ private:
 	CBaseLayer* prepareK( CBaseLayer* input );
 	CBaseLayer* prepareV( CBaseLayer* input );
 	CBaseLayer* prepareOutput( CBaseLayer* input );
+
+	bool isFusedRunPossible() const;
+	void runFused();
+	void applyFullyConnected( const char* name, const CConstFloatHandle& input, int rowCount, const CFloatHandle& result );
+	void appendToCache( CPtr<CDnnBlob>& cache, const CConstFloatHandle& data, int batchSize, int length );
 };
 
 NEOML_API CLayerWrapper<CMultiheadAttentionLayer> MultiheadAttention(
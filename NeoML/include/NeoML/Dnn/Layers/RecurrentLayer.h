@@ -55,6 +55,15 @@ protected:
 	void RunInternalDnnBackward() override;
 	void SetInternalDnnParams() override;
 
+	// The derived layers may process the whole sequence at once instead of running the internal network step by step
+	// Indicates if that is possible on the current run (only inference on CPU is supported)
+	bool IsFusedRunPossible() const;
+	// Retrieves the state the back link starts the sequence from
+	// inputNumber is the layer input mapped to the back link initial state (it is used only if connected)
+	CPtr<CDnnBlob> GetBackLinkStartState( CBackLinkLayer& backLink, int inputNumber );
+	// Saves the state after the last step of the sequence into the back link
+	void SetBackLinkEndState( CBackLinkLayer& backLink, const CDnnBlob& sequence );
+
 private:
 	// The backward links
 	CObjectArray<CBackLinkLayer> backLinks;
@@ -36,6 +36,7 @@ protected:
 	void RunOnce() override;
 	void BackwardOnce() override;
 	void LearnOnce() override;
+	void OnFilterChanged() override;
 	bool IsFilterTransposed() const override { return true; }
 
 private:
@@ -36,6 +36,8 @@ public:
 	virtual ~CArchive();
 
 	const char* Name() const { return name; }
+	// Gets the file the archive works with
+	CBaseFile* GetFile() const { return file; }
 
 	void Open( CBaseFile* baseFile, TDirection direction );
 	void Close();
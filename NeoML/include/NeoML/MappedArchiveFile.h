@@ -0,0 +1,108 @@
+/* Copyright © 2017-2021 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+
+#pragma once
+
+#include <NeoML/NeoMLDefs.h>
+
+namespace NeoML {
+
+// The read-only memory mapping of a whole file
+// The mapped pages are backed by the file and shared between all the processes that map it
+// The object is reference-counted so that the data may be used after the file object has been destroyed
+class NEOML_API CMappedFileData : public IObject {
+public:
+	// Maps the file; throws an exception if the file can't be opened or mapped
+	explicit CMappedFileData( const char* fileName );
+
+	const char* GetFileName() const { return fileName; }
+	// The file contents (nullptr for an empty file)
+	const char* GetData() const { return data; }
+	__int64 GetSize() const { return size; }
+
+protected:
+	~CMappedFileData() override;
+
+private:
+	CString fileName;
+	const char* data; // the mapped memory
+	__int64 size; // the file size
+	void* mappingHandle; // the file mapping object (Windows only)
+};
+
+//------------------------------------------------------------------------------------------------------------
+
+// The archive file that reads the data from the memory mapping of the file
+// When a network is loaded from an archive over this file with a CPU math engine,
+// the blobs are not copied but point directly into the mapped memory (see CDnnBlob::Serialize)
+// That saves both the loading time and the memory if several processes load the same file
+// Such blobs are read-only: the network may be used for inference only
+// (it may not be trained, quantized, or optimized by CDnnOptimizer)
+// The mapping is released after the file and all the blobs that point into it are destroyed
+class NEOML_API CMappedArchiveFile : public CBaseFile {
+public:
+	CMappedArchiveFile() : position( 0 ) {}
+	// Creates an object and maps the file
+	// The same as calling a constructor without parameters and then the Open method
+	explicit CMappedArchiveFile( const char* fileName );
+	~CMappedArchiveFile() override { Abort(); }
+
+	// Checks if the file is open
+	bool IsOpen() const { return mapping != nullptr; }
+
+	// Maps the file; only reading is supported
+	void Open( const char* fileName );
+
+	// The mapping of the file
+	CMappedFileData* GetMapping() const { return mapping; }
+
+	// CBaseFile class methods
+#ifdef FINEOBJ_VERSION
+	CUnicodeString GetFileName() const override;
+#else
+	const char* GetFileName() const override;
+#endif
+	int Read( void*, int bytesCount ) override;
+	void Write( const void*, int bytesCount ) override;
+	__int64 GetPosition() const override;
+	__int64 Seek( __int64 offset, TSeekPosition from ) override;
+	void SetLength( __int64 newLength ) override;
+	__int64 GetLength() const override;
+	void Abort() override;
+	void Flush() override;
+	void Close() override;
+	bool IsEndOfFile() const override;
+
+private:
+	CPtr<CMappedFileData> mapping;
+	__int64 position; // the current position in the file
+};
+
+//------------------------------------------------------------------------------------------------------------
+
+// The large data blocks in the archives are aligned to this number of bytes
+// so that they could be used directly from a memory-mapped file
+const int MappedDataAlignment = 64;
+
+// Writes the padding that aligns the data following it in the archive
+NEOML_API void WriteMappedDataPadding( CArchive& archive );
+// Skips the padding written by WriteMappedDataPadding
+NEOML_API void ReadMappedDataPadding( CArchive& archive );
+// Skips the data in the archive over a memory-mapped file and returns the pointer to it
+// Returns nullptr and skips nothing if the archive doesn't work with a memory-mapped file
+NEOML_API const char* SkipMappedData( CArchive& archive, __int64 dataSize, CPtr<CMappedFileData>& mapping );
+
+} // namespace NeoML
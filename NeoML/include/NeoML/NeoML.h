@@ -25,11 +25,13 @@ limitations under the License.
 #include <NeoML/TraditionalML/IsoDataClustering.h>
 #include <NeoML/TraditionalML/KMeansClustering.h>
 #include <NeoML/TraditionalML/HierarchicalClustering.h>
+#include <NeoML/TraditionalML/HnswIndex.h>
 #include <NeoML/TraditionalML/MemoryProblem.h>
 #include <NeoML/TraditionalML/Linear.h>
 #include <NeoML/TraditionalML/DecisionTree.h>
 #include <NeoML/TraditionalML/OneVersusAll.h>
 #include <NeoML/TraditionalML/OneVersusOne.h>
+#include <NeoML/TraditionalML/RandomForest.h>
 #include <NeoML/TraditionalML/Svm.h>
 #include <NeoML/TraditionalML/PlattScalling.h>
 #include <NeoML/TraditionalML/DifferentialEvolution.h>
@@ -78,6 +80,10 @@ limitations under the License.
 #include <NeoML/Dnn/Layers/GruLayer.h>
 #include <NeoML/Dnn/DnnSolver.h>
 #include <NeoML/Dnn/DnnInitializer.h>
+#include <NeoML/Dnn/DnnQuantization.h>
+#include <NeoML/Dnn/DnnOptimization.h>
+#include <NeoML/Dnn/DnnExecutionContext.h>
+#include <NeoML/Dnn/DnnDistributed.h>
 #include <NeoML/Dnn/Layers/MultichannelLookupLayer.h>
 #include <NeoML/Dnn/Layers/MaxOverTimePoolingLayer.h>
 #include <NeoML/Dnn/Layers/3dConvLayer.h>
@@ -118,6 +124,7 @@ limitations under the License.
 #include <NeoML/Dnn/Layers/DepthToSpaceLayer.h>
 #include <NeoML/Dnn/Layers/SpaceToDepthLayer.h>
 #include <NeoML/ArchiveFile.h>
+#include <NeoML/MappedArchiveFile.h>
 
 #ifndef NO_NEOML_NAMESPACE
 using namespace NeoML;
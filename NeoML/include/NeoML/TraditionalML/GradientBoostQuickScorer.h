@@ -37,6 +37,12 @@ public:
 	// with k taking values from 1 to the total number of trees
 	virtual bool ClassifyEx( const CSparseFloatVector& data, CArray<CClassificationResult>& results ) const = 0;
 	virtual bool ClassifyEx( const CFloatVectorDesc& data, CArray<CClassificationResult>& results ) const = 0;
+
+	// Classifies the rows of the dense row-major matrix of height x width
+	// The rows are processed by blocks, which is several times faster than classifying them one by one
+	// ClassifyBatch does the same for the dense CFloatMatrixDesc
+	virtual bool ClassifyDenseBatch( const float* data, int height, int width, CArray<CClassificationResult>& results,
+		int threadCount = 1 ) const = 0;
 };
 
 // Optimized regression model interface
@@ -46,6 +52,12 @@ public:
 
 	// Gets the learning rate
 	virtual double GetLearningRate() const = 0;
+
+	// Calculates the predictions for the rows of the dense row-major matrix of height x width
+	// The rows are processed by blocks, which is several times faster than predicting them one by one
+	// PredictBatch does the same for the dense CFloatMatrixDesc
+	virtual void PredictDenseBatch( const float* data, int height, int width, CArray<double>& results,
+		int threadCount = 1 ) const = 0;
 };
 
 // The QuickScorer algorithm for optimizing a gradient boosting model
@@ -27,11 +27,37 @@ namespace NeoML {
 // until the limit to the clusters number or the distance between them is reached
 class NEOML_API CHierarchicalClustering : public IClustering {
 public:
+	// The distance between the merged cluster and the other clusters
+	enum TLinkage {
+		// The distance between the cluster centers
+		L_Centroid = 0,
+		// The minimum distance between the initial clusters of the two clusters
+		L_Single,
+		// The average distance between the initial clusters of the two clusters, weighted by the elements weights
+		L_Average,
+		// The maximum distance between the initial clusters of the two clusters
+		L_Complete,
+		// Ward's method: the increase of the total weighted squared deviation from the cluster centers after merging, multiplied by 2
+		// (so the distance between two elements is the same as for DF_Euclid); only DF_Euclid may be used
+		L_Ward,
+
+		L_Count
+	};
+
 	// Algorithm settings
 	struct CParam {
 		TDistanceFunc DistanceType; // the distance function
 		double MaxClustersDistance; // the maximum distance between two clusters that still may be merged
 		int MinClustersCount; // the minimum number of clusters in the result
+		// The linkage; all linkages except L_Centroid are clustered by the nearest-neighbor chain algorithm in O(n^2) time
+		TLinkage Linkage;
+		// The number of threads used to calculate the initial distances
+		int ThreadCount;
+
+		CParam() : DistanceType( DF_Euclid ), MaxClustersDistance( 1e10 ), MinClustersCount( 1 ),
+			Linkage( L_Centroid ), ThreadCount( 1 )
+		{
+		}
 	};
 
 	CHierarchicalClustering( const CArray<CClusterCenter>& clusters, const CParam& params );
@@ -51,11 +77,26 @@ private:
 	CTextStream* log; // the logging stream
 	CArray<CClusterCenter> initialClusters; // the initial cluster centers
 	CObjectArray<CCommonCluster> clusters; // the current clusters
-	CFloatVectorArray distances; // the matrix containing distances between clusters
+	CArray<double> clusterWeights; // the total weight of the elements in each initial cluster
+	// The distances between the initial clusters: the upper triangle of the matrix stored row by row (n * (n - 1) / 2 elements)
+	CArray<float> distances;
+	int distancesSize; // the size of the distance matrix
+	// For the centroid linkage: the nearest of the following clusters for each cluster and the distance to it
+	CArray<int> nearestClusters;
+	CArray<float> nearestDistances;
 
 	void initialize( const CFloatMatrixDesc& matrix, const CArray<double>& weights );
+	void calcDistances();
+	float& distance( int first, int second );
+	float distance( int first, int second ) const;
+	bool clusterizeCentroid( const CFloatMatrixDesc& matrix, const CArray<double>& weights );
+	void findNearestCluster( int index );
 	void findNearestClusters( int& first, int& second ) const;
 	void mergeClusters( const CFloatMatrixDesc& matrix, const CArray<double>& weights, int first, int second );
+	bool clusterizeChain();
+	int findChainNeighbor( int index, int previous, const CArray<bool>& isActive ) const;
+	double calcMergedDistance( double firstDistance, double secondDistance, double mergedDistance,
+		double firstWeight, double secondWeight, double weight ) const;
 };
 
 } // namespace NeoML
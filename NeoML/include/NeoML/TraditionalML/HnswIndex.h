@@ -0,0 +1,130 @@
+/* Copyright © 2017-2020 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <NeoML/NeoMLDefs.h>
+#include <NeoML/TraditionalML/ClusterCenter.h>
+#include <NeoML/TraditionalML/FloatVector.h>
+#include <NeoML/TraditionalML/SparseFloatMatrix.h>
+#include <NeoML/MappedArchiveFile.h>
+
+namespace NeoML {
+
+// Approximate nearest neighbors index (Hierarchical Navigable Small World graph)
+// Reference: Yu. A. Malkov, D. A. Yashunin, https://arxiv.org/abs/1603.09320
+// The vectors are stored in the index as a dense matrix; the distances are the same as for the clustering (see TDistanceFunc)
+class NEOML_API CHnswIndex : public IObject {
+public:
+	struct CParams {
+		// The distance function; only DF_Euclid and DF_Cosine are supported
+		// DF_Machalanobis uses the variances of a cluster, and the index has no clusters
+		TDistanceFunc DistanceFunc;
+		// The maximum number of neighbors of a vector on each graph level except the lowest one
+		// On the lowest level, a vector may have twice as many neighbors
+		int MaxNeighbors;
+		// The number of candidates considered when the neighbors for a new vector are searched
+		int EfConstruction;
+		// The number of threads used for building the index
+		// The vectors are inserted in parallel, so the graph built by several threads is not reproducible
+		int ThreadCount;
+		// Initial seed for random
+		int Seed;
+
+		CParams() : DistanceFunc( DF_Euclid ), MaxNeighbors( 16 ), EfConstruction( 200 ), ThreadCount( 1 ), Seed( 0xCEA ) {}
+	};
+
+	CHnswIndex(); // for serialization
+	explicit CHnswIndex( const CParams& params );
+
+	// Builds the index for the matrix rows; the previous contents are discarded
+	// The row indices are used as the vector identifiers in the search results
+	void Build( const CFloatMatrixDesc& data );
+
+	// The number of vectors in the index
+	int GetVectorCount() const { return nodeLevels.Size(); }
+	// The number of features
+	int GetFeatureCount() const { return featureCount; }
+	// The distance function
+	TDistanceFunc GetDistanceFunc() const { return params.DistanceFunc; }
+
+	// Finds k approximate nearest neighbors of the query, ordered by increasing distance
+	// ef is the number of candidates considered during the search (the greater, the more precise and the slower)
+	// If the index has fewer than k vectors, the rest of the results is filled with NotFound
+	void Search( const CFloatVectorDesc& query, int k, int ef, CArray<int>& neighbors, CArray<float>& distances ) const;
+	// Finds k approximate nearest neighbors for each of the matrix rows
+	// The results for the i-th row are stored in the i * k ... (i + 1) * k - 1 elements of the arrays
+	void SearchBatch( const CFloatMatrixDesc& queries, int k, int ef, CArray<int>& neighbors, CArray<float>& distances,
+		int threadCount = 1 ) const;
+
+	// Serializes the index
+	// The vectors and the graph links are stored as flat arrays in the same layout as in memory
+	// When the index is loaded from an archive over CMappedArchiveFile, these arrays are not copied
+	// but used directly from the mapped file; such an index may be searched but not rebuilt
+	void Serialize( CArchive& archive );
+
+protected:
+	virtual ~CHnswIndex();
+
+private:
+	struct CCandidate;
+	class CSearchContext;
+	class CBuildLocks;
+
+	CParams params; // the index parameters
+	int featureCount; // the vector length
+	int entryPoint; // the vector on the highest level from which the search starts
+	int maxLevel; // the highest level of the graph
+	CArray<int> nodeLevels; // the highest level of each vector
+	CArray<int> upperLinksOffsets; // the offset of the vector's first level links in upperLinks
+	// The vectors, one per row; for DF_Cosine they are normalized
+	const float* vectors;
+	// The neighbors on the lowest level, 2 * MaxNeighbors + 1 elements per vector: the neighbors count and the neighbors
+	const int* baseLinks;
+	// The neighbors on the upper levels, MaxNeighbors + 1 elements per vector and level
+	const int* upperLinks;
+	// The buffers for the arrays above; they are empty if the arrays are in the mapped file
+	CArray<float> vectorsBuffer;
+	CArray<int> baseLinksBuffer;
+	CArray<int> upperLinksBuffer;
+	CPtr<CMappedFileData> mapping; // the memory-mapped file the index has been loaded from
+	// The pool of the search buffers so that they are not allocated for every query
+	mutable CPointerArray<CSearchContext> contextPool;
+	mutable CCriticalSection contextPoolSection;
+
+	int baseLinksSize() const { return 2 * params.MaxNeighbors + 1; }
+	int upperLinksSize() const { return params.MaxNeighbors + 1; }
+	int maxNeighborsCount( int level ) const { return level == 0 ? 2 * params.MaxNeighbors : params.MaxNeighbors; }
+	const float* getVector( int index ) const { return vectors + static_cast<ptrdiff_t>( index ) * featureCount; }
+	const int* getLinks( int index, int level ) const;
+	int* getBuildLinks( int index, int level );
+	float calcDistance( const float* first, const float* second ) const;
+
+	void clear();
+	void prepareQuery( const CFloatVectorDesc& query, float* result ) const;
+	void insert( int index, CSearchContext& context, CBuildLocks& locks );
+	void copyLinks( int index, int level, CSearchContext& context, CBuildLocks* locks ) const;
+	int searchGreedy( const float* query, int entry, int level, CSearchContext& context, CBuildLocks* locks ) const;
+	void searchLevel( const float* query, int entry, int level, int ef, CSearchContext& context,
+		CBuildLocks* locks ) const;
+	void selectNeighbors( CArray<CCandidate>& candidates, int maxCount ) const;
+	void connect( int neighbor, int index, int level, CSearchContext& context, CBuildLocks& locks );
+	void search( const CFloatVectorDesc& query, int k, int ef, CSearchContext& context, int* neighbors,
+		float* distances ) const;
+	CSearchContext* acquireContext() const;
+	void releaseContext( CSearchContext* context ) const;
+};
+
+} // namespace NeoML
@@ -36,6 +36,15 @@ public:
 		// Elkan argorithm
 		// If used then the distance func must support triangle inequality
 		KMA_Elkan,
+		// Mini-batch algorithm
+		// On each iteration the centers are moved towards the elements of a random batch of MiniBatchSize elements,
+		// so MaxIterations is the number of batches processed; only DF_Euclid is supported
+		KMA_MiniBatch,
+		// Hamerly algorithm
+		// Gives the same result as Lloyd algorithm but skips most of the distance calculations;
+		// unlike Elkan algorithm, keeps only two distance bounds per element, so it may be used with large number of clusters;
+		// only DF_Euclid is supported
+		KMA_Hamerly,
 
 		KMA_Count
 	};
@@ -65,7 +74,7 @@ public:
 		TKMeansInitialization Initialization;
 		// The maximum number of iterations
 		int MaxIterations;
-		// Tolerance criterion for Elkan algorithm
+		// Tolerance criterion for Elkan and mini-batch algorithms
 		double Tolerance;
 		// Number of threads used in KMeans
 		int ThreadCount;
@@ -74,9 +83,11 @@ public:
 		int RunCount;
 		// Initial seed for random
 		int Seed;
+		// The batch size for mini-batch algorithm
+		int MiniBatchSize;
 
 		CParam() : Algo( KMA_Lloyd ), DistanceFunc( DF_Euclid ), InitialClustersCount( 1 ), Initialization( KMI_Default ),
-			MaxIterations( 1 ), Tolerance( 1e-5f ), ThreadCount( 1 ), RunCount( 1 ), Seed( 0xCEA )
+			MaxIterations( 1 ), Tolerance( 1e-5f ), ThreadCount( 1 ), RunCount( 1 ), Seed( 0xCEA ), MiniBatchSize( 1024 )
 		{
 		}
 	};
@@ -113,7 +124,7 @@ private:
 	void kMeansPlusPlusInitialization( const CFloatMatrixDesc& matrix, int seed );
 
 	// Sparse data clusterization
-	bool clusterize( const CFloatMatrixDesc& matrix, const CArray<double>& weights, double& inertia );
+	bool clusterize( const CFloatMatrixDesc& matrix, const CArray<double>& weights, int seed, double& inertia );
 
 	// Lloyd algorithm implementation for sparse data
 	bool lloydClusterization( const CFloatMatrixDesc& matrix, const CArray<double>& weights, double& inertia );
@@ -139,6 +150,24 @@ private:
 	bool isPruned( const CArray<float>& upperBounds, const CVariableMatrix<float>& lowerBounds,
 		const CVariableMatrix<float>& clusterDists, int currentCluster, int clusterToProcess, int id) const;
 
+	// Mini-batch algorithm implementation for sparse and dense data
+	bool miniBatchClusterization( const CFloatMatrixDesc& matrix, const CArray<double>& weights, int seed, double& inertia );
+	// Hamerly algorithm implementation for sparse and dense data
+	bool hamerlyClusterization( const CFloatMatrixDesc& matrix, const CArray<double>& weights, double& inertia );
+	void initializeHamerlyBounds( const CFloatMatrixDesc& matrix, const CArray<float>& centers, CArray<int>& assignments,
+		CArray<float>& upperBounds, CArray<float>& lowerBounds ) const;
+	void computeHalfClosestClusterDists( const CArray<float>& centers, CArray<float>& halfClosestDist ) const;
+	int hamerlyAssignVectors( const CFloatMatrixDesc& matrix, const CArray<float>& centers,
+		const CArray<float>& halfClosestDist, CArray<int>& assignments, CArray<float>& upperBounds,
+		CArray<float>& lowerBounds ) const;
+	// Calculates the means of the elements assigned to the clusters; the centers of the empty clusters are not changed
+	void calcClusterMeans( const CFloatMatrixDesc& matrix, const CArray<double>& weights, const CArray<int>& assignments,
+		CArray<float>& centers ) const;
+	void getClusterCenters( CArray<float>& centers ) const;
+	void setClusterCenters( const CArray<float>& centers );
+	double assignToCenters( const CFloatMatrixDesc& matrix, const CArray<float>& centers, CArray<int>& assignments ) const;
+	double calcInertia( const CFloatMatrixDesc& matrix, const CArray<float>& centers, const CArray<int>& assignments ) const;
+
 	// Specific case for dense data with Euclidean metrics and Lloyd algorithm
 	bool denseLloydL2Clusterize( IClusteringData* rawData, int seed, CClusteringResult& result, double& inertia );
 	// Initial cluster selection
@@ -37,6 +37,12 @@ public:
 	virtual bool Classify( const CFloatVector& data, CClassificationResult& result ) const
 		{ return Classify( data.GetDesc(), result ); }
 
+	// Classifies all rows of the matrix (dense or sparse) using up to threadCount threads
+	// The results array is resized to data.Height; its buffer is reused if already allocated
+	// Returns true if all rows were classified successfully
+	virtual bool ClassifyBatch( const CFloatMatrixDesc& data, CArray<CClassificationResult>& results,
+		int threadCount = 1 ) const;
+
 	// Serializes the model
 	virtual void Serialize( CArchive& archive ) = 0;
 };
@@ -53,6 +59,10 @@ public:
 	virtual double Predict( const CFloatVector& data ) const
 		{ return Predict( data.GetDesc() ); };
 
+	// Predicts the function values on all rows of the matrix (dense or sparse) using up to threadCount threads
+	// The results array is resized to data.Height; its buffer is reused if already allocated
+	virtual void PredictBatch( const CFloatMatrixDesc& data, CArray<double>& results, int threadCount = 1 ) const;
+
 	// Serializes the model
 	virtual void Serialize( CArchive& archive ) = 0;
 };
@@ -69,6 +79,11 @@ public:
 		{ return MultivariatePredict( data.GetDesc() ); }
 	virtual CFloatVector MultivariatePredict( const CFloatVectorDesc& data ) const = 0;
 
+	// Predicts the function values on all rows of the matrix (dense or sparse) using up to threadCount threads
+	// The results array is resized to data.Height
+	virtual void MultivariatePredictBatch( const CFloatMatrixDesc& data, CArray<CFloatVector>& results,
+		int threadCount = 1 ) const;
+
 	// Serializes the model
 	virtual void Serialize( CArchive& archive ) = 0;
 };
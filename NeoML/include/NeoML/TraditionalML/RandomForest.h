@@ -0,0 +1,75 @@
+/* Copyright © 2017-2020 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <NeoML/NeoMLDefs.h>
+#include <NeoML/TraditionalML/DecisionTree.h>
+
+namespace NeoML {
+
+DECLARE_NEOML_MODEL_NAME( RandomForestModelName, "FmlRandomForestModel" )
+
+// Random forest classification model interface
+class NEOML_API IRandomForestModel : public IModel {
+public:
+	virtual ~IRandomForestModel();
+
+	// Gets the trees of the forest
+	virtual const CObjectArray<IModel>& GetTrees() const = 0;
+};
+
+//------------------------------------------------------------------------------------------------------------
+
+// Random forest training algorithm
+// Each tree is built by CDecisionTree on a bootstrap sample of the input data
+// The trees are built in parallel; the samples refer to the input data matrix and do not copy it
+class NEOML_API CRandomForest : public ITrainingModel {
+public:
+	struct CParams {
+		// The number of trees in the forest
+		int TreeCount;
+		// The size of the bootstrap sample relative to the input data size
+		double SubsampleRate;
+		// The parameters of the trees
+		// If TreeParams.RandomSelectedFeaturesCount is -1, the square root of the feature count is used
+		CDecisionTree::CParams TreeParams;
+		// The number of threads used for training
+		int ThreadCount;
+
+		CParams() :
+			TreeCount( 100 ),
+			SubsampleRate( 1 ),
+			ThreadCount( 1 )
+		{
+		}
+	};
+
+	explicit CRandomForest( const CParams& params, CRandom* random = 0 );
+
+	// Set a text stream to log the progress
+	void SetLog( CTextStream* newLog ) { logStream = newLog; }
+
+	// The ITrainingModel interface methods:
+	CPtr<IModel> Train( const IProblem& problem ) override;
+
+private:
+	const CParams params; // the training parameters
+	CRandom defRandom; // the default random numbers generator
+	CRandom& random; // the actual random numbers generator
+	CTextStream* logStream; // the logging stream
+};
+
+} // namespace NeoML
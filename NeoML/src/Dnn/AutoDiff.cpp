@@ -17,6 +17,7 @@ limitations under the License.
 #pragma hdrstop
 
 #include <NeoML/Dnn/AutoDiff.h>
+#include <Dnn/AutoDiffTrace.h>
 
 namespace NeoML {
 
@@ -48,11 +49,12 @@ void CTapeBlob::Detach() const
 
 //------------------------------------------------------------------------------------------------------------
 
-class CTapeVar : public ITapeOperation {
+class CTapeVar : public ITapeOperation, public ITraceableTapeOperation {
 public:
 	explicit CTapeVar( const CTapeBlob& var );
 
 	CPtr<CDnnBlob> Jacobian( const CTapeBlob* var ) const override;
+	void Trace( CTapeOperationTrace& trace ) const override { trace.Type = TOT_Variable; }
 
 private:
 	const CTapeBlob* variable;
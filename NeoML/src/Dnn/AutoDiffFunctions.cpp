@@ -18,6 +18,7 @@ limitations under the License.
 
 #include <NeoML/Dnn/AutoDiff.h>
 #include <NeoML/Dnn/AutoDiffFunctions.h>
+#include <Dnn/AutoDiffTrace.h>
 
 namespace NeoML {
 
@@ -45,7 +46,8 @@ static CPtr<CDnnBlob> callJacobian( const CDnnBlob* blob, const CTapeBlob* var )
 	}
 
 	CPtr<CDnnBlob> result = tapeOperation->Jacobian( var );
-	NeoAssert( result->GetObjectSize() == var->GetDataSize() );
+	// The operation may not depend on the variable
+	NeoAssert( result == 0 || result->GetObjectSize() == var->GetDataSize() );
 	return result;
 }
 
@@ -67,24 +69,35 @@ CPtr<const CDnnBlob> Const( IMathEngine& mathEngine, const float* data, const CB
 
 //------------------------------------------------------------------------------------------------------------
 
-class CTapeAdd : public ITapeOperation {
+class CTapeAdd : public ITapeOperation, public ITraceableTapeOperation {
 public:
-	CTapeAdd( const CDnnBlob& first, const CDnnBlob* second );
+	CTapeAdd( const CDnnBlob& first, const CDnnBlob* second, float value = 0 );
 
 	CPtr<CDnnBlob> Jacobian( const CTapeBlob* var ) const override;
+	void Trace( CTapeOperationTrace& trace ) const override;
 
 private:
 	CPtr<const CDnnBlob> first;
 	CPtr<const CDnnBlob> second;
+	const float value;
 };
 
-CTapeAdd::CTapeAdd( const CDnnBlob& _first, const CDnnBlob* _second ) :
+CTapeAdd::CTapeAdd( const CDnnBlob& _first, const CDnnBlob* _second, float _value ) :
 	first( &_first ),
-	second( _second )
+	second( _second ),
+	value( _value )
 {
 	NeoAssert( dynamic_cast<const CTapeBlob*>(first.Ptr()) != 0 || dynamic_cast<const CTapeBlob*>(second.Ptr()) != 0 );
 }
 
+void CTapeAdd::Trace( CTapeOperationTrace& trace ) const
+{
+	trace.Type = second != 0 ? TOT_Add : TOT_AddValue;
+	trace.First = first;
+	trace.Second = second;
+	trace.Value = value;
+}
+
 CPtr<CDnnBlob> CTapeAdd::Jacobian( const CTapeBlob* var ) const
 {
 	CPtr<CDnnBlob> firstJacobian = callJacobian( first, var );
@@ -152,7 +165,7 @@ CPtr<const CDnnBlob> Add( const CDnnBlob* first, float second )
 	mathEngine.VectorAddValue(first->GetData(), result->GetData(), result->GetDataSize(), secondHandle );
 
 	if( tape != 0 ) {
-		CPtr<ITapeOperation> operation( new CTapeAdd( *first, nullptr ) ); 
+		CPtr<ITapeOperation> operation( new CTapeAdd( *first, nullptr, second ) ); 
 		tape->Add( result, operation );
 	}
 	return result.Ptr();
@@ -165,24 +178,41 @@ CPtr<const CDnnBlob> Add( float first, const CDnnBlob* second )
 
 //------------------------------------------------------------------------------------------------------------
 
-class CTapeSub : public ITapeOperation {
+class CTapeSub : public ITapeOperation, public ITraceableTapeOperation {
 public:
-	CTapeSub( const CDnnBlob* first, const CDnnBlob* second );
+	CTapeSub( const CDnnBlob* first, const CDnnBlob* second, float value = 0 );
 
 	CPtr<CDnnBlob> Jacobian( const CTapeBlob* var ) const override;
+	void Trace( CTapeOperationTrace& trace ) const override;
 
 private:
 	CPtr<const CDnnBlob> first;
 	CPtr<const CDnnBlob> second;
+	// The scalar argument used instead of the missing blob
+	const float value;
 };
 
-CTapeSub::CTapeSub( const CDnnBlob* _first, const CDnnBlob* _second ) :
+CTapeSub::CTapeSub( const CDnnBlob* _first, const CDnnBlob* _second, float _value ) :
 	first( _first ),
-	second( _second )
+	second( _second ),
+	value( _value )
 {
 	NeoAssert( dynamic_cast<const CTapeBlob*>(first.Ptr()) != 0 || dynamic_cast<const CTapeBlob*>(second.Ptr()) != 0 );
 }
 
+void CTapeSub::Trace( CTapeOperationTrace& trace ) const
+{
+	if( first == 0 ) {
+		trace.Type = TOT_ValueSub;
+		trace.First = second;
+	} else {
+		trace.Type = second != 0 ? TOT_Sub : TOT_SubValue;
+		trace.First = first;
+		trace.Second = second;
+	}
+	trace.Value = value;
+}
+
 CPtr<CDnnBlob> CTapeSub::Jacobian( const CTapeBlob* var ) const
 {
 	CPtr<CDnnBlob> firstJacobian = callJacobian( first, var );
@@ -255,7 +285,7 @@ CPtr<const CDnnBlob> Sub( const CDnnBlob* first, float second )
 	mathEngine.VectorSub( first->GetData(), second, result->GetData(), result->GetDataSize() );
 
 	if( tape != 0 ) {
-		CPtr<ITapeOperation> operation( new CTapeSub( first, 0 ) ); 
+		CPtr<ITapeOperation> operation( new CTapeSub( first, 0, second ) ); 
 		tape->Add( result, operation );
 	}
 	return result.Ptr();
@@ -274,7 +304,7 @@ CPtr<const CDnnBlob> Sub( float first, const CDnnBlob* second )
 	mathEngine.VectorSub( first, second->GetData(), result->GetData(), result->GetDataSize() );
 
 	if( tape != 0 ) {
-		CPtr<ITapeOperation> operation( new CTapeSub( 0, second ) ); 
+		CPtr<ITapeOperation> operation( new CTapeSub( 0, second, first ) ); 
 		tape->Add( result, operation );
 	}
 	return result.Ptr();
@@ -282,11 +312,12 @@ CPtr<const CDnnBlob> Sub( float first, const CDnnBlob* second )
 
 //------------------------------------------------------------------------------------------------------------
 
-class CTapeMul : public ITapeOperation {
+class CTapeMul : public ITapeOperation, public ITraceableTapeOperation {
 public:
 	explicit CTapeMul( const CDnnBlob& first, const CDnnBlob& second );
 
 	CPtr<CDnnBlob> Jacobian( const CTapeBlob* var ) const override;
+	void Trace( CTapeOperationTrace& trace ) const override;
 
 private:
 	CPtr<const CDnnBlob> first;
@@ -300,6 +331,13 @@ CTapeMul::CTapeMul( const CDnnBlob& _first, const CDnnBlob& _second ) :
 	NeoAssert( dynamic_cast<const CTapeBlob*>(first.Ptr()) != 0 || dynamic_cast<const CTapeBlob*>(second.Ptr()) != 0 );
 }
 
+void CTapeMul::Trace( CTapeOperationTrace& trace ) const
+{
+	trace.Type = TOT_Mul;
+	trace.First = first;
+	trace.Second = second;
+}
+
 CPtr<CDnnBlob> CTapeMul::Jacobian( const CTapeBlob* var ) const
 {
 	CPtr<CDnnBlob> result;
@@ -398,11 +436,12 @@ CPtr<const CDnnBlob> Mul( float first, const CDnnBlob* second )
 
 //------------------------------------------------------------------------------------------------------------
 
-class CTapeDiv : public ITapeOperation {
+class CTapeDiv : public ITapeOperation, public ITraceableTapeOperation {
 public:
 	explicit CTapeDiv( const CDnnBlob& first, const CDnnBlob& second );
 
 	CPtr<CDnnBlob> Jacobian( const CTapeBlob* var ) const override;
+	void Trace( CTapeOperationTrace& trace ) const override;
 
 private:
 	CPtr<const CDnnBlob> first;
@@ -416,6 +455,13 @@ CTapeDiv::CTapeDiv( const CDnnBlob& _first, const CDnnBlob& _second ) :
 	NeoAssert( dynamic_cast<const CTapeBlob*>(first.Ptr()) != 0 || dynamic_cast<const CTapeBlob*>(second.Ptr()) != 0 );
 }
 
+void CTapeDiv::Trace( CTapeOperationTrace& trace ) const
+{
+	trace.Type = TOT_Div;
+	trace.First = first;
+	trace.Second = second;
+}
+
 CPtr<CDnnBlob> CTapeDiv::Jacobian( const CTapeBlob* var ) const
 {
 	CPtr<CDnnBlob> result;
@@ -549,11 +595,12 @@ CPtr<const CDnnBlob> NEOML_API Div( float value, const CDnnBlob* second )
 
 //------------------------------------------------------------------------------------------------------------
 
-class CTapeMax : public ITapeOperation {
+class CTapeMax : public ITapeOperation, public ITraceableTapeOperation {
 public:
 	explicit CTapeMax( const CDnnBlob& first, float second );
 
 	CPtr<CDnnBlob> Jacobian( const CTapeBlob* var ) const override;
+	void Trace( CTapeOperationTrace& trace ) const override;
 
 private:
 	CPtr<const CDnnBlob> first;
@@ -567,6 +614,13 @@ CTapeMax::CTapeMax( const CDnnBlob& _first, float _second ) :
 	NeoAssert( dynamic_cast<const CTapeBlob*>(first.Ptr()) != 0 );
 }
 
+void CTapeMax::Trace( CTapeOperationTrace& trace ) const
+{
+	trace.Type = TOT_MaxValue;
+	trace.First = first;
+	trace.Value = second;
+}
+
 CPtr<CDnnBlob> CTapeMax::Jacobian( const CTapeBlob* var ) const
 {
 	CPtr<CDnnBlob> jacobian = callJacobian( first, var );
@@ -606,11 +660,12 @@ CPtr<const CDnnBlob> NEOML_API Max( float first, const CDnnBlob* second )
 
 //------------------------------------------------------------------------------------------------------------
 
-class CTapeSum : public ITapeOperation {
+class CTapeSum : public ITapeOperation, public ITraceableTapeOperation {
 public:
 	explicit CTapeSum( const CDnnBlob& first, int axis );
 
 	CPtr<CDnnBlob> Jacobian( const CTapeBlob* var ) const override;
+	void Trace( CTapeOperationTrace& trace ) const override;
 
 	static void GetDimensions( const CDnnBlob* first, int axis, int& followingDimension,
 		int& dimensions, int& precedingDimension );
@@ -640,6 +695,13 @@ CTapeSum::CTapeSum( const CDnnBlob& _first, int axis ) :
 	NeoAssert( dynamic_cast<const CTapeBlob*>(first.Ptr()) != 0 );
 }
 
+void CTapeSum::Trace( CTapeOperationTrace& trace ) const
+{
+	trace.Type = TOT_Sum;
+	trace.First = first;
+	trace.Axis = axis;
+}
+
 CPtr<CDnnBlob> CTapeSum::Jacobian( const CTapeBlob* var ) const
 {
 	CPtr<CDnnBlob> jacobian = callJacobian( first, var );
@@ -703,11 +765,12 @@ CPtr<const CDnnBlob> Sum( const CDnnBlob* first, int axis )
 
 //------------------------------------------------------------------------------------------------------------
 
-class CTapeNeg : public ITapeOperation {
+class CTapeNeg : public ITapeOperation, public ITraceableTapeOperation {
 public:
 	explicit CTapeNeg( const CDnnBlob& first );
 
 	CPtr<CDnnBlob> Jacobian( const CTapeBlob* var ) const override;
+	void Trace( CTapeOperationTrace& trace ) const override;
 
 private:
 	CPtr<const CDnnBlob> first;
@@ -719,6 +782,12 @@ CTapeNeg::CTapeNeg( const CDnnBlob& _first ) :
 	NeoAssert( dynamic_cast<const CTapeBlob*>(first.Ptr()) != 0 );
 }
 
+void CTapeNeg::Trace( CTapeOperationTrace& trace ) const
+{
+	trace.Type = TOT_Neg;
+	trace.First = first;
+}
+
 CPtr<CDnnBlob> CTapeNeg::Jacobian( const CTapeBlob* var ) const
 {
 	CPtr<CDnnBlob> jacobian = callJacobian( first, var );
@@ -751,11 +820,12 @@ CPtr<const CDnnBlob> Neg( const CDnnBlob* first )
 
 //------------------------------------------------------------------------------------------------------------
 
-class CTapeAbs : public ITapeOperation {
+class CTapeAbs : public ITapeOperation, public ITraceableTapeOperation {
 public:
 	explicit CTapeAbs( const CDnnBlob& first );
 
 	CPtr<CDnnBlob> Jacobian( const CTapeBlob* var ) const override;
+	void Trace( CTapeOperationTrace& trace ) const override;
 
 private:
 	CPtr<const CDnnBlob> first;
@@ -767,6 +837,12 @@ CTapeAbs::CTapeAbs( const CDnnBlob& _first ) :
 	NeoAssert( dynamic_cast<const CTapeBlob*>(first.Ptr()) != 0 );
 }
 
+void CTapeAbs::Trace( CTapeOperationTrace& trace ) const
+{
+	trace.Type = TOT_Abs;
+	trace.First = first;
+}
+
 CPtr<CDnnBlob> CTapeAbs::Jacobian( const CTapeBlob* var ) const
 {
 	CPtr<CDnnBlob> jacobian = callJacobian( first, var );
@@ -802,11 +878,12 @@ CPtr<const CDnnBlob> Abs( const CDnnBlob* first )
 
 //------------------------------------------------------------------------------------------------------------
 
-class CTapeExp : public ITapeOperation {
+class CTapeExp : public ITapeOperation, public ITraceableTapeOperation {
 public:
 	explicit CTapeExp( const CDnnBlob& first );
 
 	CPtr<CDnnBlob> Jacobian( const CTapeBlob* var ) const override;
+	void Trace( CTapeOperationTrace& trace ) const override;
 
 private:
 	CPtr<const CDnnBlob> first;
@@ -818,6 +895,12 @@ CTapeExp::CTapeExp( const CDnnBlob& _first ) :
 	NeoAssert( dynamic_cast<const CTapeBlob*>(first.Ptr()) != 0 );
 }
 
+void CTapeExp::Trace( CTapeOperationTrace& trace ) const
+{
+	trace.Type = TOT_Exp;
+	trace.First = first;
+}
+
 CPtr<CDnnBlob> CTapeExp::Jacobian( const CTapeBlob* var ) const
 {
 	CPtr<CDnnBlob> jacobian = callJacobian( first, var );
@@ -862,11 +945,12 @@ CPtr<const CDnnBlob> Exp( const CDnnBlob* first )
 
 //------------------------------------------------------------------------------------------------------------
 
-class CTapeLog : public ITapeOperation {
+class CTapeLog : public ITapeOperation, public ITraceableTapeOperation {
 public:
 	explicit CTapeLog( const CDnnBlob& first );
 
 	CPtr<CDnnBlob> Jacobian( const CTapeBlob* var ) const override;
+	void Trace( CTapeOperationTrace& trace ) const override;
 
 private:
 	CPtr<const CDnnBlob> first;
@@ -878,6 +962,12 @@ CTapeLog::CTapeLog( const CDnnBlob& _first ) :
 	NeoAssert( dynamic_cast<const CTapeBlob*>(first.Ptr()) != 0 );
 }
 
+void CTapeLog::Trace( CTapeOperationTrace& trace ) const
+{
+	trace.Type = TOT_Log;
+	trace.First = first;
+}
+
 CPtr<CDnnBlob> CTapeLog::Jacobian( const CTapeBlob* var ) const
 {
 	CPtr<CDnnBlob> jacobian = callJacobian( first, var );
@@ -913,11 +1003,12 @@ CPtr<const CDnnBlob> Log( const CDnnBlob* first )
 
 //------------------------------------------------------------------------------------------------------------
 
-class CTapeTopK : public ITapeOperation {
+class CTapeTopK : public ITapeOperation, public ITraceableTapeOperation {
 public:
 	explicit CTapeTopK( const CDnnBlob& first, const CDnnBlob& indices );
 
 	CPtr<CDnnBlob> Jacobian( const CTapeBlob* var ) const override;
+	void Trace( CTapeOperationTrace& trace ) const override;
 
 private:
 	CPtr<const CDnnBlob> first;
@@ -931,6 +1022,13 @@ CTapeTopK::CTapeTopK( const CDnnBlob& _first, const CDnnBlob& _indices ) :
 	NeoAssert( dynamic_cast<const CTapeBlob*>(first.Ptr()) != 0 );
 }
 
+void CTapeTopK::Trace( CTapeOperationTrace& trace ) const
+{
+	trace.Type = TOT_TopK;
+	trace.First = first;
+	trace.Axis = indices->GetDataSize();
+}
+
 CPtr<CDnnBlob> CTapeTopK::Jacobian( const CTapeBlob* var ) const
 {
 	CPtr<CDnnBlob> jacobian = callJacobian( first, var );
@@ -969,11 +1067,12 @@ CPtr<const CDnnBlob> NEOML_API TopK( const CDnnBlob* first, int k )
 
 //------------------------------------------------------------------------------------------------------------
 
-class CTapeClip : public ITapeOperation {
+class CTapeClip : public ITapeOperation, public ITraceableTapeOperation {
 public:
 	explicit CTapeClip( const CDnnBlob& first, float minValue, float maxValue );
 
 	CPtr<CDnnBlob> Jacobian( const CTapeBlob* var ) const override;
+	void Trace( CTapeOperationTrace& trace ) const override;
 
 private:
 	CPtr<const CDnnBlob> first;
@@ -989,6 +1088,14 @@ CTapeClip::CTapeClip( const CDnnBlob& _first, float _minValue, float _maxValue )
 	NeoAssert( dynamic_cast<const CTapeBlob*>(first.Ptr()) != 0 );
 }
 
+void CTapeClip::Trace( CTapeOperationTrace& trace ) const
+{
+	trace.Type = TOT_Clip;
+	trace.First = first;
+	trace.Value = minValue;
+	trace.SecondValue = maxValue;
+}
+
 CPtr<CDnnBlob> CTapeClip::Jacobian( const CTapeBlob* var ) const
 {
 	CPtr<CDnnBlob> jacobian = callJacobian( first, var );
@@ -0,0 +1,619 @@
+/* Copyright © 2017-2021 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <NeoML/Dnn/AutoDiff.h>
+#include <Dnn/AutoDiffTrace.h>
+
+namespace NeoML {
+
+// The number of elements of a fused group processed at once
+// The intermediate results of the tile stay in the cache
+static const int TapeGraphTileSize = 4096;
+
+static inline bool isElementwise( TTapeOperationType type )
+{
+	return type != TOT_Variable && type != TOT_Sum && type != TOT_TopK && type != TOT_Count;
+}
+
+// The same split of the blob as in CTapeSum: the dimensions before the axis, the axis and the dimensions after it
+static void getSumDimensions( const CBlobDesc& desc, int axis, int& followingDimension,
+	int& dimension, int& precedingDimension )
+{
+	followingDimension = 1;
+	for( int d = 0; d < axis; d++ ) {
+		followingDimension *= desc.DimSize( d );
+	}
+	dimension = desc.DimSize( axis );
+	precedingDimension = 1;
+	for( int d = axis + 1; d < BD_Count; d++ ) {
+		precedingDimension *= desc.DimSize( d );
+	}
+}
+
+//------------------------------------------------------------------------------------------------------------
+
+class CTapeGraphImpl : public IObject {
+public:
+	CTapeGraphImpl( const CDnnBlob& expression, const CArray<const CDnnBlob*>& inputs );
+
+	int GetInputCount() const { return inputCount; }
+	void SetInput( int index, const CDnnBlob& blob );
+	CPtr<const CDnnBlob> Run();
+	CPtr<const CDnnBlob> Gradient( int index );
+
+private:
+	// The graph node: an input, a constant or an operation
+	struct CNode {
+		// TOT_Count for the inputs and the constants
+		TTapeOperationType Type;
+		int Args[2];
+		float Value;
+		float SecondValue;
+		int Axis;
+		CBlobDesc Desc;
+		// The fused group of the elementwise operation and its index inside the group
+		int Group;
+		int Slot;
+		bool NeedsGradient;
+		// The stored value; 0 for the intermediate results of the fused groups
+		CPtr<CDnnBlob> Data;
+		// The stored gradient; 0 for the intermediate results of the fused groups
+		CPtr<CDnnBlob> Diff;
+		// The indices of the elements selected by TOT_TopK
+		CPtr<CDnnBlob> Indices;
+
+		CNode() : Type( TOT_Count ), Value( 0 ), SecondValue( 0 ), Axis( 0 ), Group( NotFound ), Slot( NotFound ),
+			NeedsGradient( false ) { Args[0] = NotFound; Args[1] = NotFound; }
+	};
+
+	// The chain of the elementwise operations of the same size, calculated by tiles
+	struct CGroup {
+		int Size;
+		// The nodes of the group are groupNodes[FirstNode]...groupNodes[FirstNode + NodeCount - 1]
+		int FirstNode;
+		int NodeCount;
+	};
+
+	// The step of the calculation: either a group or a single node
+	struct CStep {
+		int Group;
+		int Node;
+	};
+
+	IMathEngine& mathEngine;
+	const int inputCount;
+	// The nodes in topological order; the first inputCount nodes are the inputs
+	CArray<CNode> nodes;
+	int output;
+	CArray<CGroup> groups;
+	CArray<int> groupNodes;
+	CArray<CStep> steps;
+	// The scalar arguments of the nodes: two values per node
+	CPtr<CDnnBlob> scalars;
+	// The buffer for the tiles of the fused groups
+	CPtr<CDnnBlob> scratch;
+	bool valuesReady;
+	bool gradientsReady;
+
+	int trace( const CDnnBlob* blob, const CPtr<IGradientTape>& tape, CMap<const CDnnBlob*, int>& blobNodes );
+	void buildGroups();
+	void allocate();
+
+	int tileSize( const CGroup& group ) const { return min( group.Size, TapeGraphTileSize ); }
+	CFloatHandle valueHandle( int index, int offset, int tile ) const;
+	CFloatHandle diffHandle( int index, int offset, int tile, int slotCount ) const;
+	CConstFloatHandle scalarHandle( int index, int pos ) const { return scalars->GetData() + 2 * index + pos; }
+
+	void runGroup( const CGroup& group );
+	void runNode( int index );
+	void calculateElementwise( int index, int offset, int count, int tile );
+	void calculateGradients();
+	void backwardGroup( const CGroup& group );
+	void backwardNode( int index );
+	void backwardElementwise( int index, int offset, int count, int tile, int slotCount );
+};
+
+CTapeGraphImpl::CTapeGraphImpl( const CDnnBlob& expression, const CArray<const CDnnBlob*>& inputs ) :
+	mathEngine( expression.GetMathEngine() ),
+	inputCount( inputs.Size() ),
+	output( NotFound ),
+	valuesReady( false ),
+	gradientsReady( false )
+{
+	const CTapeBlob* expressionTapeBlob = dynamic_cast<const CTapeBlob*>( &expression );
+	NeoAssert( expressionTapeBlob != 0 && expressionTapeBlob->Tape() != 0 );
+	const CPtr<IGradientTape> tape = expressionTapeBlob->Tape();
+
+	// The inputs are the first nodes, so that they are found before tracing their operations
+	CMap<const CDnnBlob*, int> blobNodes;
+	for( int i = 0; i < inputs.Size(); i++ ) {
+		NeoAssert( inputs[i] != 0 );
+		NeoAssert( &inputs[i]->GetMathEngine() == &mathEngine );
+		NeoAssert( !blobNodes.Has( inputs[i] ) );
+		const CTapeBlob* tapeBlob = dynamic_cast<const CTapeBlob*>( inputs[i] );
+		CNode& node = nodes.Append();
+		node.Desc = inputs[i]->GetDesc();
+		node.NeedsGradient = tapeBlob != 0 && tapeBlob->Tape() == tape;
+		node.Data = inputs[i]->GetCopy();
+		blobNodes.Add( inputs[i], i );
+	}
+
+	output = trace( &expression, tape, blobNodes );
+	buildGroups();
+	allocate();
+}
+
+// Adds the node for the blob after the nodes of its arguments
+int CTapeGraphImpl::trace( const CDnnBlob* blob, const CPtr<IGradientTape>& tape, CMap<const CDnnBlob*, int>& blobNodes )
+{
+	int index = NotFound;
+	if( blobNodes.Lookup( blob, index ) ) {
+		return index;
+	}
+
+	CTapeOperationTrace operationTrace;
+	const CTapeBlob* tapeBlob = dynamic_cast<const CTapeBlob*>( blob );
+	if( tapeBlob != 0 && tapeBlob->Tape() != 0 ) {
+		NeoAssert( tapeBlob->Tape() == tape );
+		CPtr<const ITapeOperation> operation = tape->GetOperation( tapeBlob );
+		if( operation != 0 ) {
+			const ITraceableTapeOperation* traceable = dynamic_cast<const ITraceableTapeOperation*>( operation.Ptr() );
+			// The user-defined operations can't be compiled
+			NeoAssert( traceable != 0 );
+			traceable->Trace( operationTrace );
+		}
+	}
+
+	CNode node;
+	node.Desc = blob->GetDesc();
+	if( operationTrace.Type == TOT_Count || operationTrace.Type == TOT_Variable ) {
+		// The blobs that aren't calculated by the tape and the variables that aren't the inputs are constant
+		node.Data = blob->GetCopy();
+	} else {
+		node.Type = operationTrace.Type;
+		node.Value = operationTrace.Value;
+		node.SecondValue = operationTrace.SecondValue;
+		node.Axis = operationTrace.Axis;
+		node.Args[0] = trace( operationTrace.First, tape, blobNodes );
+		node.NeedsGradient = nodes[node.Args[0]].NeedsGradient;
+		if( operationTrace.Second != 0 ) {
+			node.Args[1] = trace( operationTrace.Second, tape, blobNodes );
+			node.NeedsGradient = node.NeedsGradient || nodes[node.Args[1]].NeedsGradient;
+		}
+	}
+
+	index = nodes.Size();
+	nodes.Add( node );
+	blobNodes.Add( blob, index );
+	return index;
+}
+
+// Splits the elementwise operations into the groups
+// A group is closed by any other operation, so the groups may be calculated in the order of the nodes
+void CTapeGraphImpl::buildGroups()
+{
+	int openGroup = NotFound;
+	for( int i = 0; i < nodes.Size(); i++ ) {
+		CNode& node = nodes[i];
+		if( node.Type == TOT_Count ) {
+			continue;
+		}
+		if( !isElementwise( node.Type ) ) {
+			openGroup = NotFound;
+			CStep& step = steps.Append();
+			step.Group = NotFound;
+			step.Node = i;
+			continue;
+		}
+		if( openGroup == NotFound || groups[openGroup].Size != node.Desc.BlobSize() ) {
+			openGroup = groups.Size();
+			CGroup& group = groups.Append();
+			group.Size = node.Desc.BlobSize();
+			group.FirstNode = groupNodes.Size();
+			group.NodeCount = 0;
+			CStep& step = steps.Append();
+			step.Group = openGroup;
+			step.Node = NotFound;
+		}
+		node.Group = openGroup;
+		node.Slot = groups[openGroup].NodeCount;
+		groups[openGroup].NodeCount++;
+		groupNodes.Add( i );
+	}
+}
+
+void CTapeGraphImpl::allocate()
+{
+	// Only the results used outside of their group are stored
+	for( int i = 0; i < nodes.Size(); i++ ) {
+		CNode& node = nodes[i];
+		if( node.Type == TOT_Count ) {
+			continue;
+		}
+		if( node.Group == NotFound && node.Data == 0 ) {
+			node.Data = CDnnBlob::CreateBlob( mathEngine, node.Desc );
+		}
+		for( int arg : node.Args ) {
+			if( arg != NotFound && nodes[arg].Group != NotFound && nodes[arg].Group != node.Group && nodes[arg].Data == 0 ) {
+				nodes[arg].Data = CDnnBlob::CreateBlob( mathEngine, nodes[arg].Desc );
+			}
+		}
+		if( node.Type == TOT_TopK ) {
+			node.Indices = CDnnBlob::CreateBlob( mathEngine, CT_Int, { node.Axis } );
+		}
+	}
+	if( nodes[output].Data == 0 ) {
+		nodes[output].Data = CDnnBlob::CreateBlob( mathEngine, nodes[output].Desc );
+	}
+
+	CArray<float> scalarValues;
+	for( int i = 0; i < nodes.Size(); i++ ) {
+		CNode& node = nodes[i];
+		if( node.NeedsGradient && node.Data != 0 ) {
+			node.Diff = CDnnBlob::CreateBlob( mathEngine, node.Desc );
+		}
+		scalarValues.Add( node.Value );
+		scalarValues.Add( node.SecondValue );
+	}
+	scalars = CDnnBlob::CreateVector( mathEngine, CT_Float, scalarValues.Size() );
+	scalars->CopyFrom( scalarValues.GetPtr() );
+
+	// The values and the gradients of each node of the tile and one temporary buffer
+	int scratchSize = 0;
+	for( int i = 0; i < groups.Size(); i++ ) {
+		scratchSize = max( scratchSize, tileSize( groups[i] ) * ( 2 * groups[i].NodeCount + 1 ) );
+	}
+	if( scratchSize > 0 ) {
+		scratch = CDnnBlob::CreateVector( mathEngine, CT_Float, scratchSize );
+	}
+}
+
+CFloatHandle CTapeGraphImpl::valueHandle( int index, int offset, int tile ) const
+{
+	const CNode& node = nodes[index];
+	if( node.Data != 0 ) {
+		return node.Data->GetData() + offset;
+	}
+	return scratch->GetData() + node.Slot * tile;
+}
+
+CFloatHandle CTapeGraphImpl::diffHandle( int index, int offset, int tile, int slotCount ) const
+{
+	const CNode& node = nodes[index];
+	if( node.Diff != 0 ) {
+		return node.Diff->GetData() + offset;
+	}
+	NeoPresume( node.Group != NotFound );
+	return scratch->GetData() + ( slotCount + node.Slot ) * tile;
+}
+
+void CTapeGraphImpl::SetInput( int index, const CDnnBlob& blob )
+{
+	NeoAssert( 0 <= index && index < inputCount );
+	NeoAssert( &blob.GetMathEngine() == &mathEngine );
+	NeoAssert( blob.GetDataType() == CT_Float );
+	NeoAssert( blob.GetDataSize() == nodes[index].Data->GetDataSize() );
+	mathEngine.VectorCopy( nodes[index].Data->GetData(), blob.GetData(), blob.GetDataSize() );
+	valuesReady = false;
+	gradientsReady = false;
+}
+
+CPtr<const CDnnBlob> CTapeGraphImpl::Run()
+{
+	for( int i = 0; i < steps.Size(); i++ ) {
+		if( steps[i].Group != NotFound ) {
+			runGroup( groups[steps[i].Group] );
+		} else {
+			runNode( steps[i].Node );
+		}
+	}
+	valuesReady = true;
+	gradientsReady = false;
+	return nodes[output].Data.Ptr();
+}
+
+CPtr<const CDnnBlob> CTapeGraphImpl::Gradient( int index )
+{
+	NeoAssert( 0 <= index && index < inputCount );
+	if( !nodes[index].NeedsGradient ) {
+		return 0;
+	}
+	if( !valuesReady ) {
+		Run();
+	}
+	if( !gradientsReady ) {
+		calculateGradients();
+	}
+	return nodes[index].Diff.Ptr();
+}
+
+void CTapeGraphImpl::runGroup( const CGroup& group )
+{
+	const int tile = tileSize( group );
+	for( int offset = 0; offset < group.Size; offset += tile ) {
+		const int count = min( tile, group.Size - offset );
+		for( int i = 0; i < group.NodeCount; i++ ) {
+			calculateElementwise( groupNodes[group.FirstNode + i], offset, count, tile );
+		}
+	}
+}
+
+void CTapeGraphImpl::runNode( int index )
+{
+	const CNode& node = nodes[index];
+	const CNode& arg = nodes[node.Args[0]];
+	switch( node.Type ) {
+		case TOT_Sum:
+			if( node.Axis == -1 ) {
+				mathEngine.VectorSum( arg.Data->GetData(), arg.Desc.BlobSize(), node.Data->GetData() );
+			} else {
+				int followingDimension;
+				int dimension;
+				int precedingDimension;
+				getSumDimensions( arg.Desc, node.Axis, followingDimension, dimension, precedingDimension );
+				mathEngine.VectorSumAlongDimension( arg.Data->GetData(), precedingDimension, dimension, followingDimension,
+					node.Data->GetData() );
+			}
+			break;
+		case TOT_TopK:
+			mathEngine.VectorTopK( arg.Data->GetData(), arg.Desc.BlobSize(), node.Axis, node.Data->GetData(),
+				node.Indices->GetData<int>() );
+			break;
+		default:
+			NeoAssert( false );
+	}
+}
+
+void CTapeGraphImpl::calculateElementwise( int index, int offset, int count, int tile )
+{
+	const CNode& node = nodes[index];
+	const CFloatHandle result = valueHandle( index, offset, tile );
+	const CConstFloatHandle first = valueHandle( node.Args[0], offset, tile );
+	const CConstFloatHandle second = node.Args[1] != NotFound ? valueHandle( node.Args[1], offset, tile ) : first;
+
+	switch( node.Type ) {
+		case TOT_Add:
+			mathEngine.VectorAdd( first, second, result, count );
+			break;
+		case TOT_AddValue:
+			mathEngine.VectorAddValue( first, result, count, scalarHandle( index, 0 ) );
+			break;
+		case TOT_Sub:
+			mathEngine.VectorSub( first, second, result, count );
+			break;
+		case TOT_SubValue:
+			mathEngine.VectorSub( first, node.Value, result, count );
+			break;
+		case TOT_ValueSub:
+			mathEngine.VectorSub( node.Value, first, result, count );
+			break;
+		case TOT_Mul:
+			mathEngine.VectorEltwiseMultiply( first, second, result, count );
+			break;
+		case TOT_Div:
+			mathEngine.VectorEltwiseDivide( first, second, result, count );
+			break;
+		case TOT_MaxValue:
+			mathEngine.VectorMax( first, node.Value, result, count );
+			break;
+		case TOT_Neg:
+			mathEngine.VectorNeg( first, result, count );
+			break;
+		case TOT_Abs:
+			mathEngine.VectorAbs( first, result, count );
+			break;
+		case TOT_Exp:
+			mathEngine.VectorExp( first, result, count );
+			break;
+		case TOT_Log:
+			mathEngine.VectorLog( first, result, count );
+			break;
+		case TOT_Clip:
+			mathEngine.VectorMinMax( first, result, count, scalarHandle( index, 0 ), scalarHandle( index, 1 ) );
+			break;
+		default:
+			NeoAssert( false );
+	}
+}
+
+// Calculates the gradients of the sum of the expression elements in reverse mode
+void CTapeGraphImpl::calculateGradients()
+{
+	for( int i = 0; i < nodes.Size(); i++ ) {
+		if( nodes[i].Diff != 0 ) {
+			nodes[i].Diff->Clear();
+		}
+	}
+	if( nodes[output].NeedsGradient ) {
+		nodes[output].Diff->Fill( 1.f );
+		for( int i = steps.Size() - 1; i >= 0; i-- ) {
+			if( steps[i].Group != NotFound ) {
+				backwardGroup( groups[steps[i].Group] );
+			} else {
+				backwardNode( steps[i].Node );
+			}
+		}
+	}
+	gradientsReady = true;
+}
+
+// The intermediate results of the tile are recalculated instead of being stored by the forward pass
+void CTapeGraphImpl::backwardGroup( const CGroup& group )
+{
+	const int tile = tileSize( group );
+	for( int offset = 0; offset < group.Size; offset += tile ) {
+		const int count = min( tile, group.Size - offset );
+		for( int i = 0; i < group.NodeCount; i++ ) {
+			const int index = groupNodes[group.FirstNode + i];
+			if( nodes[index].Data == 0 ) {
+				calculateElementwise( index, offset, count, tile );
+			}
+			if( nodes[index].NeedsGradient && nodes[index].Diff == 0 ) {
+				mathEngine.VectorFill( diffHandle( index, offset, tile, group.NodeCount ), 0.f, count );
+			}
+		}
+		for( int i = group.NodeCount - 1; i >= 0; i-- ) {
+			const int index = groupNodes[group.FirstNode + i];
+			if( nodes[index].NeedsGradient ) {
+				backwardElementwise( index, offset, count, tile, group.NodeCount );
+			}
+		}
+	}
+}
+
+void CTapeGraphImpl::backwardNode( int index )
+{
+	const CNode& node = nodes[index];
+	if( !node.NeedsGradient ) {
+		return;
+	}
+	const CNode& arg = nodes[node.Args[0]];
+	switch( node.Type ) {
+		case TOT_Sum:
+			if( node.Axis == -1 ) {
+				mathEngine.VectorAddValue( arg.Diff->GetData(), arg.Diff->GetData(), arg.Desc.BlobSize(), node.Diff->GetData() );
+			} else {
+				int followingDimension;
+				int dimension;
+				int precedingDimension;
+				getSumDimensions( arg.Desc, node.Axis, followingDimension, dimension, precedingDimension );
+				mathEngine.AddVectorToMatrixRows( followingDimension, arg.Diff->GetData(), arg.Diff->GetData(),
+					dimension, precedingDimension, node.Diff->GetData() );
+			}
+			break;
+		case TOT_TopK:
+			mathEngine.MatrixSpreadRowsAdd( node.Diff->GetData(), node.Axis, 1, arg.Diff->GetData(), arg.Desc.BlobSize(),
+				node.Indices->GetData<int>() );
+			break;
+		default:
+			NeoAssert( false );
+	}
+}
+
+// Adds the vector-jacobian products of the node to the gradients of its arguments
+void CTapeGraphImpl::backwardElementwise( int index, int offset, int count, int tile, int slotCount )
+{
+	const CNode& node = nodes[index];
+	const CConstFloatHandle diff = diffHandle( index, offset, tile, slotCount );
+	const CConstFloatHandle result = valueHandle( index, offset, tile );
+	const CConstFloatHandle first = valueHandle( node.Args[0], offset, tile );
+	const bool hasFirstDiff = nodes[node.Args[0]].NeedsGradient;
+	const CFloatHandle firstDiff = hasFirstDiff ? diffHandle( node.Args[0], offset, tile, slotCount ) : CFloatHandle();
+	const bool hasSecondDiff = node.Args[1] != NotFound && nodes[node.Args[1]].NeedsGradient;
+	const CConstFloatHandle second = node.Args[1] != NotFound ? valueHandle( node.Args[1], offset, tile ) : first;
+	const CFloatHandle secondDiff = hasSecondDiff ? diffHandle( node.Args[1], offset, tile, slotCount ) : CFloatHandle();
+	const CFloatHandle temp = scratch->GetData() + 2 * slotCount * tile;
+
+	switch( node.Type ) {
+		case TOT_Add:
+		case TOT_Sub:
+			if( hasFirstDiff ) {
+				mathEngine.VectorAdd( firstDiff, diff, firstDiff, count );
+			}
+			if( hasSecondDiff ) {
+				if( node.Type == TOT_Add ) {
+					mathEngine.VectorAdd( secondDiff, diff, secondDiff, count );
+				} else {
+					mathEngine.VectorSub( secondDiff, diff, secondDiff, count );
+				}
+			}
+			break;
+		case TOT_AddValue:
+		case TOT_SubValue:
+			mathEngine.VectorAdd( firstDiff, diff, firstDiff, count );
+			break;
+		case TOT_ValueSub:
+		case TOT_Neg:
+			mathEngine.VectorSub( firstDiff, diff, firstDiff, count );
+			break;
+		case TOT_Mul:
+			if( hasFirstDiff ) {
+				mathEngine.VectorEltwiseMultiplyAdd( diff, second, firstDiff, count );
+			}
+			if( hasSecondDiff ) {
+				mathEngine.VectorEltwiseMultiplyAdd( diff, first, secondDiff, count );
+			}
+			break;
+		case TOT_Div:
+			// d(first / second) = diff / second * ( dFirst - result * dSecond )
+			mathEngine.VectorEltwiseDivide( diff, second, temp, count );
+			if( hasFirstDiff ) {
+				mathEngine.VectorAdd( firstDiff, temp, firstDiff, count );
+			}
+			if( hasSecondDiff ) {
+				mathEngine.VectorEltwiseMultiply( temp, result, temp, count );
+				mathEngine.VectorSub( secondDiff, temp, secondDiff, count );
+			}
+			break;
+		case TOT_MaxValue:
+			mathEngine.VectorCopy( temp, diff, count );
+			mathEngine.VectorMaxDiff( first, node.Value, temp, 1, count );
+			mathEngine.VectorAdd( firstDiff, temp, firstDiff, count );
+			break;
+		case TOT_Abs:
+			mathEngine.VectorAbsDiff( diff, 1, count, first, temp );
+			mathEngine.VectorAdd( firstDiff, temp, firstDiff, count );
+			break;
+		case TOT_Exp:
+			mathEngine.VectorEltwiseMultiplyAdd( diff, result, firstDiff, count );
+			break;
+		case TOT_Log:
+			mathEngine.VectorEltwiseDivide( diff, first, temp, count );
+			mathEngine.VectorAdd( firstDiff, temp, firstDiff, count );
+			break;
+		case TOT_Clip:
+			mathEngine.VectorMinMaxDiff( diff, 1, count, first, temp, scalarHandle( index, 0 ), scalarHandle( index, 1 ) );
+			mathEngine.VectorAdd( firstDiff, temp, firstDiff, count );
+			break;
+		default:
+			NeoAssert( false );
+	}
+}
+
+//------------------------------------------------------------------------------------------------------------
+
+CTapeGraph::CTapeGraph( const CDnnBlob& expression, const CArray<const CDnnBlob*>& inputs ) :
+	impl( new CTapeGraphImpl( expression, inputs ) )
+{
+}
+
+CTapeGraph::~CTapeGraph()
+{
+}
+
+int CTapeGraph::GetInputCount() const
+{
+	return impl->GetInputCount();
+}
+
+void CTapeGraph::SetInput( int index, const CDnnBlob& blob )
+{
+	impl->SetInput( index, blob );
+}
+
+CPtr<const CDnnBlob> CTapeGraph::Run()
+{
+	return impl->Run();
+}
+
+CPtr<const CDnnBlob> CTapeGraph::Gradient( int index )
+{
+	return impl->Gradient( index );
+}
+
+} // namespace NeoML
@@ -0,0 +1,71 @@
+/* Copyright © 2017-2021 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <NeoML/NeoMLDefs.h>
+#include <NeoML/Dnn/DnnBlob.h>
+
+namespace NeoML {
+
+// The types of the tape operations that may be traced into CTapeGraph
+enum TTapeOperationType {
+	TOT_Variable = 0, // the tape variable
+	TOT_Add, // first + second
+	TOT_AddValue, // first + value
+	TOT_Sub, // first - second
+	TOT_SubValue, // first - value
+	TOT_ValueSub, // value - first
+	TOT_Mul, // first * second
+	TOT_Div, // first / second
+	TOT_MaxValue, // max( first, value )
+	TOT_Neg, // -first
+	TOT_Abs, // |first|
+	TOT_Exp, // exp( first )
+	TOT_Log, // log( first )
+	TOT_Clip, // min( max( first, value ), secondValue )
+	TOT_Sum, // the sum along the axis
+	TOT_TopK, // the k largest elements
+
+	TOT_Count
+};
+
+// The description of an operation recorded on the tape
+struct CTapeOperationTrace {
+	TTapeOperationType Type;
+	// The blob arguments; Second is used only by the binary operations
+	const CDnnBlob* First;
+	const CDnnBlob* Second;
+	// The scalar arguments
+	float Value;
+	float SecondValue;
+	// The axis of TOT_Sum (-1 for the sum of all elements) or k of TOT_TopK
+	int Axis;
+
+	CTapeOperationTrace() : Type( TOT_Count ), First( 0 ), Second( 0 ), Value( 0 ), SecondValue( 0 ), Axis( 0 ) {}
+};
+
+// The built-in tape operations implement this interface so that they could be compiled into CTapeGraph
+// The user-defined operations can't be traced
+class ITraceableTapeOperation {
+public:
+	// Describes the operation
+	virtual void Trace( CTapeOperationTrace& trace ) const = 0;
+
+protected:
+	virtual ~ITraceableTapeOperation() {}
+};
+
+} // namespace NeoML
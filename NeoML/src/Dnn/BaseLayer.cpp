@@ -549,18 +549,20 @@ void CBaseLayer::backwardRunAndLearnOnce()
 	}
 	// Learning: change the layer weights, using the output errors and inputs
 	if( IsLearningPerformed() ) {
-		if( paramDiffBlobs.Size() == 0 ) {
+		// The solver will change the parameters, so they may not be mapped from a read-only file
+		for( int i = 0; i < paramBlobs.Size(); ++i ) {
+			NeoAssert( paramBlobs[i] == 0 || !paramBlobs[i]->IsReadOnly() );
+		}
+		const bool hasSparseParamDiffs = HasSparseParamDiffs();
+		if( paramDiffBlobs.Size() == 0 && !hasSparseParamDiffs ) {
 			// Create blobs
-			for( int i = 0; i < paramBlobs.Size(); ++i ) {
-				paramDiffBlobs.Add( paramBlobs[i]->GetClone() );
-				paramDiffBlobs[i]->Clear();
-			}
+			GetDnn()->GetSolver()->createParamDiffBlobs( *this, paramDiffBlobs );
 		}
 		// Calculate parameter diffs
 		LearnOnce();
 		// Change paramBlobs layer parameters, by applying paramDiffBlobs corrections
 		// according to optimizer strategy
-		if( paramBlobs.Size() != 0 && ( !dnn->IsRecurrentMode() || dnn->IsFirstSequencePos() ) ) {
+		if( paramBlobs.Size() != 0 && !hasSparseParamDiffs && ( !dnn->IsRecurrentMode() || dnn->IsFirstSequencePos() ) ) {
 			GetDnn()->GetSolver()->AddDiff( this, paramDiffBlobs );
 			paramDiffBlobs.DeleteAll();
 		}
@@ -699,6 +701,16 @@ void CBaseLayer::InitializeParamBlob(int input, CDnnBlob& blob, int inputCount)
 	GetDnn()->GetInitializer()->InitializeLayerParams(blob, inputCount);
 }
 
+void CBaseLayer::ShareParamBlobs( const CBaseLayer& source )
+{
+	NeoAssert( &source.mathEngine == &mathEngine );
+	NeoAssert( source.paramBlobs.Size() == paramBlobs.Size() );
+
+	for( int i = 0; i < paramBlobs.Size(); ++i ) {
+		paramBlobs[i] = source.paramBlobs[i];
+	}
+}
+
 static const int BaseLayerVersion = 2000;
 
 void CBaseLayer::Serialize( CArchive& archive )
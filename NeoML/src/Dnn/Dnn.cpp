@@ -343,7 +343,9 @@ CDnn::CDnn( CRandom& _random, IMathEngine& _mathEngine ) :
 	currentSequencePos( 0 ),
 	isReverseSequense( false ),
 	autoRestartMode( true ),
-	isReuseMemoryMode( false )
+	isReuseMemoryMode( false ),
+	isStaticMemoryPlanningEnabled( false ),
+	isMemoryPlanValid( false )
 {
 	solver = FINE_DEBUG_NEW CDnnSimpleGradientSolver( mathEngine );
 	initializer = FINE_DEBUG_NEW CDnnXavierInitializer( random );
@@ -454,6 +456,7 @@ void CDnn::EnableLearning()
 
 void CDnn::RequestReshape(bool forcedReshape)
 {
+	isMemoryPlanValid = false;
 	for( int i = 0; i < layers.Size(); i++ ) {
 		layers[i]->isReshapeNeeded = true;
 		layers[i]->forcedReshape = layers[i]->forcedReshape || forcedReshape;
@@ -520,8 +523,15 @@ void CDnn::RunOnce()
 			RestartSequence();
 		}
 		reshape(); // rebuild the network if necessary
-		
-		isReuseMemoryMode = ( getOutputBlobsSize() > MinReuseMemoryModeNetSize );
+
+		if( isStaticMemoryPlanningEnabled ) {
+			isReuseMemoryMode = false;
+			if( !isMemoryPlanValid ) {
+				buildMemoryPlan();
+			}
+		} else {
+			isReuseMemoryMode = ( getOutputBlobsSize() > MinReuseMemoryModeNetSize );
+		}
 		runOnce(0);
 	}
 #ifdef NEOML_USE_FINEOBJ
@@ -583,6 +593,33 @@ void CDnn::CleanUp()
 	for( int i = 0; i < layers.Size(); i++ ) {
 		layers[i]->CleanUp();
 	}
+	memoryPlanBuffer = 0;
+	isMemoryPlanValid = false;
+}
+
+void CDnn::EnableStaticMemoryPlanning()
+{
+	if( isStaticMemoryPlanningEnabled ) {
+		return;
+	}
+	isStaticMemoryPlanningEnabled = true;
+	isMemoryPlanValid = false;
+}
+
+void CDnn::DisableStaticMemoryPlanning()
+{
+	if( !isStaticMemoryPlanningEnabled ) {
+		return;
+	}
+	isStaticMemoryPlanningEnabled = false;
+	memoryPlanBuffer = 0;
+	// Release the planned blobs
+	RequestReshape(true);
+}
+
+size_t CDnn::GetMemoryPlanSize() const
+{
+	return memoryPlanBuffer == 0 ? 0 : memoryPlanBuffer->GetDataSize() * sizeof( float );
 }
 
 void CDnn::backwardRunAndLearnOnce(int curSequencePos)
@@ -664,6 +701,202 @@ size_t CDnn::getOutputBlobsSize() const
 	return result;
 }
 
+// The blob that occupies a part of the memory plan buffer
+class CMemoryPlanBlob : public CDnnBlob {
+public:
+	CMemoryPlanBlob( CDnnBlob* _buffer, const CBlobDesc& desc, int offset ) :
+		CDnnBlob( _buffer->GetMathEngine(), desc, _buffer->GetData() + offset, false ),
+		buffer( _buffer )
+	{
+	}
+
+private:
+	const CPtr<CDnnBlob> buffer; // the buffer is kept while any of its blobs is alive
+};
+
+// A layer output in the memory plan
+struct CMemoryPlanEntry {
+	CBaseLayer* Layer;
+	int Output;
+	int Size; // the number of elements (aligned)
+	int Start; // the step on which the output is calculated
+	int End; // the last step on which the output is used
+	int Offset; // the offset in the buffer
+
+	CMemoryPlanEntry() : Layer( 0 ), Output( 0 ), Size( 0 ), Start( 0 ), End( 0 ), Offset( 0 ) {}
+};
+
+// The alignment of the outputs in the buffer, in elements
+static const int MemoryPlanAlignment = 16;
+
+static int findMemoryPlanGroup( CArray<int>& groups, int value )
+{
+	while( groups[value] != value ) {
+		groups[value] = groups[groups[value]];
+		value = groups[value];
+	}
+	return value;
+}
+
+static void uniteMemoryPlanGroups( CArray<int>& groups, int first, int second )
+{
+	groups[findMemoryPlanGroup( groups, first )] = findMemoryPlanGroup( groups, second );
+}
+
+// Builds the static memory plan for the current blob sizes
+// Each layer output gets a part of one buffer; the outputs that are not used at the same time may share memory
+void CDnn::buildMemoryPlan()
+{
+	isMemoryPlanValid = true;
+
+	// The layers in the order of execution (the same as in runOnce)
+	CArray<CBaseLayer*> order;
+	CMap<CBaseLayer*, int> steps;
+	CArray<CBaseLayer*> stack;
+	CArray<int> nextInputs;
+	for( int i = 0; i < sinkLayers.Size(); ++i ) {
+		if( steps.Has( sinkLayers[i] ) ) {
+			continue;
+		}
+		steps.Add( sinkLayers[i], NotFound );
+		stack.Add( sinkLayers[i] );
+		nextInputs.Add( 0 );
+		while( !stack.IsEmpty() ) {
+			CBaseLayer* layer = stack.Last();
+			if( nextInputs.Last() < layer->GetInputCount() ) {
+				CBaseLayer* inputLayer = layer->GetInputLayer( nextInputs.Last()++ );
+				if( !steps.Has( inputLayer ) ) {
+					steps.Add( inputLayer, NotFound );
+					stack.Add( inputLayer );
+					nextInputs.Add( 0 );
+				}
+			} else {
+				steps.Set( layer, order.Size() );
+				order.Add( layer );
+				stack.DeleteLast();
+				nextInputs.DeleteLast();
+			}
+		}
+	}
+
+	// Calculate the lifetimes of the outputs
+	// The outputs that may be the same blob (in-place processing, composite layers) are united into groups
+	CArray<int> firstOutputs;
+	firstOutputs.SetSize( order.Size() + 1 );
+	firstOutputs[0] = 0;
+	for( int step = 0; step < order.Size(); ++step ) {
+		firstOutputs[step + 1] = firstOutputs[step] + order[step]->outputBlobs.Size();
+	}
+	const int outputCount = firstOutputs.Last();
+	CArray<int> lastUses;
+	CArray<int> groups;
+	lastUses.SetSize( outputCount );
+	groups.SetSize( outputCount );
+	for( int step = 0; step < order.Size(); ++step ) {
+		for( int i = firstOutputs[step]; i < firstOutputs[step + 1]; ++i ) {
+			lastUses[i] = step;
+			groups[i] = i;
+		}
+	}
+	for( int step = 0; step < order.Size(); ++step ) {
+		CBaseLayer* layer = order[step];
+		const CBaseInPlaceLayer* inPlaceLayer = dynamic_cast<const CBaseInPlaceLayer*>( layer );
+		for( int i = 0; i < layer->GetInputCount(); ++i ) {
+			const int input = firstOutputs[steps.Get( layer->GetInputLayer( i ) )] + layer->inputLinks[i].OutputNumber;
+			// The inputs of the sink layers must be kept after the run
+			lastUses[input] = layer->GetOutputCount() == 0 ? INT_MAX : max( lastUses[input], step );
+			if( layer->isComposite() ) {
+				for( int j = firstOutputs[step]; j < firstOutputs[step + 1]; ++j ) {
+					uniteMemoryPlanGroups( groups, j, input );
+				}
+			} else if( inPlaceLayer != 0 && inPlaceLayer->IsInPlace() ) {
+				uniteMemoryPlanGroups( groups, firstOutputs[step] + i, input );
+			}
+		}
+	}
+	CArray<int> groupLastUses;
+	groupLastUses.Add( NotFound, outputCount );
+	for( int i = 0; i < outputCount; ++i ) {
+		const int group = findMemoryPlanGroup( groups, i );
+		groupLastUses[group] = max( groupLastUses[group], lastUses[i] );
+	}
+
+	// Only the outputs allocated by CBaseLayer::AllocateOutputBlobs are planned
+	CArray<CMemoryPlanEntry> entries;
+	for( int step = 0; step < order.Size(); ++step ) {
+		CBaseLayer* layer = order[step];
+		const CBaseInPlaceLayer* inPlaceLayer = dynamic_cast<const CBaseInPlaceLayer*>( layer );
+		if( layer->GetInputCount() == 0 || layer->isComposite() ) {
+			continue;
+		}
+		// Release the references to the blobs of the previous plan
+		for( int i = 0; i < layer->inputBlobs.Size(); ++i ) {
+			layer->inputBlobs[i] = 0;
+		}
+		if( inPlaceLayer != 0 && inPlaceLayer->IsInPlace() ) {
+			// The outputs will be taken from the inputs on the next run
+			for( int i = 0; i < layer->outputBlobs.Size(); ++i ) {
+				layer->outputBlobs[i] = 0;
+			}
+			continue;
+		}
+		for( int i = 0; i < layer->outputBlobs.Size(); ++i ) {
+			layer->outputBlobs[i] = 0;
+			CMemoryPlanEntry& entry = entries.Append();
+			entry.Layer = layer;
+			entry.Output = i;
+			entry.Size = ( layer->outputDescs[i].BlobSize() + MemoryPlanAlignment - 1 )
+				/ MemoryPlanAlignment * MemoryPlanAlignment;
+			entry.Start = step;
+			entry.End = groupLastUses[findMemoryPlanGroup( groups, firstOutputs[step] + i )];
+		}
+	}
+	memoryPlanBuffer = 0;
+
+	// Greedy placement: the largest outputs first, each one into the smallest suitable gap
+	// between the outputs that are alive at the same time
+	entries.QuickSort< DescendingByMember<CMemoryPlanEntry, int, &CMemoryPlanEntry::Size> >();
+	CArray<CMemoryPlanEntry> placed;
+	CArray<CMemoryPlanEntry> overlapping;
+	int bufferSize = 0;
+	for( int i = 0; i < entries.Size(); ++i ) {
+		CMemoryPlanEntry& entry = entries[i];
+		overlapping.DeleteAll();
+		for( int j = 0; j < placed.Size(); ++j ) {
+			if( placed[j].Start <= entry.End && entry.Start <= placed[j].End ) {
+				overlapping.Add( placed[j] );
+			}
+		}
+		overlapping.QuickSort< AscendingByMember<CMemoryPlanEntry, int, &CMemoryPlanEntry::Offset> >();
+
+		int bestOffset = NotFound;
+		int bestGap = INT_MAX;
+		int prevEnd = 0;
+		for( int j = 0; j < overlapping.Size(); ++j ) {
+			const int gap = overlapping[j].Offset - prevEnd;
+			if( gap >= entry.Size && gap < bestGap ) {
+				bestOffset = prevEnd;
+				bestGap = gap;
+			}
+			prevEnd = max( prevEnd, overlapping[j].Offset + overlapping[j].Size );
+		}
+		entry.Offset = bestOffset == NotFound ? prevEnd : bestOffset;
+		NeoAssert( entry.Offset <= INT_MAX - entry.Size );
+		bufferSize = max( bufferSize, entry.Offset + entry.Size );
+		placed.Add( entry );
+	}
+
+	if( bufferSize == 0 ) {
+		return;
+	}
+	memoryPlanBuffer = CDnnBlob::CreateVector( mathEngine, CT_Float, bufferSize );
+	for( int i = 0; i < entries.Size(); ++i ) {
+		const CMemoryPlanEntry& entry = entries[i];
+		entry.Layer->outputBlobs[entry.Output] = FINE_DEBUG_NEW CMemoryPlanBlob( memoryPlanBuffer,
+			entry.Layer->outputDescs[entry.Output], entry.Offset );
+	}
+}
+
 void CDnn::FilterLayersParams( float threshold )
 {
 	for( int i = 0; i < layers.Size(); ++i ) {
@@ -19,6 +19,7 @@ limitations under the License.
 #include <NeoML/Dnn/DnnBlob.h>
 #include <NeoMathEngine/NeoMathEngine.h>
 #include <NeoML/Dnn/Layers/LossLayer.h>
+#include <NeoML/MappedArchiveFile.h>
 
 namespace NeoML {
 
@@ -26,7 +27,8 @@ CDnnBlob::CDnnBlob( IMathEngine& _mathEngine ) :
 	mathEngine( _mathEngine ),
 	dataOwned( true ),
 	parent(0),
-	parentPos(0)
+	parentPos(0),
+	isReadOnly( false )
 {
 }
 
@@ -91,6 +93,29 @@ CDnnBlob* CDnnBlob::CreateWindowBlob(const CPtr<CDnnBlob>& parent, int windowSiz
 	return result;
 }
 
+CDnnBlob* CDnnBlob::CreateViewBlob( const CPtr<CDnnBlob>& owner, const CBlobDesc& desc, int offset )
+{
+	NeoAssert( owner != 0 );
+	NeoAssert( desc.GetDataType() == owner->GetDataType() );
+	NeoAssert( offset >= 0 && offset + desc.BlobSize() <= owner->GetDataSize() );
+
+	CMemoryHandle viewData;
+	switch( desc.GetDataType() ) {
+		case CT_Float:
+			viewData = owner->GetData<float>() + offset;
+			break;
+		case CT_Int:
+			viewData = owner->GetData<int>() + offset;
+			break;
+		default:
+			NeoAssert( false );
+	}
+	CDnnBlob* result = FINE_DEBUG_NEW CDnnBlob( owner->GetMathEngine(), desc, viewData, false );
+	result->externalData = owner.Ptr();
+	result->isReadOnly = owner->IsReadOnly();
+	return result;
+}
+
 CDnnBlob* CDnnBlob::CreateBlob(IMathEngine& mathEngine, TBlobType type, const CBlobDesc& pattern)
 {
 	CDnnBlob* result = FINE_DEBUG_NEW CDnnBlob( mathEngine );
@@ -217,6 +242,7 @@ CDnnBlob* CDnnBlob::GetCopy() const
 void CDnnBlob::CopyFrom(const CDnnBlob* other)
 {
 	NeoAssert(HasEqualDimensions(other));
+	NeoAssert(!IsReadOnly());
 	switch(GetDataType()) {
 		case CT_Float:
 			mathEngine.VectorCopy( GetData<float>(), other->GetData<float>(), GetDataSize() );
@@ -232,6 +258,7 @@ void CDnnBlob::CopyFrom(const CDnnBlob* other)
 void CDnnBlob::Add(const CDnnBlob* other)
 {
 	NeoPresume(other->GetDataSize() == GetDataSize());
+	NeoAssert(!IsReadOnly());
 	switch(GetDataType()) {
 		case CT_Float:
 			mathEngine.VectorAdd( GetData<float>(), other->GetData<float>(), GetData<float>(), GetDataSize() );
@@ -246,6 +273,7 @@ void CDnnBlob::Add(const CDnnBlob* other)
 
 void CDnnBlob::Clear()
 {
+	NeoAssert(!IsReadOnly());
 	switch(GetDataType()) {
 		case CT_Float:
 			mathEngine.VectorFill( GetData<float>(), 0, GetDataSize() );
@@ -260,6 +288,7 @@ void CDnnBlob::Clear()
 
 void CDnnBlob::ClearObject(int num)
 {
+	NeoAssert(!IsReadOnly());
 	switch(GetDataType()) {
 		case CT_Float:
 			mathEngine.VectorFill(GetObjectData<float>( num ), 0, GetObjectSize());
@@ -324,6 +353,7 @@ void CDnnBlob::TransposeFrom(const CDnnBlob* other, int _d1, int _d2)
 	int d1 = min(_d1, _d2);
 	int d2 = max(_d1, _d2);
 	NeoAssert( GetDataType() == other->GetDataType() && GetDataSize() == other->GetDataSize() );
+	NeoAssert( !IsReadOnly() );
 	
 	int height = other->DimSize(d1);
 	int width = other->DimSize(d2);
@@ -490,78 +520,90 @@ void CDnnBlob::SplitByObject( IMathEngine& mathEngine, const CPtr<CDnnBlob>& fro
 	SplitByDim( mathEngine, static_cast<TBlobDim>(CBlobDesc::FirstObjectDim), from, to );
 }
 
-// Reads the data from archive into blob memory; in case of CPU reads directly
-template<typename T>
-static void readRawData( IMathEngine& mathEngine, CArchive& archive, const CTypedMemoryHandle<T>& handle )
-{
-	unsigned int size = 0;
-	archive >> size;
-	check( static_cast<int>( size ) >= 0, ERR_BAD_ARCHIVE, archive.Name() );
+// The smaller blobs are always copied from a memory-mapped file, because sharing their memory saves little
+// SkipMappedData works for the data of any size, so the threshold does not depend on the archive buffer size
+static const int MinMappedDataSize = 4096;
 
-	if( size > 0 ) {
-		void* ptr = mathEngine.GetBuffer( handle, 0, size * sizeof(T), false );
-		archive.Read( ptr, size * sizeof(T) );
-		mathEngine.ReleaseBuffer( handle, ptr, true );
-	}
-}
-
-template<typename T>
-static void writeRawData( IMathEngine& mathEngine, const int size, const CTypedMemoryHandle<T>& handle, CArchive& archive )
-{
-	archive << static_cast<unsigned int>( size );
-
-	if( size > 0 ) {
-		void* ptr = mathEngine.GetBuffer( handle, 0, size * sizeof(T), true );
-		archive.Write( ptr, size * sizeof(T) );
-		mathEngine.ReleaseBuffer( handle, ptr, false );
-	}
-}
-
-static const int BlobVersion = 2000;
+static const int BlobVersion = 2001;
 
 void CDnnBlob::Serialize( CArchive& archive )
 {
 	NeoAssert( parent == 0 ); // a blob that links to another may not be serialized
 
-	archive.SerializeVersion( BlobVersion, CDnn::ArchiveMinSupportedVersion );
+	const int version = archive.SerializeVersion( BlobVersion, CDnn::ArchiveMinSupportedVersion );
 
 	if( archive.IsStoring() ) {
+		NeoAssert( GetDataType() == CT_Float || GetDataType() == CT_Int );
 		archive << static_cast<int>( GetDataType() );
 		archive << static_cast<int>( 0 );
 		for( TBlobDim d = TBlobDim(0); d < BD_Count; ++d ) {
 			archive << desc.DimSize(d);
 		}
 
-		switch(GetDataType()) {
-			case CT_Float:
-				writeRawData( mathEngine, desc.BlobSize(), GetData<float>(), archive );
-				break;
-			case CT_Int:
-				writeRawData( mathEngine, desc.BlobSize(), GetData<int>(), archive );
-				break;
-			default:
-				NeoAssert( false );
+		const int size = desc.BlobSize();
+		archive << static_cast<unsigned int>( size );
+		if( size > 0 ) {
+			WriteMappedDataPadding( archive );
+			void* ptr = mathEngine.GetBuffer( data, 0, size * sizeof( float ), true );
+			archive.Write( ptr, size * sizeof( float ) );
+			mathEngine.ReleaseBuffer( data, ptr, false );
 		}
 	} else if( archive.IsLoading() ) {
 		int intType;
 		archive >> intType;
 		TBlobType type = static_cast<TBlobType>(intType);
+		check( type == CT_Float || type == CT_Int, ERR_BAD_ARCHIVE, archive.Name() );
 
 		int intPack;
 		archive >> intPack;
 		int batchLength, batchWidth, listSize, height, width, depth, channels;
 		archive >> batchLength >> batchWidth >> listSize >> height >> width >> depth >> channels;
-		initializeBlob(type, batchLength, batchWidth, listSize, height, width, depth, channels);
-
-		switch( type ) {
-			case CT_Float:
-				readRawData( mathEngine, archive, GetData<float>() );
-				break;
-			case CT_Int:
-				readRawData( mathEngine, archive, GetData<int>() );
-				break;
-			default:
-				NeoAssert( false );
+
+		unsigned int size = 0;
+		archive >> size;
+		check( static_cast<int>( size ) >= 0, ERR_BAD_ARCHIVE, archive.Name() );
+		if( size > 0 && version >= 2001 ) {
+			ReadMappedDataPadding( archive );
+		}
+		// Both float and int take 4 bytes
+		static_assert( sizeof( float ) == sizeof( int ), "sizeof( float ) != sizeof( int )" );
+		const int dataSize = static_cast<int>( size * sizeof( float ) );
+
+		CPtr<CMappedFileData> mapping;
+		const char* mappedData = dataSize < MinMappedDataSize ? nullptr : SkipMappedData( archive, dataSize, mapping );
+		CMemoryHandle mappedHandle;
+		if( mappedData != nullptr && reinterpret_cast<uintptr_t>( mappedData ) % MappedDataAlignment == 0 ) {
+			mappedHandle = mathEngine.GetExternalMemoryHandle( mappedData );
+		}
+
+		if( !mappedHandle.IsNull() ) {
+			// The blob points directly into the mapped file
+			desc = CBlobDesc( type );
+			desc.SetDimSize( BD_BatchLength, batchLength );
+			desc.SetDimSize( BD_BatchWidth, batchWidth );
+			desc.SetDimSize( BD_ListSize, listSize );
+			desc.SetDimSize( BD_Height, height );
+			desc.SetDimSize( BD_Width, width );
+			desc.SetDimSize( BD_Depth, depth );
+			desc.SetDimSize( BD_Channels, channels );
+			check( desc.BlobSize() == static_cast<int>( size ), ERR_BAD_ARCHIVE, archive.Name() );
+			data = mappedHandle;
+			dataOwned = false;
+			externalData = mapping.Ptr();
+			isReadOnly = true;
+		} else {
+			initializeBlob( type, batchLength, batchWidth, listSize, height, width, depth, channels );
+			check( desc.BlobSize() >= static_cast<int>( size ), ERR_BAD_ARCHIVE, archive.Name() );
+			if( size > 0 ) {
+				void* ptr = mathEngine.GetBuffer( data, 0, dataSize, false );
+				if( mappedData != nullptr ) {
+					// The data has already been skipped in the archive
+					::memcpy( ptr, mappedData, dataSize );
+				} else {
+					archive.Read( ptr, dataSize );
+				}
+				mathEngine.ReleaseBuffer( data, ptr, true );
+			}
 		}
 		parentPos = 0;
 	} else {
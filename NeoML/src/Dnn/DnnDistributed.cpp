@@ -0,0 +1,415 @@
+/* Copyright © 2021 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <NeoML/Dnn/DnnDistributed.h>
+#include <NeoML/Dnn/DnnSolver.h>
+#include <NeoML/Dnn/Layers/CompositeLayer.h>
+#include <NeoML/Dnn/Layers/LossLayer.h>
+#include <NeoML/Dnn/Layers/SinkLayer.h>
+#include <Dnn/DnnMemoryFile.h>
+
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace NeoML {
+
+IDistributedDataset::~IDistributedDataset()
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// The threads that run the replicas
+// Each replica is always run by the same thread, so the per-thread memory pools of its math engine are reused
+class CDistributedTraining::CWorkerThreads {
+public:
+	explicit CWorkerThreads( int count );
+	~CWorkerThreads();
+
+	// Calls task( index ) on each thread and waits until all calls are finished
+	// The first exception thrown by the task is rethrown on the calling thread
+	template<class TTask>
+	void Run( TTask& task ) { run( []( int index, void* params ) { ( *static_cast<TTask*>( params ) )( index ); }, &task ); }
+
+private:
+	typedef void ( *TTaskFunction )( int index, void* params );
+
+	std::vector<std::thread> threads;
+	std::mutex mutex;
+	std::condition_variable taskStarted;
+	std::condition_variable taskFinished;
+	TTaskFunction function;
+	void* params;
+	int generation; // the number of the current task
+	int remainingCount; // the number of the threads that haven't finished the current task
+	bool isStopped;
+	std::exception_ptr exception;
+
+	void run( TTaskFunction function, void* params );
+	void threadProc( int index );
+};
+
+CDistributedTraining::CWorkerThreads::CWorkerThreads( int count ) :
+	function( nullptr ),
+	params( nullptr ),
+	generation( 0 ),
+	remainingCount( 0 ),
+	isStopped( false )
+{
+	for( int i = 0; i < count; ++i ) {
+		threads.emplace_back( &CWorkerThreads::threadProc, this, i );
+	}
+}
+
+CDistributedTraining::CWorkerThreads::~CWorkerThreads()
+{
+	{
+		std::lock_guard<std::mutex> lock( mutex );
+		isStopped = true;
+	}
+	taskStarted.notify_all();
+	for( std::thread& thread : threads ) {
+		thread.join();
+	}
+}
+
+void CDistributedTraining::CWorkerThreads::run( TTaskFunction _function, void* _params )
+{
+	std::unique_lock<std::mutex> lock( mutex );
+	function = _function;
+	params = _params;
+	remainingCount = static_cast<int>( threads.size() );
+	exception = nullptr;
+	++generation;
+	taskStarted.notify_all();
+	taskFinished.wait( lock, [this] { return remainingCount == 0; } );
+
+	if( exception != nullptr ) {
+		std::rethrow_exception( exception );
+	}
+}
+
+void CDistributedTraining::CWorkerThreads::threadProc( int index )
+{
+	int lastGeneration = 0;
+	while( true ) {
+		TTaskFunction currentFunction = nullptr;
+		void* currentParams = nullptr;
+		{
+			std::unique_lock<std::mutex> lock( mutex );
+			taskStarted.wait( lock, [&] { return isStopped || generation != lastGeneration; } );
+			if( isStopped ) {
+				return;
+			}
+			lastGeneration = generation;
+			currentFunction = function;
+			currentParams = params;
+		}
+
+		std::exception_ptr taskException;
+		try {
+			currentFunction( index, currentParams );
+		} catch( ... ) {
+			taskException = std::current_exception();
+		}
+
+		std::lock_guard<std::mutex> lock( mutex );
+		if( taskException != nullptr && exception == nullptr ) {
+			exception = taskException;
+		}
+		if( --remainingCount == 0 ) {
+			taskFinished.notify_one();
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Adds the layers of the graph (including the layers of the composite layers) to the list
+static void addLayers( CDnnLayerGraph& graph, CArray<CBaseLayer*>& layers )
+{
+	CArray<const char*> layerNames;
+	graph.GetLayerList( layerNames );
+	for( int i = 0; i < layerNames.Size(); ++i ) {
+		CPtr<CBaseLayer> layer = graph.GetLayer( layerNames[i] );
+		layers.Add( layer.Ptr() );
+		CCompositeLayer* composite = dynamic_cast<CCompositeLayer*>( layer.Ptr() );
+		if( composite != nullptr ) {
+			addLayers( *composite, layers );
+		}
+	}
+}
+
+CDistributedTraining::CDistributedTraining( CDnn& dnn, int count, int threadCount ) :
+	threads( nullptr )
+{
+	NeoAssert( count > 0 );
+	NeoAssert( threadCount >= 0 );
+	if( threadCount == 0 ) {
+		threadCount = max( 1, static_cast<int>( std::thread::hardware_concurrency() ) / count );
+	}
+
+	// The network is copied together with the solver
+	CDnnMemoryFile file;
+	{
+		CArchive archive( &file, CArchive::SD_Storing );
+		dnn.SerializeCheckpoint( archive );
+	}
+
+	// Each replica draws different random values (for example, the dropout masks)
+	const unsigned int seed = dnn.Random().Next();
+	// The replicas recreate the initializer with their own random generators
+	// Only the built-in initializers can be recreated, other ones are not supported
+	const CDnnUniformInitializer* uniformInitializer =
+		dynamic_cast<const CDnnUniformInitializer*>( dnn.GetInitializer().Ptr() );
+	NeoAssert( uniformInitializer != nullptr
+		|| dynamic_cast<const CDnnXavierInitializer*>( dnn.GetInitializer().Ptr() ) != nullptr );
+	for( int i = 0; i < count; ++i ) {
+		mathEngines.Add( CreateCpuMathEngine( threadCount, 0 ) );
+		randoms.Add( FINE_DEBUG_NEW CRandom( seed + static_cast<unsigned int>( i ) ) );
+		cnns.Add( FINE_DEBUG_NEW CDnn( *randoms[i], *mathEngines[i] ) );
+		// The initializers use the same random state so that the replicas initialize their parameters in the same way
+		initRandoms.Add( FINE_DEBUG_NEW CRandom( dnn.Random() ) );
+		if( uniformInitializer != nullptr ) {
+			cnns[i]->SetInitializer( FINE_DEBUG_NEW CDnnUniformInitializer( *initRandoms[i],
+				uniformInitializer->GetLowerBound(), uniformInitializer->GetUpperBound() ) );
+		} else {
+			cnns[i]->SetInitializer( FINE_DEBUG_NEW CDnnXavierInitializer( *initRandoms[i] ) );
+		}
+
+		file.SeekToBegin();
+		CArchive archive( &file, CArchive::SD_Loading );
+		cnns[i]->SerializeCheckpoint( archive );
+		NeoAssert( cnns[i]->GetSolver() != nullptr );
+	}
+
+	threads = FINE_DEBUG_NEW CWorkerThreads( count );
+}
+
+CDistributedTraining::~CDistributedTraining()
+{
+	delete threads;
+	// The networks should be destroyed before their math engines
+	layers.DeleteAll();
+	cnns.DeleteAll();
+	randoms.DeleteAll();
+	initRandoms.DeleteAll();
+	for( int i = 0; i < mathEngines.Size(); ++i ) {
+		delete mathEngines[i];
+	}
+}
+
+float CDistributedTraining::GetLearningRate() const
+{
+	return cnns[0]->GetSolver()->GetLearningRate();
+}
+
+void CDistributedTraining::SetLearningRate( float newRate )
+{
+	for( int i = 0; i < cnns.Size(); ++i ) {
+		cnns[i]->GetSolver()->SetLearningRate( newRate );
+	}
+}
+
+void CDistributedTraining::RunOnce( IDistributedDataset& data )
+{
+	auto task = [&]( int index ) {
+		data.SetInputBatch( *cnns[index], index );
+		cnns[index]->RunOnce();
+	};
+	threads->Run( task );
+}
+
+void CDistributedTraining::RunAndBackwardOnce( IDistributedDataset& data )
+{
+	auto task = [&]( int index ) {
+		data.SetInputBatch( *cnns[index], index );
+		cnns[index]->RunAndBackwardOnce();
+	};
+	threads->Run( task );
+}
+
+void CDistributedTraining::Train()
+{
+	allReduce();
+	auto task = [&]( int index ) {
+		cnns[index]->GetSolver()->Train();
+	};
+	threads->Run( task );
+}
+
+void CDistributedTraining::RunAndLearnOnce( IDistributedDataset& data )
+{
+	RunAndBackwardOnce( data );
+	Train();
+}
+
+float CDistributedTraining::GetLastLoss( const CString& layerName ) const
+{
+	float loss = 0;
+	for( int i = 0; i < cnns.Size(); ++i ) {
+		loss += CheckCast<const CLossLayer>( cnns[i]->GetLayer( layerName ).Ptr() )->GetLastLoss();
+	}
+	return loss / cnns.Size();
+}
+
+void CDistributedTraining::GetLastBlob( const CString& layerName, CObjectArray<CDnnBlob>& blobs ) const
+{
+	blobs.SetSize( cnns.Size() );
+	for( int i = 0; i < cnns.Size(); ++i ) {
+		blobs[i] = CheckCast<const CSinkLayer>( cnns[i]->GetLayer( layerName ).Ptr() )->GetBlob();
+	}
+}
+
+void CDistributedTraining::Serialize( CArchive& archive )
+{
+	NeoAssert( archive.IsStoring() );
+	cnns[0]->Serialize( archive );
+}
+
+void CDistributedTraining::SerializeCheckpoint( CArchive& archive )
+{
+	NeoAssert( archive.IsStoring() );
+	cnns[0]->SerializeCheckpoint( archive );
+}
+
+// Finds the corresponding layers of the replicas
+void CDistributedTraining::collectLayers()
+{
+	layers.DeleteAll();
+	firstReplicaLayerIndex.DeleteAll();
+	for( int i = 0; i < cnns.Size(); ++i ) {
+		layers.Add( FINE_DEBUG_NEW CArray<CBaseLayer*>() );
+		addLayers( *cnns[i], *layers[i] );
+		NeoAssert( layers[i]->Size() == layers[0]->Size() );
+	}
+	for( int i = 0; i < layers[0]->Size(); ++i ) {
+		firstReplicaLayerIndex.Add( ( *layers[0] )[i], i );
+	}
+}
+
+// The gradients of one parameter blob in all replicas
+struct CDistributedGradient {
+	int Offset; // the position of the first element in the list of all gradients
+	int Size;
+	CArray<float*> Data; // the gradient data of each replica
+};
+
+// Averages the accumulated gradients over the replicas
+// Each thread averages its part of the gradients and writes the result into all replicas
+void CDistributedTraining::allReduce()
+{
+	const int count = cnns.Size();
+	if( count == 1 ) {
+		return;
+	}
+
+	CArray<CDnnSolver*> solvers;
+	for( int i = 0; i < count; ++i ) {
+		solvers.Add( cnns[i]->GetSolver() );
+		// The replicas may use different rows, so the sparse gradients are averaged as the usual ones
+		solvers[i]->convertSparseDiffs( true );
+	}
+
+	CPointerArray<CDistributedGradient> gradients;
+	// The blobs whose buffers are used, in the order of the GetBuffer calls
+	CObjectArray<CDnnBlob> gradientBlobs;
+	CArray<float*> gradientBuffers;
+	int totalSize = 0;
+	int layerCount = 0;
+	const CMap<CBaseLayer*, CDnnSolver::CDiffBlobSum>& firstSums = solvers[0]->layerToParamDiffBlobsSum;
+	for( TMapPosition pos = firstSums.GetFirstPosition(); pos != NotFound; pos = firstSums.GetNextPosition( pos ) ) {
+		const CDnnSolver::CDiffBlobSum& firstSum = firstSums.GetValue( pos );
+		if( firstSum.Sum.IsEmpty() ) {
+			continue;
+		}
+		int layerIndex = NotFound;
+		if( !firstReplicaLayerIndex.Lookup( firstSums.GetKey( pos ), layerIndex ) ) {
+			// The layer list has changed
+			collectLayers();
+			layerIndex = firstReplicaLayerIndex.Get( firstSums.GetKey( pos ) );
+		}
+		layerCount++;
+
+		const int gradientCount = gradients.Size();
+		for( int i = 0; i < firstSum.Sum.Size(); ++i ) {
+			CDistributedGradient* gradient = FINE_DEBUG_NEW CDistributedGradient;
+			gradient->Offset = totalSize;
+			gradient->Size = firstSum.Sum[i]->GetDataSize();
+			totalSize += gradient->Size;
+			gradients.Add( gradient );
+		}
+		for( int replica = 0; replica < count; ++replica ) {
+			const CDnnSolver::CDiffBlobSum& sum =
+				solvers[replica]->layerToParamDiffBlobsSum.Get( ( *layers[replica] )[layerIndex] );
+			// All replicas should have been run the same number of times
+			NeoAssert( sum.Count == firstSum.Count );
+			NeoAssert( sum.Sum.Size() == firstSum.Sum.Size() );
+			for( int i = 0; i < sum.Sum.Size(); ++i ) {
+				NeoAssert( sum.Sum[i]->GetDataSize() == gradients[gradientCount + i]->Size );
+				float* buffer = sum.Sum[i]->GetBuffer<float>( 0, sum.Sum[i]->GetDataSize(), true );
+				gradientBlobs.Add( sum.Sum[i] );
+				gradientBuffers.Add( buffer );
+				gradients[gradientCount + i]->Data.Add( buffer );
+			}
+		}
+	}
+
+	// Every replica should have trained the same layers
+	for( int replica = 1; replica < count; ++replica ) {
+		int replicaLayerCount = 0;
+		const CMap<CBaseLayer*, CDnnSolver::CDiffBlobSum>& sums = solvers[replica]->layerToParamDiffBlobsSum;
+		for( TMapPosition pos = sums.GetFirstPosition(); pos != NotFound; pos = sums.GetNextPosition( pos ) ) {
+			if( !sums.GetValue( pos ).Sum.IsEmpty() ) {
+				replicaLayerCount++;
+			}
+		}
+		NeoAssert( replicaLayerCount == layerCount );
+	}
+
+	const float multiplier = 1.f / count;
+	auto task = [&]( int index ) {
+		const int start = static_cast<int>( static_cast<int64_t>( totalSize ) * index / count );
+		const int end = static_cast<int>( static_cast<int64_t>( totalSize ) * ( index + 1 ) / count );
+		for( int i = 0; i < gradients.Size(); ++i ) {
+			const CDistributedGradient& gradient = *gradients[i];
+			const int first = max( start, gradient.Offset ) - gradient.Offset;
+			const int last = min( end, gradient.Offset + gradient.Size ) - gradient.Offset;
+			for( int j = first; j < last; ++j ) {
+				float value = gradient.Data[0][j];
+				for( int replica = 1; replica < count; ++replica ) {
+					value += gradient.Data[replica][j];
+				}
+				value *= multiplier;
+				for( int replica = 0; replica < count; ++replica ) {
+					gradient.Data[replica][j] = value;
+				}
+			}
+		}
+	};
+	threads->Run( task );
+
+	for( int i = gradientBlobs.Size() - 1; i >= 0; --i ) {
+		gradientBlobs[i]->ReleaseBuffer( gradientBuffers[i], true );
+	}
+}
+
+} // namespace NeoML
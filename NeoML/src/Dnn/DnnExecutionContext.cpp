@@ -0,0 +1,66 @@
+/* Copyright © 2017-2021 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+
+#include <common.h>
+#pragma hdrstop
+
+#include <NeoML/Dnn/DnnExecutionContext.h>
+#include <NeoML/Dnn/Layers/SourceLayer.h>
+#include <NeoML/Dnn/Layers/SinkLayer.h>
+#include <Dnn/DnnMemoryFile.h>
+
+namespace NeoML {
+
+CDnnExecutionContext::CDnnExecutionContext( CDnn& source ) :
+	dnn( random, source.GetMathEngine() )
+{
+	// Copy the layer graph through serialization
+	// The parameters are copied as well but only for the duration of the constructor
+	{
+		CDnnMemoryFile file;
+		{
+			CArchive archive( &file, CArchive::SD_Storing );
+			source.Serialize( archive );
+		}
+		file.SeekToBegin();
+		CArchive archive( &file, CArchive::SD_Loading );
+		dnn.Serialize( archive );
+	}
+	dnn.DisableLearning();
+
+	CArray<const char*> layerList;
+	dnn.GetLayerList( layerList );
+	for( int i = 0; i < layerList.Size(); ++i ) {
+		dnn.GetLayer( layerList[i] )->ShareParamBlobs( *source.GetLayer( layerList[i] ) );
+	}
+}
+
+void CDnnExecutionContext::SetInputBlob( const char* sourceName, CDnnBlob* blob )
+{
+	CheckCast<CSourceLayer>( dnn.GetLayer( sourceName ).Ptr() )->SetBlob( blob );
+}
+
+void CDnnExecutionContext::RunOnce()
+{
+	dnn.RunOnce();
+}
+
+const CPtr<CDnnBlob>& CDnnExecutionContext::GetOutputBlob( const char* sinkName ) const
+{
+	return CheckCast<const CSinkLayer>( dnn.GetLayer( sinkName ).Ptr() )->GetBlob();
+}
+
+} // namespace NeoML
@@ -0,0 +1,190 @@
+/* Copyright © 2017-2021 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <NeoML/Dnn/DnnOptimization.h>
+#include <NeoML/Dnn/Dnn.h>
+#include <NeoML/Dnn/Layers/ActivationLayers.h>
+#include <NeoML/Dnn/Layers/BatchNormalizationLayer.h>
+#include <NeoML/Dnn/Layers/FullyConnectedLayer.h>
+#include <NeoML/Dnn/Layers/ConvLayer.h>
+
+namespace NeoML {
+
+// Folds the batch normalization into the convolution or fully connected layer
+// Returns false if the layers may not be merged
+static bool foldBatchNormalization( IMathEngine& mathEngine, CBaseLayer& layer, CBatchNormalizationLayer& batchNorm )
+{
+	CPtr<CDnnBlob> params = batchNorm.GetFinalParams();
+	if( params == nullptr ) {
+		return false;
+	}
+
+	CConvLayer* conv = dynamic_cast<CConvLayer*>( &layer );
+	if( conv != nullptr ) {
+		// The convolution adds the free term even if IsZeroFreeTerm() is set
+		if( conv->IsQuantized() || !conv->GetActivation().IsIdentity() || !batchNorm.IsChannelBased()
+			|| params->GetObjectSize() != conv->GetFilterCount() )
+		{
+			return false;
+		}
+		conv->ApplyBatchNormalization( batchNorm );
+		conv->SetZeroFreeTerm( false );
+		return true;
+	}
+
+	CFullyConnectedLayer* fc = dynamic_cast<CFullyConnectedLayer*>( &layer );
+	if( fc != nullptr ) {
+		// Both the channel-based and the object-based normalization have one parameter per element
+		if( fc->IsQuantized() || !fc->GetActivation().IsIdentity()
+			|| params->GetObjectSize() != fc->GetNumberOfElements() )
+		{
+			return false;
+		}
+		if( fc->IsZeroFreeTerm() ) {
+			// The layer ignores its free term, so it is replaced with zeros before adding the normalization bias
+			CPtr<CDnnBlob> freeTerms = CDnnBlob::CreateVector( mathEngine, CT_Float, fc->GetNumberOfElements() );
+			freeTerms->Fill( 0 );
+			fc->SetFreeTermData( freeTerms );
+			fc->SetZeroFreeTerm( false );
+		}
+		fc->ApplyBatchNormalization( batchNorm );
+		return true;
+	}
+
+	return false;
+}
+
+// Sets the activation as the output activation of the convolution or fully connected layer
+// Returns false if the layer does not support it
+static bool mergeActivation( CBaseLayer& layer, const CActivationDesc& activation )
+{
+	CConvLayer* conv = dynamic_cast<CConvLayer*>( &layer );
+	if( conv != nullptr && conv->GetActivation().IsIdentity() ) {
+		conv->SetActivation( activation );
+		return true;
+	}
+	CFullyConnectedLayer* fc = dynamic_cast<CFullyConnectedLayer*>( &layer );
+	if( fc != nullptr && fc->GetActivation().IsIdentity() ) {
+		fc->SetActivation( activation );
+		return true;
+	}
+	return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+CDnnOptimizer::CDnnOptimizer( CDnn& _dnn ) :
+	dnn( _dnn )
+{
+}
+
+int CDnnOptimizer::FoldBatchNormalization()
+{
+	int result = 0;
+	CArray<const char*> layerList;
+	dnn.GetLayerList( layerList );
+	for( int i = 0; i < layerList.Size(); ++i ) {
+		CBatchNormalizationLayer* batchNorm = dynamic_cast<CBatchNormalizationLayer*>( dnn.GetLayer( layerList[i] ).Ptr() );
+		if( batchNorm == nullptr || batchNorm->GetInputCount() != 1 ) {
+			continue;
+		}
+		CPtr<CBaseLayer> layer = dnn.GetLayer( batchNorm->GetInputName( 0 ) );
+		if( layer->GetInputCount() != 1 || !hasSingleConsumer( *layer ) || !hasParamBlobs( *layer )
+			|| !foldBatchNormalization( dnn.GetMathEngine(), *layer, *batchNorm ) )
+		{
+			continue;
+		}
+		removeLayer( *batchNorm, *layer );
+		++result;
+	}
+	return result;
+}
+
+int CDnnOptimizer::MergeActivations()
+{
+	int result = 0;
+	CArray<const char*> layerList;
+	dnn.GetLayerList( layerList );
+	for( int i = 0; i < layerList.Size(); ++i ) {
+		CPtr<CBaseLayer> activationLayer = dnn.GetLayer( layerList[i] );
+		CActivationDesc activation;
+		if( activationLayer->GetInputCount() != 1 || !GetActivationDesc( *activationLayer, activation ) ) {
+			continue;
+		}
+		CPtr<CBaseLayer> layer = dnn.GetLayer( activationLayer->GetInputName( 0 ) );
+		if( layer->GetInputCount() != 1 || !hasSingleConsumer( *layer ) || !mergeActivation( *layer, activation ) ) {
+			continue;
+		}
+		removeLayer( *activationLayer, *layer );
+		++result;
+	}
+	return result;
+}
+
+int CDnnOptimizer::Optimize()
+{
+	// The normalization is folded first so that the activations following it could be merged too
+	const int foldedCount = FoldBatchNormalization();
+	return foldedCount + MergeActivations();
+}
+
+// Checks if the layer parameters are initialized
+bool CDnnOptimizer::hasParamBlobs( const CBaseLayer& layer )
+{
+	for( int i = 0; i < layer.paramBlobs.Size(); ++i ) {
+		if( layer.paramBlobs[i] == nullptr ) {
+			return false;
+		}
+	}
+	return !layer.paramBlobs.IsEmpty();
+}
+
+// Checks if the first output of the layer is connected to exactly one input of the other layers
+bool CDnnOptimizer::hasSingleConsumer( const CBaseLayer& layer ) const
+{
+	int consumerCount = 0;
+	CArray<const char*> layerList;
+	dnn.GetLayerList( layerList );
+	for( int i = 0; i < layerList.Size(); ++i ) {
+		const CBaseLayer* other = dnn.GetLayer( layerList[i] );
+		for( int j = 0; j < other->GetInputCount(); ++j ) {
+			if( strcmp( other->GetInputName( j ), layer.GetName() ) == 0 ) {
+				++consumerCount;
+			}
+		}
+	}
+	return consumerCount == 1;
+}
+
+// Deletes the single-input layer and connects its consumers to the replacement
+void CDnnOptimizer::removeLayer( CBaseLayer& layer, const CBaseLayer& replacement )
+{
+	CArray<const char*> layerList;
+	dnn.GetLayerList( layerList );
+	for( int i = 0; i < layerList.Size(); ++i ) {
+		CPtr<CBaseLayer> other = dnn.GetLayer( layerList[i] );
+		for( int j = 0; j < other->GetInputCount(); ++j ) {
+			if( strcmp( other->GetInputName( j ), layer.GetName() ) == 0 ) {
+				other->Connect( j, replacement );
+			}
+		}
+	}
+	dnn.DeleteLayer( layer );
+}
+
+} // namespace NeoML
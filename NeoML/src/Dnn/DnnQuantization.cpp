@@ -0,0 +1,222 @@
+/* Copyright © 2017-2021 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <NeoML/Dnn/DnnQuantization.h>
+#include <NeoML/Dnn/Dnn.h>
+#include <NeoML/Dnn/Layers/CompositeLayer.h>
+#include <NeoML/Dnn/Layers/FullyConnectedLayer.h>
+#include <NeoML/Dnn/Layers/ConvLayer.h>
+#include <float.h>
+
+namespace NeoML {
+
+CQuantizedWeights::CQuantizedWeights( IMathEngine& _mathEngine ) :
+	mathEngine( _mathEngine ),
+	isCalibrating( false ),
+	inputMin( FLT_MAX ),
+	inputMax( -FLT_MAX ),
+	inputScale( 1.f ),
+	inputZeroPoint( 0 ),
+	weightsDesc( CT_Float )
+{
+}
+
+void CQuantizedWeights::UpdateInputRange( const CDnnBlob& input )
+{
+	const int dataSize = input.GetDataSize();
+
+	CFloatHandleStackVar maxValue( mathEngine );
+	CFloatHandleStackVar minValue( mathEngine );
+	CIntHandleStackVar minIndex( mathEngine );
+	mathEngine.FindMaxValueInRows( input.GetData(), 1, dataSize, maxValue, 1 );
+	mathEngine.FindMinValueInColumns( input.GetData(), dataSize, 1, minValue, minIndex );
+
+	inputMin = min( inputMin, minValue.GetValue() );
+	inputMax = max( inputMax, maxValue.GetValue() );
+}
+
+void CQuantizedWeights::ResetInputRange()
+{
+	inputMin = FLT_MAX;
+	inputMax = -FLT_MAX;
+}
+
+void CQuantizedWeights::Quantize( const CDnnBlob& weights )
+{
+	NeoAssert( HasInputRange() );
+	NeoAssert( weights.GetDataType() == CT_Float );
+
+	weightsDesc = weights.GetDesc();
+	const int height = weights.GetObjectCount();
+	const int width = weights.GetObjectSize();
+
+	quantizedData = CDnnBlob::CreateVector( mathEngine, CT_Int, ( height * width + sizeof( int ) - 1 ) / sizeof( int ) );
+	scales = CDnnBlob::CreateVector( mathEngine, CT_Float, height );
+	mathEngine.QuantizeMatrixRows( weights.GetData(), height, width,
+		CInt8Handle( quantizedData->GetData<int>() ), scales->GetData() );
+
+	calcInputQuantization();
+}
+
+void CQuantizedWeights::Reset()
+{
+	quantizedData = nullptr;
+	scales = nullptr;
+}
+
+CPtr<CDnnBlob> CQuantizedWeights::Dequantize() const
+{
+	NeoAssert( IsQuantized() );
+
+	CPtr<CDnnBlob> result = CDnnBlob::CreateBlob( mathEngine, CT_Float, weightsDesc );
+	const int height = result->GetObjectCount();
+	const int width = result->GetObjectSize();
+
+	CArray<int> packedValues;
+	packedValues.SetSize( quantizedData->GetDataSize() );
+	quantizedData->CopyTo( packedValues.GetPtr() );
+	const signed char* values = reinterpret_cast<const signed char*>( packedValues.GetPtr() );
+
+	CArray<float> rowScales;
+	rowScales.SetSize( height );
+	scales->CopyTo( rowScales.GetPtr() );
+
+	CArray<float> weights;
+	weights.SetSize( height * width );
+	for( int i = 0; i < height; ++i ) {
+		for( int j = 0; j < width; ++j ) {
+			weights[i * width + j] = values[i * width + j] * rowScales[i];
+		}
+	}
+	result->CopyFrom( weights.GetPtr() );
+	return result;
+}
+
+void CQuantizedWeights::Share( const CQuantizedWeights& other )
+{
+	NeoAssert( &other.mathEngine == &mathEngine );
+
+	inputMin = other.inputMin;
+	inputMax = other.inputMax;
+	inputScale = other.inputScale;
+	inputZeroPoint = other.inputZeroPoint;
+	weightsDesc = other.weightsDesc;
+	quantizedData = other.quantizedData;
+	scales = other.scales;
+}
+
+static const int QuantizedWeightsVersion = 0;
+
+void CQuantizedWeights::Serialize( CArchive& archive )
+{
+	archive.SerializeVersion( QuantizedWeightsVersion );
+
+	archive.Serialize( inputMin );
+	archive.Serialize( inputMax );
+	archive.Serialize( inputScale );
+	archive.Serialize( inputZeroPoint );
+	for( int i = 0; i < CBlobDesc::MaxDimensions; ++i ) {
+		int dimSize = weightsDesc.DimSize( i );
+		archive.Serialize( dimSize );
+		weightsDesc.SetDimSize( i, dimSize );
+	}
+	SerializeBlob( mathEngine, archive, quantizedData );
+	SerializeBlob( mathEngine, archive, scales );
+
+	if( archive.IsLoading() ) {
+		isCalibrating = false;
+	}
+}
+
+// Calculates the parameters of the asymmetric quantization of the input into [0, 255] range
+void CQuantizedWeights::calcInputQuantization()
+{
+	// The range always contains zero so that the zero padding is represented exactly
+	const float rangeMin = min( inputMin, 0.f );
+	const float rangeMax = max( inputMax, 0.f );
+
+	inputScale = rangeMax > rangeMin ? ( rangeMax - rangeMin ) / 255 : 1.f;
+	inputZeroPoint = min( 255, max( 0, Round( -rangeMin / inputScale ) ) );
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+CDnnQuantizer::CDnnQuantizer( CDnn& _dnn ) :
+	dnn( _dnn )
+{
+}
+
+void CDnnQuantizer::RunCalibration()
+{
+	setCalibrating( dnn, true );
+	dnn.RunOnce();
+	setCalibrating( dnn, false );
+}
+
+int CDnnQuantizer::Quantize()
+{
+	return quantize( dnn );
+}
+
+void CDnnQuantizer::setCalibrating( CDnnLayerGraph& graph, bool isCalibrating )
+{
+	CArray<const char*> layerList;
+	graph.GetLayerList( layerList );
+	for( int i = 0; i < layerList.Size(); ++i ) {
+		CBaseLayer* layer = graph.GetLayer( layerList[i] );
+
+		CFullyConnectedLayer* fc = dynamic_cast<CFullyConnectedLayer*>( layer );
+		if( fc != nullptr ) {
+			fc->EnableQuantizationCalibration( isCalibrating );
+		}
+		CConvLayer* conv = dynamic_cast<CConvLayer*>( layer );
+		if( conv != nullptr ) {
+			conv->EnableQuantizationCalibration( isCalibrating );
+		}
+		CCompositeLayer* composite = dynamic_cast<CCompositeLayer*>( layer );
+		if( composite != nullptr ) {
+			setCalibrating( *composite, isCalibrating );
+		}
+	}
+}
+
+int CDnnQuantizer::quantize( CDnnLayerGraph& graph )
+{
+	int result = 0;
+	CArray<const char*> layerList;
+	graph.GetLayerList( layerList );
+	for( int i = 0; i < layerList.Size(); ++i ) {
+		CBaseLayer* layer = graph.GetLayer( layerList[i] );
+
+		CFullyConnectedLayer* fc = dynamic_cast<CFullyConnectedLayer*>( layer );
+		if( fc != nullptr && fc->Quantize() ) {
+			++result;
+		}
+		CConvLayer* conv = dynamic_cast<CConvLayer*>( layer );
+		if( conv != nullptr && conv->Quantize() ) {
+			++result;
+		}
+		CCompositeLayer* composite = dynamic_cast<CCompositeLayer*>( layer );
+		if( composite != nullptr ) {
+			result += quantize( *composite );
+		}
+	}
+	return result;
+}
+
+} // namespace NeoML
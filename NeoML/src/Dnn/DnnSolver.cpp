@@ -159,10 +159,44 @@ CDnnSolver::CDnnSolver( IMathEngine& _mathEngine ) :
 	learningRate( 0.01f ),
 	regularizationL2( 0.f ),
 	regularizationL1( 0.f ),
-	maxGradientNorm( -1.f )
+	maxGradientNorm( -1.f ),
+	isParamArenaEnabled( false )
 {
 }
 
+void CDnnSolver::EnableParamArena( bool enable )
+{
+	isParamArenaEnabled = enable;
+	if( !enable ) {
+		// The layers keep their views of the arena
+		clearArena();
+	}
+}
+
+// Creates the zero-filled blobs for the layer parameter gradients
+// The first gradients of an arena layer on the training step are calculated right in the arena
+void CDnnSolver::createParamDiffBlobs( CBaseLayer& layer, CObjectArray<CDnnBlob>& paramDiffBlobs )
+{
+	NeoAssert( paramDiffBlobs.IsEmpty() );
+
+	int arenaIndex = NotFound;
+	if( isParamArenaEnabled && layerToArenaIndex.Lookup( &layer, arenaIndex )
+		&& isArenaLayerValid( *arenaLayers[arenaIndex] ) )
+	{
+		const TMapPosition pos = layerToParamDiffBlobsSum.GetFirstPosition( &layer );
+		if( pos == NotFound || layerToParamDiffBlobsSum.GetValue( pos ).Sum.IsEmpty() ) {
+			arenaLayers[arenaIndex]->DiffSpan[0]->Clear();
+			arenaLayers[arenaIndex]->Diffs.CopyTo( paramDiffBlobs );
+			return;
+		}
+	}
+
+	for( int i = 0; i < layer.paramBlobs.Size(); ++i ) {
+		paramDiffBlobs.Add( layer.paramBlobs[i]->GetClone() );
+		paramDiffBlobs[i]->Clear();
+	}
+}
+
 // Calculates the layer parameter gradients to then use them in Train method
 void CDnnSolver::AddDiff( CBaseLayer* layer, const CObjectArray<CDnnBlob>& paramDiffBlobs,
 	bool sharedWeights )
@@ -185,13 +219,91 @@ void CDnnSolver::AddDiff( CBaseLayer* layer, const CObjectArray<CDnnBlob>& param
 	}
 }
 
+// Calculates the sparse layer parameter gradients to then use them in Train method
+void CDnnSolver::AddSparseDiff( CBaseLayer* layer, const CArray<CArray<int>>& rows,
+	const CObjectArray<CDnnBlob>& rowDiffBlobs, bool sharedWeights )
+{
+	NeoAssert( layer != 0 );
+	NeoAssert( rows.Size() == rowDiffBlobs.Size() );
+	NeoAssert( rows.Size() == layer->paramBlobs.Size() );
+
+	CSparseDiffSum& diffSum = layerToSparseDiffSum.GetOrCreateValue( layer );
+
+	if( !sharedWeights ) {
+		++diffSum.Count;
+	}
+
+	if( diffSum.Sum.IsEmpty() ) {
+		diffSum.Rows.SetSize( rows.Size() );
+		diffSum.Sum.SetSize( rows.Size() );
+		for( int i = 0; i < rows.Size(); i++ ) {
+			if( !rows[i].IsEmpty() ) {
+				NeoAssert( rowDiffBlobs[i]->GetObjectCount() == rows[i].Size() );
+				rows[i].CopyTo( diffSum.Rows[i] );
+				diffSum.Sum[i] = rowDiffBlobs[i];
+			}
+		}
+		return;
+	}
+
+	NeoAssert( diffSum.Sum.Size() == rowDiffBlobs.Size() );
+	for( int i = 0; i < rows.Size(); i++ ) {
+		if( rows[i].IsEmpty() ) {
+			continue;
+		}
+		NeoAssert( rowDiffBlobs[i]->GetObjectCount() == rows[i].Size() );
+
+		// Find the positions of the rows in the sum, the new rows are added to the end
+		CArray<int>& sumRows = diffSum.Rows[i];
+		CMap<int, int> rowToPos;
+		for( int j = 0; j < sumRows.Size(); j++ ) {
+			rowToPos.Add( sumRows[j], j );
+		}
+		CArray<int> positions;
+		positions.SetBufferSize( rows[i].Size() );
+		for( int j = 0; j < rows[i].Size(); j++ ) {
+			int pos = NotFound;
+			if( !rowToPos.Lookup( rows[i][j], pos ) ) {
+				pos = sumRows.Size();
+				sumRows.Add( rows[i][j] );
+				rowToPos.Add( rows[i][j], pos );
+			}
+			positions.Add( pos );
+		}
+
+		const int rowSize = layer->paramBlobs[i]->GetObjectSize();
+		if( diffSum.Sum[i] == 0 || diffSum.Sum[i]->GetObjectCount() < sumRows.Size() ) {
+			CPtr<CDnnBlob> newSum = CDnnBlob::CreateDataBlob( mathEngine, CT_Float, 1, sumRows.Size(), rowSize );
+			newSum->Clear();
+			if( diffSum.Sum[i] != 0 ) {
+				mathEngine.VectorCopy( newSum->GetData(), diffSum.Sum[i]->GetData(), diffSum.Sum[i]->GetDataSize() );
+			}
+			diffSum.Sum[i] = newSum;
+		}
+
+		CPtr<CDnnBlob> positionBlob = CDnnBlob::CreateVector( mathEngine, CT_Int, positions.Size() );
+		positionBlob->CopyFrom( positions.GetPtr() );
+		mathEngine.MatrixSpreadRowsAdd( rowDiffBlobs[i]->GetData(), positions.Size(), rowSize,
+			diffSum.Sum[i]->GetData(), sumRows.Size(), positionBlob->GetData<int>() );
+	}
+}
+
 // Modifies the trainable parameters of the network layers, using the accumulated gradient values 
 // and the history of previous modifications (moment, etc.)
 void CDnnSolver::Train()
 {
 	OnTrain();
 
+	convertSparseDiffs( false );
+
+	if( isParamArenaEnabled && !isArenaValid() ) {
+		buildArena();
+	}
+
 	CFloatHandleStackVar oneDivEpoch( mathEngine );
+	// The arena layers that have the gradients on this step
+	CArray<bool> hasArenaDiff;
+	hasArenaDiff.Add( false, arenaLayers.Size() );
 
 	for( TMapPosition pos = layerToParamDiffBlobsSum.GetFirstPosition(); pos != NotFound;
 		pos = layerToParamDiffBlobsSum.GetNextPosition( pos ) )
@@ -203,17 +315,39 @@ void CDnnSolver::Train()
 		}
 		NeoAssert( paramDiffBlobsSum.Count > 0 );
 
+		int arenaIndex = NotFound;
+		if( layerToArenaIndex.Lookup( layer, arenaIndex ) ) {
+			// Usually the gradients are already in the arena (see createParamDiffBlobs)
+			// They are moved there only on the step the arena is built
+			const CArenaLayer& arenaLayer = *arenaLayers[arenaIndex];
+			if( paramDiffBlobsSum.Sum[0].Ptr() != arenaLayer.Diffs[0].Ptr() ) {
+				for( int i = 0; i < paramDiffBlobsSum.Sum.Size(); i++ ) {
+					arenaLayer.Diffs[i]->CopyFrom( paramDiffBlobsSum.Sum[i] );
+				}
+				arenaLayer.Diffs.CopyTo( paramDiffBlobsSum.Sum );
+			}
+		}
+		// The gradients of the arena layer are processed as one vector
+		const CObjectArray<CDnnBlob>& diffBlobs = arenaIndex == NotFound ? paramDiffBlobsSum.Sum
+			: arenaLayers[arenaIndex]->DiffSpan;
+
 		// Take the average of the gradients to simulate that the elements from all runs were in the same batch
 		// TODO: weighted average
 		if( paramDiffBlobsSum.Count > 1 ) {
 			oneDivEpoch.SetValue( 1.f / paramDiffBlobsSum.Count );
-			for( int i = 0; i < paramDiffBlobsSum.Sum.Size(); i++ ) {
-				MathEngine().VectorMultiply( paramDiffBlobsSum.Sum[i]->GetData(), paramDiffBlobsSum.Sum[i]->GetData(),
-					paramDiffBlobsSum.Sum[i]->GetDataSize(), oneDivEpoch );
+			for( int i = 0; i < diffBlobs.Size(); i++ ) {
+				MathEngine().VectorMultiply( diffBlobs[i]->GetData(), diffBlobs[i]->GetData(),
+					diffBlobs[i]->GetDataSize(), oneDivEpoch );
 			}
 		}
 
-		clipGradients( paramDiffBlobsSum.Sum );
+		clipGradients( diffBlobs );
+
+		if( arenaIndex != NotFound ) {
+			// The arena layers are trained after all the gradients are ready
+			hasArenaDiff[arenaIndex] = true;
+			continue;
+		}
 
 		// Train the layer based on the calculated diff data
 		TrainLayer( layer, layer->paramBlobs, paramDiffBlobsSum.Sum, layerToGradientHistory.GetOrCreateValue( layer ) );
@@ -222,15 +356,463 @@ void CDnnSolver::Train()
 		paramDiffBlobsSum.Sum.Empty();
 		paramDiffBlobsSum.Count = 0;
 	}
+
+	if( !arenaLayers.IsEmpty() ) {
+		trainArenaLayers( hasArenaDiff );
+	}
+
+	for( TMapPosition pos = layerToSparseDiffSum.GetFirstPosition(); pos != NotFound;
+		pos = layerToSparseDiffSum.GetNextPosition( pos ) )
+	{
+		CSparseDiffSum& diffSum = layerToSparseDiffSum.GetValue( pos );
+		if( diffSum.Sum.IsEmpty() ) {
+			continue;
+		}
+		NeoAssert( diffSum.Count > 0 );
+
+		CObjectArray<CDnnBlob> diffBlobs;
+		for( int i = 0; i < diffSum.Sum.Size(); i++ ) {
+			if( diffSum.Sum[i] != 0 ) {
+				diffBlobs.Add( diffSum.Sum[i] );
+			}
+		}
+		if( diffSum.Count > 1 ) {
+			oneDivEpoch.SetValue( 1.f / diffSum.Count );
+			for( int i = 0; i < diffBlobs.Size(); i++ ) {
+				MathEngine().VectorMultiply( diffBlobs[i]->GetData(), diffBlobs[i]->GetData(),
+					diffBlobs[i]->GetDataSize(), oneDivEpoch );
+			}
+		}
+		// The norm of the sparse gradient is the norm of its rows
+		clipGradients( diffBlobs );
+
+		trainSparseLayer( layerToSparseDiffSum.GetKey( pos ), diffSum );
+
+		diffSum.Rows.DeleteAll();
+		diffSum.Sum.DeleteAll();
+		diffSum.Count = 0;
+	}
+}
+
+// Converts the sparse gradients into the usual ones
+// If convertAll is false, only the gradients that can't be trained by rows are converted:
+// when the solver doesn't support it or the layer also has the usual gradients
+void CDnnSolver::convertSparseDiffs( bool convertAll )
+{
+	for( TMapPosition pos = layerToSparseDiffSum.GetFirstPosition(); pos != NotFound;
+		pos = layerToSparseDiffSum.GetNextPosition( pos ) )
+	{
+		CBaseLayer* layer = layerToSparseDiffSum.GetKey( pos );
+		CSparseDiffSum& diffSum = layerToSparseDiffSum.GetValue( pos );
+		if( diffSum.Sum.IsEmpty() ) {
+			continue;
+		}
+		const TMapPosition densePos = layerToParamDiffBlobsSum.GetFirstPosition( layer );
+		const bool hasDenseDiff = densePos != NotFound && !layerToParamDiffBlobsSum.GetValue( densePos ).Sum.IsEmpty();
+		if( !convertAll && CanTrainRows() && !hasDenseDiff ) {
+			continue;
+		}
+
+		CDiffBlobSum& denseSum = layerToParamDiffBlobsSum.GetOrCreateValue( layer );
+		if( denseSum.Sum.IsEmpty() ) {
+			for( int i = 0; i < layer->paramBlobs.Size(); i++ ) {
+				denseSum.Sum.Add( layer->paramBlobs[i]->GetClone() );
+				denseSum.Sum[i]->Clear();
+			}
+		}
+		for( int i = 0; i < diffSum.Rows.Size(); i++ ) {
+			const CArray<int>& rows = diffSum.Rows[i];
+			if( rows.IsEmpty() ) {
+				continue;
+			}
+			CPtr<CDnnBlob> rowBlob = CDnnBlob::CreateVector( mathEngine, CT_Int, rows.Size() );
+			rowBlob->CopyFrom( rows.GetPtr() );
+			CDnnBlob* dense = denseSum.Sum[i];
+			mathEngine.MatrixSpreadRowsAdd( diffSum.Sum[i]->GetData(), rows.Size(), dense->GetObjectSize(),
+				dense->GetData(), dense->GetObjectCount(), rowBlob->GetData<int>() );
+		}
+		denseSum.Count += diffSum.Count;
+
+		diffSum.Rows.DeleteAll();
+		diffSum.Sum.DeleteAll();
+		diffSum.Count = 0;
+	}
+}
+
+// Copies the rows of the blob
+static void gatherRows( IMathEngine& mathEngine, const CDnnBlob& rows, const CDnnBlob& blob, CDnnBlob& rowData )
+{
+	const CConstFloatHandle table = blob.GetData();
+	const CLookupDimension dimension( blob.GetObjectCount(), blob.GetObjectSize() );
+	mathEngine.VectorMultichannelLookupAndCopy( rows.GetDataSize(), 1, rows.GetData<int>(),
+		&table, &dimension, 1, rowData.GetData(), blob.GetObjectSize() );
+}
+
+// Adds the changes of the rows to the blob
+static void addRowChanges( IMathEngine& mathEngine, const CDnnBlob& rows, CDnnBlob& newRowData,
+	const CDnnBlob& oldRowData, CDnnBlob& blob )
+{
+	mathEngine.VectorSub( newRowData.GetData(), oldRowData.GetData(), newRowData.GetData(), newRowData.GetDataSize() );
+	mathEngine.MatrixSpreadRowsAdd( newRowData.GetData(), rows.GetDataSize(), blob.GetObjectSize(),
+		blob.GetData(), blob.GetObjectCount(), rows.GetData<int>() );
+}
+
+// Trains only the rows of the layer parameters that have the gradients
+// The rows of the parameters and of the gradient history are gathered into the separate blobs,
+// trained by TrainLayer and then written back
+void CDnnSolver::trainSparseLayer( CBaseLayer* layer, const CSparseDiffSum& diffSum )
+{
+	CObjectArray<CDnnBlob>& history = layerToGradientHistory.GetOrCreateValue( layer );
+	const int paramCount = layer->paramBlobs.Size();
+	NeoAssert( history.Size() % paramCount == 0 );
+	int historyTypeCount = history.Size() / paramCount;
+
+	for( int i = 0; i < paramCount; i++ ) {
+		const CArray<int>& rows = diffSum.Rows[i];
+		if( rows.IsEmpty() ) {
+			continue;
+		}
+		CDnnBlob& param = *layer->paramBlobs[i];
+		const int rowSize = param.GetObjectSize();
+		CPtr<CDnnBlob> rowBlob = CDnnBlob::CreateVector( mathEngine, CT_Int, rows.Size() );
+		rowBlob->CopyFrom( rows.GetPtr() );
+
+		CObjectArray<CDnnBlob> rowParams;
+		rowParams.Add( CDnnBlob::CreateDataBlob( mathEngine, CT_Float, 1, rows.Size(), rowSize ) );
+		gatherRows( mathEngine, *rowBlob, param, *rowParams[0] );
+		CPtr<CDnnBlob> oldRowParams = rowParams[0]->GetCopy();
+
+		CObjectArray<CDnnBlob> rowHistory;
+		CObjectArray<CDnnBlob> oldRowHistory;
+		for( int type = 0; type < historyTypeCount; type++ ) {
+			rowHistory.Add( rowParams[0]->GetClone() );
+			gatherRows( mathEngine, *rowBlob, *history[type * paramCount + i], *rowHistory[type] );
+			oldRowHistory.Add( rowHistory[type]->GetCopy() );
+		}
+
+		CObjectArray<CDnnBlob> rowDiffs;
+		rowDiffs.Add( diffSum.Sum[i] );
+		TrainLayer( layer, rowParams, rowDiffs, rowHistory );
+
+		if( historyTypeCount == 0 ) {
+			// TrainLayer has created the history for the rows, so the history of the whole blobs is zero
+			historyTypeCount = rowHistory.Size();
+			for( int type = 0; type < historyTypeCount; type++ ) {
+				for( int j = 0; j < paramCount; j++ ) {
+					CDnnBlob* blob = layer->paramBlobs[j]->GetClone();
+					blob->Clear();
+					history.Add( blob );
+				}
+				oldRowHistory.Add( rowHistory[type]->GetClone() );
+				oldRowHistory[type]->Clear();
+			}
+		}
+		NeoAssert( rowHistory.Size() == historyTypeCount );
+
+		addRowChanges( mathEngine, *rowBlob, *rowParams[0], *oldRowParams, param );
+		for( int type = 0; type < historyTypeCount; type++ ) {
+			addRowChanges( mathEngine, *rowBlob, *rowHistory[type], *oldRowHistory[type], *history[type * paramCount + i] );
+		}
+	}
 }
 
 void CDnnSolver::Reset()
 {
 	layerToParamDiffBlobsSum.DeleteAll();
+	layerToSparseDiffSum.DeleteAll();
 	layerToGradientHistory.DeleteAll();
+	clearArenaHistory();
 	OnReset();
 }
 
+// Checks if the arena still holds the parameters of all the trained layers
+bool CDnnSolver::isArenaValid() const
+{
+	for( int i = 0; i < arenaLayers.Size(); i++ ) {
+		if( !isArenaLayerValid( *arenaLayers[i] ) ) {
+			return false;
+		}
+	}
+
+	for( TMapPosition pos = layerToParamDiffBlobsSum.GetFirstPosition(); pos != NotFound;
+		pos = layerToParamDiffBlobsSum.GetNextPosition( pos ) )
+	{
+		CBaseLayer* layer = layerToParamDiffBlobsSum.GetKey( pos );
+		if( !layerToParamDiffBlobsSum.GetValue( pos ).Sum.IsEmpty() && !layerToArenaIndex.Has( layer )
+			&& !arenaExcludedLayers.Has( layer ) )
+		{
+			// A new layer is being trained
+			return false;
+		}
+	}
+	return true;
+}
+
+// Checks if the layer still uses the arena views as its parameters
+bool CDnnSolver::isArenaLayerValid( const CArenaLayer& arenaLayer ) const
+{
+	const CObjectArray<CDnnBlob>& paramBlobs = arenaLayer.Layer->paramBlobs;
+	if( paramBlobs.Size() != arenaLayer.Params.Size() ) {
+		return false;
+	}
+	for( int i = 0; i < paramBlobs.Size(); i++ ) {
+		if( paramBlobs[i].Ptr() != arenaLayer.Params[i].Ptr() ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool CDnnSolver::canAddToArena( const CBaseLayer& layer, const CObjectArray<CDnnBlob>& paramDiffBlobs,
+	const CMap<CDnnBlob*, int>& blobUseCount ) const
+{
+	const CObjectArray<CDnnBlob>& paramBlobs = layer.paramBlobs;
+	if( paramBlobs.IsEmpty() || paramBlobs.Size() != paramDiffBlobs.Size() ) {
+		return false;
+	}
+	for( int i = 0; i < paramBlobs.Size(); i++ ) {
+		if( paramBlobs[i] == nullptr || paramBlobs[i]->GetDataType() != CT_Float
+			|| blobUseCount.Get( paramBlobs[i].Ptr() ) != 1
+			|| paramDiffBlobs[i] == nullptr || !paramDiffBlobs[i]->HasEqualDimensions( paramBlobs[i] ) )
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// Packs the parameters of the trained layers into the arena
+// The layers with the same learning settings are placed one after another
+void CDnnSolver::buildArena()
+{
+	clearArena();
+
+	// The parameters shared by several layers are left where they are
+	CMap<CDnnBlob*, int> blobUseCount;
+	for( TMapPosition pos = layerToParamDiffBlobsSum.GetFirstPosition(); pos != NotFound;
+		pos = layerToParamDiffBlobsSum.GetNextPosition( pos ) )
+	{
+		if( layerToParamDiffBlobsSum.GetValue( pos ).Sum.IsEmpty() ) {
+			continue;
+		}
+		const CObjectArray<CDnnBlob>& paramBlobs = layerToParamDiffBlobsSum.GetKey( pos )->paramBlobs;
+		for( int i = 0; i < paramBlobs.Size(); i++ ) {
+			if( paramBlobs[i] != nullptr ) {
+				blobUseCount.GetOrCreateValue( paramBlobs[i].Ptr(), 0 )++;
+			}
+		}
+	}
+
+	CArray<CBaseLayer*> layers;
+	for( TMapPosition pos = layerToParamDiffBlobsSum.GetFirstPosition(); pos != NotFound;
+		pos = layerToParamDiffBlobsSum.GetNextPosition( pos ) )
+	{
+		CBaseLayer* layer = layerToParamDiffBlobsSum.GetKey( pos );
+		const CObjectArray<CDnnBlob>& paramDiffBlobs = layerToParamDiffBlobsSum.GetValue( pos ).Sum;
+		if( paramDiffBlobs.IsEmpty() ) {
+			continue;
+		}
+		if( canAddToArena( *layer, paramDiffBlobs, blobUseCount ) ) {
+			layers.Add( layer );
+		} else {
+			arenaExcludedLayers.Add( layer );
+		}
+	}
+
+	// Split the layers into the groups
+	CArray<bool> isAdded;
+	isAdded.Add( false, layers.Size() );
+	int arenaSize = 0;
+	for( int i = 0; i < layers.Size(); i++ ) {
+		if( isAdded[i] ) {
+			continue;
+		}
+		CArenaGroup* group = FINE_DEBUG_NEW CArenaGroup;
+		group->FirstLayer = arenaLayers.Size();
+		group->LayerCount = 0;
+		group->IsHistoryShared = false;
+		for( int j = i; j < layers.Size(); j++ ) {
+			if( isAdded[j] || layers[j]->GetBaseLearningRate() != layers[i]->GetBaseLearningRate()
+				|| layers[j]->GetBaseL1RegularizationMult() != layers[i]->GetBaseL1RegularizationMult()
+				|| layers[j]->GetBaseL2RegularizationMult() != layers[i]->GetBaseL2RegularizationMult() )
+			{
+				continue;
+			}
+			CArenaLayer* arenaLayer = FINE_DEBUG_NEW CArenaLayer;
+			arenaLayer->Layer = layers[j];
+			arenaLayer->Offset = arenaSize;
+			arenaLayer->Size = 0;
+			for( int k = 0; k < layers[j]->paramBlobs.Size(); k++ ) {
+				arenaLayer->Size += layers[j]->paramBlobs[k]->GetDataSize();
+			}
+			arenaSize += arenaLayer->Size;
+			layerToArenaIndex.Add( layers[j], arenaLayers.Size() );
+			arenaLayers.Add( arenaLayer );
+			group->LayerCount++;
+			isAdded[j] = true;
+		}
+		arenaGroups.Add( group );
+	}
+	if( arenaSize == 0 ) {
+		return;
+	}
+
+	paramArena = CDnnBlob::CreateVector( MathEngine(), CT_Float, arenaSize );
+	paramDiffArena = CDnnBlob::CreateVector( MathEngine(), CT_Float, arenaSize );
+	paramDiffArena->Clear();
+
+	for( int i = 0; i < arenaLayers.Size(); i++ ) {
+		CArenaLayer& arenaLayer = *arenaLayers[i];
+		CObjectArray<CDnnBlob>& paramBlobs = arenaLayer.Layer->paramBlobs;
+		int offset = arenaLayer.Offset;
+		for( int j = 0; j < paramBlobs.Size(); j++ ) {
+			CPtr<CDnnBlob> param = CDnnBlob::CreateViewBlob( paramArena, paramBlobs[j]->GetDesc(), offset );
+			param->CopyFrom( paramBlobs[j] );
+			paramBlobs[j] = param;
+			arenaLayer.Params.Add( param );
+			arenaLayer.Diffs.Add( CDnnBlob::CreateViewBlob( paramDiffArena, paramBlobs[j]->GetDesc(), offset ) );
+			offset += paramBlobs[j]->GetDataSize();
+		}
+		CBlobDesc spanDesc( CT_Float );
+		spanDesc.SetDimSize( BD_Channels, arenaLayer.Size );
+		arenaLayer.DiffSpan.Add( CDnnBlob::CreateViewBlob( paramDiffArena, spanDesc, arenaLayer.Offset ) );
+	}
+
+	for( int i = 0; i < arenaGroups.Size(); i++ ) {
+		CArenaGroup& group = *arenaGroups[i];
+		const CArenaLayer& lastLayer = *arenaLayers[group.FirstLayer + group.LayerCount - 1];
+		const int offset = arenaLayers[group.FirstLayer]->Offset;
+		CBlobDesc spanDesc( CT_Float );
+		spanDesc.SetDimSize( BD_Channels, lastLayer.Offset + lastLayer.Size - offset );
+		group.Params.Add( CDnnBlob::CreateViewBlob( paramArena, spanDesc, offset ) );
+		group.Diffs.Add( CDnnBlob::CreateViewBlob( paramDiffArena, spanDesc, offset ) );
+	}
+}
+
+// The views of the previous arena stay valid, so the layers may keep them
+void CDnnSolver::clearArena()
+{
+	paramArena = nullptr;
+	paramDiffArena = nullptr;
+	arenaLayers.DeleteAll();
+	arenaGroups.DeleteAll();
+	layerToArenaIndex.DeleteAll();
+	arenaExcludedLayers.DeleteAll();
+}
+
+void CDnnSolver::clearArenaHistory()
+{
+	for( int i = 0; i < arenaGroups.Size(); i++ ) {
+		arenaGroups[i]->History.DeleteAll();
+		arenaGroups[i]->IsHistoryShared = false;
+	}
+}
+
+// Trains the arena layers that have the gradients
+// If all layers of a group have the gradients the whole group is trained at once
+void CDnnSolver::trainArenaLayers( const CArray<bool>& hasDiff )
+{
+	for( int i = 0; i < arenaGroups.Size(); i++ ) {
+		CArenaGroup& group = *arenaGroups[i];
+		bool isWholeGroup = CanTrainLayersTogether();
+		for( int j = group.FirstLayer; j < group.FirstLayer + group.LayerCount; j++ ) {
+			isWholeGroup = isWholeGroup && hasDiff[j];
+		}
+
+		if( isWholeGroup ) {
+			if( group.History.IsEmpty() ) {
+				packGroupHistory( group );
+			}
+			TrainLayer( arenaLayers[group.FirstLayer]->Layer, group.Params, group.Diffs, group.History );
+			if( !group.IsHistoryShared ) {
+				shareGroupHistory( group );
+			}
+		} else {
+			for( int j = group.FirstLayer; j < group.FirstLayer + group.LayerCount; j++ ) {
+				if( hasDiff[j] ) {
+					const CArenaLayer& arenaLayer = *arenaLayers[j];
+					TrainLayer( arenaLayer.Layer, arenaLayer.Params, arenaLayer.Diffs,
+						layerToGradientHistory.GetOrCreateValue( arenaLayer.Layer ) );
+				}
+			}
+		}
+	}
+
+	// Clear the diff data
+	for( int i = 0; i < arenaLayers.Size(); i++ ) {
+		if( hasDiff[i] ) {
+			CDiffBlobSum& paramDiffBlobsSum = layerToParamDiffBlobsSum.Get( arenaLayers[i]->Layer );
+			paramDiffBlobsSum.Sum.Empty();
+			paramDiffBlobsSum.Count = 0;
+		}
+	}
+}
+
+// Copies the gradient history of the separately trained group layers into the group history
+void CDnnSolver::packGroupHistory( CArenaGroup& group )
+{
+	NeoAssert( group.History.IsEmpty() );
+
+	int historyTypeCount = 0;
+	for( int i = group.FirstLayer; i < group.FirstLayer + group.LayerCount && historyTypeCount == 0; i++ ) {
+		const TMapPosition pos = layerToGradientHistory.GetFirstPosition( arenaLayers[i]->Layer );
+		if( pos != NotFound ) {
+			historyTypeCount = layerToGradientHistory.GetValue( pos ).Size() / arenaLayers[i]->Params.Size();
+		}
+	}
+	if( historyTypeCount == 0 ) {
+		// The history will be created by the solver
+		return;
+	}
+
+	for( int j = 0; j < historyTypeCount; j++ ) {
+		CPtr<CDnnBlob> blob = group.Diffs[0]->GetClone();
+		blob->Clear();
+		group.History.Add( blob );
+	}
+
+	const int groupOffset = arenaLayers[group.FirstLayer]->Offset;
+	for( int i = group.FirstLayer; i < group.FirstLayer + group.LayerCount; i++ ) {
+		const CArenaLayer& arenaLayer = *arenaLayers[i];
+		const TMapPosition pos = layerToGradientHistory.GetFirstPosition( arenaLayer.Layer );
+		if( pos == NotFound ) {
+			continue;
+		}
+		const CObjectArray<CDnnBlob>& history = layerToGradientHistory.GetValue( pos );
+		if( history.Size() != historyTypeCount * arenaLayer.Params.Size() ) {
+			continue;
+		}
+		for( int j = 0; j < historyTypeCount; j++ ) {
+			int offset = arenaLayer.Offset - groupOffset;
+			for( int k = 0; k < arenaLayer.Params.Size(); k++ ) {
+				const CDnnBlob* blob = history[j * arenaLayer.Params.Size() + k];
+				MathEngine().VectorCopy( group.History[j]->GetData() + offset, blob->GetData(), blob->GetDataSize() );
+				offset += blob->GetDataSize();
+			}
+		}
+	}
+}
+
+// Replaces the gradient history of the group layers with the views of the group history
+// so that the layers may be trained separately and the history is serialized per layer
+void CDnnSolver::shareGroupHistory( CArenaGroup& group )
+{
+	const int groupOffset = arenaLayers[group.FirstLayer]->Offset;
+	for( int i = group.FirstLayer; i < group.FirstLayer + group.LayerCount; i++ ) {
+		const CArenaLayer& arenaLayer = *arenaLayers[i];
+		CObjectArray<CDnnBlob>& history = layerToGradientHistory.GetOrCreateValue( arenaLayer.Layer );
+		history.DeleteAll();
+		for( int j = 0; j < group.History.Size(); j++ ) {
+			int offset = arenaLayer.Offset - groupOffset;
+			for( int k = 0; k < arenaLayer.Params.Size(); k++ ) {
+				history.Add( CDnnBlob::CreateViewBlob( group.History[j], arenaLayer.Params[k]->GetDesc(), offset ) );
+				offset += arenaLayer.Params[k]->GetDataSize();
+			}
+		}
+	}
+	group.IsHistoryShared = true;
+}
+
 void CDnnSolver::clipGradients(const CObjectArray<CDnnBlob>& paramDiffBlobs)
 {
 	if(maxGradientNorm < 0 || paramDiffBlobs.Size() == 0) {
@@ -261,11 +843,11 @@ void CDnnSolver::clipGradients(const CObjectArray<CDnnBlob>& paramDiffBlobs)
 	}
 }
 
-static const int DnnSolverVersion = 0;
+static const int DnnSolverVersion = 2;
 
 void CDnnSolver::Serialize( CArchive& archive, CDnn& dnn )
 {
-	archive.SerializeVersion( DnnSolverVersion );
+	const int version = archive.SerializeVersion( DnnSolverVersion );
 	if( archive.IsStoring() ) {
 		CMap<CBaseLayer*, CString> layerPtrToId;
 		mapLayerPtrToId( dnn, layerPtrToId );
@@ -287,12 +869,30 @@ void CDnnSolver::Serialize( CArchive& archive, CDnn& dnn )
 			SerializeBlobs( mathEngine, archive, layerToGradientHistory.GetValue( pos ) );
 		}
 		archive << learningRate << regularizationL1 << regularizationL2 << maxGradientNorm;
+		archive << isParamArenaEnabled;
+
+		archive << layerToSparseDiffSum.Size();
+		for( int pos = layerToSparseDiffSum.GetFirstPosition(); pos != NotFound;
+			pos = layerToSparseDiffSum.GetNextPosition( pos ) )
+		{
+			CSparseDiffSum& diffSum = layerToSparseDiffSum.GetValue( pos );
+			archive << layerPtrToId[layerToSparseDiffSum.GetKey( pos )];
+			archive << diffSum.Count;
+			archive << diffSum.Rows.Size();
+			for( int i = 0; i < diffSum.Rows.Size(); i++ ) {
+				diffSum.Rows[i].Serialize( archive );
+			}
+			SerializeBlobs( mathEngine, archive, diffSum.Sum );
+		}
 	} else {
 		CMap<CString, CBaseLayer*> layerIdToPtr;
 		mapLayerIdToPtr( dnn, layerIdToPtr );
 
 		layerToParamDiffBlobsSum.DeleteAll();
+		layerToSparseDiffSum.DeleteAll();
 		layerToGradientHistory.DeleteAll();
+		// The arena will be rebuilt on the next training step
+		clearArena();
 
 		int size;
 		archive >> size;
@@ -311,6 +911,26 @@ void CDnnSolver::Serialize( CArchive& archive, CDnn& dnn )
 			SerializeBlobs( mathEngine, archive, layerToGradientHistory.GetOrCreateValue( layerIdToPtr[layerId] ) );
 		}
 		archive >> learningRate >> regularizationL1 >> regularizationL2 >> maxGradientNorm;
+		isParamArenaEnabled = false;
+		if( version >= 1 ) {
+			archive >> isParamArenaEnabled;
+		}
+		if( version >= 2 ) {
+			archive >> size;
+			for( int i = 0; i < size; ++i ) {
+				CString layerId;
+				archive >> layerId;
+				CSparseDiffSum& diffSum = layerToSparseDiffSum.GetOrCreateValue( layerIdToPtr[layerId] );
+				archive >> diffSum.Count;
+				int paramCount = 0;
+				archive >> paramCount;
+				diffSum.Rows.SetSize( paramCount );
+				for( int j = 0; j < paramCount; j++ ) {
+					diffSum.Rows[j].Serialize( archive );
+				}
+				SerializeBlobs( mathEngine, archive, diffSum.Sum );
+			}
+		}
 	}
 }
 
@@ -465,6 +1085,27 @@ void CDnnAdaptiveGradientSolver::TrainLayer( const CBaseLayer* layer, const CObj
 	float regL1 = layer->GetBaseL1RegularizationMult() * GetL1Regularization();
 	float regL2 = layer->GetBaseL2RegularizationMult() * GetL2Regularization();
 
+	if( MathEngine().GetType() == MET_Cpu ) {
+		// The fused step passes over the parameters and the gradient history only once
+		CAdamStepParams params;
+		params.Rate = rate;
+		params.MomentDecayRate = momentDecayRate;
+		params.SecondMomentDecayRate = secondMomentDecayRate;
+		params.Epsilon = epsilon;
+		params.L1Regularization = regL1;
+		params.L2Regularization = regL2;
+		for( int i = 0; i < paramBlobs.Size(); ++i ) {
+			CFloatHandle secondMomentMax;
+			if( IsAmsGradEnabled() ) {
+				secondMomentMax = gradientHistory[i + paramDiffBlobs.Size() * GHT_SecondMomentMaxAverage]->GetData();
+			}
+			MathEngine().AdamStep( params, paramBlobs[i]->GetDataSize(), paramDiffBlobs[i]->GetData(),
+				paramBlobs[i]->GetData(), gradientHistory[i]->GetData(),
+				gradientHistory[i + paramDiffBlobs.Size() * GHT_SecondMomentAverage]->GetData(), secondMomentMax );
+		}
+		return;
+	}
+
 	// Set the values of the variables
 	CFastArray<float, TV_Count> varValues;
 	varValues.SetSize( TV_Count );
@@ -614,6 +1255,30 @@ void CDnnNesterovGradientSolver::TrainLayer( const CBaseLayer* layer, const CObj
 	float regL1 = layer->GetBaseL1RegularizationMult() * GetL1Regularization();
 	float regL2 = layer->GetBaseL2RegularizationMult() * GetL2Regularization();
 
+	if( MathEngine().GetType() == MET_Cpu ) {
+		// The fused step passes over the parameters and the gradient history only once
+		CAdamStepParams params;
+		params.Rate = rate;
+		params.MomentDecayRate = momentDecayRate;
+		params.SecondMomentDecayRate = secondMomentDecayRate;
+		params.Epsilon = epsilon;
+		params.L1Regularization = regL1;
+		params.L2Regularization = regL2;
+		params.GradientMult = ( 1.f - muT ) / ( 1.f - productMuT );
+		params.MomentMult = muTPlusOne / ( 1.f - productMuT * muTPlusOne );
+		params.SecondMomentMult = 1 / ( 1 - secondMomentDecayRateN );
+		for( int i = 0; i < paramBlobs.Size(); ++i ) {
+			CFloatHandle secondMomentMax;
+			if( IsAmsGradEnabled() ) {
+				secondMomentMax = gradientHistory[i + paramDiffBlobs.Size() * GHT_SecondMomentMaxAverage]->GetData();
+			}
+			MathEngine().AdamStep( params, paramBlobs[i]->GetDataSize(), paramDiffBlobs[i]->GetData(),
+				paramBlobs[i]->GetData(), gradientHistory[i]->GetData(),
+				gradientHistory[i + paramDiffBlobs.Size() * GHT_SecondMomentAverage]->GetData(), secondMomentMax );
+		}
+		return;
+	}
+
 	// Set the values for the variables
 	CFastArray<float, TV_Count> varValues;
 	varValues.SetSize( TV_Count );
@@ -663,22 +1328,23 @@ void CDnnNesterovGradientSolver::TrainLayer( const CBaseLayer* layer, const CObj
 			tempVariables->GetData( {TV_MomentDecayRateVar}) );
 		MathEngine().VectorMultiplyAndAdd( moment->GetData(), paramDiffBlob->GetData(),
 			moment->GetData(), dataSize, tempVariables->GetData( {TV_OpMomentDecayRateVar} ) );
-		// Calculate the historical average squared gradient
-		MathEngine().VectorEltwiseMultiply( paramDiffBlob->GetData(), paramDiffBlob->GetData(),
-			temporaryBlob->GetData(), dataSize );
-		MathEngine().VectorMultiply( secondMoment->GetData(), secondMoment->GetData(), dataSize,
-			tempVariables->GetData( {TV_SecondMomentDecayRateVar} ) );
-		MathEngine().VectorMultiplyAndAdd( secondMoment->GetData(), temporaryBlob->GetData(),
-			secondMoment->GetData(), dataSize, tempVariables->GetData( {TV_OpSecondMomentDecayRateVar} ) );
 
 		// Calculate the auxiliary variables (notations taken from the reference paper)
-		// m with a dash
+		// m with a dash; calculated before temporaryBlob with the regularized gradient is overwritten
 		CFloatHandle mBar = mBarBlob->GetData();
 		MathEngine().VectorMultiply( paramDiffBlob->GetData(), mBar, dataSize,
 			tempVariables->GetData( {TV_MBarGradMultVar} ) );
 		MathEngine().VectorMultiplyAndAdd( mBar, moment->GetData(), mBar, dataSize,
 			tempVariables->GetData( {TV_MBarMomentMultVar} ) );
 
+		// Calculate the historical average squared gradient
+		MathEngine().VectorEltwiseMultiply( paramDiffBlob->GetData(), paramDiffBlob->GetData(),
+			temporaryBlob->GetData(), dataSize );
+		MathEngine().VectorMultiply( secondMoment->GetData(), secondMoment->GetData(), dataSize,
+			tempVariables->GetData( {TV_SecondMomentDecayRateVar} ) );
+		MathEngine().VectorMultiplyAndAdd( secondMoment->GetData(), temporaryBlob->GetData(),
+			secondMoment->GetData(), dataSize, tempVariables->GetData( {TV_OpSecondMomentDecayRateVar} ) );
+
 		// sqrt(n with a hat) + eps
 		if( IsAmsGradEnabled() ) {
 			// Update the maximum average
@@ -809,6 +1475,8 @@ void CDnnLambGradientSolver::TrainLayer( const CBaseLayer* layer, const CObjectA
 	// Getting parameters affected by weight decay
 	CHashTable<int> weightDecayParamIndexes;
 	getWeightDecayIndices( *layer, paramBlobs.Size(), weightDecayParamIndexes );
+	// The squared norms of the gradient, the weights and the update calculated by the fused update
+	CFloatHandleStackVar squaredNorms( MathEngine(), 3 );
 
 	for( int i = 0; i < paramBlobs.Size(); ++i ) {
 		int dataSize = paramBlobs[i]->GetDataSize();
@@ -821,6 +1489,26 @@ void CDnnLambGradientSolver::TrainLayer( const CBaseLayer* layer, const CObjectA
 
 		CPtr<CDnnBlob> paramDiffBlob = paramDiffBlobs[i];
 
+		if( MathEngine().GetType() == MET_Cpu ) {
+			// The fused update passes over the data once and calculates all the norms along the way
+			const float weightDecay = weightDecayParamIndexes.Has( i ) && layerWeighDecay > 0 ? layerWeighDecay : 0.f;
+			MathEngine().LambUpdate( dataSize, useNvLamb ? clipMultiplier : 1.f, momentDecayRate, secondMomentDecayRate,
+				epsilon, weightDecay, paramDiffBlob->GetData(), paramBlobs[i]->GetData(), moment->GetData(),
+				secondMoment->GetData(), tempBlob->GetData(), squaredNorms.GetHandle() );
+			float norms[3];
+			MathEngine().DataExchangeTyped<float>( norms, squaredNorms.GetHandle(), 3 );
+
+			if( useNvLamb ) {
+				const float invSquareClipMultiplier = 1.0f / ( clipMultiplier * clipMultiplier );
+				layersGradientNormSquare.Add( invSquareClipMultiplier * norms[0] );
+			}
+			const float multiplier = useTrustRatio ? calcNormalizeMultiplier( sqrtf( norms[1] ), sqrtf( norms[2] ) ) : 1.f;
+			tempVariables->GetData( { TV_TrustRatioVar } ).SetValue( -rate * multiplier );
+			MathEngine().VectorMultiplyAndAdd( paramBlobs[i]->GetData(), tempBlob->GetData(),
+				paramBlobs[i]->GetData(), dataSize, tempVariables->GetData( { TV_TrustRatioVar } ) );
+			continue;
+		}
+
 		if( useNvLamb ) {
 			MathEngine().VectorMultiply( paramDiffBlob->GetData(), paramDiffBlob->GetData(), dataSize,
 				tempVariables->GetData( { TV_ClipMultiplierVar } ) );
@@ -935,20 +1623,21 @@ void CDnnLambGradientSolver::getWeightDecayIndices( const CBaseLayer& layer, int
 void CDnnLambGradientSolver::calcNormalizeMultiplier( const CDnnBlob& weights, const CDnnBlob& update,
 	const CFloatHandle& multiplierVar ) const
 {
-	float weightNorm = calcL2Norm( weights.GetData(), weights.GetDataSize() );
+	const float weightNorm = calcL2Norm( weights.GetData(), weights.GetDataSize() );
+	const float updateNorm = calcL2Norm( update.GetData(), update.GetDataSize() );
+	multiplierVar.SetValue( calcNormalizeMultiplier( weightNorm, updateNorm ) );
+}
+
+float CDnnLambGradientSolver::calcNormalizeMultiplier( float weightNorm, float updateNorm ) const
+{
 	if( weightDecayClip > 0 ) {
 		weightNorm = min( weightNorm, weightDecayClip );
 	}
 
-	const float updateNorm = calcL2Norm( update.GetData(), update.GetDataSize() );
-
-	float multiplier = 0;
 	if( weightNorm > 0 && updateNorm > 0 ) {
-		multiplier = weightNorm / updateNorm;
-	} else {
-		multiplier = 1.0f;
+		return weightNorm / updateNorm;
 	}
-	multiplierVar.SetValue( multiplier );
+	return 1.0f;
 }
 
 void CDnnLambGradientSolver::OnTrain()
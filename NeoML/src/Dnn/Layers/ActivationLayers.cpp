@@ -57,6 +57,51 @@ CPtr<CBaseLayer> CreateActivationLayer( IMathEngine& mathEngine, TActivationFunc
 	return 0;
 }
 
+static const int ActivationDescVersion = 0;
+
+void CActivationDesc::Serialize( CArchive& archive )
+{
+	archive.SerializeVersion( ActivationDescVersion );
+	archive.SerializeEnum( Type );
+	archive.Serialize( Param1 );
+	archive.Serialize( Param2 );
+}
+
+bool GetActivationDesc( const CBaseLayer& layer, CActivationDesc& desc )
+{
+	static_assert( AF_Count == 12, "AF_Count != 12" );
+	if( dynamic_cast<const CLinearLayer*>( &layer ) != nullptr ) {
+		const CLinearLayer* linear = dynamic_cast<const CLinearLayer*>( &layer );
+		desc = CActivationDesc( AF_Linear, linear->GetMultiplier(), linear->GetFreeTerm() );
+	} else if( dynamic_cast<const CELULayer*>( &layer ) != nullptr ) {
+		desc = CActivationDesc( AF_ELU, dynamic_cast<const CELULayer*>( &layer )->GetAlpha() );
+	} else if( dynamic_cast<const CReLULayer*>( &layer ) != nullptr ) {
+		desc = CActivationDesc( AF_ReLU, dynamic_cast<const CReLULayer*>( &layer )->GetUpperThreshold() );
+	} else if( dynamic_cast<const CLeakyReLULayer*>( &layer ) != nullptr ) {
+		desc = CActivationDesc( AF_LeakyReLU, dynamic_cast<const CLeakyReLULayer*>( &layer )->GetAlpha() );
+	} else if( dynamic_cast<const CAbsLayer*>( &layer ) != nullptr ) {
+		desc = CActivationDesc( AF_Abs );
+	} else if( dynamic_cast<const CSigmoidLayer*>( &layer ) != nullptr ) {
+		desc = CActivationDesc( AF_Sigmoid );
+	} else if( dynamic_cast<const CTanhLayer*>( &layer ) != nullptr ) {
+		desc = CActivationDesc( AF_Tanh );
+	} else if( dynamic_cast<const CHardTanhLayer*>( &layer ) != nullptr ) {
+		desc = CActivationDesc( AF_HardTanh );
+	} else if( dynamic_cast<const CHardSigmoidLayer*>( &layer ) != nullptr ) {
+		const CHardSigmoidLayer* hardSigmoid = dynamic_cast<const CHardSigmoidLayer*>( &layer );
+		desc = CActivationDesc( AF_HardSigmoid, hardSigmoid->GetSlope(), hardSigmoid->GetBias() );
+	} else if( dynamic_cast<const CPowerLayer*>( &layer ) != nullptr ) {
+		desc = CActivationDesc( AF_Power, dynamic_cast<const CPowerLayer*>( &layer )->GetExponent() );
+	} else if( dynamic_cast<const CHSwishLayer*>( &layer ) != nullptr ) {
+		desc = CActivationDesc( AF_HSwish );
+	} else if( dynamic_cast<const CGELULayer*>( &layer ) != nullptr ) {
+		desc = CActivationDesc( AF_GELU );
+	} else {
+		return false;
+	}
+	return true;
+}
+
 ///////////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////////
 CLinearLayer::CLinearLayer( IMathEngine& mathEngine ) :
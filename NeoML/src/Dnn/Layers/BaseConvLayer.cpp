@@ -115,6 +115,7 @@ void CBaseConvLayer::SetFilterData(const CPtr<CDnnBlob>& newFilter)
 	} else {
 		Filter() = newFilter->GetCopy();
 	}
+	OnFilterChanged();
 }
 
 CPtr<CDnnBlob> CBaseConvLayer::GetFreeTermData() const
@@ -184,6 +185,7 @@ void CBaseConvLayer::FilterLayerParams( float threshold )
 				paramBlobs[blobIndex]->GetDataSize(), threshold );
 		}
 	}
+	OnFilterChanged();
 }
 
 static const int BaseConvLayerVersion = 2000;
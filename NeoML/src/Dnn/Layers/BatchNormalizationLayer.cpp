@@ -446,6 +446,18 @@ void CBatchNormalizationLayer::LearnOnce()
 	isFinalParamDirty = true;
 }
 
+void CBatchNormalizationLayer::ShareParamBlobs( const CBaseLayer& source )
+{
+	CBaseLayer::ShareParamBlobs( source );
+
+	const CBatchNormalizationLayer* sourceLayer = CheckCast<CBatchNormalizationLayer>( &source );
+	// The final parameters of the source layer must be up to date
+	NeoAssert( !sourceLayer->isFinalParamDirty );
+	finalParams = sourceLayer->finalParams;
+	internalParams = sourceLayer->internalParams;
+	isFinalParamDirty = false;
+}
+
 void CBatchNormalizationLayer::SetFinalParams(const CPtr<CDnnBlob>& _params)
 {
 	if(finalParams != 0) {
@@ -398,6 +398,16 @@ void CCompositeLayer::FilterLayerParams( float threshold )
 	}
 }
 
+void CCompositeLayer::ShareParamBlobs( const CBaseLayer& source )
+{
+	CBaseLayer::ShareParamBlobs( source );
+
+	const CCompositeLayer* sourceLayer = CheckCast<CCompositeLayer>( &source );
+	for( int i = 0; i < layers.Size(); ++i ) {
+		layers[i]->ShareParamBlobs( *sourceLayer->GetLayer( layers[i]->GetName() ) );
+	}
+}
+
 void CCompositeLayer::SetInternalDnnParams()
 {
 	NeoAssert(internalDnn != 0);
@@ -23,7 +23,8 @@ namespace NeoML {
 
 CConvLayer::CConvLayer( IMathEngine& mathEngine ) :
 	CBaseConvLayer( mathEngine, "CCnnConvLayer" ),
-	convDesc( 0 )
+	convDesc( 0 ),
+	quantizedWeights( mathEngine )
 {
 }
 
@@ -37,7 +38,8 @@ void CConvLayer::initConvDesc()
 	if( convDesc == 0 ) {
 		convDesc = MathEngine().InitBlobConvolution( inputBlobs[0]->GetDesc(),
 			paddingHeight, paddingWidth, strideHeight, strideWidth, dilationHeight, dilationWidth,
-			Filter()->GetDesc(), outputBlobs[0]->GetDesc() );
+			quantizedWeights.IsQuantized() ? quantizedWeights.GetWeightsDesc() : Filter()->GetDesc(),
+			outputBlobs[0]->GetDesc() );
 	}
 }
 void CConvLayer::destroyConvDesc()
@@ -66,6 +68,8 @@ void CConvLayer::Reshape()
 		GetName(), "different number of inputs and outputs in conv layer" );
 	CheckArchitecture( paddingHeight < filterHeight * dilationHeight && paddingWidth < filterWidth * dilationWidth,
 		GetName(), "padding is more or equal to receptive field size" );
+	CheckArchitecture( activation.IsIdentity() || ( !IsBackwardPerformed() && !IsLearningPerformed() ),
+		GetName(), "layer with activation can be used only for inference" );
 
 	int outputHeight, outputWidth;
 	calcOutputBlobSize(outputHeight, outputWidth);
@@ -74,7 +78,16 @@ void CConvLayer::Reshape()
 			&& filterWidth <= inputDescs[i].Width() + 2 * paddingWidth,
 			GetName(), "filter is bigger than input" );
 
-		if(Filter() == 0) {
+		if( quantizedWeights.IsQuantized() ) {
+			CheckArchitecture( !IsBackwardPerformed() && !IsLearningPerformed(),
+				GetName(), "quantized layer can be used only for inference" );
+			const CBlobDesc& filterDesc = quantizedWeights.GetWeightsDesc();
+			NeoAssert(filterDesc.ObjectCount() == filterCount);
+			NeoAssert(filterDesc.Height() == filterHeight);
+			NeoAssert(filterDesc.Width() == filterWidth);
+			NeoAssert(filterDesc.Depth() == inputDescs[i].Depth());
+			NeoAssert(filterDesc.Channels() == inputDescs[i].Channels());
+		} else if(Filter() == 0) {
 			// Create a weights matrix
 			Filter() = CDnnBlob::Create3DImageBlob( MathEngine(), CT_Float, 1, filterCount, filterHeight, filterWidth,
 				inputDescs[i].Depth(), inputDescs[i].Channels() );
@@ -113,9 +126,20 @@ void CConvLayer::RunOnce()
 	initConvDesc();
 
 	for( int i = 0; i < outputBlobs.Size(); ++i ) {
-		CFloatHandle freeTerm = FreeTerms()->GetData();
-		MathEngine().BlobConvolution( *convDesc, inputBlobs[i]->GetData(),
-			Filter()->GetData(), &freeTerm, outputBlobs[i]->GetData() );
+		if( quantizedWeights.IsCalibrating() ) {
+			quantizedWeights.UpdateInputRange( *inputBlobs[i] );
+		}
+
+		if( quantizedWeights.IsQuantized() ) {
+			CConstFloatHandle freeTerm = FreeTerms()->GetData();
+			MathEngine().BlobQuantizedConvolution( *convDesc, inputBlobs[i]->GetData(),
+				quantizedWeights.GetInputScale(), quantizedWeights.GetInputZeroPoint(), quantizedWeights.GetData(),
+				quantizedWeights.GetScales(), &freeTerm, activation, outputBlobs[i]->GetData() );
+		} else {
+			CFloatHandle freeTerm = FreeTerms()->GetData();
+			MathEngine().BlobConvolution( *convDesc, inputBlobs[i]->GetData(),
+				Filter()->GetData(), &freeTerm, activation, outputBlobs[i]->GetData() );
+		}
 	}
 }
 
@@ -138,14 +162,87 @@ void CConvLayer::LearnOnce()
 		MathEngine().BlobConvolutionLearnAdd( *convDesc, inputBlobs[i]->GetData(), outputDiffBlobs[i]->GetData(),
 			FilterDiff()->GetData(), IsZeroFreeTerm() ? 0 : &freeTermDiff, false );
 	}
+	// The solver changes the filter after the learning step
+	OnFilterChanged();
+}
+
+void CConvLayer::OnFilterChanged()
+{
+	if( convDesc != 0 ) {
+		convDesc->ResetFilterCache();
+	}
 }
 
-static const int ConvLayerVersion = 2000;
+void CConvLayer::ShareParamBlobs( const CBaseLayer& source )
+{
+	CBaseConvLayer::ShareParamBlobs( source );
+	quantizedWeights.Share( CheckCast<CConvLayer>( &source )->quantizedWeights );
+	destroyConvDesc();
+}
+
+CPtr<CDnnBlob> CConvLayer::GetFilterData() const
+{
+	if( quantizedWeights.IsQuantized() ) {
+		return quantizedWeights.Dequantize();
+	}
+	return CBaseConvLayer::GetFilterData();
+}
+
+void CConvLayer::SetFilterData( const CPtr<CDnnBlob>& newFilter )
+{
+	if( quantizedWeights.IsQuantized() ) {
+		quantizedWeights.Reset();
+		destroyConvDesc();
+	}
+	CBaseConvLayer::SetFilterData( newFilter );
+}
+
+void CConvLayer::SetActivation( const CActivationDesc& desc )
+{
+	activation = desc;
+	ForceReshape();
+}
+
+bool CConvLayer::Quantize()
+{
+	if( quantizedWeights.IsQuantized() ) {
+		return true;
+	}
+	if( !quantizedWeights.HasInputRange() || Filter() == 0 ) {
+		return false;
+	}
+
+	quantizedWeights.Quantize( *Filter() );
+	// The float filter is no longer needed
+	Filter() = 0;
+	return true;
+}
+
+static const int ConvLayerVersion = 2002;
 
 void CConvLayer::Serialize( CArchive& archive )
 {
-	archive.SerializeVersion( ConvLayerVersion, CDnn::ArchiveMinSupportedVersion );
+	const int version = archive.SerializeVersion( ConvLayerVersion, CDnn::ArchiveMinSupportedVersion );
 	CBaseConvLayer::Serialize( archive );
+
+	if( version >= 2001 ) {
+		// The quantized filter
+		bool isQuantized = quantizedWeights.IsQuantized();
+		archive.Serialize( isQuantized );
+		if( isQuantized ) {
+			quantizedWeights.Serialize( archive );
+		} else if( archive.IsLoading() ) {
+			quantizedWeights.Reset();
+		}
+	} else if( archive.IsLoading() ) {
+		quantizedWeights.Reset();
+	}
+
+	if( version >= 2002 ) {
+		activation.Serialize( archive );
+	} else if( archive.IsLoading() ) {
+		activation = CActivationDesc();
+	}
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////
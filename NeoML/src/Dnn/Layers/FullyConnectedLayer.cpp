@@ -24,7 +24,8 @@ namespace NeoML {
 CFullyConnectedLayer::CFullyConnectedLayer( IMathEngine& mathEngine, const char* name ) :
 	CBaseLayer( mathEngine, name == nullptr ? "CCnnFullyConnectedLayer" : name, true ),
 	numberOfElements(0),
-	isZeroFreeTerm(false)
+	isZeroFreeTerm(false),
+	quantizedWeights( mathEngine )
 {
 	paramBlobs.SetSize(2);
 }
@@ -38,8 +39,15 @@ void CFullyConnectedLayer::Reshape()
 	CheckInputs();
 	CheckArchitecture( GetInputCount() == GetOutputCount(),
 		GetName(), "fully connected layer with different numbers of input and output" );
+	CheckArchitecture( activation.IsIdentity() || ( !IsBackwardPerformed() && !IsLearningPerformed() ),
+		GetName(), "layer with activation can be used only for inference" );
 	for(int i = 0; i < GetInputCount(); i++) {
-		if(Weights() == 0) {
+		if( quantizedWeights.IsQuantized() ) {
+			CheckArchitecture( !IsBackwardPerformed() && !IsLearningPerformed(),
+				GetName(), "quantized layer can be used only for inference" );
+			CheckArchitecture( quantizedWeights.GetWeightsDesc().ObjectSize() == inputDescs[i].ObjectSize(),
+				GetName(), "weights size mismatch" );
+		} else if(Weights() == 0) {
 			// Create a weights matrix
 			CBlobDesc weightsDesc = inputDescs[i];
 			weightsDesc.SetDimSize(BD_BatchLength, 1);
@@ -78,16 +86,26 @@ void CFullyConnectedLayer::RunOnce()
 	for( int i = 0; i < GetInputCount(); i++ ) {
 		CConstFloatHandle inputData = inputBlobs[i]->GetData();
 		CFloatHandle outputData = outputBlobs[i]->GetData();
-		CConstFloatHandle weightData = Weights()->GetData();
 
-		MathEngine().MultiplyMatrixByTransposedMatrix(inputData, inputBlobs[i]->GetObjectCount(),
-			inputBlobs[i]->GetObjectSize(), inputBlobs[i]->GetObjectSize(),
-			weightData, numberOfElements, Weights()->GetObjectSize(),
-			outputData, outputBlobs[i]->GetObjectSize(), outputBlobs[i]->GetObjectSize() * inputBlobs[i]->GetObjectCount());
+		if( quantizedWeights.IsCalibrating() ) {
+			quantizedWeights.UpdateInputRange( *inputBlobs[i] );
+		}
 
-		if( !isZeroFreeTerm ) {
-			MathEngine().AddVectorToMatrixRows(1, outputData, outputData, inputBlobs[i]->GetObjectCount(),
-				outputBlobs[i]->GetObjectSize(), FreeTerms()->GetData());
+		// The free term and the activation are applied by the multiplication kernel
+		CConstFloatHandle freeTerm = FreeTerms()->GetData();
+		const CConstFloatHandle* freeTermPtr = isZeroFreeTerm ? nullptr : &freeTerm;
+
+		if( quantizedWeights.IsQuantized() ) {
+			MathEngine().MultiplyMatrixByTransposedQuantizedMatrix( inputData, inputBlobs[i]->GetObjectCount(),
+				inputBlobs[i]->GetObjectSize(), quantizedWeights.GetInputScale(), quantizedWeights.GetInputZeroPoint(),
+				quantizedWeights.GetData(), quantizedWeights.GetScales(), numberOfElements, freeTermPtr, activation,
+				outputData );
+		} else {
+			CConstFloatHandle weightData = Weights()->GetData();
+			MathEngine().MultiplyMatrixByTransposedMatrix(inputData, inputBlobs[i]->GetObjectCount(),
+				inputBlobs[i]->GetObjectSize(), inputBlobs[i]->GetObjectSize(),
+				weightData, numberOfElements, Weights()->GetObjectSize(), freeTermPtr, activation,
+				outputData, outputBlobs[i]->GetObjectSize(), outputBlobs[i]->GetObjectSize() * inputBlobs[i]->GetObjectCount());
 		}
 	}
 }
@@ -126,6 +144,12 @@ void CFullyConnectedLayer::FilterLayerParams( float threshold )
 	}
 }
 
+void CFullyConnectedLayer::ShareParamBlobs( const CBaseLayer& source )
+{
+	CBaseLayer::ShareParamBlobs( source );
+	quantizedWeights.Share( CheckCast<CFullyConnectedLayer>( &source )->quantizedWeights );
+}
+
 void CFullyConnectedLayer::SetNumberOfElements(int newNumberOfElements)
 {
 	NeoAssert( ( Weights() == 0 && FreeTerms() == 0 ) || numberOfElements == newNumberOfElements );
@@ -134,6 +158,9 @@ void CFullyConnectedLayer::SetNumberOfElements(int newNumberOfElements)
 
 CPtr<CDnnBlob> CFullyConnectedLayer::GetWeightsData() const
 {
+	if( quantizedWeights.IsQuantized() ) {
+		return quantizedWeights.Dequantize();
+	}
 	if(Weights() == 0) {
 		return 0;
 	}
@@ -143,6 +170,7 @@ CPtr<CDnnBlob> CFullyConnectedLayer::GetWeightsData() const
 
 void CFullyConnectedLayer::SetWeightsData(const CDnnBlob* newWeights)
 {
+	quantizedWeights.Reset();
 	if(newWeights == 0) {
 		NeoAssert(Weights() == 0 || GetDnn() == 0);
 		Weights() = 0;
@@ -193,8 +221,30 @@ void CFullyConnectedLayer::SetZeroFreeTerm(bool _isZeroFreeTerm)
 	isZeroFreeTerm = _isZeroFreeTerm;
 }
 
+void CFullyConnectedLayer::SetActivation( const CActivationDesc& desc )
+{
+	activation = desc;
+	ForceReshape();
+}
+
+bool CFullyConnectedLayer::Quantize()
+{
+	if( quantizedWeights.IsQuantized() ) {
+		return true;
+	}
+	if( !quantizedWeights.HasInputRange() || Weights() == 0 ) {
+		return false;
+	}
+
+	quantizedWeights.Quantize( *Weights() );
+	// The float weights are no longer needed
+	Weights() = 0;
+	return true;
+}
+
 void CFullyConnectedLayer::ApplyBatchNormalization(CBatchNormalizationLayer& batchNorm)
 {
+	NeoAssert( !quantizedWeights.IsQuantized() );
 	CPtr<CDnnBlob> params = batchNorm.GetFinalParams();
 	if(params.Ptr() == 0 || Weights().Ptr() == 0) {
 		return;
@@ -214,16 +264,35 @@ void CFullyConnectedLayer::ApplyBatchNormalization(CBatchNormalizationLayer& bat
 	}
 }
 
-static const int FullyConnectedLayerVersion = 2000;
+static const int FullyConnectedLayerVersion = 2002;
 
 void CFullyConnectedLayer::Serialize( CArchive& archive )
 {
-	archive.SerializeVersion( FullyConnectedLayerVersion, CDnn::ArchiveMinSupportedVersion );
+	const int version = archive.SerializeVersion( FullyConnectedLayerVersion, CDnn::ArchiveMinSupportedVersion );
 	CBaseLayer::Serialize( archive );
 
 	archive.Serialize( numberOfElements );
 	archive.Serialize( isZeroFreeTerm );
 
+	if( version >= 2001 ) {
+		// The quantized weights
+		bool isQuantized = quantizedWeights.IsQuantized();
+		archive.Serialize( isQuantized );
+		if( isQuantized ) {
+			quantizedWeights.Serialize( archive );
+		} else if( archive.IsLoading() ) {
+			quantizedWeights.Reset();
+		}
+	} else if( archive.IsLoading() ) {
+		quantizedWeights.Reset();
+	}
+
+	if( version >= 2002 ) {
+		activation.Serialize( archive );
+	} else if( archive.IsLoading() ) {
+		activation = CActivationDesc();
+	}
+
 	if( archive.IsLoading() ) {
 		// Converts the free terms blob into a new tensor with the length in the first dimension not Channels
 		CDnnBlob* freeTerms = FreeTerms();
@@ -19,8 +19,213 @@ limitations under the License.
 #include <NeoML/Dnn/Layers/FullyConnectedSourceLayer.h>
 #include <NeoMathEngine/NeoMathEngine.h>
 
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+
 namespace NeoML {
 
+// Fills the labels and the weights of the batch vectors
+// labelSize is the number of label elements per vector (1 for int labels)
+static void fillLabelsAndWeights( const IProblem& problem, int firstVectorIndex, int batchSize,
+	TBlobType labelType, int labelSize, float* labels, float* weights )
+{
+	const int vectorCount = problem.GetVectorCount();
+	for( int i = 0; i < batchSize; ++i ) {
+		const int vectorIndex = ( firstVectorIndex + i ) % vectorCount;
+		// Update the labels
+		if( labelType == CT_Float ) {
+			if( labelSize == 1 ) {
+				*labels = static_cast< float >( problem.GetBinaryClass( vectorIndex ) );
+			} else {
+				int classLabel = problem.GetClass( vectorIndex );
+				NeoAssert( 0 <= classLabel && classLabel < labelSize );
+				::memset( labels, 0, labelSize * sizeof( float ) );
+				labels[classLabel] = 1;
+			}
+		} else {
+			static_assert( sizeof( float ) == sizeof( int ), "sizeof( float ) != sizeof( int )" );
+			NeoAssert( labelSize == 1 );
+			*reinterpret_cast<int*>( labels ) = problem.GetClass( vectorIndex );
+		}
+
+		// Update the weights
+		weights[i] = static_cast<float>( problem.GetVectorWeight( vectorIndex ) );
+
+		labels += labelSize;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Prepares the next batches of the problem on a separate thread
+// The batches are stored in a ring buffer; the one returned by GetNextBatch is not overwritten until the next call
+class CFullyConnectedSourceLayer::CBatchLoader {
+public:
+	// The batch prepared for copying into math engine memory
+	struct CBatch {
+		int FirstVectorIndex; // the index of the first vector of the batch in the problem
+		int ElementCount; // the number of nonzero elements
+		int ColumnsPos; // the position of the column indices in Data
+		int ValuesPos; // the position of the values in Data
+		CArray<int> Data; // the row offsets, the column indices and the values of the sparse matrix
+		CArray<float> Labels;
+		CArray<float> Weights;
+
+		CBatch() : FirstVectorIndex( 0 ), ElementCount( 0 ), ColumnsPos( 0 ), ValuesPos( 0 ) {}
+	};
+
+	CBatchLoader( const IProblem* problem, int firstVectorIndex, int batchSize, int batchCount,
+		TBlobType labelType, int labelSize );
+	~CBatchLoader();
+
+	// Returns the next batch, waiting for it if necessary
+	// The batch stays valid until the next call
+	const CBatch& GetNextBatch();
+
+private:
+	const CPtr<const IProblem> problem;
+	const int batchSize;
+	const TBlobType labelType;
+	const int labelSize;
+	CPointerArray<CBatch> batches; // the ring buffer
+	int readPos; // the position of the next batch to be returned
+	int writePos; // the position of the next batch to be loaded
+	int filledCount; // the number of loaded batches including the one in use
+	bool isBatchInUse; // the batch at readPos has been returned by GetNextBatch
+	bool isStopped;
+	std::exception_ptr exception; // the exception thrown while loading
+	std::mutex mutex;
+	std::condition_variable batchLoaded;
+	std::condition_variable batchReleased;
+	std::thread thread;
+
+	void threadProc( int firstVectorIndex );
+	void loadBatch( CBatch& batch, int firstVectorIndex ) const;
+};
+
+CFullyConnectedSourceLayer::CBatchLoader::CBatchLoader( const IProblem* _problem, int firstVectorIndex,
+		int _batchSize, int batchCount, TBlobType _labelType, int _labelSize ) :
+	problem( _problem ),
+	batchSize( _batchSize ),
+	labelType( _labelType ),
+	labelSize( _labelSize ),
+	readPos( 0 ),
+	writePos( 0 ),
+	filledCount( 0 ),
+	isBatchInUse( false ),
+	isStopped( false )
+{
+	NeoAssert( batchCount > 0 );
+	// One more batch is needed for the batch in use
+	for( int i = 0; i <= batchCount; ++i ) {
+		batches.Add( FINE_DEBUG_NEW CBatch );
+	}
+	thread = std::thread( &CBatchLoader::threadProc, this, firstVectorIndex );
+}
+
+CFullyConnectedSourceLayer::CBatchLoader::~CBatchLoader()
+{
+	{
+		std::lock_guard<std::mutex> lock( mutex );
+		isStopped = true;
+	}
+	batchReleased.notify_one();
+	thread.join();
+}
+
+const CFullyConnectedSourceLayer::CBatchLoader::CBatch& CFullyConnectedSourceLayer::CBatchLoader::GetNextBatch()
+{
+	std::unique_lock<std::mutex> lock( mutex );
+	if( isBatchInUse ) {
+		readPos = ( readPos + 1 ) % batches.Size();
+		filledCount--;
+		isBatchInUse = false;
+		batchReleased.notify_one();
+	}
+
+	batchLoaded.wait( lock, [this] { return filledCount > 0 || exception != nullptr; } );
+	if( filledCount == 0 ) {
+		std::rethrow_exception( exception );
+	}
+	isBatchInUse = true;
+	return *batches[readPos];
+}
+
+void CFullyConnectedSourceLayer::CBatchLoader::threadProc( int firstVectorIndex )
+{
+	const int vectorCount = problem->GetVectorCount();
+	while( true ) {
+		int pos = 0;
+		{
+			std::unique_lock<std::mutex> lock( mutex );
+			batchReleased.wait( lock, [this] { return isStopped || filledCount < batches.Size(); } );
+			if( isStopped ) {
+				return;
+			}
+			pos = writePos;
+		}
+
+		// The batch at writePos is not used by the other thread
+		try {
+			loadBatch( *batches[pos], firstVectorIndex );
+		} catch( ... ) {
+			std::lock_guard<std::mutex> lock( mutex );
+			exception = std::current_exception();
+			batchLoaded.notify_one();
+			return;
+		}
+		firstVectorIndex = ( firstVectorIndex + batchSize ) % vectorCount;
+
+		{
+			std::lock_guard<std::mutex> lock( mutex );
+			writePos = ( writePos + 1 ) % batches.Size();
+			filledCount++;
+		}
+		batchLoaded.notify_one();
+	}
+}
+
+// Packs the batch in the same way as CDnnSparseMatrix does: rows, columns, values, each aligned
+void CFullyConnectedSourceLayer::CBatchLoader::loadBatch( CBatch& batch, int firstVectorIndex ) const
+{
+	const int vectorCount = problem->GetVectorCount();
+	const CFloatMatrixDesc matrix = problem->GetMatrix();
+
+	batch.FirstVectorIndex = firstVectorIndex;
+	batch.ElementCount = 0;
+	for( int i = 0; i < batchSize; ++i ) {
+		batch.ElementCount += matrix.GetRow( ( firstVectorIndex + i ) % vectorCount ).Size;
+	}
+	batch.ColumnsPos = CeilTo( batchSize + 1, 4 );
+	batch.ValuesPos = batch.ColumnsPos + CeilTo( batch.ElementCount, 4 );
+	batch.Data.SetSize( batch.ValuesPos + CeilTo( batch.ElementCount, 4 ) );
+
+	static_assert( sizeof( int ) == sizeof( float ), "sizeof( int ) != sizeof( float )" );
+	int* rowsPtr = batch.Data.GetPtr();
+	int* columnsPtr = batch.Data.GetPtr() + batch.ColumnsPos;
+	float* valuesPtr = reinterpret_cast<float*>( batch.Data.GetPtr() + batch.ValuesPos );
+	int elementIndex = 0;
+	for( int i = 0; i < batchSize; ++i ) {
+		rowsPtr[i] = elementIndex;
+		const CFloatVectorDesc vector = matrix.GetRow( ( firstVectorIndex + i ) % vectorCount );
+		for( int j = 0; j < vector.Size; ++j ) {
+			columnsPtr[elementIndex] = vector.Indexes[j];
+			valuesPtr[elementIndex] = vector.Values[j];
+			elementIndex++;
+		}
+	}
+	rowsPtr[batchSize] = elementIndex;
+
+	batch.Labels.SetSize( batchSize * labelSize );
+	batch.Weights.SetSize( batchSize );
+	fillLabelsAndWeights( *problem, firstVectorIndex, batchSize, labelType, labelSize,
+		batch.Labels.GetPtr(), batch.Weights.GetPtr() );
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+
 CFullyConnectedSourceLayer::CFullyConnectedSourceLayer( IMathEngine& mathEngine ) :
 	CFullyConnectedLayer( mathEngine, "CCnnFullyConnectedSourceLayer" ),
 	problem( nullptr ),
@@ -31,7 +236,9 @@ CFullyConnectedSourceLayer::CFullyConnectedSourceLayer( IMathEngine& mathEngine
 	batchFirstLoadedIndex( NotFound ),
 	batchLastLoadedIndex( NotFound ),
 	firstVectorInBatchIndex( NotFound ),
-	labelType( CT_Float )
+	labelType( CT_Float ),
+	prefetchBatchCount( 0 ),
+	loader( nullptr )
 {
 }
 
@@ -40,13 +247,7 @@ void CFullyConnectedSourceLayer::SetBatchSize( int newBatchSize )
 	NeoAssert( newBatchSize > 0 );
 
 	batchSize = newBatchSize;
-	batchIndex = NotFound;
-	batchFirstLoadedIndex = NotFound;
-	batchLastLoadedIndex = NotFound;
-	if( batchData != 0 ) {
-		delete batchData;
-		batchData = 0;
-	}
+	resetBatches();
 
 	ForceReshape();
 }
@@ -58,20 +259,26 @@ void CFullyConnectedSourceLayer::SetMaxBatchCount( int newBatchCount )
 	batchCount = newBatchCount;
 }
 
+void CFullyConnectedSourceLayer::SetPrefetchBatchCount( int newPrefetchBatchCount )
+{
+	NeoAssert( newPrefetchBatchCount >= 0 );
+
+	if( prefetchBatchCount == newPrefetchBatchCount ) {
+		return;
+	}
+
+	prefetchBatchCount = newPrefetchBatchCount;
+	resetBatches();
+}
+
 void CFullyConnectedSourceLayer::SetProblem( IProblem* newProblem )
 {
 	NeoAssert( GetDnn() == 0 || problem == 0 || newProblem == 0
 		|| ( problem->GetFeatureCount() == newProblem->GetFeatureCount()
 			&& problem->GetClassCount() == newProblem->GetClassCount() ) );
 
+	resetBatches();
 	problem = newProblem;
-	batchIndex = NotFound;
-	batchFirstLoadedIndex = NotFound;
-	batchLastLoadedIndex = NotFound;
-	if( batchData != 0 ) {
-		delete batchData;
-		batchData = 0;
-	}
 	firstVectorInBatchIndex = 0;
 }
 
@@ -84,34 +291,39 @@ void CFullyConnectedSourceLayer::SetLabelType( TBlobType newLabelType )
 	}
 
 	labelType = newLabelType;
+	// The prepared labels are of the old type
+	delete loader;
+	loader = nullptr;
 
 	ForceReshape();
 }
 
-static const int FullyConnectedSourceLayerVersion = 2000;
+static const int FullyConnectedSourceLayerVersion = 2001;
 
 void CFullyConnectedSourceLayer::Serialize( CArchive& archive )
 {
-	archive.SerializeVersion( FullyConnectedSourceLayerVersion, CDnn::ArchiveMinSupportedVersion );
+	const int version = archive.SerializeVersion( FullyConnectedSourceLayerVersion, CDnn::ArchiveMinSupportedVersion );
 	CFullyConnectedLayer::Serialize( archive );
 
 	if( archive.IsStoring() ) {
 		archive << batchSize;
 		archive << batchCount;
 		archive << static_cast<int>( labelType );
+		archive << prefetchBatchCount;
 	} else if( archive.IsLoading() ) {
+		resetBatches();
 		problem = 0;
-		delete batchData;
-		batchData = 0;
 		archive >> batchSize;
 		archive >> batchCount;
-		batchIndex = NotFound;
-		batchFirstLoadedIndex = NotFound;
-		batchLastLoadedIndex = NotFound;
 		firstVectorInBatchIndex = 0;
 		int labelTypeInt = 0;
 		archive >> labelTypeInt;
 		labelType = static_cast<TBlobType>( labelTypeInt );
+		if( version >= 2001 ) {
+			archive >> prefetchBatchCount;
+		} else {
+			prefetchBatchCount = 0;
+		}
 	} else {
 		NeoAssert( false );
 	}
@@ -119,6 +331,7 @@ void CFullyConnectedSourceLayer::Serialize( CArchive& archive )
 
 CFullyConnectedSourceLayer::~CFullyConnectedSourceLayer()
 {
+	delete loader;
 	if( batchData != 0 ) {
 		delete batchData;
 	}
@@ -173,10 +386,16 @@ void CFullyConnectedSourceLayer::Reshape()
 
 void CFullyConnectedSourceLayer::RunOnce()
 {
+	if( prefetchBatchCount > 0 ) {
+		// The batch has already been prepared, including the labels and the weights
+		loadPrefetchedBatch();
+		return;
+	}
+
 	loadBatchData();
 
 	// Update the data
-	CSparseMatrixDesc batchDataDesc = batchData->GetBatchDesc( batchIndex - batchFirstLoadedIndex );
+	CSparseMatrixDesc batchDataDesc = getBatchDesc();
 	MathEngine().MultiplySparseMatrixByTransposedMatrix( batchSize,
 		problem->GetFeatureCount(), GetNumberOfElements(),
 		batchDataDesc, Weights()->GetData(), outputBlobs[0]->GetData() );
@@ -187,35 +406,8 @@ void CFullyConnectedSourceLayer::RunOnce()
 	}
 
 	// Update the labels and weights
-
-	float* labels = batchLabels.GetPtr();
-	float* weights = batchWeights.GetPtr();
-
-	const int vectorCount = problem->GetVectorCount();
-	for( int i = 0; i < batchSize; ++i ) {
-		const int vectorIndex = ( firstVectorInBatchIndex + i ) % vectorCount;
-		// Update the labels
-		if( labelType == CT_Float ) {
-			if( outputBlobs[1]->GetChannelsCount() == 1 ) {
-				*labels = static_cast< float >( problem->GetBinaryClass( vectorIndex ) );
-			} else {
-				int classLabel = problem->GetClass( vectorIndex );
-				NeoAssert( 0 <= classLabel && classLabel < outputBlobs[1]->GetChannelsCount() );
-				::memset( labels, 0, outputBlobs[1]->GetChannelsCount() * sizeof( float ) );
-				labels[classLabel] = 1;
-			}
-		} else {
-			static_assert( sizeof( float ) == sizeof( int ), "sizeof( float ) != sizeof( int )" );
-			NeoAssert( outputBlobs[1]->GetChannelsCount() == 1 );
-			*reinterpret_cast<int*>( labels ) = problem->GetClass( vectorIndex );
-		}
-
-		// Update the weights
-		*weights = static_cast<float>( problem->GetVectorWeight( vectorIndex ) );
-
-		labels += outputBlobs[1]->GetObjectSize();
-		weights += outputBlobs[2]->GetObjectSize();
-	}
+	fillLabelsAndWeights( *problem, firstVectorInBatchIndex, batchSize, labelType, outputBlobs[1]->GetObjectSize(),
+		batchLabels.GetPtr(), batchWeights.GetPtr() );
 
 	if( labelType == CT_Float ) {
 		outputBlobs[1]->CopyFrom( batchLabels.GetPtr() );
@@ -232,9 +424,7 @@ void CFullyConnectedSourceLayer::BackwardOnce()
 
 void CFullyConnectedSourceLayer::LearnOnce()
 {
-	NeoAssert( batchData != 0 );
-
-	CSparseMatrixDesc batchDataDesc = batchData->GetBatchDesc( batchIndex );
+	CSparseMatrixDesc batchDataDesc = getBatchDesc();
 	MathEngine().MultiplyTransposedMatrixBySparseMatrixAndAdd( outputDiffBlobs[0]->GetObjectCount(),
 		GetNumberOfElements(), problem->GetFeatureCount(),
 		outputDiffBlobs[0]->GetData(), batchDataDesc, WeightsDiff()->GetData() );
@@ -245,6 +435,20 @@ void CFullyConnectedSourceLayer::LearnOnce()
 	}
 }
 
+// Stops the loader and discards the loaded batches
+void CFullyConnectedSourceLayer::resetBatches()
+{
+	delete loader;
+	loader = nullptr;
+	batchIndex = NotFound;
+	batchFirstLoadedIndex = NotFound;
+	batchLastLoadedIndex = NotFound;
+	if( batchData != 0 ) {
+		delete batchData;
+		batchData = 0;
+	}
+}
+
 // Load the batch
 void CFullyConnectedSourceLayer::loadBatchData()
 {
@@ -300,6 +504,60 @@ void CFullyConnectedSourceLayer::loadBatchData()
 	}
 }
 
+// Takes the next batch prepared by the loader and passes it to the outputs
+void CFullyConnectedSourceLayer::loadPrefetchedBatch()
+{
+	NeoAssert( problem != 0 );
+
+	if( loader == nullptr ) {
+		const int firstVectorIndex = batchIndex == NotFound ? 0
+			: ( firstVectorInBatchIndex + batchSize ) % problem->GetVectorCount();
+		loader = FINE_DEBUG_NEW CBatchLoader( problem, firstVectorIndex, batchSize, prefetchBatchCount, labelType,
+			outputBlobs[1]->GetObjectSize() );
+	}
+	const CBatchLoader::CBatch& batch = loader->GetNextBatch();
+	batchIndex = 0;
+	firstVectorInBatchIndex = batch.FirstVectorIndex;
+
+	// Copy the batch into math engine memory with one call
+	if( prefetchedData == nullptr || prefetchedData->GetDataSize() < batch.Data.Size() ) {
+		prefetchedData = CDnnBlob::CreateVector( MathEngine(), CT_Int, batch.Data.Size() );
+	}
+	CIntHandle data = prefetchedData->GetData<int>();
+	MathEngine().DataExchangeTyped( data, batch.Data.GetPtr(), batch.Data.Size() );
+	prefetchedBatchDesc.ElementCount = batch.ElementCount;
+	prefetchedBatchDesc.Rows = data;
+	prefetchedBatchDesc.Columns = data + batch.ColumnsPos;
+	prefetchedBatchDesc.Values = CFloatHandle( data + batch.ValuesPos );
+
+	MathEngine().MultiplySparseMatrixByTransposedMatrix( batchSize,
+		problem->GetFeatureCount(), GetNumberOfElements(),
+		prefetchedBatchDesc, Weights()->GetData(), outputBlobs[0]->GetData() );
+
+	if( !IsZeroFreeTerm() ) {
+		MathEngine().AddVectorToMatrixRows( 1, outputBlobs[0]->GetObjectData( 0 ), outputBlobs[0]->GetData(),
+			batchSize, outputBlobs[0]->GetObjectSize(), FreeTerms()->GetData() );
+	}
+
+	if( labelType == CT_Float ) {
+		outputBlobs[1]->CopyFrom( batch.Labels.GetPtr() );
+	} else {
+		outputBlobs[1]->CopyFrom( reinterpret_cast<const int*>( batch.Labels.GetPtr() ) );
+	}
+	outputBlobs[2]->CopyFrom( batch.Weights.GetPtr() );
+}
+
+// Gets the description of the current batch
+CSparseMatrixDesc CFullyConnectedSourceLayer::getBatchDesc() const
+{
+	if( prefetchBatchCount > 0 ) {
+		NeoAssert( loader != nullptr );
+		return prefetchedBatchDesc;
+	}
+	NeoAssert( batchData != 0 );
+	return batchData->GetBatchDesc( batchIndex - batchFirstLoadedIndex );
+}
+
 // Checks if a batch with this index has been loaded
 bool CFullyConnectedSourceLayer::isBatchLoaded( int index ) const
 {
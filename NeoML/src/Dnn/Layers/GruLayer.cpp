@@ -127,6 +127,68 @@ void CGruLayer::SetHiddenSize(int size)
 	mainBackLink->SetDimSize(BD_Channels, size);
 }
 
+void CGruLayer::RunOnce()
+{
+	if( isFusedRunPossible() ) {
+		runFused();
+	} else {
+		CRecurrentLayer::RunOnce();
+	}
+}
+
+// Checks if the layer may be calculated by the fused kernel instead of the internal network
+bool CGruLayer::isFusedRunPossible() const
+{
+	return IsFusedRunPossible()
+		&& !mainLayer->IsQuantized() && mainLayer->GetActivation().IsIdentity()
+		&& !gateLayer->IsQuantized() && gateLayer->GetActivation().IsIdentity();
+}
+
+// Processes the whole sequence at once:
+// the input projections are calculated for all the steps by matrix multiplication,
+// then the math engine runs the recurrent part with the fused gate activations
+// The weights of both fully connected layers are [input, hidden] concatenations
+void CGruLayer::runFused()
+{
+	const CDnnBlob& input = *inputBlobs[0];
+	const int sequenceLength = input.GetBatchLength();
+	const int batchSize = input.GetBatchWidth();
+	const int inputSize = input.GetObjectSize();
+	const int hiddenSize = GetHiddenSize();
+	const int gatesSize = G_Count * hiddenSize;
+	const int rowCount = sequenceLength * batchSize;
+	const int weightsRowSize = inputSize + hiddenSize;
+
+	const CObjectArray<CDnnBlob>& mainParams = GetInternalLayerParams( *mainLayer );
+	const CObjectArray<CDnnBlob>& gateParams = GetInternalLayerParams( *gateLayer );
+	NeoPresume( mainParams[0]->GetObjectSize() == weightsRowSize );
+	NeoPresume( gateParams[0]->GetObjectSize() == weightsRowSize );
+
+	CFloatHandleVar inputGates( MathEngine(), rowCount * gatesSize );
+	MathEngine().MultiplyMatrixByTransposedMatrix( input.GetData(), rowCount, inputSize, inputSize,
+		gateParams[0]->GetData(), gatesSize, weightsRowSize, inputGates.GetHandle(), gatesSize, rowCount * gatesSize );
+	if( !gateLayer->IsZeroFreeTerm() ) {
+		MathEngine().AddVectorToMatrixRows( 1, inputGates.GetHandle(), inputGates.GetHandle(), rowCount, gatesSize,
+			gateParams[1]->GetData() );
+	}
+
+	CFloatHandleVar inputMain( MathEngine(), rowCount * hiddenSize );
+	MathEngine().MultiplyMatrixByTransposedMatrix( input.GetData(), rowCount, inputSize, inputSize,
+		mainParams[0]->GetData(), hiddenSize, weightsRowSize, inputMain.GetHandle(), hiddenSize, rowCount * hiddenSize );
+	if( !mainLayer->IsZeroFreeTerm() ) {
+		MathEngine().AddVectorToMatrixRows( 1, inputMain.GetHandle(), inputMain.GetHandle(), rowCount, hiddenSize,
+			mainParams[1]->GetData() );
+	}
+
+	CPtr<CDnnBlob> initialOutput = GetBackLinkStartState( *mainBackLink, 1 );
+
+	MathEngine().GruRecurrent( IsReverseSequence(), sequenceLength, batchSize, hiddenSize,
+		inputGates.GetHandle(), inputMain.GetHandle(), gateParams[0]->GetData() + inputSize,
+		mainParams[0]->GetData() + inputSize, weightsRowSize, initialOutput->GetData(), outputBlobs[0]->GetData() );
+
+	SetBackLinkEndState( *mainBackLink, *outputBlobs[0] );
+}
+
 static const int GruLayerVersion = 2000;
 
 void CGruLayer::Serialize( CArchive& archive )
@@ -238,6 +238,68 @@ void CLstmLayer::SetCompatibilityMode( bool compatibilityMode )
 	ForceReshape();
 }
 
+void CLstmLayer::RunOnce()
+{
+	if( isFusedRunPossible() ) {
+		runFused();
+	} else {
+		CRecurrentLayer::RunOnce();
+	}
+}
+
+// Checks if the layer may be calculated by the fused kernel instead of the internal network
+// The dropout is not applied on inference so it doesn't matter
+bool CLstmLayer::isFusedRunPossible() const
+{
+	return IsFusedRunPossible() && recurrentActivation == AF_Sigmoid && !isInCompatibilityMode
+		&& !inputHiddenLayer->IsQuantized() && inputHiddenLayer->GetActivation().IsIdentity()
+		&& !recurHiddenLayer->IsQuantized() && recurHiddenLayer->GetActivation().IsIdentity();
+}
+
+// Processes the whole sequence at once:
+// the input projection is calculated for all the steps by one matrix multiplication,
+// then the math engine runs the recurrent part with the fused gate activations
+void CLstmLayer::runFused()
+{
+	const CDnnBlob& input = *inputBlobs[0];
+	const int sequenceLength = input.GetBatchLength();
+	const int batchSize = input.GetBatchWidth();
+	const int hiddenSize = GetHiddenSize();
+	const int gatesSize = G_Count * hiddenSize;
+	const int rowCount = sequenceLength * batchSize;
+
+	const CObjectArray<CDnnBlob>& inputParams = GetInternalLayerParams( *inputHiddenLayer );
+	const CObjectArray<CDnnBlob>& recurParams = GetInternalLayerParams( *recurHiddenLayer );
+	NeoPresume( inputParams[0]->GetObjectSize() == input.GetObjectSize() );
+
+	CFloatHandleVar inputGates( MathEngine(), rowCount * gatesSize );
+	MathEngine().MultiplyMatrixByTransposedMatrix( input.GetData(), rowCount, input.GetObjectSize(), input.GetObjectSize(),
+		inputParams[0]->GetData(), gatesSize, input.GetObjectSize(), inputGates.GetHandle(), gatesSize, rowCount * gatesSize );
+	// Both free terms are added to the input projection
+	if( !inputHiddenLayer->IsZeroFreeTerm() ) {
+		MathEngine().AddVectorToMatrixRows( 1, inputGates.GetHandle(), inputGates.GetHandle(), rowCount, gatesSize,
+			inputParams[1]->GetData() );
+	}
+	if( !recurHiddenLayer->IsZeroFreeTerm() ) {
+		MathEngine().AddVectorToMatrixRows( 1, inputGates.GetHandle(), inputGates.GetHandle(), rowCount, gatesSize,
+			recurParams[1]->GetData() );
+	}
+
+	CPtr<CDnnBlob> initialOutput = GetBackLinkStartState( *mainBackLink, 2 );
+	CPtr<CDnnBlob> initialState = GetBackLinkStartState( *stateBackLink, 1 );
+
+	// The state is calculated even if the second output is not connected
+	CPtr<CDnnBlob> state = outputBlobs.Size() > 1 ? outputBlobs[1].Ptr()
+		: CDnnBlob::CreateBlob( MathEngine(), CT_Float, outputBlobs[0]->GetDesc() );
+
+	MathEngine().LstmRecurrent( IsReverseSequence(), sequenceLength, batchSize, hiddenSize,
+		inputGates.GetHandle(), recurParams[0]->GetData(), initialOutput->GetData(), initialState->GetData(),
+		outputBlobs[0]->GetData(), state->GetData() );
+
+	SetBackLinkEndState( *mainBackLink, *outputBlobs[0] );
+	SetBackLinkEndState( *stateBackLink, *state );
+}
+
 static const int LstmLayerVersion = 2001;
 
 void CLstmLayer::Serialize( CArchive& archive )
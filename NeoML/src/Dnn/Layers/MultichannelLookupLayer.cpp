@@ -22,7 +22,8 @@ namespace NeoML {
 
 CMultichannelLookupLayer::CMultichannelLookupLayer( IMathEngine& mathEngine ) :
 	CBaseLayer( mathEngine, "CCnnMultichannelLookupLayer", true ),
-	useFrameworkLearning( false )
+	useFrameworkLearning( false ),
+	isSparseGradientEnabled( false )
 {
 }
 
@@ -106,15 +107,20 @@ CArchive& operator >> (CArchive& archive, CLookupDimension& d) {
 	return archive >> d.VectorCount >> d.VectorSize;
 }
 
-static const int MultichannelLookupLayerVersion = 2000;
+static const int MultichannelLookupLayerVersion = 2001;
 
 void CMultichannelLookupLayer::Serialize( CArchive& archive )
 {
-	archive.SerializeVersion( MultichannelLookupLayerVersion, CDnn::ArchiveMinSupportedVersion );
+	const int version = archive.SerializeVersion( MultichannelLookupLayerVersion, CDnn::ArchiveMinSupportedVersion );
 	CBaseLayer::Serialize( archive );
 	
 	dimensions.Serialize(archive);
 	archive.Serialize(useFrameworkLearning);
+	if( version >= 2001 ) {
+		archive.Serialize( isSparseGradientEnabled );
+	} else {
+		isSparseGradientEnabled = false;
+	}
 	SerializeBlobs( MathEngine(), archive, ownParams );
 }
 
@@ -204,7 +210,9 @@ void CMultichannelLookupLayer::LearnOnce()
 {
 	CFloatHandleStackVar learningRate( MathEngine() );
 
-	if(useFrameworkLearning) {
+	if( useFrameworkLearning && isSparseGradientEnabled ) {
+		learnSparse();
+	} else if(useFrameworkLearning) {
 		learningRate.SetValue( 1 );
 
 		CArray<CFloatHandle> lookupTables;
@@ -255,6 +263,92 @@ void CMultichannelLookupLayer::LearnOnce()
 	}
 }
 
+// Passes to the solver only the gradients of the embeddings used in the inputs
+void CMultichannelLookupLayer::learnSparse()
+{
+	const int tableCount = GetDimensions().Size();
+
+	// Read the indices and collect the used rows of each table
+	CArray<CArray<int>> inputIndices;
+	inputIndices.SetSize( inputBlobs.Size() );
+	for( int i = 0; i < inputBlobs.Size(); i++ ) {
+		CArray<int>& indices = inputIndices[i];
+		indices.SetSize( inputBlobs[i]->GetDataSize() );
+		if( inputBlobs[i]->GetDataType() == CT_Float ) {
+			CArray<float> values;
+			values.SetSize( indices.Size() );
+			inputBlobs[i]->CopyTo( values.GetPtr() );
+			for( int k = 0; k < values.Size(); k++ ) {
+				indices[k] = static_cast<int>( values[k] );
+			}
+		} else {
+			inputBlobs[i]->CopyTo( indices.GetPtr() );
+		}
+	}
+
+	CArray<CArray<int>> rows;
+	rows.SetSize( tableCount );
+	for( int j = 0; j < tableCount; j++ ) {
+		CMap<int, int> rowPositions;
+		for( int i = 0; i < inputIndices.Size(); i++ ) {
+			CArray<int>& indices = inputIndices[i];
+			const int channelCount = inputBlobs[i]->GetChannelsCount();
+			for( int k = j; k < indices.Size(); k += channelCount ) {
+				const int row = indices[k];
+				NeoAssert( 0 <= row && row < GetDimensions()[j].VectorCount );
+				int position = NotFound;
+				if( !rowPositions.Lookup( row, position ) ) {
+					position = rows[j].Size();
+					rows[j].Add( row );
+					rowPositions.Add( row, position );
+				}
+				// Replace the index with the position in the compact table
+				indices[k] = position;
+			}
+		}
+	}
+
+	// Calculate the gradients of the used rows
+	CObjectArray<CDnnBlob> rowDiffs;
+	CArray<CFloatHandle> diffTables;
+	CArray<CLookupDimension> diffDimensions;
+	for( int j = 0; j < tableCount; j++ ) {
+		const int rowCount = max( rows[j].Size(), 1 );
+		CPtr<CDnnBlob> diff = CDnnBlob::CreateDataBlob( MathEngine(), CT_Float, 1, rowCount, GetDimensions()[j].VectorSize );
+		diff->Clear();
+		rowDiffs.Add( diff );
+		diffTables.Add( diff->GetData() );
+		diffDimensions.Add( CLookupDimension( rowCount, GetDimensions()[j].VectorSize ) );
+	}
+
+	CFloatHandleStackVar mult( MathEngine() );
+	mult.SetValue( 1 );
+	for( int i = 0; i < inputBlobs.Size(); i++ ) {
+		CPtr<CDnnBlob> positions = CDnnBlob::CreateBlob( MathEngine(), CT_Int, inputBlobs[i]->GetDesc() );
+		positions->CopyFrom( inputIndices[i].GetPtr() );
+		MathEngine().VectorMultichannelLookupAndAddToTable(
+			positions->GetObjectCount() * positions->GetGeometricalSize(),
+			positions->GetChannelsCount(), positions->GetData<int>(),
+			diffTables.GetPtr(), diffDimensions.GetPtr(), tableCount,
+			mult, outputDiffBlobs[i]->GetData(), outputBlobs[i]->GetChannelsCount() );
+	}
+
+	// In the recurrent mode the gradients of all sequence positions make one step
+	const bool isContinuation = GetDnn()->IsRecurrentMode() && !GetDnn()->IsFirstSequencePos();
+	GetDnn()->GetSolver()->AddSparseDiff( this, rows, rowDiffs, isContinuation );
+}
+
+void CMultichannelLookupLayer::ShareParamBlobs( const CBaseLayer& source )
+{
+	CBaseLayer::ShareParamBlobs( source );
+
+	const CMultichannelLookupLayer* sourceLayer = CheckCast<CMultichannelLookupLayer>( &source );
+	NeoAssert( ownParams.Size() == sourceLayer->ownParams.Size() );
+	for( int i = 0; i < ownParams.Size(); ++i ) {
+		ownParams[i] = sourceLayer->ownParams[i];
+	}
+}
+
 void CMultichannelLookupLayer::Word2VecStep( IMathEngine& mathEngine, int batchSize,
 	CMultichannelLookupLayer& word2vecLayer, CMultichannelLookupLayer& context2vecLayer,
 	const CConstIntHandle& positiveSampleMatrix, int positiveCount,
@@ -34,7 +34,9 @@ CMultiheadAttentionLayer::CMultiheadAttentionLayer( IMathEngine& mathEngine ) :
 	hiddenSize( 8 ),
 	dropoutRate( -1 ),
 	useMask( false ),
-	outputSize( 8 )
+	outputSize( 8 ),
+	useKeyValueCache( false ),
+	cachedLength( 0 )
 {
 }
 
@@ -73,6 +75,59 @@ void CMultiheadAttentionLayer::SetOutputSize( int _outputSize )
 	outputSize = _outputSize;
 }
 
+void CMultiheadAttentionLayer::EnableKeyValueCache( bool enable )
+{
+	useKeyValueCache = enable;
+	keyCache = nullptr;
+	valueCache = nullptr;
+	cachedLength = 0;
+}
+
+// Copies the valid positions of the cache
+static CPtr<CDnnBlob> copyCachedPositions( const CDnnBlob& cache, int cachedLength )
+{
+	CBlobDesc desc = cache.GetDesc();
+	desc.SetDimSize( BD_ListSize, cachedLength );
+	CPtr<CDnnBlob> result = CDnnBlob::CreateBlob( cache.GetMathEngine(), CT_Float, desc );
+
+	const int objectSize = cachedLength * cache.GetChannelsCount();
+	for( int i = 0; i < cache.GetBatchWidth(); ++i ) {
+		cache.GetMathEngine().VectorCopy( result->GetData() + i * objectSize,
+			cache.GetData() + i * cache.GetListSize() * cache.GetChannelsCount(), objectSize );
+	}
+	return result;
+}
+
+void CMultiheadAttentionLayer::GetState( CObjectArray<CDnnBlob>& state ) const
+{
+	state.SetSize( 2 );
+	state[0] = cachedLength == 0 ? nullptr : copyCachedPositions( *keyCache, cachedLength );
+	state[1] = cachedLength == 0 ? nullptr : copyCachedPositions( *valueCache, cachedLength );
+}
+
+void CMultiheadAttentionLayer::SetState( const CObjectArray<CDnnBlob>& state )
+{
+	NeoAssert( state.Size() == 2 );
+	NeoAssert( ( state[0] == nullptr ) == ( state[1] == nullptr ) );
+
+	if( state[0] == nullptr ) {
+		cachedLength = 0;
+		return;
+	}
+	NeoAssert( state[0]->HasEqualDimensions( state[1] ) );
+	NeoAssert( state[0]->GetChannelsCount() == hiddenSize );
+	// The cache is modified in place, so the blobs are copied
+	keyCache = state[0]->GetCopy();
+	valueCache = state[1]->GetCopy();
+	cachedLength = state[0]->GetListSize();
+}
+
+void CMultiheadAttentionLayer::RestartSequence()
+{
+	cachedLength = 0;
+	CCompositeLayer::RestartSequence();
+}
+
 static const int MultiheadAttentionLayerVersion = 0;
 
 void CMultiheadAttentionLayer::Serialize( CArchive& archive )
@@ -95,6 +150,165 @@ void CMultiheadAttentionLayer::Reshape()
 	CCompositeLayer::Reshape();
 }
 
+void CMultiheadAttentionLayer::RunOnce()
+{
+	if( isFusedRunPossible() ) {
+		runFused();
+	} else {
+		CheckArchitecture( !useKeyValueCache, GetName(), "key/value cache is supported only for inference on CPU" );
+		CCompositeLayer::RunOnce();
+	}
+}
+
+// Checks if the attention may be calculated by the fused kernel instead of the internal network
+// The dropout is not applied on inference so it doesn't matter
+bool CMultiheadAttentionLayer::isFusedRunPossible() const
+{
+	// The fused kernel doesn't store the softmax result, so the second output must not be connected
+	if( MathEngine().GetType() != MET_Cpu || GetDnn()->IsRecurrentMode() || GetDnn()->IsBackwardPerformed()
+		|| outputBlobs.Size() != 1 || inputBlobs[I_Q]->GetDataType() != CT_Float )
+	{
+		return false;
+	}
+
+	const char* const fullyConnectedNames[] = { "Q", "K", "V", "Out.Dense" };
+	for( const char* name : fullyConnectedNames ) {
+		const CFullyConnectedLayer* fc = dynamic_cast<const CFullyConnectedLayer*>( GetLayer( name ).Ptr() );
+		if( fc == nullptr || fc->IsQuantized() || !fc->GetActivation().IsIdentity() ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Calculates the attention without the internal network:
+// the projections are calculated by matrix multiplications right in the head-interleaved layout,
+// so no transpositions are needed, and the math engine calculates all the heads at once
+// without storing the ListSize_Q x ListSize_V score matrices
+void CMultiheadAttentionLayer::runFused()
+{
+	const CDnnBlob& query = *inputBlobs[I_Q];
+	const CDnnBlob& key = *inputBlobs[I_K];
+	const CDnnBlob& value = *inputBlobs[I_V];
+	const int batchSize = query.GetBatchLength() * query.GetBatchWidth();
+	const int queryLength = query.GetListSize();
+	const int keyLength = key.GetListSize();
+	const int headSize = hiddenSize / headCount;
+	NeoPresume( key.GetObjectCount() == batchSize * keyLength );
+	NeoPresume( value.GetObjectCount() == batchSize * keyLength );
+
+	// [B, seq_Q, n_head, d_k]
+	CFloatHandleVar projectedQuery( MathEngine(), batchSize * queryLength * hiddenSize );
+	applyFullyConnected( "Q", query.GetData(), query.GetObjectCount(), projectedQuery.GetHandle() );
+	// [B, seq_to, n_head, d_k]
+	CFloatHandleVar projectedKey( MathEngine(), batchSize * keyLength * hiddenSize );
+	applyFullyConnected( "K", key.GetData(), key.GetObjectCount(), projectedKey.GetHandle() );
+	CFloatHandleVar projectedValue( MathEngine(), batchSize * keyLength * hiddenSize );
+	applyFullyConnected( "V", value.GetData(), value.GetObjectCount(), projectedValue.GetHandle() );
+
+	const float multiplier = static_cast<float>( 1.0 / sqrt( 1.0 * hiddenSize ) );
+	// [B, seq_Q, n_head, d_k]
+	CFloatHandleVar attention( MathEngine(), batchSize * queryLength * hiddenSize );
+
+	if( useKeyValueCache ) {
+		CheckArchitecture( !useMask, GetName(), "mask is not supported with key/value cache" );
+		CheckArchitecture( queryLength == keyLength, GetName(),
+			"with key/value cache the number of queries must be equal to the number of keys" );
+		CheckArchitecture( cachedLength == 0 || keyCache->GetBatchWidth() == batchSize, GetName(),
+			"the batch size differs from the cached one" );
+		appendToCache( keyCache, projectedKey.GetHandle(), batchSize, keyLength );
+		appendToCache( valueCache, projectedValue.GetHandle(), batchSize, keyLength );
+		const int prevLength = cachedLength;
+		cachedLength += keyLength;
+
+		// The new queries don't see the new positions that follow them
+		CPtr<CDnnBlob> mask;
+		if( queryLength > 1 ) {
+			CArray<float> maskData;
+			maskData.Add( 0.f, queryLength * cachedLength );
+			for( int i = 0; i < queryLength; ++i ) {
+				for( int j = prevLength + i + 1; j < cachedLength; ++j ) {
+					maskData[i * cachedLength + j] = -1e+9f;
+				}
+			}
+			mask = CDnnBlob::CreateVector( MathEngine(), CT_Float, maskData.Size() );
+			mask->CopyFrom( maskData.GetPtr() );
+		}
+
+		// The objects are not stored contiguously in the cache, so they are processed one by one
+		const int cacheObjectSize = keyCache->GetListSize() * hiddenSize;
+		const int queryObjectSize = queryLength * hiddenSize;
+		for( int i = 0; i < batchSize; ++i ) {
+			MathEngine().ScaledDotProductAttention( 1, headCount, queryLength, cachedLength, headSize, multiplier,
+				projectedQuery.GetHandle() + i * queryObjectSize, keyCache->GetData() + i * cacheObjectSize,
+				valueCache->GetData() + i * cacheObjectSize, mask == nullptr ? CConstFloatHandle() : mask->GetData(),
+				attention.GetHandle() + i * queryObjectSize );
+		}
+	} else {
+		// The mask is multiplied by the same constant as in applyMask
+		CPtr<CDnnBlob> mask;
+		if( useMask ) {
+			const CDnnBlob& maskInput = *inputBlobs[I_Mask];
+			NeoPresume( maskInput.GetDataSize() == queryLength * keyLength );
+			CFloatHandleStackVar maskMultiplier( MathEngine() );
+			maskMultiplier.SetValue( -1e+9 );
+			mask = CDnnBlob::CreateBlob( MathEngine(), CT_Float, maskInput.GetDesc() );
+			MathEngine().VectorMultiply( maskInput.GetData(), mask->GetData(), mask->GetDataSize(), maskMultiplier );
+		}
+
+		MathEngine().ScaledDotProductAttention( batchSize, headCount, queryLength, keyLength, headSize,
+			multiplier, projectedQuery.GetHandle(), projectedKey.GetHandle(), projectedValue.GetHandle(),
+			mask == nullptr ? CConstFloatHandle() : mask->GetData(), attention.GetHandle() );
+	}
+
+	applyFullyConnected( "Out.Dense", attention.GetHandle(), batchSize * queryLength, outputBlobs[O_Output]->GetData() );
+}
+
+// Calculates the result of the internal fully connected layer
+void CMultiheadAttentionLayer::applyFullyConnected( const char* name, const CConstFloatHandle& input, int rowCount,
+	const CFloatHandle& result )
+{
+	CPtr<CFullyConnectedLayer> fc = CheckCast<CFullyConnectedLayer>( GetLayer( name ) );
+	const CObjectArray<CDnnBlob>& params = GetInternalLayerParams( *fc );
+	const int inputSize = params[0]->GetObjectSize();
+	const int outputSize = params[0]->GetObjectCount();
+
+	MathEngine().MultiplyMatrixByTransposedMatrix( input, rowCount, inputSize, inputSize,
+		params[0]->GetData(), outputSize, inputSize, result, outputSize, rowCount * outputSize );
+	if( !fc->IsZeroFreeTerm() ) {
+		MathEngine().AddVectorToMatrixRows( 1, result, result, rowCount, outputSize, params[1]->GetData() );
+	}
+}
+
+// Appends the new positions of all the objects to the cache
+void CMultiheadAttentionLayer::appendToCache( CPtr<CDnnBlob>& cache, const CConstFloatHandle& data,
+	int batchSize, int length )
+{
+	const int newLength = cachedLength + length;
+	if( cache == nullptr || cache->GetListSize() < newLength || cache->GetBatchWidth() != batchSize
+		|| cache->GetChannelsCount() != hiddenSize )
+	{
+		CheckArchitecture( cachedLength == 0 || cache->GetChannelsCount() == hiddenSize, GetName(),
+			"the hidden size differs from the cached one" );
+		// The capacity is doubled so that the total copying time is linear in the sequence length
+		CBlobDesc desc( CT_Float );
+		desc.SetDimSize( BD_BatchWidth, batchSize );
+		desc.SetDimSize( BD_ListSize, max( newLength, cache == nullptr ? 0 : 2 * cache->GetListSize() ) );
+		desc.SetDimSize( BD_Channels, hiddenSize );
+		CPtr<CDnnBlob> newCache = CDnnBlob::CreateBlob( MathEngine(), CT_Float, desc );
+		for( int i = 0; i < batchSize && cachedLength > 0; ++i ) {
+			MathEngine().VectorCopy( newCache->GetData() + i * newCache->GetListSize() * hiddenSize,
+				cache->GetData() + i * cache->GetListSize() * hiddenSize, cachedLength * hiddenSize );
+		}
+		cache = newCache;
+	}
+
+	for( int i = 0; i < batchSize; ++i ) {
+		MathEngine().VectorCopy( cache->GetData() + ( i * cache->GetListSize() + cachedLength ) * hiddenSize,
+			data + i * length * hiddenSize, length * hiddenSize );
+	}
+}
+
 // Creates layer with new parameters
 // Here and further blob sizes are shown as [BathcWidth, ListSize, Width, Channels]
 void CMultiheadAttentionLayer::create()
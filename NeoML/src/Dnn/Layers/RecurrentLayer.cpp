@@ -215,6 +215,48 @@ void CRecurrentLayer::RunInternalDnnBackward()
 	}
 }
 
+bool CRecurrentLayer::IsFusedRunPossible() const
+{
+	if( MathEngine().GetType() != MET_Cpu || GetDnn()->IsRecurrentMode() || GetDnn()->IsBackwardPerformed()
+		|| repeatCount != 1 || inputBlobs[0]->GetDataType() != CT_Float || inputBlobs[0]->GetListSize() != 1 )
+	{
+		return false;
+	}
+	// The other inputs are the initial states of the back links
+	for( int i = 1; i < inputBlobs.Size(); ++i ) {
+		if( inputBlobs[i]->GetBatchLength() != 1 ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+CPtr<CDnnBlob> CRecurrentLayer::GetBackLinkStartState( CBackLinkLayer& backLink, int inputNumber )
+{
+	// The same rules as in CBackLinkLayer::RunOnce
+	if( isReverseSequence ) {
+		backLink.RestartSequence();
+	}
+	CPtr<CDnnBlob> result = inputNumber < inputBlobs.Size() && backLink.isProcessingFirstPosition
+		? inputBlobs[inputNumber] : backLink.CaptureSink()->GetBlob();
+	backLink.isProcessingFirstPosition = false;
+
+	CheckArchitecture( result->GetDataSize() == inputBlobs[0]->GetBatchWidth() * backLink.GetDimSize( BD_Channels ),
+		GetName(), "the back link state has incorrect size" );
+	return result;
+}
+
+void CRecurrentLayer::SetBackLinkEndState( CBackLinkLayer& backLink, const CDnnBlob& sequence )
+{
+	const CPtr<CDnnBlob>& state = backLink.CaptureSink()->GetBlob();
+	NeoAssert( state != nullptr );
+	const int stateSize = state->GetDataSize();
+	NeoAssert( sequence.GetDataSize() == sequence.GetBatchLength() * stateSize );
+
+	const int lastPos = isReverseSequence ? 0 : sequence.GetBatchLength() - 1;
+	MathEngine().VectorCopy( state->GetData(), sequence.GetData() + lastPos * stateSize, stateSize );
+}
+
 void CRecurrentLayer::serializationHook(CArchive& archive)
 {
 	if( archive.IsStoring() ) {
@@ -102,6 +102,15 @@ void CTransposedConvLayer::LearnOnce()
 		MathEngine().BlobConvolutionLearnAdd( *convDesc, outputDiffBlobs[i]->GetData(), inputBlobs[i]->GetData(),
 			FilterDiff()->GetData(), IsZeroFreeTerm() ? 0 : &freeTermDiff, true );
 	}
+	// The solver changes the filter after the learning step
+	OnFilterChanged();
+}
+
+void CTransposedConvLayer::OnFilterChanged()
+{
+	if( convDesc != 0 ) {
+		convDesc->ResetFilterCache();
+	}
 }
 
 void CTransposedConvLayer::destroyConvDesc()
@@ -0,0 +1,265 @@
+/* Copyright © 2017-2021 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+
+#include <common.h>
+#pragma hdrstop
+
+#include <NeoML/NeoMLDefs.h>
+#include <NeoML/MappedArchiveFile.h>
+
+#if FINE_PLATFORM( FINE_WINDOWS )
+// Windows.h is already included
+#elif FINE_PLATFORM( FINE_LINUX ) || FINE_PLATFORM( FINE_DARWIN ) || FINE_PLATFORM( FINE_IOS ) || FINE_PLATFORM( FINE_ANDROID )
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#error Unknown platform
+#endif
+
+namespace NeoML {
+
+// Generates an exception with the last system error code if the condition is not fulfilled
+static inline void checkMappedFileError( bool condition, const CString& fileName )
+{
+	if( !condition ) {
+#if FINE_PLATFORM( FINE_WINDOWS )
+		const int errorCode = static_cast<int>( ::GetLastError() );
+#else
+		const int errorCode = errno;
+#endif
+#ifdef NEOML_USE_FINEOBJ
+		ThrowFileException( errorCode, fileName.CreateUnicodeString( CP_UTF8 ) );
+#else
+		ThrowFileException( errorCode, fileName );
+#endif
+	}
+}
+
+CMappedFileData::CMappedFileData( const char* _fileName ) :
+	fileName( _fileName ),
+	data( nullptr ),
+	size( 0 ),
+	mappingHandle( nullptr )
+{
+#if FINE_PLATFORM( FINE_WINDOWS )
+	HANDLE file = ::CreateFileA( fileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL, nullptr );
+	checkMappedFileError( file != INVALID_HANDLE_VALUE, fileName );
+
+	LARGE_INTEGER fileSize;
+	if( ::GetFileSizeEx( file, &fileSize ) == 0 ) {
+		::CloseHandle( file );
+		checkMappedFileError( false, fileName );
+	}
+	size = fileSize.QuadPart;
+	if( size > 0 ) {
+		// The mapping object keeps the file open until it is closed
+		mappingHandle = ::CreateFileMappingA( file, nullptr, PAGE_READONLY, 0, 0, nullptr );
+		::CloseHandle( file );
+		checkMappedFileError( mappingHandle != nullptr, fileName );
+		data = static_cast<const char*>( ::MapViewOfFile( mappingHandle, FILE_MAP_READ, 0, 0, 0 ) );
+		if( data == nullptr ) {
+			::CloseHandle( mappingHandle );
+			checkMappedFileError( false, fileName );
+		}
+	} else {
+		::CloseHandle( file );
+	}
+#else
+	const int file = ::open( fileName, O_RDONLY );
+	checkMappedFileError( file != -1, fileName );
+
+	struct stat fileStat;
+	if( ::fstat( file, &fileStat ) != 0 ) {
+		::close( file );
+		checkMappedFileError( false, fileName );
+	}
+	size = static_cast<__int64>( fileStat.st_size );
+	if( size > 0 ) {
+		// The mapping keeps a reference to the file, so the descriptor is not needed after that
+		void* ptr = ::mmap( nullptr, static_cast<size_t>( size ), PROT_READ, MAP_SHARED, file, 0 );
+		::close( file );
+		checkMappedFileError( ptr != MAP_FAILED, fileName );
+		data = static_cast<const char*>( ptr );
+	} else {
+		::close( file );
+	}
+#endif
+}
+
+CMappedFileData::~CMappedFileData()
+{
+	if( data == nullptr ) {
+		return;
+	}
+#if FINE_PLATFORM( FINE_WINDOWS )
+	::UnmapViewOfFile( data );
+	::CloseHandle( mappingHandle );
+#else
+	::munmap( const_cast<char*>( data ), static_cast<size_t>( size ) );
+#endif
+}
+
+//------------------------------------------------------------------------------------------------------------
+
+CMappedArchiveFile::CMappedArchiveFile( const char* fileName ) :
+	position( 0 )
+{
+	Open( fileName );
+}
+
+void CMappedArchiveFile::Open( const char* fileName )
+{
+	NeoAssert( !IsOpen() );
+	mapping = FINE_DEBUG_NEW CMappedFileData( fileName );
+	position = 0;
+}
+
+#ifdef FINEOBJ_VERSION
+CUnicodeString CMappedArchiveFile::GetFileName() const
+{
+	return IsOpen() ? CString( mapping->GetFileName() ).CreateUnicodeString( CP_UTF8 ) : CUnicodeString();
+}
+#else
+const char* CMappedArchiveFile::GetFileName() const
+{
+	return IsOpen() ? mapping->GetFileName() : "";
+}
+#endif
+
+int CMappedArchiveFile::Read( void* buffer, int bytesCount )
+{
+	NeoAssert( IsOpen() );
+	NeoAssert( bytesCount >= 0 );
+	const int bytesRead = static_cast<int>( min( static_cast<__int64>( bytesCount ), mapping->GetSize() - position ) );
+	if( bytesRead > 0 ) {
+		::memcpy( buffer, mapping->GetData() + position, bytesRead );
+		position += bytesRead;
+	}
+	return max( bytesRead, 0 );
+}
+
+void CMappedArchiveFile::Write( const void*, int )
+{
+	NeoAssert( false );
+}
+
+__int64 CMappedArchiveFile::GetPosition() const
+{
+	NeoAssert( IsOpen() );
+	return position;
+}
+
+__int64 CMappedArchiveFile::Seek( __int64 offset, TSeekPosition from )
+{
+	NeoAssert( IsOpen() );
+	__int64 newPosition = offset;
+	switch( from ) {
+		case begin:
+			break;
+		case current:
+			newPosition += position;
+			break;
+		case end:
+			newPosition += mapping->GetSize();
+			break;
+		default:
+			NeoAssert( false );
+	}
+	NeoAssert( newPosition >= 0 );
+	position = newPosition;
+	return position;
+}
+
+void CMappedArchiveFile::SetLength( __int64 )
+{
+	NeoAssert( false );
+}
+
+__int64 CMappedArchiveFile::GetLength() const
+{
+	NeoAssert( IsOpen() );
+	return mapping->GetSize();
+}
+
+void CMappedArchiveFile::Abort()
+{
+	mapping = nullptr;
+	position = 0;
+}
+
+void CMappedArchiveFile::Flush()
+{
+	// Nothing to write
+}
+
+void CMappedArchiveFile::Close()
+{
+	mapping = nullptr;
+	position = 0;
+}
+
+bool CMappedArchiveFile::IsEndOfFile() const
+{
+	NeoAssert( IsOpen() );
+	return position >= mapping->GetSize();
+}
+
+//---------------------------------------------------------------------------------------------------------
+
+void WriteMappedDataPadding( CArchive& archive )
+{
+	static const char zeros[MappedDataAlignment] = {};
+	// The padding size itself takes one byte
+	const int padding = static_cast<int>( ( MappedDataAlignment - ( archive.GetPosition() + 1 ) % MappedDataAlignment )
+		% MappedDataAlignment );
+	archive << static_cast<unsigned char>( padding );
+	archive.Write( zeros, padding );
+}
+
+void ReadMappedDataPadding( CArchive& archive )
+{
+	unsigned char padding = 0;
+	archive >> padding;
+	check( padding < MappedDataAlignment, ERR_BAD_ARCHIVE, archive.Name() );
+	archive.Skip( padding );
+}
+
+const char* SkipMappedData( CArchive& archive, __int64 dataSize, CPtr<CMappedFileData>& mapping )
+{
+	CMappedArchiveFile* file = dynamic_cast<CMappedArchiveFile*>( archive.GetFile() );
+	if( file == nullptr ) {
+		return nullptr;
+	}
+	mapping = file->GetMapping();
+	// The file position depends on how much of the data is already in the archive buffer,
+	// so the offset is calculated from the archive position and the archive beginning in the file
+	const __int64 archiveBegin = file->GetLength() - archive.GetLength();
+	const __int64 dataOffset = archiveBegin + archive.GetPosition();
+	// CArchive::Skip takes an int, so the larger data is skipped by parts
+	for( __int64 skipped = 0; skipped < dataSize; ) {
+		const int partSize = static_cast<int>( min<__int64>( dataSize - skipped, INT_MAX ) );
+		archive.Skip( partSize );
+		skipped += partSize;
+	}
+	check( dataOffset >= 0 && dataOffset + dataSize <= mapping->GetSize(), ERR_BAD_ARCHIVE, archive.Name() );
+	return mapping->GetData() + dataOffset;
+}
+
+} // namespace NeoML
@@ -19,6 +19,7 @@ limitations under the License.
 #include <NeoML/NeoMLDefs.h>
 #include <NeoML/TraditionalML/Model.h>
 #include <NeoML/TraditionalML/TrainingModel.h>
+#include <NeoMathEngine/OpenMP.h>
 
 namespace NeoML {
 
@@ -29,14 +30,71 @@ IModel::~IModel()
 {
 }
 
+bool IModel::ClassifyBatch( const CFloatMatrixDesc& data, CArray<CClassificationResult>& results, int threadCount ) const
+{
+	NeoAssert( threadCount > 0 );
+	results.SetSize( data.Height );
+
+	CArray<bool> isSucceeded;
+	isSucceeded.Add( true, threadCount );
+	NEOML_OMP_NUM_THREADS( threadCount ) {
+		int firstVector = 0;
+		int vectorCount = 0;
+		if( OmpGetTaskIndexAndCount( data.Height, firstVector, vectorCount ) ) {
+			const int lastVector = firstVector + vectorCount;
+			for( int i = firstVector; i < lastVector; i++ ) {
+				if( !Classify( data.GetRow( i ), results[i] ) ) {
+					isSucceeded[OmpGetThreadNum()] = false;
+				}
+			}
+		}
+	}
+	return isSucceeded.Find( false ) == NotFound;
+}
+
 IRegressionModel::~IRegressionModel()
 {
 }
 
+void IRegressionModel::PredictBatch( const CFloatMatrixDesc& data, CArray<double>& results, int threadCount ) const
+{
+	NeoAssert( threadCount > 0 );
+	results.SetSize( data.Height );
+
+	NEOML_OMP_NUM_THREADS( threadCount ) {
+		int firstVector = 0;
+		int vectorCount = 0;
+		if( OmpGetTaskIndexAndCount( data.Height, firstVector, vectorCount ) ) {
+			const int lastVector = firstVector + vectorCount;
+			for( int i = firstVector; i < lastVector; i++ ) {
+				results[i] = Predict( data.GetRow( i ) );
+			}
+		}
+	}
+}
+
 IMultivariateRegressionModel::~IMultivariateRegressionModel()
 {
 }
 
+void IMultivariateRegressionModel::MultivariatePredictBatch( const CFloatMatrixDesc& data, CArray<CFloatVector>& results,
+	int threadCount ) const
+{
+	NeoAssert( threadCount > 0 );
+	results.SetSize( data.Height );
+
+	NEOML_OMP_NUM_THREADS( threadCount ) {
+		int firstVector = 0;
+		int vectorCount = 0;
+		if( OmpGetTaskIndexAndCount( data.Height, firstVector, vectorCount ) ) {
+			const int lastVector = firstVector + vectorCount;
+			for( int i = firstVector; i < lastVector; i++ ) {
+				results[i] = MultivariatePredict( data.GetRow( i ) );
+			}
+		}
+	}
+}
+
 ITrainingModel::~ITrainingModel()
 {
 }
@@ -0,0 +1,127 @@
+/* Copyright © 2017-2020 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <CpuFeatures.h>
+#include <NeoMathEngine/NeoMathEngineDefs.h>
+
+#ifdef NEOML_USE_SSE
+#if FINE_PLATFORM( FINE_WINDOWS )
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif // NEOML_USE_SSE
+
+namespace NeoML {
+
+#ifdef NEOML_USE_SSE
+
+// Calls cpuid for the given leaf and subleaf; regs are eax, ebx, ecx, edx
+static void callCpuId( unsigned int leaf, unsigned int subleaf, unsigned int regs[4] )
+{
+#if FINE_PLATFORM( FINE_WINDOWS )
+	int result[4] = { 0, 0, 0, 0 };
+	__cpuidex( result, static_cast<int>( leaf ), static_cast<int>( subleaf ) );
+	for( int i = 0; i < 4; i++ ) {
+		regs[i] = static_cast<unsigned int>( result[i] );
+	}
+#else
+	regs[0] = regs[1] = regs[2] = regs[3] = 0;
+	if( leaf <= __get_cpuid_max( 0, nullptr ) ) {
+		__cpuid_count( leaf, subleaf, regs[0], regs[1], regs[2], regs[3] );
+	}
+#endif
+}
+
+// Checks that the OS saves all the given state components (XCR0 bits)
+static bool isOsStateEnabled( unsigned long long stateBits )
+{
+	unsigned int regs[4];
+	callCpuId( 1, 0, regs );
+	// osxsave
+	if( ( regs[2] & ( 1u << 27 ) ) == 0 ) {
+		return false;
+	}
+#if FINE_PLATFORM( FINE_WINDOWS )
+	const unsigned long long xcr0 = _xgetbv( 0 );
+#else
+	unsigned int eax = 0;
+	unsigned int edx = 0;
+	__asm__ __volatile__( "xgetbv" : "=a"( eax ), "=d"( edx ) : "c"( 0 ) );
+	const unsigned long long xcr0 = ( static_cast<unsigned long long>( edx ) << 32 ) | eax;
+#endif
+	return ( xcr0 & stateBits ) == stateBits;
+}
+
+static bool checkAvx2()
+{
+	unsigned int regs[4];
+	callCpuId( 1, 0, regs );
+	// fma and avx bits in ECX
+	const unsigned int FmaAndAvxBits = ( 1u << 12 ) + ( 1u << 28 );
+	if( ( regs[2] & FmaAndAvxBits ) != FmaAndAvxBits ) {
+		return false;
+	}
+	// avx2 bit in EBX
+	callCpuId( 7, 0, regs );
+	if( ( regs[1] & ( 1u << 5 ) ) == 0 ) {
+		return false;
+	}
+	// The XMM and YMM state
+	return isOsStateEnabled( 0x6 );
+}
+
+static bool checkAvx512()
+{
+	unsigned int regs[4];
+	callCpuId( 7, 0, regs );
+	// avx512_f bit in EBX
+	if( ( regs[1] & ( 1u << 16 ) ) == 0 ) {
+		return false;
+	}
+	// The XMM, YMM, opmask, ZMM_Hi256 and Hi16_ZMM state
+	return isOsStateEnabled( 0xE6 );
+}
+
+bool IsAvx2Available()
+{
+	static const bool isAvailable = checkAvx2();
+	return isAvailable;
+}
+
+bool IsAvx512Available()
+{
+	static const bool isAvailable = checkAvx512();
+	return isAvailable;
+}
+
+#else // NEOML_USE_SSE
+
+bool IsAvx2Available()
+{
+	return false;
+}
+
+bool IsAvx512Available()
+{
+	return false;
+}
+
+#endif // NEOML_USE_SSE
+
+} // namespace NeoML
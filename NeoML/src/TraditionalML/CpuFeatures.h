@@ -0,0 +1,30 @@
+/* Copyright © 2017-2020 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+
+namespace NeoML {
+
+// The checks of the instruction sets used by the SIMD kernels of the algorithms
+// Both the processor and the OS (which saves the registers when switching contexts) must support the set
+// Always false if the kernels for the set are not compiled
+
+// AVX2 and FMA
+bool IsAvx2Available();
+
+// AVX-512 Foundation
+bool IsAvx512Available();
+
+} // namespace NeoML
@@ -17,6 +17,7 @@ limitations under the License.
 #pragma hdrstop
 
 #include <DecisionTreeClassificationModel.h>
+#include <NeoMathEngine/OpenMP.h>
 
 namespace NeoML {
 
@@ -158,6 +159,31 @@ bool CDecisionTreeClassificationModel::Classify( const CFloatVectorDesc& data, C
 	return classify( node, result );
 }
 
+bool CDecisionTreeClassificationModel::ClassifyBatch( const CFloatMatrixDesc& data,
+	CArray<CClassificationResult>& results, int threadCount ) const
+{
+	NeoAssert( threadCount > 0 );
+	results.SetSize( data.Height );
+
+	CArray<bool> isSucceeded;
+	isSucceeded.Add( true, threadCount );
+	NEOML_OMP_NUM_THREADS( threadCount ) {
+		int firstVector = 0;
+		int vectorCount = 0;
+		if( OmpGetTaskIndexAndCount( data.Height, firstVector, vectorCount ) ) {
+			const int lastVector = firstVector + vectorCount;
+			CFloatVectorDesc row;
+			for( int i = firstVector; i < lastVector; i++ ) {
+				data.GetRow( i, row );
+				if( !classify( GetClassifyNode( row ), results[i] ) ) {
+					isSucceeded[OmpGetThreadNum()] = false;
+				}
+			}
+		}
+	}
+	return isSucceeded.Find( false ) == NotFound;
+}
+
 void CDecisionTreeClassificationModel::Serialize( CArchive& archive )
 {
 	archive.SerializeVersion( 0 );
@@ -230,7 +256,7 @@ void CDecisionTreeClassificationModel::Serialize( CArchive& archive )
 }
 
 // Performs classification in a node
-bool CDecisionTreeClassificationModel::classify( CDecisionTreeNodeBase* node, CClassificationResult& result ) const
+bool CDecisionTreeClassificationModel::classify( const CDecisionTreeNodeBase* node, CClassificationResult& result ) const
 {
 	NeoAssert( node != 0 );
 	NeoAssert( node->GetInfo() != 0 );
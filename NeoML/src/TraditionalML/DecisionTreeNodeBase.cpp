@@ -83,6 +83,35 @@ void CDecisionTreeNodeBase::GetClassifyNode( const CFloatVector& data, CPtr<CDec
 	GetClassifyNode( data.GetDesc(), node, additionalLevel );
 }
 
+const CDecisionTreeNodeBase* CDecisionTreeNodeBase::GetClassifyNode( const CFloatVectorDesc& data ) const
+{
+	const CDecisionTreeNodeBase* node = this;
+	while( node->info != 0 ) {
+		if( node->info->Type == DTNT_Discrete ) {
+			const CDecisionTreeDiscreteNodeInfo* discreteInfo = static_cast<const CDecisionTreeDiscreteNodeInfo*>( node->info );
+			float featureValue = 0;
+			GetValue( data, discreteInfo->FeatureIndex, featureValue );
+
+			const int childIndex = discreteInfo->Values.Find( featureValue );
+			if( childIndex == NotFound ) {
+				return node;
+			}
+			node = discreteInfo->Children[childIndex];
+		} else if( node->info->Type == DTNT_Continuous ) {
+			const CDecisionTreeContinuousNodeInfo* continuousInfo = static_cast<const CDecisionTreeContinuousNodeInfo*>( node->info );
+			float featureValue = 0;
+			GetValue( data, continuousInfo->FeatureIndex, featureValue );
+
+			node = featureValue <= continuousInfo->Threshold ? continuousInfo->Child1.Ptr() : continuousInfo->Child2.Ptr();
+			NeoAssert( node != 0 );
+		} else {
+			NeoAssert( node->info->Type == DTNT_Const || node->info->Type == DTNT_Undefined );
+			return node;
+		}
+	}
+	return node;
+}
+
 CDecisionTreeNodeBase::~CDecisionTreeNodeBase()
 {
 	if( info != 0 ) {
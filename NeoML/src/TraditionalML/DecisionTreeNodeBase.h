@@ -41,6 +41,9 @@ public:
 	// Gets the node to be used for classification
 	void GetClassifyNode( const CFloatVectorDesc& data, CPtr<CDecisionTreeNodeBase>& node, int& level ) const;
 	void GetClassifyNode( const CFloatVector& data, CPtr<CDecisionTreeNodeBase>& node, int& level ) const;
+	// Gets the node to be used for classification without touching the reference counters
+	// (faster when the same tree is used by several threads)
+	const CDecisionTreeNodeBase* GetClassifyNode( const CFloatVectorDesc& data ) const;
 
 protected:
 	virtual ~CDecisionTreeNodeBase(); // delete operator prohibited
@@ -22,6 +22,11 @@ limitations under the License.
 
 namespace NeoML {
 
+// The maximum number of histogram elements in a feature block (a block should fit into the cache)
+static const int MaxFeatureBlockSize = 8 * 1024;
+// The approximate cost of looking for the feature block start in a vector (relative to adding a value to the histogram)
+static const int FeatureBlockSearchCost = 8;
+
 template<class T>
 CGradientBoostFastHistTreeBuilder<T>::CGradientBoostFastHistTreeBuilder( const CGradientBoostFastHistTreeBuilderParams& _params, CTextStream* _logStream, int _predictionSize ) :
 	params( _params ),
@@ -152,6 +157,7 @@ void CGradientBoostFastHistTreeBuilder<T>::initHistData( const CGradientBoostFas
 	idPos.Add( NotFound, featurePos.Last() );
 	histSize = 0;
 	for( int i = 0; i < usedFeatures.Size(); i++ ) {
+		NeoPresume( i == 0 || usedFeatures[i - 1] < usedFeatures[i] );
 		const int featureIndex = usedFeatures[i];
 		for( int j = featurePos[featureIndex]; j < featurePos[featureIndex + 1]; j++ ) {
 			idPos[j] = histSize;
@@ -159,6 +165,22 @@ void CGradientBoostFastHistTreeBuilder<T>::initHistData( const CGradientBoostFas
 		}
 	}
 
+	// Splitting the features into blocks that may be processed independently
+	// Each thread gets at least one block, and a block is not larger than MaxFeatureBlockSize
+	const int blockSize = max( 1, min( ( histSize + params.ThreadCount - 1 ) / params.ThreadCount,
+		MaxFeatureBlockSize / T( predictionSize ).ValueSize() ) );
+	featureBlocks.Empty();
+	featureBlocks.Add( 0 );
+	int currentBlockSize = 0;
+	for( int i = 0; i < usedFeatures.Size(); i++ ) {
+		const int featureIndex = usedFeatures[i];
+		currentBlockSize += featurePos[featureIndex + 1] - featurePos[featureIndex];
+		if( currentBlockSize >= blockSize || i == usedFeatures.Size() - 1 ) {
+			featureBlocks.Add( i + 1 );
+			currentBlockSize = 0;
+		}
+	}
+
 	// The histogram size of tree depth + 1 is sufficient
 	histStats.Add( T( predictionSize ), histSize * ( params.MaxTreeDepth + 1 ) );
 	freeHists.Empty();
@@ -191,6 +213,7 @@ void CGradientBoostFastHistTreeBuilder<T>::freeHist( int ptr )
 template<class T>
 void CGradientBoostFastHistTreeBuilder<T>::subHist( int firstPtr, int secondPtr )
 {
+	NEOML_OMP_FOR_NUM_THREADS( histSize > MaxFeatureBlockSize ? params.ThreadCount : 1 )
 	for( int i = 0; i < histSize; i++ ) {
 		histStats[firstPtr + i].Sub( histStats[secondPtr + i] );
 	}
@@ -203,6 +226,7 @@ void CGradientBoostFastHistTreeBuilder<T>::buildHist( const CGradientBoostFastHi
 	T& totalStats )
 {
 	T* histStatsPtr = histStats.GetPtr() + node.HistPtr;
+	NEOML_OMP_FOR_NUM_THREADS( histSize > MaxFeatureBlockSize ? params.ThreadCount : 1 )
 	for( int i = 0; i < histSize; i++ ) {
 		histStatsPtr[i].Erase();
 	}
@@ -210,45 +234,15 @@ void CGradientBoostFastHistTreeBuilder<T>::buildHist( const CGradientBoostFastHi
 	totalStats.SetSize( predictionSize );
 	totalStats.Erase();
 
-	const bool isOmp = ( node.VectorSetSize > 4 * params.ThreadCount ); // check if using OpenMP makes sense
-	if( isOmp ) {
+	// check if using OpenMP makes sense
+	const bool isOmp = ( params.ThreadCount > 1 && node.VectorSetSize > 4 * params.ThreadCount );
+	if( isOmp && static_cast<int64_t>( node.VectorSetSize ) * FeatureBlockSearchCost < histSize ) {
+		// The histogram is large compared to the number of vectors
+		// Merging the per-thread histograms would take more time than building them, so split the histogram instead
+		buildHistByFeatures( problem, node, gradients, hessians, weights, totalStats );
+	} else if( isOmp ) {
 		// There are many vectors in the set, so we'll use several threads to build the histogram
-		CArray<T> results;
-		results.Add( T( predictionSize ), params.ThreadCount );
-
-		const int valueSize = histStatsPtr[0].ValueSize();
-		tempHistStats.SetSize( params.ThreadCount * histSize );
-		for( int i = 0; i < params.ThreadCount * histSize; i++ ) {
-			tempHistStats[i].SetSize( valueSize );
-			tempHistStats[i].Erase();
-		}
-
-		NEOML_OMP_NUM_THREADS(params.ThreadCount)
-		{
-			const int threadNumber = OmpGetThreadNum();
-			NeoAssert( threadNumber < params.ThreadCount );
-			int i = threadNumber;
-			while( i < node.VectorSetSize ) {
-				const int vectorIndex = vectorSet[node.VectorSetPtr + i];
-				addVectorToHist( problem.GetUsedVectorDataPtr( vectorIndex ), problem.GetUsedVectorDataSize( vectorIndex ),
-					gradients, hessians, weights, tempHistStats.GetPtr() + histSize * threadNumber, vectorIndex );
-				results[threadNumber].Add( gradients, hessians, weights, vectorIndex );
-				i += params.ThreadCount;
-			}
-		}
-
-		// Merge the threads' results
-		for( int i = 0; i < params.ThreadCount; i++ ) {
-			totalStats.Add( results[i] );
-		}
-
-		NEOML_OMP_FOR_NUM_THREADS( params.ThreadCount )
-		for( int i = 0; i < histSize; i++ ) {
-			for( int j = 0; j < params.ThreadCount; j++ ) {
-				const int index = j * histSize + i;
-				histStatsPtr[i].Add( tempHistStats[index] );
-			}
-		}
+		buildHistByVectors( problem, node, gradients, hessians, weights, totalStats );
 	} else {
 		// There are few vectors in the set, build the histogram using only one thread
 		for( int i = 0; i < node.VectorSetSize; i++ ) {
@@ -276,6 +270,98 @@ void CGradientBoostFastHistTreeBuilder<T>::buildHist( const CGradientBoostFastHi
 	}
 }
 
+// Builds the histogram dividing the vectors between the threads
+// Each thread builds a separate histogram, then the histograms are merged
+template<class T>
+void CGradientBoostFastHistTreeBuilder<T>::buildHistByVectors( const CGradientBoostFastHistProblem& problem, const CNode& node,
+	const CArray<typename T::Type>& gradients, const CArray<typename T::Type>& hessians, const CArray<double>& weights,
+	T& totalStats )
+{
+	T* histStatsPtr = histStats.GetPtr() + node.HistPtr;
+
+	CArray<T> results;
+	results.Add( T( predictionSize ), params.ThreadCount );
+
+	const int valueSize = histStatsPtr[0].ValueSize();
+	tempHistStats.SetSize( params.ThreadCount * histSize );
+
+	NEOML_OMP_NUM_THREADS( params.ThreadCount )
+	{
+		const int threadNumber = OmpGetThreadNum();
+		NeoAssert( threadNumber < params.ThreadCount );
+		T* threadHistStats = tempHistStats.GetPtr() + histSize * threadNumber;
+		for( int i = 0; i < histSize; i++ ) {
+			threadHistStats[i].SetSize( valueSize );
+			threadHistStats[i].Erase();
+		}
+
+		// Each thread processes a contiguous part of the vector set
+		int start;
+		int count;
+		if( OmpGetTaskIndexAndCount( node.VectorSetSize, start, count ) ) {
+			for( int i = start; i < start + count; i++ ) {
+				const int vectorIndex = vectorSet[node.VectorSetPtr + i];
+				addVectorToHist( problem.GetUsedVectorDataPtr( vectorIndex ), problem.GetUsedVectorDataSize( vectorIndex ),
+					gradients, hessians, weights, threadHistStats, vectorIndex );
+				results[threadNumber].Add( gradients, hessians, weights, vectorIndex );
+			}
+		}
+	}
+
+	// Merge the threads' results
+	for( int i = 0; i < params.ThreadCount; i++ ) {
+		totalStats.Add( results[i] );
+	}
+
+	NEOML_OMP_FOR_NUM_THREADS( params.ThreadCount )
+	for( int i = 0; i < histSize; i++ ) {
+		for( int j = 0; j < params.ThreadCount; j++ ) {
+			const int index = j * histSize + i;
+			histStatsPtr[i].Add( tempHistStats[index] );
+		}
+	}
+}
+
+// Builds the histogram dividing the features between the threads
+// Each thread goes through all vectors of the set but fills only the part of the histogram for its feature block
+// The feature values of a vector are sorted so the block start in the vector is found by binary search
+template<class T>
+void CGradientBoostFastHistTreeBuilder<T>::buildHistByFeatures( const CGradientBoostFastHistProblem& problem, const CNode& node,
+	const CArray<typename T::Type>& gradients, const CArray<typename T::Type>& hessians, const CArray<double>& weights,
+	T& totalStats )
+{
+	T* histStatsPtr = histStats.GetPtr() + node.HistPtr;
+	const CArray<int>& usedFeatures = problem.GetUsedFeatures();
+	const CArray<int>& featurePos = problem.GetFeaturePos();
+	const int blockCount = featureBlocks.Size() - 1;
+
+	NEOML_OMP_FOR_NUM_THREADS( params.ThreadCount )
+	for( int block = 0; block < blockCount; block++ ) {
+		// The range of feature value identifiers that belong to the block
+		const int firstId = featurePos[usedFeatures[featureBlocks[block]]];
+		const int lastId = featurePos[usedFeatures[featureBlocks[block + 1] - 1] + 1];
+
+		for( int i = 0; i < node.VectorSetSize; i++ ) {
+			const int vectorIndex = vectorSet[node.VectorSetPtr + i];
+			const int* vectorPtr = problem.GetUsedVectorDataPtr( vectorIndex );
+			const int vectorSize = problem.GetUsedVectorDataSize( vectorIndex );
+
+			for( int pos = FindInsertionPoint<int, Ascending<int>, int>( firstId - 1, vectorPtr, vectorSize );
+				pos < vectorSize && vectorPtr[pos] < lastId; pos++ )
+			{
+				const int id = idPos[vectorPtr[pos]];
+				if( id != NotFound ) {
+					histStatsPtr[id].Add( gradients, hessians, weights, vectorIndex );
+				}
+			}
+		}
+	}
+
+	for( int i = 0; i < node.VectorSetSize; i++ ) {
+		totalStats.Add( gradients, hessians, weights, vectorSet[node.VectorSetPtr + i] );
+	}
+}
+
 // Adds a vector to the histogram
 template<class T>
 void CGradientBoostFastHistTreeBuilder<T>::addVectorToHist( const int* vectorPtr, int vectorSize,
@@ -382,12 +468,13 @@ void CGradientBoostFastHistTreeBuilder<T>::applySplit( const CGradientBoostFastH
 	const int nextId = problem.GetFeaturePos()[featureIndex + 1] - 1;
 
 	// Determining to which subtree each vector belongs
+	// Each thread processes a contiguous part of the vector set so that the threads don't write into the same cache lines
 	NEOML_OMP_NUM_THREADS(params.ThreadCount)
 	{
-		const int threadNumber = OmpGetThreadNum();
-		NeoAssert( threadNumber < params.ThreadCount );
-		int i = threadNumber;
-		while( i < vectorCount ) {
+		int start;
+		int count;
+		OmpGetTaskIndexAndCount( vectorCount, start, count );
+		for( int i = start; i < start + count; i++ ) {
 			const int* vectorDataPtr = problem.GetUsedVectorDataPtr( vectorSet[vectorPtr + i] );
 			const int vectorDataSize = problem.GetUsedVectorDataSize( vectorSet[vectorPtr + i] );
 
@@ -404,8 +491,6 @@ void CGradientBoostFastHistTreeBuilder<T>::applySplit( const CGradientBoostFastH
 				// The vector belongs to the left subtree
 				vectorSet[vectorPtr + i] = -( vectorSet[vectorPtr + i] + 1 );
 			} // To the right subtree otherwise (no action needed)
-
-			i += params.ThreadCount;
 		}
 	}
 
@@ -87,6 +87,7 @@ private:
 	CArray<int> freeHists; // free histograms list
 	CArray<T> histStats; // the array for storing histograms
 	CArray<int> idPos; // the identifier positions in the current histogram
+	CArray<int> featureBlocks; // the bounds of the feature blocks (the indices in the used features array)
 	CArray<T> tempHistStats; // a temporary array for building histograms
 
 	// Caching the buffers
@@ -101,6 +102,12 @@ private:
 	void buildHist( const CGradientBoostFastHistProblem& problem, const CNode& node,
 		const CArray<typename T::Type>& gradients, const CArray<typename T::Type>& hessians, const CArray<double>& weights,
 		T& stats );
+	void buildHistByVectors( const CGradientBoostFastHistProblem& problem, const CNode& node,
+		const CArray<typename T::Type>& gradients, const CArray<typename T::Type>& hessians, const CArray<double>& weights,
+		T& stats );
+	void buildHistByFeatures( const CGradientBoostFastHistProblem& problem, const CNode& node,
+		const CArray<typename T::Type>& gradients, const CArray<typename T::Type>& hessians, const CArray<double>& weights,
+		T& stats );
 	void addVectorToHist( const int* vectorPtr, int vectorSize, const CArray<typename T::Type>& gradients, 
 		const CArray<typename T::Type>& hessians, const CArray<double>& weights, T* stats, int vectorIndex );
 	int evaluateSplit( const CGradientBoostFastHistProblem& problem, const CNode& node ) const;
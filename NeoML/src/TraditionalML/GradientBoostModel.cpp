@@ -18,6 +18,7 @@ limitations under the License.
 
 #include <GradientBoostModel.h>
 #include <CompactRegressionTree.h>
+#include <NeoMathEngine/OpenMP.h>
 
 namespace NeoML {
 
@@ -52,6 +53,16 @@ bool CGradientBoostModel::Classify( const CFloatVectorDesc& data, CClassificatio
 	return classify( predictions, result );
 }
 
+bool CGradientBoostModel::ClassifyBatch( const CFloatMatrixDesc& data, CArray<CClassificationResult>& results,
+	int threadCount ) const
+{
+	results.SetSize( data.Height );
+	processBatch( data, threadCount, [&]( int index, CFastArray<double, 1>& predictions ) {
+		classify( predictions, results[index] );
+	} );
+	return true;
+}
+
 void CGradientBoostModel::Serialize( CArchive& archive )
 {
 #ifdef NEOML_USE_FINEOBJ
@@ -243,6 +254,15 @@ double CGradientBoostModel::Predict( const CFloatVectorDesc& data ) const
 	return predictions[0];
 }
 
+void CGradientBoostModel::PredictBatch( const CFloatMatrixDesc& data, CArray<double>& results, int threadCount ) const
+{
+	NeoAssert( ensembles.Size() == 1 && valueSize == 1 );
+	results.SetSize( data.Height );
+	processBatch( data, threadCount, [&]( int index, CFastArray<double, 1>& predictions ) {
+		results[index] = predictions[0];
+	} );
+}
+
 // IMultivariateRegressionModel interface method
 CFloatVector CGradientBoostModel::MultivariatePredict( const CFloatVectorDesc& data ) const
 {
@@ -269,6 +289,104 @@ CFloatVector CGradientBoostModel::MultivariatePredict( const CFloatVectorDesc& d
 	return result;
 }
 
+void CGradientBoostModel::MultivariatePredictBatch( const CFloatMatrixDesc& data, CArray<CFloatVector>& results,
+	int threadCount ) const
+{
+	results.SetSize( data.Height );
+	processBatch( data, threadCount, [&]( int index, CFastArray<double, 1>& predictions ) {
+		results[index] = CFloatVector( predictions.Size() );
+		float* resultPtr = results[index].CopyOnWrite();
+		for( int i = 0; i < predictions.Size(); i++ ) {
+			resultPtr[i] = static_cast<float>( predictions[i] );
+		}
+	} );
+}
+
+// The number of vectors processed together by each tree of the ensemble
+static const int GradientBoostBatchSize = 64;
+
+// Calculates the predictions of the ensembles on the vectors [firstVector, firstVector + vectorCount)
+// The trees are applied one by one to all the vectors so that each tree is read from memory once per batch
+// The predictions are stored vector by vector, getPredictionSize() values for each vector
+void CGradientBoostModel::predictRawBatch( const CFloatMatrixDesc& data, int firstVector, int vectorCount,
+	double* predictions ) const
+{
+	NeoAssert( vectorCount <= GradientBoostBatchSize );
+	const int predictionSize = getPredictionSize();
+
+	CFloatVectorDesc rows[GradientBoostBatchSize];
+	for( int i = 0; i < vectorCount; i++ ) {
+		data.GetRow( firstVector + i, rows[i] );
+	}
+	for( int i = 0; i < vectorCount * predictionSize; i++ ) {
+		predictions[i] = 0;
+	}
+
+	if( ensembles.Size() > 1 || valueSize == 1 ) {
+		// Each ensemble calculates a single value
+		for( int e = 0; e < ensembles.Size(); e++ ) {
+			const CGradientBoostEnsemble& ensemble = ensembles[e];
+			for( int t = 0; t < ensemble.Size(); t++ ) {
+				const CRegressionTree* tree = static_cast<const CRegressionTree*>( ensemble[t].Ptr() );
+				for( int i = 0; i < vectorCount; i++ ) {
+					predictions[i * predictionSize + e] += tree->Predict( rows[i] );
+				}
+			}
+		}
+	} else {
+		// The only ensemble of the multi-value trees
+		CRegressionTree::CPrediction pred;
+		const CGradientBoostEnsemble& ensemble = ensembles[0];
+		for( int t = 0; t < ensemble.Size(); t++ ) {
+			const CRegressionTree* tree = static_cast<const CRegressionTree*>( ensemble[t].Ptr() );
+			for( int i = 0; i < vectorCount; i++ ) {
+				tree->Predict( rows[i], pred );
+				NeoPresume( pred.Size() == predictionSize );
+				double* vectorPredictions = predictions + i * predictionSize;
+				for( int j = 0; j < predictionSize; j++ ) {
+					vectorPredictions[j] += pred[j];
+				}
+			}
+		}
+	}
+
+	for( int i = 0; i < vectorCount * predictionSize; i++ ) {
+		predictions[i] *= learningRate;
+	}
+}
+
+// Calculates the predictions on all the vectors of the matrix and passes them to process( vectorIndex, predictions )
+template<typename TProcessPrediction>
+void CGradientBoostModel::processBatch( const CFloatMatrixDesc& data, int threadCount,
+	const TProcessPrediction& process ) const
+{
+	NeoAssert( threadCount > 0 );
+	NeoAssert( !ensembles.IsEmpty() );
+	const int predictionSize = getPredictionSize();
+
+	NEOML_OMP_NUM_THREADS( threadCount ) {
+		int firstVector = 0;
+		int vectorCount = 0;
+		if( OmpGetTaskIndexAndCount( data.Height, firstVector, vectorCount ) ) {
+			CArray<double> batchPredictions;
+			batchPredictions.SetSize( GradientBoostBatchSize * predictionSize );
+			CFastArray<double, 1> predictions;
+			const int lastVector = firstVector + vectorCount;
+			for( int batchStart = firstVector; batchStart < lastVector; batchStart += GradientBoostBatchSize ) {
+				const int batchSize = min( GradientBoostBatchSize, lastVector - batchStart );
+				predictRawBatch( data, batchStart, batchSize, batchPredictions.GetPtr() );
+				for( int i = 0; i < batchSize; i++ ) {
+					predictions.SetSize( predictionSize );
+					for( int j = 0; j < predictionSize; j++ ) {
+						predictions[j] = batchPredictions[i * predictionSize + j];
+					}
+					process( batchStart + i, predictions );
+				}
+			}
+		}
+	}
+}
+
 // Performs classification
 bool CGradientBoostModel::classify( CFastArray<double, 1>& predictions, CClassificationResult& result ) const
 {
@@ -39,6 +39,8 @@ public:
 	// IModel interface methods
 	int GetClassCount() const override { return ( valueSize == 1 && ensembles.Size() == 1 ) ? 2 : valueSize * ensembles.Size(); }
 	bool Classify( const CFloatVectorDesc& data, CClassificationResult& result ) const override;
+	bool ClassifyBatch( const CFloatMatrixDesc& data, CArray<CClassificationResult>& results,
+		int threadCount ) const override;
 	void Serialize( CArchive& archive ) override;
 
 	// IGradientBoostModel inteface methods
@@ -53,9 +55,12 @@ public:
 
 	// IRegressionModel interface methods
 	double Predict( const CFloatVectorDesc& data ) const override;
+	void PredictBatch( const CFloatMatrixDesc& data, CArray<double>& results, int threadCount ) const override;
 
 	// IMultivariateRegressionModel interface methods
 	CFloatVector MultivariatePredict( const CFloatVectorDesc& data ) const override;
+	void MultivariatePredictBatch( const CFloatMatrixDesc& data, CArray<CFloatVector>& results,
+		int threadCount ) const override;
 
 private:
 	CArray<CGradientBoostEnsemble> ensembles; // the models
@@ -64,6 +69,10 @@ private:
 	int valueSize; // the value size of each model, if valueSize > 1 then ensemble consists of multiclass trees
 
 	bool classify( CFastArray<double, 1>& predictions, CClassificationResult& result ) const;
+	int getPredictionSize() const { return ensembles.Size() > 1 ? ensembles.Size() : valueSize; }
+	void predictRawBatch( const CFloatMatrixDesc& data, int firstVector, int vectorCount, double* predictions ) const;
+	template<typename TProcessPrediction>
+	void processBatch( const CFloatMatrixDesc& data, int threadCount, const TProcessPrediction& process ) const;
 	double probability( double prediction ) const;
 };
 
@@ -33,6 +33,7 @@ limitations under the License.
 #pragma hdrstop
 
 #include <GradientBoostQSEnsemble.h>
+#include <GradientBoostQSKernels.h>
 #include <SerializeCompact.h>
 
 namespace NeoML {
@@ -339,6 +340,69 @@ double CGradientBoostQSEnsemble::Predict( const CFloatVectorDesc& data, int last
 	return calculateScore( data, resultBitvectors, lastTreeIndex );
 }
 
+void CGradientBoostQSEnsemble::PredictBlocks( const CFloatMatrixDesc& data, int firstRow, int rowCount, double* results ) const
+{
+	NeoAssert( data.Columns == nullptr );
+	NeoAssert( firstRow >= 0 && rowCount >= 0 && firstRow + rowCount <= data.Height );
+
+	const CQSBlockKernels& kernels = GetQSBlockKernels();
+
+	// The features used in the nodes; the rest are not looked at
+	CArray<int> features;
+	CArray<CQSNodeOffset> offsets;
+	for( TMapPosition pos = featureQsNodesOffsets.GetFirstPosition(); pos != NotFound;
+		pos = featureQsNodesOffsets.GetNextPosition( pos ) )
+	{
+		if( featureQsNodesOffsets.GetKey( pos ) < data.Width ) {
+			features.Add( featureQsNodesOffsets.GetKey( pos ) );
+			offsets.Add( featureQsNodesOffsets.GetValue( pos ) );
+		}
+	}
+
+	// The block rows are transposed: QSBlockSize values for each feature
+	CArray<float> blockValues;
+	blockValues.SetSize( data.Width * QSBlockSize );
+	// The bitvectors of the block rows are interleaved: QSBlockSize bitvectors for each tree
+	CArray<unsigned __int64> bitvectors;
+	bitvectors.SetSize( GetTreesCount() * QSBlockSize );
+	float scores[QSBlockSize];
+
+	for( int blockStart = 0; blockStart < rowCount; blockStart += QSBlockSize ) {
+		const int blockSize = min( QSBlockSize, rowCount - blockStart );
+		for( int i = 0; i < blockSize; i++ ) {
+			const float* row = data.Values + data.PointerB[firstRow + blockStart + i];
+			for( int feature = 0; feature < data.Width; feature++ ) {
+				blockValues[feature * QSBlockSize + i] = row[feature];
+			}
+		}
+		// The last block is padded with zero rows
+		for( int i = blockSize; i < QSBlockSize; i++ ) {
+			for( int feature = 0; feature < data.Width; feature++ ) {
+				blockValues[feature * QSBlockSize + i] = 0.f;
+			}
+		}
+		memset( bitvectors.GetPtr(), ~0, bitvectors.Size() * sizeof( unsigned __int64 ) );
+
+		for( int i = 0; i < features.Size(); i++ ) {
+			const float* values = blockValues.GetPtr() + features[i] * QSBlockSize;
+			const CQSNodeOffset& offset = offsets[i];
+			if( offset.Less.Begin != NotFound ) {
+				kernels.ScanLess( qsNodes.GetPtr() + offset.Less.Begin, offset.Less.End - offset.Less.Begin + 1,
+					values, bitvectors.GetPtr() );
+			}
+			if( offset.More.Begin != NotFound ) {
+				kernels.ScanMore( qsNodes.GetPtr() + offset.More.Begin, offset.More.End - offset.More.Begin + 1,
+					values, bitvectors.GetPtr() );
+			}
+		}
+
+		calculateBlockScores( blockValues.GetPtr(), data.Width, bitvectors.GetPtr(), scores );
+		for( int i = 0; i < blockSize; i++ ) {
+			results[blockStart + i] = scores[i];
+		}
+	}
+}
+
 CArchive& operator<<( CArchive& archive, const CGradientBoostQSEnsemble& block )
 {
 	archive.SerializeVersion( 0 );
@@ -777,4 +841,36 @@ double CGradientBoostQSEnsemble::calculateScore( const CFloatVectorDesc& data, c
 	return score;
 }
 
+// Score computation for all the rows of the block, in the same way as calculateScore
+// blockValues are the transposed block rows of featureCount features
+void CGradientBoostQSEnsemble::calculateBlockScores( const float* blockValues, int featureCount,
+	const unsigned __int64* bitvectors, float* scores ) const
+{
+	for( int j = 0; j < QSBlockSize; j++ ) {
+		scores[j] = 0;
+	}
+	for( int i = 0; i < GetTreesCount(); i++ ) {
+		const CQSLeaf* leaves = qsLeaves.GetPtr() + treeQsLeavesOffsets[i];
+		const unsigned __int64* treeBitvectors = bitvectors + i * QSBlockSize;
+		for( int j = 0; j < QSBlockSize; j++ ) {
+			const CQSLeaf& leaf = leaves[findLowestBitIndex( treeBitvectors[j] )];
+			if( leaf.SimpleNodeIndex == NotFound ) {
+				scores[j] += leaf.Value;
+				continue;
+			}
+			int nodeIndex = leaf.SimpleNodeIndex;
+			while( simpleNodes[nodeIndex].Feature != NotFound ) {
+				const int feature = simpleNodes[nodeIndex].Feature;
+				const float value = feature < featureCount ? blockValues[feature * QSBlockSize + j] : 0.f;
+				if( value <= simpleNodes[nodeIndex].Value ) {
+					nodeIndex++;
+				} else {
+					nodeIndex = simpleNodes[nodeIndex].RightChild;
+				}
+			}
+			scores[j] += simpleNodes[nodeIndex].Value;
+		}
+	}
+}
+
 } // namespace NeoML
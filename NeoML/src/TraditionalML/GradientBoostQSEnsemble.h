@@ -16,6 +16,7 @@ limitations under the License.
 #pragma once
 
 #include <NeoML/TraditionalML/GradientBoost.h>
+#include <GradientBoostQSKernels.h>
 
 namespace NeoML {
 
@@ -26,17 +27,6 @@ const unsigned char PM_Inverted = 1; // the node is inverted
 const unsigned char PM_LeftLeaf = 2; // the left child is a leaf in the optimized subtree
 const unsigned char PM_RightLeaf = 4; // the right child is a leaf in the optimized subtree
 
-// The descriptor of an non-leaf node of the subtree to be optimized
-struct CQSNode {
-	unsigned __int64 Mask; // the false nodes mask: has zeros in the positions where the vector cannot possibly belong if the node criterion is false
-	float Threshold; // split threshold
-	short Tree; // the index of the tree in the ensemble
-	char Order; // the order of depth first traversal
-	unsigned char PropertiesMask; // the node properties (inverted or not, is either of the children a leaf in the optimized subtree)
-
-	CQSNode( unsigned __int64 mask, float threshold, int tree, int order, unsigned char propertiesMask );
-};
-
 inline CQSNode::CQSNode( unsigned __int64 mask, float threshold, int tree, int order, unsigned char propertiesMask ) :
 	Mask( mask ),
 	Threshold( threshold ),
@@ -96,6 +86,11 @@ public:
 	// The prediction method that uses only the trees in the 0 to lastTreeIndex range
 	double Predict( const CFloatVectorDesc& data, int lastTreeIndex ) const;
 
+	// Calculates the predictions for the rows of the dense matrix in the firstRow to firstRow + rowCount - 1 range
+	// The rows are processed by blocks of QSBlockSize (V-QuickScorer): each node threshold is compared
+	// with the feature values of all the block rows at once, and the bitvectors of the block are stored together
+	void PredictBlocks( const CFloatMatrixDesc& data, int firstRow, int rowCount, double* results ) const;
+
 	// Gets the number of trees in the ensemble
 	int GetTreesCount() const { return treeQsLeavesOffsets.Size(); };
 
@@ -129,6 +124,8 @@ private:
 
 	void processFeature( int feature, float value, CFastArray<unsigned __int64, 512>& bitvectors ) const;
 	double calculateScore( const CFloatVectorDesc& data, const CFastArray<unsigned __int64, 512>& bitvectors, int lastTreeIndex ) const;
+	void calculateBlockScores( const float* blockValues, int featureCount, const unsigned __int64* bitvectors,
+		float* scores ) const;
 };
 
 } // namespace NeoML
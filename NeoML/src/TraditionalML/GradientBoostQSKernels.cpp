@@ -0,0 +1,82 @@
+/* Copyright © 2017-2020 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <GradientBoostQSKernels.h>
+#include <CpuFeatures.h>
+
+namespace NeoML {
+
+// The portable kernels
+static void qsBlockScanLess( const CQSNode* nodes, int nodeCount, const float* values, unsigned long long* bitvectors )
+{
+	for( int i = 0; i < nodeCount; i++ ) {
+		const CQSNode& node = nodes[i];
+		unsigned long long* treeBitvectors = bitvectors + node.Tree * QSBlockSize;
+		bool isAnyApplied = false;
+		for( int j = 0; j < QSBlockSize; j++ ) {
+			const bool isApplied = node.Threshold < values[j];
+			treeBitvectors[j] &= isApplied ? node.Mask : ~0ULL;
+			isAnyApplied |= isApplied;
+		}
+		if( !isAnyApplied ) {
+			return;
+		}
+	}
+}
+
+static void qsBlockScanMore( const CQSNode* nodes, int nodeCount, const float* values, unsigned long long* bitvectors )
+{
+	for( int i = 0; i < nodeCount; i++ ) {
+		const CQSNode& node = nodes[i];
+		unsigned long long* treeBitvectors = bitvectors + node.Tree * QSBlockSize;
+		bool isAnyApplied = false;
+		for( int j = 0; j < QSBlockSize; j++ ) {
+			const bool isApplied = node.Threshold >= values[j];
+			treeBitvectors[j] &= isApplied ? node.Mask : ~0ULL;
+			isAnyApplied |= isApplied;
+		}
+		if( !isAnyApplied ) {
+			return;
+		}
+	}
+}
+
+static CQSBlockKernels createQSBlockKernels()
+{
+	CQSBlockKernels kernels;
+	kernels.ScanLess = qsBlockScanLess;
+	kernels.ScanMore = qsBlockScanMore;
+#ifdef NEOML_USE_SSE
+	if( IsAvx512Available() ) {
+		kernels.ScanLess = QSBlockScanLessAvx512;
+		kernels.ScanMore = QSBlockScanMoreAvx512;
+	} else if( IsAvx2Available() ) {
+		kernels.ScanLess = QSBlockScanLessAvx2;
+		kernels.ScanMore = QSBlockScanMoreAvx2;
+	}
+#endif
+	return kernels;
+}
+
+const CQSBlockKernels& GetQSBlockKernels()
+{
+	static const CQSBlockKernels kernels = createQSBlockKernels();
+	return kernels;
+}
+
+} // namespace NeoML
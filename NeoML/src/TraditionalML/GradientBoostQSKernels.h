@@ -0,0 +1,66 @@
+/* Copyright © 2017-2020 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+
+// The header is included into the files compiled with AVX2 and AVX-512 support,
+// so it must not include the headers that define inline functions
+#include <NeoMathEngine/NeoMathEngineDefs.h>
+
+namespace NeoML {
+
+const int QSBlockSize = 16; // the number of vectors processed together by the block-wise prediction
+
+// The descriptor of an non-leaf node of the subtree to be optimized
+struct CQSNode {
+	unsigned long long Mask; // the false nodes mask: has zeros in the positions where the vector cannot possibly belong if the node criterion is false
+	float Threshold; // split threshold
+	short Tree; // the index of the tree in the ensemble
+	char Order; // the order of depth first traversal
+	unsigned char PropertiesMask; // the node properties (inverted or not, is either of the children a leaf in the optimized subtree)
+
+	CQSNode( unsigned long long mask, float threshold, int tree, int order, unsigned char propertiesMask );
+};
+
+// The kernels of the block-wise QuickScorer (V-QuickScorer)
+// A kernel goes through the nodes of one feature in the order they are sorted in
+// and ANDs the node mask into the bitvectors of the block rows for which the node criterion is not fulfilled
+// The scan stops at the first node whose criterion is fulfilled for all the rows of the block
+// values are the feature values of QSBlockSize rows; bitvectors are QSBlockSize bitvectors per tree
+typedef void ( *TQSBlockScanKernel )( const CQSNode* nodes, int nodeCount, const float* values, unsigned long long* bitvectors );
+
+struct CQSBlockKernels {
+	// For the non-inverted nodes, sorted by threshold ascending: the mask is applied if the threshold < value
+	TQSBlockScanKernel ScanLess;
+	// For the inverted nodes, sorted by threshold descending: the mask is applied if the threshold >= value
+	TQSBlockScanKernel ScanMore;
+};
+
+// Gets the kernels for the instruction sets supported by the processor
+const CQSBlockKernels& GetQSBlockKernels();
+
+#ifdef NEOML_USE_SSE
+
+// The kernels compiled with AVX2 support, process the block as 2 registers of 8 floats
+void QSBlockScanLessAvx2( const CQSNode* nodes, int nodeCount, const float* values, unsigned long long* bitvectors );
+void QSBlockScanMoreAvx2( const CQSNode* nodes, int nodeCount, const float* values, unsigned long long* bitvectors );
+
+// The kernels compiled with AVX-512 support, process the block as 1 register of 16 floats
+void QSBlockScanLessAvx512( const CQSNode* nodes, int nodeCount, const float* values, unsigned long long* bitvectors );
+void QSBlockScanMoreAvx512( const CQSNode* nodes, int nodeCount, const float* values, unsigned long long* bitvectors );
+
+#endif // NEOML_USE_SSE
+
+} // namespace NeoML
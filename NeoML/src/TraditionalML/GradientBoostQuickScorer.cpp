@@ -18,6 +18,7 @@ limitations under the License.
 
 #include <NeoML/TraditionalML/GradientBoostQuickScorer.h>
 #include <GradientBoostQSEnsemble.h>
+#include <NeoMathEngine/OpenMP.h>
 
 namespace NeoML {
 
@@ -38,6 +39,26 @@ static inline double exponentFunc( double f )
 
 //------------------------------------------------------------------------------------------------------------
 
+// Creates the descriptor of the dense row-major matrix; pointers is the buffer for the row offsets
+static CFloatMatrixDesc createDenseMatrixDesc( const float* data, int height, int width, CArray<int>& pointers )
+{
+	NeoAssert( height >= 0 && width >= 0 );
+	pointers.SetSize( height + 1 );
+	for( int i = 0; i <= height; i++ ) {
+		pointers[i] = i * width;
+	}
+
+	CFloatMatrixDesc desc;
+	desc.Height = height;
+	desc.Width = width;
+	desc.Values = const_cast<float*>( data );
+	desc.PointerB = pointers.GetPtr();
+	desc.PointerE = pointers.GetPtr() + 1;
+	return desc;
+}
+
+//------------------------------------------------------------------------------------------------------------
+
 IGradientBoostQSModel::~IGradientBoostQSModel()
 {
 }
@@ -56,13 +77,24 @@ public:
 	// IGradientBoostQSModel interface methods
 	int GetClassCount() const override { return ensembles.Size() == 1 ? 2 : ensembles.Size(); };
 	bool Classify( const CFloatVectorDesc& data, CClassificationResult& result ) const override;
+	// The dense matrices are classified by blocks of rows
+	bool ClassifyBatch( const CFloatMatrixDesc& data, CArray<CClassificationResult>& results,
+		int threadCount = 1 ) const override;
 
 	// IGradientBoostQSModel interface methods
 	bool ClassifyEx( const CSparseFloatVector& data, CArray<CClassificationResult>& results ) const override;
 	bool ClassifyEx( const CFloatVectorDesc& data, CArray<CClassificationResult>& results ) const override;
+	bool ClassifyDenseBatch( const float* data, int height, int width, CArray<CClassificationResult>& results,
+		int threadCount = 1 ) const override;
 
 	// IRegressionModel interface method
 	double Predict( const CFloatVectorDesc& data ) const override;
+	// The dense matrices are processed by blocks of rows
+	void PredictBatch( const CFloatMatrixDesc& data, CArray<double>& results, int threadCount = 1 ) const override;
+
+	// IGradientBoostQSRegressionModel interface method
+	void PredictDenseBatch( const float* data, int height, int width, CArray<double>& results,
+		int threadCount = 1 ) const override;
 
 	// General methods
 	double GetLearningRate() const override { return learningRate; };
@@ -118,6 +150,88 @@ bool CGradientBoostQSModel::Classify( const CFloatVectorDesc& data, CClassificat
 	return classify( predictions, result );
 }
 
+void CGradientBoostQSModel::PredictBatch( const CFloatMatrixDesc& data, CArray<double>& results, int threadCount ) const
+{
+	if( data.Columns != nullptr ) {
+		IGradientBoostQSRegressionModel::PredictBatch( data, results, threadCount );
+		return;
+	}
+
+	NeoAssert( threadCount > 0 );
+	results.SetSize( data.Height );
+
+	NEOML_OMP_NUM_THREADS( threadCount ) {
+		int firstVector = 0;
+		int vectorCount = 0;
+		if( OmpGetTaskIndexAndCount( data.Height, firstVector, vectorCount ) ) {
+			ensembles.First()->PredictBlocks( data, firstVector, vectorCount, results.GetPtr() + firstVector );
+			for( int i = firstVector; i < firstVector + vectorCount; i++ ) {
+				results[i] *= learningRate;
+			}
+		}
+	}
+}
+
+bool CGradientBoostQSModel::ClassifyBatch( const CFloatMatrixDesc& data, CArray<CClassificationResult>& results,
+	int threadCount ) const
+{
+	if( data.Columns != nullptr ) {
+		return IGradientBoostQSModel::ClassifyBatch( data, results, threadCount );
+	}
+
+	NeoAssert( threadCount > 0 );
+	results.SetSize( data.Height );
+
+	// The predictions of each ensemble for all the rows
+	CArray<double> ensemblePredictions;
+	ensemblePredictions.SetSize( ensembles.Size() * data.Height );
+
+	CArray<bool> isSucceeded;
+	isSucceeded.Add( true, threadCount );
+	NEOML_OMP_NUM_THREADS( threadCount ) {
+		int firstVector = 0;
+		int vectorCount = 0;
+		if( OmpGetTaskIndexAndCount( data.Height, firstVector, vectorCount ) ) {
+			for( int ensembleIndex = 0; ensembleIndex < ensembles.Size(); ensembleIndex++ ) {
+				ensembles[ensembleIndex]->PredictBlocks( data, firstVector, vectorCount,
+					ensemblePredictions.GetPtr() + ensembleIndex * data.Height + firstVector );
+			}
+
+			CArray<double> predictions;
+			predictions.SetSize( ensembles.Size() );
+			for( int i = firstVector; i < firstVector + vectorCount; i++ ) {
+				bool isClassified = false;
+				if( GetClassCount() == 2 ) {
+					isClassified = classify( ensemblePredictions[i] * learningRate, results[i] );
+				} else {
+					for( int ensembleIndex = 0; ensembleIndex < ensembles.Size(); ensembleIndex++ ) {
+						predictions[ensembleIndex] = ensemblePredictions[ensembleIndex * data.Height + i];
+					}
+					isClassified = classify( predictions, results[i] );
+				}
+				if( !isClassified ) {
+					isSucceeded[OmpGetThreadNum()] = false;
+				}
+			}
+		}
+	}
+	return isSucceeded.Find( false ) == NotFound;
+}
+
+void CGradientBoostQSModel::PredictDenseBatch( const float* data, int height, int width, CArray<double>& results,
+	int threadCount ) const
+{
+	CArray<int> pointers;
+	PredictBatch( createDenseMatrixDesc( data, height, width, pointers ), results, threadCount );
+}
+
+bool CGradientBoostQSModel::ClassifyDenseBatch( const float* data, int height, int width,
+	CArray<CClassificationResult>& results, int threadCount ) const
+{
+	CArray<int> pointers;
+	return ClassifyBatch( createDenseMatrixDesc( data, height, width, pointers ), results, threadCount );
+}
+
 bool CGradientBoostQSModel::ClassifyEx( const CSparseFloatVector& data, CArray<CClassificationResult>& results ) const
 {
 	return ClassifyEx( data.GetDesc(), results );
@@ -17,23 +17,71 @@ limitations under the License.
 #pragma hdrstop
 
 #include <NeoML/TraditionalML/HierarchicalClustering.h>
+#include <NeoMathEngine/OpenMP.h>
 #include <float.h>
 
 namespace NeoML {
 
+// The merge of two clusters found by the nearest-neighbor chain algorithm
+struct CHierarchicalMerge {
+	int First; // an initial cluster from the first merged cluster
+	int Second; // an initial cluster from the second merged cluster
+	float Distance; // the distance between the merged clusters
+	int Step; // the step of the algorithm on which the merge was found
+
+	CHierarchicalMerge() : First( NotFound ), Second( NotFound ), Distance( 0 ), Step( 0 ) {}
+	CHierarchicalMerge( int first, int second, float distance, int step ) :
+		First( first ), Second( second ), Distance( distance ), Step( step ) {}
+};
+
+// Sorts the merges by distance; the merges with equal distances keep their order
+class CHierarchicalMergeAscending {
+public:
+	bool Predicate( const CHierarchicalMerge& first, const CHierarchicalMerge& second ) const
+		{ return first.Distance < second.Distance || ( first.Distance == second.Distance && first.Step < second.Step ); }
+	bool IsEqual( const CHierarchicalMerge& first, const CHierarchicalMerge& second ) const
+		{ return first.Step == second.Step; }
+	void Swap( CHierarchicalMerge& first, CHierarchicalMerge& second ) const { swap( first, second ); }
+};
+
+// Finds the set the element belongs to and compresses the path to it
+static int findSet( CArray<int>& parents, int index )
+{
+	int root = index;
+	while( parents[root] != root ) {
+		root = parents[root];
+	}
+	while( parents[index] != root ) {
+		const int next = parents[index];
+		parents[index] = root;
+		index = next;
+	}
+	return root;
+}
+
+//---------------------------------------------------------------------------------------------------------
+
 CHierarchicalClustering::CHierarchicalClustering( const CArray<CClusterCenter>& clustersCenters, const CParam& _params ) :
 	params( _params ),
-	log( 0 )
+	log( 0 ),
+	distancesSize( 0 )
 {
 	NeoAssert( params.MinClustersCount > 0 );
+	NeoAssert( params.Linkage >= 0 && params.Linkage < L_Count );
+	NeoAssert( params.Linkage != L_Ward || params.DistanceType == DF_Euclid );
+	NeoAssert( params.ThreadCount > 0 );
 	clustersCenters.CopyTo( initialClusters );
 }
 
 CHierarchicalClustering::CHierarchicalClustering( const CParam& _params ) :
 	params( _params ),
-	log( 0 )
+	log( 0 ),
+	distancesSize( 0 )
 {
 	NeoAssert( params.MinClustersCount > 0 );
+	NeoAssert( params.Linkage >= 0 && params.Linkage < L_Count );
+	NeoAssert( params.Linkage != L_Ward || params.DistanceType == DF_Euclid );
+	NeoAssert( params.ThreadCount > 0 );
 }
 
 bool CHierarchicalClustering::Clusterize( IClusteringData* data, CClusteringResult& result )
@@ -63,36 +111,7 @@ bool CHierarchicalClustering::Clusterize( IClusteringData* data, CClusteringResu
 		}
 	}
 
-	bool success = false;
-	const int initialClustersCount = clusters.Size();
-	while( true ) {
-		if( log != 0 ) {
-			*log << "\n[Step " << initialClustersCount - clusters.Size() << "]\n";
-		}
-
-		if( clusters.Size() <= params.MinClustersCount ) {
-			break;
-		}
-
-		int first = NotFound;
-		int second = NotFound;
-		findNearestClusters( first, second );
-
-		if( log != 0 ) {
-			*log << "Distance: " << distances[first][second] << "\n";
-		}
-
-		if( distances[first][second] > params.MaxClustersDistance ) {
-			success = true;
-			break;
-		}
-
-		if( log != 0 ) {
-			*log << "Merge clusters (" << first << ") and (" << second << ") distance - " << distances[first][second] << "\n";
-		}
-
-		mergeClusters( matrix, weights, first, second );
-	}
+	const bool success = params.Linkage == L_Centroid ? clusterizeCentroid( matrix, weights ) : clusterizeChain();
 
 	result.ClusterCount = clusters.Size();
 	result.Data.SetSize( data->GetVectorCount() );
@@ -115,6 +134,10 @@ bool CHierarchicalClustering::Clusterize( IClusteringData* data, CClusteringResu
 		}
 	}
 
+	distances.FreeBuffer();
+	nearestClusters.FreeBuffer();
+	nearestDistances.FreeBuffer();
+
 	return success;
 }
 
@@ -124,6 +147,8 @@ void CHierarchicalClustering::initialize( const CFloatMatrixDesc& matrix, const
 	const int vectorsCount = matrix.Height;
 
 	// Define the initial cluster set
+	clusters.DeleteAll();
+	clusterWeights.DeleteAll();
 	if( initialClusters.IsEmpty() ) {
 		// Each element is a cluster
 		clusters.SetBufferSize( vectorsCount );
@@ -134,12 +159,14 @@ void CHierarchicalClustering::initialize( const CFloatMatrixDesc& matrix, const
 			clusters.Add( FINE_DEBUG_NEW CCommonCluster( CClusterCenter( mean ) ) );
 			clusters.Last()->Add( i, desc, weights[i] );
 		}
+		weights.CopyTo( clusterWeights );
 	} else {
 		// The initial cluster centers have been specified directly
 		clusters.SetBufferSize( initialClusters.Size() );
 		for( int i = 0; i < initialClusters.Size(); i++ ) {
 			clusters.Add( FINE_DEBUG_NEW CCommonCluster( initialClusters[i] ) );
 		}
+		clusterWeights.Add( 0., clusters.Size() );
 
 		// Each element of the original data set is put into the nearest cluster
 		for( int i = 0; i < vectorsCount; i++ ) {
@@ -158,6 +185,7 @@ void CHierarchicalClustering::initialize( const CFloatMatrixDesc& matrix, const
 
 			NeoAssert( nearestCluster == i );
 			clusters[nearestCluster]->Add( i, desc, weights[i] );
+			clusterWeights[nearestCluster] += weights[i];
 		}
 
 		for( int i = 0; i < clusters.Size(); i++ ) {
@@ -167,12 +195,110 @@ void CHierarchicalClustering::initialize( const CFloatMatrixDesc& matrix, const
 
 	NeoAssert( !clusters.IsEmpty() );
 
-	// Initialize the cluster distance matrix
-	distances.DeleteAll();
-	distances.Add( CFloatVector( clusters.Size() ), clusters.Size() );
+	calcDistances();
+}
+
+// Calculates the distances between the initial clusters
+void CHierarchicalClustering::calcDistances()
+{
+	distancesSize = clusters.Size();
+	NeoAssert( static_cast<__int64>( distancesSize ) * ( distancesSize - 1 ) / 2 <= INT_MAX );
+	const int distancesCount = distancesSize * ( distancesSize - 1 ) / 2;
+	distances.SetSize( distancesCount );
+
+	// The matrix elements are split evenly between the threads
+	NEOML_OMP_NUM_THREADS( params.ThreadCount ) {
+		int firstIndex = 0;
+		int count = 0;
+		if( OmpGetTaskIndexAndCount( distancesCount, firstIndex, count ) ) {
+			// Find the matrix element with firstIndex index
+			int i = 0;
+			int rowStart = 0;
+			while( rowStart + distancesSize - i - 1 <= firstIndex ) {
+				rowStart += distancesSize - i - 1;
+				i++;
+			}
+			int j = i + 1 + firstIndex - rowStart;
+
+			for( int index = firstIndex; index < firstIndex + count; index++ ) {
+				double value = clusters[i]->CalcDistance( *clusters[j], params.DistanceType );
+				if( params.Linkage == L_Ward ) {
+					value *= 2 * clusterWeights[i] * clusterWeights[j] / ( clusterWeights[i] + clusterWeights[j] );
+				}
+				distances[index] = static_cast<float>( value );
+				if( ++j == distancesSize ) {
+					i++;
+					j = i + 1;
+				}
+			}
+		}
+	}
+}
+
+// The distance between two clusters
+inline float& CHierarchicalClustering::distance( int first, int second )
+{
+	NeoPresume( first != second );
+	if( first > second ) {
+		swap( first, second );
+	}
+	return distances[first * ( 2 * distancesSize - first - 1 ) / 2 + second - first - 1];
+}
+
+inline float CHierarchicalClustering::distance( int first, int second ) const
+{
+	return const_cast<CHierarchicalClustering*>( this )->distance( first, second );
+}
+
+// Merges the clusters with the closest centers, recalculating the distances after each merge
+bool CHierarchicalClustering::clusterizeCentroid( const CFloatMatrixDesc& matrix, const CArray<double>& weights )
+{
+	nearestClusters.SetSize( clusters.Size() );
+	nearestDistances.SetSize( clusters.Size() );
 	for( int i = 0; i < clusters.Size(); i++ ) {
-		for( int j = i + 1; j < clusters.Size(); j++ ) {
-			distances[i].SetAt( j, static_cast<float>( clusters[i]->CalcDistance( *clusters[j], params.DistanceType ) ) );
+		findNearestCluster( i );
+	}
+
+	const int initialClustersCount = clusters.Size();
+	while( true ) {
+		if( log != 0 ) {
+			*log << "\n[Step " << initialClustersCount - clusters.Size() << "]\n";
+		}
+
+		if( clusters.Size() <= params.MinClustersCount ) {
+			return false;
+		}
+
+		int first = NotFound;
+		int second = NotFound;
+		findNearestClusters( first, second );
+
+		if( log != 0 ) {
+			*log << "Distance: " << distance( first, second ) << "\n";
+		}
+
+		if( distance( first, second ) > params.MaxClustersDistance ) {
+			return true;
+		}
+
+		if( log != 0 ) {
+			*log << "Merge clusters (" << first << ") and (" << second << ") distance - " << distance( first, second ) << "\n";
+		}
+
+		mergeClusters( matrix, weights, first, second );
+	}
+}
+
+// Finds the nearest of the following clusters
+void CHierarchicalClustering::findNearestCluster( int index )
+{
+	nearestClusters[index] = NotFound;
+	nearestDistances[index] = FLT_MAX;
+	for( int i = index + 1; i < clusters.Size(); i++ ) {
+		const float current = distance( index, i );
+		if( nearestClusters[index] == NotFound || current < nearestDistances[index] ) {
+			nearestClusters[index] = i;
+			nearestDistances[index] = current;
 		}
 	}
 }
@@ -183,15 +309,12 @@ void CHierarchicalClustering::findNearestClusters( int& first, int& second ) con
 	NeoAssert( clusters.Size() > 1 );
 
 	first = 0;
-	second = 1;
-	for( int i = 0; i < clusters.Size(); i++ ) {
-		for( int j = i + 1; j < clusters.Size(); j++ ) {
-			if( distances[i][j] < distances[first][second] ) {
-				first = i;
-				second = j;
-			}
+	for( int i = 1; i < clusters.Size() - 1; i++ ) {
+		if( nearestDistances[i] < nearestDistances[first] ) {
+			first = i;
 		}
 	}
+	second = nearestClusters[first];
 }
 
 // Merges two clusters
@@ -220,27 +343,193 @@ void CHierarchicalClustering::mergeClusters( const CFloatMatrixDesc& matrix, con
 	// Switch the second cluster with the last; now we can calculate the cluster distance matrix in linear time
 	const int last = clusters.Size() - 1;
 	clusters[second] = clusters[last];
-	distances[second] = distances[last];
-	for( int i = 0; i < second; i++ ) {
-		distances[i].SetAt( second, distances[i][last] );
-	}
-	for( int i = second + 1; i < last; i++ ) {
-		distances[second].SetAt( i, distances[i][last] );
+	for( int i = 0; i < last; i++ ) {
+		if( i != second ) {
+			distance( i, second ) = distance( i, last );
+		}
 	}
 	for( int i = 0; i < last; i++ ) {
-		const double distance = clusters[first]->CalcDistance( *clusters[i], params.DistanceType );
-		if( i < first ) {
-			distances[i].SetAt( first, static_cast<float>( distance ) );
-		} else {
-			distances[first].SetAt( i, static_cast<float>( distance ) );
+		if( i != first ) {
+			distance( i, first ) = static_cast<float>( clusters[first]->CalcDistance( *clusters[i], params.DistanceType ) );
 		}
 	}
 	clusters.SetSize( last );
 
+	// Update the nearest clusters: only the distances to the first and the second clusters have changed
+	for( int i = 0; i < last; i++ ) {
+		if( i == first || i == second || nearestClusters[i] == first || nearestClusters[i] == second
+			|| nearestClusters[i] == last )
+		{
+			findNearestCluster( i );
+			continue;
+		}
+		const int changed[2] = { first, second };
+		for( int j = 0; j < 2; j++ ) {
+			const int other = changed[j];
+			if( other > i && ( distance( i, other ) < nearestDistances[i]
+				|| ( distance( i, other ) == nearestDistances[i] && other < nearestClusters[i] ) ) )
+			{
+				nearestClusters[i] = other;
+				nearestDistances[i] = distance( i, other );
+			}
+		}
+	}
+
 	if( log != 0 ) {
 		*log << "Result:\n";
 		*log << *clusters[first];
 	}
 }
 
+// Builds the full dendrogram by the nearest-neighbor chain algorithm and then merges the clusters in order of distance
+// The distances are updated by the Lance-Williams formula, so the clusters centers are not recalculated until the end
+// This is correct because the distance to a merged cluster is never less than the distance between the merged clusters
+bool CHierarchicalClustering::clusterizeChain()
+{
+	const int initialClustersCount = clusters.Size();
+	CArray<bool> isActive;
+	isActive.Add( true, initialClustersCount );
+	CArray<double> currentWeights;
+	clusterWeights.CopyTo( currentWeights );
+
+	CArray<CHierarchicalMerge> merges;
+	merges.SetBufferSize( initialClustersCount - 1 );
+	CArray<int> chain;
+	int firstActive = 0;
+	while( merges.Size() < initialClustersCount - 1 ) {
+		if( chain.IsEmpty() ) {
+			while( !isActive[firstActive] ) {
+				firstActive++;
+			}
+			chain.Add( firstActive );
+		}
+
+		// Extend the chain until its last two clusters are the nearest neighbors of each other
+		int first = NotFound;
+		int second = NotFound;
+		while( true ) {
+			const int last = chain.Last();
+			const int previous = chain.Size() > 1 ? chain[chain.Size() - 2] : NotFound;
+			const int neighbor = findChainNeighbor( last, previous, isActive );
+			if( neighbor == previous ) {
+				first = min( last, previous );
+				second = max( last, previous );
+				break;
+			}
+			chain.Add( neighbor );
+		}
+		chain.SetSize( chain.Size() - 2 );
+
+		// The merged cluster takes the place of the first cluster
+		const double mergedDistance = distance( first, second );
+		merges.Add( CHierarchicalMerge( first, second, static_cast<float>( mergedDistance ), merges.Size() ) );
+		isActive[second] = false;
+		for( int i = 0; i < initialClustersCount; i++ ) {
+			if( isActive[i] && i != first ) {
+				distance( first, i ) = static_cast<float>( calcMergedDistance( distance( first, i ), distance( second, i ),
+					mergedDistance, currentWeights[first], currentWeights[second], currentWeights[i] ) );
+			}
+		}
+		currentWeights[first] += currentWeights[second];
+	}
+
+	// Apply the merges in order of distance
+	merges.QuickSort<CHierarchicalMergeAscending>();
+	CArray<int> parents;
+	parents.SetSize( initialClustersCount );
+	for( int i = 0; i < initialClustersCount; i++ ) {
+		parents[i] = i;
+	}
+	bool success = false;
+	int clustersCount = initialClustersCount;
+	for( int step = 0; ; step++ ) {
+		if( log != 0 ) {
+			*log << "\n[Step " << step << "]\n";
+		}
+
+		if( clustersCount <= params.MinClustersCount ) {
+			break;
+		}
+
+		const CHierarchicalMerge& merge = merges[step];
+		if( log != 0 ) {
+			*log << "Distance: " << merge.Distance << "\n";
+		}
+
+		if( merge.Distance > params.MaxClustersDistance ) {
+			success = true;
+			break;
+		}
+
+		const int first = findSet( parents, merge.First );
+		const int second = findSet( parents, merge.Second );
+		NeoAssert( first != second );
+		if( log != 0 ) {
+			*log << "Merge clusters (" << first << ") and (" << second << ") distance - " << merge.Distance << "\n";
+		}
+
+		// The cluster with the smaller index remains
+		const int target = min( first, second );
+		const int source = max( first, second );
+		parents[source] = target;
+		clusters[target] = FINE_DEBUG_NEW CCommonCluster( *clusters[target], *clusters[source] );
+		clusters[source] = nullptr;
+		clustersCount--;
+
+		if( log != 0 ) {
+			*log << "Result:\n";
+			*log << *clusters[target];
+		}
+	}
+
+	// Remove the merged clusters
+	int resultSize = 0;
+	for( int i = 0; i < clusters.Size(); i++ ) {
+		if( clusters[i] != nullptr ) {
+			clusters[resultSize++] = clusters[i];
+		}
+	}
+	clusters.SetSize( resultSize );
+
+	return success;
+}
+
+// Finds the nearest active cluster for the last cluster in the chain
+// If there are several nearest clusters and the previous cluster in the chain is one of them, it is returned
+int CHierarchicalClustering::findChainNeighbor( int index, int previous, const CArray<bool>& isActive ) const
+{
+	int result = previous;
+	float resultDistance = previous == NotFound ? FLT_MAX : distance( index, previous );
+	for( int i = 0; i < isActive.Size(); i++ ) {
+		if( isActive[i] && i != index ) {
+			const float current = distance( index, i );
+			if( result == NotFound || current < resultDistance ) {
+				result = i;
+				resultDistance = current;
+			}
+		}
+	}
+	return result;
+}
+
+// Calculates the distance from the cluster to the merged cluster (the Lance-Williams formula)
+double CHierarchicalClustering::calcMergedDistance( double firstDistance, double secondDistance, double mergedDistance,
+	double firstWeight, double secondWeight, double weight ) const
+{
+	switch( params.Linkage ) {
+		case L_Single:
+			return min( firstDistance, secondDistance );
+		case L_Complete:
+			return max( firstDistance, secondDistance );
+		case L_Average:
+			return ( firstWeight * firstDistance + secondWeight * secondDistance ) / ( firstWeight + secondWeight );
+		case L_Ward:
+			return ( ( firstWeight + weight ) * firstDistance + ( secondWeight + weight ) * secondDistance
+				- weight * mergedDistance ) / ( firstWeight + secondWeight + weight );
+		default:
+			NeoAssert( false );
+	}
+	return 0;
+}
+
 } // namespace NeoML
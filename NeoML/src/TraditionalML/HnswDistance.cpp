@@ -0,0 +1,217 @@
+/* Copyright © 2017-2020 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <HnswDistance.h>
+#include <CpuFeatures.h>
+
+#if defined( NEOML_USE_SSE )
+#include <xmmintrin.h>
+#elif defined( NEOML_USE_NEON )
+#include <arm_neon.h>
+#endif
+
+namespace NeoML {
+
+#if defined( NEOML_USE_SSE )
+
+static inline float horizontalSum( __m128 value )
+{
+	value = _mm_add_ps( value, _mm_movehl_ps( value, value ) );
+	value = _mm_add_ss( value, _mm_shuffle_ps( value, value, 1 ) );
+	return _mm_cvtss_f32( value );
+}
+
+static float squaredEuclidSse( const float* first, const float* second, int size )
+{
+	__m128 sum0 = _mm_setzero_ps();
+	__m128 sum1 = _mm_setzero_ps();
+	int i = 0;
+	for( ; i + 8 <= size; i += 8 ) {
+		const __m128 diff0 = _mm_sub_ps( _mm_loadu_ps( first + i ), _mm_loadu_ps( second + i ) );
+		const __m128 diff1 = _mm_sub_ps( _mm_loadu_ps( first + i + 4 ), _mm_loadu_ps( second + i + 4 ) );
+		sum0 = _mm_add_ps( sum0, _mm_mul_ps( diff0, diff0 ) );
+		sum1 = _mm_add_ps( sum1, _mm_mul_ps( diff1, diff1 ) );
+	}
+	if( i + 4 <= size ) {
+		const __m128 diff = _mm_sub_ps( _mm_loadu_ps( first + i ), _mm_loadu_ps( second + i ) );
+		sum0 = _mm_add_ps( sum0, _mm_mul_ps( diff, diff ) );
+		i += 4;
+	}
+	float result = horizontalSum( _mm_add_ps( sum0, sum1 ) );
+	for( ; i < size; i++ ) {
+		const float diff = first[i] - second[i];
+		result += diff * diff;
+	}
+	return result;
+}
+
+static float dotProductSse( const float* first, const float* second, int size )
+{
+	__m128 sum0 = _mm_setzero_ps();
+	__m128 sum1 = _mm_setzero_ps();
+	int i = 0;
+	for( ; i + 8 <= size; i += 8 ) {
+		sum0 = _mm_add_ps( sum0, _mm_mul_ps( _mm_loadu_ps( first + i ), _mm_loadu_ps( second + i ) ) );
+		sum1 = _mm_add_ps( sum1, _mm_mul_ps( _mm_loadu_ps( first + i + 4 ), _mm_loadu_ps( second + i + 4 ) ) );
+	}
+	if( i + 4 <= size ) {
+		sum0 = _mm_add_ps( sum0, _mm_mul_ps( _mm_loadu_ps( first + i ), _mm_loadu_ps( second + i ) ) );
+		i += 4;
+	}
+	float result = horizontalSum( _mm_add_ps( sum0, sum1 ) );
+	for( ; i < size; i++ ) {
+		result += first[i] * second[i];
+	}
+	return result;
+}
+
+static CHnswDistanceKernels createHnswDistanceKernels()
+{
+	CHnswDistanceKernels kernels;
+	if( IsAvx2Available() ) {
+		kernels.SquaredEuclid = HnswSquaredEuclidAvx2;
+		kernels.DotProduct = HnswDotProductAvx2;
+	} else {
+		kernels.SquaredEuclid = squaredEuclidSse;
+		kernels.DotProduct = dotProductSse;
+	}
+	return kernels;
+}
+
+#elif defined( NEOML_USE_NEON )
+
+static inline float horizontalSum( float32x4_t value )
+{
+	const float32x2_t sum = vadd_f32( vget_low_f32( value ), vget_high_f32( value ) );
+	return vget_lane_f32( vpadd_f32( sum, sum ), 0 );
+}
+
+static float squaredEuclidNeon( const float* first, const float* second, int size )
+{
+	float32x4_t sum0 = vdupq_n_f32( 0.f );
+	float32x4_t sum1 = vdupq_n_f32( 0.f );
+	int i = 0;
+	for( ; i + 8 <= size; i += 8 ) {
+		const float32x4_t diff0 = vsubq_f32( vld1q_f32( first + i ), vld1q_f32( second + i ) );
+		const float32x4_t diff1 = vsubq_f32( vld1q_f32( first + i + 4 ), vld1q_f32( second + i + 4 ) );
+		sum0 = vmlaq_f32( sum0, diff0, diff0 );
+		sum1 = vmlaq_f32( sum1, diff1, diff1 );
+	}
+	if( i + 4 <= size ) {
+		const float32x4_t diff = vsubq_f32( vld1q_f32( first + i ), vld1q_f32( second + i ) );
+		sum0 = vmlaq_f32( sum0, diff, diff );
+		i += 4;
+	}
+	float result = horizontalSum( vaddq_f32( sum0, sum1 ) );
+	for( ; i < size; i++ ) {
+		const float diff = first[i] - second[i];
+		result += diff * diff;
+	}
+	return result;
+}
+
+static float dotProductNeon( const float* first, const float* second, int size )
+{
+	float32x4_t sum0 = vdupq_n_f32( 0.f );
+	float32x4_t sum1 = vdupq_n_f32( 0.f );
+	int i = 0;
+	for( ; i + 8 <= size; i += 8 ) {
+		sum0 = vmlaq_f32( sum0, vld1q_f32( first + i ), vld1q_f32( second + i ) );
+		sum1 = vmlaq_f32( sum1, vld1q_f32( first + i + 4 ), vld1q_f32( second + i + 4 ) );
+	}
+	if( i + 4 <= size ) {
+		sum0 = vmlaq_f32( sum0, vld1q_f32( first + i ), vld1q_f32( second + i ) );
+		i += 4;
+	}
+	float result = horizontalSum( vaddq_f32( sum0, sum1 ) );
+	for( ; i < size; i++ ) {
+		result += first[i] * second[i];
+	}
+	return result;
+}
+
+static CHnswDistanceKernels createHnswDistanceKernels()
+{
+	CHnswDistanceKernels kernels;
+	kernels.SquaredEuclid = squaredEuclidNeon;
+	kernels.DotProduct = dotProductNeon;
+	return kernels;
+}
+
+#else
+
+// The portable kernels; the sums are accumulated in several independent variables
+static const int DistanceUnrollCount = 8;
+
+static float squaredEuclid( const float* first, const float* second, int size )
+{
+	float sums[DistanceUnrollCount] = {};
+	int i = 0;
+	for( ; i + DistanceUnrollCount <= size; i += DistanceUnrollCount ) {
+		for( int j = 0; j < DistanceUnrollCount; j++ ) {
+			const float diff = first[i + j] - second[i + j];
+			sums[j] += diff * diff;
+		}
+	}
+	float result = 0;
+	for( ; i < size; i++ ) {
+		const float diff = first[i] - second[i];
+		result += diff * diff;
+	}
+	for( int j = 0; j < DistanceUnrollCount; j++ ) {
+		result += sums[j];
+	}
+	return result;
+}
+
+static float dotProduct( const float* first, const float* second, int size )
+{
+	float sums[DistanceUnrollCount] = {};
+	int i = 0;
+	for( ; i + DistanceUnrollCount <= size; i += DistanceUnrollCount ) {
+		for( int j = 0; j < DistanceUnrollCount; j++ ) {
+			sums[j] += first[i + j] * second[i + j];
+		}
+	}
+	float result = 0;
+	for( ; i < size; i++ ) {
+		result += first[i] * second[i];
+	}
+	for( int j = 0; j < DistanceUnrollCount; j++ ) {
+		result += sums[j];
+	}
+	return result;
+}
+
+static CHnswDistanceKernels createHnswDistanceKernels()
+{
+	CHnswDistanceKernels kernels;
+	kernels.SquaredEuclid = squaredEuclid;
+	kernels.DotProduct = dotProduct;
+	return kernels;
+}
+
+#endif
+
+const CHnswDistanceKernels& GetHnswDistanceKernels()
+{
+	static const CHnswDistanceKernels kernels = createHnswDistanceKernels();
+	return kernels;
+}
+
+} // namespace NeoML
@@ -0,0 +1,46 @@
+/* Copyright © 2017-2020 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+
+// The header is included into the files compiled with AVX2 support,
+// so it must not include the headers that define inline functions
+#include <NeoMathEngine/NeoMathEngineDefs.h>
+
+namespace NeoML {
+
+// The kernels that calculate the distances between the dense vectors of the HNSW index
+// The rounding errors depend on the instruction set, so the distances may differ in the last bits on different processors
+typedef float ( *THnswDistanceKernel )( const float* first, const float* second, int size );
+
+struct CHnswDistanceKernels {
+	// The squared Euclidean distance
+	THnswDistanceKernel SquaredEuclid;
+	// The dot product
+	THnswDistanceKernel DotProduct;
+};
+
+// Gets the kernels for the instruction sets supported by the processor
+const CHnswDistanceKernels& GetHnswDistanceKernels();
+
+#ifdef NEOML_USE_SSE
+
+// The kernels compiled with AVX2 and FMA support
+float HnswSquaredEuclidAvx2( const float* first, const float* second, int size );
+float HnswDotProductAvx2( const float* first, const float* second, int size );
+
+#endif // NEOML_USE_SSE
+
+} // namespace NeoML
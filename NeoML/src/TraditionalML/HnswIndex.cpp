@@ -0,0 +1,621 @@
+/* Copyright © 2017-2020 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <NeoML/TraditionalML/HnswIndex.h>
+#include <HnswDistance.h>
+#include <NeoML/Random.h>
+#include <NeoMathEngine/OpenMP.h>
+#include <float.h>
+#include <math.h>
+#include <memory>
+
+namespace NeoML {
+
+// The vector found during the search
+struct CHnswIndex::CCandidate {
+	float Distance;
+	int Index;
+
+	CCandidate() : Distance( 0 ), Index( NotFound ) {}
+	CCandidate( float distance, int index ) : Distance( distance ), Index( index ) {}
+};
+
+// The buffers used by one search
+class CHnswIndex::CSearchContext {
+public:
+	typedef AscendingByMember<CCandidate, float, &CCandidate::Distance> CAscending;
+	typedef DescendingByMember<CCandidate, float, &CCandidate::Distance> CDescending;
+
+	CSearchContext( int vectorCount, int featureCount );
+
+	// Marks the vector as visited; returns false if it has already been visited during this search
+	bool Visit( int index );
+	// Starts a new search
+	void ResetVisited();
+
+	CArray<float> Query; // the prepared query
+	// The candidates to be checked, the closest on top
+	CPriorityQueue<CArray<CCandidate>, CDescending> Candidates;
+	// The vectors found, the farthest on top
+	CPriorityQueue<CArray<CCandidate>, CAscending> Results;
+	CArray<CCandidate> Found; // the search results sorted by distance
+	CArray<CCandidate> Pruned; // the neighbors of a vector that has too many of them
+	CArray<int> Links; // the copy of the neighbors list
+
+private:
+	// The search number for each vector when it has been visited last time
+	CArray<unsigned int> visited;
+	unsigned int searchNumber;
+};
+
+CHnswIndex::CSearchContext::CSearchContext( int vectorCount, int featureCount ) :
+	searchNumber( 0 )
+{
+	Query.SetSize( featureCount );
+	visited.Add( 0, vectorCount );
+}
+
+inline bool CHnswIndex::CSearchContext::Visit( int index )
+{
+	if( visited[index] == searchNumber ) {
+		return false;
+	}
+	visited[index] = searchNumber;
+	return true;
+}
+
+void CHnswIndex::CSearchContext::ResetVisited()
+{
+	searchNumber++;
+	if( searchNumber == 0 ) {
+		// The counter has overflowed
+		::memset( visited.GetPtr(), 0, visited.Size() * sizeof( unsigned int ) );
+		searchNumber = 1;
+	}
+}
+
+// The locks used when the vectors are inserted in parallel
+class CHnswIndex::CBuildLocks {
+public:
+	// The lock for the neighbors lists of the vector
+	// The number of locks is limited, so one lock is shared by several vectors
+	CCriticalSection& Node( int index ) { return nodes[index % NodeLockCount]; }
+
+	// The lock for the entry point
+	CCriticalSection Global;
+
+private:
+	static const int NodeLockCount = 4096;
+	CCriticalSection nodes[NodeLockCount];
+};
+
+//---------------------------------------------------------------------------------------------------------
+
+static inline void copyLinkList( const int* links, CArray<int>& result )
+{
+	result.SetSize( links[0] );
+	for( int i = 0; i < links[0]; i++ ) {
+		result[i] = links[i + 1];
+	}
+}
+
+// CArchive reads and writes at most INT_MAX bytes at once
+static const int MaxArchiveBlockSize = 1 << 30;
+
+// Writes the array as the raw data
+template<class T>
+static void storeFlatArray( CArchive& archive, const T* data, int size, bool isAligned )
+{
+	archive << size;
+	if( isAligned ) {
+		WriteMappedDataPadding( archive );
+	}
+	const char* ptr = reinterpret_cast<const char*>( data );
+	const __int64 dataSize = static_cast<__int64>( size ) * sizeof( T );
+	for( __int64 written = 0; written < dataSize; ) {
+		const int blockSize = static_cast<int>( min<__int64>( dataSize - written, MaxArchiveBlockSize ) );
+		archive.Write( ptr + written, blockSize );
+		written += blockSize;
+	}
+}
+
+// Reads the array written by storeFlatArray
+// If the array is aligned and the archive is over a memory-mapped file, returns the pointer into the file
+// Otherwise returns the pointer to the buffer the data has been copied to
+template<class T>
+static const T* loadFlatArray( CArchive& archive, CArray<T>& buffer, bool isAligned, CPtr<CMappedFileData>& mapping )
+{
+	int size = 0;
+	archive >> size;
+	check( size >= 0, ERR_BAD_ARCHIVE, archive.Name() );
+	const __int64 dataSize = static_cast<__int64>( size ) * sizeof( T );
+
+	buffer.DeleteAll();
+	const char* mappedData = nullptr;
+	if( isAligned ) {
+		ReadMappedDataPadding( archive );
+		CPtr<CMappedFileData> arrayMapping;
+		mappedData = SkipMappedData( archive, dataSize, arrayMapping );
+		if( mappedData != nullptr && reinterpret_cast<uintptr_t>( mappedData ) % MappedDataAlignment == 0 ) {
+			mapping = arrayMapping;
+			return reinterpret_cast<const T*>( mappedData );
+		}
+	}
+
+	buffer.SetSize( size );
+	char* ptr = reinterpret_cast<char*>( buffer.GetPtr() );
+	if( mappedData != nullptr ) {
+		// The data has already been skipped in the archive
+		::memcpy( ptr, mappedData, static_cast<size_t>( dataSize ) );
+	} else {
+		for( __int64 read = 0; read < dataSize; ) {
+			const int blockSize = static_cast<int>( min<__int64>( dataSize - read, MaxArchiveBlockSize ) );
+			archive.Read( ptr + read, blockSize );
+			read += blockSize;
+		}
+	}
+	return buffer.GetPtr();
+}
+
+//---------------------------------------------------------------------------------------------------------
+
+CHnswIndex::CHnswIndex() :
+	featureCount( 0 ),
+	entryPoint( NotFound ),
+	maxLevel( NotFound ),
+	vectors( nullptr ),
+	baseLinks( nullptr ),
+	upperLinks( nullptr )
+{
+}
+
+CHnswIndex::CHnswIndex( const CParams& _params ) :
+	params( _params ),
+	featureCount( 0 ),
+	entryPoint( NotFound ),
+	maxLevel( NotFound ),
+	vectors( nullptr ),
+	baseLinks( nullptr ),
+	upperLinks( nullptr )
+{
+	NeoAssert( params.DistanceFunc == DF_Euclid || params.DistanceFunc == DF_Cosine );
+	NeoAssert( params.MaxNeighbors > 1 );
+	NeoAssert( params.EfConstruction > 0 );
+	NeoAssert( params.ThreadCount > 0 );
+}
+
+CHnswIndex::~CHnswIndex()
+{
+}
+
+void CHnswIndex::Build( const CFloatMatrixDesc& data )
+{
+	NeoAssert( data.Height > 0 );
+	NeoAssert( data.Width > 0 );
+	NeoAssert( static_cast<__int64>( data.Height ) * data.Width <= INT_MAX );
+
+	clear();
+	featureCount = data.Width;
+	const int vectorCount = data.Height;
+
+	vectorsBuffer.SetSize( vectorCount * featureCount );
+	vectors = vectorsBuffer.GetPtr();
+	NEOML_OMP_NUM_THREADS( params.ThreadCount ) {
+		int firstVector = 0;
+		int count = 0;
+		if( OmpGetTaskIndexAndCount( vectorCount, firstVector, count ) ) {
+			CFloatVectorDesc row;
+			for( int i = firstVector; i < firstVector + count; i++ ) {
+				data.GetRow( i, row );
+				prepareQuery( row, vectorsBuffer.GetPtr() + static_cast<ptrdiff_t>( i ) * featureCount );
+			}
+		}
+	}
+
+	// The level of each vector is selected with exponentially decreasing probability
+	CRandom random( params.Seed );
+	const double levelMultiplier = 1. / log( static_cast<double>( params.MaxNeighbors ) );
+	nodeLevels.SetSize( vectorCount );
+	upperLinksOffsets.SetSize( vectorCount );
+	int upperLinksCount = 0;
+	for( int i = 0; i < vectorCount; i++ ) {
+		nodeLevels[i] = static_cast<int>( -log( 1. - random.Uniform( 0, 1 ) ) * levelMultiplier );
+		upperLinksOffsets[i] = upperLinksCount;
+		upperLinksCount += nodeLevels[i] * upperLinksSize();
+	}
+
+	baseLinksBuffer.Add( 0, vectorCount * baseLinksSize() );
+	baseLinks = baseLinksBuffer.GetPtr();
+	upperLinksBuffer.Add( 0, upperLinksCount );
+	upperLinks = upperLinksBuffer.GetPtr();
+
+	entryPoint = 0;
+	maxLevel = nodeLevels[0];
+
+	std::unique_ptr<CBuildLocks> locks( FINE_DEBUG_NEW CBuildLocks );
+	NEOML_OMP_NUM_THREADS( params.ThreadCount ) {
+		int firstVector = 0;
+		int count = 0;
+		if( OmpGetTaskIndexAndCount( vectorCount - 1, firstVector, count ) ) {
+			CSearchContext context( vectorCount, featureCount );
+			for( int i = firstVector; i < firstVector + count; i++ ) {
+				insert( i + 1, context, *locks );
+			}
+		}
+	}
+}
+
+void CHnswIndex::Search( const CFloatVectorDesc& query, int k, int ef, CArray<int>& neighbors,
+	CArray<float>& distances ) const
+{
+	NeoAssert( k > 0 );
+	neighbors.SetSize( k );
+	distances.SetSize( k );
+
+	CSearchContext* context = acquireContext();
+	search( query, k, ef, *context, neighbors.GetPtr(), distances.GetPtr() );
+	releaseContext( context );
+}
+
+void CHnswIndex::SearchBatch( const CFloatMatrixDesc& queries, int k, int ef, CArray<int>& neighbors,
+	CArray<float>& distances, int threadCount ) const
+{
+	NeoAssert( k > 0 );
+	NeoAssert( threadCount > 0 );
+	neighbors.SetSize( queries.Height * k );
+	distances.SetSize( queries.Height * k );
+
+	NEOML_OMP_NUM_THREADS( threadCount ) {
+		int firstQuery = 0;
+		int queryCount = 0;
+		if( OmpGetTaskIndexAndCount( queries.Height, firstQuery, queryCount ) ) {
+			CSearchContext* context = acquireContext();
+			CFloatVectorDesc query;
+			for( int i = firstQuery; i < firstQuery + queryCount; i++ ) {
+				queries.GetRow( i, query );
+				search( query, k, ef, *context, neighbors.GetPtr() + i * k, distances.GetPtr() + i * k );
+			}
+			releaseContext( context );
+		}
+	}
+}
+
+void CHnswIndex::Serialize( CArchive& archive )
+{
+	archive.SerializeVersion( 0 );
+
+	if( archive.IsStoring() ) {
+		archive << static_cast<int>( params.DistanceFunc );
+		archive << params.MaxNeighbors << params.EfConstruction << params.ThreadCount << params.Seed;
+		archive << featureCount << entryPoint << maxLevel;
+		const int vectorCount = GetVectorCount();
+		storeFlatArray( archive, nodeLevels.GetPtr(), vectorCount, false );
+		storeFlatArray( archive, upperLinksOffsets.GetPtr(), vectorCount, false );
+		const int upperLinksCount = vectorCount == 0 ? 0
+			: upperLinksOffsets.Last() + nodeLevels.Last() * upperLinksSize();
+		storeFlatArray( archive, vectors, vectorCount * featureCount, true );
+		storeFlatArray( archive, baseLinks, vectorCount * baseLinksSize(), true );
+		storeFlatArray( archive, upperLinks, upperLinksCount, true );
+	} else if( archive.IsLoading() ) {
+		clear();
+		int distanceFunc = 0;
+		archive >> distanceFunc;
+		check( distanceFunc == DF_Euclid || distanceFunc == DF_Cosine, ERR_BAD_ARCHIVE, archive.Name() );
+		params.DistanceFunc = static_cast<TDistanceFunc>( distanceFunc );
+		archive >> params.MaxNeighbors >> params.EfConstruction >> params.ThreadCount >> params.Seed;
+		archive >> featureCount >> entryPoint >> maxLevel;
+		check( params.MaxNeighbors > 1 && featureCount >= 0, ERR_BAD_ARCHIVE, archive.Name() );
+
+		CArray<int> buffer;
+		loadFlatArray( archive, buffer, false, mapping );
+		buffer.MoveTo( nodeLevels );
+		loadFlatArray( archive, buffer, false, mapping );
+		buffer.MoveTo( upperLinksOffsets );
+		const int vectorCount = nodeLevels.Size();
+		check( upperLinksOffsets.Size() == vectorCount, ERR_BAD_ARCHIVE, archive.Name() );
+		check( vectorCount == 0 || ( 0 <= entryPoint && entryPoint < vectorCount ), ERR_BAD_ARCHIVE, archive.Name() );
+
+		vectors = loadFlatArray( archive, vectorsBuffer, true, mapping );
+		baseLinks = loadFlatArray( archive, baseLinksBuffer, true, mapping );
+		upperLinks = loadFlatArray( archive, upperLinksBuffer, true, mapping );
+	} else {
+		NeoAssert( false );
+	}
+}
+
+// The neighbors list of the vector on the level; its first element is the number of neighbors
+const int* CHnswIndex::getLinks( int index, int level ) const
+{
+	NeoPresume( level <= nodeLevels[index] );
+	if( level == 0 ) {
+		return baseLinks + static_cast<ptrdiff_t>( index ) * baseLinksSize();
+	}
+	return upperLinks + upperLinksOffsets[index] + ( level - 1 ) * upperLinksSize();
+}
+
+// The neighbors list that may be changed while the index is built
+int* CHnswIndex::getBuildLinks( int index, int level )
+{
+	NeoPresume( mapping == nullptr );
+	return const_cast<int*>( getLinks( index, level ) );
+}
+
+float CHnswIndex::calcDistance( const float* first, const float* second ) const
+{
+	if( params.DistanceFunc == DF_Euclid ) {
+		return GetHnswDistanceKernels().SquaredEuclid( first, second, featureCount );
+	}
+	// The vectors are normalized, so the dot product is the cosine (see DF_Cosine)
+	const float cosine = GetHnswDistanceKernels().DotProduct( first, second, featureCount );
+	return 1.f - cosine * fabsf( cosine );
+}
+
+void CHnswIndex::clear()
+{
+	CCriticalSectionLock lock( contextPoolSection );
+	contextPool.DeleteAll();
+	featureCount = 0;
+	entryPoint = NotFound;
+	maxLevel = NotFound;
+	nodeLevels.DeleteAll();
+	upperLinksOffsets.DeleteAll();
+	vectors = nullptr;
+	baseLinks = nullptr;
+	upperLinks = nullptr;
+	vectorsBuffer.DeleteAll();
+	baseLinksBuffer.DeleteAll();
+	upperLinksBuffer.DeleteAll();
+	mapping = nullptr;
+}
+
+// Converts the vector to the dense representation used in the index
+void CHnswIndex::prepareQuery( const CFloatVectorDesc& query, float* result ) const
+{
+	if( query.Indexes == nullptr ) {
+		NeoAssert( query.Size <= featureCount );
+		::memcpy( result, query.Values, query.Size * sizeof( float ) );
+		::memset( result + query.Size, 0, ( featureCount - query.Size ) * sizeof( float ) );
+	} else {
+		::memset( result, 0, featureCount * sizeof( float ) );
+		for( int i = 0; i < query.Size; i++ ) {
+			NeoAssert( query.Indexes[i] < featureCount );
+			result[query.Indexes[i]] = query.Values[i];
+		}
+	}
+
+	if( params.DistanceFunc == DF_Cosine ) {
+		const float norm = sqrtf( GetHnswDistanceKernels().DotProduct( result, result, featureCount ) );
+		if( norm > 0 ) {
+			for( int i = 0; i < featureCount; i++ ) {
+				result[i] /= norm;
+			}
+		}
+	}
+}
+
+// Adds the vector to the graph
+void CHnswIndex::insert( int index, CSearchContext& context, CBuildLocks& locks )
+{
+	const int level = nodeLevels[index];
+	const float* query = getVector( index );
+
+	// If the new vector becomes the entry point, the other vectors wait for it to be inserted
+	CCriticalSectionLock globalLock( locks.Global );
+	int entry = entryPoint;
+	const int currentMaxLevel = maxLevel;
+	if( level <= currentMaxLevel ) {
+		globalLock.Unlock();
+	}
+
+	for( int l = currentMaxLevel; l > level; l-- ) {
+		entry = searchGreedy( query, entry, l, context, &locks );
+	}
+
+	for( int l = min( level, currentMaxLevel ); l >= 0; l-- ) {
+		searchLevel( query, entry, l, params.EfConstruction, context, &locks );
+		entry = context.Found[0].Index;
+		selectNeighbors( context.Found, params.MaxNeighbors );
+
+		{
+			CCriticalSectionLock lock( locks.Node( index ) );
+			int* links = getBuildLinks( index, l );
+			links[0] = context.Found.Size();
+			for( int i = 0; i < context.Found.Size(); i++ ) {
+				links[i + 1] = context.Found[i].Index;
+			}
+		}
+		for( int i = 0; i < context.Found.Size(); i++ ) {
+			connect( context.Found[i].Index, index, l, context, locks );
+		}
+	}
+
+	if( level > currentMaxLevel ) {
+		entryPoint = index;
+		maxLevel = level;
+	}
+}
+
+// Copies the neighbors list of the vector to the search context
+// While the index is built, the list may be changed by the other threads, so it is copied under the lock
+void CHnswIndex::copyLinks( int index, int level, CSearchContext& context, CBuildLocks* locks ) const
+{
+	if( locks != nullptr ) {
+		CCriticalSectionLock lock( locks->Node( index ) );
+		copyLinkList( getLinks( index, level ), context.Links );
+	} else {
+		copyLinkList( getLinks( index, level ), context.Links );
+	}
+}
+
+// Moves to the closest neighbor while it is closer to the query than the current vector
+int CHnswIndex::searchGreedy( const float* query, int entry, int level, CSearchContext& context,
+	CBuildLocks* locks ) const
+{
+	float distance = calcDistance( query, getVector( entry ) );
+	bool isChanged = true;
+	while( isChanged ) {
+		isChanged = false;
+		copyLinks( entry, level, context, locks );
+		for( int i = 0; i < context.Links.Size(); i++ ) {
+			const int neighbor = context.Links[i];
+			const float neighborDistance = calcDistance( query, getVector( neighbor ) );
+			if( neighborDistance < distance ) {
+				distance = neighborDistance;
+				entry = neighbor;
+				isChanged = true;
+			}
+		}
+	}
+	return entry;
+}
+
+void CHnswIndex::searchLevel( const float* query, int entry, int level, int ef, CSearchContext& context,
+	CBuildLocks* locks ) const
+{
+	context.ResetVisited();
+	context.Candidates.Reset();
+	context.Results.Reset();
+
+	const CCandidate start( calcDistance( query, getVector( entry ) ), entry );
+	context.Visit( entry );
+	context.Candidates.Push( start );
+	context.Results.Push( start );
+
+	while( !context.Candidates.IsEmpty() ) {
+		CCandidate current;
+		context.Candidates.Pop( current );
+		if( current.Distance > context.Results.Peek().Distance && context.Results.Size() >= ef ) {
+			break;
+		}
+
+		copyLinks( current.Index, level, context, locks );
+		for( int i = 0; i < context.Links.Size(); i++ ) {
+			const int neighbor = context.Links[i];
+			if( !context.Visit( neighbor ) ) {
+				continue;
+			}
+			const float distance = calcDistance( query, getVector( neighbor ) );
+			if( context.Results.Size() < ef || distance < context.Results.Peek().Distance ) {
+				context.Candidates.Push( CCandidate( distance, neighbor ) );
+				context.Results.Push( CCandidate( distance, neighbor ) );
+				if( context.Results.Size() > ef ) {
+					context.Results.Pop();
+				}
+			}
+		}
+	}
+
+	context.Found.DeleteAll();
+	context.Results.CopyTo( context.Found );
+	context.Found.QuickSort<CSearchContext::CAscending>();
+}
+
+// Selects the neighbors among the candidates sorted by distance
+// The candidate is taken if it is closer to the vector than to any of the already selected neighbors,
+// so that the neighbors cover different directions
+void CHnswIndex::selectNeighbors( CArray<CCandidate>& candidates, int maxCount ) const
+{
+	if( candidates.Size() <= maxCount ) {
+		return;
+	}
+
+	int selectedCount = 0;
+	for( int i = 0; i < candidates.Size() && selectedCount < maxCount; i++ ) {
+		const CCandidate candidate = candidates[i];
+		bool isSelected = true;
+		for( int j = 0; j < selectedCount; j++ ) {
+			if( calcDistance( getVector( candidate.Index ), getVector( candidates[j].Index ) ) < candidate.Distance ) {
+				isSelected = false;
+				break;
+			}
+		}
+		if( isSelected ) {
+			candidates[selectedCount++] = candidate;
+		}
+	}
+	candidates.SetSize( selectedCount );
+}
+
+// Adds the new vector to the neighbors of the vector found for it
+void CHnswIndex::connect( int neighbor, int index, int level, CSearchContext& context, CBuildLocks& locks )
+{
+	CCriticalSectionLock lock( locks.Node( neighbor ) );
+	int* links = getBuildLinks( neighbor, level );
+	const int maxCount = maxNeighborsCount( level );
+	if( links[0] < maxCount ) {
+		links[++links[0]] = index;
+		return;
+	}
+
+	// The list is full, so the neighbors are selected again
+	const float* vector = getVector( neighbor );
+	context.Pruned.DeleteAll();
+	context.Pruned.Add( CCandidate( calcDistance( vector, getVector( index ) ), index ) );
+	for( int i = 1; i <= links[0]; i++ ) {
+		context.Pruned.Add( CCandidate( calcDistance( vector, getVector( links[i] ) ), links[i] ) );
+	}
+	context.Pruned.QuickSort<CSearchContext::CAscending>();
+	selectNeighbors( context.Pruned, maxCount );
+
+	links[0] = context.Pruned.Size();
+	for( int i = 0; i < context.Pruned.Size(); i++ ) {
+		links[i + 1] = context.Pruned[i].Index;
+	}
+}
+
+void CHnswIndex::search( const CFloatVectorDesc& query, int k, int ef, CSearchContext& context, int* neighbors,
+	float* distances ) const
+{
+	for( int i = 0; i < k; i++ ) {
+		neighbors[i] = NotFound;
+		distances[i] = FLT_MAX;
+	}
+	if( GetVectorCount() == 0 ) {
+		return;
+	}
+
+	prepareQuery( query, context.Query.GetPtr() );
+	int entry = entryPoint;
+	for( int l = maxLevel; l > 0; l-- ) {
+		entry = searchGreedy( context.Query.GetPtr(), entry, l, context, nullptr );
+	}
+	searchLevel( context.Query.GetPtr(), entry, 0, max( ef, k ), context, nullptr );
+
+	for( int i = 0; i < min( k, context.Found.Size() ); i++ ) {
+		neighbors[i] = context.Found[i].Index;
+		distances[i] = context.Found[i].Distance;
+	}
+}
+
+// Gets the search buffers from the pool or creates new ones
+CHnswIndex::CSearchContext* CHnswIndex::acquireContext() const
+{
+	CCriticalSectionLock lock( contextPoolSection );
+	if( contextPool.IsEmpty() ) {
+		return FINE_DEBUG_NEW CSearchContext( GetVectorCount(), featureCount );
+	}
+	return contextPool.DetachAt( contextPool.Size() - 1 );
+}
+
+void CHnswIndex::releaseContext( CSearchContext* context ) const
+{
+	CCriticalSectionLock lock( contextPoolSection );
+	contextPool.Add( context );
+}
+
+} // namespace NeoML
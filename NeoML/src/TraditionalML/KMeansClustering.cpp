@@ -129,7 +129,7 @@ bool CKMeansClustering::runClusterization( IClusteringData* input, int seed, CCl
 		}
 	}
 
-	bool success = clusterize( matrix, weights, inertia );
+	bool success = clusterize( matrix, weights, seed, inertia );
 
 	result.ClusterCount = clusters.Size();
 	result.Data.SetSize( matrix.Height );
@@ -177,12 +177,14 @@ bool CKMeansClustering::denseLloydL2Clusterize( IClusteringData* rawData, int se
 	CPtr<CDnnBlob> sizes = CDnnBlob::CreateVector( *mathEngine, CT_Float, clusterCount );
 	CPtr<CDnnBlob> labels = CDnnBlob::CreateVector( *mathEngine, CT_Int, vectorCount );
 
-	static_assert( KMA_Count == 2, "KMA_Count != 2" );
+	static_assert( KMA_Count == 4, "KMA_Count != 4" );
 	switch( params.Algo ) {
 		case KMA_Lloyd:
 			success = lloydBlobClusterization( *data, *weight, *centers, *sizes, *labels, inertia );
 			break;
 		case KMA_Elkan:
+		case KMA_MiniBatch:
+		case KMA_Hamerly:
 			// Only Lloyd algorithm is supported for dense data
 		default:
 			NeoAssert( false );
@@ -328,13 +330,22 @@ void CKMeansClustering::kMeansPlusPlusInitialization( const CFloatMatrixDesc& ma
 	}
 }
 
-bool CKMeansClustering::clusterize( const CFloatMatrixDesc& matrix, const CArray<double>& weights, double& inertia )
+bool CKMeansClustering::clusterize( const CFloatMatrixDesc& matrix, const CArray<double>& weights, int seed, double& inertia )
 {
-	if( params.Algo == KMA_Lloyd ) {
-		return lloydClusterization( matrix, weights, inertia );
-	} else {
-		return elkanClusterization( matrix, weights, inertia );
+	static_assert( KMA_Count == 4, "KMA_Count != 4" );
+	switch( params.Algo ) {
+		case KMA_Lloyd:
+			return lloydClusterization( matrix, weights, inertia );
+		case KMA_Elkan:
+			return elkanClusterization( matrix, weights, inertia );
+		case KMA_MiniBatch:
+			return miniBatchClusterization( matrix, weights, seed, inertia );
+		case KMA_Hamerly:
+			return hamerlyClusterization( matrix, weights, inertia );
+		default:
+			NeoAssert( false );
 	}
+	return false;
 }
 
 bool CKMeansClustering::lloydClusterization( const CFloatMatrixDesc& matrix, const CArray<double>& weights, double& inertia )
@@ -642,6 +653,535 @@ bool CKMeansClustering::isPruned( const CArray<float>& upperBounds, const CVaria
 		( upperBounds[id] <= 0.5 * clusterDists( currentCluster, clusterToProcess ) );
 }
 
+// The squared euclidean distance between the element and the dense cluster center
+static inline double calcSquaredDistance( const CFloatVectorDesc& element, const float* center, int featureCount,
+	double centerSquaredNorm )
+{
+	double result = 0;
+	if( element.Indexes == nullptr ) {
+		for( int i = 0; i < element.Size; i++ ) {
+			const double diff = element.Values[i] - center[i];
+			result += diff * diff;
+		}
+		// The missing values are zeros
+		for( int i = element.Size; i < featureCount; i++ ) {
+			result += static_cast<double>( center[i] ) * center[i];
+		}
+	} else {
+		// |x - c|^2 = |c|^2 + sum( x * ( x - 2 * c ) ) over the non-zero elements of x
+		result = centerSquaredNorm;
+		for( int i = 0; i < element.Size; i++ ) {
+			const double value = element.Values[i];
+			result += value * ( value - 2. * center[element.Indexes[i]] );
+		}
+		result = max( result, 0. );
+	}
+	return result;
+}
+
+// Calculates the squared norms of the dense cluster centers
+static void calcSquaredNorms( const CArray<float>& centers, int featureCount, CArray<double>& norms )
+{
+	const int clusterCount = centers.Size() / featureCount;
+	norms.SetSize( clusterCount );
+	for( int c = 0; c < clusterCount; c++ ) {
+		const float* center = centers.GetPtr() + c * featureCount;
+		double norm = 0;
+		for( int i = 0; i < featureCount; i++ ) {
+			norm += static_cast<double>( center[i] ) * center[i];
+		}
+		norms[c] = norm;
+	}
+}
+
+// Finds the nearest cluster center for the element
+static int findNearestCenter( const CFloatVectorDesc& element, const CArray<float>& centers, const CArray<double>& norms,
+	int featureCount, double& distance )
+{
+	int result = NotFound;
+	distance = DBL_MAX;
+	for( int c = 0; c < norms.Size(); c++ ) {
+		const double current = calcSquaredDistance( element, centers.GetPtr() + c * featureCount, featureCount, norms[c] );
+		if( current < distance ) {
+			distance = current;
+			result = c;
+		}
+	}
+	return result;
+}
+
+// Sorts the elements by the cluster they are assigned to
+// The elements of the c-th cluster are order[offsets[c]], ..., order[offsets[c + 1] - 1]
+static void groupByCluster( const CArray<int>& assignments, int clusterCount, CArray<int>& offsets, CArray<int>& order )
+{
+	offsets.DeleteAll();
+	offsets.Add( 0, clusterCount + 1 );
+	for( int i = 0; i < assignments.Size(); i++ ) {
+		offsets[assignments[i] + 1]++;
+	}
+	for( int c = 0; c < clusterCount; c++ ) {
+		offsets[c + 1] += offsets[c];
+	}
+	CArray<int> positions;
+	offsets.CopyTo( positions );
+	order.SetSize( assignments.Size() );
+	for( int i = 0; i < assignments.Size(); i++ ) {
+		order[positions[assignments[i]]++] = i;
+	}
+}
+
+// Adds the weighted element to the dense vector
+static inline void addElement( const CFloatVectorDesc& element, double weight, double* sum )
+{
+	if( element.Indexes == nullptr ) {
+		for( int i = 0; i < element.Size; i++ ) {
+			sum[i] += weight * element.Values[i];
+		}
+	} else {
+		for( int i = 0; i < element.Size; i++ ) {
+			sum[element.Indexes[i]] += weight * element.Values[i];
+		}
+	}
+}
+
+// Gets the current cluster centers as a dense matrix
+void CKMeansClustering::getClusterCenters( CArray<float>& centers ) const
+{
+	NeoAssert( !clusters.IsEmpty() );
+	const int featureCount = clusters[0]->GetCenter().Mean.Size();
+	centers.SetSize( clusters.Size() * featureCount );
+	for( int c = 0; c < clusters.Size(); c++ ) {
+		const CFloatVector& mean = clusters[c]->GetCenter().Mean;
+		NeoAssert( mean.Size() == featureCount );
+		::memcpy( centers.GetPtr() + c * featureCount, mean.GetPtr(), featureCount * sizeof( float ) );
+	}
+}
+
+// Replaces the clusters with the new empty clusters with the given centers
+void CKMeansClustering::setClusterCenters( const CArray<float>& centers )
+{
+	const int clusterCount = clusters.Size();
+	const int featureCount = centers.Size() / clusterCount;
+	CCommonCluster::CParams clusterParam;
+	clusterParam.MinElementCountForVariance = 1;
+	for( int c = 0; c < clusterCount; c++ ) {
+		CFloatVector mean( featureCount );
+		::memcpy( mean.CopyOnWrite(), centers.GetPtr() + c * featureCount, featureCount * sizeof( float ) );
+		clusters[c] = FINE_DEBUG_NEW CCommonCluster( CClusterCenter( mean ), clusterParam );
+	}
+}
+
+// Assigns every element to the nearest of the dense centers and returns the inertia
+double CKMeansClustering::assignToCenters( const CFloatMatrixDesc& matrix, const CArray<float>& centers,
+	CArray<int>& assignments ) const
+{
+	CArray<double> norms;
+	calcSquaredNorms( centers, matrix.Width, norms );
+	assignments.SetSize( matrix.Height );
+	CFastArray<double, 8> localInertia;
+	localInertia.Add( 0., params.ThreadCount );
+	NEOML_OMP_NUM_THREADS( params.ThreadCount ) {
+		int firstVector = 0;
+		int vectorCount = 0;
+		if( OmpGetTaskIndexAndCount( matrix.Height, firstVector, vectorCount ) ) {
+			for( int i = firstVector; i < firstVector + vectorCount; i++ ) {
+				double distance = 0;
+				assignments[i] = findNearestCenter( matrix.GetRow( i ), centers, norms, matrix.Width, distance );
+				localInertia[OmpGetThreadNum()] += distance;
+			}
+		}
+	}
+
+	double inertia = 0;
+	for( int i = 0; i < localInertia.Size(); ++i ) {
+		inertia += localInertia[i];
+	}
+	return inertia;
+}
+
+// Calculates the inertia for the given assignments
+double CKMeansClustering::calcInertia( const CFloatMatrixDesc& matrix, const CArray<float>& centers,
+	const CArray<int>& assignments ) const
+{
+	CArray<double> norms;
+	calcSquaredNorms( centers, matrix.Width, norms );
+	CFastArray<double, 8> localInertia;
+	localInertia.Add( 0., params.ThreadCount );
+	NEOML_OMP_NUM_THREADS( params.ThreadCount ) {
+		int firstVector = 0;
+		int vectorCount = 0;
+		if( OmpGetTaskIndexAndCount( matrix.Height, firstVector, vectorCount ) ) {
+			for( int i = firstVector; i < firstVector + vectorCount; i++ ) {
+				const int c = assignments[i];
+				localInertia[OmpGetThreadNum()] += calcSquaredDistance( matrix.GetRow( i ),
+					centers.GetPtr() + c * matrix.Width, matrix.Width, norms[c] );
+			}
+		}
+	}
+
+	double inertia = 0;
+	for( int i = 0; i < localInertia.Size(); ++i ) {
+		inertia += localInertia[i];
+	}
+	return inertia;
+}
+
+// Calculates the weighted means of the elements in each cluster
+// The clusters are split between the threads, so no synchronization is needed
+void CKMeansClustering::calcClusterMeans( const CFloatMatrixDesc& matrix, const CArray<double>& weights,
+	const CArray<int>& assignments, CArray<float>& centers ) const
+{
+	const int clusterCount = clusters.Size();
+	const int featureCount = matrix.Width;
+	CArray<int> offsets;
+	CArray<int> order;
+	groupByCluster( assignments, clusterCount, offsets, order );
+
+	NEOML_OMP_NUM_THREADS( params.ThreadCount ) {
+		int firstCluster = 0;
+		int clusterCountPerThread = 0;
+		if( OmpGetTaskIndexAndCount( clusterCount, firstCluster, clusterCountPerThread ) ) {
+			CArray<double> sum;
+			for( int c = firstCluster; c < firstCluster + clusterCountPerThread; c++ ) {
+				sum.DeleteAll();
+				sum.Add( 0., featureCount );
+				double totalWeight = 0;
+				for( int i = offsets[c]; i < offsets[c + 1]; i++ ) {
+					const int index = order[i];
+					addElement( matrix.GetRow( index ), weights[index], sum.GetPtr() );
+					totalWeight += weights[index];
+				}
+				if( totalWeight > 0 ) {
+					float* center = centers.GetPtr() + c * featureCount;
+					for( int j = 0; j < featureCount; j++ ) {
+						center[j] = static_cast<float>( sum[j] / totalWeight );
+					}
+				}
+			}
+		}
+	}
+}
+
+bool CKMeansClustering::miniBatchClusterization( const CFloatMatrixDesc& matrix, const CArray<double>& weights,
+	int seed, double& inertia )
+{
+	NeoAssert( params.DistanceFunc == DF_Euclid );
+	NeoAssert( params.MiniBatchSize > 0 );
+
+	const int clusterCount = clusters.Size();
+	const int featureCount = matrix.Width;
+	CArray<float> centers;
+	getClusterCenters( centers );
+	CArray<double> norms;
+	calcSquaredNorms( centers, featureCount, norms );
+	// The total weight of the elements that have moved each center
+	CArray<double> centerWeights;
+	centerWeights.Add( 0., clusterCount );
+
+	CRandom random( seed );
+	const int batchSize = min( params.MiniBatchSize, matrix.Height );
+	CArray<int> batch;
+	batch.SetSize( batchSize );
+	CArray<int> batchAssignments;
+	batchAssignments.SetSize( batchSize );
+	CArray<int> offsets;
+	CArray<int> order;
+	CFastArray<double, 8> maxMove;
+	maxMove.Add( 0., params.ThreadCount );
+
+	bool success = false;
+	for( int iteration = 0; iteration < params.MaxIterations; iteration++ ) {
+		for( int i = 0; i < batchSize; i++ ) {
+			batch[i] = random.UniformInt( 0, matrix.Height - 1 );
+		}
+
+		NEOML_OMP_NUM_THREADS( params.ThreadCount ) {
+			int firstVector = 0;
+			int vectorCount = 0;
+			if( OmpGetTaskIndexAndCount( batchSize, firstVector, vectorCount ) ) {
+				for( int i = firstVector; i < firstVector + vectorCount; i++ ) {
+					double distance = 0;
+					batchAssignments[i] = findNearestCenter( matrix.GetRow( batch[i] ), centers, norms, featureCount, distance );
+				}
+			}
+		}
+
+		// Each center becomes the mean of all the elements that have been assigned to it
+		groupByCluster( batchAssignments, clusterCount, offsets, order );
+		for( int i = 0; i < maxMove.Size(); i++ ) {
+			maxMove[i] = 0;
+		}
+		NEOML_OMP_NUM_THREADS( params.ThreadCount ) {
+			int firstCluster = 0;
+			int clusterCountPerThread = 0;
+			if( OmpGetTaskIndexAndCount( clusterCount, firstCluster, clusterCountPerThread ) ) {
+				CArray<double> sum;
+				for( int c = firstCluster; c < firstCluster + clusterCountPerThread; c++ ) {
+					if( offsets[c] == offsets[c + 1] ) {
+						continue;
+					}
+					sum.DeleteAll();
+					sum.Add( 0., featureCount );
+					double batchWeight = 0;
+					for( int i = offsets[c]; i < offsets[c + 1]; i++ ) {
+						const int index = batch[order[i]];
+						addElement( matrix.GetRow( index ), weights[index], sum.GetPtr() );
+						batchWeight += weights[index];
+					}
+					if( batchWeight <= 0 ) {
+						continue;
+					}
+
+					const double totalWeight = centerWeights[c] + batchWeight;
+					float* center = centers.GetPtr() + c * featureCount;
+					double move = 0;
+					double norm = 0;
+					for( int j = 0; j < featureCount; j++ ) {
+						const float newValue = static_cast<float>( ( centerWeights[c] * center[j] + sum[j] ) / totalWeight );
+						move += static_cast<double>( newValue - center[j] ) * ( newValue - center[j] );
+						norm += static_cast<double>( newValue ) * newValue;
+						center[j] = newValue;
+					}
+					centerWeights[c] = totalWeight;
+					norms[c] = norm;
+					maxMove[OmpGetThreadNum()] = max( maxMove[OmpGetThreadNum()], move );
+				}
+			}
+		}
+
+		double iterationMove = 0;
+		for( int i = 0; i < maxMove.Size(); i++ ) {
+			iterationMove = max( iterationMove, maxMove[i] );
+		}
+		if( log != 0 ) {
+			*log << L"Step " << iteration << L" Max center move: " << iterationMove << L"\n";
+		}
+		if( iterationMove <= params.Tolerance ) {
+			success = true;
+			break;
+		}
+	}
+
+	// Assign all the elements to the found centers
+	setClusterCenters( centers );
+	CArray<int> assignments;
+	inertia = assignToCenters( matrix, centers, assignments );
+	CArray<CClusterCenter> oldCenters;
+	storeClusterCenters( oldCenters );
+	updateClusters( matrix, weights, assignments, oldCenters );
+	return success;
+}
+
+bool CKMeansClustering::hamerlyClusterization( const CFloatMatrixDesc& matrix, const CArray<double>& weights, double& inertia )
+{
+	// Metric must support triangle inequality
+	NeoAssert( params.DistanceFunc == DF_Euclid );
+
+	const int clusterCount = clusters.Size();
+	const int featureCount = matrix.Width;
+	CArray<float> centers;
+	getClusterCenters( centers );
+
+	// Element assignments (objectCount)
+	CArray<int> assignments;
+	// The upper bound of the distance to the assigned center (objectCount)
+	CArray<float> upperBounds;
+	// The lower bound of the distance to any other center (objectCount)
+	CArray<float> lowerBounds;
+	initializeHamerlyBounds( matrix, centers, assignments, upperBounds, lowerBounds );
+
+	// Half of the distance from each center to the closest other center (clusterCount)
+	CArray<float> halfClosestDist;
+	CArray<float> oldCenters;
+	CArray<float> moveDistance;
+	moveDistance.SetSize( clusterCount );
+	bool success = false;
+	for( int iteration = 0; iteration < params.MaxIterations; iteration++ ) {
+		// Recalculate centers
+		centers.CopyTo( oldCenters );
+		calcClusterMeans( matrix, weights, assignments, centers );
+
+		// Update the bounds: the lower bound decreases by the largest move of the other centers
+		int farthestMoved = 0;
+		float maxMove = 0;
+		float secondMaxMove = 0;
+		for( int c = 0; c < clusterCount; c++ ) {
+			double move = 0;
+			for( int j = 0; j < featureCount; j++ ) {
+				const double diff = centers[c * featureCount + j] - oldCenters[c * featureCount + j];
+				move += diff * diff;
+			}
+			moveDistance[c] = static_cast<float>( sqrt( move ) );
+			if( moveDistance[c] > maxMove ) {
+				secondMaxMove = maxMove;
+				maxMove = moveDistance[c];
+				farthestMoved = c;
+			} else if( moveDistance[c] > secondMaxMove ) {
+				secondMaxMove = moveDistance[c];
+			}
+		}
+		NEOML_OMP_NUM_THREADS( params.ThreadCount ) {
+			int firstVector = 0;
+			int vectorCount = 0;
+			if( OmpGetTaskIndexAndCount( matrix.Height, firstVector, vectorCount ) ) {
+				for( int i = firstVector; i < firstVector + vectorCount; i++ ) {
+					upperBounds[i] += moveDistance[assignments[i]];
+					lowerBounds[i] -= assignments[i] == farthestMoved ? secondMaxMove : maxMove;
+				}
+			}
+		}
+
+		// Reassign vectors
+		computeHalfClosestClusterDists( centers, halfClosestDist );
+		const int changedCount = hamerlyAssignVectors( matrix, centers, halfClosestDist, assignments,
+			upperBounds, lowerBounds );
+		if( log != 0 ) {
+			*log << L"Step " << iteration << L" Changed assignments: " << changedCount << L"\n";
+		}
+		if( changedCount == 0 ) {
+			success = true;
+			break;
+		}
+	}
+
+	inertia = calcInertia( matrix, centers, assignments );
+	setClusterCenters( centers );
+	CArray<CClusterCenter> clusterCenters;
+	storeClusterCenters( clusterCenters );
+	updateClusters( matrix, weights, assignments, clusterCenters );
+	return success;
+}
+
+// Assigns each element to the nearest center and sets the bounds to the exact distances
+void CKMeansClustering::initializeHamerlyBounds( const CFloatMatrixDesc& matrix, const CArray<float>& centers,
+	CArray<int>& assignments, CArray<float>& upperBounds, CArray<float>& lowerBounds ) const
+{
+	CArray<double> norms;
+	calcSquaredNorms( centers, matrix.Width, norms );
+	assignments.SetSize( matrix.Height );
+	upperBounds.SetSize( matrix.Height );
+	lowerBounds.SetSize( matrix.Height );
+	NEOML_OMP_NUM_THREADS( params.ThreadCount ) {
+		int firstVector = 0;
+		int vectorCount = 0;
+		if( OmpGetTaskIndexAndCount( matrix.Height, firstVector, vectorCount ) ) {
+			for( int i = firstVector; i < firstVector + vectorCount; i++ ) {
+				const CFloatVectorDesc element = matrix.GetRow( i );
+				double nearest = DBL_MAX;
+				double secondNearest = DBL_MAX;
+				for( int c = 0; c < norms.Size(); c++ ) {
+					const double distance = calcSquaredDistance( element, centers.GetPtr() + c * matrix.Width,
+						matrix.Width, norms[c] );
+					if( distance < nearest ) {
+						secondNearest = nearest;
+						nearest = distance;
+						assignments[i] = c;
+					} else if( distance < secondNearest ) {
+						secondNearest = distance;
+					}
+				}
+				upperBounds[i] = static_cast<float>( sqrt( nearest ) );
+				lowerBounds[i] = secondNearest == DBL_MAX ? FLT_MAX : static_cast<float>( sqrt( secondNearest ) );
+			}
+		}
+	}
+}
+
+// Calculates half of the distance from each center to the closest other center
+void CKMeansClustering::computeHalfClosestClusterDists( const CArray<float>& centers, CArray<float>& halfClosestDist ) const
+{
+	const int clusterCount = clusters.Size();
+	const int featureCount = centers.Size() / clusterCount;
+	halfClosestDist.SetSize( clusterCount );
+	NEOML_OMP_NUM_THREADS( params.ThreadCount ) {
+		int firstCluster = 0;
+		int clusterCountPerThread = 0;
+		if( OmpGetTaskIndexAndCount( clusterCount, firstCluster, clusterCountPerThread ) ) {
+			for( int c = firstCluster; c < firstCluster + clusterCountPerThread; c++ ) {
+				const float* center = centers.GetPtr() + c * featureCount;
+				double closest = DBL_MAX;
+				for( int other = 0; other < clusterCount; other++ ) {
+					if( other == c ) {
+						continue;
+					}
+					const float* otherCenter = centers.GetPtr() + other * featureCount;
+					double distance = 0;
+					for( int j = 0; j < featureCount; j++ ) {
+						const double diff = center[j] - otherCenter[j];
+						distance += diff * diff;
+					}
+					closest = min( closest, distance );
+				}
+				halfClosestDist[c] = closest == DBL_MAX ? FLT_MAX : static_cast<float>( 0.5 * sqrt( closest ) );
+			}
+		}
+	}
+}
+
+// Reassigns the elements whose bounds do not guarantee that the assigned center is the nearest
+// Returns the number of the elements assigned to another center
+int CKMeansClustering::hamerlyAssignVectors( const CFloatMatrixDesc& matrix, const CArray<float>& centers,
+	const CArray<float>& halfClosestDist, CArray<int>& assignments, CArray<float>& upperBounds,
+	CArray<float>& lowerBounds ) const
+{
+	CArray<double> norms;
+	calcSquaredNorms( centers, matrix.Width, norms );
+	CFastArray<int, 8> changedCount;
+	changedCount.Add( 0, params.ThreadCount );
+	NEOML_OMP_NUM_THREADS( params.ThreadCount ) {
+		int firstVector = 0;
+		int vectorCount = 0;
+		if( OmpGetTaskIndexAndCount( matrix.Height, firstVector, vectorCount ) ) {
+			for( int i = firstVector; i < firstVector + vectorCount; i++ ) {
+				const int assigned = assignments[i];
+				const float bound = max( halfClosestDist[assigned], lowerBounds[i] );
+				if( upperBounds[i] <= bound ) {
+					continue;
+				}
+				// Tighten the upper bound
+				const CFloatVectorDesc element = matrix.GetRow( i );
+				const double assignedDistance = calcSquaredDistance( element, centers.GetPtr() + assigned * matrix.Width,
+					matrix.Width, norms[assigned] );
+				upperBounds[i] = static_cast<float>( sqrt( assignedDistance ) );
+				if( upperBounds[i] <= bound ) {
+					continue;
+				}
+
+				// Check all the centers; the current center is preferred if the distances are equal
+				int nearestCluster = assigned;
+				double nearest = assignedDistance;
+				double secondNearest = DBL_MAX;
+				for( int c = 0; c < norms.Size(); c++ ) {
+					if( c == assigned ) {
+						continue;
+					}
+					const double distance = calcSquaredDistance( element, centers.GetPtr() + c * matrix.Width,
+						matrix.Width, norms[c] );
+					if( distance < nearest ) {
+						secondNearest = nearest;
+						nearest = distance;
+						nearestCluster = c;
+					} else if( distance < secondNearest ) {
+						secondNearest = distance;
+					}
+				}
+				if( nearestCluster != assigned ) {
+					assignments[i] = nearestCluster;
+					upperBounds[i] = static_cast<float>( sqrt( nearest ) );
+					changedCount[OmpGetThreadNum()]++;
+				}
+				lowerBounds[i] = secondNearest == DBL_MAX ? FLT_MAX : static_cast<float>( sqrt( secondNearest ) );
+			}
+		}
+	}
+
+	int result = 0;
+	for( int i = 0; i < changedCount.Size(); i++ ) {
+		result += changedCount[i];
+	}
+	return result;
+}
+
 // Selects initial centers from dense data
 void CKMeansClustering::selectInitialClusters( const CDnnBlob& data, int seed, CDnnBlob& centers )
 {
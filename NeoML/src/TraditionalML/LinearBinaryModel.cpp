@@ -17,6 +17,7 @@ limitations under the License.
 #pragma hdrstop
 
 #include <LinearBinaryModel.h>
+#include <LinearFunctionBatch.h>
 
 namespace NeoML {
 
@@ -37,6 +38,20 @@ bool CLinearBinaryModel::Classify( const CFloatVectorDesc& data, CClassification
 	return classify( distance, result );
 }
 
+bool CLinearBinaryModel::ClassifyBatch( const CFloatMatrixDesc& data, CArray<CClassificationResult>& results,
+	int threadCount ) const
+{
+	CArray<double> distances;
+	distances.SetSize( data.Height );
+	LinearFunctionBatch( plane, data, threadCount, distances.GetPtr() );
+
+	results.SetSize( data.Height );
+	for( int i = 0; i < data.Height; i++ ) {
+		classify( distances[i], results[i] );
+	}
+	return true;
+}
+
 // Calculates classification result from the distance to the separating plane
 bool CLinearBinaryModel::classify( double distance, CClassificationResult& result ) const
 {
@@ -76,4 +91,10 @@ double CLinearBinaryModel::Predict( const CFloatVectorDesc& data ) const
 	return LinearFunction( plane, data );
 }
 
+void CLinearBinaryModel::PredictBatch( const CFloatMatrixDesc& data, CArray<double>& results, int threadCount ) const
+{
+	results.SetSize( data.Height );
+	LinearFunctionBatch( plane, data, threadCount, results.GetPtr() );
+}
+
 } // namespace NeoML
@@ -0,0 +1,100 @@
+/* Copyright © 2017-2021 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <LinearFunctionBatch.h>
+#include <NeoMathEngine/OpenMP.h>
+
+namespace NeoML {
+
+// The number of dense rows multiplied by the plane at once
+static const int LinearFunctionRowBlock = 4;
+
+// Calculates the dot products of the plane and a block of dense rows of the same size
+static void denseRowBlockDotProduct( const float* plane, int planeSize, const CFloatVectorDesc* rows, double* results )
+{
+	const int size = min( planeSize, rows[0].Size );
+	const float* row0 = rows[0].Values;
+	const float* row1 = rows[1].Values;
+	const float* row2 = rows[2].Values;
+	const float* row3 = rows[3].Values;
+
+	double sum0 = 0;
+	double sum1 = 0;
+	double sum2 = 0;
+	double sum3 = 0;
+	for( int i = 0; i < size; i++ ) {
+		const double weight = plane[i];
+		sum0 += weight * row0[i];
+		sum1 += weight * row1[i];
+		sum2 += weight * row2[i];
+		sum3 += weight * row3[i];
+	}
+
+	const double freeTerm = plane[planeSize - 1];
+	results[0] = freeTerm + sum0;
+	results[1] = freeTerm + sum1;
+	results[2] = freeTerm + sum2;
+	results[3] = freeTerm + sum3;
+}
+
+// Checks if the block of rows may be processed by denseRowBlockDotProduct
+static bool isDenseRowBlock( const CFloatVectorDesc* rows )
+{
+	for( int i = 0; i < LinearFunctionRowBlock; i++ ) {
+		if( rows[i].Indexes != nullptr || rows[i].Size != rows[0].Size ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void LinearFunctionBatch( const CFloatVector& plane, const CFloatMatrixDesc& matrix, int threadCount, double* results )
+{
+	NeoAssert( plane.Size() > 0 );
+	NeoAssert( threadCount > 0 );
+
+	const float* planePtr = plane.GetPtr();
+	const int planeSize = plane.Size();
+
+	NEOML_OMP_NUM_THREADS( threadCount ) {
+		int firstVector = 0;
+		int vectorCount = 0;
+		if( OmpGetTaskIndexAndCount( matrix.Height, firstVector, vectorCount ) ) {
+			const int lastVector = firstVector + vectorCount;
+			CFloatVectorDesc rows[LinearFunctionRowBlock];
+			int i = firstVector;
+			for( ; i + LinearFunctionRowBlock <= lastVector; i += LinearFunctionRowBlock ) {
+				for( int j = 0; j < LinearFunctionRowBlock; j++ ) {
+					matrix.GetRow( i + j, rows[j] );
+				}
+				if( isDenseRowBlock( rows ) ) {
+					denseRowBlockDotProduct( planePtr, planeSize, rows, results + i );
+				} else {
+					for( int j = 0; j < LinearFunctionRowBlock; j++ ) {
+						results[i + j] = LinearFunction( plane, rows[j] );
+					}
+				}
+			}
+			for( ; i < lastVector; i++ ) {
+				results[i] = LinearFunction( plane, matrix.GetRow( i ) );
+			}
+		}
+	}
+}
+
+} // namespace NeoML
@@ -0,0 +1,29 @@
+/* Copyright © 2017-2021 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <NeoML/TraditionalML/FloatVector.h>
+#include <NeoML/TraditionalML/SparseFloatMatrix.h>
+
+namespace NeoML {
+
+// Calculates LinearFunction( plane, row ) for every row of the matrix using up to threadCount threads
+// The plane contains the weights followed by the free term
+// The dense rows are processed in blocks so that each weight is loaded once per block
+// The results are equal to the ones returned by LinearFunction
+void LinearFunctionBatch( const CFloatVector& plane, const CFloatMatrixDesc& matrix, int threadCount, double* results );
+
+} // namespace NeoML
@@ -0,0 +1,145 @@
+/* Copyright © 2017-2020 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <NeoML/TraditionalML/RandomForest.h>
+#include <RandomForestModel.h>
+#include <NeoMathEngine/OpenMP.h>
+#include <math.h>
+
+namespace NeoML {
+
+// The bootstrap sample of the input data
+// Only the row pointers are stored, the matrix values are shared with the input data;
+// the vector drawn several times is included once with its weight multiplied by the number of draws
+class CBootstrapSubProblem : public IProblem {
+public:
+	CBootstrapSubProblem( const IProblem* problem, int sampleSize, CRandom& random );
+
+	// IProblem interface methods
+	int GetClassCount() const override { return problem->GetClassCount(); }
+	int GetFeatureCount() const override { return problem->GetFeatureCount(); }
+	bool IsDiscreteFeature( int index ) const override { return problem->IsDiscreteFeature( index ); }
+	int GetVectorCount() const override { return originalIndices.Size(); }
+	int GetClass( int index ) const override { return problem->GetClass( originalIndices[index] ); }
+	CFloatMatrixDesc GetMatrix() const override { return matrix; }
+	double GetVectorWeight( int index ) const override
+		{ return problem->GetVectorWeight( originalIndices[index] ) * drawCounts[index]; }
+	int GetDiscretizationValue( int index ) const override { return problem->GetDiscretizationValue( index ); }
+
+protected:
+	virtual ~CBootstrapSubProblem() {} // delete operator prohibited
+
+private:
+	const CPtr<const IProblem> problem; // the input data
+	CArray<int> originalIndices; // the indices of the sample vectors in the input data
+	CArray<int> drawCounts; // the number of times each vector has been drawn
+	CArray<int> pointerB; // vector start pointers
+	CArray<int> pointerE; // vector end pointers
+	CFloatMatrixDesc matrix; // the matrix descriptor for the problem
+};
+
+CBootstrapSubProblem::CBootstrapSubProblem( const IProblem* _problem, int sampleSize, CRandom& random ) :
+	problem( _problem )
+{
+	NeoAssert( problem != 0 );
+	NeoAssert( sampleSize > 0 );
+
+	const int vectorCount = problem->GetVectorCount();
+	CArray<int> counts;
+	counts.Add( 0, vectorCount );
+	for( int i = 0; i < sampleSize; i++ ) {
+		counts[random.UniformInt( 0, vectorCount - 1 )]++;
+	}
+
+	CFloatMatrixDesc baseMatrix = problem->GetMatrix();
+	for( int i = 0; i < vectorCount; i++ ) {
+		if( counts[i] > 0 ) {
+			originalIndices.Add( i );
+			drawCounts.Add( counts[i] );
+			pointerB.Add( baseMatrix.PointerB[i] );
+			pointerE.Add( baseMatrix.PointerE[i] );
+		}
+	}
+
+	matrix.Height = originalIndices.Size();
+	matrix.Width = baseMatrix.Width;
+	matrix.Columns = baseMatrix.Columns;
+	matrix.Values = baseMatrix.Values;
+	matrix.PointerB = pointerB.GetPtr();
+	matrix.PointerE = pointerE.GetPtr();
+}
+
+//---------------------------------------------------------------------------------------------------------
+
+CRandomForest::CRandomForest( const CParams& _params, CRandom* _random ) :
+	params( _params ),
+	random( _random != nullptr ? *_random : defRandom ),
+	logStream( 0 )
+{
+	NeoAssert( params.TreeCount > 0 );
+	NeoAssert( params.SubsampleRate > 0 );
+	NeoAssert( params.ThreadCount > 0 );
+}
+
+CPtr<IModel> CRandomForest::Train( const IProblem& problem )
+{
+	NeoAssert( problem.GetVectorCount() > 0 );
+	NeoAssert( problem.GetClassCount() > 1 );
+	NeoAssert( problem.GetFeatureCount() > 0 );
+
+	if( logStream != 0 ) {
+		*logStream << "\nRandom forest training started:\n";
+	}
+
+	CDecisionTree::CParams treeParams = params.TreeParams;
+	if( treeParams.RandomSelectedFeaturesCount == NotFound ) {
+		treeParams.RandomSelectedFeaturesCount = max( 1,
+			static_cast<int>( sqrt( static_cast<double>( problem.GetFeatureCount() ) ) ) );
+	}
+	const int sampleSize = max( 1, static_cast<int>( problem.GetVectorCount() * params.SubsampleRate ) );
+
+	// The seeds are generated beforehand so that the result would not depend on the number of threads
+	CArray<unsigned int> seeds;
+	seeds.SetBufferSize( params.TreeCount );
+	for( int i = 0; i < params.TreeCount; i++ ) {
+		seeds.Add( random.Next() );
+	}
+
+	CObjectArray<IModel> trees;
+	trees.SetSize( params.TreeCount );
+	NEOML_OMP_NUM_THREADS( params.ThreadCount ) {
+		int firstTree = 0;
+		int treeCount = 0;
+		if( OmpGetTaskIndexAndCount( params.TreeCount, firstTree, treeCount ) ) {
+			for( int i = firstTree; i < firstTree + treeCount; i++ ) {
+				CRandom treeRandom( seeds[i] );
+				CPtr<IProblem> sample = FINE_DEBUG_NEW CBootstrapSubProblem( &problem, sampleSize, treeRandom );
+				CDecisionTree tree( treeParams, &treeRandom );
+				trees[i] = tree.Train( *sample );
+			}
+		}
+	}
+
+	if( logStream != 0 ) {
+		*logStream << "\nRandom forest training finished\n";
+	}
+
+	return FINE_DEBUG_NEW CRandomForestModel( trees, problem.GetClassCount() );
+}
+
+} // namespace NeoML
@@ -0,0 +1,113 @@
+/* Copyright © 2017-2020 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <RandomForestModel.h>
+#include <NeoMathEngine/OpenMP.h>
+
+namespace NeoML {
+
+IRandomForestModel::~IRandomForestModel()
+{
+}
+
+REGISTER_NEOML_MODEL( CRandomForestModel, RandomForestModelName )
+
+CRandomForestModel::CRandomForestModel( CObjectArray<IModel>& _trees, int _classCount ) :
+	classCount( _classCount )
+{
+	NeoAssert( !_trees.IsEmpty() );
+	NeoAssert( classCount > 1 );
+	_trees.MoveTo( trees );
+}
+
+bool CRandomForestModel::Classify( const CFloatVectorDesc& data, CClassificationResult& result ) const
+{
+	CClassificationResult treeResult;
+	return classify( data, treeResult, result );
+}
+
+bool CRandomForestModel::ClassifyBatch( const CFloatMatrixDesc& data, CArray<CClassificationResult>& results,
+	int threadCount ) const
+{
+	NeoAssert( threadCount > 0 );
+	results.SetSize( data.Height );
+
+	CArray<bool> isSucceeded;
+	isSucceeded.Add( true, threadCount );
+	NEOML_OMP_NUM_THREADS( threadCount ) {
+		int firstVector = 0;
+		int vectorCount = 0;
+		if( OmpGetTaskIndexAndCount( data.Height, firstVector, vectorCount ) ) {
+			const int lastVector = firstVector + vectorCount;
+			// The tree result is reused to avoid the allocations for every tree
+			CClassificationResult treeResult;
+			CFloatVectorDesc row;
+			for( int i = firstVector; i < lastVector; i++ ) {
+				data.GetRow( i, row );
+				if( !classify( row, treeResult, results[i] ) ) {
+					isSucceeded[OmpGetThreadNum()] = false;
+				}
+			}
+		}
+	}
+	return isSucceeded.Find( false ) == NotFound;
+}
+
+void CRandomForestModel::Serialize( CArchive& archive )
+{
+	archive.SerializeVersion( 0 );
+
+	archive.Serialize( classCount );
+	int treeCount = trees.Size();
+	archive.Serialize( treeCount );
+	trees.SetSize( treeCount );
+	for( int i = 0; i < trees.Size(); i++ ) {
+		SerializeModel( archive, trees[i] );
+	}
+}
+
+// Averages the class probabilities over the trees
+bool CRandomForestModel::classify( const CFloatVectorDesc& data, CClassificationResult& treeResult,
+	CClassificationResult& result ) const
+{
+	CArray<double> probabilities;
+	probabilities.Add( 0., classCount );
+
+	for( int i = 0; i < trees.Size(); i++ ) {
+		if( !trees[i]->Classify( data, treeResult ) ) {
+			return false;
+		}
+		NeoAssert( treeResult.Probabilities.Size() == classCount );
+		for( int j = 0; j < classCount; j++ ) {
+			probabilities[j] += treeResult.Probabilities[j].GetValue();
+		}
+	}
+
+	result.PreferredClass = 0;
+	result.ExceptionProbability = CClassificationProbability( 0 );
+	result.Probabilities.SetSize( classCount );
+	for( int j = 0; j < classCount; j++ ) {
+		result.Probabilities[j] = CClassificationProbability( probabilities[j] / trees.Size() );
+		if( probabilities[j] > probabilities[result.PreferredClass] ) {
+			result.PreferredClass = j;
+		}
+	}
+	return true;
+}
+
+} // namespace NeoML
@@ -17,6 +17,7 @@ limitations under the License.
 #pragma hdrstop
 
 #include <SvmBinaryModel.h>
+#include <LinearFunctionBatch.h>
 
 namespace NeoML {
 
@@ -63,6 +64,56 @@ bool CSvmBinaryModel::Classify( const CFloatVectorDesc& data, CClassificationRes
 		value += alpha[i] * kernel.Calculate( data, desc );
 	}
 
+	classify( value, result );
+	return true;
+}
+
+bool CSvmBinaryModel::ClassifyBatch( const CFloatMatrixDesc& data, CArray<CClassificationResult>& results,
+	int threadCount ) const
+{
+	if( kernel.KernelType() != CSvmKernel::KT_Linear ) {
+		return ISvmBinaryModel::ClassifyBatch( data, results, threadCount );
+	}
+
+	// The linear kernel decision function is a single dot product with the weighted sum of the support vectors
+	CFloatVector plane;
+	calcLinearKernelPlane( plane );
+
+	CArray<double> values;
+	values.SetSize( data.Height );
+	LinearFunctionBatch( plane, data, threadCount, values.GetPtr() );
+
+	results.SetSize( data.Height );
+	for( int i = 0; i < data.Height; i++ ) {
+		classify( freeTerm + values[i], results[i] );
+	}
+	return true;
+}
+
+// Calculates the plane equal to the weighted sum of the support vectors (the free term of the plane is zero)
+void CSvmBinaryModel::calcLinearKernelPlane( CFloatVector& plane ) const
+{
+	CArray<double> weights;
+	weights.Add( 0., matrix.GetWidth() );
+	CFloatVectorDesc desc;
+	for( int i = 0; i < alpha.Size(); i++ ) {
+		matrix.GetRow( i, desc );
+		for( int j = 0; j < desc.Size; j++ ) {
+			weights[desc.Indexes == nullptr ? j : desc.Indexes[j]] += alpha[i] * desc.Values[j];
+		}
+	}
+
+	plane = CFloatVector( weights.Size() + 1 );
+	float* planePtr = plane.CopyOnWrite();
+	for( int i = 0; i < weights.Size(); i++ ) {
+		planePtr[i] = static_cast<float>( weights[i] );
+	}
+	planePtr[weights.Size()] = 0.f;
+}
+
+// Calculates the classification result from the value of the decision function
+void CSvmBinaryModel::classify( double value, CClassificationResult& result )
+{
 	const double probability = 1 / ( 1 + exp( value ) );
 	result.ExceptionProbability = CClassificationProbability( 0 );
 	result.Probabilities.SetSize( 2 );
@@ -74,7 +125,6 @@ bool CSvmBinaryModel::Classify( const CFloatVectorDesc& data, CClassificationRes
 	} else {
 		result.PreferredClass = 1;
 	}
-	return true;
 }
 
 void CSvmBinaryModel::Serialize( CArchive& archive )
@@ -31,6 +31,8 @@ public:
 	// IModel interface methods
 	virtual int GetClassCount() const { return 2; }
 	virtual bool Classify( const CFloatVectorDesc& data, CClassificationResult& result ) const;
+	virtual bool ClassifyBatch( const CFloatMatrixDesc& data, CArray<CClassificationResult>& results,
+		int threadCount ) const;
 	virtual void Serialize( CArchive& archive );
 
 	// ISvmBinaryModel interface methods
@@ -47,6 +49,9 @@ private:
 	double freeTerm; // the free term
 	CSparseFloatMatrix matrix; // the support vectors
 	CArray<double> alpha; // the coefficients
+
+	void calcLinearKernelPlane( CFloatVector& plane ) const;
+	static void classify( double value, CClassificationResult& result );
 };
 
 } // namespace NeoML
@@ -0,0 +1,82 @@
+/* Copyright © 2017-2020 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+// The file is compiled with AVX2 support; its functions are called only if the processor supports it
+
+#include <common.h>
+#pragma hdrstop
+
+#include <GradientBoostQSKernels.h>
+#include <immintrin.h>
+
+namespace NeoML {
+
+static_assert( QSBlockSize == 16, "The AVX2 kernels process the block as 2 registers of 8 floats" );
+
+// Applies the mask to the 4 registers of the tree bitvectors in the lanes where the 32-bit criterion is not fulfilled
+static inline void applyMaskAvx2( __m256 isApplied0, __m256 isApplied1, __m256i notMask, unsigned long long* treeBitvectors )
+{
+	__m256i* bitvectors = reinterpret_cast<__m256i*>( treeBitvectors );
+	const __m256i applied0 = _mm256_castps_si256( isApplied0 );
+	const __m256i applied1 = _mm256_castps_si256( isApplied1 );
+	// Extend the 32-bit results of the comparison to the 64-bit bitvector lanes
+	const __m256i lanes[4] = {
+		_mm256_cvtepi32_epi64( _mm256_castsi256_si128( applied0 ) ),
+		_mm256_cvtepi32_epi64( _mm256_extracti128_si256( applied0, 1 ) ),
+		_mm256_cvtepi32_epi64( _mm256_castsi256_si128( applied1 ) ),
+		_mm256_cvtepi32_epi64( _mm256_extracti128_si256( applied1, 1 ) )
+	};
+	// bitvector & ( isApplied ? mask : ~0 ) == bitvector & ~( isApplied & ~mask )
+	for( int i = 0; i < 4; i++ ) {
+		const __m256i clear = _mm256_and_si256( lanes[i], notMask );
+		_mm256_storeu_si256( bitvectors + i, _mm256_andnot_si256( clear, _mm256_loadu_si256( bitvectors + i ) ) );
+	}
+}
+
+void QSBlockScanLessAvx2( const CQSNode* nodes, int nodeCount, const float* values, unsigned long long* bitvectors )
+{
+	const __m256 values0 = _mm256_loadu_ps( values );
+	const __m256 values1 = _mm256_loadu_ps( values + 8 );
+	for( int i = 0; i < nodeCount; i++ ) {
+		const CQSNode& node = nodes[i];
+		const __m256 threshold = _mm256_set1_ps( node.Threshold );
+		const __m256 isApplied0 = _mm256_cmp_ps( threshold, values0, _CMP_LT_OQ );
+		const __m256 isApplied1 = _mm256_cmp_ps( threshold, values1, _CMP_LT_OQ );
+		if( _mm256_movemask_ps( _mm256_or_ps( isApplied0, isApplied1 ) ) == 0 ) {
+			return;
+		}
+		applyMaskAvx2( isApplied0, isApplied1, _mm256_set1_epi64x( static_cast<long long>( ~node.Mask ) ),
+			bitvectors + node.Tree * QSBlockSize );
+	}
+}
+
+void QSBlockScanMoreAvx2( const CQSNode* nodes, int nodeCount, const float* values, unsigned long long* bitvectors )
+{
+	const __m256 values0 = _mm256_loadu_ps( values );
+	const __m256 values1 = _mm256_loadu_ps( values + 8 );
+	for( int i = 0; i < nodeCount; i++ ) {
+		const CQSNode& node = nodes[i];
+		const __m256 threshold = _mm256_set1_ps( node.Threshold );
+		const __m256 isApplied0 = _mm256_cmp_ps( threshold, values0, _CMP_GE_OQ );
+		const __m256 isApplied1 = _mm256_cmp_ps( threshold, values1, _CMP_GE_OQ );
+		if( _mm256_movemask_ps( _mm256_or_ps( isApplied0, isApplied1 ) ) == 0 ) {
+			return;
+		}
+		applyMaskAvx2( isApplied0, isApplied1, _mm256_set1_epi64x( static_cast<long long>( ~node.Mask ) ),
+			bitvectors + node.Tree * QSBlockSize );
+	}
+}
+
+} // namespace NeoML
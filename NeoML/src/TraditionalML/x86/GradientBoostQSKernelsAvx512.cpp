@@ -0,0 +1,67 @@
+/* Copyright © 2017-2020 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+// The file is compiled with AVX-512 support; its functions are called only if the processor supports it
+
+#include <common.h>
+#pragma hdrstop
+
+#include <GradientBoostQSKernels.h>
+#include <immintrin.h>
+
+namespace NeoML {
+
+static_assert( QSBlockSize == 16, "The AVX-512 kernels process the block as 1 register of 16 floats" );
+
+// Applies the mask to the 2 registers of the tree bitvectors in the lanes set in isApplied
+static inline void applyMaskAvx512( __mmask16 isApplied, __m512i mask, unsigned long long* treeBitvectors )
+{
+	const __m512i bitvectors0 = _mm512_loadu_si512( treeBitvectors );
+	const __m512i bitvectors1 = _mm512_loadu_si512( treeBitvectors + 8 );
+	_mm512_storeu_si512( treeBitvectors,
+		_mm512_mask_and_epi64( bitvectors0, static_cast<__mmask8>( isApplied ), bitvectors0, mask ) );
+	_mm512_storeu_si512( treeBitvectors + 8,
+		_mm512_mask_and_epi64( bitvectors1, static_cast<__mmask8>( isApplied >> 8 ), bitvectors1, mask ) );
+}
+
+void QSBlockScanLessAvx512( const CQSNode* nodes, int nodeCount, const float* values, unsigned long long* bitvectors )
+{
+	const __m512 blockValues = _mm512_loadu_ps( values );
+	for( int i = 0; i < nodeCount; i++ ) {
+		const CQSNode& node = nodes[i];
+		const __mmask16 isApplied = _mm512_cmp_ps_mask( _mm512_set1_ps( node.Threshold ), blockValues, _CMP_LT_OQ );
+		if( isApplied == 0 ) {
+			return;
+		}
+		applyMaskAvx512( isApplied, _mm512_set1_epi64( static_cast<long long>( node.Mask ) ),
+			bitvectors + node.Tree * QSBlockSize );
+	}
+}
+
+void QSBlockScanMoreAvx512( const CQSNode* nodes, int nodeCount, const float* values, unsigned long long* bitvectors )
+{
+	const __m512 blockValues = _mm512_loadu_ps( values );
+	for( int i = 0; i < nodeCount; i++ ) {
+		const CQSNode& node = nodes[i];
+		const __mmask16 isApplied = _mm512_cmp_ps_mask( _mm512_set1_ps( node.Threshold ), blockValues, _CMP_GE_OQ );
+		if( isApplied == 0 ) {
+			return;
+		}
+		applyMaskAvx512( isApplied, _mm512_set1_epi64( static_cast<long long>( node.Mask ) ),
+			bitvectors + node.Tree * QSBlockSize );
+	}
+}
+
+} // namespace NeoML
@@ -0,0 +1,78 @@
+/* Copyright © 2017-2020 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+// The file is compiled with AVX2 and FMA support; its functions are called only if the processor supports them
+
+#include <common.h>
+#pragma hdrstop
+
+#include <HnswDistance.h>
+#include <immintrin.h>
+
+namespace NeoML {
+
+static inline float horizontalSumAvx( __m256 value )
+{
+	__m128 sum = _mm_add_ps( _mm256_castps256_ps128( value ), _mm256_extractf128_ps( value, 1 ) );
+	sum = _mm_add_ps( sum, _mm_movehl_ps( sum, sum ) );
+	sum = _mm_add_ss( sum, _mm_shuffle_ps( sum, sum, 1 ) );
+	return _mm_cvtss_f32( sum );
+}
+
+float HnswSquaredEuclidAvx2( const float* first, const float* second, int size )
+{
+	__m256 sum0 = _mm256_setzero_ps();
+	__m256 sum1 = _mm256_setzero_ps();
+	int i = 0;
+	for( ; i + 16 <= size; i += 16 ) {
+		const __m256 diff0 = _mm256_sub_ps( _mm256_loadu_ps( first + i ), _mm256_loadu_ps( second + i ) );
+		const __m256 diff1 = _mm256_sub_ps( _mm256_loadu_ps( first + i + 8 ), _mm256_loadu_ps( second + i + 8 ) );
+		sum0 = _mm256_fmadd_ps( diff0, diff0, sum0 );
+		sum1 = _mm256_fmadd_ps( diff1, diff1, sum1 );
+	}
+	if( i + 8 <= size ) {
+		const __m256 diff = _mm256_sub_ps( _mm256_loadu_ps( first + i ), _mm256_loadu_ps( second + i ) );
+		sum0 = _mm256_fmadd_ps( diff, diff, sum0 );
+		i += 8;
+	}
+	float result = horizontalSumAvx( _mm256_add_ps( sum0, sum1 ) );
+	for( ; i < size; i++ ) {
+		const float diff = first[i] - second[i];
+		result += diff * diff;
+	}
+	return result;
+}
+
+float HnswDotProductAvx2( const float* first, const float* second, int size )
+{
+	__m256 sum0 = _mm256_setzero_ps();
+	__m256 sum1 = _mm256_setzero_ps();
+	int i = 0;
+	for( ; i + 16 <= size; i += 16 ) {
+		sum0 = _mm256_fmadd_ps( _mm256_loadu_ps( first + i ), _mm256_loadu_ps( second + i ), sum0 );
+		sum1 = _mm256_fmadd_ps( _mm256_loadu_ps( first + i + 8 ), _mm256_loadu_ps( second + i + 8 ), sum1 );
+	}
+	if( i + 8 <= size ) {
+		sum0 = _mm256_fmadd_ps( _mm256_loadu_ps( first + i ), _mm256_loadu_ps( second + i ), sum0 );
+		i += 8;
+	}
+	float result = horizontalSumAvx( _mm256_add_ps( sum0, sum1 ) );
+	for( ; i < size; i++ ) {
+		result += first[i] * second[i];
+	}
+	return result;
+}
+
+} // namespace NeoML
@@ -886,3 +886,164 @@ TEST_F( CAutoDiffTest, TestBinaryCrossEntropy )
 		ASSERT_NEAR( gradRes[i], gradData[i], 1e-4 );
 	}
 }
+
+static void checkBlobsNear( const CDnnBlob& expected, const CDnnBlob& actual, float eps )
+{
+	ASSERT_EQ( expected.GetDataSize(), actual.GetDataSize() );
+	CArray<float> expectedData;
+	expectedData.SetSize( expected.GetDataSize() );
+	expected.CopyTo( expectedData.GetPtr() );
+	CArray<float> actualData;
+	actualData.SetSize( actual.GetDataSize() );
+	actual.CopyTo( actualData.GetPtr() );
+	for( int i = 0; i < expectedData.Size(); i++ ) {
+		ASSERT_NEAR( expectedData[i], actualData[i], eps * max( 1.f, fabsf( expectedData[i] ) ) );
+	}
+}
+
+static CPtr<CDnnBlob> createRandomBlob( IMathEngine& mathEngine, CRandom& random, const CBlobDesc& desc,
+	float minValue, float maxValue )
+{
+	CArray<float> data;
+	for( int i = 0; i < desc.BlobSize(); i++ ) {
+		data.Add( static_cast<float>( random.Uniform( minValue, maxValue ) ) );
+	}
+	CPtr<CDnnBlob> blob( CDnnBlob::CreateBlob( mathEngine, desc ) );
+	blob->CopyFrom( data.GetPtr() );
+	return blob;
+}
+
+// The expression uses all the elementwise operations
+static CPtr<const CDnnBlob> graphTestExpression( const CDnnBlob* x, const CDnnBlob* y, const CDnnBlob* labels )
+{
+	CPtr<const CDnnBlob> ratio = Div( Add( Mul( x, x ), 1.f ), Add( Abs( y ), 0.5f ) );
+	CPtr<const CDnnBlob> clipped = Clip( Sub( ratio, y ), -2.f, 3.f );
+	CPtr<const CDnnBlob> diff = Sub( Exp( Neg( Abs( Sub( clipped, labels ) ) ) ), Max( Sub( 0.5f, x ), 0.f ) );
+	return Mul( Log( Add( Mul( diff, diff ), 1.f ) ), Sub( y, 2.f ) );
+}
+
+TEST_F( CAutoDiffTest, TestGraphBinaryCrossEntropy )
+{
+	const int VectorSize = 16;
+
+	float valuesA[VectorSize] = { 0.501, 0.001, 0.002, 0.003, 0.004, 0.004, 0.005, 0.505,
+		0.010, 0.010, 0.011, 0.490, 0.489, 0.488, 0.487, 0.491 };
+	CPtr<CDnnBlob> a( CDnnBlob::CreateVector( MathEngine(), CT_Float, VectorSize ) );
+	a->CopyFrom( valuesA );
+
+	float valuesB[VectorSize] = { 0.001, 0.401, 0.002, 0.003, 0.004, 0.004, 0.005, 0.010,
+		0.405, 0.010, 0.011, 0.289, 0.390, 0.288, 0.391, 0.291 };
+	CPtr<CDnnBlob> b( CDnnBlob::CreateVector( MathEngine(), CT_Float, VectorSize ) );
+	b->CopyFrom( valuesB );
+
+	CPtr<CDnnBlob> xBlob( CDnnBlob::CreateVector( MathEngine(), CT_Float, VectorSize ) );
+	xBlob->Fill( 1.f );
+
+	CGradientTape tape;
+	CPtr<const CDnnBlob> x = tape.Variable( *xBlob );
+	CPtr<const CDnnBlob> loss = BinaryCrossEntropy( TopK( Mul( x, a ), 4 ), TopK( Mul( b, x ), 4 ), false );
+	CArray<const CDnnBlob*> inputs;
+	inputs.Add( x );
+	CTapeGraph graph( *loss, inputs );
+	ASSERT_EQ( 1, graph.GetInputCount() );
+
+	checkBlobsNear( *loss, *graph.Run(), 1e-5f );
+	checkBlobsNear( *tape.Gradient( *loss, *x ), *graph.Gradient( 0 ), 1e-4f );
+
+	// The graph is replayed for the new values of the variable
+	CRandom random( 0x1F );
+	for( int step = 0; step < 3; step++ ) {
+		CPtr<CDnnBlob> newX = createRandomBlob( MathEngine(), random, { VectorSize }, 0.5f, 2.f );
+		graph.SetInput( 0, *newX );
+
+		CGradientTape newTape;
+		CPtr<const CDnnBlob> newVar = newTape.Variable( *newX );
+		CPtr<const CDnnBlob> expected = BinaryCrossEntropy( TopK( Mul( newVar, a ), 4 ), TopK( Mul( b, newVar ), 4 ), false );
+		checkBlobsNear( *expected, *graph.Run(), 1e-5f );
+		checkBlobsNear( *newTape.Gradient( *expected, *newVar ), *graph.Gradient( 0 ), 1e-4f );
+	}
+}
+
+TEST_F( CAutoDiffTest, TestGraphFusedOperations )
+{
+	// The size isn't a multiple of the tile size
+	const int VectorSize = 10007;
+	CRandom random( 0x2A );
+	CPtr<CDnnBlob> xBlob = createRandomBlob( MathEngine(), random, { VectorSize }, -2.f, 2.f );
+	CPtr<CDnnBlob> yBlob = createRandomBlob( MathEngine(), random, { VectorSize }, -2.f, 2.f );
+	CPtr<CDnnBlob> labels = createRandomBlob( MathEngine(), random, { VectorSize }, -1.f, 1.f );
+
+	CGradientTape tape;
+	CPtr<const CDnnBlob> x = tape.Variable( *xBlob );
+	CPtr<const CDnnBlob> y = tape.Variable( *yBlob );
+	CPtr<const CDnnBlob> expression = graphTestExpression( x, y, labels );
+	CPtr<const CDnnBlob> loss = Sum( expression, -1 );
+
+	CArray<const CDnnBlob*> inputs;
+	inputs.Add( x );
+	inputs.Add( y );
+	inputs.Add( labels );
+	CTapeGraph graph( *loss, inputs );
+	CTapeGraph elementwiseGraph( *expression, inputs );
+
+	checkBlobsNear( *loss, *graph.Run(), 1e-4f );
+	checkBlobsNear( *expression, *elementwiseGraph.Run(), 1e-5f );
+	for( int i = 0; i < 2; i++ ) {
+		const CDnnBlob& var = i == 0 ? *x : *y;
+		checkBlobsNear( *tape.Gradient( *loss, var ), *graph.Gradient( i ), 1e-4f );
+		checkBlobsNear( *tape.Gradient( *expression, var ), *elementwiseGraph.Gradient( i ), 1e-4f );
+	}
+	// The labels are not a tape variable
+	EXPECT_TRUE( graph.Gradient( 2 ) == 0 );
+
+	// The new labels change the result
+	CPtr<CDnnBlob> newLabels = createRandomBlob( MathEngine(), random, { VectorSize }, -1.f, 1.f );
+	graph.SetInput( 2, *newLabels );
+	CGradientTape newTape;
+	CPtr<const CDnnBlob> newX = newTape.Variable( *xBlob );
+	CPtr<const CDnnBlob> newY = newTape.Variable( *yBlob );
+	CPtr<const CDnnBlob> newLoss = Sum( graphTestExpression( newX, newY, newLabels ), -1 );
+	checkBlobsNear( *newLoss, *graph.Run(), 1e-4f );
+	checkBlobsNear( *newTape.Gradient( *newLoss, *newX ), *graph.Gradient( 0 ), 1e-4f );
+	checkBlobsNear( *newTape.Gradient( *newLoss, *newY ), *graph.Gradient( 1 ), 1e-4f );
+}
+
+TEST_F( CAutoDiffTest, TestGraphSumAlongAxis )
+{
+	const int Height = 6;
+	const int Width = 5;
+	CRandom random( 0x3B );
+	CPtr<CDnnBlob> xBlob = createRandomBlob( MathEngine(), random, { Height, Width }, -1.f, 1.f );
+	CPtr<CDnnBlob> a = createRandomBlob( MathEngine(), random, { Height, Width }, -1.f, 1.f );
+
+	CGradientTape tape;
+	CPtr<const CDnnBlob> x = tape.Variable( *xBlob );
+	// The result of the sum is used by the next fused group
+	CPtr<const CDnnBlob> rows = Sum( Mul( Exp( x ), a ), BD_Depth );
+	CPtr<const CDnnBlob> loss = Sum( Mul( rows, rows ), -1 );
+
+	CArray<const CDnnBlob*> inputs;
+	inputs.Add( x );
+	CTapeGraph graph( *loss, inputs );
+	checkBlobsNear( *loss, *graph.Run(), 1e-4f );
+
+	// d(loss)/dx[h][w] = 2 * rows[w] * exp(x[h][w]) * a[h][w]
+	CArray<float> xData;
+	xData.SetSize( xBlob->GetDataSize() );
+	xBlob->CopyTo( xData.GetPtr() );
+	CArray<float> aData;
+	aData.SetSize( a->GetDataSize() );
+	a->CopyTo( aData.GetPtr() );
+	CArray<float> rowsData;
+	rowsData.SetSize( rows->GetDataSize() );
+	rows->CopyTo( rowsData.GetPtr() );
+	CPtr<const CDnnBlob> grad = graph.Gradient( 0 );
+	CArray<float> gradData;
+	gradData.SetSize( grad->GetDataSize() );
+	grad->CopyTo( gradData.GetPtr() );
+	ASSERT_EQ( Height * Width, gradData.Size() );
+	for( int i = 0; i < gradData.Size(); i++ ) {
+		const float expected = 2 * rowsData[i % Width] * expf( xData[i] ) * aData[i];
+		ASSERT_NEAR( expected, gradData[i], 1e-4 );
+	}
+}
@@ -25,9 +25,42 @@ using namespace NeoMLTest;
 //---------------------------------------------------------------------------------------------------------------------
 // Common functions
 
+// Checks that the batch classification gives the same results as the classification of separate vectors
+void TestClassifyBatch( const IModel* model, const CClassificationRandomProblem* testData )
+{
+	const int threadCount = 4;
+	CArray<CClassificationResult> results;
+	ASSERT_TRUE( model->ClassifyBatch( testData->GetMatrix(), results, threadCount ) );
+	ASSERT_EQ( testData->GetVectorCount(), results.Size() );
+
+	for( int i = 0; i < testData->GetVectorCount(); i++ ) {
+		CClassificationResult expected;
+		ASSERT_TRUE( model->Classify( testData->GetVector( i ), expected ) );
+		ASSERT_EQ( expected.Probabilities.Size(), results[i].Probabilities.Size() );
+		// The batch calculations may change the rounding errors (e.g. for SVM with the linear kernel)
+		for( int j = 0; j < expected.Probabilities.Size(); j++ ) {
+			const double expectedValue = expected.Probabilities[j].GetValue();
+			const double value = results[i].Probabilities[j].GetValue();
+			if( std::isnan( expectedValue ) ) {
+				ASSERT_TRUE( std::isnan( value ) );
+			} else {
+				ASSERT_NEAR( expectedValue, value, 1e-5 );
+			}
+		}
+		if( !( fabs( expected.Probabilities[expected.PreferredClass].GetValue()
+			- expected.Probabilities[results[i].PreferredClass].GetValue() ) <= 1e-5 ) )
+		{
+			ASSERT_EQ( expected.PreferredClass, results[i].PreferredClass );
+		}
+	}
+}
+
 void TestClassificationResult( const IModel* modelDense, const IModel* modelSparse,
 	const CClassificationRandomProblem* testDataDense, const CClassificationRandomProblem* testDataSparse )
 {
+	TestClassifyBatch( modelDense, testDataDense );
+	TestClassifyBatch( modelSparse, testDataSparse );
+
 	for( int i = 0; i < testDataSparse->GetVectorCount(); i++ ) {
 		CClassificationResult result1;
 		CClassificationResult result2;
@@ -45,6 +78,18 @@ void TestClassificationResult( const IModel* modelDense, const IModel* modelSpar
 	}
 }
 
+// Checks that the batch prediction gives the same results as the prediction on separate vectors
+template<class TProblem>
+void TestPredictBatch( const IRegressionModel* model, const TProblem* testData )
+{
+	CArray<double> results;
+	model->PredictBatch( testData->GetMatrix(), results, 4 );
+	ASSERT_EQ( testData->GetVectorCount(), results.Size() );
+	for( int i = 0; i < testData->GetVectorCount(); i++ ) {
+		ASSERT_DOUBLE_EQ( model->Predict( testData->GetVector( i ) ), results[i] );
+	}
+}
+
 void CrossValidate( int PartsCount, ITrainingModel& trainingModel, const IProblem* dense, const IProblem* sparse )
 {
 	CCrossValidation CrossValidation( trainingModel, dense );
@@ -185,6 +230,9 @@ protected:
 
 	void TestBinaryRegressionResult() const
 	{
+		TestPredictBatch( ModelDense.Ptr(), DenseBinaryTestData );
+		TestPredictBatch( ModelSparse.Ptr(), SparseBinaryTestData );
+
 		for( int i = 0; i < SparseBinaryTestData->GetVectorCount(); i++ ) {
 			double result1 = ModelDense->Predict( DenseBinaryTestData->GetVector( i ) );
 			double result2 = ModelDense->Predict( SparseBinaryTestData->GetVector( i ) );
@@ -278,6 +326,10 @@ protected:
 			ASSERT_EQ( ::memcmp( v1.Indexes, v2.Indexes, ( v2.Indexes == nullptr ? 0 : v2.Size )*sizeof( float ) ), 0 );
 		};
 
+		CArray<CFloatVector> batchResults;
+		ModelDense->MultivariatePredictBatch( DenseMultiTestData->GetMatrix(), batchResults, 4 );
+		ASSERT_EQ( DenseMultiTestData->GetVectorCount(), batchResults.Size() );
+
 		for( int i = 0; i < SparseMultiTestData->GetVectorCount(); i++ ) {
 			CFloatVector result1 = ModelDense->MultivariatePredict( DenseMultiTestData->GetVector( i ) );
 			CFloatVector result2 = ModelDense->MultivariatePredict( SparseMultiTestData->GetVector( i ) );
@@ -287,6 +339,7 @@ protected:
 			cmpFloatVectors( result1.GetDesc(), result2.GetDesc() );
 			cmpFloatVectors( result1.GetDesc(), result3.GetDesc() );
 			cmpFloatVectors( result1.GetDesc(), result4.GetDesc() );
+			cmpFloatVectors( result1.GetDesc(), batchResults[i].GetDesc() );
 		}
 	}
 };
@@ -327,6 +380,77 @@ TEST_F( RandomBinaryClassification4000x20, DecisionTree )
 	TestBinaryClassificationResult();
 }
 
+TEST_F( RandomBinaryClassification4000x20, RandomForest )
+{
+	CRandomForest::CParams params;
+	params.TreeCount = 20;
+	params.ThreadCount = 4;
+	// The same random seed is used for dense and sparse data so that the same trees would be built
+	CRandom denseRandom( 0 );
+	CRandomForest denseForest( params, &denseRandom );
+	ModelDense = denseForest.Train( *DenseRandomBinaryProblem );
+	CRandom sparseRandom( 0 );
+	CRandomForest sparseForest( params, &sparseRandom );
+	ModelSparse = sparseForest.Train( *SparseRandomBinaryProblem );
+	TestBinaryClassificationResult();
+}
+
+// Compares the block-wise classification of the dense matrix with the classification of the rows one by one
+TEST_F( RandomBinaryClassification4000x20, QuickScorerBlocks )
+{
+	CRandom random( 0 );
+	CGradientBoost::CParams params;
+	params.Random = &random;
+	params.IterationsCount = 300;
+	// The trees fit into 64 leaves entirely, as usual for the ranking models
+	params.MaxTreeDepth = 6;
+	params.Representation = GBMR_QuickScorer;
+	CGradientBoost boosting( params );
+	CPtr<IGradientBoostQSModel> model = boosting.TrainModel<IGradientBoostQSModel>( *DenseRandomBinaryProblem );
+	ASSERT_TRUE( model != nullptr );
+
+	const CFloatMatrixDesc matrix = DenseBinaryTestData->GetMatrix();
+	CArray<float> data;
+	data.SetSize( matrix.Height * matrix.Width );
+	for( int i = 0; i < matrix.Height; i++ ) {
+		::memcpy( data.GetPtr() + i * matrix.Width, matrix.GetRow( i ).Values, matrix.Width * sizeof( float ) );
+	}
+
+	CArray<CClassificationResult> results;
+	int begin = GetTickCount();
+	ASSERT_TRUE( model->ClassifyDenseBatch( data.GetPtr(), matrix.Height, matrix.Width, results ) );
+	GTEST_LOG_( INFO ) << "Block-wise classification time: " << GetTickCount() - begin;
+	ASSERT_EQ( matrix.Height, results.Size() );
+
+	CArray<CClassificationResult> expected;
+	expected.SetSize( matrix.Height );
+	begin = GetTickCount();
+	for( int i = 0; i < matrix.Height; i++ ) {
+		model->Classify( matrix.GetRow( i ), expected[i] );
+	}
+	GTEST_LOG_( INFO ) << "Row-wise classification time: " << GetTickCount() - begin;
+
+	// ClassifyEx calculates the results for all the prefixes of the ensemble; the last one is for the whole ensemble
+	CArray<CClassificationResult> resultsEx;
+	CArray<int> preferredClassesEx;
+	preferredClassesEx.SetSize( matrix.Height );
+	begin = GetTickCount();
+	for( int i = 0; i < matrix.Height; i++ ) {
+		model->ClassifyEx( matrix.GetRow( i ), resultsEx );
+		preferredClassesEx[i] = resultsEx.Last().PreferredClass;
+	}
+	GTEST_LOG_( INFO ) << "ClassifyEx time: " << GetTickCount() - begin;
+
+	for( int i = 0; i < matrix.Height; i++ ) {
+		ASSERT_EQ( preferredClassesEx[i], results[i].PreferredClass );
+		ASSERT_EQ( expected[i].PreferredClass, results[i].PreferredClass );
+		ASSERT_EQ( expected[i].Probabilities.Size(), results[i].Probabilities.Size() );
+		for( int j = 0; j < expected[i].Probabilities.Size(); j++ ) {
+			ASSERT_DOUBLE_EQ( expected[i].Probabilities[j].GetValue(), results[i].Probabilities[j].GetValue() );
+		}
+	}
+}
+
 TEST_F( RandomMultiClassification2000x20, GBTB_Full )
 {
 	CRandom random( 0 );
@@ -403,6 +527,52 @@ TEST_F( RandomMultiClassification2000x20, GBMR_QuickScorer )
 	TestMultiClassificationResult();
 }
 
+TEST_F( RandomMultiClassification2000x20, RandomForest )
+{
+	CRandomForest::CParams params;
+	params.TreeCount = 20;
+	params.ThreadCount = 4;
+	CRandom denseRandom( 0 );
+	CRandomForest denseForest( params, &denseRandom );
+	ModelDense = denseForest.Train( *DenseRandomMultiProblem );
+	CRandom sparseRandom( 0 );
+	CRandomForest sparseForest( params, &sparseRandom );
+	ModelSparse = sparseForest.Train( *SparseRandomMultiProblem );
+	TestMultiClassificationResult();
+
+	// The trees don't depend on the number of threads
+	params.ThreadCount = 1;
+	CRandom random( 0 );
+	CRandomForest forest( params, &random );
+	CPtr<IModel> model = forest.Train( *DenseRandomMultiProblem );
+
+	const char* fileName = "random_forest_test.arch";
+	{
+		CArchiveFile archiveFile( fileName, CArchive::store, GetPlatformEnv() );
+		CArchive archive( &archiveFile, CArchive::SD_Storing );
+		SerializeModel( archive, model );
+	}
+	CPtr<IModel> loadedModel;
+	{
+		CArchiveFile archiveFile( fileName, CArchive::load, GetPlatformEnv() );
+		CArchive archive( &archiveFile, CArchive::SD_Loading );
+		SerializeModel( archive, loadedModel );
+	}
+	::remove( fileName );
+	ASSERT_EQ( ModelDense->GetClassCount(), loadedModel->GetClassCount() );
+
+	for( int i = 0; i < DenseMultiTestData->GetVectorCount(); i++ ) {
+		CClassificationResult expected;
+		CClassificationResult result;
+		ASSERT_TRUE( ModelDense->Classify( DenseMultiTestData->GetVector( i ), expected ) );
+		ASSERT_TRUE( loadedModel->Classify( DenseMultiTestData->GetVector( i ), result ) );
+		ASSERT_EQ( expected.PreferredClass, result.PreferredClass );
+		for( int j = 0; j < expected.Probabilities.Size(); j++ ) {
+			ASSERT_DOUBLE_EQ( expected.Probabilities[j].GetValue(), result.Probabilities[j].GetValue() );
+		}
+	}
+}
+
 TEST_F( RandomMultiClassification2000x20, OneVsAllLinear )
 {
 	CLinear linear( EF_SquaredHinge );
@@ -568,6 +738,9 @@ TEST_F( RandomBinaryRegression4000x20, Linear )
 		ASSERT_DOUBLE_EQ( result1, result3 );
 		ASSERT_DOUBLE_EQ( result1, result4 );
 	}
+
+	TestPredictBatch( model.Ptr(), denseBinaryTestData.Ptr() );
+	TestPredictBatch( model2.Ptr(), sparseBinaryTestData.Ptr() );
 }
 
 // GB binary tree builders
@@ -592,6 +765,40 @@ TEST_F( RandomBinaryGBRegression4000x20, FastHist )
 	TestBinaryRegressionResult();
 }
 
+TEST_F( RandomBinaryGBRegression4000x20, FastHistMultiThread )
+{
+	CRandom random( 0 );
+	CGradientBoost::CParams params;
+	params.Random = &random;
+	params.IterationsCount = 10;
+	params.TreeBuilder = GBTB_FastHist;
+	params.ThreadCount = 4;
+	TrainBinaryGradientBoost( params );
+	TestBinaryRegressionResult();
+
+	// The histograms of the wide problem have up to 200 * 32 bins, so the histogram of the root is built by vectors
+	// and the histograms of the nodes with less than 800 vectors are built by features
+	CRandom problemRandom( 0x1234 );
+	CPtr<CClassificationRandomProblem> wideProblem = CClassificationRandomProblem::Random( problemRandom, 1000, 200, 2 );
+	CArray<double> expected;
+	for( int threadCount : { 1, 4 } ) {
+		random.Reset( 0 );
+		params.ThreadCount = threadCount;
+		CGradientBoost boosting( params );
+		CPtr<IRegressionModel> model = boosting.TrainModel<IRegressionModel>( *wideProblem );
+		ASSERT_TRUE( model != nullptr );
+		// The trees don't depend on the number of threads
+		for( int i = 0; i < wideProblem->GetVectorCount(); i++ ) {
+			const double prediction = model->Predict( wideProblem->GetVector( i ) );
+			if( threadCount == 1 ) {
+				expected.Add( prediction );
+			} else {
+				ASSERT_EQ( expected[i], prediction );
+			}
+		}
+	}
+}
+
 // GB multi tree builders
 TEST_F( RandomMultiGBRegression2000x20, Full )
 {
@@ -670,6 +877,54 @@ TEST_F( RandomBinaryGBRegression4000x20, QuickScorer )
 	TestBinaryRegressionResult();
 }
 
+TEST_F( RandomBinaryGBRegression4000x20, QuickScorerBlocks )
+{
+	CRandom random( 0 );
+	CGradientBoost::CParams params;
+	params.Random = &random;
+	params.IterationsCount = 50;
+	params.Representation = GBMR_QuickScorer;
+	TrainBinaryGradientBoost( params );
+
+	// The number of rows is not divisible by the block size
+	const CFloatMatrixDesc matrix = DenseBinaryTestData->GetMatrix();
+
+	CArray<double> results;
+	int begin = GetTickCount();
+	ModelDense->PredictBatch( matrix, results, 1 );
+	GTEST_LOG_( INFO ) << "Block-wise prediction time: " << GetTickCount() - begin;
+	ASSERT_EQ( matrix.Height, results.Size() );
+
+	CArray<double> expected;
+	expected.SetSize( matrix.Height );
+	begin = GetTickCount();
+	for( int i = 0; i < matrix.Height; i++ ) {
+		expected[i] = ModelDense->Predict( matrix.GetRow( i ) );
+	}
+	GTEST_LOG_( INFO ) << "Row-wise prediction time: " << GetTickCount() - begin;
+
+	for( int i = 0; i < matrix.Height; i++ ) {
+		ASSERT_DOUBLE_EQ( expected[i], results[i] );
+	}
+
+	ModelDense->PredictBatch( matrix, results, 3 );
+	for( int i = 0; i < matrix.Height; i++ ) {
+		ASSERT_DOUBLE_EQ( expected[i], results[i] );
+	}
+
+	// The dense row-major matrix
+	CArray<float> data;
+	data.SetSize( matrix.Height * matrix.Width );
+	for( int i = 0; i < matrix.Height; i++ ) {
+		::memcpy( data.GetPtr() + i * matrix.Width, matrix.GetRow( i ).Values, matrix.Width * sizeof( float ) );
+	}
+	CheckCast<IGradientBoostQSRegressionModel>( ModelDense.Ptr() )->PredictDenseBatch( data.GetPtr(),
+		matrix.Height, matrix.Width, results, 2 );
+	for( int i = 0; i < matrix.Height; i++ ) {
+		ASSERT_DOUBLE_EQ( expected[i], results[i] );
+	}
+}
+
 // test GB multi model's representations (to test MultivariatePredict)
 TEST_F( RandomMultiGBRegression2000x20, Linked )
 {
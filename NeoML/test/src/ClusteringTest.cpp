@@ -164,6 +164,18 @@ static void hierarchicalClustering( IClusteringData* data, CClusteringResult& re
 	hierarchical.Clusterize( data, result );
 }
 
+static void hierarchicalWardClustering( IClusteringData* data, CClusteringResult& result )
+{
+	CHierarchicalClustering::CParam params;
+	params.DistanceType = DF_Euclid;
+	params.MinClustersCount = 2;
+	params.Linkage = CHierarchicalClustering::L_Ward;
+	params.ThreadCount = 4;
+
+	CHierarchicalClustering hierarchical( params );
+	hierarchical.Clusterize( data, result );
+}
+
 static void isoDataClustering( IClusteringData* data, CClusteringResult& result )
 {
 	CIsoDataClustering::CParam params;
@@ -207,6 +219,35 @@ static void kmeansElkanClustering( IClusteringData* data, CClusteringResult& res
 	kMeans.Clusterize( data, result );
 }
 
+static void kmeansMiniBatchClustering( IClusteringData* data, CClusteringResult& result )
+{
+	CKMeansClustering::CParam params;
+	params.DistanceFunc = DF_Euclid;
+	params.InitialClustersCount = 2;
+	params.MaxIterations = 50;
+	params.Algo = CKMeansClustering::KMA_MiniBatch;
+	params.Initialization = CKMeansClustering::KMI_KMeansPlusPlus;
+	params.MiniBatchSize = 100;
+	params.ThreadCount = 4;
+
+	CKMeansClustering kMeans( params );
+	kMeans.Clusterize( data, result );
+}
+
+static void kmeansHamerlyClustering( IClusteringData* data, CClusteringResult& result )
+{
+	CKMeansClustering::CParam params;
+	params.DistanceFunc = DF_Euclid;
+	params.InitialClustersCount = 2;
+	params.MaxIterations = 50;
+	params.Algo = CKMeansClustering::KMA_Hamerly;
+	params.Initialization = CKMeansClustering::KMI_KMeansPlusPlus;
+	params.ThreadCount = 4;
+
+	CKMeansClustering kMeans( params );
+	kMeans.Clusterize( data, result );
+}
+
 // --------------------------------------------------------------------------------------------------------------------
 // Result check functions
 
@@ -381,6 +422,111 @@ TEST_F( CClusteringTest, PrecalcIsoData )
 	precalcTestImpl( isoDataClustering, expectedResult );
 }
 
+// Merges the clusters by the definition of the linkage, recalculating all distances on each step
+static void naiveLinkageClustering( const CFloatMatrixDesc& matrix, CHierarchicalClustering::TLinkage linkage,
+	int clustersCount, CArray<int>& labels )
+{
+	CArray<CFloatVector> vectors;
+	for( int i = 0; i < matrix.Height; ++i ) {
+		vectors.Add( CFloatVector( matrix.Width, matrix.GetRow( i ) ) );
+	}
+	CArray<CArray<int>> clusters;
+	clusters.SetSize( matrix.Height );
+	for( int i = 0; i < matrix.Height; ++i ) {
+		clusters[i].Add( i );
+	}
+
+	while( clusters.Size() > clustersCount ) {
+		int bestFirst = NotFound;
+		int bestSecond = NotFound;
+		double bestDistance = 0;
+		for( int first = 0; first < clusters.Size(); ++first ) {
+			for( int second = first + 1; second < clusters.Size(); ++second ) {
+				double distance = 0;
+				if( linkage == CHierarchicalClustering::L_Ward ) {
+					CFloatVector firstMean( matrix.Width, 0.f );
+					CFloatVector secondMean( matrix.Width, 0.f );
+					for( int i = 0; i < clusters[first].Size(); ++i ) {
+						firstMean += vectors[clusters[first][i]];
+					}
+					for( int i = 0; i < clusters[second].Size(); ++i ) {
+						secondMean += vectors[clusters[second][i]];
+					}
+					firstMean *= 1.f / clusters[first].Size();
+					secondMean *= 1.f / clusters[second].Size();
+					const double firstSize = clusters[first].Size();
+					const double secondSize = clusters[second].Size();
+					distance = 2 * firstSize * secondSize / ( firstSize + secondSize )
+						* DotProduct( firstMean - secondMean, firstMean - secondMean );
+				} else {
+					distance = linkage == CHierarchicalClustering::L_Single ? DBL_MAX : 0;
+					for( int i = 0; i < clusters[first].Size(); ++i ) {
+						for( int j = 0; j < clusters[second].Size(); ++j ) {
+							const CFloatVector diff = vectors[clusters[first][i]] - vectors[clusters[second][j]];
+							const double pairDistance = DotProduct( diff, diff );
+							if( linkage == CHierarchicalClustering::L_Single ) {
+								distance = min( distance, pairDistance );
+							} else if( linkage == CHierarchicalClustering::L_Complete ) {
+								distance = max( distance, pairDistance );
+							} else {
+								distance += pairDistance / clusters[first].Size() / clusters[second].Size();
+							}
+						}
+					}
+				}
+				if( bestFirst == NotFound || distance < bestDistance ) {
+					bestFirst = first;
+					bestSecond = second;
+					bestDistance = distance;
+				}
+			}
+		}
+		clusters[bestFirst].Add( clusters[bestSecond] );
+		clusters.DeleteAt( bestSecond );
+	}
+
+	labels.SetSize( matrix.Height );
+	for( int i = 0; i < clusters.Size(); ++i ) {
+		for( int j = 0; j < clusters[i].Size(); ++j ) {
+			labels[clusters[i][j]] = i;
+		}
+	}
+}
+
+TEST_F( CClusteringTest, HierarchicalLinkages )
+{
+	CPtr<IClusteringData> sparseData = nullptr;
+	CPtr<IClusteringData> denseData = nullptr;
+	generateData( 100, 4, 0x2021, sparseData, denseData );
+
+	const CHierarchicalClustering::TLinkage linkages[] = { CHierarchicalClustering::L_Single,
+		CHierarchicalClustering::L_Average, CHierarchicalClustering::L_Complete, CHierarchicalClustering::L_Ward };
+	for( CHierarchicalClustering::TLinkage linkage : linkages ) {
+		for( int clustersCount : { 2, 7, 30 } ) {
+			CArray<int> expected;
+			naiveLinkageClustering( denseData->GetMatrix(), linkage, clustersCount, expected );
+
+			CHierarchicalClustering::CParam params;
+			params.DistanceType = DF_Euclid;
+			params.MinClustersCount = clustersCount;
+			params.Linkage = linkage;
+			params.ThreadCount = 3;
+			CHierarchicalClustering hierarchical( params );
+			CClusteringResult result;
+			EXPECT_FALSE( hierarchical.Clusterize( sparseData, result ) );
+			ASSERT_EQ( clustersCount, result.ClusterCount );
+
+			// The same partition
+			for( int i = 0; i < expected.Size(); ++i ) {
+				for( int j = i + 1; j < expected.Size(); ++j ) {
+					EXPECT_EQ( expected[i] == expected[j], result.Data[i] == result.Data[j] )
+						<< "linkage " << linkage << ", clusters " << clustersCount;
+				}
+			}
+		}
+	}
+}
+
 static void kmeansElkanDefaultInitClustering( IClusteringData* data, CClusteringResult& result )
 {
 	CKMeansClustering::CParam params;
@@ -395,6 +541,35 @@ static void kmeansElkanDefaultInitClustering( IClusteringData* data, CClustering
 	kMeans.Clusterize( data, result );
 }
 
+static void kmeansHamerlyDefaultInitClustering( IClusteringData* data, CClusteringResult& result )
+{
+	CKMeansClustering::CParam params;
+	params.DistanceFunc = DF_Euclid;
+	params.InitialClustersCount = 2;
+	params.MaxIterations = 50;
+	params.Algo = CKMeansClustering::KMA_Hamerly;
+	params.Initialization = CKMeansClustering::KMI_Default;
+	params.ThreadCount = 4;
+
+	CKMeansClustering kMeans( params );
+	kMeans.Clusterize( data, result );
+}
+
+static void kmeansMiniBatchDefaultInitClustering( IClusteringData* data, CClusteringResult& result )
+{
+	CKMeansClustering::CParam params;
+	params.DistanceFunc = DF_Euclid;
+	params.InitialClustersCount = 2;
+	params.MaxIterations = 20;
+	params.Algo = CKMeansClustering::KMA_MiniBatch;
+	params.Initialization = CKMeansClustering::KMI_Default;
+	params.MiniBatchSize = 32;
+	params.ThreadCount = 4;
+
+	CKMeansClustering kMeans( params );
+	kMeans.Clusterize( data, result );
+}
+
 TEST_F( CClusteringTest, PrecalcKmeans )
 {
 	CClusteringResult expectedResult;
@@ -410,8 +585,61 @@ TEST_F( CClusteringTest, PrecalcKmeans )
 	precalcTestImpl( kmeansLloydClustering, expectedResult );
 	// Check that different algos with the same initialization return similar results
 	precalcTestImpl( kmeansElkanDefaultInitClustering, expectedResult );
+	precalcTestImpl( kmeansHamerlyDefaultInitClustering, expectedResult );
+	// The last step of the mini-batch k-means assigns all the data, so the well-separated clusters are the same
+	precalcTestImpl( kmeansMiniBatchDefaultInitClustering, expectedResult );
+}
+
+// Hamerly's algorithm must give the same result as Lloyd's on the data with many clusters
+TEST_F( CClusteringTest, KmeansHamerlyVsLloyd )
+{
+	CRandom random( 0x2718 );
+	const int vectorCount = 2000;
+	const int featureCount = 8;
+	CArray<CSparseFloatVector> vectors;
+	for( int i = 0; i < vectorCount; ++i ) {
+		CSparseFloatVector& vector = vectors.Append();
+		const int center = random.UniformInt( 0, 19 );
+		for( int j = 0; j < featureCount; ++j ) {
+			vector.SetAt( j, static_cast<float>( ( center * ( j + 3 ) ) % 7 + random.Normal( 0, 0.7 ) ) );
+		}
+	}
+	CPtr<IClusteringData> data = new CClusteringTestData( vectors, featureCount, false );
+
+	CKMeansClustering::CParam params;
+	params.DistanceFunc = DF_Euclid;
+	params.InitialClustersCount = 20;
+	params.MaxIterations = 100;
+	params.Initialization = CKMeansClustering::KMI_KMeansPlusPlus;
+	params.ThreadCount = 3;
+
+	params.Algo = CKMeansClustering::KMA_Lloyd;
+	CClusteringResult lloydResult;
+	CKMeansClustering lloyd( params );
+	EXPECT_TRUE( lloyd.Clusterize( data, lloydResult ) );
+
+	params.Algo = CKMeansClustering::KMA_Hamerly;
+	CClusteringResult hamerlyResult;
+	CKMeansClustering hamerly( params );
+	EXPECT_TRUE( hamerly.Clusterize( data, hamerlyResult ) );
+
+	EXPECT_TRUE( isEqual( lloydResult, hamerlyResult ) );
+	ASSERT_EQ( lloydResult.Data.Size(), hamerlyResult.Data.Size() );
+	for( int i = 0; i < lloydResult.Data.Size(); ++i ) {
+		EXPECT_EQ( lloydResult.Data[i], hamerlyResult.Data[i] );
+	}
+
+	// Mini-batch k-means finds the clustering of similar quality
+	params.Algo = CKMeansClustering::KMA_MiniBatch;
+	params.MiniBatchSize = 200;
+	CKMeansClustering miniBatch( params );
+	CClusteringResult miniBatchResult;
+	miniBatch.Clusterize( data, miniBatchResult );
+	EXPECT_EQ( 20, miniBatchResult.ClusterCount );
+	EXPECT_EQ( vectorCount, miniBatchResult.Data.Size() );
 }
 
 INSTANTIATE_TEST_CASE_P( CClusteringTestInstantiation, CClusteringTest,
-	::testing::Values( firstComeClustering, hierarchicalClustering,
-		isoDataClustering, kmeansElkanClustering, kmeansLloydClustering ) );
+	::testing::Values( firstComeClustering, hierarchicalClustering, hierarchicalWardClustering,
+		isoDataClustering, kmeansElkanClustering, kmeansLloydClustering, kmeansMiniBatchClustering,
+		kmeansHamerlyClustering ) );
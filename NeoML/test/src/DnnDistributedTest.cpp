@@ -0,0 +1,279 @@
+/* Copyright © 2021 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <TestFixture.h>
+
+using namespace NeoML;
+using namespace NeoMLTest;
+
+// The distributed training on the parts of the batch should give the same results
+// as the usual training on the whole batch
+
+static const int batchWidth = 8;
+static const int inputSize = 10;
+static const int labelSize = 4;
+
+// Splits the batch evenly between the replicas
+class CTestDistributedDataset : public IDistributedDataset {
+public:
+	CTestDistributedDataset( const CArray<float>& _data, const CArray<float>& _labels, int _count ) :
+		data( _data ), labels( _labels ), count( _count ) {}
+
+	void SetInputBatch( CDnn& dnn, int index ) override
+	{
+		const int width = batchWidth / count;
+		setBlob( dnn, "data", data.GetPtr() + index * width * inputSize, width, inputSize );
+		setBlob( dnn, "label", labels.GetPtr() + index * width * labelSize, width, labelSize );
+	}
+
+private:
+	const CArray<float>& data;
+	const CArray<float>& labels;
+	const int count;
+
+	static void setBlob( CDnn& dnn, const char* name, const float* ptr, int width, int channels )
+	{
+		CPtr<CDnnBlob> blob = CDnnBlob::CreateDataBlob( dnn.GetMathEngine(), CT_Float, 1, width, channels );
+		blob->CopyFrom( ptr );
+		CheckCast<CSourceLayer>( dnn.GetLayer( name ).Ptr() )->SetBlob( blob );
+	}
+};
+
+static void fillRandom( CArray<float>& values, int size, CRandom& random )
+{
+	values.SetSize( size );
+	for( int i = 0; i < size; ++i ) {
+		values[i] = static_cast<float>( random.Uniform( -1, 1 ) );
+	}
+}
+
+static void buildNetwork( CDnn& dnn, const CPtr<CDnnSolver>& solver )
+{
+	CSourceLayer* data = Source( dnn, "data" );
+	CSourceLayer* label = Source( dnn, "label" );
+	CBaseLayer* fc1 = FullyConnected( 12 )( "fc1", data );
+	CBaseLayer* relu = Relu()( "relu", fc1 );
+	CBaseLayer* fc2 = FullyConnected( labelSize )( "fc2", relu );
+	EuclideanLoss()( "loss", fc2, label );
+	Sink( fc2, "sink" );
+	dnn.SetSolver( solver );
+}
+
+static CPtr<CDnnSolver> createSolver( IMathEngine& mathEngine )
+{
+	CPtr<CDnnAdaptiveGradientSolver> solver = new CDnnAdaptiveGradientSolver( mathEngine );
+	solver->SetLearningRate( 0.05f );
+	solver->SetL2Regularization( 0.01f );
+	return solver.Ptr();
+}
+
+static void getWeights( const CDnn& dnn, CArray<float>& weights )
+{
+	weights.DeleteAll();
+	for( const char* name : { "fc1", "fc2" } ) {
+		const CFullyConnectedLayer* fc = CheckCast<const CFullyConnectedLayer>( dnn.GetLayer( name ).Ptr() );
+		for( const CPtr<CDnnBlob>& blob : { fc->GetWeightsData(), fc->GetFreeTermData() } ) {
+			const int offset = weights.Size();
+			weights.SetSize( offset + blob->GetDataSize() );
+			blob->CopyTo( weights.GetPtr() + offset );
+		}
+	}
+}
+
+static void checkWeightsEqual( const CArray<float>& expected, const CArray<float>& actual, float eps )
+{
+	ASSERT_EQ( expected.Size(), actual.Size() );
+	for( int i = 0; i < expected.Size(); ++i ) {
+		EXPECT_NEAR( expected[i], actual[i], eps );
+	}
+}
+
+TEST( CDnnDistributedTest, Training )
+{
+	if( MathEngineType() != MET_Cpu ) {
+		return;
+	}
+
+	CRandom dataRandom( 0x4A );
+	CArray<float> data;
+	fillRandom( data, batchWidth * inputSize, dataRandom );
+	CArray<float> labels;
+	fillRandom( labels, batchWidth * labelSize, dataRandom );
+
+	CRandom random( 0x12 );
+	CDnn dnn( random, MathEngine() );
+	buildNetwork( dnn, createSolver( MathEngine() ) );
+	CTestDistributedDataset wholeBatch( data, labels, 1 );
+
+	// The replicas are created before the first run and initialize their parameters by themselves
+	CDistributedTraining distributed( dnn, 2, 1 );
+	ASSERT_EQ( 2, distributed.GetModelCount() );
+	CTestDistributedDataset halfBatches( data, labels, 2 );
+
+	const int stepCount = 5;
+	float firstLoss = 0;
+	for( int step = 0; step < stepCount; ++step ) {
+		wholeBatch.SetInputBatch( dnn, 0 );
+		dnn.RunAndLearnOnce();
+		// Two runs per step check the gradient accumulation
+		distributed.RunAndBackwardOnce( halfBatches );
+		distributed.RunAndLearnOnce( halfBatches );
+		if( step == 0 ) {
+			firstLoss = distributed.GetLastLoss( "loss" );
+		}
+	}
+	EXPECT_LT( distributed.GetLastLoss( "loss" ), firstLoss );
+
+	CArray<float> expected;
+	getWeights( dnn, expected );
+	CArray<float> actual;
+	for( int i = 0; i < distributed.GetModelCount(); ++i ) {
+		getWeights( distributed.GetModel( i ), actual );
+		checkWeightsEqual( expected, actual, 1e-4f );
+	}
+
+	CObjectArray<CDnnBlob> outputs;
+	distributed.GetLastBlob( "sink", outputs );
+	ASSERT_EQ( 2, outputs.Size() );
+	EXPECT_EQ( batchWidth / 2, outputs[0]->GetBatchWidth() );
+
+	// The learning rate is changed in all replicas
+	distributed.SetLearningRate( 0.01f );
+	for( int i = 0; i < distributed.GetModelCount(); ++i ) {
+		EXPECT_EQ( 0.01f, distributed.GetModel( i ).GetSolver()->GetLearningRate() );
+	}
+}
+
+TEST( CDnnDistributedTest, TrainedNetworkCopy )
+{
+	if( MathEngineType() != MET_Cpu ) {
+		return;
+	}
+
+	CRandom dataRandom( 0x5B );
+	CArray<float> data;
+	fillRandom( data, batchWidth * inputSize, dataRandom );
+	CArray<float> labels;
+	fillRandom( labels, batchWidth * labelSize, dataRandom );
+	CTestDistributedDataset halfBatches( data, labels, 2 );
+
+	// The replicas get the trained parameters and the solver state of the network
+	CRandom random( 0x12 );
+	CDnn dnn( random, MathEngine() );
+	buildNetwork( dnn, createSolver( MathEngine() ) );
+	CTestDistributedDataset wholeBatch( data, labels, 1 );
+	wholeBatch.SetInputBatch( dnn, 0 );
+	dnn.RunAndLearnOnce();
+
+	CDistributedTraining distributed( dnn, 2 );
+	for( int step = 0; step < 3; ++step ) {
+		wholeBatch.SetInputBatch( dnn, 0 );
+		dnn.RunAndLearnOnce();
+		distributed.RunAndLearnOnce( halfBatches );
+	}
+
+	CArray<float> expected;
+	getWeights( dnn, expected );
+	CArray<float> actual;
+	for( int i = 0; i < distributed.GetModelCount(); ++i ) {
+		getWeights( distributed.GetModel( i ), actual );
+		checkWeightsEqual( expected, actual, 1e-4f );
+	}
+
+	// The stored network continues training in the same way
+	const CString fileName = "distributed_test.arch";
+	{
+		CArchiveFile archiveFile( fileName, CArchive::store, GetPlatformEnv() );
+		CArchive archive( &archiveFile, CArchive::SD_Storing );
+		distributed.SerializeCheckpoint( archive );
+	}
+	CRandom loadedRandom( 0x12 );
+	CDnn loadedDnn( loadedRandom, MathEngine() );
+	{
+		CArchiveFile archiveFile( fileName, CArchive::load, GetPlatformEnv() );
+		CArchive archive( &archiveFile, CArchive::SD_Loading );
+		loadedDnn.SerializeCheckpoint( archive );
+	}
+	::remove( fileName );
+	wholeBatch.SetInputBatch( dnn, 0 );
+	dnn.RunAndLearnOnce();
+	wholeBatch.SetInputBatch( loadedDnn, 0 );
+	loadedDnn.RunAndLearnOnce();
+	getWeights( dnn, expected );
+	getWeights( loadedDnn, actual );
+	checkWeightsEqual( expected, actual, 1e-4f );
+}
+
+TEST( CDnnDistributedTest, ReplicaDropout )
+{
+	if( MathEngineType() != MET_Cpu ) {
+		return;
+	}
+
+	// Both replicas get the same half of the batch
+	CRandom dataRandom( 0x6C );
+	CArray<float> half;
+	fillRandom( half, batchWidth / 2 * inputSize, dataRandom );
+	CArray<float> data;
+	data.Add( half );
+	data.Add( half );
+	fillRandom( half, batchWidth / 2 * labelSize, dataRandom );
+	CArray<float> labels;
+	labels.Add( half );
+	labels.Add( half );
+	CTestDistributedDataset halfBatches( data, labels, 2 );
+
+	CRandom random( 0x12 );
+	CDnn dnn( random, MathEngine() );
+	CSourceLayer* dataLayer = Source( dnn, "data" );
+	CSourceLayer* label = Source( dnn, "label" );
+	CBaseLayer* fc1 = FullyConnected( 12 )( "fc1", dataLayer );
+	CBaseLayer* dropout = Dropout( 0.5f )( "dropout", fc1 );
+	CBaseLayer* fc2 = FullyConnected( labelSize )( "fc2", dropout );
+	EuclideanLoss()( "loss", fc2, label );
+	Sink( dropout, "sink" );
+	dnn.SetSolver( createSolver( MathEngine() ) );
+
+	CDistributedTraining distributed( dnn, 2, 1 );
+	distributed.RunAndBackwardOnce( halfBatches );
+
+	// The replicas are initialized in the same way but draw different dropout masks
+	CArray<float> firstWeights;
+	getWeights( distributed.GetModel( 0 ), firstWeights );
+	CArray<float> secondWeights;
+	getWeights( distributed.GetModel( 1 ), secondWeights );
+	checkWeightsEqual( firstWeights, secondWeights, 0.f );
+
+	CObjectArray<CDnnBlob> outputs;
+	distributed.GetLastBlob( "sink", outputs );
+	ASSERT_EQ( 2, outputs.Size() );
+	CArray<float> firstOutput;
+	firstOutput.SetSize( outputs[0]->GetDataSize() );
+	outputs[0]->CopyTo( firstOutput.GetPtr() );
+	CArray<float> secondOutput;
+	secondOutput.SetSize( outputs[1]->GetDataSize() );
+	outputs[1]->CopyTo( secondOutput.GetPtr() );
+	ASSERT_EQ( firstOutput.Size(), secondOutput.Size() );
+	int differentCount = 0;
+	for( int i = 0; i < firstOutput.Size(); ++i ) {
+		if( firstOutput[i] != secondOutput[i] ) {
+			differentCount++;
+		}
+	}
+	EXPECT_LT( 0, differentCount );
+}
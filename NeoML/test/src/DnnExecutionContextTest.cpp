@@ -0,0 +1,151 @@
+/* Copyright © 2021 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+
+#include <common.h>
+#pragma hdrstop
+
+#include <TestFixture.h>
+
+#include <thread>
+
+using namespace NeoML;
+using namespace NeoMLTest;
+
+// Source -> Conv -> BatchNormalization -> ReLU -> Lstm -> FullyConnected -> Sink
+static void buildExecutionContextTestNet( CDnn& dnn, CRandom& random )
+{
+	CSourceLayer* source = Source( dnn, "source" );
+	CConvLayer* conv = Conv( 4, CConvAxisParams( 3, 1 ), CConvAxisParams( 3, 1 ) )( "conv", source );
+	CBatchNormalizationLayer* bn = BatchNormalization( true )( "bn", conv );
+	CReLULayer* relu = Relu()( "relu", bn );
+	CLstmLayer* lstm = Lstm( 5, 0.f )( "lstm", relu );
+	CFullyConnectedLayer* fc = FullyConnected( 7 )( "fc", lstm );
+	Sink( fc, "sink" );
+
+	source->SetBlob( CDnnBlob::CreateBlob( dnn.GetMathEngine(), CT_Float, CBlobDesc( { 3, 2, 1, 4, 4, 1, 3 } ) ) );
+	dnn.RunOnce();
+
+	// Non-trivial batch normalization parameters
+	CPtr<CDnnBlob> finalParams = bn->GetFinalParams();
+	CArray<float> params;
+	params.SetSize( finalParams->GetDataSize() );
+	for( int i = 0; i < params.Size(); ++i ) {
+		params[i] = static_cast<float>( random.Uniform( 0.5, 1.5 ) );
+	}
+	finalParams->CopyFrom( params.GetPtr() );
+	bn->SetFinalParams( finalParams );
+}
+
+static CPtr<CDnnBlob> createExecutionContextTestInput( IMathEngine& mathEngine, CRandom& random )
+{
+	CPtr<CDnnBlob> input = CDnnBlob::CreateBlob( mathEngine, CT_Float, CBlobDesc( { 3, 2, 1, 4, 4, 1, 3 } ) );
+	CArray<float> inputData;
+	inputData.SetSize( input->GetDataSize() );
+	for( int i = 0; i < inputData.Size(); ++i ) {
+		inputData[i] = static_cast<float>( random.Uniform( -1, 1 ) );
+	}
+	input->CopyFrom( inputData.GetPtr() );
+	return input;
+}
+
+static void getBlobData( const CDnnBlob& blob, CArray<float>& data )
+{
+	data.SetSize( blob.GetDataSize() );
+	blob.CopyTo( data.GetPtr() );
+}
+
+TEST( CDnnExecutionContextTest, ConcurrentRun )
+{
+	const int threadCount = 4;
+	const int runCount = 10;
+
+	CRandom random( 0x3C );
+	CDnn dnn( random, MathEngine() );
+	buildExecutionContextTestNet( dnn, random );
+
+	CObjectArray<CDnnBlob> inputs;
+	CArray<CArray<float>> expected;
+	expected.SetSize( threadCount );
+	for( int i = 0; i < threadCount; ++i ) {
+		inputs.Add( createExecutionContextTestInput( MathEngine(), random ) );
+		CheckCast<CSourceLayer>( dnn.GetLayer( "source" ).Ptr() )->SetBlob( inputs[i] );
+		dnn.RunOnce();
+		getBlobData( *CheckCast<CSinkLayer>( dnn.GetLayer( "sink" ).Ptr() )->GetBlob(), expected[i] );
+	}
+
+	std::vector<std::unique_ptr<CDnnExecutionContext>> contexts;
+	for( int i = 0; i < threadCount; ++i ) {
+		contexts.emplace_back( new CDnnExecutionContext( dnn ) );
+	}
+
+	CArray<CArray<float>> actual;
+	actual.SetSize( threadCount );
+	std::vector<std::thread> threads;
+	for( int i = 0; i < threadCount; ++i ) {
+		threads.emplace_back( [&, i]() {
+			CDnnExecutionContext& context = *contexts[i];
+			context.SetInputBlob( "source", inputs[i] );
+			for( int run = 0; run < runCount; ++run ) {
+				context.RunOnce();
+			}
+			getBlobData( *context.GetOutputBlob( "sink" ), actual[i] );
+		} );
+	}
+	for( size_t i = 0; i < threads.size(); ++i ) {
+		threads[i].join();
+	}
+
+	for( int i = 0; i < threadCount; ++i ) {
+		ASSERT_EQ( expected[i].Size(), actual[i].Size() );
+		for( int j = 0; j < expected[i].Size(); ++j ) {
+			EXPECT_NEAR( expected[i][j], actual[i][j], 1e-5f );
+		}
+	}
+}
+
+TEST( CDnnExecutionContextTest, SharedParameters )
+{
+	CRandom random( 0x3D );
+	CDnn dnn( random, MathEngine() );
+	buildExecutionContextTestNet( dnn, random );
+
+	CDnnExecutionContext context( dnn );
+	context.SetInputBlob( "source", createExecutionContextTestInput( MathEngine(), random ) );
+	context.RunOnce();
+	CArray<float> output;
+	getBlobData( *context.GetOutputBlob( "sink" ), output );
+	float maxAbs = 0;
+	for( int i = 0; i < output.Size(); ++i ) {
+		maxAbs = max( maxAbs, fabsf( output[i] ) );
+	}
+	EXPECT_LT( 0.f, maxAbs );
+
+	// The weights are changed in place in the original network
+	CPtr<CFullyConnectedLayer> fc = CheckCast<CFullyConnectedLayer>( dnn.GetLayer( "fc" ).Ptr() );
+	CPtr<CDnnBlob> weights = fc->GetWeightsData();
+	weights->Fill( 0 );
+	fc->SetWeightsData( weights );
+	CPtr<CDnnBlob> freeTerms = fc->GetFreeTermData();
+	freeTerms->Fill( 1.f );
+	fc->SetFreeTermData( freeTerms );
+
+	// The context sees the new weights
+	context.RunOnce();
+	getBlobData( *context.GetOutputBlob( "sink" ), output );
+	for( int i = 0; i < output.Size(); ++i ) {
+		EXPECT_EQ( 1.f, output[i] );
+	}
+}
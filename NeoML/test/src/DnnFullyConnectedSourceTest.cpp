@@ -0,0 +1,133 @@
+/* Copyright © 2021 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <TestFixture.h>
+
+using namespace NeoML;
+using namespace NeoMLTest;
+
+// The layer should give the same results with and without the background loader
+
+static const int featureCount = 12;
+static const int classCount = 3;
+
+static CPtr<CMemoryProblem> createProblem( int vectorCount )
+{
+	CRandom random( 0x71 );
+	CPtr<CMemoryProblem> problem = new CMemoryProblem( featureCount, classCount );
+	for( int i = 0; i < vectorCount; ++i ) {
+		CSparseFloatVector vector;
+		for( int j = 0; j < featureCount; ++j ) {
+			if( random.UniformInt( 0, 2 ) == 0 ) {
+				vector.SetAt( j, static_cast<float>( random.Uniform( -1, 1 ) ) );
+			}
+		}
+		problem->Add( vector, random.Uniform( 0.5, 1 ), random.UniformInt( 0, classCount - 1 ) );
+	}
+	return problem;
+}
+
+static CFullyConnectedSourceLayer* buildNetwork( CDnn& dnn, IProblem* problem, TBlobType labelType,
+	CArray<CSinkLayer*>& sinks )
+{
+	CPtr<CFullyConnectedSourceLayer> source = new CFullyConnectedSourceLayer( dnn.GetMathEngine() );
+	source->SetName( "source" );
+	source->SetNumberOfElements( classCount );
+	source->SetLabelType( labelType );
+	source->SetBatchSize( 4 );
+	source->SetMaxBatchCount( 2 );
+	source->SetProblem( problem );
+	dnn.AddLayer( *source );
+
+	sinks.Add( Sink( CDnnLayerLink( source, 0 ), "data" ) );
+	sinks.Add( Sink( CDnnLayerLink( source, 1 ), "labels" ) );
+	sinks.Add( Sink( CDnnLayerLink( source, 2 ), "weights" ) );
+	if( labelType == CT_Float ) {
+		EuclideanLoss()( "loss", CDnnLayerLink( source, 0 ), CDnnLayerLink( source, 1 ), CDnnLayerLink( source, 2 ) );
+	} else {
+		CrossEntropyLoss()( "loss", CDnnLayerLink( source, 0 ), CDnnLayerLink( source, 1 ), CDnnLayerLink( source, 2 ) );
+	}
+
+	CPtr<CDnnSimpleGradientSolver> solver = new CDnnSimpleGradientSolver( dnn.GetMathEngine() );
+	solver->SetLearningRate( 0.1f );
+	dnn.SetSolver( solver );
+	return source;
+}
+
+static void checkBlobsEqual( const CDnnBlob& expected, const CDnnBlob& actual )
+{
+	ASSERT_TRUE( expected.HasEqualDimensions( &actual ) );
+	ASSERT_EQ( expected.GetDataType(), actual.GetDataType() );
+
+	if( expected.GetDataType() == CT_Int ) {
+		CArray<int> expectedData;
+		expectedData.SetSize( expected.GetDataSize() );
+		expected.CopyTo( expectedData.GetPtr() );
+		CArray<int> actualData;
+		actualData.SetSize( actual.GetDataSize() );
+		actual.CopyTo( actualData.GetPtr() );
+		for( int i = 0; i < expectedData.Size(); ++i ) {
+			EXPECT_EQ( expectedData[i], actualData[i] );
+		}
+		return;
+	}
+
+	CArray<float> expectedData;
+	expectedData.SetSize( expected.GetDataSize() );
+	expected.CopyTo( expectedData.GetPtr() );
+	CArray<float> actualData;
+	actualData.SetSize( actual.GetDataSize() );
+	actual.CopyTo( actualData.GetPtr() );
+	for( int i = 0; i < expectedData.Size(); ++i ) {
+		EXPECT_NEAR( expectedData[i], actualData[i], 1e-4f );
+	}
+}
+
+TEST( CDnnFullyConnectedSourceTest, Prefetch )
+{
+	// The number of vectors is not divisible by the batch size
+	CPtr<CMemoryProblem> problem = createProblem( 10 );
+
+	for( TBlobType labelType : { CT_Float, CT_Int } ) {
+		CRandom expectedRandom( 0x2C );
+		CDnn expectedDnn( expectedRandom, MathEngine() );
+		CArray<CSinkLayer*> expectedSinks;
+		CFullyConnectedSourceLayer* expectedSource = buildNetwork( expectedDnn, problem, labelType, expectedSinks );
+
+		CRandom actualRandom( 0x2C );
+		CDnn actualDnn( actualRandom, MathEngine() );
+		CArray<CSinkLayer*> actualSinks;
+		CFullyConnectedSourceLayer* actualSource = buildNetwork( actualDnn, problem, labelType, actualSinks );
+		actualSource->SetPrefetchBatchCount( 2 );
+
+		for( int step = 0; step < 9; ++step ) {
+			if( step == 3 ) {
+				// The loader is restarted from the next batch
+				actualSource->SetLabelType( labelType == CT_Float ? CT_Int : CT_Float );
+				actualSource->SetLabelType( labelType );
+			}
+			expectedDnn.RunAndLearnOnce();
+			actualDnn.RunAndLearnOnce();
+			for( int i = 0; i < expectedSinks.Size(); ++i ) {
+				checkBlobsEqual( *expectedSinks[i]->GetBlob(), *actualSinks[i]->GetBlob() );
+			}
+		}
+		checkBlobsEqual( *expectedSource->GetWeightsData(), *actualSource->GetWeightsData() );
+		checkBlobsEqual( *expectedSource->GetFreeTermData(), *actualSource->GetFreeTermData() );
+	}
+}
@@ -0,0 +1,258 @@
+/* Copyright © 2021 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <TestFixture.h>
+
+using namespace NeoML;
+using namespace NeoMLTest;
+
+// The fused implementation of the multihead attention is used on CPU inference
+// When the backward pass is performed the layer runs the internal network
+// so the results of RunOnce and RunAndBackwardOnce are compared
+
+static CPtr<CDnnBlob> createRandomBlob( IMathEngine& mathEngine, const CBlobDesc& desc, CRandom& random )
+{
+	CPtr<CDnnBlob> blob = CDnnBlob::CreateBlob( mathEngine, CT_Float, desc );
+	CArray<float> data;
+	data.SetSize( blob->GetDataSize() );
+	for( int i = 0; i < data.Size(); ++i ) {
+		data[i] = static_cast<float>( random.Uniform( -1, 1 ) );
+	}
+	blob->CopyFrom( data.GetPtr() );
+	return blob;
+}
+
+static CSourceLayer* addRandomSource( CDnn& dnn, const char* name, int batchWidth, int listSize, int channels,
+	CRandom& random )
+{
+	CBlobDesc desc( CT_Float );
+	desc.SetDimSize( BD_BatchWidth, batchWidth );
+	desc.SetDimSize( BD_ListSize, listSize );
+	desc.SetDimSize( BD_Channels, channels );
+
+	CSourceLayer* source = Source( dnn, name );
+	source->SetBlob( createRandomBlob( dnn.GetMathEngine(), desc, random ) );
+	return source;
+}
+
+static void checkBlobsEqual( const CDnnBlob& expected, const CDnnBlob& actual )
+{
+	ASSERT_TRUE( expected.HasEqualDimensions( &actual ) );
+
+	CArray<float> expectedData;
+	expectedData.SetSize( expected.GetDataSize() );
+	expected.CopyTo( expectedData.GetPtr() );
+
+	CArray<float> actualData;
+	actualData.SetSize( actual.GetDataSize() );
+	actual.CopyTo( actualData.GetPtr() );
+
+	for( int i = 0; i < expectedData.Size(); ++i ) {
+		EXPECT_NEAR( expectedData[i], actualData[i], 1e-4f );
+	}
+}
+
+static void checkFusedAttention( int headCount, int hiddenSize, int queryLength, int keyLength, bool useMask )
+{
+	const int batchWidth = 3;
+	const int outputSize = 7;
+
+	CRandom random( 0x3F );
+	CDnn dnn( random, MathEngine() );
+	CSourceLayer* query = addRandomSource( dnn, "query", batchWidth, queryLength, 5, random );
+	CSourceLayer* key = addRandomSource( dnn, "key", batchWidth, keyLength, 5, random );
+	CSourceLayer* value = addRandomSource( dnn, "value", batchWidth, keyLength, 4, random );
+
+	CMultiheadAttentionLayer* attention = nullptr;
+	if( useMask ) {
+		// The mask is shared by all the objects and heads; the ones mark the hidden positions
+		CBlobDesc maskDesc( CT_Float );
+		maskDesc.SetDimSize( BD_Width, queryLength );
+		maskDesc.SetDimSize( BD_Channels, keyLength );
+		CArray<float> maskData;
+		maskData.Add( 0.f, queryLength * keyLength );
+		for( int i = 0; i < queryLength; ++i ) {
+			for( int j = i + 1; j < keyLength; ++j ) {
+				maskData[i * keyLength + j] = 1.f;
+			}
+		}
+		CPtr<CDnnBlob> maskBlob = CDnnBlob::CreateBlob( MathEngine(), CT_Float, maskDesc );
+		maskBlob->CopyFrom( maskData.GetPtr() );
+		CSourceLayer* mask = Source( dnn, "mask" );
+		mask->SetBlob( maskBlob );
+
+		attention = MultiheadAttention( headCount, hiddenSize, outputSize, -1 )( "attention", query, key, value, mask );
+		attention->SetUseMask( true );
+	} else {
+		attention = MultiheadAttention( headCount, hiddenSize, outputSize, -1 )( "attention", query, key, value );
+	}
+	CSinkLayer* sink = Sink( attention, "output" );
+
+	CSourceLayer* label = addRandomSource( dnn, "label", batchWidth, queryLength, outputSize, random );
+	EuclideanLoss()( "loss", attention, label );
+
+	dnn.DisableLearning();
+	dnn.RunAndBackwardOnce();
+	CPtr<CDnnBlob> expected = sink->GetBlob()->GetCopy();
+
+	dnn.RunOnce();
+	checkBlobsEqual( *expected, *sink->GetBlob() );
+}
+
+TEST( CDnnFusedAttentionTest, MultiheadAttention )
+{
+	if( MathEngineType() != MET_Cpu ) {
+		return;
+	}
+
+	checkFusedAttention( 1, 8, 6, 6, false );
+	checkFusedAttention( 2, 8, 6, 9, false );
+	checkFusedAttention( 4, 16, 1, 300, false );
+	checkFusedAttention( 2, 8, 70, 70, false );
+}
+
+TEST( CDnnFusedAttentionTest, MultiheadAttentionWithMask )
+{
+	if( MathEngineType() != MET_Cpu ) {
+		return;
+	}
+
+	checkFusedAttention( 1, 8, 6, 6, true );
+	checkFusedAttention( 2, 12, 5, 8, true );
+	checkFusedAttention( 3, 6, 70, 300, true );
+}
+
+// Creates the blob with the positions [start, start + length) of the sequence data
+static CPtr<CDnnBlob> createSequencePart( IMathEngine& mathEngine, const CArray<float>& data, int batchWidth,
+	int fullLength, int channels, int start, int length )
+{
+	CBlobDesc desc( CT_Float );
+	desc.SetDimSize( BD_BatchWidth, batchWidth );
+	desc.SetDimSize( BD_ListSize, length );
+	desc.SetDimSize( BD_Channels, channels );
+
+	CArray<float> part;
+	for( int b = 0; b < batchWidth; ++b ) {
+		for( int i = start; i < start + length; ++i ) {
+			for( int c = 0; c < channels; ++c ) {
+				part.Add( data[( b * fullLength + i ) * channels + c] );
+			}
+		}
+	}
+	CPtr<CDnnBlob> blob = CDnnBlob::CreateBlob( mathEngine, CT_Float, desc );
+	blob->CopyFrom( part.GetPtr() );
+	return blob;
+}
+
+// Extracts the given positions of the output
+static void getSequencePart( const CDnnBlob& blob, int start, int length, CArray<float>& result )
+{
+	CArray<float> data;
+	data.SetSize( blob.GetDataSize() );
+	blob.CopyTo( data.GetPtr() );
+
+	const int fullLength = blob.GetListSize();
+	const int channels = blob.GetChannelsCount();
+	result.DeleteAll();
+	for( int b = 0; b < blob.GetBatchWidth(); ++b ) {
+		for( int i = start; i < start + length; ++i ) {
+			for( int c = 0; c < channels; ++c ) {
+				result.Add( data[( b * fullLength + i ) * channels + c] );
+			}
+		}
+	}
+}
+
+static void checkArraysEqual( const CArray<float>& expected, const CArray<float>& actual )
+{
+	ASSERT_EQ( expected.Size(), actual.Size() );
+	for( int i = 0; i < expected.Size(); ++i ) {
+		EXPECT_NEAR( expected[i], actual[i], 1e-4f );
+	}
+}
+
+TEST( CDnnFusedAttentionTest, KeyValueCache )
+{
+	if( MathEngineType() != MET_Cpu ) {
+		return;
+	}
+
+	const int batchWidth = 2;
+	const int sequenceLength = 7;
+	const int channels = 5;
+	const int prefixLength = 3;
+
+	CRandom random( 0x4A );
+	CArray<float> data;
+	for( int i = 0; i < batchWidth * sequenceLength * channels; ++i ) {
+		data.Add( static_cast<float>( random.Uniform( -1, 1 ) ) );
+	}
+
+	CDnn dnn( random, MathEngine() );
+	CSourceLayer* source = Source( dnn, "data" );
+	CMultiheadAttentionLayer* attention = MultiheadAttention( 2, 8, 6, -1 )( "attention", source, source, source );
+	CSinkLayer* sink = Sink( attention, "output" );
+
+	// Without the cache, the last position of the output attends to all the positions of the sequence
+	CArray<CArray<float>> expected;
+	expected.SetSize( sequenceLength );
+	for( int i = 0; i < sequenceLength; ++i ) {
+		source->SetBlob( createSequencePart( MathEngine(), data, batchWidth, sequenceLength, channels, 0, i + 1 ) );
+		dnn.RunOnce();
+		getSequencePart( *sink->GetBlob(), i, 1, expected[i] );
+	}
+
+	attention->EnableKeyValueCache( true );
+	dnn.SetAutoRestartMode( false );
+	dnn.RestartSequence();
+
+	// The prefix is processed at once, each position attends only to the previous ones
+	source->SetBlob( createSequencePart( MathEngine(), data, batchWidth, sequenceLength, channels, 0, prefixLength ) );
+	dnn.RunOnce();
+	EXPECT_EQ( prefixLength, attention->GetCachedLength() );
+	for( int i = 0; i < prefixLength; ++i ) {
+		CArray<float> actual;
+		getSequencePart( *sink->GetBlob(), i, 1, actual );
+		checkArraysEqual( expected[i], actual );
+	}
+
+	// Then the positions are processed one by one
+	CObjectArray<CDnnBlob> state;
+	for( int i = prefixLength; i < sequenceLength; ++i ) {
+		if( i == sequenceLength - 1 ) {
+			attention->GetState( state );
+		}
+		source->SetBlob( createSequencePart( MathEngine(), data, batchWidth, sequenceLength, channels, i, 1 ) );
+		dnn.RunOnce();
+		EXPECT_EQ( i + 1, attention->GetCachedLength() );
+		CArray<float> actual;
+		getSequencePart( *sink->GetBlob(), 0, 1, actual );
+		checkArraysEqual( expected[i], actual );
+	}
+
+	// Restoring the state repeats the last step
+	attention->SetState( state );
+	EXPECT_EQ( sequenceLength - 1, attention->GetCachedLength() );
+	dnn.RunOnce();
+	CArray<float> actual;
+	getSequencePart( *sink->GetBlob(), 0, 1, actual );
+	checkArraysEqual( expected[sequenceLength - 1], actual );
+
+	dnn.RestartSequence();
+	EXPECT_EQ( 0, attention->GetCachedLength() );
+}
@@ -0,0 +1,151 @@
+/* Copyright © 2021 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <TestFixture.h>
+
+using namespace NeoML;
+using namespace NeoMLTest;
+
+// The fused implementation of LSTM and GRU is used on CPU inference
+// When the backward pass is performed the layers run the internal network step by step
+// so the results of RunOnce and RunAndBackwardOnce are compared
+
+static CSourceLayer* addRandomSource( CDnn& dnn, const char* name, int batchLength, int batchWidth, int channels,
+	CRandom& random )
+{
+	CSourceLayer* source = Source( dnn, name );
+	CPtr<CDnnBlob> blob = CDnnBlob::CreateDataBlob( dnn.GetMathEngine(), CT_Float, batchLength, batchWidth, channels );
+	CArray<float> data;
+	data.SetSize( blob->GetDataSize() );
+	for( int i = 0; i < data.Size(); ++i ) {
+		data[i] = static_cast<float>( random.Uniform( -1, 1 ) );
+	}
+	blob->CopyFrom( data.GetPtr() );
+	source->SetBlob( blob );
+	return source;
+}
+
+static void checkBlobsEqual( const CDnnBlob& expected, const CDnnBlob& actual )
+{
+	ASSERT_TRUE( expected.HasEqualDimensions( &actual ) );
+
+	CArray<float> expectedData;
+	expectedData.SetSize( expected.GetDataSize() );
+	expected.CopyTo( expectedData.GetPtr() );
+
+	CArray<float> actualData;
+	actualData.SetSize( actual.GetDataSize() );
+	actual.CopyTo( actualData.GetPtr() );
+
+	for( int i = 0; i < expectedData.Size(); ++i ) {
+		EXPECT_NEAR( expectedData[i], actualData[i], 1e-4f );
+	}
+}
+
+// Runs the network in both modes (twice, to check how the state is passed between the runs)
+// and compares the outputs of the sinks
+static void checkFusedRun( CDnn& dnn, const CArray<CSinkLayer*>& sinks )
+{
+	dnn.DisableLearning();
+	for( int autoRestart = 1; autoRestart >= 0; --autoRestart ) {
+		dnn.SetAutoRestartMode( autoRestart != 0 );
+
+		CObjectArray<CDnnBlob> expected;
+		dnn.RestartSequence();
+		dnn.RunAndBackwardOnce();
+		dnn.RunAndBackwardOnce();
+		for( int i = 0; i < sinks.Size(); ++i ) {
+			expected.Add( sinks[i]->GetBlob()->GetCopy() );
+		}
+
+		dnn.RestartSequence();
+		dnn.RunOnce();
+		dnn.RunOnce();
+		for( int i = 0; i < sinks.Size(); ++i ) {
+			checkBlobsEqual( *expected[i], *sinks[i]->GetBlob() );
+		}
+	}
+}
+
+TEST( CDnnFusedRecurrentTest, Lstm )
+{
+	if( MathEngineType() != MET_Cpu ) {
+		return;
+	}
+
+	const int hiddenSize = 6;
+	for( int reverse = 0; reverse < 2; ++reverse ) {
+		for( int withInitialState = 0; withInitialState < 2; ++withInitialState ) {
+			CRandom random( 0x1D );
+			CDnn dnn( random, MathEngine() );
+			CSourceLayer* data = addRandomSource( dnn, "data", 5, 3, 7, random );
+
+			CLstmLayer* lstm = nullptr;
+			if( withInitialState != 0 ) {
+				CSourceLayer* state = addRandomSource( dnn, "initialState", 1, 3, hiddenSize, random );
+				CSourceLayer* history = addRandomSource( dnn, "initialHistory", 1, 3, hiddenSize, random );
+				lstm = Lstm( hiddenSize, 0.f )( "lstm", data, state, history );
+			} else {
+				lstm = Lstm( hiddenSize, 0.f )( "lstm", data );
+			}
+			lstm->SetReverseSequence( reverse != 0 );
+
+			CArray<CSinkLayer*> sinks;
+			sinks.Add( Sink( lstm, "output" ) );
+			sinks.Add( Sink( CDnnLayerLink( lstm, 1 ), "state" ) );
+
+			CSourceLayer* label = addRandomSource( dnn, "label", 5, 3, hiddenSize, random );
+			EuclideanLoss()( "loss", lstm, label );
+
+			checkFusedRun( dnn, sinks );
+		}
+	}
+}
+
+TEST( CDnnFusedRecurrentTest, Gru )
+{
+	if( MathEngineType() != MET_Cpu ) {
+		return;
+	}
+
+	const int hiddenSize = 5;
+	for( int reverse = 0; reverse < 2; ++reverse ) {
+		for( int withInitialState = 0; withInitialState < 2; ++withInitialState ) {
+			CRandom random( 0x2E );
+			CDnn dnn( random, MathEngine() );
+			CSourceLayer* data = addRandomSource( dnn, "data", 6, 2, 9, random );
+
+			CGruLayer* gru = nullptr;
+			if( withInitialState != 0 ) {
+				CSourceLayer* history = addRandomSource( dnn, "initialHistory", 1, 2, hiddenSize, random );
+				gru = Gru( hiddenSize )( "gru", data, history );
+			} else {
+				gru = Gru( hiddenSize )( "gru", data );
+			}
+			gru->SetReverseSequence( reverse != 0 );
+
+			CArray<CSinkLayer*> sinks;
+			sinks.Add( Sink( gru, "output" ) );
+
+			CSourceLayer* label = addRandomSource( dnn, "label", 6, 2, hiddenSize, random );
+			EuclideanLoss()( "loss", gru, label );
+
+			checkFusedRun( dnn, sinks );
+		}
+	}
+}
@@ -193,6 +193,7 @@ static void checkSerializeLayer( const CString& layerName )
 
 	cnn.DeleteAllLayers();
 	checkSerializeFromFile<T>( cnn, newVersionFileName );
+	::remove( newVersionFileName );
 }
 
 GTEST_TEST( SerializeFromFile, BaseLayerSerialization )
@@ -0,0 +1,121 @@
+/* Copyright © 2021 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+
+#include <common.h>
+#pragma hdrstop
+
+#include <TestFixture.h>
+
+using namespace NeoML;
+using namespace NeoMLTest;
+
+static const char* const memoryPlanTestSinks[] = { "mid", "out", "seq" };
+
+// The network with in-place layers, outputs used several times and a composite layer
+static void buildMemoryPlanTestNet( CDnn& dnn )
+{
+	CSourceLayer* source = Source( dnn, "source" );
+	CConvLayer* conv1 = Conv( 8, CConvAxisParams( 3, 1 ), CConvAxisParams( 3, 1 ) )( "conv1", source );
+	CReLULayer* relu1 = Relu()( "relu1", conv1 );
+	CConvLayer* conv2 = Conv( 8, CConvAxisParams( 3, 1 ), CConvAxisParams( 3, 1 ) )( "conv2", relu1 );
+	CSigmoidLayer* sigmoid = Sigmoid()( "sigmoid", conv2 );
+	CEltwiseSumLayer* sum = Sum()( "sum", relu1, sigmoid );
+	CConvLayer* conv3 = Conv( 4, CConvAxisParams( 3, 1, 1, 2 ), CConvAxisParams( 3, 1, 1, 2 ) )( "conv3", sum );
+	CReLULayer* relu3 = Relu()( "relu3", conv3 );
+	CFullyConnectedLayer* fc = FullyConnected( 10 )( "fc", relu3 );
+	CLstmLayer* lstm = Lstm( 6, 0.f )( "lstm", fc );
+	Sink( conv2, "mid" );
+	Sink( fc, "out" );
+	Sink( lstm, "seq" );
+}
+
+static void setMemoryPlanTestInput( CDnn& dnn, CRandom& random, int batchLength, int batchWidth )
+{
+	CPtr<CDnnBlob> input = CDnnBlob::Create2DImageBlob( dnn.GetMathEngine(), CT_Float, batchLength, batchWidth, 9, 7, 3 );
+	CArray<float> inputData;
+	inputData.SetSize( input->GetDataSize() );
+	for( int i = 0; i < inputData.Size(); ++i ) {
+		inputData[i] = static_cast<float>( random.Uniform( -1, 1 ) );
+	}
+	input->CopyFrom( inputData.GetPtr() );
+	CheckCast<CSourceLayer>( dnn.GetLayer( "source" ).Ptr() )->SetBlob( input );
+}
+
+static void getMemoryPlanTestOutputs( CDnn& dnn, CArray<CArray<float>>& outputs )
+{
+	outputs.DeleteAll();
+	for( const char* sink : memoryPlanTestSinks ) {
+		const CDnnBlob& blob = *CheckCast<CSinkLayer>( dnn.GetLayer( sink ).Ptr() )->GetBlob();
+		CArray<float>& data = outputs.Append();
+		data.SetSize( blob.GetDataSize() );
+		blob.CopyTo( data.GetPtr() );
+	}
+}
+
+static void checkMemoryPlanTestOutputs( const CArray<CArray<float>>& expected, const CArray<CArray<float>>& actual )
+{
+	ASSERT_EQ( expected.Size(), actual.Size() );
+	for( int i = 0; i < expected.Size(); ++i ) {
+		ASSERT_EQ( expected[i].Size(), actual[i].Size() );
+		for( int j = 0; j < expected[i].Size(); ++j ) {
+			EXPECT_FLOAT_EQ( expected[i][j], actual[i][j] ) << memoryPlanTestSinks[i] << " " << j;
+		}
+	}
+}
+
+TEST( CDnnMemoryPlanTest, SameResults )
+{
+	CRandom random( 0x1F );
+	CDnn dnn( random, MathEngine() );
+	buildMemoryPlanTestNet( dnn );
+	setMemoryPlanTestInput( dnn, random, 2, 3 );
+
+	dnn.RunOnce();
+	CArray<CArray<float>> expected;
+	getMemoryPlanTestOutputs( dnn, expected );
+	EXPECT_EQ( 0, dnn.GetMemoryPlanSize() );
+
+	dnn.EnableStaticMemoryPlanning();
+	CArray<CArray<float>> actual;
+	for( int run = 0; run < 3; ++run ) {
+		dnn.RunOnce();
+		getMemoryPlanTestOutputs( dnn, actual );
+		checkMemoryPlanTestOutputs( expected, actual );
+	}
+
+	// The outputs share memory
+	size_t outputsSize = 0;
+	CArray<const char*> layerList;
+	dnn.GetLayerList( layerList );
+	for( int i = 0; i < layerList.Size(); ++i ) {
+		if( strcmp( layerList[i], "source" ) != 0 && strcmp( layerList[i], "lstm" ) != 0 ) {
+			outputsSize += dnn.GetLayer( layerList[i] )->GetOutputBlobsSize() * sizeof( float );
+		}
+	}
+	EXPECT_LT( 0, dnn.GetMemoryPlanSize() );
+	EXPECT_LT( dnn.GetMemoryPlanSize(), outputsSize );
+
+	// The plan is rebuilt for the new input size
+	setMemoryPlanTestInput( dnn, random, 3, 5 );
+	dnn.RunOnce();
+	getMemoryPlanTestOutputs( dnn, actual );
+
+	dnn.DisableStaticMemoryPlanning();
+	EXPECT_EQ( 0, dnn.GetMemoryPlanSize() );
+	dnn.RunOnce();
+	getMemoryPlanTestOutputs( dnn, expected );
+	checkMemoryPlanTestOutputs( expected, actual );
+}
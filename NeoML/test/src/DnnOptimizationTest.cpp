@@ -0,0 +1,151 @@
+/* Copyright © 2021 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <TestFixture.h>
+
+using namespace NeoML;
+using namespace NeoMLTest;
+
+static void setRandomFinalParams( CBatchNormalizationLayer& bn, CRandom& random )
+{
+	CPtr<CDnnBlob> finalParams = bn.GetFinalParams();
+	CArray<float> params;
+	params.SetSize( finalParams->GetDataSize() );
+	for( int i = 0; i < params.Size(); ++i ) {
+		params[i] = static_cast<float>( random.Uniform( -1.5, 1.5 ) );
+	}
+	finalParams->CopyFrom( params.GetPtr() );
+	bn.SetFinalParams( finalParams );
+}
+
+// Source -> Conv -> BatchNormalization -> ReLU -> FullyConnected -> BatchNormalization -> Sigmoid -> Sink
+// Source -> Conv -> HSwish -> Sink, the convolution output also goes to another Sink
+// Source -> FullyConnected (no free term) -> BatchNormalization -> GELU -> Sink
+static void buildOptimizationTestNet( CDnn& dnn, CRandom& random )
+{
+	CSourceLayer* source = Source( dnn, "source" );
+	CConvLayer* conv = Conv( 6, CConvAxisParams( 3, 1 ), CConvAxisParams( 3, 1, 2 ) )( "conv", source );
+	CBatchNormalizationLayer* convBn = BatchNormalization( true )( "convBn", conv );
+	CReLULayer* relu = Relu()( "relu", convBn );
+	CFullyConnectedLayer* fc = FullyConnected( 5 )( "fc", relu );
+	CBatchNormalizationLayer* fcBn = BatchNormalization( false )( "fcBn", fc );
+	CSigmoidLayer* sigmoid = Sigmoid()( "sigmoid", fcBn );
+	Sink( sigmoid, "sink" );
+
+	CConvLayer* branchConv = Conv( 3, CConvAxisParams( 1 ), CConvAxisParams( 1 ) )( "branchConv", source );
+	CHSwishLayer* hswish = HSwish()( "hswish", branchConv );
+	Sink( hswish, "branchSink" );
+	Sink( branchConv, "branchConvSink" );
+
+	CFullyConnectedLayer* noFreeTermFc = FullyConnected( 4, true )( "noFreeTermFc", source );
+	CBatchNormalizationLayer* noFreeTermBn = BatchNormalization( true )( "noFreeTermBn", noFreeTermFc );
+	CGELULayer* gelu = Gelu()( "gelu", noFreeTermBn );
+	Sink( gelu, "geluSink" );
+
+	CPtr<CDnnBlob> input = CDnnBlob::CreateBlob( dnn.GetMathEngine(), CT_Float, CBlobDesc( { 1, 3, 1, 7, 6, 1, 2 } ) );
+	CArray<float> inputData;
+	inputData.SetSize( input->GetDataSize() );
+	for( int i = 0; i < inputData.Size(); ++i ) {
+		inputData[i] = static_cast<float>( random.Uniform( -1, 1 ) );
+	}
+	input->CopyFrom( inputData.GetPtr() );
+	source->SetBlob( input );
+
+	dnn.RunOnce();
+	setRandomFinalParams( *convBn, random );
+	setRandomFinalParams( *fcBn, random );
+	setRandomFinalParams( *noFreeTermBn, random );
+}
+
+static void getSinkData( CDnn& dnn, const char* sinkName, CArray<float>& data )
+{
+	CPtr<CDnnBlob> blob = CheckCast<CSinkLayer>( dnn.GetLayer( sinkName ).Ptr() )->GetBlob();
+	data.SetSize( blob->GetDataSize() );
+	blob->CopyTo( data.GetPtr() );
+}
+
+static void checkSinkData( CDnn& dnn, const char* sinkName, const CArray<float>& expected )
+{
+	CArray<float> actual;
+	getSinkData( dnn, sinkName, actual );
+	ASSERT_EQ( expected.Size(), actual.Size() );
+	for( int i = 0; i < expected.Size(); ++i ) {
+		EXPECT_NEAR( expected[i], actual[i], 1e-4f ) << sinkName << " " << i;
+	}
+}
+
+TEST( CDnnOptimizationTest, FoldAndFuse )
+{
+	const char* const sinkNames[] = { "sink", "branchSink", "branchConvSink", "geluSink" };
+	const int sinkCount = sizeof( sinkNames ) / sizeof( sinkNames[0] );
+
+	CRandom random( 0x1E );
+	CDnn dnn( random, MathEngine() );
+	buildOptimizationTestNet( dnn, random );
+
+	dnn.RunOnce();
+	CArray<float> expected[sinkCount];
+	for( int i = 0; i < sinkCount; ++i ) {
+		getSinkData( dnn, sinkNames[i], expected[i] );
+	}
+	const int layerCount = dnn.GetLayerCount();
+
+	CDnnOptimizer optimizer( dnn );
+	EXPECT_EQ( 6, optimizer.Optimize() );
+	EXPECT_EQ( layerCount - 6, dnn.GetLayerCount() );
+	EXPECT_EQ( 0, optimizer.Optimize() );
+
+	EXPECT_FALSE( dnn.HasLayer( "convBn" ) );
+	EXPECT_FALSE( dnn.HasLayer( "relu" ) );
+	EXPECT_FALSE( dnn.HasLayer( "fcBn" ) );
+	EXPECT_FALSE( dnn.HasLayer( "sigmoid" ) );
+	EXPECT_FALSE( dnn.HasLayer( "noFreeTermBn" ) );
+	EXPECT_FALSE( dnn.HasLayer( "gelu" ) );
+	// The convolution output is used twice so the activation is kept
+	EXPECT_TRUE( dnn.HasLayer( "hswish" ) );
+
+	EXPECT_EQ( AF_ReLU, CheckCast<CConvLayer>( dnn.GetLayer( "conv" ).Ptr() )->GetActivation().Type );
+	EXPECT_EQ( AF_Sigmoid, CheckCast<CFullyConnectedLayer>( dnn.GetLayer( "fc" ).Ptr() )->GetActivation().Type );
+	EXPECT_TRUE( CheckCast<CConvLayer>( dnn.GetLayer( "branchConv" ).Ptr() )->GetActivation().IsIdentity() );
+
+	dnn.RunOnce();
+	for( int i = 0; i < sinkCount; ++i ) {
+		checkSinkData( dnn, sinkNames[i], expected[i] );
+	}
+
+	// The merged activations are serialized
+	const CString fileName = "optimized_test.arch";
+	{
+		CArchiveFile archiveFile( fileName, CArchive::store, GetPlatformEnv() );
+		CArchive archive( &archiveFile, CArchive::SD_Storing );
+		archive.Serialize( dnn );
+	}
+	CDnn loaded( random, MathEngine() );
+	{
+		CArchiveFile archiveFile( fileName, CArchive::load, GetPlatformEnv() );
+		CArchive archive( &archiveFile, CArchive::SD_Loading );
+		archive.Serialize( loaded );
+	}
+	::remove( fileName );
+	CheckCast<CSourceLayer>( loaded.GetLayer( "source" ).Ptr() )->SetBlob(
+		CheckCast<CSourceLayer>( dnn.GetLayer( "source" ).Ptr() )->GetBlob() );
+	loaded.RunOnce();
+	for( int i = 0; i < sinkCount; ++i ) {
+		checkSinkData( loaded, sinkNames[i], expected[i] );
+	}
+}
@@ -0,0 +1,229 @@
+/* Copyright © 2021 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <TestFixture.h>
+
+using namespace NeoML;
+using namespace NeoMLTest;
+
+// The training in the parameter arena mode should give the same results as the usual one
+// The networks are trained in both modes from the same initial state and their weights are compared
+
+static CSourceLayer* addRandomSource( CDnn& dnn, const char* name, int batchWidth, int channels, CRandom& random )
+{
+	CSourceLayer* source = Source( dnn, name );
+	CPtr<CDnnBlob> blob = CDnnBlob::CreateDataBlob( dnn.GetMathEngine(), CT_Float, 1, batchWidth, channels );
+	CArray<float> data;
+	data.SetSize( blob->GetDataSize() );
+	for( int i = 0; i < data.Size(); ++i ) {
+		data[i] = static_cast<float>( random.Uniform( -1, 1 ) );
+	}
+	blob->CopyFrom( data.GetPtr() );
+	source->SetBlob( blob );
+	return source;
+}
+
+// The network with several fully connected layers, one of them has its own learning rate
+static void buildNetwork( CDnn& dnn, CArray<CFullyConnectedLayer*>& fcs )
+{
+	CRandom random( 0x3F );
+	CSourceLayer* data = addRandomSource( dnn, "data", 8, 10, random );
+	CSourceLayer* label = addRandomSource( dnn, "label", 8, 4, random );
+
+	fcs.Add( FullyConnected( 12 )( "fc1", data ) );
+	CBaseLayer* relu = Relu()( "relu", fcs.Last() );
+	fcs.Add( FullyConnected( 7 )( "fc2", relu ) );
+	fcs.Last()->SetBaseLearningRate( 0.5f );
+	CBaseLayer* tanh = Tanh()( "tanh", fcs.Last() );
+	fcs.Add( FullyConnected( 4 )( "fc3", tanh ) );
+	EuclideanLoss()( "loss", fcs.Last(), label );
+}
+
+static void checkWeightsEqual( const CArray<CFullyConnectedLayer*>& expected, const CArray<CFullyConnectedLayer*>& actual )
+{
+	ASSERT_EQ( expected.Size(), actual.Size() );
+	for( int i = 0; i < expected.Size(); ++i ) {
+		CPtr<CDnnBlob> expectedBlobs[2] = { expected[i]->GetWeightsData(), expected[i]->GetFreeTermData() };
+		CPtr<CDnnBlob> actualBlobs[2] = { actual[i]->GetWeightsData(), actual[i]->GetFreeTermData() };
+		for( int j = 0; j < 2; ++j ) {
+			CArray<float> expectedData;
+			expectedData.SetSize( expectedBlobs[j]->GetDataSize() );
+			expectedBlobs[j]->CopyTo( expectedData.GetPtr() );
+			CArray<float> actualData;
+			actualData.SetSize( actualBlobs[j]->GetDataSize() );
+			actualBlobs[j]->CopyTo( actualData.GetPtr() );
+			ASSERT_EQ( expectedData.Size(), actualData.Size() );
+			for( int k = 0; k < expectedData.Size(); ++k ) {
+				EXPECT_NEAR( expectedData[k], actualData[k], 1e-4f );
+			}
+		}
+	}
+}
+
+// Trains two copies of the network, the second one switches to the arena mode after the enableStep steps
+static void checkParamArena( const CPtr<CDnnSolver>& expectedSolver, const CPtr<CDnnSolver>& actualSolver,
+	int enableStep )
+{
+	const int stepCount = 6;
+	CRandom expectedRandom( 0x11 );
+	CDnn expectedDnn( expectedRandom, MathEngine() );
+	CArray<CFullyConnectedLayer*> expectedFcs;
+	buildNetwork( expectedDnn, expectedFcs );
+	expectedDnn.SetSolver( expectedSolver );
+
+	CRandom actualRandom( 0x11 );
+	CDnn actualDnn( actualRandom, MathEngine() );
+	CArray<CFullyConnectedLayer*> actualFcs;
+	buildNetwork( actualDnn, actualFcs );
+	actualDnn.SetSolver( actualSolver );
+
+	for( int step = 0; step < stepCount; ++step ) {
+		if( step == enableStep ) {
+			actualSolver->EnableParamArena( true );
+		}
+		// Two runs per step check the gradient averaging
+		expectedDnn.RunAndBackwardOnce();
+		expectedDnn.RunAndLearnOnce();
+		actualDnn.RunAndBackwardOnce();
+		actualDnn.RunAndLearnOnce();
+	}
+	checkWeightsEqual( expectedFcs, actualFcs );
+
+	// All the parameters are in the arena
+	ASSERT_TRUE( actualSolver->GetParamArena() != nullptr );
+	int paramCount = 0;
+	for( int i = 0; i < actualFcs.Size(); ++i ) {
+		paramCount += actualFcs[i]->GetWeightsData()->GetDataSize() + actualFcs[i]->GetFreeTermData()->GetDataSize();
+	}
+	EXPECT_EQ( paramCount, actualSolver->GetParamArena()->GetDataSize() );
+
+	// Some of the layers in a group are not trained
+	expectedFcs[0]->DisableLearning();
+	actualFcs[0]->DisableLearning();
+	for( int step = 0; step < 2; ++step ) {
+		expectedDnn.RunAndLearnOnce();
+		actualDnn.RunAndLearnOnce();
+	}
+	checkWeightsEqual( expectedFcs, actualFcs );
+}
+
+static CPtr<CDnnSolver> createAdam( bool isAmsGradEnabled )
+{
+	CPtr<CDnnAdaptiveGradientSolver> solver = new CDnnAdaptiveGradientSolver( MathEngine() );
+	solver->EnableAmsGrad( isAmsGradEnabled );
+	solver->SetLearningRate( 0.05f );
+	solver->SetL2Regularization( 0.01f );
+	solver->SetL1Regularization( 0.001f );
+	solver->SetMaxGradientNorm( 0.5f );
+	return solver.Ptr();
+}
+
+TEST( CDnnParamArenaTest, SimpleGradient )
+{
+	for( int enableStep = 0; enableStep < 4; enableStep += 3 ) {
+		CPtr<CDnnSimpleGradientSolver> expected = new CDnnSimpleGradientSolver( MathEngine() );
+		CPtr<CDnnSimpleGradientSolver> actual = new CDnnSimpleGradientSolver( MathEngine() );
+		for( CDnnSimpleGradientSolver* solver : { expected.Ptr(), actual.Ptr() } ) {
+			solver->SetLearningRate( 0.05f );
+			solver->SetL2Regularization( 0.01f );
+			solver->SetMaxGradientNorm( 0.5f );
+		}
+		checkParamArena( expected.Ptr(), actual.Ptr(), enableStep );
+	}
+}
+
+TEST( CDnnParamArenaTest, Adam )
+{
+	for( int enableStep = 0; enableStep < 4; enableStep += 3 ) {
+		for( int amsGrad = 0; amsGrad < 2; ++amsGrad ) {
+			checkParamArena( createAdam( amsGrad != 0 ), createAdam( amsGrad != 0 ), enableStep );
+		}
+	}
+}
+
+TEST( CDnnParamArenaTest, Nesterov )
+{
+	for( int enableStep = 0; enableStep < 4; enableStep += 3 ) {
+		CPtr<CDnnNesterovGradientSolver> expected = new CDnnNesterovGradientSolver( MathEngine() );
+		CPtr<CDnnNesterovGradientSolver> actual = new CDnnNesterovGradientSolver( MathEngine() );
+		for( CDnnNesterovGradientSolver* solver : { expected.Ptr(), actual.Ptr() } ) {
+			solver->SetLearningRate( 0.05f );
+			solver->SetL2Regularization( 0.01f );
+		}
+		checkParamArena( expected.Ptr(), actual.Ptr(), enableStep );
+	}
+}
+
+TEST( CDnnParamArenaTest, Lamb )
+{
+	for( int enableStep = 0; enableStep < 4; enableStep += 3 ) {
+		CPtr<CDnnLambGradientSolver> expected = new CDnnLambGradientSolver( MathEngine() );
+		CPtr<CDnnLambGradientSolver> actual = new CDnnLambGradientSolver( MathEngine() );
+		for( CDnnLambGradientSolver* solver : { expected.Ptr(), actual.Ptr() } ) {
+			solver->SetLearningRate( 0.05f );
+			solver->SetL2Regularization( 0.01f );
+			solver->ExcludeBiasParamLayers();
+		}
+		checkParamArena( expected.Ptr(), actual.Ptr(), enableStep );
+	}
+}
+
+TEST( CDnnParamArenaTest, Serialization )
+{
+	CRandom random( 0x11 );
+	CDnn dnn( random, MathEngine() );
+	CArray<CFullyConnectedLayer*> fcs;
+	buildNetwork( dnn, fcs );
+	CPtr<CDnnSolver> solver = createAdam( false );
+	solver->EnableParamArena( true );
+	dnn.SetSolver( solver );
+	for( int step = 0; step < 3; ++step ) {
+		dnn.RunAndLearnOnce();
+	}
+
+	// The solver state is stored per layer, the arena is rebuilt after loading
+	const CString fileName = "param_arena_test.arch";
+	{
+		CArchiveFile archiveFile( fileName, CArchive::store, GetPlatformEnv() );
+		CArchive archive( &archiveFile, CArchive::SD_Storing );
+		dnn.SerializeCheckpoint( archive );
+	}
+	CRandom loadedRandom( 0x11 );
+	CDnn loadedDnn( loadedRandom, MathEngine() );
+	{
+		CArchiveFile archiveFile( fileName, CArchive::load, GetPlatformEnv() );
+		CArchive archive( &archiveFile, CArchive::SD_Loading );
+		loadedDnn.SerializeCheckpoint( archive );
+	}
+	::remove( fileName );
+	EXPECT_TRUE( loadedDnn.GetSolver()->IsParamArenaEnabled() );
+	for( const char* name : { "data", "label" } ) {
+		CheckCast<CSourceLayer>( loadedDnn.GetLayer( name ).Ptr() )->SetBlob(
+			CheckCast<CSourceLayer>( dnn.GetLayer( name ).Ptr() )->GetBlob() );
+	}
+
+	CArray<CFullyConnectedLayer*> loadedFcs;
+	for( const char* name : { "fc1", "fc2", "fc3" } ) {
+		loadedFcs.Add( CheckCast<CFullyConnectedLayer>( loadedDnn.GetLayer( name ).Ptr() ) );
+	}
+	for( int step = 0; step < 3; ++step ) {
+		dnn.RunAndLearnOnce();
+		loadedDnn.RunAndLearnOnce();
+	}
+	checkWeightsEqual( fcs, loadedFcs );
+}
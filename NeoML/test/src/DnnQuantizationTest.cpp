@@ -0,0 +1,130 @@
+/* Copyright © 2021 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <TestFixture.h>
+
+using namespace NeoML;
+using namespace NeoMLTest;
+
+// Source -> Conv -> ReLU -> FullyConnected -> Sink
+static CSinkLayer* buildQuantizationTestNet( CDnn& dnn, CRandom& random )
+{
+	CSourceLayer* source = Source( dnn, "source" );
+	CPtr<CDnnBlob> input = CDnnBlob::CreateBlob( dnn.GetMathEngine(), CT_Float, CBlobDesc( { 1, 4, 1, 9, 7, 1, 3 } ) );
+	CArray<float> inputData;
+	inputData.SetSize( input->GetDataSize() );
+	for( int i = 0; i < inputData.Size(); ++i ) {
+		inputData[i] = static_cast<float>( random.Uniform( -1, 3 ) );
+	}
+	input->CopyFrom( inputData.GetPtr() );
+	source->SetBlob( input );
+
+	CConvLayer* conv = Conv( 8, CConvAxisParams( 3, 1 ), CConvAxisParams( 3, 1, 2 ) )( "conv", source );
+	CReLULayer* relu = Relu()( "relu", conv );
+	CFullyConnectedLayer* fc = FullyConnected( 10 )( "fc", relu );
+	return Sink( fc, "sink" );
+}
+
+static void checkQuantizedOutput( const CDnnBlob& expected, const CDnnBlob& actual )
+{
+	CArray<float> expectedData;
+	expectedData.SetSize( expected.GetDataSize() );
+	expected.CopyTo( expectedData.GetPtr() );
+
+	CArray<float> actualData;
+	actualData.SetSize( actual.GetDataSize() );
+	actual.CopyTo( actualData.GetPtr() );
+
+	ASSERT_EQ( expectedData.Size(), actualData.Size() );
+	float maxAbs = 0;
+	for( int i = 0; i < expectedData.Size(); ++i ) {
+		maxAbs = max( maxAbs, fabsf( expectedData[i] ) );
+	}
+	// 8-bit quantization error is about 1% of the range
+	for( int i = 0; i < expectedData.Size(); ++i ) {
+		EXPECT_NEAR( expectedData[i], actualData[i], 0.05f * maxAbs );
+	}
+}
+
+TEST( CDnnQuantizationTest, ConvAndFullyConnected )
+{
+	if( MathEngineType() != MET_Cpu ) {
+		return;
+	}
+
+	CRandom random( 0x5A );
+	CDnn dnn( random, MathEngine() );
+	CSinkLayer* sink = buildQuantizationTestNet( dnn, random );
+
+	dnn.RunOnce();
+	CPtr<CDnnBlob> expected = sink->GetBlob()->GetCopy();
+
+	CDnnQuantizer quantizer( dnn );
+	EXPECT_EQ( 0, quantizer.Quantize() );
+	quantizer.RunCalibration();
+	EXPECT_EQ( 2, quantizer.Quantize() );
+
+	CPtr<CFullyConnectedLayer> fc = CheckCast<CFullyConnectedLayer>( dnn.GetLayer( "fc" ).Ptr() );
+	CPtr<CConvLayer> conv = CheckCast<CConvLayer>( dnn.GetLayer( "conv" ).Ptr() );
+	EXPECT_TRUE( fc->IsQuantized() );
+	EXPECT_TRUE( conv->IsQuantized() );
+	EXPECT_EQ( 10, fc->GetWeightsData()->GetObjectCount() );
+	EXPECT_EQ( 8, conv->GetFilterData()->GetObjectCount() );
+
+	dnn.RunOnce();
+	CPtr<CDnnBlob> quantized = sink->GetBlob()->GetCopy();
+	checkQuantizedOutput( *expected, *quantized );
+
+	// The quantized network is serialized with the quantized weights
+	const CString fileName = "quantized_test.arch";
+	{
+		CArchiveFile archiveFile( fileName, CArchive::store, GetPlatformEnv() );
+		CArchive archive( &archiveFile, CArchive::SD_Storing );
+		archive.Serialize( dnn );
+	}
+
+	CDnn loaded( random, MathEngine() );
+	{
+		CArchiveFile archiveFile( fileName, CArchive::load, GetPlatformEnv() );
+		CArchive archive( &archiveFile, CArchive::SD_Loading );
+		archive.Serialize( loaded );
+	}
+	::remove( fileName );
+	EXPECT_TRUE( CheckCast<CFullyConnectedLayer>( loaded.GetLayer( "fc" ).Ptr() )->IsQuantized() );
+	EXPECT_TRUE( CheckCast<CConvLayer>( loaded.GetLayer( "conv" ).Ptr() )->IsQuantized() );
+
+	CheckCast<CSourceLayer>( loaded.GetLayer( "source" ).Ptr() )->SetBlob(
+		CheckCast<CSourceLayer>( dnn.GetLayer( "source" ).Ptr() )->GetBlob() );
+	loaded.RunOnce();
+	CPtr<CDnnBlob> loadedOutput = CheckCast<CSinkLayer>( loaded.GetLayer( "sink" ).Ptr() )->GetBlob();
+
+	CArray<float> quantizedData;
+	quantizedData.SetSize( quantized->GetDataSize() );
+	quantized->CopyTo( quantizedData.GetPtr() );
+	CArray<float> loadedData;
+	loadedData.SetSize( loadedOutput->GetDataSize() );
+	loadedOutput->CopyTo( loadedData.GetPtr() );
+	ASSERT_EQ( quantizedData.Size(), loadedData.Size() );
+	for( int i = 0; i < quantizedData.Size(); ++i ) {
+		EXPECT_FLOAT_EQ( quantizedData[i], loadedData[i] );
+	}
+
+	// Setting the float weights returns the layer to the float mode
+	fc->SetWeightsData( fc->GetWeightsData() );
+	EXPECT_FALSE( fc->IsQuantized() );
+}
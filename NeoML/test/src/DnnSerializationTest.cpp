@@ -61,6 +61,7 @@ TEST_F( CDnnSerializationTest, CnnUninitializedLayerSerialization )
 			CArchive archive( &archiveFile, CArchive::SD_Loading );
 			archive.Serialize( cnn );
 		}
+		::remove( newVersionFileName );
 
 		cnn.DeleteLayer( layerName );
 	}
@@ -164,11 +165,115 @@ static void checkSerializedNet( const CString& fileName )
 			CArchive archive( &archiveFile, CArchive::SD_Loading );
 			archive.Serialize( cnn );
 		}
+
+		checkNet( inputBlobs, outputBlobs, cnn, fileName );
+
+		{
+			// Load from the memory-mapped file
+			CMappedArchiveFile mappedFile( newVersionFileName );
+			CArchive archive( &mappedFile, CArchive::SD_Loading );
+			archive.Serialize( cnn );
+		}
+		::remove( newVersionFileName );
 	}
 
 	checkNet( inputBlobs, outputBlobs, cnn, fileName );
 }
 
+// Checks that the parameters loaded from a memory-mapped file are used without copying
+TEST_F( CDnnSerializationTest, MappedFileLoading )
+{
+	CRandom random( 0x54321 );
+	CPtr<CDnnBlob> input = CDnnBlob::CreateDataBlob( MathEngine(), CT_Float, 1, 4, 100 );
+	CArray<float> inputData;
+	inputData.SetSize( input->GetDataSize() );
+	for( int i = 0; i < inputData.Size(); ++i ) {
+		inputData[i] = static_cast<float>( random.Uniform( -1, 1 ) );
+	}
+	input->CopyFrom( inputData.GetPtr() );
+
+	const CString fileName = "mapped_test_archive.new_ver";
+	CArray<float> expected;
+	{
+		CDnn dnn( random, MathEngine() );
+		CSourceLayer* source = Source( dnn, "source" );
+		CFullyConnectedLayer* fc1 = FullyConnected( 64 )( "fc1", source );
+		CReLULayer* relu = Relu()( "relu", fc1 );
+		CFullyConnectedLayer* fc2 = FullyConnected( 3 )( "fc2", relu );
+		CSinkLayer* sink = Sink( fc2, "sink" );
+		source->SetBlob( input );
+		dnn.RunOnce();
+		expected.SetSize( sink->GetBlob()->GetDataSize() );
+		sink->GetBlob()->CopyTo( expected.GetPtr() );
+
+		CArchiveFile archiveFile( fileName, CArchive::store, GetPlatformEnv() );
+		CArchive archive( &archiveFile, CArchive::SD_Storing );
+		archive.Serialize( dnn );
+	}
+
+	CPtr<CMappedFileData> mapping;
+	{
+		CDnn dnn( random, MathEngine() );
+		{
+			CMappedArchiveFile mappedFile( fileName );
+			mapping = mappedFile.GetMapping();
+			CArchive archive( &mappedFile, CArchive::SD_Loading );
+			archive.Serialize( dnn );
+		}
+		if( MathEngine().GetType() == MET_Cpu ) {
+			// The weights of fc1 point into the mapped file
+			EXPECT_LT( 1, mapping->RefCount() );
+		} else {
+			EXPECT_EQ( 1, mapping->RefCount() );
+		}
+
+		CheckCast<CSourceLayer>( dnn.GetLayer( "source" ).Ptr() )->SetBlob( input );
+		dnn.RunOnce();
+		const CDnnBlob& output = *CheckCast<CSinkLayer>( dnn.GetLayer( "sink" ).Ptr() )->GetBlob();
+		ASSERT_EQ( expected.Size(), output.GetDataSize() );
+		CArray<float> actual;
+		actual.SetSize( output.GetDataSize() );
+		output.CopyTo( actual.GetPtr() );
+		for( int i = 0; i < expected.Size(); ++i ) {
+			EXPECT_FLOAT_EQ( expected[i], actual[i] );
+		}
+	}
+	// The mapping is released together with the network
+	EXPECT_EQ( 1, mapping->RefCount() );
+	mapping = nullptr;
+	::remove( fileName );
+}
+
+TEST_F( CDnnSerializationTest, MappedBlobIsReadOnly )
+{
+	CPtr<CDnnBlob> blob = CDnnBlob::CreateDataBlob( MathEngine(), CT_Float, 2, 4, 1000 );
+	blob->Fill( 1.f );
+
+	const CString fileName = "mapped_test_blob.new_ver";
+	{
+		CArchiveFile archiveFile( fileName, CArchive::store, GetPlatformEnv() );
+		CArchive archive( &archiveFile, CArchive::SD_Storing );
+		blob->Serialize( archive );
+	}
+
+	{
+		CPtr<CDnnBlob> loaded = FINE_DEBUG_NEW CDnnBlob( MathEngine() );
+		{
+			CMappedArchiveFile mappedFile( fileName );
+			CArchive archive( &mappedFile, CArchive::SD_Loading );
+			loaded->Serialize( archive );
+		}
+		// Only the CPU math engine uses the mapped memory
+		EXPECT_EQ( MathEngine().GetType() == MET_Cpu, loaded->IsReadOnly() );
+		EXPECT_EQ( loaded->IsReadOnly(), CPtr<CDnnBlob>( CDnnBlob::CreateWindowBlob( loaded ) )->IsReadOnly() );
+		// The copies may be changed
+		CPtr<CDnnBlob> copy = loaded->GetCopy();
+		EXPECT_FALSE( copy->IsReadOnly() );
+		copy->Fill( 2.f );
+	}
+	::remove( fileName );
+}
+
 // Checks serialization of the old versions of CDnn
 TEST_P( CDnnSerializationTest, PreviousVersions )
 {
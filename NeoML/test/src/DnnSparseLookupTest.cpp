@@ -0,0 +1,230 @@
+/* Copyright © 2021 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <TestFixture.h>
+
+using namespace NeoML;
+using namespace NeoMLTest;
+
+// The training with the sparse embedding gradients should give the same results as the usual one
+// when the solver doesn't change the unused rows
+
+static const int batchWidth = 6;
+static const int labelSize = 3;
+static const CLookupDimension tableDims[] = { CLookupDimension( 20, 4 ), CLookupDimension( 50, 3 ) };
+static const int tableCount = sizeof( tableDims ) / sizeof( tableDims[0] );
+
+static void buildNetwork( CDnn& dnn, const CPtr<CDnnSolver>& solver, bool isSparse )
+{
+	CSourceLayer* ids = Source( dnn, "ids" );
+	CSourceLayer* label = Source( dnn, "label" );
+
+	CPtr<CMultichannelLookupLayer> lookup = new CMultichannelLookupLayer( dnn.GetMathEngine() );
+	lookup->SetName( "lookup" );
+	CArray<CLookupDimension> dims;
+	for( int i = 0; i < tableCount; i++ ) {
+		dims.Add( tableDims[i] );
+	}
+	lookup->SetDimensions( dims );
+	lookup->SetUseFrameworkLearning( true );
+	lookup->EnableSparseGradient( isSparse );
+	lookup->Connect( *ids );
+	dnn.AddLayer( *lookup );
+
+	CBaseLayer* fc = FullyConnected( labelSize )( "fc", lookup.Ptr() );
+	EuclideanLoss()( "loss", fc, label );
+	dnn.SetSolver( solver );
+}
+
+// Sets the batch that uses only the rows less than rowLimit of each table
+// If rowLimit is not greater than the batch width, all these rows are used
+static void setBatch( CDnn& dnn, CRandom& random, int rowLimit )
+{
+	CArray<int> ids;
+	for( int i = 0; i < batchWidth; i++ ) {
+		for( int j = 0; j < tableCount; j++ ) {
+			if( rowLimit <= batchWidth ) {
+				ids.Add( ( i + j ) % rowLimit );
+			} else {
+				ids.Add( random.UniformInt( 0, min( rowLimit, tableDims[j].VectorCount ) - 1 ) );
+			}
+		}
+	}
+	CPtr<CDnnBlob> idsBlob = CDnnBlob::CreateDataBlob( dnn.GetMathEngine(), CT_Int, 1, batchWidth, tableCount );
+	idsBlob->CopyFrom( ids.GetPtr() );
+	CheckCast<CSourceLayer>( dnn.GetLayer( "ids" ).Ptr() )->SetBlob( idsBlob );
+
+	CArray<float> labels;
+	for( int i = 0; i < batchWidth * labelSize; i++ ) {
+		labels.Add( static_cast<float>( random.Uniform( -1, 1 ) ) );
+	}
+	CPtr<CDnnBlob> labelBlob = CDnnBlob::CreateDataBlob( dnn.GetMathEngine(), CT_Float, 1, batchWidth, labelSize );
+	labelBlob->CopyFrom( labels.GetPtr() );
+	CheckCast<CSourceLayer>( dnn.GetLayer( "label" ).Ptr() )->SetBlob( labelBlob );
+}
+
+static void getTable( const CDnn& dnn, int index, CArray<float>& table )
+{
+	const CDnnBlob* blob = CheckCast<const CMultichannelLookupLayer>( dnn.GetLayer( "lookup" ).Ptr() )->GetEmbeddings( index );
+	table.SetSize( blob->GetDataSize() );
+	blob->CopyTo( table.GetPtr() );
+}
+
+static void checkTablesEqual( const CDnn& expectedDnn, const CDnn& dnn )
+{
+	CArray<float> expected;
+	CArray<float> actual;
+	for( int i = 0; i < tableCount; i++ ) {
+		getTable( expectedDnn, i, expected );
+		getTable( dnn, i, actual );
+		ASSERT_EQ( expected.Size(), actual.Size() );
+		for( int j = 0; j < expected.Size(); j++ ) {
+			EXPECT_NEAR( expected[j], actual[j], 1e-5f );
+		}
+	}
+}
+
+// Trains the dense and the sparse networks on the same data
+// Each step consists of two runs to check the gradient accumulation
+static void trainAndCompare( const CPtr<CDnnSolver>& denseSolver, const CPtr<CDnnSolver>& sparseSolver,
+	int firstRowLimit, int rowLimit )
+{
+	CRandom denseRandom( 0x2C );
+	CDnn dense( denseRandom, MathEngine() );
+	buildNetwork( dense, denseSolver, false );
+	CRandom sparseRandom( 0x2C );
+	CDnn sparse( sparseRandom, MathEngine() );
+	buildNetwork( sparse, sparseSolver, true );
+
+	for( int step = 0; step < 4; step++ ) {
+		for( int run = 0; run < 2; run++ ) {
+			// The first run always uses the rows less than firstRowLimit
+			const int limit = run == 0 ? firstRowLimit : rowLimit;
+			CRandom denseDataRandom( step * 2 + run );
+			setBatch( dense, denseDataRandom, limit );
+			dense.RunAndBackwardOnce();
+			CRandom sparseDataRandom( step * 2 + run );
+			setBatch( sparse, sparseDataRandom, limit );
+			sparse.RunAndBackwardOnce();
+		}
+		denseSolver->Train();
+		sparseSolver->Train();
+	}
+	checkTablesEqual( dense, sparse );
+}
+
+TEST( CDnnSparseLookupTest, SimpleSolver )
+{
+	// Without the moment and the regularization the unused rows are not changed by the dense training
+	CPtr<CDnnSimpleGradientSolver> denseSolver = new CDnnSimpleGradientSolver( MathEngine() );
+	denseSolver->SetLearningRate( 0.1f );
+	denseSolver->SetMomentDecayRate( 0 );
+	CPtr<CDnnSimpleGradientSolver> sparseSolver = new CDnnSimpleGradientSolver( MathEngine() );
+	sparseSolver->SetLearningRate( 0.1f );
+	sparseSolver->SetMomentDecayRate( 0 );
+	trainAndCompare( denseSolver.Ptr(), sparseSolver.Ptr(), 50, 50 );
+}
+
+TEST( CDnnSparseLookupTest, AdamSolver )
+{
+	// The same rows are used on each step, so the dense training doesn't change the others
+	CPtr<CDnnAdaptiveGradientSolver> denseSolver = new CDnnAdaptiveGradientSolver( MathEngine() );
+	denseSolver->SetLearningRate( 0.05f );
+	CPtr<CDnnAdaptiveGradientSolver> sparseSolver = new CDnnAdaptiveGradientSolver( MathEngine() );
+	sparseSolver->SetLearningRate( 0.05f );
+	trainAndCompare( denseSolver.Ptr(), sparseSolver.Ptr(), 3, 3 );
+}
+
+TEST( CDnnSparseLookupTest, UnusedRows )
+{
+	// The sparse training doesn't change the unused rows even with the moment and the regularization
+	CRandom random( 0x3D );
+	CDnn dnn( random, MathEngine() );
+	CPtr<CDnnAdaptiveGradientSolver> solver = new CDnnAdaptiveGradientSolver( MathEngine() );
+	solver->SetLearningRate( 0.05f );
+	solver->SetL2Regularization( 0.1f );
+	buildNetwork( dnn, solver.Ptr(), true );
+
+	CRandom dataRandom( 0x4E );
+	setBatch( dnn, dataRandom, 10 );
+	dnn.RunAndLearnOnce();
+	CArray<float> initial;
+	getTable( dnn, 1, initial );
+
+	for( int step = 0; step < 3; step++ ) {
+		setBatch( dnn, dataRandom, 5 );
+		dnn.RunAndLearnOnce();
+	}
+	CArray<float> trained;
+	getTable( dnn, 1, trained );
+	const int rowSize = tableDims[1].VectorSize;
+	for( int i = 0; i < initial.Size(); i++ ) {
+		if( i < 5 * rowSize ) {
+			EXPECT_NE( initial[i], trained[i] );
+		} else {
+			EXPECT_EQ( initial[i], trained[i] );
+		}
+	}
+}
+
+TEST( CDnnSparseLookupTest, DenseFallback )
+{
+	// The solver that can't train the rows separately gets the usual gradients
+	CPtr<CDnnNesterovGradientSolver> denseSolver = new CDnnNesterovGradientSolver( MathEngine() );
+	denseSolver->SetLearningRate( 0.05f );
+	denseSolver->SetL2Regularization( 0.01f );
+	CPtr<CDnnNesterovGradientSolver> sparseSolver = new CDnnNesterovGradientSolver( MathEngine() );
+	sparseSolver->SetLearningRate( 0.05f );
+	sparseSolver->SetL2Regularization( 0.01f );
+	trainAndCompare( denseSolver.Ptr(), sparseSolver.Ptr(), 10, 50 );
+}
+
+TEST( CDnnSparseLookupTest, Serialization )
+{
+	// The accumulated sparse gradients are stored with the solver
+	CPtr<CDnnAdaptiveGradientSolver> solver = new CDnnAdaptiveGradientSolver( MathEngine() );
+	solver->SetLearningRate( 0.05f );
+	CRandom random( 0x5F );
+	CDnn dnn( random, MathEngine() );
+	buildNetwork( dnn, solver.Ptr(), true );
+	CRandom dataRandom( 0x11 );
+	setBatch( dnn, dataRandom, 5 );
+	dnn.RunAndLearnOnce();
+	setBatch( dnn, dataRandom, 5 );
+	dnn.RunAndBackwardOnce();
+
+	const CString fileName = "sparse_lookup_test.arch";
+	{
+		CArchiveFile archiveFile( fileName, CArchive::store, GetPlatformEnv() );
+		CArchive archive( &archiveFile, CArchive::SD_Storing );
+		dnn.SerializeCheckpoint( archive );
+	}
+	CRandom loadedRandom( 0x5F );
+	CDnn loadedDnn( loadedRandom, MathEngine() );
+	{
+		CArchiveFile archiveFile( fileName, CArchive::load, GetPlatformEnv() );
+		CArchive archive( &archiveFile, CArchive::SD_Loading );
+		loadedDnn.SerializeCheckpoint( archive );
+	}
+	::remove( fileName );
+	EXPECT_TRUE( CheckCast<CMultichannelLookupLayer>( loadedDnn.GetLayer( "lookup" ).Ptr() )->IsSparseGradientEnabled() );
+
+	dnn.GetSolver()->Train();
+	loadedDnn.GetSolver()->Train();
+	checkTablesEqual( dnn, loadedDnn );
+}
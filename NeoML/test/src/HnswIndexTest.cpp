@@ -0,0 +1,269 @@
+/* Copyright © 2017-2020 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <TestFixture.h>
+
+using namespace NeoML;
+using namespace NeoMLTest;
+
+class CHnswIndexTest : public CNeoMLTestFixture, public ::testing::WithParamInterface<TDistanceFunc> {
+public:
+	static bool InitTestFixture() { return true; }
+	static void DeinitTestFixture() {}
+};
+
+// The dense matrix of random vectors; about a half of the values are zero
+class CHnswTestData {
+public:
+	CHnswTestData( CRandom& random, int height, int width );
+
+	CFloatMatrixDesc GetDesc() const { return desc; }
+	const float* GetRow( int index ) const { return values.GetPtr() + index * desc.Width; }
+
+private:
+	CFloatMatrixDesc desc;
+	CArray<float> values;
+	CArray<int> pointers;
+};
+
+CHnswTestData::CHnswTestData( CRandom& random, int height, int width )
+{
+	values.SetSize( height * width );
+	for( int i = 0; i < values.Size(); i++ ) {
+		values[i] = random.Next() % 2 == 0 ? 0.f : static_cast<float>( random.Uniform( -1, 1 ) );
+	}
+	for( int i = 0; i <= height; i++ ) {
+		pointers.Add( i * width );
+	}
+	desc.Height = height;
+	desc.Width = width;
+	desc.Values = values.GetPtr();
+	desc.PointerB = pointers.GetPtr();
+	desc.PointerE = pointers.GetPtr() + 1;
+}
+
+static float calcTestDistance( const float* first, const float* second, int size, TDistanceFunc distanceFunc )
+{
+	double result = 0;
+	if( distanceFunc == DF_Euclid ) {
+		for( int i = 0; i < size; i++ ) {
+			result += ( first[i] - second[i] ) * ( first[i] - second[i] );
+		}
+	} else {
+		double dotProduct = 0;
+		double firstNorm = 0;
+		double secondNorm = 0;
+		for( int i = 0; i < size; i++ ) {
+			dotProduct += first[i] * second[i];
+			firstNorm += first[i] * first[i];
+			secondNorm += second[i] * second[i];
+		}
+		result = 1. - dotProduct * fabs( dotProduct ) / firstNorm / secondNorm;
+	}
+	return static_cast<float>( result );
+}
+
+// Checks the share of the exact k nearest neighbors found by the index
+static void checkRecall( const CHnswIndex& index, const CHnswTestData& data, const CHnswTestData& queries,
+	int k, int ef, double minRecall )
+{
+	const int featureCount = data.GetDesc().Width;
+	int foundCount = 0;
+	CArray<int> neighbors;
+	CArray<float> distances;
+	CArray<float> exactDistances;
+	for( int i = 0; i < queries.GetDesc().Height; i++ ) {
+		CFloatVectorDesc query;
+		queries.GetDesc().GetRow( i, query );
+		index.Search( query, k, ef, neighbors, distances );
+
+		exactDistances.DeleteAll();
+		for( int j = 0; j < data.GetDesc().Height; j++ ) {
+			exactDistances.Add( calcTestDistance( queries.GetRow( i ), data.GetRow( j ), featureCount,
+				index.GetDistanceFunc() ) );
+		}
+		exactDistances.QuickSort<Ascending<float>>();
+
+		for( int j = 0; j < k; j++ ) {
+			ASSERT_NE( NotFound, neighbors[j] );
+			EXPECT_NEAR( calcTestDistance( queries.GetRow( i ), data.GetRow( neighbors[j] ), featureCount,
+				index.GetDistanceFunc() ), distances[j], 1e-4 );
+			if( j > 0 ) {
+				EXPECT_LE( distances[j - 1], distances[j] );
+			}
+			if( distances[j] <= exactDistances[k - 1] + 1e-5 ) {
+				foundCount++;
+			}
+		}
+	}
+	EXPECT_LE( minRecall, static_cast<double>( foundCount ) / ( queries.GetDesc().Height * k ) );
+}
+
+TEST_P( CHnswIndexTest, Recall )
+{
+	CRandom random( 0x1234 );
+	CHnswTestData data( random, 3000, 24 );
+	CHnswTestData queries( random, 100, 24 );
+
+	CHnswIndex::CParams params;
+	params.DistanceFunc = GetParam();
+	params.MaxNeighbors = 12;
+	params.EfConstruction = 100;
+	CPtr<CHnswIndex> index = new CHnswIndex( params );
+	index->Build( data.GetDesc() );
+	EXPECT_EQ( 3000, index->GetVectorCount() );
+	EXPECT_EQ( 24, index->GetFeatureCount() );
+	checkRecall( *index, data, queries, 10, 64, 0.9 );
+
+	// The sparse matrix gives the same index
+	CSparseFloatMatrix sparseData( data.GetDesc() );
+	CPtr<CHnswIndex> sparseIndex = new CHnswIndex( params );
+	sparseIndex->Build( sparseData.GetDesc() );
+	CSparseFloatMatrix sparseQueries( queries.GetDesc() );
+
+	CArray<int> expectedNeighbors;
+	CArray<float> expectedDistances;
+	index->SearchBatch( queries.GetDesc(), 10, 64, expectedNeighbors, expectedDistances );
+	CArray<int> neighbors;
+	CArray<float> distances;
+	sparseIndex->SearchBatch( sparseQueries.GetDesc(), 10, 64, neighbors, distances, 4 );
+	ASSERT_EQ( expectedNeighbors.Size(), neighbors.Size() );
+	for( int i = 0; i < neighbors.Size(); i++ ) {
+		EXPECT_EQ( expectedNeighbors[i], neighbors[i] );
+		EXPECT_EQ( expectedDistances[i], distances[i] );
+	}
+
+	// The index built in parallel is different but as precise
+	params.ThreadCount = 4;
+	CPtr<CHnswIndex> parallelIndex = new CHnswIndex( params );
+	parallelIndex->Build( data.GetDesc() );
+	checkRecall( *parallelIndex, data, queries, 10, 64, 0.9 );
+}
+
+TEST_P( CHnswIndexTest, SearchBatch )
+{
+	CRandom random( 0x4321 );
+	CHnswTestData data( random, 500, 13 );
+	CHnswTestData queries( random, 37, 13 );
+
+	CHnswIndex::CParams params;
+	params.DistanceFunc = GetParam();
+	params.ThreadCount = 3;
+	CPtr<CHnswIndex> index = new CHnswIndex( params );
+	index->Build( data.GetDesc() );
+
+	CArray<int> batchNeighbors;
+	CArray<float> batchDistances;
+	index->SearchBatch( queries.GetDesc(), 5, 20, batchNeighbors, batchDistances, 4 );
+	ASSERT_EQ( queries.GetDesc().Height * 5, batchNeighbors.Size() );
+
+	CArray<int> neighbors;
+	CArray<float> distances;
+	for( int i = 0; i < queries.GetDesc().Height; i++ ) {
+		CFloatVectorDesc query;
+		queries.GetDesc().GetRow( i, query );
+		index->Search( query, 5, 20, neighbors, distances );
+		for( int j = 0; j < 5; j++ ) {
+			EXPECT_EQ( neighbors[j], batchNeighbors[i * 5 + j] );
+			EXPECT_EQ( distances[j], batchDistances[i * 5 + j] );
+		}
+	}
+
+	// Fewer vectors than requested
+	CHnswTestData smallData( random, 3, 13 );
+	index->Build( smallData.GetDesc() );
+	CFloatVectorDesc query;
+	queries.GetDesc().GetRow( 0, query );
+	index->Search( query, 5, 20, neighbors, distances );
+	for( int j = 0; j < 3; j++ ) {
+		EXPECT_NE( NotFound, neighbors[j] );
+	}
+	EXPECT_EQ( NotFound, neighbors[3] );
+	EXPECT_EQ( NotFound, neighbors[4] );
+}
+
+// Checks that the index loaded from the usual and from the memory-mapped file finds the same neighbors
+static void checkSerialization( TDistanceFunc distanceFunc, int vectorCount, int featureCount, const char* fileName )
+{
+	CRandom random( 0x5678 );
+	CHnswTestData data( random, vectorCount, featureCount );
+	CHnswTestData queries( random, 50, featureCount );
+
+	CHnswIndex::CParams params;
+	params.DistanceFunc = distanceFunc;
+	CPtr<CHnswIndex> index = new CHnswIndex( params );
+	index->Build( data.GetDesc() );
+	CArray<int> expectedNeighbors;
+	CArray<float> expectedDistances;
+	index->SearchBatch( queries.GetDesc(), 7, 30, expectedNeighbors, expectedDistances );
+
+	{
+		CArchiveFile file( fileName, CArchive::store, GetPlatformEnv() );
+		CArchive archive( &file, CArchive::SD_Storing );
+		index->Serialize( archive );
+	}
+
+	for( int isMapped = 0; isMapped < 2; isMapped++ ) {
+		CPtr<CHnswIndex> loadedIndex = new CHnswIndex();
+		CPtr<CMappedFileData> mapping;
+		if( isMapped == 0 ) {
+			CArchiveFile file( fileName, CArchive::load, GetPlatformEnv() );
+			CArchive archive( &file, CArchive::SD_Loading );
+			loadedIndex->Serialize( archive );
+		} else {
+			CMappedArchiveFile file( fileName );
+			mapping = file.GetMapping();
+			CArchive archive( &file, CArchive::SD_Loading );
+			loadedIndex->Serialize( archive );
+		}
+		if( mapping != nullptr ) {
+			// The vectors and the links are used directly from the file
+			EXPECT_LT( 1, mapping->RefCount() );
+		}
+		EXPECT_EQ( index->GetVectorCount(), loadedIndex->GetVectorCount() );
+		EXPECT_EQ( index->GetFeatureCount(), loadedIndex->GetFeatureCount() );
+		EXPECT_EQ( distanceFunc, loadedIndex->GetDistanceFunc() );
+
+		CArray<int> neighbors;
+		CArray<float> distances;
+		loadedIndex->SearchBatch( queries.GetDesc(), 7, 30, neighbors, distances, 2 );
+		ASSERT_EQ( expectedNeighbors.Size(), neighbors.Size() );
+		for( int i = 0; i < neighbors.Size(); i++ ) {
+			EXPECT_EQ( expectedNeighbors[i], neighbors[i] );
+			EXPECT_EQ( expectedDistances[i], distances[i] );
+		}
+	}
+	::remove( fileName );
+}
+
+TEST_P( CHnswIndexTest, Serialization )
+{
+	// The test instances for different distance functions may run in parallel
+	checkSerialization( GetParam(), 1000, 17,
+		GetParam() == DF_Euclid ? "hnsw_index_euclid_test.arch" : "hnsw_index_cosine_test.arch" );
+}
+
+TEST_P( CHnswIndexTest, SerializationSmall )
+{
+	// The arrays are smaller than the archive buffer, so they are skipped inside the buffer
+	checkSerialization( GetParam(), 20, 4,
+		GetParam() == DF_Euclid ? "hnsw_small_euclid_test.arch" : "hnsw_small_cosine_test.arch" );
+}
+
+INSTANTIATE_TEST_CASE_P( CHnswIndexTestInstantiation, CHnswIndexTest,
+	::testing::Values( DF_Euclid, DF_Cosine ) );
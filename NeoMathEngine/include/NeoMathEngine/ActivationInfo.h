@@ -0,0 +1,59 @@
+/* Copyright  2017-2020 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+
+namespace NeoML {
+
+// Supported activation functions
+enum TActivationFunction {
+	AF_Linear = 0,
+	AF_ELU,
+	AF_ReLU,
+	AF_LeakyReLU,
+	AF_Abs,
+	AF_Sigmoid,
+	AF_Tanh,
+	AF_HardTanh,
+	AF_HardSigmoid,
+	AF_Power,
+	AF_HSwish,
+	AF_GELU,
+
+	AF_Count
+};
+
+// The activation function together with its parameters
+// May be applied by the convolution and matrix multiplication kernels to their result before it is written
+struct CActivationInfo {
+	TActivationFunction Type;
+	// The parameters of the function:
+	// AF_Linear - the multiplier and the free term
+	// AF_ELU, AF_LeakyReLU - alpha
+	// AF_ReLU - the upper threshold (0 if there is none)
+	// AF_HardSigmoid - the slope and the bias
+	// AF_Power - the exponent
+	// AF_GELU is calculated as x * sigmoid(1.702 * x)
+	float Param1;
+	float Param2;
+
+	// The default is the identity function
+	explicit CActivationInfo( TActivationFunction type = AF_Linear, float param1 = 1.f, float param2 = 0.f ) :
+		Type( type ), Param1( param1 ), Param2( param2 ) {}
+
+	bool IsIdentity() const { return Type == AF_Linear && Param1 == 1.f && Param2 == 0.f; }
+};
+
+} // namespace NeoML
@@ -84,7 +84,7 @@ public:
 	template<typename U = T, typename std::enable_if<std::is_same<U, T>::value && !std::is_const<U>::value, int>::type = 0>
 	operator CTypedMemoryHandle<const U>() const
 	{
-		return CTypedMemoryHandle<const U>( *this );
+		return CTypedMemoryHandle<const U>( static_cast<const CMemoryHandle&>( *this ) );
 	}
 
 	CTypedMemoryHandle& operator+=( ptrdiff_t shift )
@@ -217,6 +217,10 @@ typedef CTypedMemoryHandle<const float> CConstFloatHandle;
 typedef CTypedMemoryHandle<int> CIntHandle;
 typedef CTypedMemoryHandle<const int> CConstIntHandle;
 
+// 8-bit integers are used only for the quantized data
+typedef CTypedMemoryHandle<signed char> CInt8Handle;
+typedef CTypedMemoryHandle<const signed char> CConstInt8Handle;
+
 typedef CMemoryHandleVar<float> CFloatHandleVar;
 typedef CMemoryHandleVar<int> CIntHandleVar;
 
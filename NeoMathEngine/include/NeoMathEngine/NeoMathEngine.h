@@ -21,6 +21,7 @@ limitations under the License.
 #include <NeoMathEngine/BlobDesc.h>
 #include <NeoMathEngine/SparseMatrixDesc.h>
 #include <NeoMathEngine/LookupData.h>
+#include <NeoMathEngine/ActivationInfo.h>
 #include <NeoMathEngine/OpenMP.h>
 #include <NeoMathEngine/CrtAllocatedObject.h>
 #include <NeoMathEngine/PerformanceCounters.h>
@@ -447,6 +448,13 @@ public:
 	virtual void MultiplyMatrixByTransposedMatrix(const CConstFloatHandle& firstHandle, int firstHeight,
 		int firstWidth, int firstRowSize, const CConstFloatHandle& secondHandle, int secondHeight, int secondRowSize,
 		const CFloatHandle& resultHandle, int resultRowSize, int resultBufferSize) = 0;
+	// The same as above, but then adds the free term to each row of the result and applies the activation function
+	// Both are done for each part of the result right after it is calculated
+	// You can pass 0 for the freeTermHandle parameter, and the free terms will be 0
+	virtual void MultiplyMatrixByTransposedMatrix(const CConstFloatHandle& firstHandle, int firstHeight,
+		int firstWidth, int firstRowSize, const CConstFloatHandle& secondHandle, int secondHeight, int secondRowSize,
+		const CConstFloatHandle* freeTermHandle, const CActivationInfo& activation,
+		const CFloatHandle& resultHandle, int resultRowSize, int resultBufferSize) = 0;
 	// Multiplies matrices from two batches, stored one after another in firstHandle, secondHandle parameters
 	virtual void MultiplyMatrixByTransposedMatrix(int batchSize, const CConstFloatHandle& firstHandle, int firstHeight,
 		int firstWidth, const CConstFloatHandle& secondHandle, int secondHeight, const CFloatHandle& resultHandle,
@@ -515,12 +523,33 @@ public:
 	virtual void MatrixSpreadRows( const CConstIntHandle& sourceHandle, int height, int width,
 		const CIntHandle& resultHandle, int resultHeight, const CConstIntHandle& indexHandle,
 		const CConstIntHandle& fillValue ) = 0;
+
+	// 8-bit quantized matrix multiplication (inference only)
+	// Quantizes each row of the matrix into signed 8-bit values: quantized = round( value / scale ),
+	// where scale = max( abs( row ) ) / 127 is written into rowScalesHandle (one value per row)
+	virtual void QuantizeMatrixRows( const CConstFloatHandle& matrixHandle, int height, int width,
+		const CInt8Handle& quantizedHandle, const CFloatHandle& rowScalesHandle ) = 0;
+	// result = activation( first * dequantize( second )^T + freeTerm )
+	// The first matrix is quantized on the fly into unsigned 8-bit values:
+	// q = clamp( round( value / firstScale ) + firstZeroPoint, 0, 255 )
+	// The second matrix of secondHeight * firstWidth size should be quantized by QuantizeMatrixRows
+	// You can pass 0 for the freeTermHandle parameter, and the free terms will be 0
+	virtual void MultiplyMatrixByTransposedQuantizedMatrix( const CConstFloatHandle& firstHandle, int firstHeight,
+		int firstWidth, float firstScale, int firstZeroPoint, const CConstInt8Handle& secondHandle,
+		const CConstFloatHandle& secondScalesHandle, int secondHeight, const CConstFloatHandle* freeTermHandle,
+		const CActivationInfo& activation, const CFloatHandle& resultHandle ) = 0;
 };
 
 // Blob operations descriptors
 struct NEOMATHENGINE_API CTimeConvolutionDesc : public CCrtAllocatedObject { public: virtual ~CTimeConvolutionDesc(); };
 struct NEOMATHENGINE_API C3dConvolutionDesc : public CCrtAllocatedObject { public: virtual ~C3dConvolutionDesc(); };
-struct NEOMATHENGINE_API CConvolutionDesc : public CCrtAllocatedObject { public: virtual ~CConvolutionDesc(); };
+// The convolution descriptor may keep data calculated from the filter (e.g. the Winograd-transformed filter)
+// ResetFilterCache must be called after the filter values are changed so that the data is recalculated on the next use
+struct NEOMATHENGINE_API CConvolutionDesc : public CCrtAllocatedObject {
+public:
+	virtual ~CConvolutionDesc();
+	virtual void ResetFilterCache() {}
+};
 struct NEOMATHENGINE_API CChannelwiseConvolutionDesc : public CCrtAllocatedObject { public: virtual ~CChannelwiseConvolutionDesc(); };
 struct NEOMATHENGINE_API CRleConvolutionDesc : public CCrtAllocatedObject { public: virtual ~CRleConvolutionDesc(); };
 struct NEOMATHENGINE_API CDropoutDesc : public CCrtAllocatedObject { public: virtual ~CDropoutDesc(); };
@@ -556,6 +585,34 @@ struct CRleImage {
 	CRleStroke Lines[1];
 };
 
+//------------------------------------------------------------------------------------------------------------
+// Optimizer steps
+
+// The parameters of the fused Adam step (see IDnnEngine::AdamStep)
+struct CAdamStepParams {
+	// The learning rate
+	float Rate;
+	// The decay rates of the moving means of the gradient and the squared gradient
+	float MomentDecayRate;
+	float SecondMomentDecayRate;
+	// Added to the square root of the second moment to avoid division by zero
+	float Epsilon;
+	// The regularization added to the gradient: L2 * param + clamp( param, -L1, L1 )
+	float L1Regularization;
+	float L2Regularization;
+	// The update is ( GradientMult * gradient + MomentMult * moment ) / ( sqrt( SecondMomentMult * secondMoment ) + Epsilon )
+	// Plain Adam uses 0, 1, 1; the Nesterov variant uses its bias-corrected coefficients
+	float GradientMult;
+	float MomentMult;
+	float SecondMomentMult;
+
+	CAdamStepParams() :
+		Rate( 0.f ), MomentDecayRate( 0.9f ), SecondMomentDecayRate( 0.999f ), Epsilon( 1e-6f ),
+		L1Regularization( 0.f ), L2Regularization( 0.f ), GradientMult( 0.f ), MomentMult( 1.f ), SecondMomentMult( 1.f )
+	{
+	}
+};
+
 //------------------------------------------------------------------------------------------------------------
 
 // Neural network-specific operations
@@ -616,13 +673,26 @@ public:
 		int strideHeight, int strideWidth, int dilationHeight, int dilationWidth, const CBlobDesc& filter,
 		const CBlobDesc& output ) = 0;
 
+	// The data calculated from the filter may be cached in the descriptor (see CConvolutionDesc::ResetFilterCache)
 	virtual void BlobConvolution( const CConvolutionDesc& desc, const CFloatHandle& source,
 		const CFloatHandle& filter, const CFloatHandle* freeTerm, const CFloatHandle& result ) = 0;
+	// The same as above, but the activation function is applied to each part of the result right after it is calculated
+	virtual void BlobConvolution( const CConvolutionDesc& desc, const CFloatHandle& source,
+		const CFloatHandle& filter, const CFloatHandle* freeTerm, const CActivationInfo& activation,
+		const CFloatHandle& result ) = 0;
 	virtual void BlobConvolutionBackward( const CConvolutionDesc& desc, const CFloatHandle& outputDiff,
 		const CFloatHandle& filter, const CFloatHandle* freeTerm, const CFloatHandle& inputDiff ) = 0;
 	virtual void BlobConvolutionLearnAdd( const CConvolutionDesc& desc, const CFloatHandle& input,
 		const CFloatHandle& outputDiff, const CFloatHandle& filterDiff,
 		const CFloatHandle* freeTermDiff, bool isFreeTermDiffFromInput ) = 0;
+	// 8-bit quantized convolution (inference only)
+	// The source is quantized on the fly in the same way as in MultiplyMatrixByTransposedQuantizedMatrix
+	// The filter should be quantized by QuantizeMatrixRows with one scale per filter
+	// You can pass 0 for the freeTerm parameter, and the free terms will be 0
+	// The activation function is applied to the result in the same way as in BlobConvolution
+	virtual void BlobQuantizedConvolution( const CConvolutionDesc& desc, const CConstFloatHandle& source,
+		float sourceScale, int sourceZeroPoint, const CConstInt8Handle& filter, const CConstFloatHandle& filterScales,
+		const CConstFloatHandle* freeTerm, const CActivationInfo& activation, const CFloatHandle& result ) = 0;
 
 	// Calculates channelwise convolution
 	// You can pass 0 for the freeTerm parameter, and the free terms will be 0
@@ -847,6 +917,74 @@ public:
 	virtual void IndRnnRecurrentLearn( bool reverse, int sequenceLength, int batchSize, int objectSize,
 		const CConstFloatHandle& mask, const CConstFloatHandle& u, const CConstFloatHandle& h, const CConstFloatHandle& hDiff,
 		const CFloatHandle& uDiff ) = 0;
+
+	// Fused LSTM and GRU recurrences (inference only)
+	// The input projections (x * W^T + free terms) should be calculated for the whole sequence in advance,
+	// then the recurrent part is calculated step by step
+	// All the sequences are stored as sequenceLength x batchSize x size
+	// The initial output and state are optional (may be null, which means zero)
+
+	// LSTM; the gates are stored in [main, forget, input, reset] order, hiddenSize elements each
+	//    gates = inputGates_t + h_(t-1) * recurWeights^T
+	//    c_t = sigmoid(input) * tanh(main) + sigmoid(forget) * c_(t-1)
+	//    h_t = sigmoid(reset) * tanh(c_t)
+	// inputGates: sequenceLength x batchSize x (4 * hiddenSize)
+	// recurWeights: (4 * hiddenSize) x hiddenSize
+	// initialOutput, initialState: batchSize x hiddenSize
+	// output (h), state (c): sequenceLength x batchSize x hiddenSize
+	virtual void LstmRecurrent( bool reverse, int sequenceLength, int batchSize, int hiddenSize,
+		const CConstFloatHandle& inputGates, const CConstFloatHandle& recurWeights,
+		const CConstFloatHandle& initialOutput, const CConstFloatHandle& initialState,
+		const CFloatHandle& output, const CFloatHandle& state ) = 0;
+	// GRU; the gates are stored in [update, reset] order, hiddenSize elements each
+	//    gates = sigmoid( inputGates_t + h_(t-1) * gateWeights^T )
+	//    main = tanh( inputMain_t + ( reset * h_(t-1) ) * mainWeights^T )
+	//    h_t = ( 1 - update ) * main + update * h_(t-1)
+	// inputGates: sequenceLength x batchSize x (2 * hiddenSize)
+	// inputMain: sequenceLength x batchSize x hiddenSize
+	// gateWeights: (2 * hiddenSize) x hiddenSize, mainWeights: hiddenSize x hiddenSize;
+	// weightsRowSize is the distance between the rows of both weight matrices
+	// initialOutput: batchSize x hiddenSize
+	// output (h): sequenceLength x batchSize x hiddenSize
+	virtual void GruRecurrent( bool reverse, int sequenceLength, int batchSize, int hiddenSize,
+		const CConstFloatHandle& inputGates, const CConstFloatHandle& inputMain,
+		const CConstFloatHandle& gateWeights, const CConstFloatHandle& mainWeights, int weightsRowSize,
+		const CConstFloatHandle& initialOutput, const CFloatHandle& output ) = 0;
+
+	// Multihead scaled dot-product attention (inference only)
+	//    result = softmax( scale * Q * K^T + mask ) * V for each object and head
+	// The keys are processed by blocks with the online softmax normalization,
+	// so the full queryLength x keyLength score matrix is never stored
+	// query: batchSize x queryLength x headCount x headSize
+	// key, value: batchSize x keyLength x headCount x headSize
+	// mask (optional, may be null): queryLength x keyLength, added to the scores of every object and head
+	// result: batchSize x queryLength x headCount x headSize
+	virtual void ScaledDotProductAttention( int batchSize, int headCount, int queryLength, int keyLength,
+		int headSize, float scale, const CConstFloatHandle& query, const CConstFloatHandle& key,
+		const CConstFloatHandle& value, const CConstFloatHandle& mask, const CFloatHandle& result ) = 0;
+
+	// Fused optimizer steps: the parameters and the gradient history are read and written only once
+
+	// Adam step (also used for the Nesterov variant and AMSGrad):
+	//    g = paramDiff + L2 * param + clamp( param, -L1, L1 )
+	//    moment = MomentDecayRate * moment + ( 1 - MomentDecayRate ) * g
+	//    secondMoment = SecondMomentDecayRate * secondMoment + ( 1 - SecondMomentDecayRate ) * g * g
+	//    secondMomentMax = max( secondMomentMax, secondMoment )
+	//    param -= Rate * ( GradientMult * g + MomentMult * moment )
+	//        / ( sqrt( SecondMomentMult * secondMomentMax ) + Epsilon )
+	// secondMomentMax is optional (may be null), if it is not set secondMoment is used instead
+	virtual void AdamStep( const CAdamStepParams& params, int dataSize, const CConstFloatHandle& paramDiff,
+		const CFloatHandle& param, const CFloatHandle& moment, const CFloatHandle& secondMoment,
+		const CFloatHandle& secondMomentMax ) = 0;
+	// LAMB update; the parameters are not changed because the trust ratio depends on the norm of the update:
+	//    g = gradientMult * paramDiff
+	//    moment and secondMoment are updated as in AdamStep
+	//    update = moment / ( sqrt( secondMoment ) + epsilon ) + weightDecay * param
+	// squaredNorms (3 elements) are set to the squared L2-norms of g, param and update
+	virtual void LambUpdate( int dataSize, float gradientMult, float momentDecayRate, float secondMomentDecayRate,
+		float epsilon, float weightDecay, const CConstFloatHandle& paramDiff, const CConstFloatHandle& param,
+		const CFloatHandle& moment, const CFloatHandle& secondMoment, const CFloatHandle& update,
+		const CFloatHandle& squaredNorms ) = 0;
 };
 
 //------------------------------------------------------------------------------------------------------------
@@ -933,6 +1071,11 @@ public:
 	// Creates a handle with data from another math engine
 	virtual CMemoryHandle CopyFrom( const CMemoryHandle& handle, size_t size ) = 0;
 
+	// Creates a handle that points to the host memory not allocated by the math engine (for example, a memory-mapped file)
+	// The memory should stay valid while the handle is used; the handle may not be passed to HeapFree
+	// Returns a null handle if the math engine can't work with the host memory directly (only the CPU math engine can)
+	virtual CMemoryHandle GetExternalMemoryHandle( const void* data ) = 0;
+
 	// Creates a object for aggregating statistics.
 	// This object should be destroyed using the standard delete operator after use.
 	virtual IPerformanceCounters* CreatePerformanceCounters() const = 0;
@@ -940,12 +1083,19 @@ public:
 
 //------------------------------------------------------------------------------------------------------------
 
+// Cpu math engine flags
+
+// Round the matrices to bfloat16 in the matrix multiplications (and so in the fully connected and convolution layers)
+// The products are accumulated in float and the results are float, so all the blobs are still float
+// Faster but less precise; works only if the CPU supports avx512_bf16, otherwise the flag is ignored
+const int CpuMathEngineBf16MatrixMultiplicationFlag = 0x1;
+
 // Creates a math engine that uses a CPU for calculations
 // You should call SetMathEngineExceptionHandler() before this call
 // threadCount is the number of threads that may be used;
 // the default value is 0, which means as many threads as the CPU has cores
 // This math engine should be destroyed using the standard delete operator after use
-NEOMATHENGINE_API IMathEngine* CreateCpuMathEngine( int threadCount, size_t memoryLimit );
+NEOMATHENGINE_API IMathEngine* CreateCpuMathEngine( int threadCount, size_t memoryLimit, int flags = 0 );
 
 // Destroys all global data that is shared between CPU math engines
 // Should be called only if there are no running CpuMathEngine instances
@@ -20,6 +20,7 @@ limitations under the License.
 #endif
 
 #include <cstdint>
+#include <NeoMathEngine/ThreadPool.h>
 
 #ifdef NEOML_USE_OMP
 	#if defined( _MSC_VER ) 
@@ -64,8 +65,14 @@ inline int OmpGetMaxThreadCount()
 }
 
 // Returns the current number of threads in the OMP pool
+// Inside a thread pool task returns the number of tasks in the calculation (see IThreadPool)
 inline int OmpGetThreadCount()
 {
+	int threadNum = 0;
+	int threadCount = 0;
+	if( GetThreadPoolTaskInfo( threadNum, threadCount ) ) {
+		return threadCount;
+	}
 #ifdef NEOML_USE_OMP
 	return omp_get_num_threads();
 #else
@@ -74,8 +81,14 @@ inline int OmpGetThreadCount()
 }
 
 // Returns the current thread number
+// Inside a thread pool task returns the number of the task (see IThreadPool)
 inline int OmpGetThreadNum()
 {
+	int threadNum = 0;
+	int threadCount = 0;
+	if( GetThreadPoolTaskInfo( threadNum, threadCount ) ) {
+		return threadNum;
+	}
 #ifdef NEOML_USE_OMP
 	return omp_get_thread_num();
 #else
@@ -37,8 +37,9 @@ public:
 		int strideHeight, int strideWidth, int dilationHeight, int dilationWidth, const CBlobDesc& filter,
 		const CBlobDesc& result ) const = 0;
 
+	// The activation function is applied to each part of the result right after it is calculated
 	virtual void BlobConvolution( const CConvolutionDesc& convDesc, const float* source,
-		const float* filter, const float* freeTerm, float* result ) const = 0;
+		const float* filter, const float* freeTerm, const CActivationInfo& activation, float* result ) const = 0;
 
 	virtual SgemmFunc GetSgemmFunction() const = 0;
 };
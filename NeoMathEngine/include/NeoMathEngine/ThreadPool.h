@@ -0,0 +1,77 @@
+/* Copyright © 2017-2021 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <NeoMathEngine/NeoMathEngineDefs.h>
+#include <NeoMathEngine/CrtAllocatedObject.h>
+#include <atomic>
+
+namespace NeoML {
+
+// IThreadPool is the pool of threads that runs the parallel calculations of the CPU math engine
+// Each math engine owns its pool, so the engines used in one process do not compete for a global pool
+// The tasks are put into the queues of the threads; an idle thread takes the tasks from the queues of the others
+class NEOMATHENGINE_API IThreadPool : public CCrtAllocatedObject {
+public:
+	// The task to be run; threadNum is the number of the task in [0, threadCount)
+	typedef void ( *TTask )( int threadNum, void* params );
+
+	virtual ~IThreadPool();
+
+	// The number of threads that may run the calculations at the same time (the calling thread included)
+	virtual int Size() const = 0;
+
+	// Calls task( threadNum, params ) for each threadNum in [0, threadCount) and waits until all calls are finished
+	// The calling thread takes part in the calculation
+	// While a call is running, OmpGetThreadNum() and OmpGetThreadCount() return threadNum and threadCount
+	// If called from inside another task the calls are performed one after another on the current thread
+	// The first exception thrown by the task is rethrown on the calling thread
+	virtual void RunParallel( int threadCount, TTask task, void* params ) = 0;
+};
+
+// Creates a thread pool with the specified number of threads (the calling thread included)
+NEOMATHENGINE_API IThreadPool* CreateThreadPool( int threadCount );
+
+// Retrieves the number of the task currently run by this thread and the number of tasks in its parallel calculation
+// Returns false if the thread is not running a thread pool task
+NEOMATHENGINE_API bool GetThreadPoolTaskInfo( int& threadNum, int& threadCount );
+
+//------------------------------------------------------------------------------------------------------------
+
+// Calls func() on threadCount threads of the pool
+// Use OmpGetThreadNum() and OmpGetTaskIndexAndCount() inside to split the work
+template<class TFunc>
+inline void ParallelRun( IThreadPool& threadPool, int threadCount, const TFunc& func )
+{
+	threadPool.RunParallel( threadCount,
+		[]( int, void* params ) { ( *static_cast<const TFunc*>( params ) )(); },
+		const_cast<TFunc*>( &func ) );
+}
+
+// Calls func( index ) for each index in [0, count) using threadCount threads of the pool
+// The indices are given out one by one, so the threads that are done earlier take the remaining ones
+template<class TFunc>
+inline void ParallelFor( IThreadPool& threadPool, int threadCount, int count, const TFunc& func )
+{
+	std::atomic<int> next( 0 );
+	ParallelRun( threadPool, threadCount < count ? threadCount : count, [&]() {
+		for( int index = next++; index < count; index = next++ ) {
+			func( index );
+		}
+	} );
+}
+
+} // namespace NeoML
@@ -170,6 +170,33 @@ struct CCPUInfo {
 		return AnyAvx512IsAvailable;
 	}
 
+	static bool IsAvx512Bf16Available()
+	{
+		Regs regs;
+		callCpuIdEx( regs, 7, 0 );
+
+		// avx512_f and avx512_bw bits in EBX
+		const unsigned int Avx512FAndBwBits = ( 1 << 16 ) + ( 1u << 30 );
+		if( ( static_cast<unsigned int>( regs.ebx ) & Avx512FAndBwBits ) != Avx512FAndBwBits ) {
+			return false;
+		}
+
+		// avx512_bf16 bit in EAX of the subleaf 1
+		callCpuIdEx( regs, 7, 1 );
+		if( ( regs.eax & ( 1 << 5 ) ) == 0 ) {
+			return false;
+		}
+
+		// The OS must save the opmask and the ZMM registers, otherwise the instructions raise #UD
+		// Check the osxsave bit in ECX and then the XMM, YMM, opmask, ZMM_Hi256 and Hi16_ZMM bits in XCR0
+		callCpuId( regs, 1 );
+		if( ( regs.ecx & ( 1 << 27 ) ) == 0 ) {
+			return false;
+		}
+		const unsigned long long Avx512StateBits = 0xE6;
+		return ( callXgetbv() & Avx512StateBits ) == Avx512StateBits;
+	}
+
 private:
 
 #if FINE_PLATFORM(FINE_WINDOWS)
@@ -216,4 +243,23 @@ private:
 #endif // !FINE_ARCHITECTURE( FINE_ARM64 )
 	}
 
+	// Reads XCR0, the register of the processor state components enabled by the OS
+	// Should be called only if the osxsave bit is set
+	static unsigned long long callXgetbv() {
+#if !FINE_ARCHITECTURE( FINE_ARM64 ) && !FINE_ARCHITECTURE( FINE_ARM )
+#if FINE_PLATFORM( FINE_WINDOWS )
+		return _xgetbv( 0 );
+#elif FINE_PLATFORM( FINE_LINUX ) || FINE_PLATFORM( FINE_DARWIN )
+		unsigned int eax = 0;
+		unsigned int edx = 0;
+		__asm__ __volatile__( "xgetbv" : "=a"( eax ), "=d"( edx ) : "c"( 0 ) );
+		return ( static_cast<unsigned long long>( edx ) << 32 ) | eax;
+#else
+		return 0;
+#endif
+#else
+		return 0;
+#endif // !FINE_ARCHITECTURE( FINE_ARM64 )
+	}
+
 };
@@ -24,6 +24,9 @@ limitations under the License.
 #include <NeoMathEngine/SimdMathEngine.h>
 #include <DllLoader.h>
 #include <CPUInfo.h>
+#ifdef NEOML_USE_SSE
+#include <CpuX86Bf16MatrixMultiplying.h>
+#endif
 
 #if FINE_PLATFORM( FINE_ANDROID ) || FINE_PLATFORM( FINE_LINUX )
 #include <PerformanceCountersCpuLinux.h>
@@ -48,8 +51,9 @@ namespace NeoML {
 static int FloatAlignment = CCPUInfo::DefineFloatAlignment();
 static CCPUInfo::TCpuArch CPUArch = CCPUInfo::GetCpuArch();
 
-CCpuMathEngine::CCpuMathEngine( int _threadCount, size_t _memoryLimit ) :
+CCpuMathEngine::CCpuMathEngine( int _threadCount, size_t _memoryLimit, int flags ) :
 	threadCount( _threadCount <= 0 ? OmpGetMaxThreadCount() : _threadCount ),
+	threadPool( CreateThreadPool( threadCount ) ),
 	floatAlignment( FloatAlignment ),
 	memoryAlignment( floatAlignment * sizeof(float) ),
 	memoryPool( new CMemoryPool( _memoryLimit == 0 ? SIZE_MAX : _memoryLimit, this, false ) ),
@@ -60,7 +64,7 @@ CCpuMathEngine::CCpuMathEngine( int _threadCount, size_t _memoryLimit ) :
 {
 #ifdef NEOML_USE_AVX
 	if( dllLoader.IsLoaded( CDllLoader::AVX_DLL ) ) {
-		simdMathEngine = unique_ptr<ISimdMathEngine>( CDllLoader::avxDll->CreateSimdMathEngine( this, threadCount ) );
+		simdMathEngine = unique_ptr<ISimdMathEngine>( CDllLoader::avxDll->CreateSimdMathEngine( this, threadPool.get() ) );
 		// Don't use custom sgemm function when we are compiled with MKL and when we are on Intel CPU.
 		if( CPUArch == CCPUInfo::TCpuArch::Intel ) {
 #ifndef NEOML_USE_MKL
@@ -72,6 +76,13 @@ CCpuMathEngine::CCpuMathEngine( int _threadCount, size_t _memoryLimit ) :
 		}
 	}
 #endif
+#ifdef NEOML_USE_BF16_GEMM
+	if( ( flags & CpuMathEngineBf16MatrixMultiplicationFlag ) != 0 && CCPUInfo::IsAvx512Bf16Available() ) {
+		customSgemmFunction = Bf16MultiplyMatrix;
+	}
+#else
+	( void ) flags;
+#endif
 }
 
 CCpuMathEngine::~CCpuMathEngine()
@@ -143,10 +154,9 @@ void CCpuMathEngine::CleanUp()
 	stackAllocator->CleanUp();
 	memoryPool->CleanUp();
 #ifdef NEOML_USE_MKL
-	NEOML_OMP_NUM_THREADS( threadCount )
-	{
+	ParallelRun( *threadPool, threadCount, [] {
 		mkl_thread_free_buffers();
-	}
+	} );
 #endif
 }
 
@@ -185,6 +195,12 @@ CMemoryHandle CCpuMathEngine::CopyFrom( const CMemoryHandle& handle, size_t size
 	return result;
 }
 
+CMemoryHandle CCpuMathEngine::GetExternalMemoryHandle( const void* data )
+{
+	ASSERT_EXPR( data != 0 );
+	return CMemoryHandleInternal::CreateMemoryHandle( this, data );
+}
+
 CMemoryHandle CCpuMathEngine::Alloc( size_t size )
 {
 	// Ensure the correct alignment
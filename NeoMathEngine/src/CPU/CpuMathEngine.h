@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <NeoMathEngine/NeoMathEngine.h>
 #include <NeoMathEngine/SimdMathEngine.h>
+#include <NeoMathEngine/ThreadPool.h>
 #include <RawMemoryManager.h>
 #include <DllLoader.h>
 #include <mutex>
@@ -35,7 +36,7 @@ class ISimdMathEngine;
 // Math engine that uses a CPU for calculations
 class CCpuMathEngine : public IMathEngine, public IRawMemoryManager {
 public:
-	CCpuMathEngine( int threadCount, size_t memoryLimit );
+	CCpuMathEngine( int threadCount, size_t memoryLimit, int flags = 0 );
 	~CCpuMathEngine() override;
 
 	// IMathEngine interface methods
@@ -54,6 +55,7 @@ public:
 	void DataExchangeRaw( const CMemoryHandle& handle, const void* data, size_t size ) override;
 	void DataExchangeRaw( void* data, const CMemoryHandle& handle, size_t size ) override;
 	CMemoryHandle CopyFrom( const CMemoryHandle& handle, size_t size ) override;
+	CMemoryHandle GetExternalMemoryHandle( const void* data ) override;
 	void GetMathEngineInfo( CMathEngineInfo& info ) const override;
 
 	// IVectorMathEngine interface methods
@@ -304,6 +306,10 @@ public:
 	void MultiplyMatrixByTransposedMatrix(const CConstFloatHandle& firstHandle, int firstHeight,
 		int firstWidth, int firstRowSize, const CConstFloatHandle& secondHandle, int secondHeight, int secondRowSize,
 		const CFloatHandle& resultHandle, int resultRowSize, int resultBufferSize) override;
+	void MultiplyMatrixByTransposedMatrix(const CConstFloatHandle& firstHandle, int firstHeight,
+		int firstWidth, int firstRowSize, const CConstFloatHandle& secondHandle, int secondHeight, int secondRowSize,
+		const CConstFloatHandle* freeTermHandle, const CActivationInfo& activation,
+		const CFloatHandle& resultHandle, int resultRowSize, int resultBufferSize) override;
 	void MultiplyMatrixByTransposedMatrix(int batchSize, const CConstFloatHandle& firstHandle, int firstHeight, int firstWidth,
 		const CConstFloatHandle& secondHandle, int secondHeight, const CFloatHandle& resultHandle, int resultBufferSize) override;
 	void MultiplySparseMatrixByTransposedMatrix( int firstHeight, int firstWidth, int secondHeight,
@@ -342,6 +348,12 @@ public:
 	void MatrixSpreadRows(const CConstIntHandle& sourceHandle, int height, int width,
 		const CIntHandle& resultHandle, int resultHeight, const CConstIntHandle& indexHandle,
 		const CConstIntHandle& fillValue) override;
+	void QuantizeMatrixRows( const CConstFloatHandle& matrixHandle, int height, int width,
+		const CInt8Handle& quantizedHandle, const CFloatHandle& rowScalesHandle ) override;
+	void MultiplyMatrixByTransposedQuantizedMatrix( const CConstFloatHandle& firstHandle, int firstHeight,
+		int firstWidth, float firstScale, int firstZeroPoint, const CConstInt8Handle& secondHandle,
+		const CConstFloatHandle& secondScalesHandle, int secondHeight, const CConstFloatHandle* freeTermHandle,
+		const CActivationInfo& activation, const CFloatHandle& resultHandle ) override;
 
 	// IDnnEngine interface methods
 	void BlobMergeByDim(TBlobDim dim, const CBlobDesc* from, const CFloatHandle* fromData, int fromCount,
@@ -379,11 +391,17 @@ public:
 	void BlobConvolution( const CConvolutionDesc& desc,
 		const CFloatHandle& source, const CFloatHandle& filter, const CFloatHandle* freeTerm,
 		const CFloatHandle& result ) override;
+	void BlobConvolution( const CConvolutionDesc& desc,
+		const CFloatHandle& source, const CFloatHandle& filter, const CFloatHandle* freeTerm,
+		const CActivationInfo& activation, const CFloatHandle& result ) override;
 	void BlobConvolutionBackward( const CConvolutionDesc& desc, const CFloatHandle& outputDiff,
 		const CFloatHandle& filter, const CFloatHandle* freeTerm, const CFloatHandle& inputDiff ) override;
 	void BlobConvolutionLearnAdd( const CConvolutionDesc& desc,
 	 const CFloatHandle& input, const CFloatHandle& outputDiff, const CFloatHandle& filterDiff,
 		const CFloatHandle* freeTermDiff, bool isFreeTermDiffFromInput ) override;
+	void BlobQuantizedConvolution( const CConvolutionDesc& desc, const CConstFloatHandle& source,
+		float sourceScale, int sourceZeroPoint, const CConstInt8Handle& filter, const CConstFloatHandle& filterScales,
+		const CConstFloatHandle* freeTerm, const CActivationInfo& activation, const CFloatHandle& result ) override;
 	CChannelwiseConvolutionDesc* InitBlobChannelwiseConvolution( const CBlobDesc& input,
 		int paddingHeight, int paddingWidth, int strideHeight, int strideWidth,
 		const CBlobDesc& filter, const CBlobDesc* freeTerm, const CBlobDesc& output ) override;
@@ -491,6 +509,24 @@ public:
 	void IndRnnRecurrentLearn( bool reverse, int sequenceLength, int batchSize, int objectSize,
 		const CConstFloatHandle& mask, const CConstFloatHandle& u, const CConstFloatHandle& h, const CConstFloatHandle& hDiff,
 		const CFloatHandle& uDiff ) override;
+	void LstmRecurrent( bool reverse, int sequenceLength, int batchSize, int hiddenSize,
+		const CConstFloatHandle& inputGates, const CConstFloatHandle& recurWeights,
+		const CConstFloatHandle& initialOutput, const CConstFloatHandle& initialState,
+		const CFloatHandle& output, const CFloatHandle& state ) override;
+	void GruRecurrent( bool reverse, int sequenceLength, int batchSize, int hiddenSize,
+		const CConstFloatHandle& inputGates, const CConstFloatHandle& inputMain,
+		const CConstFloatHandle& gateWeights, const CConstFloatHandle& mainWeights, int weightsRowSize,
+		const CConstFloatHandle& initialOutput, const CFloatHandle& output ) override;
+	void ScaledDotProductAttention( int batchSize, int headCount, int queryLength, int keyLength,
+		int headSize, float scale, const CConstFloatHandle& query, const CConstFloatHandle& key,
+		const CConstFloatHandle& value, const CConstFloatHandle& mask, const CFloatHandle& result ) override;
+	void AdamStep( const CAdamStepParams& params, int dataSize, const CConstFloatHandle& paramDiff,
+		const CFloatHandle& param, const CFloatHandle& moment, const CFloatHandle& secondMoment,
+		const CFloatHandle& secondMomentMax ) override;
+	void LambUpdate( int dataSize, float gradientMult, float momentDecayRate, float secondMomentDecayRate,
+		float epsilon, float weightDecay, const CConstFloatHandle& paramDiff, const CConstFloatHandle& param,
+		const CFloatHandle& moment, const CFloatHandle& secondMoment, const CFloatHandle& update,
+		const CFloatHandle& squaredNorms ) override;
 
 	IPerformanceCounters* CreatePerformanceCounters() const override;
 
@@ -500,7 +536,8 @@ protected:
 	void Free( const CMemoryHandle& handle ) override;
 
 private:
-	const int threadCount; // the number of threads for OMP
+	const int threadCount; // the number of threads for parallel calculations
+	const std::unique_ptr<IThreadPool> threadPool; // the threads for parallel calculations
 	const int floatAlignment; // float alignment
 	const int memoryAlignment; // allocation alignment
 	const std::unique_ptr<CMemoryPool> memoryPool; // the memory manager
@@ -515,7 +552,8 @@ private:
 
 	void blob3dConvolution1x1x1( const CBlobDesc& source, const CBlobDesc& filter, const CBlobDesc& result,
 		int strideHeight, int strideWidth, int strideDepth,
-		const float* sourceData, const float* filterData, const float* freeTermData, float* resultData );
+		const float* sourceData, const float* filterData, const float* freeTermData,
+		const CActivationInfo& activation, float* resultData );
 	void blob3dConvolution1x1x1Backward( const CCommon3dConvolutionDesc& desc, const float* outputDiffData,
 		const float* filterData, const CFloatHandle* freeTermData, float* inputDiffData );
 	void blob3dConvolution1x1x1LearnAdd( const CCommon3dConvolutionDesc& desc, const CFloatHandle& inputData,
@@ -559,6 +597,10 @@ private:
 		int firstWidth, const CConstFloatHandle& secondHandle, int secondHeight, const CFloatHandle& resultHandle );
 	void multiplyMatrixByTransposedMatrixAndAdd( const float* first, int firstHeight, int firstWidth, int firstRowSize,
 		const float* second, int secondHeight, int secondRowSize, float* result, int resultRowSize );
+	void quantizeWithZeroPoint( const float* data, int size, float scale, int zeroPoint, short* result );
+	void multiplyMatrixByTransposedQuantizedMatrix( const short* first, int firstHeight, int firstWidth,
+		float firstScale, const signed char* second, const float* secondScales, int secondHeight,
+		float* result, int resultRowSize );
 
 	template<class T>
 	void blobMergeByDimCommon( int dimNum, const CBlobDesc* from, const CTypedMemoryHandle<T>* fromData, int fromCount,
@@ -590,9 +632,12 @@ private:
 		int batch, int resultStart, int resultCount, float* result );
 	void fillTempData( const float* sourceData, float* filterData, const CCpuConvolutionDesc& desc, int start, int count );
 	void blobConvolutionForwardAlgo0( const CCpuConvolutionDesc& desc, const float* sourceData,
-		const float* filterData, const CFloatHandle* freeTermData, float* resultData );
+		const float* filterData, const CFloatHandle* freeTermData, const CActivationInfo& activation, float* resultData );
 	void blobConvolutionForwardAlgo1( const CCpuConvolutionDesc& desc, const float* sourceData,
-		const float* filterData, const CFloatHandle* freeTermData, float* resultData );
+		const float* filterData, const CFloatHandle* freeTermData, const CActivationInfo& activation, float* resultData );
+	void updateWinogradFilter( const CCpuConvolutionDesc& desc, const float* filterData );
+	void blobConvolutionForwardWinograd( const CCpuConvolutionDesc& desc, const float* sourceData,
+		const float* filterData, const float* freeTermData, const CActivationInfo& activation, float* resultData );
 	void backwardConvolutionAddFilterToOutput( const CCpuConvolutionDesc& desc, const CFloatHandle& temp,
 		const CFloatHandle* freeTerm, const CFloatHandle& output );
 	void backwardDilationConvolutionAddFilterToOutput( const CCpuConvolutionDesc& desc, const CFloatHandle& temp,
@@ -0,0 +1,128 @@
+/* Copyright © 2017-2020 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+// The activation functions applied by the CPU kernels to their result (see CActivationInfo)
+// These functions only use raw pointers and do not contain any omp sections inside,
+// so they may be called by the parallel tasks of the kernels for the part of the result they have just calculated
+
+#pragma once
+
+#include <NeoMathEngine/ActivationInfo.h>
+#include <algorithm>
+#include <cmath>
+
+namespace NeoML {
+
+// Exponent with limitations to avoid overflow
+inline float activationExp( float value )
+{
+	return value < -87.33654474f ? 0.f : expf( std::min( value, 88.f ) );
+}
+
+// Applies the activation function to the data in place
+inline void applyActivation( const CActivationInfo& activation, float* data, int dataSize )
+{
+	static_assert( AF_Count == 12, "AF_Count != 12" );
+	const float param1 = activation.Param1;
+	const float param2 = activation.Param2;
+	switch( activation.Type ) {
+		case AF_Linear:
+			if( !activation.IsIdentity() ) {
+				for( int i = 0; i < dataSize; ++i ) {
+					data[i] = data[i] * param1 + param2;
+				}
+			}
+			break;
+		case AF_ELU:
+			for( int i = 0; i < dataSize; ++i ) {
+				data[i] = data[i] >= 0 ? data[i] : param1 * ( activationExp( data[i] ) - 1.f );
+			}
+			break;
+		case AF_ReLU:
+			if( param1 > 0 ) {
+				for( int i = 0; i < dataSize; ++i ) {
+					data[i] = std::min( std::max( data[i], 0.f ), param1 );
+				}
+			} else {
+				for( int i = 0; i < dataSize; ++i ) {
+					data[i] = std::max( data[i], 0.f );
+				}
+			}
+			break;
+		case AF_LeakyReLU:
+			for( int i = 0; i < dataSize; ++i ) {
+				data[i] = data[i] > 0 ? data[i] : param1 * data[i];
+			}
+			break;
+		case AF_Abs:
+			for( int i = 0; i < dataSize; ++i ) {
+				data[i] = fabsf( data[i] );
+			}
+			break;
+		case AF_Sigmoid:
+			for( int i = 0; i < dataSize; ++i ) {
+				data[i] = 1.f / ( 1.f + activationExp( -data[i] ) );
+			}
+			break;
+		case AF_Tanh:
+			for( int i = 0; i < dataSize; ++i ) {
+				data[i] = tanhf( data[i] );
+			}
+			break;
+		case AF_HardTanh:
+			for( int i = 0; i < dataSize; ++i ) {
+				data[i] = std::min( std::max( data[i], -1.f ), 1.f );
+			}
+			break;
+		case AF_HardSigmoid:
+			for( int i = 0; i < dataSize; ++i ) {
+				data[i] = std::min( std::max( data[i] * param1 + param2, 0.f ), 1.f );
+			}
+			break;
+		case AF_Power:
+			for( int i = 0; i < dataSize; ++i ) {
+				data[i] = powf( data[i], param1 );
+			}
+			break;
+		case AF_HSwish:
+			for( int i = 0; i < dataSize; ++i ) {
+				const float value = data[i];
+				data[i] = value <= -3.f ? 0.f : ( value >= 3.f ? value : value * ( value + 3.f ) / 6.f );
+			}
+			break;
+		case AF_GELU:
+			// x * sigmoid(1.702 * x)
+			for( int i = 0; i < dataSize; ++i ) {
+				data[i] = data[i] / ( 1.f + activationExp( -1.702f * data[i] ) );
+			}
+			break;
+		default:
+			break;
+	}
+}
+
+// Applies the activation function to the matrix rows in place
+inline void applyActivation( const CActivationInfo& activation, float* matrix, int height, int width, int rowSize )
+{
+	if( width == rowSize ) {
+		applyActivation( activation, matrix, height * width );
+		return;
+	}
+	for( int i = 0; i < height; ++i ) {
+		applyActivation( activation, matrix + i * rowSize, width );
+	}
+}
+
+} // namespace NeoML
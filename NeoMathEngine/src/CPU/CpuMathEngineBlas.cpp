@@ -18,6 +18,7 @@ limitations under the License.
 
 #include <CpuMathEngine.h>
 #include <CpuMathEnginePrivate.h>
+#include <CpuMathEngineActivation.h>
 #include <MemoryHandleInternal.h>
 #include <MathEngineCommon.h>
 #include <math.h>
@@ -191,10 +192,9 @@ void CCpuMathEngine::SetVectorToMatrixRows( const CFloatHandle& resultHandle,
 	CFloatHandle result = resultHandle;
 
 	const int curThreadCount = IsOmpRelevant( matrixHeight, matrixHeight * matrixWidth ) ? threadCount : 1;
-	NEOML_OMP_FOR_NUM_THREADS( curThreadCount )
-	for(int i = 0; i < matrixHeight; i++) {
+	ParallelFor( *threadPool, curThreadCount, matrixHeight, [&]( int i ) {
 		VectorCopy( result + i * matrixWidth, vectorHandle, matrixWidth );
-	}
+	} );
 }
 
 void CCpuMathEngine::setVectorToMatrixRows( float* result,
@@ -235,8 +235,7 @@ void CCpuMathEngine::AddVectorToMatrixRows( int batchSize, const CConstFloatHand
 	const int matrixSize = matrixHeight * matrixWidth;
 	const int tasks = batchSize * matrixSize;
 	const int curThreadCount = IsOmpRelevant(tasks, tasks) ? threadCount : 1;
-	NEOML_OMP_NUM_THREADS( curThreadCount )
-	{
+	ParallelRun( *threadPool, curThreadCount, [&] {
 		int batchStart;
 		int batchCount;
 		int heightStart;
@@ -257,7 +256,7 @@ void CCpuMathEngine::AddVectorToMatrixRows( int batchSize, const CConstFloatHand
 				vectorData += matrixWidth;
 			}
 		}
-	}
+	} );
 }
 
 void CCpuMathEngine::RowMultiplyMatrixByMatrix(const CConstFloatHandle& firstHandle,
@@ -875,16 +874,26 @@ void CCpuMathEngine::batchMultiplyMatrixByTransposedMatrix( int batchSize, const
 
 void CCpuMathEngine::MultiplyMatrixByTransposedMatrix(const CConstFloatHandle& firstHandle, int firstHeight,
 	int firstWidth, int firstRowSize, const CConstFloatHandle& secondHandle, int secondHeight, int secondRowSize,
+	const CFloatHandle& resultHandle, int resultRowSize, int resultBufferSize)
+{
+	MultiplyMatrixByTransposedMatrix( firstHandle, firstHeight, firstWidth, firstRowSize, secondHandle, secondHeight,
+		secondRowSize, nullptr, CActivationInfo(), resultHandle, resultRowSize, resultBufferSize );
+}
+
+void CCpuMathEngine::MultiplyMatrixByTransposedMatrix(const CConstFloatHandle& firstHandle, int firstHeight,
+	int firstWidth, int firstRowSize, const CConstFloatHandle& secondHandle, int secondHeight, int secondRowSize,
+	const CConstFloatHandle* freeTermHandle, const CActivationInfo& activation,
 	const CFloatHandle& resultHandle, int resultRowSize, int)
 {
 	const float* first = GetRaw( firstHandle );
 	const float* second = GetRaw( secondHandle );
+	const float* freeTerm = freeTermHandle != nullptr ? GetRaw( *freeTermHandle ) : nullptr;
 	float* result = GetRaw( resultHandle );
+	const bool isIdentity = activation.IsIdentity();
 
 	const int curThreadCount = IsOmpRelevant( firstHeight * secondHeight, firstWidth * firstHeight * secondHeight )
 		? threadCount : 1;
-	NEOML_OMP_NUM_THREADS( curThreadCount )
-	{
+	ParallelRun( *threadPool, curThreadCount, [&] {
 		int firstHeightStart;
 		int firstHeightCount;
 		int secondHeightStart;
@@ -892,15 +901,24 @@ void CCpuMathEngine::MultiplyMatrixByTransposedMatrix(const CConstFloatHandle& f
 		if( OmpGetTaskIndexAndCount2D( firstHeight, 1, secondHeight, floatAlignment,
 			firstHeightStart, firstHeightCount, secondHeightStart, secondHeightCount ) )
 		{
-			const float* firstData = first + firstHeightStart * firstWidth;
-			float* resultData = result + firstHeightStart * secondHeight + secondHeightStart;
-			const float* secondData = second + secondHeightStart * firstWidth;
+			const float* firstData = first + firstHeightStart * firstRowSize;
+			float* resultData = result + firstHeightStart * resultRowSize + secondHeightStart;
+			const float* secondData = second + secondHeightStart * secondRowSize;
 
 			multiplyMatrixByTransposedMatrix( firstData, firstHeightCount, firstWidth, firstRowSize,
 				secondData, secondHeightCount, secondRowSize,
 				resultData, resultRowSize );
+
+			// Process the calculated part of the result while it is still in the cache
+			if( freeTerm != nullptr ) {
+				addVectorToMatrixRows( resultData, resultData, firstHeightCount, secondHeightCount, resultRowSize,
+					resultRowSize, freeTerm + secondHeightStart );
+			}
+			if( !isIdentity ) {
+				applyActivation( activation, resultData, firstHeightCount, secondHeightCount, resultRowSize );
+			}
 		}
-	}
+	} );
 }
 
 void CCpuMathEngine::MultiplyMatrixByTransposedMatrix( int batchSize, const CConstFloatHandle& firstHandle,
@@ -922,6 +940,127 @@ void CCpuMathEngine::MultiplyMatrixByTransposedMatrix( int batchSize, const CCon
 	}
 }
 
+void CCpuMathEngine::QuantizeMatrixRows( const CConstFloatHandle& matrixHandle, int height, int width,
+	const CInt8Handle& quantizedHandle, const CFloatHandle& rowScalesHandle )
+{
+	ASSERT_EXPR( height > 0 && width > 0 );
+
+	const float* matrix = GetRaw( matrixHandle );
+	signed char* quantized = GetRaw( quantizedHandle );
+	float* rowScales = GetRaw( rowScalesHandle );
+
+	const int curThreadCount = IsOmpRelevant( height, height * width ) ? threadCount : 1;
+	ParallelRun( *threadPool, curThreadCount, [&] {
+		int start;
+		int count;
+		if( OmpGetTaskIndexAndCount( height, start, count ) ) {
+			for( int row = start; row < start + count; ++row ) {
+				const float* matrixRow = matrix + row * width;
+				signed char* quantizedRow = quantized + row * width;
+
+				float maxAbs = 0;
+				for( int i = 0; i < width; ++i ) {
+					maxAbs = max( maxAbs, static_cast<float>( fabs( matrixRow[i] ) ) );
+				}
+				// The zero row is quantized into zeros with any scale
+				const float scale = maxAbs > 0 ? maxAbs / 127.f : 1.f;
+				for( int i = 0; i < width; ++i ) {
+					quantizedRow[i] = static_cast<signed char>( roundf( matrixRow[i] / scale ) );
+				}
+				rowScales[row] = scale;
+			}
+		}
+	} );
+}
+
+void CCpuMathEngine::MultiplyMatrixByTransposedQuantizedMatrix( const CConstFloatHandle& firstHandle, int firstHeight,
+	int firstWidth, float firstScale, int firstZeroPoint, const CConstInt8Handle& secondHandle,
+	const CConstFloatHandle& secondScalesHandle, int secondHeight, const CConstFloatHandle* freeTermHandle,
+	const CActivationInfo& activation, const CFloatHandle& resultHandle )
+{
+	ASSERT_EXPR( firstScale > 0 );
+	ASSERT_EXPR( 0 <= firstZeroPoint && firstZeroPoint <= 255 );
+
+	const float* first = GetRaw( firstHandle );
+	const signed char* second = GetRaw( secondHandle );
+	const float* secondScales = GetRaw( secondScalesHandle );
+	const float* freeTerm = freeTermHandle != nullptr ? GetRaw( *freeTermHandle ) : nullptr;
+	float* result = GetRaw( resultHandle );
+	const bool isIdentity = activation.IsIdentity();
+
+	CMemoryHandleStackVar<short> quantizedFirst( mathEngine(), firstHeight * firstWidth );
+	short* quantizedFirstRaw = GetRaw( quantizedFirst.GetHandle() );
+
+	const int curThreadCount = IsOmpRelevant( firstHeight * secondHeight, firstWidth * firstHeight * secondHeight )
+		? threadCount : 1;
+	ParallelRun( *threadPool, curThreadCount, [&] {
+		int start;
+		int count;
+		if( OmpGetTaskIndexAndCount( firstHeight, start, count ) ) {
+			quantizeWithZeroPoint( first + start * firstWidth, count * firstWidth, firstScale, firstZeroPoint,
+				quantizedFirstRaw + start * firstWidth );
+		}
+	} );
+
+	ParallelRun( *threadPool, curThreadCount, [&] {
+		int firstHeightStart;
+		int firstHeightCount;
+		int secondHeightStart;
+		int secondHeightCount;
+		if( OmpGetTaskIndexAndCount2D( firstHeight, 1, secondHeight, floatAlignment,
+			firstHeightStart, firstHeightCount, secondHeightStart, secondHeightCount ) )
+		{
+			float* resultData = result + firstHeightStart * secondHeight + secondHeightStart;
+			multiplyMatrixByTransposedQuantizedMatrix( quantizedFirstRaw + firstHeightStart * firstWidth,
+				firstHeightCount, firstWidth, firstScale, second + secondHeightStart * firstWidth,
+				secondScales + secondHeightStart, secondHeightCount, resultData, secondHeight );
+
+			if( freeTerm != nullptr ) {
+				addVectorToMatrixRows( resultData, resultData, firstHeightCount, secondHeightCount, secondHeight,
+					secondHeight, freeTerm + secondHeightStart );
+			}
+			if( !isIdentity ) {
+				applyActivation( activation, resultData, firstHeightCount, secondHeightCount, secondHeight );
+			}
+		}
+	} );
+}
+
+// Quantizes the data into unsigned 8-bit values and stores them with the zero point subtracted
+void CCpuMathEngine::quantizeWithZeroPoint( const float* data, int size, float scale, int zeroPoint, short* result )
+{
+	const float inverseScale = 1.f / scale;
+	for( int i = 0; i < size; ++i ) {
+		const int value = static_cast<int>( roundf( data[i] * inverseScale ) ) + zeroPoint;
+		result[i] = static_cast<short>( min( 255, max( 0, value ) ) - zeroPoint );
+	}
+}
+
+// The products are accumulated in 32-bit integers and converted into float once per result element
+void CCpuMathEngine::multiplyMatrixByTransposedQuantizedMatrix( const short* first, int firstHeight, int firstWidth,
+	float firstScale, const signed char* second, const float* secondScales, int secondHeight,
+	float* result, int resultRowSize )
+{
+	for( int i = 0; i < firstHeight; ++i ) {
+		const short* firstRow = first + i * firstWidth;
+		float* resultRow = result + i * resultRowSize;
+
+		int j = 0;
+		// Process four rows of the second matrix at once to reuse the loaded values of the first row
+		for( ; j + 4 <= secondHeight; j += 4 ) {
+			int sums[4];
+			quantizedDotProduct4( firstRow, second + j * firstWidth, firstWidth, firstWidth, sums );
+			for( int k = 0; k < 4; ++k ) {
+				resultRow[j + k] = firstScale * secondScales[j + k] * sums[k];
+			}
+		}
+		for( ; j < secondHeight; ++j ) {
+			resultRow[j] = firstScale * secondScales[j]
+				* quantizedDotProduct( firstRow, second + j * firstWidth, firstWidth );
+		}
+	}
+}
+
 void CCpuMathEngine::batchMultiplyTransposedMatrixByMatrix( int batchSize,
 	const float* first, int firstHeight, int firstWidth,
 	const float* second, int secondWidth,
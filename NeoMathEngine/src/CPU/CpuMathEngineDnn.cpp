@@ -17,6 +17,7 @@ limitations under the License.
 #pragma hdrstop
 
 #include <CpuMathEngine.h>
+#include <float.h>
 #include <CpuMathEnginePrivate.h>
 #include <MemoryHandleInternal.h>
 #include <MathEngineCommon.h>
@@ -416,8 +417,7 @@ void CCpuMathEngine::QrnnFPooling( bool reverse, int sequenceLength, int objectS
 	}
 
 	const int currThreadCount = IsOmpRelevant( objectSize, sequenceLength * objectSize ) ? threadCount : 1;
-	NEOML_OMP_NUM_THREADS( currThreadCount )
-	{
+	ParallelRun( *threadPool, currThreadCount, [&] {
 		int start;
 		int count;
 		if( OmpGetTaskIndexAndCount( objectSize, start, count ) ) {
@@ -443,7 +443,7 @@ void CCpuMathEngine::QrnnFPooling( bool reverse, int sequenceLength, int objectS
 				hPrev = res;
 			}
 		}
-	}
+	} );
 }
 
 void CCpuMathEngine::QrnnFPoolingBackward( bool reverse, int sequenceLength, int objectSize,
@@ -541,8 +541,7 @@ void CCpuMathEngine::QrnnIfPooling( bool reverse, int sequenceLength, int object
 	}
 
 	const int currThreadCount = IsOmpRelevant( objectSize, sequenceLength * objectSize ) ? threadCount : 1;
-	NEOML_OMP_NUM_THREADS( currThreadCount )
-	{
+	ParallelRun( *threadPool, currThreadCount, [&] {
 		int start;
 		int count;
 		if( OmpGetTaskIndexAndCount( objectSize, start, count ) ) {
@@ -570,7 +569,7 @@ void CCpuMathEngine::QrnnIfPooling( bool reverse, int sequenceLength, int object
 				hPrev = res;
 			}
 		}
-	}
+	} );
 }
 
 void CCpuMathEngine::QrnnIfPoolingBackward( bool reverse, int sequenceLength, int objectSize,
@@ -790,9 +789,355 @@ void CCpuMathEngine::IndRnnRecurrentLearn( bool reverse, int sequenceLength, int
 	}
 }
 
+void CCpuMathEngine::LstmRecurrent( bool reverse, int sequenceLength, int batchSize, int hiddenSize,
+	const CConstFloatHandle& inputGates, const CConstFloatHandle& recurWeights,
+	const CConstFloatHandle& initialOutput, const CConstFloatHandle& initialState,
+	const CFloatHandle& output, const CFloatHandle& state )
+{
+	ASSERT_EXPR( sequenceLength >= 1 );
+	ASSERT_EXPR( batchSize >= 1 );
+	ASSERT_EXPR( hiddenSize >= 1 );
+	ASSERT_EXPR( inputGates.GetMathEngine() == this );
+	ASSERT_EXPR( recurWeights.GetMathEngine() == this );
+	ASSERT_EXPR( initialOutput.IsNull() || initialOutput.GetMathEngine() == this );
+	ASSERT_EXPR( initialState.IsNull() || initialState.GetMathEngine() == this );
+	ASSERT_EXPR( output.GetMathEngine() == this );
+	ASSERT_EXPR( state.GetMathEngine() == this );
+
+	const int gatesSize = 4 * hiddenSize;
+	const int stepSize = batchSize * hiddenSize;
+	CFloatHandleStackVar gates( *this, batchSize * gatesSize );
+
+	CConstFloatHandle prevOutput = initialOutput;
+	CConstFloatHandle prevState = initialState;
+	for( int step = 0; step < sequenceLength; ++step ) {
+		const int pos = reverse ? sequenceLength - 1 - step : step;
+		CConstFloatHandle currInputGates = inputGates + pos * batchSize * gatesSize;
+		CFloatHandle currOutput = output + pos * stepSize;
+		CFloatHandle currState = state + pos * stepSize;
+
+		if( prevOutput.IsNull() ) {
+			VectorCopy( gates.GetHandle(), currInputGates, batchSize * gatesSize );
+		} else {
+			MultiplyMatrixByTransposedMatrix( prevOutput, batchSize, hiddenSize, hiddenSize,
+				recurWeights, gatesSize, hiddenSize, gates.GetHandle(), gatesSize, batchSize * gatesSize );
+			VectorAdd( gates.GetHandle(), currInputGates, gates.GetHandle(), batchSize * gatesSize );
+		}
+
+		// The gate activations: tanh for the main gate, sigmoid for the others
+		CFloatHandle gate = gates.GetHandle();
+		for( int b = 0; b < batchSize; ++b ) {
+			VectorTanh( gate, gate, hiddenSize );
+			VectorSigmoid( gate + hiddenSize, gate + hiddenSize, 3 * hiddenSize );
+			gate += gatesSize;
+		}
+
+		// c_t = input * main + forget * c_(t-1)
+		const float* gatesData = GetRaw( gates.GetHandle() );
+		const float* prevStateData = prevState.IsNull() ? nullptr : GetRaw( prevState );
+		float* stateData = GetRaw( currState );
+		for( int b = 0; b < batchSize; ++b ) {
+			const float* main = gatesData + b * gatesSize;
+			const float* forget = main + hiddenSize;
+			const float* input = forget + hiddenSize;
+			for( int i = 0; i < hiddenSize; ++i ) {
+				stateData[i] = input[i] * main[i];
+			}
+			if( prevStateData != nullptr ) {
+				for( int i = 0; i < hiddenSize; ++i ) {
+					stateData[i] += forget[i] * prevStateData[i];
+				}
+				prevStateData += hiddenSize;
+			}
+			stateData += hiddenSize;
+		}
+
+		// h_t = reset * tanh(c_t)
+		VectorTanh( currState, currOutput, stepSize );
+		float* outputData = GetRaw( currOutput );
+		for( int b = 0; b < batchSize; ++b ) {
+			const float* reset = gatesData + b * gatesSize + 3 * hiddenSize;
+			for( int i = 0; i < hiddenSize; ++i ) {
+				outputData[i] *= reset[i];
+			}
+			outputData += hiddenSize;
+		}
+
+		prevOutput = currOutput;
+		prevState = currState;
+	}
+}
+
+void CCpuMathEngine::GruRecurrent( bool reverse, int sequenceLength, int batchSize, int hiddenSize,
+	const CConstFloatHandle& inputGates, const CConstFloatHandle& inputMain,
+	const CConstFloatHandle& gateWeights, const CConstFloatHandle& mainWeights, int weightsRowSize,
+	const CConstFloatHandle& initialOutput, const CFloatHandle& output )
+{
+	ASSERT_EXPR( sequenceLength >= 1 );
+	ASSERT_EXPR( batchSize >= 1 );
+	ASSERT_EXPR( hiddenSize >= 1 );
+	ASSERT_EXPR( weightsRowSize >= hiddenSize );
+	ASSERT_EXPR( inputGates.GetMathEngine() == this );
+	ASSERT_EXPR( inputMain.GetMathEngine() == this );
+	ASSERT_EXPR( gateWeights.GetMathEngine() == this );
+	ASSERT_EXPR( mainWeights.GetMathEngine() == this );
+	ASSERT_EXPR( initialOutput.IsNull() || initialOutput.GetMathEngine() == this );
+	ASSERT_EXPR( output.GetMathEngine() == this );
+
+	const int gatesSize = 2 * hiddenSize;
+	const int stepSize = batchSize * hiddenSize;
+	CFloatHandleStackVar gates( *this, batchSize * gatesSize );
+	CFloatHandleStackVar resetOutput( *this, stepSize );
+
+	CConstFloatHandle prevOutput = initialOutput;
+	for( int step = 0; step < sequenceLength; ++step ) {
+		const int pos = reverse ? sequenceLength - 1 - step : step;
+		CConstFloatHandle currInputGates = inputGates + pos * batchSize * gatesSize;
+		CConstFloatHandle currInputMain = inputMain + pos * stepSize;
+		CFloatHandle currOutput = output + pos * stepSize;
+
+		const float* gatesData = GetRaw( gates.GetHandle() );
+		float* outputData = GetRaw( currOutput );
+		if( prevOutput.IsNull() ) {
+			// h_(t-1) == 0, so h_t = ( 1 - update ) * tanh( inputMain_t )
+			VectorSigmoid( currInputGates, gates.GetHandle(), batchSize * gatesSize );
+			VectorTanh( currInputMain, currOutput, stepSize );
+			for( int b = 0; b < batchSize; ++b ) {
+				const float* update = gatesData + b * gatesSize;
+				for( int i = 0; i < hiddenSize; ++i ) {
+					outputData[i] *= 1.f - update[i];
+				}
+				outputData += hiddenSize;
+			}
+		} else {
+			MultiplyMatrixByTransposedMatrix( prevOutput, batchSize, hiddenSize, hiddenSize,
+				gateWeights, gatesSize, weightsRowSize, gates.GetHandle(), gatesSize, batchSize * gatesSize );
+			VectorAdd( gates.GetHandle(), currInputGates, gates.GetHandle(), batchSize * gatesSize );
+			VectorSigmoid( gates.GetHandle(), gates.GetHandle(), batchSize * gatesSize );
+
+			const float* prevOutputData = GetRaw( prevOutput );
+			float* resetOutputData = GetRaw( resetOutput.GetHandle() );
+			for( int b = 0; b < batchSize; ++b ) {
+				const float* reset = gatesData + b * gatesSize + hiddenSize;
+				for( int i = 0; i < hiddenSize; ++i ) {
+					resetOutputData[b * hiddenSize + i] = reset[i] * prevOutputData[b * hiddenSize + i];
+				}
+			}
+
+			MultiplyMatrixByTransposedMatrix( resetOutput.GetHandle(), batchSize, hiddenSize, hiddenSize,
+				mainWeights, hiddenSize, weightsRowSize, currOutput, hiddenSize, stepSize );
+			VectorAdd( currOutput, currInputMain, currOutput, stepSize );
+			VectorTanh( currOutput, currOutput, stepSize );
+
+			for( int b = 0; b < batchSize; ++b ) {
+				const float* update = gatesData + b * gatesSize;
+				for( int i = 0; i < hiddenSize; ++i ) {
+					outputData[i] = ( 1.f - update[i] ) * outputData[i] + update[i] * prevOutputData[i];
+				}
+				outputData += hiddenSize;
+				prevOutputData += hiddenSize;
+			}
+		}
+
+		prevOutput = currOutput;
+	}
+}
+
+// The block sizes for the attention: the scores of one query block and one key block fit into the L2 cache
+static const int AttentionQueryBlockSize = 64;
+static const int AttentionKeyBlockSize = 256;
+
+void CCpuMathEngine::ScaledDotProductAttention( int batchSize, int headCount, int queryLength, int keyLength,
+	int headSize, float scale, const CConstFloatHandle& query, const CConstFloatHandle& key,
+	const CConstFloatHandle& value, const CConstFloatHandle& mask, const CFloatHandle& result )
+{
+	ASSERT_EXPR( batchSize >= 1 );
+	ASSERT_EXPR( headCount >= 1 );
+	ASSERT_EXPR( queryLength >= 1 );
+	ASSERT_EXPR( keyLength >= 1 );
+	ASSERT_EXPR( headSize >= 1 );
+	ASSERT_EXPR( query.GetMathEngine() == this );
+	ASSERT_EXPR( key.GetMathEngine() == this );
+	ASSERT_EXPR( value.GetMathEngine() == this );
+	ASSERT_EXPR( mask.IsNull() || mask.GetMathEngine() == this );
+	ASSERT_EXPR( result.GetMathEngine() == this );
+
+	const float* queryData = GetRaw( query );
+	const float* keyData = GetRaw( key );
+	const float* valueData = GetRaw( value );
+	const float* maskData = mask.IsNull() ? nullptr : GetRaw( mask );
+	float* resultData = GetRaw( result );
+
+	// All the heads are stored in one row, so the rows of a single head are strided
+	const int rowSize = headCount * headSize;
+	const int queryBlockCount = ( queryLength + AttentionQueryBlockSize - 1 ) / AttentionQueryBlockSize;
+	const int taskCount = batchSize * headCount * queryBlockCount;
+	const int keyBlockSize = min( keyLength, AttentionKeyBlockSize );
+	// Per thread: the scores of the block, the running maximum and the running sum for each query
+	const int bufferSize = AttentionQueryBlockSize * ( keyBlockSize + 2 );
+
+	const int curThreadCount = IsOmpRelevant( taskCount,
+		static_cast<int64_t>( batchSize ) * queryLength * keyLength * rowSize ) ? threadCount : 1;
+	CFloatHandleStackVar buffer( mathEngine(), curThreadCount * bufferSize );
+	float* bufferData = GetRaw( buffer.GetHandle() );
+
+	ParallelRun( *threadPool, curThreadCount, [&] {
+		float* scores = bufferData + OmpGetThreadNum() * bufferSize;
+		float* rowMax = scores + AttentionQueryBlockSize * keyBlockSize;
+		float* rowSum = rowMax + AttentionQueryBlockSize;
+
+		int start;
+		int count;
+		if( OmpGetTaskIndexAndCount( taskCount, start, count ) ) {
+			for( int task = start; task < start + count; ++task ) {
+				const int queryBlock = task % queryBlockCount;
+				const int head = ( task / queryBlockCount ) % headCount;
+				const int batch = task / ( queryBlockCount * headCount );
+
+				const int queryStart = queryBlock * AttentionQueryBlockSize;
+				const int queryCount = min( AttentionQueryBlockSize, queryLength - queryStart );
+				const float* q = queryData + ( batch * queryLength + queryStart ) * rowSize + head * headSize;
+				const float* k = keyData + batch * keyLength * rowSize + head * headSize;
+				const float* v = valueData + batch * keyLength * rowSize + head * headSize;
+				// The unnormalized result is accumulated right in the output
+				float* out = resultData + ( batch * queryLength + queryStart ) * rowSize + head * headSize;
+
+				for( int i = 0; i < queryCount; ++i ) {
+					vectorFill0( out + i * rowSize, headSize );
+				}
+				vectorFill( rowMax, -FLT_MAX, queryCount );
+				vectorFill0( rowSum, queryCount );
+
+				for( int keyStart = 0; keyStart < keyLength; keyStart += keyBlockSize ) {
+					const int keyCount = min( keyBlockSize, keyLength - keyStart );
+					multiplyMatrixByTransposedMatrix( q, queryCount, headSize, rowSize,
+						k + keyStart * rowSize, keyCount, rowSize, scores, keyCount );
+
+					// The online softmax: the previous sums and results are rescaled to the new maximum
+					for( int i = 0; i < queryCount; ++i ) {
+						float* rowScores = scores + i * keyCount;
+						const float* rowMask = maskData == nullptr ? nullptr
+							: maskData + ( queryStart + i ) * keyLength + keyStart;
+						float blockMax = -FLT_MAX;
+						for( int j = 0; j < keyCount; ++j ) {
+							rowScores[j] *= scale;
+							if( rowMask != nullptr ) {
+								rowScores[j] += rowMask[j];
+							}
+							blockMax = max( blockMax, rowScores[j] );
+						}
+
+						const float newMax = max( rowMax[i], blockMax );
+						float blockSum = 0;
+						for( int j = 0; j < keyCount; ++j ) {
+							rowScores[j] = expf( rowScores[j] - newMax );
+							blockSum += rowScores[j];
+						}
+
+						if( rowMax[i] != -FLT_MAX ) {
+							const float correction = expf( rowMax[i] - newMax );
+							float* outRow = out + i * rowSize;
+							for( int c = 0; c < headSize; ++c ) {
+								outRow[c] *= correction;
+							}
+							rowSum[i] *= correction;
+						}
+						rowSum[i] += blockSum;
+						rowMax[i] = newMax;
+					}
+
+					multiplyMatrixByMatrixAndAdd( scores, queryCount, keyCount, keyCount,
+						v + keyStart * rowSize, headSize, rowSize, out, rowSize );
+				}
+
+				for( int i = 0; i < queryCount; ++i ) {
+					float* outRow = out + i * rowSize;
+					const float multiplier = 1.f / rowSum[i];
+					for( int c = 0; c < headSize; ++c ) {
+						outRow[c] *= multiplier;
+					}
+				}
+			}
+		}
+	} );
+}
+
+void CCpuMathEngine::AdamStep( const CAdamStepParams& params, int dataSize, const CConstFloatHandle& paramDiff,
+	const CFloatHandle& param, const CFloatHandle& moment, const CFloatHandle& secondMoment,
+	const CFloatHandle& secondMomentMax )
+{
+	ASSERT_EXPR( dataSize >= 0 );
+	ASSERT_EXPR( paramDiff.GetMathEngine() == this );
+	ASSERT_EXPR( param.GetMathEngine() == this );
+	ASSERT_EXPR( moment.GetMathEngine() == this );
+	ASSERT_EXPR( secondMoment.GetMathEngine() == this );
+	ASSERT_EXPR( secondMomentMax.IsNull() || secondMomentMax.GetMathEngine() == this );
+
+	const float* paramDiffData = GetRaw( paramDiff );
+	float* paramData = GetRaw( param );
+	float* momentData = GetRaw( moment );
+	float* secondMomentData = GetRaw( secondMoment );
+	float* secondMomentMaxData = secondMomentMax.IsNull() ? nullptr : GetRaw( secondMomentMax );
+
+	const int curThreadCount = IsOmpRelevant( dataSize, dataSize ) ? threadCount : 1;
+
+	ParallelRun( *threadPool, curThreadCount, [&] {
+		int index;
+		int count;
+		if( OmpGetTaskIndexAndCount( dataSize, 16, index, count ) ) {
+			vectorAdamStep( params, paramDiffData + index, paramData + index, momentData + index,
+				secondMomentData + index, secondMomentMaxData == nullptr ? nullptr : secondMomentMaxData + index, count );
+		}
+	} );
+}
+
+void CCpuMathEngine::LambUpdate( int dataSize, float gradientMult, float momentDecayRate, float secondMomentDecayRate,
+	float epsilon, float weightDecay, const CConstFloatHandle& paramDiff, const CConstFloatHandle& param,
+	const CFloatHandle& moment, const CFloatHandle& secondMoment, const CFloatHandle& update,
+	const CFloatHandle& squaredNorms )
+{
+	ASSERT_EXPR( dataSize >= 0 );
+	ASSERT_EXPR( paramDiff.GetMathEngine() == this );
+	ASSERT_EXPR( param.GetMathEngine() == this );
+	ASSERT_EXPR( moment.GetMathEngine() == this );
+	ASSERT_EXPR( secondMoment.GetMathEngine() == this );
+	ASSERT_EXPR( update.GetMathEngine() == this );
+	ASSERT_EXPR( squaredNorms.GetMathEngine() == this );
+
+	const float* paramDiffData = GetRaw( paramDiff );
+	const float* paramData = GetRaw( param );
+	float* momentData = GetRaw( moment );
+	float* secondMomentData = GetRaw( secondMoment );
+	float* updateData = GetRaw( update );
+
+	// Each thread accumulates its own norms, they are summed up afterwards
+	const int curThreadCount = IsOmpRelevant( dataSize, dataSize ) ? threadCount : 1;
+	CFloatHandleStackVar threadNorms( mathEngine(), curThreadCount * 3 );
+	float* threadNormsData = GetRaw( threadNorms.GetHandle() );
+	vectorFill0( threadNormsData, curThreadCount * 3 );
+
+	ParallelRun( *threadPool, curThreadCount, [&] {
+		int index;
+		int count;
+		if( OmpGetTaskIndexAndCount( dataSize, 16, index, count ) ) {
+			vectorLambUpdate( gradientMult, momentDecayRate, secondMomentDecayRate, epsilon, weightDecay,
+				paramDiffData + index, paramData + index, momentData + index, secondMomentData + index,
+				updateData + index, count, threadNormsData + OmpGetThreadNum() * 3 );
+		}
+	} );
+
+	float* result = GetRaw( squaredNorms );
+	vectorFill0( result, 3 );
+	for( int i = 0; i < curThreadCount; ++i ) {
+		for( int j = 0; j < 3; ++j ) {
+			result[j] += threadNormsData[i * 3 + j];
+		}
+	}
+}
+
 template<class T>
 static inline void SpaceToDepthFunc( const T* source, int dataRowCount, int dataRowWidth,
-	int blockChannels, int blockSize, bool isForward, T* result, int threadCount )
+	int blockChannels, int blockSize, bool isForward, T* result, IThreadPool& threadPool )
 {
 	// flattens 3d-block of size (blockSize x blockSize x channels)
 
@@ -810,9 +1155,8 @@ static inline void SpaceToDepthFunc( const T* source, int dataRowCount, int data
 
 	// iterate over data rows
 	const int blobSize = dataRowCount * dataRowWidth * blockSize * blockRowSize;
-	const int curThreadCount = IsOmpRelevant( dataRowCount, blobSize ) ? threadCount : 1;
-	NEOML_OMP_NUM_THREADS( curThreadCount )
-	{
+	const int curThreadCount = IsOmpRelevant( dataRowCount, blobSize ) ? threadPool.Size() : 1;
+	ParallelRun( threadPool, curThreadCount, [&] {
 		int threadRowStart;
 		int threadRowCount;
 		if( OmpGetTaskIndexAndCount( dataRowCount, threadRowStart, threadRowCount ) ) {
@@ -840,7 +1184,7 @@ static inline void SpaceToDepthFunc( const T* source, int dataRowCount, int data
 				resultPtr += dataRowSize;
 			}
 		}
-	}
+	} );
 }
 
 void CCpuMathEngine::SpaceToDepth( const CBlobDesc& source, const CConstFloatHandle& sourceData, int blockSize,
@@ -856,7 +1200,7 @@ void CCpuMathEngine::SpaceToDepth( const CBlobDesc& source, const CConstFloatHan
 	ASSERT_EXPR( source.Channels() * blockSize * blockSize == result.Channels() );
 
 	SpaceToDepthFunc( GetRaw( sourceData ), source.ObjectCount() * result.Height(), result.Width(), source.Channels(),
-		blockSize, true, GetRaw( resultData ), threadCount );
+		blockSize, true, GetRaw( resultData ), *threadPool );
 }
 
 void CCpuMathEngine::SpaceToDepth( const CBlobDesc& source, const CConstIntHandle& sourceData, int blockSize,
@@ -872,7 +1216,7 @@ void CCpuMathEngine::SpaceToDepth( const CBlobDesc& source, const CConstIntHandl
 	ASSERT_EXPR( source.Channels() * blockSize * blockSize == result.Channels() );
 
 	SpaceToDepthFunc( GetRaw( sourceData ), source.ObjectCount() * result.Height(), result.Width(), source.Channels(),
-		blockSize, true, GetRaw( resultData ), threadCount );
+		blockSize, true, GetRaw( resultData ), *threadPool );
 }
 
 void CCpuMathEngine::DepthToSpace( const CBlobDesc& source, const CConstFloatHandle& sourceData, int blockSize,
@@ -888,7 +1232,7 @@ void CCpuMathEngine::DepthToSpace( const CBlobDesc& source, const CConstFloatHan
 	ASSERT_EXPR( source.Channels() == result.Channels() * blockSize * blockSize );
 
 	SpaceToDepthFunc( GetRaw( sourceData ), source.ObjectCount() * source.Height(), source.Width(), result.Channels(),
-		blockSize, false, GetRaw( resultData ), threadCount );
+		blockSize, false, GetRaw( resultData ), *threadPool );
 }
 
 void CCpuMathEngine::DepthToSpace( const CBlobDesc& source, const CConstIntHandle& sourceData, int blockSize,
@@ -904,7 +1248,7 @@ void CCpuMathEngine::DepthToSpace( const CBlobDesc& source, const CConstIntHandl
 	ASSERT_EXPR( source.Channels() == result.Channels() * blockSize * blockSize );
 
 	SpaceToDepthFunc( GetRaw( sourceData ), source.ObjectCount() * source.Height(), source.Width(), result.Channels(),
-		blockSize, false, GetRaw( resultData ), threadCount );
+		blockSize, false, GetRaw( resultData ), *threadPool );
 }
 
 } // namespace NeoML
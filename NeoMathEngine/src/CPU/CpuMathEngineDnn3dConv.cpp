@@ -55,8 +55,7 @@ void CCpuMathEngine::blob3dConvolution1x1x1Backward( const CCommon3dConvolutionD
 	int objectCount = outputDiff.ObjectCount();
 
 	const int curThreadCount = IsOmpRelevant( objectCount ) ? threadCount : 1;
-	NEOML_OMP_NUM_THREADS( curThreadCount )
-	{
+	ParallelRun( *threadPool, curThreadCount, [&] {
 		int batchStart;
 		int batchCount;
 		if( OmpGetTaskIndexAndCount( objectCount, batchStart, batchCount ) ) {
@@ -109,7 +108,7 @@ void CCpuMathEngine::blob3dConvolution1x1x1Backward( const CCommon3dConvolutionD
 				}
 			}
 		}
-	}
+	} );
 }
 
 void CCpuMathEngine::blob3dConvolution1x1x1LearnAdd( const CCommon3dConvolutionDesc& desc, const CFloatHandle& inputData,
@@ -309,8 +308,7 @@ void CCpuMathEngine::blob3dConvolution( const CCommon3dConvolutionDesc& desc, co
 	CFloatHandleStackVar outputTempData( mathEngine(), tempObjectCount * outputTempObjectSize );
 	float* outputTempDataPtr = GetRaw( outputTempData.GetHandle() );
 
-	NEOML_OMP_NUM_THREADS( curThreadCount )
-	{
+	ParallelRun( *threadPool, curThreadCount, [&] {
 		int batchStart;
 		int batchCount;
 		int outputStart;
@@ -355,7 +353,7 @@ void CCpuMathEngine::blob3dConvolution( const CCommon3dConvolutionDesc& desc, co
 				}
 			}
 		}
-	}
+	} );
 }
 
 void CCpuMathEngine::addMatrixToMatrix( float* first, int height,
@@ -413,8 +411,7 @@ void CCpuMathEngine::blob3dConvolutionBackward( const CCommon3dConvolutionDesc&
 	const int curThreadCount = IsOmpRelevant( outputLineY, static_cast<int64_t>( source.BlobSize() ) * filter.BlobSize() )
 		? threadCount : 1;
 
-	NEOML_OMP_NUM_THREADS( curThreadCount )
-	{
+	ParallelRun( *threadPool, curThreadCount, [&] {
 		// The first step is to multiply the input and filter matrices
 		int inputStart;
 		int inputCount;
@@ -424,13 +421,10 @@ void CCpuMathEngine::blob3dConvolutionBackward( const CCommon3dConvolutionDesc&
 				filterForwardPtr, filterForwardGeometricalSize, filterForwardChannelsCount,
 				tempPtr + inputStart * tempWidth, filterForwardGeometricalSize );
 		}
+	} );
 
-		do {
-			if( curThreadCount > 1 ) {
-#pragma omp barrier
-			}
-		} while( 0 );
-
+	// The second step reads the temp rows calculated by other threads, so it must start after the first one is finished
+	ParallelRun( *threadPool, curThreadCount, [&] {
 		// The second step is to add the subvectors of the resulting 
 		// matrix to the corresponding places in the output
 		int outputLineStart;
@@ -520,7 +514,7 @@ void CCpuMathEngine::blob3dConvolutionBackward( const CCommon3dConvolutionDesc&
 				}
 			}
 		}
-	}
+	} );
 }
 
 void CCpuMathEngine::blob3dConvolutionLearnAdd( const CCommon3dConvolutionDesc& desc, const float* inputData,
@@ -551,38 +545,37 @@ void CCpuMathEngine::blob3dConvolutionLearnAdd( const CCommon3dConvolutionDesc&
 		freeTermDiffReduction.reset( new COmpReduction<COmpReduction1DData>( curThreadCount, *freeTermDiffItem ) );
 	}
 
-	NEOML_OMP_FOR_NUM_THREADS( curThreadCount )
-		for( int b = 0; b < objectCount; ++b ) {
-			const float* outputDiffDataPtr = outputDiffData + b * outputDiff.ObjectSize();
-			float* inputPreparedDataPtr = GetRaw( inputPreparedTemp.GetPrivateData() );
-			float* filterDiffReductionDataPtr = GetRaw( filterDiffReduction.GetPrivate().Data );
-			float* outputTempDataPtr = GetRaw( outputTemp.GetPrivateData() );
-
-			blob3dConvolutionPrepareInput( desc, inputPreparedDataPtr, inputData, b,
-				outputDiff.Height(), 0, outputDiff.Width() * outputDiff.Depth() );
-
-			transposeMatrix( 1, outputDiffDataPtr,
-				outputDiff.Height(), 1, outputDiff.Width() * outputDiff.Depth(),
-				outputDiff.Channels(), outputTempDataPtr );
-
-			// Filter diff
-			multiplyTransposedMatrixByMatrixAndAdd( outputTempDataPtr,
-				outputDiff.GeometricalSize(), outputDiff.Channels(), outputDiff.Channels(),
-				inputPreparedDataPtr, filterDiff.GeometricalSize() * input.Channels(), filterDiff.GeometricalSize() * input.Channels(),
-				filterDiffReductionDataPtr, filterDiff.GeometricalSize() * input.Channels() );
-
-			if( freeTermDiffData != nullptr ) {
-				// Free term diff
-				float* freeTermDiffReductionDataPtr = GetRaw( freeTermDiffReduction->GetPrivate().Data );
-				if( isFreeTermDiffFromInput ) {
-					sumMatrixRowsAdd( freeTermDiffReductionDataPtr,
-						inputData + b * input.ObjectSize(), input.GeometricalSize(), input.Channels() );
-				} else {
-					sumMatrixRowsAdd( freeTermDiffReductionDataPtr,
-						outputDiffDataPtr, outputDiff.GeometricalSize(), outputDiff.Channels() );
-				}
+	ParallelFor( *threadPool, curThreadCount, objectCount, [&]( int b ) {
+		const float* outputDiffDataPtr = outputDiffData + b * outputDiff.ObjectSize();
+		float* inputPreparedDataPtr = GetRaw( inputPreparedTemp.GetPrivateData() );
+		float* filterDiffReductionDataPtr = GetRaw( filterDiffReduction.GetPrivate().Data );
+		float* outputTempDataPtr = GetRaw( outputTemp.GetPrivateData() );
+
+		blob3dConvolutionPrepareInput( desc, inputPreparedDataPtr, inputData, b,
+			outputDiff.Height(), 0, outputDiff.Width() * outputDiff.Depth() );
+
+		transposeMatrix( 1, outputDiffDataPtr,
+			outputDiff.Height(), 1, outputDiff.Width() * outputDiff.Depth(),
+			outputDiff.Channels(), outputTempDataPtr );
+
+		// Filter diff
+		multiplyTransposedMatrixByMatrixAndAdd( outputTempDataPtr,
+			outputDiff.GeometricalSize(), outputDiff.Channels(), outputDiff.Channels(),
+			inputPreparedDataPtr, filterDiff.GeometricalSize() * input.Channels(), filterDiff.GeometricalSize() * input.Channels(),
+			filterDiffReductionDataPtr, filterDiff.GeometricalSize() * input.Channels() );
+
+		if( freeTermDiffData != nullptr ) {
+			// Free term diff
+			float* freeTermDiffReductionDataPtr = GetRaw( freeTermDiffReduction->GetPrivate().Data );
+			if( isFreeTermDiffFromInput ) {
+				sumMatrixRowsAdd( freeTermDiffReductionDataPtr,
+					inputData + b * input.ObjectSize(), input.GeometricalSize(), input.Channels() );
+			} else {
+				sumMatrixRowsAdd( freeTermDiffReductionDataPtr,
+					outputDiffDataPtr, outputDiff.GeometricalSize(), outputDiff.Channels() );
 			}
 		}
+	} );
 
 	filterDiffReduction.Reduce();
 	if( freeTermDiffData != 0 ) {
@@ -617,7 +610,7 @@ void CCpuMathEngine::Blob3dConvolution( const C3dConvolutionDesc& convDesc, cons
 
 	if( desc.PaddingHeight == 0 && desc.PaddingWidth == 0 && desc.PaddingDepth == 0 && desc.Filter.ObjectSize() == desc.Filter.Channels() ) {
 		blob3dConvolution1x1x1( desc.Source, desc.Filter, desc.Result, desc.StrideHeight, desc.StrideWidth, desc.StrideDepth,
-			sourceDataRaw, filterDataRaw, freeTermDataRaw, resultDataRaw );
+			sourceDataRaw, filterDataRaw, freeTermDataRaw, CActivationInfo(), resultDataRaw );
 	} else {
 		blob3dConvolution( desc, sourceDataRaw, filterDataRaw, freeTermData, resultDataRaw );
 	}
@@ -130,8 +130,7 @@ void CCpuMathEngine::blobChannelwiseConvolutionFilter3x3Padding1Stride2( const C
 	const int inputObjectSize = inputRowSize * sourceDesc.Height();
 	const int outputObjectSize = outputRowSize * resultDesc.Height();
 
-	NEOML_OMP_NUM_THREADS( curThreadCount )
-	{
+	ParallelRun( *threadPool, curThreadCount, [&] {
 		int batchStart;
 		int batchCount;
 		int resultStart;
@@ -205,7 +204,7 @@ void CCpuMathEngine::blobChannelwiseConvolutionFilter3x3Padding1Stride2( const C
 				resultRowEnd += outputObjectSize;
 			}
 		}
-	}
+	} );
 }
 
 void CCpuMathEngine::blobChannelwiseConvolutionFilter3x3Padding1Stride1( const CCommonChannelwiseConvolutionDesc& desc,
@@ -227,8 +226,7 @@ void CCpuMathEngine::blobChannelwiseConvolutionFilter3x3Padding1Stride1( const C
 	const int inputObjectSize = inputRowSize * sourceDesc.Height();
 	const int outputObjectSize = outputRowSize * resultDesc.Height();
 
-	NEOML_OMP_NUM_THREADS( curThreadCount )
-	{
+	ParallelRun( *threadPool, curThreadCount, [&] {
 		int batchStart;
 		int batchCount;
 		int resultStart;
@@ -301,7 +299,7 @@ void CCpuMathEngine::blobChannelwiseConvolutionFilter3x3Padding1Stride1( const C
 				resultRowEnd += outputObjectSize;
 			}
 		}
-	}
+	} );
 }
 
 void CCpuMathEngine::BlobChannelwiseConvolution( const CChannelwiseConvolutionDesc& convDesc, const CConstFloatHandle& sourceData,
@@ -341,8 +339,7 @@ void CCpuMathEngine::BlobChannelwiseConvolution( const CChannelwiseConvolutionDe
 	const int inputObjectSize = inputRowSize * sourceDesc.Height();
 	const int outputObjectSize = outputRowSize * resultDesc.Height();
 
-	NEOML_OMP_NUM_THREADS( curThreadCount )
-	{
+	ParallelRun( *threadPool, curThreadCount, [&] {
 		int batchStart;
 		int batchCount;
 		int resultStart;
@@ -391,7 +388,7 @@ void CCpuMathEngine::BlobChannelwiseConvolution( const CChannelwiseConvolutionDe
 				}
 			}
 		}
-	}
+	} );
 }
 
 } // namespace NeoML
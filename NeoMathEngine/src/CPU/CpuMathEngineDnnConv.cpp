@@ -23,6 +23,7 @@ limitations under the License.
 #include <MemoryHandleInternal.h>
 #include <MathEngineDnnConv.h>
 #include <CpuMathEnginePrivate.h>
+#include <CpuMathEngineActivation.h>
 #include <NeoMathEngine/SimdMathEngine.h>
 
 namespace NeoML {
@@ -34,7 +35,8 @@ enum TConvAlgo {
 	CA_2,		// work with the data directly (only for stride = 1 and padding = 0)
 				// most efficient when the image is large and especially when it has many channels
 				
-	CA_1x1		// for convolution with a 1*1 filter, no padding and dilation (both 2D and 3D)
+	CA_1x1,		// for convolution with a 1*1 filter, no padding and dilation (both 2D and 3D)
+	CA_Winograd	// Winograd F(2x2, 3x3) algorithm for a 3*3 filter with stride = 1 and no dilation (forward pass only)
 };
 
 const int BlobConvolutionCacheSize = 256 * 1024;
@@ -45,20 +47,49 @@ struct CCpuConvolutionDesc : public CCommonConvolutionDesc {
 	TConvAlgo BackwardAlgo;
 	unique_ptr<CConvolutionDesc> SimdConvolutionDesc;
 
-	CCpuConvolutionDesc( unique_ptr<CConvolutionDesc>& simdConvolutionDesc, const CBlobDesc& source, const CBlobDesc& result, const CBlobDesc& filter,
-			int paddingHeight, int paddingWidth, int strideHeight, int strideWidth, int dilationHeight, int dilationWidth ) :
+	// The filter transformed for the Winograd algorithm (16 x FilterCount x InputChannels)
+	// Used only if ForwardAlgo == CA_Winograd
+	unique_ptr<CFloatHandleVar> WinogradFilter;
+	mutable bool IsWinogradFilterValid; // indicates if WinogradFilter has been calculated from the current filter
+
+	CCpuConvolutionDesc( IMathEngine& mathEngine, unique_ptr<CConvolutionDesc>& simdConvolutionDesc, const CBlobDesc& source,
+			const CBlobDesc& result, const CBlobDesc& filter, int paddingHeight, int paddingWidth,
+			int strideHeight, int strideWidth, int dilationHeight, int dilationWidth ) :
 		CCommonConvolutionDesc( source, result, filter, paddingHeight, paddingWidth, strideHeight, strideWidth, dilationHeight, dilationWidth ),
-		ForwardAlgo( getActualForwardAlgo() ),
+		ForwardAlgo( simdConvolutionDesc == nullptr && isWinogradApplicable() ? CA_Winograd : getActualForwardAlgo() ),
 		BackwardAlgo( getActualBackwardAlgo() ),
-		SimdConvolutionDesc( std::move( simdConvolutionDesc ) )
+		SimdConvolutionDesc( std::move( simdConvolutionDesc ) ),
+		IsWinogradFilterValid( false )
 	{
+		if( ForwardAlgo == CA_Winograd ) {
+			WinogradFilter.reset( new CFloatHandleVar( mathEngine, WinogradTileSize * filter.ObjectCount() * filter.Depth() * filter.Channels() ) );
+		}
 	}
 
+	// CConvolutionDesc
+	void ResetFilterCache() override { IsWinogradFilterValid = false; }
+
+	// The number of elements in the transformed input tile (4 x 4)
+	static const int WinogradTileSize = 16;
+
+	bool isWinogradApplicable() const;
 	TConvAlgo getActualForwardAlgo() const;
 	TConvAlgo getActualBackwardAlgo() const;
 };
 
-// Gets the algorithm to be used for this convolution
+// Checks if the Winograd algorithm may be used for this convolution
+// The transformations only pay off when there are enough channels to multiply
+inline bool CCpuConvolutionDesc::isWinogradApplicable() const
+{
+	return Filter.Height() == 3 && Filter.Width() == 3
+		&& StrideHeight == 1 && StrideWidth == 1
+		&& DilationHeight == 1 && DilationWidth == 1
+		&& PaddingHeight <= 2 && PaddingWidth <= 2
+		&& Result.Height() >= 4 && Result.Width() >= 4
+		&& Source.Depth() * Source.Channels() >= 8 && Filter.ObjectCount() >= 8;
+}
+
+// Gets the algorithm to be used for this convolution (apart from the Winograd algorithm)
 inline TConvAlgo CCpuConvolutionDesc::getActualForwardAlgo() const
 {
 	if( PaddingHeight == 0 && PaddingWidth == 0
@@ -136,7 +167,7 @@ CConvolutionDesc* CCpuMathEngine::InitBlobConvolution( const CBlobDesc& source,
 			strideHeight, strideWidth, dilationHeight, dilationWidth, filter, result ) );
 	}
 
-	CCpuConvolutionDesc* desc = new CCpuConvolutionDesc( simdConvolutionDesc, source, result, filter,
+	CCpuConvolutionDesc* desc = new CCpuConvolutionDesc( mathEngine(), simdConvolutionDesc, source, result, filter,
 		paddingHeight, paddingWidth, strideHeight, strideWidth, dilationHeight, dilationWidth );
 	return desc;
 }
@@ -391,7 +422,7 @@ inline int ceilTo( int val, int discret )
 }
 
 void CCpuMathEngine::blobConvolutionForwardAlgo0( const CCpuConvolutionDesc& desc, const float* sourceData,
-	const float* filterData, const CFloatHandle* freeTermData, float* resultData )
+	const float* filterData, const CFloatHandle* freeTermData, const CActivationInfo& activation, float* resultData )
 {
 	const int resultItemCount = desc.Result.ObjectCount() * desc.Result.Width() * desc.Result.Height();
 	const int curThreadCount = IsOmpRelevant( resultItemCount, static_cast< int64_t >( desc.Result.BlobSize() ) * desc.Filter.ObjectSize() ) ? threadCount : 1;
@@ -401,8 +432,7 @@ void CCpuMathEngine::blobConvolutionForwardAlgo0( const CCpuConvolutionDesc& des
 	CFloatHandleStackVar tempData( mathEngine(), tempDataSize );
 	float* tempDataRaw = GetRaw( tempData.GetHandle() );
 
-	NEOML_OMP_NUM_THREADS( curThreadCount )
-	{
+	ParallelRun( *threadPool, curThreadCount, [&] {
 		const int filterObjectCount = desc.Filter.ObjectCount();
 		const int filterObjectSize = desc.Filter.ObjectSize();
 		float* tempDataPtr = tempDataRaw + OmpGetThreadNum() * cacheItemCount * filterObjectSize;
@@ -426,15 +456,18 @@ void CCpuMathEngine::blobConvolutionForwardAlgo0( const CCpuConvolutionDesc& des
 					addVectorToMatrixRows( resultDataPtr, resultDataPtr, size, filterObjectCount, filterObjectCount, 
 						filterObjectCount, GetRaw( *freeTermData ) );
 				}
+				if( !activation.IsIdentity() ) {
+					applyActivation( activation, resultDataPtr, size * filterObjectCount );
+				}
 
 				index += size;
 			}
 		}
-	}
+	} );
 }
 
 void CCpuMathEngine::blobConvolutionForwardAlgo1( const CCpuConvolutionDesc& desc, const float* sourceData,
-	const float* filterData, const CFloatHandle* freeTermData, float* resultData )
+	const float* filterData, const CFloatHandle* freeTermData, const CActivationInfo& activation, float* resultData )
 {
 	float* freeTermDataRaw = freeTermData == nullptr ? nullptr : GetRaw( *freeTermData );
 
@@ -459,8 +492,7 @@ void CCpuMathEngine::blobConvolutionForwardAlgo1( const CCpuConvolutionDesc& des
 	float* outputTransposedData = GetRaw( stackBuffer.GetHandle() );
 	float* tempBlobData = outputTransposedData + outputTransposedDataSize;
 
-	NEOML_OMP_NUM_THREADS( curThreadCount )
-	{
+	ParallelRun( *threadPool, curThreadCount, [&] {
 		const CBlobDesc& source = desc.Source;
 		const CBlobDesc& filter = desc.Filter;
 		const CBlobDesc& result = desc.Result;
@@ -497,15 +529,208 @@ void CCpuMathEngine::blobConvolutionForwardAlgo1( const CCpuConvolutionDesc& des
 						filter.BatchWidth() );
 				}
 
+				if( !activation.IsIdentity() ) {
+					applyActivation( activation, outputTransposedPtr, result.Height() * resultCount * outputChannels );
+				}
+
 				// Transpose the result
 				transposeResult( desc, outputTransposedPtr, batch, resultStart, resultCount, resultData );
 			}
 		}
+	} );
+}
+
+// Calculates the filter for the Winograd algorithm: U = G * g * G^T for each filter and input channel
+// The result is stored as 16 matrices of FilterCount x InputChannels size
+// The calculation is done only once until the cache is reset by CConvolutionDesc::ResetFilterCache
+void CCpuMathEngine::updateWinogradFilter( const CCpuConvolutionDesc& desc, const float* filterData )
+{
+	if( desc.IsWinogradFilterValid ) {
+		return;
 	}
+	desc.IsWinogradFilterValid = true;
+
+	const int filterCount = desc.Filter.ObjectCount();
+	const int channels = desc.Filter.Depth() * desc.Filter.Channels();
+	const int matrixSize = filterCount * channels;
+	float* result = GetRaw( desc.WinogradFilter->GetHandle() );
+
+	for( int k = 0; k < filterCount; ++k ) {
+		const float* filter = filterData + k * desc.Filter.ObjectSize();
+		float* resultPtr = result + k * channels;
+		for( int c = 0; c < channels; ++c ) {
+			float g[3][3];
+			for( int i = 0; i < 3; ++i ) {
+				for( int j = 0; j < 3; ++j ) {
+					g[i][j] = filter[( i * 3 + j ) * channels + c];
+				}
+			}
+			// t = G * g
+			float t[4][3];
+			for( int j = 0; j < 3; ++j ) {
+				t[0][j] = g[0][j];
+				t[1][j] = 0.5f * ( g[0][j] + g[1][j] + g[2][j] );
+				t[2][j] = 0.5f * ( g[0][j] - g[1][j] + g[2][j] );
+				t[3][j] = g[2][j];
+			}
+			// u = t * G^T
+			for( int i = 0; i < 4; ++i ) {
+				resultPtr[( i * 4 + 0 ) * matrixSize + c] = t[i][0];
+				resultPtr[( i * 4 + 1 ) * matrixSize + c] = 0.5f * ( t[i][0] + t[i][1] + t[i][2] );
+				resultPtr[( i * 4 + 2 ) * matrixSize + c] = 0.5f * ( t[i][0] - t[i][1] + t[i][2] );
+				resultPtr[( i * 4 + 3 ) * matrixSize + c] = t[i][2];
+			}
+		}
+	}
+}
+
+// Winograd F(2x2, 3x3) algorithm
+// The result is split into 2x2 tiles; for each tile the 4x4 input window is transformed (V = B^T * d * B),
+// then the transformed input is multiplied by the transformed filter as 16 independent matrix products
+// and the products are transformed back (Y = A^T * M * A)
+// That takes 16 multiplications per 4 output pixels instead of 36
+void CCpuMathEngine::blobConvolutionForwardWinograd( const CCpuConvolutionDesc& desc, const float* sourceData,
+	const float* filterData, const float* freeTermData, const CActivationInfo& activation, float* resultData )
+{
+	const int tileSize = CCpuConvolutionDesc::WinogradTileSize;
+
+	updateWinogradFilter( desc, filterData );
+	const float* winogradFilter = GetRaw( desc.WinogradFilter->GetHandle() );
+
+	const CBlobDesc& source = desc.Source;
+	const CBlobDesc& result = desc.Result;
+	const int channels = source.Depth() * source.Channels();
+	const int filterCount = desc.Filter.ObjectCount();
+
+	const int tileRows = ( result.Height() + 1 ) / 2;
+	const int tileColumns = ( result.Width() + 1 ) / 2;
+	const int objectTileCount = tileRows * tileColumns;
+	const int tileCount = result.ObjectCount() * objectTileCount;
+
+	const int curThreadCount = IsOmpRelevant( tileCount,
+		static_cast<int64_t>( result.BlobSize() ) * desc.Filter.ObjectSize() ) ? threadCount : 1;
+	// The number of tiles processed at once: the transformed data should fit into the cache
+	const int cacheTileCount = max( 1, min( BlobConvolutionCacheSize / ( tileSize * ( channels + filterCount ) ),
+		( tileCount + curThreadCount - 1 ) / curThreadCount ) );
+	// The transformed input, the products and a zero vector that emulates padding
+	const int threadDataSize = tileSize * cacheTileCount * ( channels + filterCount ) + channels;
+
+	CFloatHandleStackVar tempData( mathEngine(), curThreadCount * threadDataSize );
+	float* tempDataRaw = GetRaw( tempData.GetHandle() );
+
+	ParallelRun( *threadPool, curThreadCount, [&] {
+		float* transformedInput = tempDataRaw + OmpGetThreadNum() * threadDataSize;
+		float* products = transformedInput + tileSize * cacheTileCount * channels;
+		float* zeros = products + tileSize * cacheTileCount * filterCount;
+		vectorFill( zeros, 0.f, channels );
+
+		int start;
+		int count;
+		if( !OmpGetTaskIndexAndCount( tileCount, start, count ) ) {
+			return;
+		}
+
+		for( int index = 0; index < count; index += cacheTileCount ) {
+			const int size = min( count - index, cacheTileCount );
+
+			// Transform the input
+			for( int tile = 0; tile < size; ++tile ) {
+				const int batch = ( start + index + tile ) / objectTileCount;
+				const int tileRow = ( start + index + tile ) % objectTileCount / tileColumns;
+				const int tileColumn = ( start + index + tile ) % tileColumns;
+				const float* sourceObject = sourceData + batch * source.ObjectSize();
+
+				const float* d[4][4];
+				for( int i = 0; i < 4; ++i ) {
+					const int row = tileRow * 2 - desc.PaddingHeight + i;
+					for( int j = 0; j < 4; ++j ) {
+						const int column = tileColumn * 2 - desc.PaddingWidth + j;
+						d[i][j] = ( row < 0 || row >= source.Height() || column < 0 || column >= source.Width() ) ? zeros
+							: sourceObject + ( row * source.Width() + column ) * channels;
+					}
+				}
+
+				float* v = transformedInput + tile * channels;
+				const int vStep = cacheTileCount * channels;
+				for( int c = 0; c < channels; ++c ) {
+					// t = B^T * d
+					float t[4][4];
+					for( int j = 0; j < 4; ++j ) {
+						t[0][j] = d[0][j][c] - d[2][j][c];
+						t[1][j] = d[1][j][c] + d[2][j][c];
+						t[2][j] = d[2][j][c] - d[1][j][c];
+						t[3][j] = d[1][j][c] - d[3][j][c];
+					}
+					// v = t * B
+					for( int i = 0; i < 4; ++i ) {
+						v[( i * 4 + 0 ) * vStep + c] = t[i][0] - t[i][2];
+						v[( i * 4 + 1 ) * vStep + c] = t[i][1] + t[i][2];
+						v[( i * 4 + 2 ) * vStep + c] = t[i][2] - t[i][1];
+						v[( i * 4 + 3 ) * vStep + c] = t[i][1] - t[i][3];
+					}
+				}
+			}
+
+			// Multiply the transformed input by the transformed filter
+			for( int i = 0; i < tileSize; ++i ) {
+				multiplyMatrixByTransposedMatrix( transformedInput + i * cacheTileCount * channels, size, channels, channels,
+					winogradFilter + i * filterCount * channels, filterCount, channels,
+					products + i * cacheTileCount * filterCount, filterCount );
+			}
+
+			// Transform the products back into the result
+			for( int tile = 0; tile < size; ++tile ) {
+				const int batch = ( start + index + tile ) / objectTileCount;
+				const int row = ( start + index + tile ) % objectTileCount / tileColumns * 2;
+				const int column = ( start + index + tile ) % tileColumns * 2;
+				const bool hasSecondRow = row + 1 < result.Height();
+				const bool hasSecondColumn = column + 1 < result.Width();
+				float* resultPtr = resultData + batch * result.ObjectSize() + ( row * result.Width() + column ) * filterCount;
+
+				const float* m = products + tile * filterCount;
+				const int mStep = cacheTileCount * filterCount;
+				for( int k = 0; k < filterCount; ++k ) {
+					// s = A^T * m
+					float s[2][4];
+					for( int j = 0; j < 4; ++j ) {
+						s[0][j] = m[j * mStep + k] + m[( 4 + j ) * mStep + k] + m[( 8 + j ) * mStep + k];
+						s[1][j] = m[( 4 + j ) * mStep + k] - m[( 8 + j ) * mStep + k] - m[( 12 + j ) * mStep + k];
+					}
+					const float freeTerm = freeTermData == nullptr ? 0.f : freeTermData[k];
+					// y = s * A
+					resultPtr[k] = s[0][0] + s[0][1] + s[0][2] + freeTerm;
+					if( hasSecondColumn ) {
+						resultPtr[filterCount + k] = s[0][1] - s[0][2] - s[0][3] + freeTerm;
+					}
+					if( hasSecondRow ) {
+						resultPtr[result.Width() * filterCount + k] = s[1][0] + s[1][1] + s[1][2] + freeTerm;
+						if( hasSecondColumn ) {
+							resultPtr[( result.Width() + 1 ) * filterCount + k] = s[1][1] - s[1][2] - s[1][3] + freeTerm;
+						}
+					}
+				}
+
+				if( !activation.IsIdentity() ) {
+					// The tile rows are contiguous in the result
+					const int tileRowSize = ( hasSecondColumn ? 2 : 1 ) * filterCount;
+					applyActivation( activation, resultPtr, tileRowSize );
+					if( hasSecondRow ) {
+						applyActivation( activation, resultPtr + result.Width() * filterCount, tileRowSize );
+					}
+				}
+			}
+		}
+	} );
 }
 
 void CCpuMathEngine::BlobConvolution( const CConvolutionDesc& convDesc, const CFloatHandle& source,
 	const CFloatHandle& filter, const CFloatHandle* freeTerm, const CFloatHandle& result )
+{
+	BlobConvolution( convDesc, source, filter, freeTerm, CActivationInfo(), result );
+}
+
+void CCpuMathEngine::BlobConvolution( const CConvolutionDesc& convDesc, const CFloatHandle& source,
+	const CFloatHandle& filter, const CFloatHandle* freeTerm, const CActivationInfo& activation, const CFloatHandle& result )
 {
 	const float* sourceRaw = GetRaw( source );
 	const float* filterRaw = GetRaw( filter );
@@ -515,7 +740,7 @@ void CCpuMathEngine::BlobConvolution( const CConvolutionDesc& convDesc, const CF
 	const CCpuConvolutionDesc& desc = static_cast<const CCpuConvolutionDesc&>( convDesc );
 
 	if( desc.SimdConvolutionDesc != nullptr ) {
-		simdMathEngine->BlobConvolution( *desc.SimdConvolutionDesc, sourceRaw, filterRaw, freeTermRaw, resultRaw );
+		simdMathEngine->BlobConvolution( *desc.SimdConvolutionDesc, sourceRaw, filterRaw, freeTermRaw, activation, resultRaw );
 		return;
 	}
 
@@ -531,18 +756,21 @@ void CCpuMathEngine::BlobConvolution( const CConvolutionDesc& convDesc, const CF
 			const int64_t algo1DataSize = static_cast<int64_t>( desc.Result.Width() ) * desc.Result.Height() * desc.Filter.ObjectSize() + desc.Result.ObjectSize();
 
 			if( min( desc.Result.ObjectCount(), algo1ThreadCount ) * algo1DataSize <= algo0ThreadCount * BlobConvolutionCacheSize ) {
-				blobConvolutionForwardAlgo1( desc, sourceRaw, filterRaw, freeTerm, resultRaw );
+				blobConvolutionForwardAlgo1( desc, sourceRaw, filterRaw, freeTerm, activation, resultRaw );
 			} else {
-				blobConvolutionForwardAlgo0( desc, sourceRaw, filterRaw, freeTerm, resultRaw );
+				blobConvolutionForwardAlgo0( desc, sourceRaw, filterRaw, freeTerm, activation, resultRaw );
 			}
 			break;
 		}
+		case CA_Winograd:
+			blobConvolutionForwardWinograd( desc, sourceRaw, filterRaw, freeTermRaw, activation, resultRaw );
+			break;
 		case CA_1x1:
 			{
 				bool needsFlatten = desc.Source.Depth() != 1;
 
 				blob3dConvolution1x1x1( needsFlatten ? flatten( desc.Source ) : desc.Source, needsFlatten ? flatten( desc.Filter ) : desc.Filter,
-					desc.Result, desc.StrideHeight, desc.StrideWidth, 1, sourceRaw, filterRaw, freeTermRaw, resultRaw );
+					desc.Result, desc.StrideHeight, desc.StrideWidth, 1, sourceRaw, filterRaw, freeTermRaw, activation, resultRaw );
 				break;
 			}
 		default:
@@ -550,6 +778,68 @@ void CCpuMathEngine::BlobConvolution( const CConvolutionDesc& convDesc, const CF
 	}
 }
 
+void CCpuMathEngine::BlobQuantizedConvolution( const CConvolutionDesc& convDesc, const CConstFloatHandle& source,
+	float sourceScale, int sourceZeroPoint, const CConstInt8Handle& filter, const CConstFloatHandle& filterScales,
+	const CConstFloatHandle* freeTerm, const CActivationInfo& activation, const CFloatHandle& result )
+{
+	ASSERT_EXPR( sourceScale > 0 );
+	ASSERT_EXPR( 0 <= sourceZeroPoint && sourceZeroPoint <= 255 );
+
+	const CCpuConvolutionDesc& desc = static_cast<const CCpuConvolutionDesc&>( convDesc );
+
+	const float* sourceRaw = GetRaw( source );
+	const signed char* filterRaw = GetRaw( filter );
+	const float* filterScalesRaw = GetRaw( filterScales );
+	const float* freeTermRaw = freeTerm != nullptr ? GetRaw( *freeTerm ) : nullptr;
+	float* resultRaw = GetRaw( result );
+
+	// The same scheme as in blobConvolutionForwardAlgo0 is used
+	// but the temporary data is quantized before the multiplication
+	const int resultItemCount = desc.Result.ObjectCount() * desc.Result.Width() * desc.Result.Height();
+	const int curThreadCount = IsOmpRelevant( resultItemCount, static_cast< int64_t >( desc.Result.BlobSize() ) * desc.Filter.ObjectSize() ) ? threadCount : 1;
+	const int cacheItemCount = max( 1, min( ceilTo( BlobConvolutionCacheSize / desc.Filter.ObjectSize(), 16 ), resultItemCount / curThreadCount ) );
+	const int tempDataSize = curThreadCount * cacheItemCount * desc.Filter.ObjectSize();
+
+	CFloatHandleStackVar tempData( mathEngine(), tempDataSize );
+	float* tempDataRaw = GetRaw( tempData.GetHandle() );
+	CMemoryHandleStackVar<short> quantizedData( mathEngine(), tempDataSize );
+	short* quantizedDataRaw = GetRaw( quantizedData.GetHandle() );
+
+	ParallelRun( *threadPool, curThreadCount, [&] {
+		const int filterObjectCount = desc.Filter.ObjectCount();
+		const int filterObjectSize = desc.Filter.ObjectSize();
+		float* tempDataPtr = tempDataRaw + OmpGetThreadNum() * cacheItemCount * filterObjectSize;
+		short* quantizedDataPtr = quantizedDataRaw + OmpGetThreadNum() * cacheItemCount * filterObjectSize;
+
+		int start;
+		int count;
+		if( OmpGetTaskIndexAndCount( resultItemCount, start, count ) ) {
+			int index = 0;
+			while( index < count ) {
+				const int size = min( count - index, cacheItemCount );
+
+				fillTempData( sourceRaw, tempDataPtr, desc, start + index, size );
+				quantizeWithZeroPoint( tempDataPtr, size * filterObjectSize, sourceScale, sourceZeroPoint, quantizedDataPtr );
+
+				float* resultDataPtr = resultRaw + ( start + index ) * filterObjectCount;
+
+				multiplyMatrixByTransposedQuantizedMatrix( quantizedDataPtr, size, filterObjectSize, sourceScale,
+					filterRaw, filterScalesRaw, filterObjectCount, resultDataPtr, filterObjectCount );
+
+				if( freeTermRaw != nullptr ) {
+					addVectorToMatrixRows( resultDataPtr, resultDataPtr, size, filterObjectCount, filterObjectCount,
+						filterObjectCount, freeTermRaw );
+				}
+				if( !activation.IsIdentity() ) {
+					applyActivation( activation, resultDataPtr, size * filterObjectCount );
+				}
+
+				index += size;
+			}
+		}
+	} );
+}
+
 void CCpuMathEngine::backwardConvolutionAddFilterToOutput( const CCpuConvolutionDesc& desc, const CFloatHandle& temp,
 	const CFloatHandle* freeTermData, const CFloatHandle& outputData )
 {
@@ -735,8 +1025,7 @@ void CCpuMathEngine::blobConvolutionBackwardAlgo1( const CCpuConvolutionDesc& de
 	const int curThreadCount = IsOmpRelevant( result.ObjectCount() * result.Height(),
 		static_cast<int64_t>( source.BlobSize() ) * filter.BlobSize() ) ? threadCount : 1;
 
-	NEOML_OMP_NUM_THREADS( curThreadCount )
-	{
+	ParallelRun( *threadPool, curThreadCount, [&] {
 		// Step 1: multiply the input and filter matrices
 		int inputStart;
 		int inputCount;
@@ -746,18 +1035,17 @@ void CCpuMathEngine::blobConvolutionBackwardAlgo1( const CCpuConvolutionDesc& de
 				filterForwardRaw, filterForwardGeometricalSize, filterForwardChannelsCount,
 				tempRaw + inputStart * tempWidth, filterForwardGeometricalSize );
 		}
+	} );
 
-		if( curThreadCount > 1 ) {
-			#pragma omp barrier
-		}
-
+	// Step 2 reads the temp rows calculated by other threads, so it must start after step 1 is finished
+	ParallelRun( *threadPool, curThreadCount, [&] {
 		// Step 2: add the subvectors from the resulting matrix to the required positions in the output
 		if( desc.DilationHeight > 1 || desc.DilationWidth > 1 ) {
 			backwardDilationConvolutionAddFilterToOutput( desc, temp.GetHandle(), freeTerm, resultData );
 		} else {
 			backwardConvolutionAddFilterToOutput( desc, temp.GetHandle(), freeTerm, resultData );
 		}
-	}
+	} );
 }
 
 // Creates a temporary outputDiff blob using the #2 algorithm
@@ -838,8 +1126,7 @@ void CCpuMathEngine::blobConvolutionBackwardAlgo2( const CCpuConvolutionDesc& de
 
 	const int curThreadCount = IsOmpRelevant(batchSize) ? threadCount : 1;
 
-	NEOML_OMP_FOR_NUM_THREADS( curThreadCount )
-	for( int j = 0; j < batchSize; j++ ) {
+	ParallelFor( *threadPool, curThreadCount, batchSize, [&]( int j ) {
 		CFloatHandle inputDiffStart = inputDiffData + j * inputDiff.ObjectSize();
 		if( freeTermData != nullptr ) {
 			setVectorToMatrixRows( GetRaw( inputDiffStart ), inputDiff.Height() * inputDiff.Width(),
@@ -864,7 +1151,7 @@ void CCpuMathEngine::blobConvolutionBackwardAlgo2( const CCpuConvolutionDesc& de
 			inputDiffStart += inputDiff.Width() * inputDiff.Depth() * inputDiff.Channels();
 			filterStart += tempFilterObjectSize;
 		}
-	}
+	} );
 }
 
 void CCpuMathEngine::BlobConvolutionBackward( const CConvolutionDesc& convDesc, const CFloatHandle& outputDiffData,
@@ -929,8 +1216,7 @@ void CCpuMathEngine::blobConvolutionLearnAlgo1( const CCpuConvolutionDesc& desc,
 		freeTermDiffReduction.reset( new COmpReduction<COmpReduction1DData>( curThreadCount, *freeTermDiffItem ) );
 	}
 
-	NEOML_OMP_FOR_NUM_THREADS( curThreadCount )
-	for(int b = 0; b < objectCount; ++b) {
+	ParallelFor( *threadPool, curThreadCount, objectCount, [&]( int b ) {
 		float* tempBlobHolderDataRaw = GetRaw( tempBlobHolder.GetPrivateData() );
 		float* outputDiffTransDataRaw = GetRaw( outputDiffTrans.GetPrivateData() );
 		float* outputTempDataRaw = GetRaw( outputTemp.GetPrivateData() );
@@ -979,7 +1265,7 @@ void CCpuMathEngine::blobConvolutionLearnAlgo1( const CCpuConvolutionDesc& desc,
 				}
 			}
 		}
-	}
+	} );
 
 	if( freeTermDiffData != nullptr ) {
 		freeTermDiffReduction->Reduce();
@@ -1022,8 +1308,7 @@ void CCpuMathEngine::blobConvolutionLearnAlgo2( const CCpuConvolutionDesc& desc,
 		freeTermDiffReduction.reset( new COmpReduction<COmpReduction1DData>( curThreadCount, *freeTermDiffItem ) );
 	}
 
-	NEOML_OMP_FOR_NUM_THREADS( curThreadCount )
-	for( int j = 0; j < objectCount; ++j ) {
+	ParallelFor( *threadPool, curThreadCount, objectCount, [&]( int j ) {
 		// filter diff
 		float* filterMatrix = GetRaw( filterDiffReduction.GetPrivate().Data );
 		for( int h = 0; h < filterDiff.Height(); ++h ) {
@@ -1065,7 +1350,7 @@ void CCpuMathEngine::blobConvolutionLearnAlgo2( const CCpuConvolutionDesc& desc,
 				}
 			}
 		}
-	}
+	} );
 
 	filterDiffReduction.Reduce();
 
@@ -1158,8 +1443,7 @@ void CCpuMathEngine::BlobChannelwiseConvolutionBackward( const CChannelwiseConvo
 	COmpPrivate1DData temp( curThreadCount, mathEngine(), inputGeo * filterGeo * input.Channels() );
 	COmpPrivate2DData outputRepacked( curThreadCount, mathEngine(), output.Height() * output.Width(), output.Channels() );
 
-	NEOML_OMP_FOR_NUM_THREADS( curThreadCount )
-	for( int batchIndex = 0; batchIndex < input.BatchWidth(); ++batchIndex ) {
+	ParallelFor( *threadPool, curThreadCount, input.BatchWidth(), [&]( int batchIndex ) {
 		float* inputRepackedDataRaw = GetRaw( inputRepacked.GetPrivateData() );
 		float* outputRepackedDataRaw = GetRaw( outputRepacked.GetPrivateData() );
 		// Repack HWC -> CHW
@@ -1229,7 +1513,7 @@ void CCpuMathEngine::BlobChannelwiseConvolutionBackward( const CChannelwiseConvo
 		transposeMatrix( 1, outputRepackedDataRaw,
 			outputRepacked.GetWidth(), 1, outputRepacked.GetHeight(), 1,
 			outputDiffDataRaw + batchIndex * outputBatch );
-	}
+	} );
 }
 
 void CCpuMathEngine::BlobChannelwiseConvolutionLearnAdd( const CChannelwiseConvolutionDesc& convDesc, const CFloatHandle& inputData,
@@ -1275,8 +1559,7 @@ void CCpuMathEngine::BlobChannelwiseConvolutionLearnAdd( const CChannelwiseConvo
 		freeTermDiffReduction.reset( new COmpReduction<COmpReduction1DData>( curThreadCount, *freeTermDiffItem ) );
 	}
 
-	NEOML_OMP_NUM_THREADS( curThreadCount )
-	{
+	ParallelRun( *threadPool, curThreadCount, [&] {
 		int batchStart;
 		int batchCount;
 		if( OmpGetTaskIndexAndCount( outputDiff.BatchWidth(), batchStart, batchCount ) ) {
@@ -1321,7 +1604,7 @@ void CCpuMathEngine::BlobChannelwiseConvolutionLearnAdd( const CChannelwiseConvo
 				}
 			}
 		}
-	}
+	} );
 
 	if( freeTermDiffData != nullptr ) {
 		freeTermDiffReduction->Reduce();
@@ -219,8 +219,7 @@ void CCpuMathEngine::BlobRleConvolution( const CRleConvolutionDesc& convDesc, co
 
 	const int curThreadCount = IsOmpRelevant( objectCount ) ? threadCount : 1;
 
-	NEOML_OMP_FOR_NUM_THREADS( curThreadCount )
-	for( int b = 0; b < objectCount; ++b ) {
+	ParallelFor( *threadPool, curThreadCount, objectCount, [&]( int b ) {
 		const CRleImage* inputImage = reinterpret_cast<CRleImage*>( GetRaw( sourceData + source.ObjectSize() * b ) );
 		int imageStartPos = ( source.Width() - inputImage->Width ) / 2;
 		int imageStartLine = ( source.Height() - inputImage->Height ) / 2;
@@ -273,7 +272,7 @@ void CCpuMathEngine::BlobRleConvolution( const CRleConvolutionDesc& convDesc, co
 				output += filterCount;
 			}
 		}
-	}
+	} );
 }
 
 void CCpuMathEngine::BlobRleConvolutionLearnAdd( const CRleConvolutionDesc& convDesc, const CFloatHandle& inputData,
@@ -323,8 +322,7 @@ void CCpuMathEngine::BlobRleConvolutionLearnAdd( const CRleConvolutionDesc& conv
 	float* multsPtr = GetRaw( mults.GetHandle() );
 	const float* outputDiffDataRaw = GetRaw( outputDiffData );
 
-	NEOML_OMP_FOR_NUM_THREADS( curThreadCount )
-	for( int b = 0; b < objectCount; ++b ) {
+	ParallelFor( *threadPool, curThreadCount, objectCount, [&]( int b ) {
 		const CRleImage* inputImage = reinterpret_cast<CRleImage*>( GetRaw( inputData + input.ObjectSize() * b ) );
 		int imageStartPos = ( input.Width() - inputImage->Width ) / 2;
 		int imageStartLine = ( input.Height() - inputImage->Height ) / 2;
@@ -384,7 +382,7 @@ void CCpuMathEngine::BlobRleConvolutionLearnAdd( const CRleConvolutionDesc& conv
 				}
 			}
 		}
-	}
+	} );
 
 	if( freeTermDiffData != 0 ) {
 		freeTermDiffReduction->Reduce();
@@ -75,8 +75,7 @@ void CCpuMathEngine::BlobTimeConvolution( const CTimeConvolutionDesc& convDesc,
 
 	const int curThreadCount = IsOmpRelevant( result.BatchLength() ) ? threadCount : 1;
 
-	NEOML_OMP_FOR_NUM_THREADS( curThreadCount )
-	for( int outSeqNum = 0; outSeqNum < result.BatchLength(); ++outSeqNum ) {
+	ParallelFor( *threadPool, curThreadCount, result.BatchLength(), [&]( int outSeqNum ) {
 		int filterRowStart = 0;
 		int inputRowStart = outSeqNum * desc.Stride - desc.PaddingFront;
 		if( inputRowStart < 0 ) {
@@ -105,7 +104,7 @@ void CCpuMathEngine::BlobTimeConvolution( const CTimeConvolutionDesc& convDesc,
 			multiplyMatrixByTransposedMatrixAndAdd( inputPtr, source.BatchWidth(), inputObjectSize, inputObjectSize,
 				filterPtr, filter.BatchWidth(), filterDataSize, outputPtr, outputObjectSize );
 		}
-	}
+	} );
 
 	AddVectorToMatrixRows( 1, resultData, resultData, result.ObjectCount(), result.ObjectSize(), freeTermData );
 }
@@ -135,8 +134,7 @@ void CCpuMathEngine::BlobTimeConvolutionBackward( const CTimeConvolutionDesc& co
 
 	const int curThreadCount = IsOmpRelevant( inputDiff.BatchLength() ) ? threadCount : 1;
 
-	NEOML_OMP_FOR_NUM_THREADS( curThreadCount )
-	for( int inSeqNum = 0; inSeqNum < inputDiff.BatchLength(); ++inSeqNum ) {
+	ParallelFor( *threadPool, curThreadCount, inputDiff.BatchLength(), [&]( int inSeqNum ) {
 		float* inputDiffDataPtr = inputDiffDataRaw + inSeqNum * inputRowSize;
 		vectorFill0( inputDiffDataPtr, inputObjectSize * inputDiff.BatchWidth() );
 
@@ -161,7 +159,7 @@ void CCpuMathEngine::BlobTimeConvolutionBackward( const CTimeConvolutionDesc& co
 				filterPtr, filter.Channels(), filterDataSize,
 				inputDiffDataPtr, inputObjectSize );
 		}
-	}
+	} );
 }
 
 void CCpuMathEngine::BlobTimeConvolutionLearnAdd( const CTimeConvolutionDesc& convDesc, const CFloatHandle& inputData,
@@ -188,8 +186,7 @@ void CCpuMathEngine::BlobTimeConvolutionLearnAdd( const CTimeConvolutionDesc& co
 
 	const int curThreadCount = IsOmpRelevant( outputDiff.BatchLength() ) ? threadCount : 1;
 
-	NEOML_OMP_FOR_NUM_THREADS( curThreadCount )
-	for( int outSeqNum = 0; outSeqNum < outputDiff.BatchLength(); ++outSeqNum ) {
+	ParallelFor( *threadPool, curThreadCount, outputDiff.BatchLength(), [&]( int outSeqNum ) {
 		const float* outputDiffPtr = outputDiffDataRaw +
 			outSeqNum * outputDiff.BatchWidth() * outputDiff.ObjectSize();
 		float* ompReductionPrivatePtr = GetRaw( ompReduction.GetPrivate().Data );
@@ -208,7 +205,7 @@ void CCpuMathEngine::BlobTimeConvolutionLearnAdd( const CTimeConvolutionDesc& co
 				inputPtr, filterDiff.Channels(), filterDiff.Channels(),
 				filterDiffPtr, filterDataSize );
 		}
-	}
+	} );
 
 	ompReduction.Reduce();
 
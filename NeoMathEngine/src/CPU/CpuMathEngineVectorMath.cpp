@@ -57,14 +57,13 @@ void CCpuMathEngine::VectorAdd(const CConstFloatHandle& firstHandle, const CCons
 
 	const int curThreadCount = IsOmpRelevant( vectorSize, vectorSize ) ? threadCount : 1;
 
-	NEOML_OMP_NUM_THREADS( curThreadCount )
-	{
+	ParallelRun( *threadPool, curThreadCount, [&] {
 		int index;
 		int count;
 		if( OmpGetTaskIndexAndCount( vectorSize, 16, index, count ) ) {
 			NeoML::vectorAdd( GetRaw(firstHandle + index), GetRaw(secondHandle + index), GetRaw(resultHandle + index), count );
 		}
-	}
+	} );
 }
 
 void CCpuMathEngine::VectorSum(const CConstFloatHandle& firstHandle, int vectorSize, const CFloatHandle& resultHandle)
@@ -27,12 +27,14 @@ limitations under the License.
 #include <MathEngineDnnConv.h>
 #include <CpuArmMathEngineVectorMathPrivate.h>
 #include <CpuArmMathEngineBlasPrivate.h>
+#include <CpuMathEngineActivation.h>
 
 namespace NeoML {
 
 void CCpuMathEngine::blob3dConvolution1x1x1( const CBlobDesc& source, const CBlobDesc& filter, const CBlobDesc& result,
 	int strideHeight, int strideWidth, int strideDepth,
-	const float* sourceData, const float* filterData, const float* freeTermData, float* resultData )
+	const float* sourceData, const float* filterData, const float* freeTermData,
+	const CActivationInfo& activation, float* resultData )
 {
 	static constexpr int goodDenominatorFirst = 8;
 	static constexpr int goodDenominatorSecond = 12;
@@ -47,8 +49,7 @@ void CCpuMathEngine::blob3dConvolution1x1x1( const CBlobDesc& source, const CBlo
 	if( strideHeight == 1 && strideWidth == 1 && strideDepth == 1) {
 		if( geomSize > newChannels ) {
 			// Split the first matrix by rows
-			NEOML_OMP_NUM_THREADS(IsOmpRelevant(geomSize, opCount) ? threadCount : 1)
-			{
+			ParallelRun( *threadPool, IsOmpRelevant(geomSize, opCount) ? threadCount : 1, [&] {
 				int geomStart;
 				int geomCount;
 				if( OmpGetTaskIndexAndCount(geomSize, goodDenominatorFirst, geomStart, geomCount) ) {
@@ -62,12 +63,14 @@ void CCpuMathEngine::blob3dConvolution1x1x1( const CBlobDesc& source, const CBlo
 						geomCount, channels, channels,
 						filterData, newChannels, channels,
 						outputDataPtr, newChannels);
+					if( !activation.IsIdentity() ) {
+						applyActivation( activation, outputDataPtr, geomCount * newChannels );
+					}
 				}
-			}
+			} );
 		} else {
 			// Split the second matrix by rows
-			NEOML_OMP_NUM_THREADS(IsOmpRelevant(newChannels, opCount) ? threadCount : 1)
-			{
+			ParallelRun( *threadPool, IsOmpRelevant(newChannels, opCount) ? threadCount : 1, [&] {
 				int channelStart;
 				int channelCount;
 				if( OmpGetTaskIndexAndCount(newChannels, goodDenominatorSecond, channelStart, channelCount) ) {
@@ -87,15 +90,17 @@ void CCpuMathEngine::blob3dConvolution1x1x1( const CBlobDesc& source, const CBlo
 						geomSize, channels, channels,
 						filterData + channelStart * channels, channelCount, channels,
 						resultData + channelStart, newChannels);
+					if( !activation.IsIdentity() ) {
+						applyActivation( activation, resultData + channelStart, geomSize, channelCount, newChannels );
+					}
 				}
-			}
+			} );
 		}
 	} else {
 		CFloatHandleVar repackedHolder(mathEngine(), geomSize * channels);
 		float* repackedData = GetRaw(repackedHolder.GetHandle());
 
-		NEOML_OMP_NUM_THREADS(IsOmpRelevant(geomSize, opCount) ? threadCount : 1)
-		{
+		ParallelRun( *threadPool, IsOmpRelevant(geomSize, opCount) ? threadCount : 1, [&] {
 			int geomStart;
 			int geomCount;
 			if( OmpGetTaskIndexAndCount(geomSize, geomStart, geomCount) ) {
@@ -125,8 +130,11 @@ void CCpuMathEngine::blob3dConvolution1x1x1( const CBlobDesc& source, const CBlo
 					geomCount, channels, channels,
 					filterData, newChannels, channels,
 					outputDataPtr, newChannels);
+				if( !activation.IsIdentity() ) {
+					applyActivation( activation, outputDataPtr, geomCount * newChannels );
+				}
 			}
-		}
+		} );
 	}
 }
 
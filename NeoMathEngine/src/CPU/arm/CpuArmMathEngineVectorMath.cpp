@@ -138,8 +138,7 @@ void CCpuMathEngine::VectorReLU(const CConstFloatHandle& firstHandle,
 
 	const int curThreadCount = IsOmpRelevant( vectorSize, vectorSize ) ? threadCount : 1;
 
-	NEOML_OMP_NUM_THREADS( curThreadCount )
-	{
+	ParallelRun( *threadPool, curThreadCount, [&] {
 		int index;
 		int count;
 		if( OmpGetTaskIndexAndCount( vectorSize, 16, index, count ) ) {
@@ -149,7 +148,7 @@ void CCpuMathEngine::VectorReLU(const CConstFloatHandle& firstHandle,
 				vectorReLU( first + index, result + index, count );
 			}
 		}
-	}
+	} );
 }
 
 void CCpuMathEngine::VectorEltwiseMax(const CConstFloatHandle& firstHandle, const CConstFloatHandle& secondHandle,
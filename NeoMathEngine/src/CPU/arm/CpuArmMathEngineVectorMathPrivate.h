@@ -18,6 +18,7 @@ limitations under the License.
 #pragma once
 
 #include <NeoMathEngine/NeoMathEngineDefs.h>
+#include <NeoMathEngine/NeoMathEngine.h>
 
 #ifdef NEOML_USE_NEON
 
@@ -482,6 +483,233 @@ inline void vectorDotProduct( const float* first, const float* second, int vecto
 	*result = vget_lane_f32(HorizontalAddNeon(acc), 0);
 }
 
+//------------------------------------------------------------------------------------------------------------
+// 8-bit quantized dot products
+
+inline int horizontalAddInt32( const int32x4_t& value )
+{
+	const int32x2_t sum = vadd_s32( vget_low_s32( value ), vget_high_s32( value ) );
+	return vget_lane_s32( vpadd_s32( sum, sum ), 0 );
+}
+
+// Multiplies 8 16-bit values by 8 8-bit values and adds the products to the 32-bit sums
+inline int32x4_t quantizedMultiplyAdd( const int32x4_t& sum, const int16x8_t& first, const signed char* second )
+{
+	const int16x8_t secondValue = vmovl_s8( vld1_s8( second ) );
+	const int32x4_t result = vmlal_s16( sum, vget_low_s16( first ), vget_low_s16( secondValue ) );
+	return vmlal_s16( result, vget_high_s16( first ), vget_high_s16( secondValue ) );
+}
+
+// Calculates the dot products of the 16-bit vector and four 8-bit vectors placed secondRowSize apart
+// The products are accumulated in 32-bit integers
+inline void quantizedDotProduct4( const short* first, const signed char* second, int secondRowSize,
+	int vectorSize, int* result )
+{
+	const signed char* second0 = second;
+	const signed char* second1 = second0 + secondRowSize;
+	const signed char* second2 = second1 + secondRowSize;
+	const signed char* second3 = second2 + secondRowSize;
+
+	int32x4_t sum0 = vdupq_n_s32( 0 );
+	int32x4_t sum1 = vdupq_n_s32( 0 );
+	int32x4_t sum2 = vdupq_n_s32( 0 );
+	int32x4_t sum3 = vdupq_n_s32( 0 );
+	int i = 0;
+	for( ; i + 8 <= vectorSize; i += 8 ) {
+		const int16x8_t firstValue = vld1q_s16( first + i );
+		sum0 = quantizedMultiplyAdd( sum0, firstValue, second0 + i );
+		sum1 = quantizedMultiplyAdd( sum1, firstValue, second1 + i );
+		sum2 = quantizedMultiplyAdd( sum2, firstValue, second2 + i );
+		sum3 = quantizedMultiplyAdd( sum3, firstValue, second3 + i );
+	}
+	result[0] = horizontalAddInt32( sum0 );
+	result[1] = horizontalAddInt32( sum1 );
+	result[2] = horizontalAddInt32( sum2 );
+	result[3] = horizontalAddInt32( sum3 );
+
+	for( ; i < vectorSize; ++i ) {
+		const int value = first[i];
+		result[0] += value * second0[i];
+		result[1] += value * second1[i];
+		result[2] += value * second2[i];
+		result[3] += value * second3[i];
+	}
+}
+
+// Calculates the dot product of the 16-bit vector and the 8-bit vector in 32-bit integers
+inline int quantizedDotProduct( const short* first, const signed char* second, int vectorSize )
+{
+	int32x4_t sum = vdupq_n_s32( 0 );
+	int i = 0;
+	for( ; i + 8 <= vectorSize; i += 8 ) {
+		sum = quantizedMultiplyAdd( sum, vld1q_s16( first + i ), second + i );
+	}
+	int result = horizontalAddInt32( sum );
+	for( ; i < vectorSize; ++i ) {
+		result += first[i] * second[i];
+	}
+	return result;
+}
+
+//------------------------------------------------------------------------------------------------------------
+// Optimizer steps
+
+// Fused Adam step (see IDnnEngine::AdamStep); secondMomentMax may be null
+inline void vectorAdamStep( const CAdamStepParams& params, const float* paramDiff, float* param, float* moment,
+	float* secondMoment, float* secondMomentMax, int vectorSize )
+{
+	const bool useL1 = params.L1Regularization > 0;
+	const bool useL2 = params.L2Regularization > 0;
+	const float opMomentDecayRate = 1 - params.MomentDecayRate;
+	const float opSecondMomentDecayRate = 1 - params.SecondMomentDecayRate;
+
+	int count = GetCount4( vectorSize );
+	if( count > 0 ) {
+		const float32x4_t l1 = vdupq_n_f32( params.L1Regularization );
+		const float32x4_t minusL1 = vdupq_n_f32( -params.L1Regularization );
+		const float32x4_t l2 = vdupq_n_f32( params.L2Regularization );
+		const float32x4_t momentDecayRate = vdupq_n_f32( params.MomentDecayRate );
+		const float32x4_t opMomentDecayRateNeon = vdupq_n_f32( opMomentDecayRate );
+		const float32x4_t secondMomentDecayRate = vdupq_n_f32( params.SecondMomentDecayRate );
+		const float32x4_t opSecondMomentDecayRateNeon = vdupq_n_f32( opSecondMomentDecayRate );
+		const float32x4_t gradientMult = vdupq_n_f32( params.GradientMult );
+		const float32x4_t momentMult = vdupq_n_f32( params.MomentMult );
+		const float32x4_t secondMomentMult = vdupq_n_f32( params.SecondMomentMult );
+		const float32x4_t epsilon = vdupq_n_f32( params.Epsilon );
+		const float32x4_t minusRate = vdupq_n_f32( -params.Rate );
+		CSqrtNeon sqrtObj;
+
+		for( int i = 0; i < count; ++i ) {
+			const float32x4_t paramNeon = LoadNeon4( param );
+			float32x4_t diff = LoadNeon4( paramDiff );
+			if( useL2 ) {
+				diff = MultiplyAndAddNeon( diff, paramNeon, l2 );
+			}
+			if( useL1 ) {
+				diff = vaddq_f32( diff, vminq_f32( l1, vmaxq_f32( minusL1, paramNeon ) ) );
+			}
+
+			const float32x4_t momentNeon = MultiplyAndAddNeon( vmulq_f32( LoadNeon4( moment ), momentDecayRate ),
+				diff, opMomentDecayRateNeon );
+			StoreNeon4( momentNeon, moment );
+			float32x4_t secondMomentNeon = MultiplyAndAddNeon( vmulq_f32( LoadNeon4( secondMoment ), secondMomentDecayRate ),
+				vmulq_f32( diff, diff ), opSecondMomentDecayRateNeon );
+			StoreNeon4( secondMomentNeon, secondMoment );
+			if( secondMomentMax != nullptr ) {
+				secondMomentNeon = vmaxq_f32( LoadNeon4( secondMomentMax ), secondMomentNeon );
+				StoreNeon4( secondMomentNeon, secondMomentMax );
+				secondMomentMax += 4;
+			}
+
+			const float32x4_t update = DivideNeon(
+				MultiplyAndAddNeon( vmulq_f32( diff, gradientMult ), momentNeon, momentMult ),
+				vaddq_f32( sqrtObj.Execute( vmulq_f32( secondMomentNeon, secondMomentMult ) ), epsilon ) );
+			StoreNeon4( MultiplyAndAddNeon( paramNeon, update, minusRate ), param );
+
+			paramDiff += 4;
+			param += 4;
+			moment += 4;
+			secondMoment += 4;
+		}
+	}
+
+	for( int i = 0; i < vectorSize; ++i ) {
+		float diff = paramDiff[i];
+		if( useL2 ) {
+			diff += params.L2Regularization * param[i];
+		}
+		if( useL1 ) {
+			diff += min( params.L1Regularization, max( -params.L1Regularization, param[i] ) );
+		}
+		moment[i] = moment[i] * params.MomentDecayRate + opMomentDecayRate * diff;
+		secondMoment[i] = secondMoment[i] * params.SecondMomentDecayRate + opSecondMomentDecayRate * ( diff * diff );
+		float denominator = secondMoment[i];
+		if( secondMomentMax != nullptr ) {
+			secondMomentMax[i] = max( secondMomentMax[i], secondMoment[i] );
+			denominator = secondMomentMax[i];
+		}
+		denominator = sqrtf( denominator * params.SecondMomentMult ) + params.Epsilon;
+		param[i] += -params.Rate * ( ( diff * params.GradientMult + moment[i] * params.MomentMult ) / denominator );
+	}
+}
+
+// Fused LAMB update (see IDnnEngine::LambUpdate)
+// The squared norms of the gradient, the parameters and the update are added to squaredNorms[0..2]
+inline void vectorLambUpdate( float gradientMult, float momentDecayRate, float secondMomentDecayRate, float epsilon,
+	float weightDecay, const float* paramDiff, const float* param, float* moment, float* secondMoment, float* update,
+	int vectorSize, float* squaredNorms )
+{
+	const float opMomentDecayRate = 1 - momentDecayRate;
+	const float opSecondMomentDecayRate = 1 - secondMomentDecayRate;
+
+	float diffNorm = 0;
+	float paramNorm = 0;
+	float updateNorm = 0;
+
+	int count = GetCount4( vectorSize );
+	if( count > 0 ) {
+		const float32x4_t gradientMultNeon = vdupq_n_f32( gradientMult );
+		const float32x4_t momentDecayRateNeon = vdupq_n_f32( momentDecayRate );
+		const float32x4_t opMomentDecayRateNeon = vdupq_n_f32( opMomentDecayRate );
+		const float32x4_t secondMomentDecayRateNeon = vdupq_n_f32( secondMomentDecayRate );
+		const float32x4_t opSecondMomentDecayRateNeon = vdupq_n_f32( opSecondMomentDecayRate );
+		const float32x4_t epsilonNeon = vdupq_n_f32( epsilon );
+		const float32x4_t weightDecayNeon = vdupq_n_f32( weightDecay );
+		CSqrtNeon sqrtObj;
+
+		float32x4_t diffNormNeon = vdupq_n_f32( 0 );
+		float32x4_t paramNormNeon = vdupq_n_f32( 0 );
+		float32x4_t updateNormNeon = vdupq_n_f32( 0 );
+
+		for( int i = 0; i < count; ++i ) {
+			const float32x4_t paramNeon = LoadNeon4( param );
+			const float32x4_t diff = vmulq_f32( LoadNeon4( paramDiff ), gradientMultNeon );
+			const float32x4_t diffSquare = vmulq_f32( diff, diff );
+
+			const float32x4_t momentNeon = MultiplyAndAddNeon( vmulq_f32( LoadNeon4( moment ), momentDecayRateNeon ),
+				diff, opMomentDecayRateNeon );
+			StoreNeon4( momentNeon, moment );
+			const float32x4_t secondMomentNeon = MultiplyAndAddNeon(
+				vmulq_f32( LoadNeon4( secondMoment ), secondMomentDecayRateNeon ), diffSquare, opSecondMomentDecayRateNeon );
+			StoreNeon4( secondMomentNeon, secondMoment );
+
+			const float32x4_t updateNeon = MultiplyAndAddNeon(
+				DivideNeon( momentNeon, vaddq_f32( sqrtObj.Execute( secondMomentNeon ), epsilonNeon ) ),
+				paramNeon, weightDecayNeon );
+			StoreNeon4( updateNeon, update );
+
+			diffNormNeon = vaddq_f32( diffNormNeon, diffSquare );
+			paramNormNeon = MultiplyAndAddNeon( paramNormNeon, paramNeon, paramNeon );
+			updateNormNeon = MultiplyAndAddNeon( updateNormNeon, updateNeon, updateNeon );
+
+			paramDiff += 4;
+			param += 4;
+			moment += 4;
+			secondMoment += 4;
+			update += 4;
+		}
+
+		diffNorm += vget_lane_f32( HorizontalAddNeon( diffNormNeon ), 0 );
+		paramNorm += vget_lane_f32( HorizontalAddNeon( paramNormNeon ), 0 );
+		updateNorm += vget_lane_f32( HorizontalAddNeon( updateNormNeon ), 0 );
+	}
+
+	for( int i = 0; i < vectorSize; ++i ) {
+		const float diff = paramDiff[i] * gradientMult;
+		moment[i] = moment[i] * momentDecayRate + opMomentDecayRate * diff;
+		secondMoment[i] = secondMoment[i] * secondMomentDecayRate + opSecondMomentDecayRate * ( diff * diff );
+		update[i] = moment[i] / ( sqrtf( secondMoment[i] ) + epsilon ) + weightDecay * param[i];
+
+		diffNorm += diff * diff;
+		paramNorm += param[i] * param[i];
+		updateNorm += update[i] * update[i];
+	}
+
+	squaredNorms[0] += diffNorm;
+	squaredNorms[1] += paramNorm;
+	squaredNorms[2] += updateNorm;
+}
+
 //------------------------------------------------------------------------------------------------------------
 
 // QRNN primitives
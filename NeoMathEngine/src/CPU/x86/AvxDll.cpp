@@ -114,11 +114,11 @@ void CAvxDll::Free()
 	}
 }
 
-ISimdMathEngine* CAvxDll::CreateSimdMathEngine( IMathEngine* mathEngine, int threadCount )
+ISimdMathEngine* CAvxDll::CreateSimdMathEngine( IMathEngine* mathEngine, IThreadPool* threadPool )
 {
 	ASSERT_EXPR( IsLoaded() );
 
-	ISimdMathEngine* simdMathEngine = createSimdMathEngineFunc( mathEngine, threadCount );
+	ISimdMathEngine* simdMathEngine = createSimdMathEngineFunc( mathEngine, threadPool );
 	ASSERT_EXPR( simdMathEngine != nullptr );
 	return simdMathEngine;
 }
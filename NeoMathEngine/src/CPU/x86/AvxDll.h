@@ -16,6 +16,7 @@ limitations under the License.
 #pragma once
 
 #include <NeoMathEngine/NeoMathEngineDefs.h>
+#include <NeoMathEngine/ThreadPool.h>
 
 #include <MathEngineDll.h>
 
@@ -36,11 +37,11 @@ public:
 	// Unloads the library
 	void Free();
 
-	ISimdMathEngine* CreateSimdMathEngine( IMathEngine* mathEngine, int threadCount );
+	ISimdMathEngine* CreateSimdMathEngine( IMathEngine* mathEngine, IThreadPool* threadPool );
 
 private:
 	constexpr static char const* CreateSimdMathEngineFuncName = "CreateSimdMathEngine";
-	typedef ISimdMathEngine* ( *CreateSimdMathEngineFunc )( IMathEngine* mathEngine, int threadCount );
+	typedef ISimdMathEngine* ( *CreateSimdMathEngineFunc )( IMathEngine* mathEngine, IThreadPool* threadPool );
 
 	CreateSimdMathEngineFunc createSimdMathEngineFunc;
 
@@ -0,0 +1,267 @@
+/* Copyright © 2017-2020 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <CpuX86Bf16MatrixMultiplying.h>
+
+#ifdef NEOML_USE_BF16_GEMM
+
+#include <immintrin.h>
+#include <cstdint>
+#include <algorithm>
+#include <NeoMathEngine/NeoMathEngine.h>
+#include <MemoryHandleInternal.h>
+
+// The whole file is compiled without the avx512 options,
+// so only the functions with this attribute may use the avx512 instructions
+#define NEOML_BF16_TARGET __attribute__(( target( "avx512f,avx512bw,avx512bf16" ) ))
+
+namespace NeoML {
+
+// The matrices are multiplied by blocks: BlockDepth elements of the k dimension
+// and BlockHeight rows of the result at a time
+static const size_t BlockDepth = 512;
+static const size_t BlockHeight = 128;
+// The micro-kernel calculates KernelHeight * KernelWidth block of the result
+static const size_t KernelHeight = 8;
+static const size_t KernelWidth = 32;
+// Both packed matrices may be written up to 16 elements beyond their size
+static const size_t PackedSlack = 16;
+
+// The packed matrices contain the pairs of bfloat16 values that are neighbours along the k dimension
+// (in one 32-bit element), as vdpbf16ps expects them.
+// The packed A contains the rows of op(A): packedA[row * pairCount + pair]
+// The packed B contains the columns of op(B) by KernelWidth: packedB[pair * KernelWidth + column]
+
+static inline __mmask16 tailMask( size_t count )
+{
+	return count >= 16 ? static_cast<__mmask16>( 0xFFFF ) : static_cast<__mmask16>( ( 1u << count ) - 1 );
+}
+
+// Converts 32 consecutive floats (16 in each argument) into 16 pairs
+NEOML_BF16_TARGET
+static inline __m512i convertToPairs( __m512 low, __m512 high )
+{
+	return reinterpret_cast<__m512i>( _mm512_cvtne2ps_pbh( high, low ) );
+}
+
+// Converts two vectors into 16 pairs, each one with the elements from the first and the second vector
+NEOML_BF16_TARGET
+static inline __m512i interleaveToPairs( __m512 first, __m512 second )
+{
+	const __m512i index = _mm512_set_epi16( 31, 15, 30, 14, 29, 13, 28, 12, 27, 11, 26, 10, 25, 9, 24, 8,
+		23, 7, 22, 6, 21, 5, 20, 4, 19, 3, 18, 2, 17, 1, 16, 0 );
+	return _mm512_permutexvar_epi16( index, convertToPairs( first, second ) );
+}
+
+// Packs rowCount rows of op(A) starting from the given one and depth elements of k starting from kStart
+NEOML_BF16_TARGET
+static void packA( bool transA, const float* a, size_t aRowSize, size_t rowStart, size_t rowCount,
+	size_t kStart, size_t depth, uint32_t* packed )
+{
+	const size_t pairCount = ( depth + 1 ) / 2;
+	if( !transA ) {
+		for( size_t row = 0; row < rowCount; ++row ) {
+			const float* source = a + ( rowStart + row ) * aRowSize + kStart;
+			uint32_t* result = packed + row * pairCount;
+			// The values beyond depth are zeros; they may overwrite the beginning of the next row,
+			// which is packed later
+			for( size_t i = 0; i < depth; i += 32 ) {
+				const __m512 low = _mm512_maskz_loadu_ps( tailMask( depth - i ), source + i );
+				const __m512 high = depth - i > 16 ? _mm512_maskz_loadu_ps( tailMask( depth - i - 16 ), source + i + 16 )
+					: _mm512_setzero_ps();
+				_mm512_storeu_si512( result + i / 2, convertToPairs( low, high ) );
+			}
+		}
+	} else {
+		// op(A)[row][i] is a[i * aRowSize + row]
+		alignas( 64 ) uint32_t pairs[16];
+		for( size_t pair = 0; pair < pairCount; ++pair ) {
+			const float* first = a + ( kStart + 2 * pair ) * aRowSize + rowStart;
+			const bool hasSecond = 2 * pair + 1 < depth;
+			for( size_t row = 0; row < rowCount; row += 16 ) {
+				const __mmask16 mask = tailMask( rowCount - row );
+				const __m512 firstValues = _mm512_maskz_loadu_ps( mask, first + row );
+				const __m512 secondValues = hasSecond ? _mm512_maskz_loadu_ps( mask, first + aRowSize + row )
+					: _mm512_setzero_ps();
+				_mm512_store_si512( pairs, interleaveToPairs( firstValues, secondValues ) );
+				const size_t count = std::min<size_t>( 16, rowCount - row );
+				for( size_t i = 0; i < count; ++i ) {
+					packed[( row + i ) * pairCount + pair] = pairs[i];
+				}
+			}
+		}
+	}
+}
+
+// Packs columnCount (not more than KernelWidth) columns of op(B) starting from the given one
+// and depth elements of k starting from kStart; the rest of KernelWidth columns are filled with zeros
+NEOML_BF16_TARGET
+static void packB( bool transB, const float* b, size_t bRowSize, size_t columnStart, size_t columnCount,
+	size_t kStart, size_t depth, uint32_t* packed )
+{
+	const size_t pairCount = ( depth + 1 ) / 2;
+	if( !transB ) {
+		for( size_t pair = 0; pair < pairCount; ++pair ) {
+			const float* first = b + ( kStart + 2 * pair ) * bRowSize + columnStart;
+			const bool hasSecond = 2 * pair + 1 < depth;
+			for( size_t column = 0; column < KernelWidth; column += 16 ) {
+				const __mmask16 mask = column < columnCount ? tailMask( columnCount - column ) : 0;
+				const __m512 firstValues = _mm512_maskz_loadu_ps( mask, first + column );
+				const __m512 secondValues = hasSecond ? _mm512_maskz_loadu_ps( mask, first + bRowSize + column )
+					: _mm512_setzero_ps();
+				_mm512_storeu_si512( packed + pair * KernelWidth + column, interleaveToPairs( firstValues, secondValues ) );
+			}
+		}
+	} else {
+		// op(B)[i][column] is b[column * bRowSize + i]
+		alignas( 64 ) uint32_t pairs[16];
+		for( size_t column = 0; column < KernelWidth; ++column ) {
+			if( column >= columnCount ) {
+				for( size_t pair = 0; pair < pairCount; ++pair ) {
+					packed[pair * KernelWidth + column] = 0;
+				}
+				continue;
+			}
+			const float* source = b + ( columnStart + column ) * bRowSize + kStart;
+			for( size_t i = 0; i < depth; i += 32 ) {
+				const __m512 low = _mm512_maskz_loadu_ps( tailMask( depth - i ), source + i );
+				const __m512 high = depth - i > 16 ? _mm512_maskz_loadu_ps( tailMask( depth - i - 16 ), source + i + 16 )
+					: _mm512_setzero_ps();
+				_mm512_store_si512( pairs, convertToPairs( low, high ) );
+				const size_t count = std::min<size_t>( 16, pairCount - i / 2 );
+				for( size_t pair = 0; pair < count; ++pair ) {
+					packed[( i / 2 + pair ) * KernelWidth + column] = pairs[pair];
+				}
+			}
+		}
+	}
+}
+
+// Adds the product of Rows rows of the packed A and the packed B to the result
+template<int Rows>
+NEOML_BF16_TARGET
+static void multiplyKernel( const uint32_t* packedA, size_t pairCount, const uint32_t* packedB,
+	float* c, size_t cRowSize, __mmask16 firstMask, __mmask16 secondMask )
+{
+	__m512 first[Rows];
+	__m512 second[Rows];
+	for( int row = 0; row < Rows; ++row ) {
+		first[row] = _mm512_setzero_ps();
+		second[row] = _mm512_setzero_ps();
+	}
+
+	for( size_t pair = 0; pair < pairCount; ++pair ) {
+		const __m512bh firstB = reinterpret_cast<__m512bh>( _mm512_loadu_si512( packedB ) );
+		const __m512bh secondB = reinterpret_cast<__m512bh>( _mm512_loadu_si512( packedB + 16 ) );
+		packedB += KernelWidth;
+		for( int row = 0; row < Rows; ++row ) {
+			const __m512bh a = reinterpret_cast<__m512bh>( _mm512_set1_epi32( static_cast<int>( packedA[row * pairCount + pair] ) ) );
+			first[row] = _mm512_dpbf16_ps( first[row], a, firstB );
+			second[row] = _mm512_dpbf16_ps( second[row], a, secondB );
+		}
+	}
+
+	for( int row = 0; row < Rows; ++row ) {
+		float* result = c + row * cRowSize;
+		_mm512_mask_storeu_ps( result, firstMask, _mm512_add_ps( _mm512_maskz_loadu_ps( firstMask, result ), first[row] ) );
+		_mm512_mask_storeu_ps( result + 16, secondMask,
+			_mm512_add_ps( _mm512_maskz_loadu_ps( secondMask, result + 16 ), second[row] ) );
+	}
+}
+
+NEOML_BF16_TARGET
+static void multiplyRows( const uint32_t* packedA, size_t rowCount, size_t pairCount, const uint32_t* packedB,
+	float* c, size_t cRowSize, size_t columnCount )
+{
+	const __mmask16 firstMask = tailMask( columnCount );
+	const __mmask16 secondMask = columnCount > 16 ? tailMask( columnCount - 16 ) : 0;
+
+	size_t row = 0;
+	for( ; row + KernelHeight <= rowCount; row += KernelHeight ) {
+		multiplyKernel<KernelHeight>( packedA + row * pairCount, pairCount, packedB, c + row * cRowSize, cRowSize,
+			firstMask, secondMask );
+	}
+
+	packedA += row * pairCount;
+	c += row * cRowSize;
+	switch( rowCount - row ) {
+		case 7:
+			multiplyKernel<7>( packedA, pairCount, packedB, c, cRowSize, firstMask, secondMask );
+			break;
+		case 6:
+			multiplyKernel<6>( packedA, pairCount, packedB, c, cRowSize, firstMask, secondMask );
+			break;
+		case 5:
+			multiplyKernel<5>( packedA, pairCount, packedB, c, cRowSize, firstMask, secondMask );
+			break;
+		case 4:
+			multiplyKernel<4>( packedA, pairCount, packedB, c, cRowSize, firstMask, secondMask );
+			break;
+		case 3:
+			multiplyKernel<3>( packedA, pairCount, packedB, c, cRowSize, firstMask, secondMask );
+			break;
+		case 2:
+			multiplyKernel<2>( packedA, pairCount, packedB, c, cRowSize, firstMask, secondMask );
+			break;
+		case 1:
+			multiplyKernel<1>( packedA, pairCount, packedB, c, cRowSize, firstMask, secondMask );
+			break;
+		default:
+			break;
+	}
+}
+
+NEOML_BF16_TARGET
+static void multiplyMatrix( bool transA, bool transB, const float* a, size_t aRowSize, const float* b, size_t bRowSize,
+	float* c, size_t cRowSize, size_t m, size_t n, size_t k, uint32_t* packedA, uint32_t* packedB )
+{
+	for( size_t kStart = 0; kStart < k; kStart += BlockDepth ) {
+		const size_t depth = std::min( BlockDepth, k - kStart );
+		const size_t pairCount = ( depth + 1 ) / 2;
+		for( size_t rowStart = 0; rowStart < m; rowStart += BlockHeight ) {
+			const size_t rowCount = std::min( BlockHeight, m - rowStart );
+			packA( transA, a, aRowSize, rowStart, rowCount, kStart, depth, packedA );
+			for( size_t columnStart = 0; columnStart < n; columnStart += KernelWidth ) {
+				const size_t columnCount = std::min( KernelWidth, n - columnStart );
+				packB( transB, b, bRowSize, columnStart, columnCount, kStart, depth, packedB );
+				multiplyRows( packedA, rowCount, pairCount, packedB, c + rowStart * cRowSize + columnStart, cRowSize,
+					columnCount );
+			}
+		}
+	}
+}
+
+void Bf16MultiplyMatrix( bool transA, bool transB, IMathEngine* engine,
+	const float* aPtr, size_t aRowSize, const float* bPtr, size_t bRowSize,
+	float* cPtr, size_t cRowSize, size_t m, size_t n, size_t k )
+{
+	if( m == 0 || n == 0 || k == 0 ) {
+		return;
+	}
+
+	// The packed values have the same size as float
+	const size_t pairCount = ( std::min( BlockDepth, k ) + 1 ) / 2;
+	CFloatHandleStackVar packedA( *engine, std::min( BlockHeight, m ) * pairCount + PackedSlack );
+	CFloatHandleStackVar packedB( *engine, pairCount * KernelWidth + PackedSlack );
+	multiplyMatrix( transA, transB, aPtr, aRowSize, bPtr, bRowSize, cPtr, cRowSize, m, n, k,
+		reinterpret_cast<uint32_t*>( GetRaw( packedA.GetHandle() ) ), reinterpret_cast<uint32_t*>( GetRaw( packedB.GetHandle() ) ) );
+}
+
+} // namespace NeoML
+
+#endif // NEOML_USE_BF16_GEMM
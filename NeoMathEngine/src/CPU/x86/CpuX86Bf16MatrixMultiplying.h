@@ -0,0 +1,43 @@
+/* Copyright © 2017-2020 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <NeoMathEngine/NeoMathEngineDefs.h>
+#include <cstddef>
+
+// The avx512_bf16 instructions are compiled only inside the functions with the target attribute,
+// which is supported by GCC 10+ and Clang 9+
+#if defined( NEOML_USE_SSE ) && ( ( defined( __clang__ ) && __clang_major__ >= 9 ) \
+	|| ( !defined( __clang__ ) && defined( __GNUC__ ) && __GNUC__ >= 10 ) )
+#define NEOML_USE_BF16_GEMM
+#endif
+
+namespace NeoML {
+
+class IMathEngine;
+
+#ifdef NEOML_USE_BF16_GEMM
+
+// Calculates C += op(A) * op(B) like SgemmFunc, where op(A) is m * k and op(B) is k * n
+// The elements of A and B are rounded to bfloat16, the products are accumulated in float
+// Should be called only if the CPU supports avx512_bf16 (see CCPUInfo::IsAvx512Bf16Available)
+void Bf16MultiplyMatrix( bool transA, bool transB, IMathEngine* engine,
+	const float* aPtr, size_t aRowSize, const float* bPtr, size_t bRowSize,
+	float* cPtr, size_t cRowSize, size_t m, size_t n, size_t k );
+
+#endif // NEOML_USE_BF16_GEMM
+
+} // namespace NeoML
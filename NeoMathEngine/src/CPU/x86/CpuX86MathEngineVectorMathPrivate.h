@@ -18,6 +18,7 @@ limitations under the License.
 #pragma once
 
 #include <NeoMathEngine/NeoMathEngineDefs.h>
+#include <NeoMathEngine/NeoMathEngine.h>
 
 #ifdef NEOML_USE_SSE
 
@@ -526,6 +527,239 @@ inline void vectorDotProduct( const float* first, const float* second, int vecto
 	*result = acc;
 }
 
+//------------------------------------------------------------------------------------------------------------
+// 8-bit quantized dot products
+
+// Loads 8 signed 8-bit values and extends them to 16 bits
+inline __m128i loadInt8AsInt16( const signed char* data )
+{
+	const __m128i value = _mm_loadl_epi64( reinterpret_cast<const __m128i*>( data ) );
+	// Each value is put into both bytes of the 16-bit element, then the arithmetic shift restores its sign
+	return _mm_srai_epi16( _mm_unpacklo_epi8( value, value ), 8 );
+}
+
+inline int horizontalAddInt32( __m128i value )
+{
+	value = _mm_add_epi32( value, _mm_shuffle_epi32( value, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+	value = _mm_add_epi32( value, _mm_shuffle_epi32( value, _MM_SHUFFLE( 2, 3, 0, 1 ) ) );
+	return _mm_cvtsi128_si32( value );
+}
+
+// Calculates the dot products of the 16-bit vector and four 8-bit vectors placed secondRowSize apart
+// The products are accumulated in 32-bit integers
+inline void quantizedDotProduct4( const short* first, const signed char* second, int secondRowSize,
+	int vectorSize, int* result )
+{
+	const signed char* second0 = second;
+	const signed char* second1 = second0 + secondRowSize;
+	const signed char* second2 = second1 + secondRowSize;
+	const signed char* second3 = second2 + secondRowSize;
+
+	__m128i sum0 = _mm_setzero_si128();
+	__m128i sum1 = _mm_setzero_si128();
+	__m128i sum2 = _mm_setzero_si128();
+	__m128i sum3 = _mm_setzero_si128();
+	int i = 0;
+	for( ; i + 8 <= vectorSize; i += 8 ) {
+		const __m128i firstValue = _mm_loadu_si128( reinterpret_cast<const __m128i*>( first + i ) );
+		sum0 = _mm_add_epi32( sum0, _mm_madd_epi16( firstValue, loadInt8AsInt16( second0 + i ) ) );
+		sum1 = _mm_add_epi32( sum1, _mm_madd_epi16( firstValue, loadInt8AsInt16( second1 + i ) ) );
+		sum2 = _mm_add_epi32( sum2, _mm_madd_epi16( firstValue, loadInt8AsInt16( second2 + i ) ) );
+		sum3 = _mm_add_epi32( sum3, _mm_madd_epi16( firstValue, loadInt8AsInt16( second3 + i ) ) );
+	}
+	result[0] = horizontalAddInt32( sum0 );
+	result[1] = horizontalAddInt32( sum1 );
+	result[2] = horizontalAddInt32( sum2 );
+	result[3] = horizontalAddInt32( sum3 );
+
+	for( ; i < vectorSize; ++i ) {
+		const int value = first[i];
+		result[0] += value * second0[i];
+		result[1] += value * second1[i];
+		result[2] += value * second2[i];
+		result[3] += value * second3[i];
+	}
+}
+
+// Calculates the dot product of the 16-bit vector and the 8-bit vector in 32-bit integers
+inline int quantizedDotProduct( const short* first, const signed char* second, int vectorSize )
+{
+	__m128i sum = _mm_setzero_si128();
+	int i = 0;
+	for( ; i + 8 <= vectorSize; i += 8 ) {
+		const __m128i firstValue = _mm_loadu_si128( reinterpret_cast<const __m128i*>( first + i ) );
+		sum = _mm_add_epi32( sum, _mm_madd_epi16( firstValue, loadInt8AsInt16( second + i ) ) );
+	}
+	int result = horizontalAddInt32( sum );
+	for( ; i < vectorSize; ++i ) {
+		result += first[i] * second[i];
+	}
+	return result;
+}
+
+//------------------------------------------------------------------------------------------------------------
+// Optimizer steps
+
+// Fused Adam step (see IDnnEngine::AdamStep); secondMomentMax may be null
+inline void vectorAdamStep( const CAdamStepParams& params, const float* paramDiff, float* param, float* moment,
+	float* secondMoment, float* secondMomentMax, int vectorSize )
+{
+	const bool useL1 = params.L1Regularization > 0;
+	const bool useL2 = params.L2Regularization > 0;
+	const float opMomentDecayRate = 1 - params.MomentDecayRate;
+	const float opSecondMomentDecayRate = 1 - params.SecondMomentDecayRate;
+
+	int sseSize;
+	int nonSseSize;
+	checkSse( vectorSize, sseSize, nonSseSize );
+
+	if( sseSize > 0 ) {
+		const __m128 l1 = _mm_set_ps1( params.L1Regularization );
+		const __m128 minusL1 = _mm_set_ps1( -params.L1Regularization );
+		const __m128 l2 = _mm_set_ps1( params.L2Regularization );
+		const __m128 momentDecayRate = _mm_set_ps1( params.MomentDecayRate );
+		const __m128 opMomentDecayRateSse = _mm_set_ps1( opMomentDecayRate );
+		const __m128 secondMomentDecayRate = _mm_set_ps1( params.SecondMomentDecayRate );
+		const __m128 opSecondMomentDecayRateSse = _mm_set_ps1( opSecondMomentDecayRate );
+		const __m128 gradientMult = _mm_set_ps1( params.GradientMult );
+		const __m128 momentMult = _mm_set_ps1( params.MomentMult );
+		const __m128 secondMomentMult = _mm_set_ps1( params.SecondMomentMult );
+		const __m128 epsilon = _mm_set_ps1( params.Epsilon );
+		const __m128 minusRate = _mm_set_ps1( -params.Rate );
+
+		for( int i = 0; i < sseSize; ++i ) {
+			const __m128 paramSse = _mm_loadu_ps( param );
+			__m128 diff = _mm_loadu_ps( paramDiff );
+			if( useL2 ) {
+				diff = _mm_add_ps( diff, _mm_mul_ps( l2, paramSse ) );
+			}
+			if( useL1 ) {
+				diff = _mm_add_ps( diff, _mm_min_ps( l1, _mm_max_ps( minusL1, paramSse ) ) );
+			}
+
+			const __m128 momentSse = _mm_add_ps( _mm_mul_ps( _mm_loadu_ps( moment ), momentDecayRate ),
+				_mm_mul_ps( opMomentDecayRateSse, diff ) );
+			_mm_storeu_ps( moment, momentSse );
+			__m128 secondMomentSse = _mm_add_ps( _mm_mul_ps( _mm_loadu_ps( secondMoment ), secondMomentDecayRate ),
+				_mm_mul_ps( opSecondMomentDecayRateSse, _mm_mul_ps( diff, diff ) ) );
+			_mm_storeu_ps( secondMoment, secondMomentSse );
+			if( secondMomentMax != nullptr ) {
+				secondMomentSse = _mm_max_ps( _mm_loadu_ps( secondMomentMax ), secondMomentSse );
+				_mm_storeu_ps( secondMomentMax, secondMomentSse );
+				secondMomentMax += 4;
+			}
+
+			const __m128 update = _mm_div_ps(
+				_mm_add_ps( _mm_mul_ps( diff, gradientMult ), _mm_mul_ps( momentSse, momentMult ) ),
+				_mm_add_ps( _mm_sqrt_ps( _mm_mul_ps( secondMomentSse, secondMomentMult ) ), epsilon ) );
+			_mm_storeu_ps( param, _mm_add_ps( paramSse, _mm_mul_ps( minusRate, update ) ) );
+
+			paramDiff += 4;
+			param += 4;
+			moment += 4;
+			secondMoment += 4;
+		}
+	}
+
+	for( int i = 0; i < nonSseSize; ++i ) {
+		float diff = paramDiff[i];
+		if( useL2 ) {
+			diff += params.L2Regularization * param[i];
+		}
+		if( useL1 ) {
+			diff += min( params.L1Regularization, max( -params.L1Regularization, param[i] ) );
+		}
+		moment[i] = moment[i] * params.MomentDecayRate + opMomentDecayRate * diff;
+		secondMoment[i] = secondMoment[i] * params.SecondMomentDecayRate + opSecondMomentDecayRate * ( diff * diff );
+		float denominator = secondMoment[i];
+		if( secondMomentMax != nullptr ) {
+			secondMomentMax[i] = max( secondMomentMax[i], secondMoment[i] );
+			denominator = secondMomentMax[i];
+		}
+		denominator = sqrtf( denominator * params.SecondMomentMult ) + params.Epsilon;
+		param[i] += -params.Rate * ( ( diff * params.GradientMult + moment[i] * params.MomentMult ) / denominator );
+	}
+}
+
+// Fused LAMB update (see IDnnEngine::LambUpdate)
+// The squared norms of the gradient, the parameters and the update are added to squaredNorms[0..2]
+inline void vectorLambUpdate( float gradientMult, float momentDecayRate, float secondMomentDecayRate, float epsilon,
+	float weightDecay, const float* paramDiff, const float* param, float* moment, float* secondMoment, float* update,
+	int vectorSize, float* squaredNorms )
+{
+	const float opMomentDecayRate = 1 - momentDecayRate;
+	const float opSecondMomentDecayRate = 1 - secondMomentDecayRate;
+
+	int sseSize;
+	int nonSseSize;
+	checkSse( vectorSize, sseSize, nonSseSize );
+
+	float diffNorm = 0;
+	float paramNorm = 0;
+	float updateNorm = 0;
+
+	if( sseSize > 0 ) {
+		const __m128 gradientMultSse = _mm_set_ps1( gradientMult );
+		const __m128 momentDecayRateSse = _mm_set_ps1( momentDecayRate );
+		const __m128 opMomentDecayRateSse = _mm_set_ps1( opMomentDecayRate );
+		const __m128 secondMomentDecayRateSse = _mm_set_ps1( secondMomentDecayRate );
+		const __m128 opSecondMomentDecayRateSse = _mm_set_ps1( opSecondMomentDecayRate );
+		const __m128 epsilonSse = _mm_set_ps1( epsilon );
+		const __m128 weightDecaySse = _mm_set_ps1( weightDecay );
+
+		__m128 diffNormSse = _mm_setzero_ps();
+		__m128 paramNormSse = _mm_setzero_ps();
+		__m128 updateNormSse = _mm_setzero_ps();
+
+		for( int i = 0; i < sseSize; ++i ) {
+			const __m128 paramSse = _mm_loadu_ps( param );
+			const __m128 diff = _mm_mul_ps( _mm_loadu_ps( paramDiff ), gradientMultSse );
+			const __m128 diffSquare = _mm_mul_ps( diff, diff );
+
+			const __m128 momentSse = _mm_add_ps( _mm_mul_ps( _mm_loadu_ps( moment ), momentDecayRateSse ),
+				_mm_mul_ps( opMomentDecayRateSse, diff ) );
+			_mm_storeu_ps( moment, momentSse );
+			const __m128 secondMomentSse = _mm_add_ps( _mm_mul_ps( _mm_loadu_ps( secondMoment ), secondMomentDecayRateSse ),
+				_mm_mul_ps( opSecondMomentDecayRateSse, diffSquare ) );
+			_mm_storeu_ps( secondMoment, secondMomentSse );
+
+			const __m128 updateSse = _mm_add_ps(
+				_mm_div_ps( momentSse, _mm_add_ps( _mm_sqrt_ps( secondMomentSse ), epsilonSse ) ),
+				_mm_mul_ps( weightDecaySse, paramSse ) );
+			_mm_storeu_ps( update, updateSse );
+
+			diffNormSse = _mm_add_ps( diffNormSse, diffSquare );
+			paramNormSse = _mm_add_ps( paramNormSse, _mm_mul_ps( paramSse, paramSse ) );
+			updateNormSse = _mm_add_ps( updateNormSse, _mm_mul_ps( updateSse, updateSse ) );
+
+			paramDiff += 4;
+			param += 4;
+			moment += 4;
+			secondMoment += 4;
+			update += 4;
+		}
+
+		diffNorm += _mm_cvtss_f32( HorizontalAddSse( diffNormSse ) );
+		paramNorm += _mm_cvtss_f32( HorizontalAddSse( paramNormSse ) );
+		updateNorm += _mm_cvtss_f32( HorizontalAddSse( updateNormSse ) );
+	}
+
+	for( int i = 0; i < nonSseSize; ++i ) {
+		const float diff = paramDiff[i] * gradientMult;
+		moment[i] = moment[i] * momentDecayRate + opMomentDecayRate * diff;
+		secondMoment[i] = secondMoment[i] * secondMomentDecayRate + opSecondMomentDecayRate * ( diff * diff );
+		update[i] = moment[i] / ( sqrtf( secondMoment[i] ) + epsilon ) + weightDecay * param[i];
+
+		diffNorm += diff * diff;
+		paramNorm += param[i] * param[i];
+		updateNorm += update[i] * update[i];
+	}
+
+	squaredNorms[0] += diffNorm;
+	squaredNorms[1] += paramNorm;
+	squaredNorms[2] += updateNorm;
+}
+
 //------------------------------------------------------------------------------------------------------------
 
 // QRNN primitives
@@ -48,20 +48,20 @@ CAvxConvolutionDesc::CAvxConvolutionDesc( IMathEngine* mathEngine, const CBlobDe
 
 class CAvxMathEngine : public ISimdMathEngine {
 public:
-	CAvxMathEngine( IMathEngine* _mathEngine, int _threadCount ) : mathEngine( _mathEngine ), threadCount( _threadCount ) {}
+	CAvxMathEngine( IMathEngine* _mathEngine, IThreadPool* _threadPool ) : mathEngine( _mathEngine ), threadPool( _threadPool ) {}
 
 	CConvolutionDesc* InitBlobConvolution( const CBlobDesc& source, int paddingHeight, int paddingWidth,
 		int strideHeight, int strideWidth, int dilationHeight, int dilationWidth, const CBlobDesc& filter,
 		const CBlobDesc& result ) const override;
 
 	void BlobConvolution( const CConvolutionDesc& convDesc, const float* source,
-		const float* filter, const float* freeTerm, float* result ) const override;
+		const float* filter, const float* freeTerm, const CActivationInfo& activation, float* result ) const override;
 
 	SgemmFunc GetSgemmFunction() const override;
 
 private:
 	IMathEngine* mathEngine;
-	int threadCount;
+	IThreadPool* threadPool;
 };
 
 CConvolutionDesc* CAvxMathEngine::InitBlobConvolution( const CBlobDesc& source, int paddingHeight, int paddingWidth,
@@ -75,11 +75,11 @@ CConvolutionDesc* CAvxMathEngine::InitBlobConvolution( const CBlobDesc& source,
 }
 
 void CAvxMathEngine::BlobConvolution( const CConvolutionDesc& convDesc, const float* source,
-	const float* filter, const float* freeTerm, float* result ) const
+	const float* filter, const float* freeTerm, const CActivationInfo& activation, float* result ) const
 {
 	const CAvxConvolutionDesc& desc = static_cast<const CAvxConvolutionDesc&>( convDesc );
 	
-	desc.BlobConvolution->ProcessConvolution( threadCount, source, filter, freeTerm, result );
+	desc.BlobConvolution->ProcessConvolution( *threadPool, source, filter, freeTerm, activation, result );
 
 }
 
@@ -90,10 +90,10 @@ SgemmFunc CAvxMathEngine::GetSgemmFunction() const
 
 extern "C"
 FME_DLL_EXPORT
-ISimdMathEngine* CreateSimdMathEngine( IMathEngine* mathEngine, int threadCount )
+ISimdMathEngine* CreateSimdMathEngine( IMathEngine* mathEngine, IThreadPool* threadPool )
 {
 	try {
-		return new CAvxMathEngine( mathEngine, threadCount );
+		return new CAvxMathEngine( mathEngine, threadPool );
 	} catch( ... ) {
 		// We cannot throw any exception from C function
 		return nullptr;
@@ -16,13 +16,15 @@ limitations under the License.
 #include <array>
 #include <vector>
 #include <NeoMathEngine/NeoMathEngine.h>
+#include <CpuMathEngineActivation.h>
 
 namespace NeoML {
 
 class CBlobConvolutionBase : public CCrtAllocatedObject {
 public:
 	virtual ~CBlobConvolutionBase() = default;
-	virtual void ProcessConvolution( int threadCount, const float* sourceData, const float* filterData, const float* freeTermData, float* resultData ) = 0;
+	virtual void ProcessConvolution( IThreadPool& threadPool, const float* sourceData, const float* filterData, const float* freeTermData,
+		const CActivationInfo& activation, float* resultData ) = 0;
 };
 
 template<int FltCnt>
@@ -34,8 +36,8 @@ public:
 		int dilationHeight, int dilationWidth, int resultHeight, int resultWidth, int resObjCnt );
 	~CBlobConvolution() override = default;
 
-	void ProcessConvolution( int threadCount,
-		const float* sourceData, const float* filterData, const float* freeTermData, float* resultData ) override;
+	void ProcessConvolution( IThreadPool& threadPool, const float* sourceData, const float* filterData,
+		const float* freeTermData, const CActivationInfo& activation, float* resultData ) override;
 
 private:
 	struct CSize {
@@ -225,8 +227,8 @@ CBlobConvolution<FltCnt>::CBlobConvolution( IMathEngine* _mathEngine, int channe
 }
 
 template<int FltCnt>
-void CBlobConvolution<FltCnt>::ProcessConvolution( int threadCount,
-	const float* sourceData, const float* filterData, const float* freeTermData, float* resultData )
+void CBlobConvolution<FltCnt>::ProcessConvolution( IThreadPool& threadPool, const float* sourceData, const float* filterData,
+	const float* freeTermData, const CActivationInfo& activation, float* resultData )
 {
 	CFloatHandleStackVar filterTempBuffer( *mathEngine, FltW * FltH * FltCntM8 * ChCnt );
 	CFloatHandleStackVar freeTermTempBuffer( *mathEngine, FltCntM8 );
@@ -239,7 +241,7 @@ void CBlobConvolution<FltCnt>::ProcessConvolution( int threadCount,
 	const int SrcObjSize = SrcW * SrcH * ChCnt;
 	const int ResObjSize = ResW * ResH * FltCnt;
 	const int ResRowCount = ResObjCnt * ResH;
-	const int curThreadCount = IsOmpRelevant( ResRowCount, ResRowCount * ResW * FltCnt * FltW * FltH * ChCnt ) ? threadCount : 1;
+	const int curThreadCount = IsOmpRelevant( ResRowCount, ResRowCount * ResW * FltCnt * FltW * FltH * ChCnt ) ? threadPool.Size() : 1;
 
 	// Number of steps for each side of image, where filter is applied partially
 	int PartialStepCountBeforeX = static_cast<const int>( std::ceil( static_cast<float>( PaddingW ) / StrideW ) );
@@ -279,8 +281,7 @@ void CBlobConvolution<FltCnt>::ProcessConvolution( int threadCount,
 	const int srcXOffset = 0 + ( DilationW - PaddingW );
 	const int srcYOffset = 0 + ( DilationH - PaddingH );
 	
-	NEOML_OMP_NUM_THREADS( curThreadCount )
-	{
+	ParallelRun( threadPool, curThreadCount, [&] {
 		// Index of row in whole result array
 		int rowIdx;
 		// Count of rows for current thread
@@ -342,9 +343,14 @@ void CBlobConvolution<FltCnt>::ProcessConvolution( int threadCount,
 					processConvolutionLoop( PartialStepCountAfterX, useNarrowProcessing, srcPtr, resPtr, windowOffsets[4] );
 					ry += useNarrowProcessing ? NarrowBatchProcessSize.Height : WideBatchProcessSize.Height;
 				}
+
+				if( !activation.IsIdentity() ) {
+					// The rows just calculated are still in the cache
+					applyActivation( activation, realResStart + ryStart * ResLineStride, ryCount * ResLineStride );
+				}
 			}
 		}
-	}
+	} );
 }
 
 template<int FltCnt>
@@ -164,6 +164,12 @@ CMemoryHandle CCudaMathEngine::CopyFrom( const CMemoryHandle& handle, size_t siz
 	return result;
 }
 
+CMemoryHandle CCudaMathEngine::GetExternalMemoryHandle( const void* )
+{
+	// The device memory can't point to the host memory
+	return CMemoryHandle();
+}
+
 CMemoryHandle CCudaMathEngine::Alloc( size_t size )
 {
 	SetCudaDevice( device->DeviceNumber );
@@ -1026,6 +1026,17 @@ void CCudaMathEngine::vectorMultichannelLookupAndAddToTable(int batchSize, int c
 	}
 }
 
+void CCudaMathEngine::QuantizeMatrixRows( const CConstFloatHandle&, int, int, const CInt8Handle&, const CFloatHandle& )
+{
+	ASSERT_EXPR( false );
+}
+
+void CCudaMathEngine::MultiplyMatrixByTransposedQuantizedMatrix( const CConstFloatHandle&, int, int, float, int,
+	const CConstInt8Handle&, const CConstFloatHandle&, int, const CConstFloatHandle*, const CActivationInfo&, const CFloatHandle& )
+{
+	ASSERT_EXPR( false );
+}
+
 } // namespace NeoML
 
 #endif // NEOML_USE_CUDA
@@ -24,6 +24,7 @@ limitations under the License.
 #include <CublasFunctions.h>
 #include <MathEngineCommon.h>
 #include <MemoryHandleInternal.h>
+#include <MathEngineActivation.h>
 
 #include <cuda_runtime_api.h>
 
@@ -75,6 +76,21 @@ void CCudaMathEngine::MultiplyMatrixByTransposedMatrix( const CConstFloatHandle&
 		GetRaw( resultHandle ), resultRowSize ) );
 }
 
+void CCudaMathEngine::MultiplyMatrixByTransposedMatrix( const CConstFloatHandle& firstHandle, int firstHeight,
+	int firstWidth, int firstRowSize, const CConstFloatHandle& secondHandle, int secondHeight, int secondRowSize,
+	const CConstFloatHandle* freeTermHandle, const CActivationInfo& activation,
+	const CFloatHandle& resultHandle, int resultRowSize, int resultBufferSize )
+{
+	// The free term and the activation are applied by separate kernels
+	ASSERT_EXPR( resultRowSize == secondHeight );
+	MultiplyMatrixByTransposedMatrix( firstHandle, firstHeight, firstWidth, firstRowSize, secondHandle, secondHeight,
+		secondRowSize, resultHandle, resultRowSize, resultBufferSize );
+	if( freeTermHandle != nullptr ) {
+		AddVectorToMatrixRows( 1, resultHandle, resultHandle, firstHeight, secondHeight, *freeTermHandle );
+	}
+	ApplyActivationByVectorOperations( *this, activation, resultHandle, firstHeight * secondHeight );
+}
+
 void CCudaMathEngine::MultiplyMatrixByTransposedMatrix( int batchSize, const CConstFloatHandle& firstHandle,
 	int firstHeight, int firstWidth, const CConstFloatHandle& secondHandle, int secondHeight,
 	const CFloatHandle& resultHandle, int resultBufferSize )
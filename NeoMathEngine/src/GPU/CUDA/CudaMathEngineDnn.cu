@@ -643,6 +643,44 @@ void CCudaMathEngine::IndRnnRecurrentLearn( bool reverse, int sequenceLength, in
 		mask.IsNull() ? nullptr : GetRaw( mask ), GetRaw( u ), GetRaw( h ), GetRaw( hDiff ), GetRaw( uDiff ) );
 }
 
+void CCudaMathEngine::LstmRecurrent( bool /*reverse*/, int /*sequenceLength*/, int /*batchSize*/, int /*hiddenSize*/,
+	const CConstFloatHandle& /*inputGates*/, const CConstFloatHandle& /*recurWeights*/,
+	const CConstFloatHandle& /*initialOutput*/, const CConstFloatHandle& /*initialState*/,
+	const CFloatHandle& /*output*/, const CFloatHandle& /*state*/ )
+{
+	ASSERT_EXPR( false );
+}
+
+void CCudaMathEngine::GruRecurrent( bool /*reverse*/, int /*sequenceLength*/, int /*batchSize*/, int /*hiddenSize*/,
+	const CConstFloatHandle& /*inputGates*/, const CConstFloatHandle& /*inputMain*/,
+	const CConstFloatHandle& /*gateWeights*/, const CConstFloatHandle& /*mainWeights*/, int /*weightsRowSize*/,
+	const CConstFloatHandle& /*initialOutput*/, const CFloatHandle& /*output*/ )
+{
+	ASSERT_EXPR( false );
+}
+
+void CCudaMathEngine::ScaledDotProductAttention( int /*batchSize*/, int /*headCount*/, int /*queryLength*/, int /*keyLength*/,
+	int /*headSize*/, float /*scale*/, const CConstFloatHandle& /*query*/, const CConstFloatHandle& /*key*/,
+	const CConstFloatHandle& /*value*/, const CConstFloatHandle& /*mask*/, const CFloatHandle& /*result*/ )
+{
+	ASSERT_EXPR( false );
+}
+
+void CCudaMathEngine::AdamStep( const CAdamStepParams& /*params*/, int /*dataSize*/, const CConstFloatHandle& /*paramDiff*/,
+	const CFloatHandle& /*param*/, const CFloatHandle& /*moment*/, const CFloatHandle& /*secondMoment*/,
+	const CFloatHandle& /*secondMomentMax*/ )
+{
+	ASSERT_EXPR( false );
+}
+
+void CCudaMathEngine::LambUpdate( int /*dataSize*/, float /*gradientMult*/, float /*momentDecayRate*/, float /*secondMomentDecayRate*/,
+	float /*epsilon*/, float /*weightDecay*/, const CConstFloatHandle& /*paramDiff*/, const CConstFloatHandle& /*param*/,
+	const CFloatHandle& /*moment*/, const CFloatHandle& /*secondMoment*/, const CFloatHandle& /*update*/,
+	const CFloatHandle& /*squaredNorms*/ )
+{
+	ASSERT_EXPR( false );
+}
+
 } // namespace NeoML
 
 #endif // NEOML_USE_CUDA
@@ -23,6 +23,7 @@ limitations under the License.
 #include <CudaDevice.h>
 #include <MathEngineCommon.h>
 #include <MemoryHandleInternal.h>
+#include <MathEngineActivation.h>
 
 #include <Kernels/CudaDnnConvKernels.h>
 
@@ -144,6 +145,16 @@ void CCudaMathEngine::BlobConvolution( const CConvolutionDesc& convDesc,
 
 }
 
+void CCudaMathEngine::BlobConvolution( const CConvolutionDesc& convDesc,
+	const CFloatHandle& sourceData, const CFloatHandle& filterData, const CFloatHandle* freeTermData,
+	const CActivationInfo& activation, const CFloatHandle& resultData )
+{
+	// The activation is applied by separate kernels
+	BlobConvolution( convDesc, sourceData, filterData, freeTermData, resultData );
+	const int resultSize = static_cast<const CCudaConvolutionDesc&>( convDesc ).Internal.Result.BlobSize();
+	ApplyActivationByVectorOperations( *this, activation, resultData, resultSize );
+}
+
 void CCudaMathEngine::BlobConvolutionBackward( const CConvolutionDesc& convDesc, const CFloatHandle& outputDiff,
 	const CFloatHandle& filter, const CFloatHandle* freeTerm, const CFloatHandle& inputDiff )
 {
@@ -235,6 +246,12 @@ void CCudaMathEngine::BlobConvolutionLearnAdd( const CConvolutionDesc& convDesc,
 		tempMatrix, matrixWidth, matrixWidth, filterDiff, matrixWidth, desc.Filter.BlobSize() );
 }
 
+void CCudaMathEngine::BlobQuantizedConvolution( const CConvolutionDesc&, const CConstFloatHandle&, float, int,
+	const CConstInt8Handle&, const CConstFloatHandle&, const CConstFloatHandle*, const CActivationInfo&, const CFloatHandle& )
+{
+	ASSERT_EXPR( false );
+}
+
 } // namespace NeoML
 
 #endif // NEOML_USE_CUDA
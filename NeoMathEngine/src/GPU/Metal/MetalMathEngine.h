@@ -60,6 +60,7 @@ public:
 	void DataExchangeRaw( const CMemoryHandle& handle, const void* data, size_t size ) override;
 	void DataExchangeRaw( void* data, const CMemoryHandle& handle, size_t size ) override;
 	CMemoryHandle CopyFrom( const CMemoryHandle& handle, size_t size ) override;
+	CMemoryHandle GetExternalMemoryHandle( const void* data ) override;
 	void GetMathEngineInfo( CMathEngineInfo& info ) const override;
 
 	// IVectorMathematicsEngine interface methods
@@ -317,6 +318,10 @@ public:
 	void MultiplyMatrixByTransposedMatrix(const CConstFloatHandle& firstHandle, int firstHeight,
 		int firstWidth, int firstRowSize, const CConstFloatHandle& secondHandle, int secondHeight, int secondRowSize,
 		const CFloatHandle& resultHandle, int resultRowSize, int resultBufferSize) override;
+	void MultiplyMatrixByTransposedMatrix(const CConstFloatHandle& firstHandle, int firstHeight,
+		int firstWidth, int firstRowSize, const CConstFloatHandle& secondHandle, int secondHeight, int secondRowSize,
+		const CConstFloatHandle* freeTermHandle, const CActivationInfo& activation,
+		const CFloatHandle& resultHandle, int resultRowSize, int resultBufferSize) override;
 	void MultiplyMatrixByTransposedMatrix(int batchSize, const CConstFloatHandle& firstHandle, int firstHeight, int firstWidth,
 		const CConstFloatHandle& secondHandle, int secondHeight, const CFloatHandle& resultHandle, int resultBufferSize) override;
 	void MultiplySparseMatrixByTransposedMatrix( int firstHeight, int firstWidth, int secondHeight,
@@ -355,6 +360,12 @@ public:
 	void MatrixSpreadRows(const CConstIntHandle& sourceHandle, int height, int width,
 		const CIntHandle& resultHandle, int resultHeight, const CConstIntHandle& indexHandle,
 		const CConstIntHandle& fillValue) override;
+	void QuantizeMatrixRows( const CConstFloatHandle& matrixHandle, int height, int width,
+		const CInt8Handle& quantizedHandle, const CFloatHandle& rowScalesHandle ) override;
+	void MultiplyMatrixByTransposedQuantizedMatrix( const CConstFloatHandle& firstHandle, int firstHeight,
+		int firstWidth, float firstScale, int firstZeroPoint, const CConstInt8Handle& secondHandle,
+		const CConstFloatHandle& secondScalesHandle, int secondHeight, const CConstFloatHandle* freeTermHandle,
+		const CActivationInfo& activation, const CFloatHandle& resultHandle ) override;
 
 	// IDnnEngine interface methods
 	void BlobMergeByDim(TBlobDim dim, const CBlobDesc* from, const CFloatHandle* fromData, int fromCount,
@@ -394,11 +405,17 @@ public:
 	void BlobConvolution( const CConvolutionDesc& desc,
 		const CFloatHandle& source, const CFloatHandle& filter, const CFloatHandle* freeTerm,
 		const CFloatHandle& result ) override;
+	void BlobConvolution( const CConvolutionDesc& desc,
+		const CFloatHandle& source, const CFloatHandle& filter, const CFloatHandle* freeTerm,
+		const CActivationInfo& activation, const CFloatHandle& result ) override;
 	void BlobConvolutionBackward( const CConvolutionDesc& desc, const CFloatHandle& outputDiff,
 		const CFloatHandle& filter, const CFloatHandle* freeTerm, const CFloatHandle& inputDiff ) override;
 	void BlobConvolutionLearnAdd( const CConvolutionDesc& desc,
 		const CFloatHandle& input, const CFloatHandle& outputDiff, const CFloatHandle& filterDiff,
 		const CFloatHandle* freeTermDiff, bool isFreeTermDiffFromInput ) override;
+	void BlobQuantizedConvolution( const CConvolutionDesc& desc, const CConstFloatHandle& source,
+		float sourceScale, int sourceZeroPoint, const CConstInt8Handle& filter, const CConstFloatHandle& filterScales,
+		const CConstFloatHandle* freeTerm, const CActivationInfo& activation, const CFloatHandle& result ) override;
 	CChannelwiseConvolutionDesc* InitBlobChannelwiseConvolution( const CBlobDesc& input,
 		int paddingHeight, int paddingWidth, int strideHeight, int strideWidth,
 		const CBlobDesc& filter, const CBlobDesc* freeTerm, const CBlobDesc& output ) override;
@@ -510,6 +527,24 @@ public:
 	void IndRnnRecurrentLearn( bool reverse, int sequenceLength, int batchSize, int objectSize,
 		const CConstFloatHandle& mask, const CConstFloatHandle& u, const CConstFloatHandle& h, const CConstFloatHandle& hDiff,
 		const CFloatHandle& uDiff ) override;
+	void LstmRecurrent( bool reverse, int sequenceLength, int batchSize, int hiddenSize,
+		const CConstFloatHandle& inputGates, const CConstFloatHandle& recurWeights,
+		const CConstFloatHandle& initialOutput, const CConstFloatHandle& initialState,
+		const CFloatHandle& output, const CFloatHandle& state ) override;
+	void GruRecurrent( bool reverse, int sequenceLength, int batchSize, int hiddenSize,
+		const CConstFloatHandle& inputGates, const CConstFloatHandle& inputMain,
+		const CConstFloatHandle& gateWeights, const CConstFloatHandle& mainWeights, int weightsRowSize,
+		const CConstFloatHandle& initialOutput, const CFloatHandle& output ) override;
+	void ScaledDotProductAttention( int batchSize, int headCount, int queryLength, int keyLength,
+		int headSize, float scale, const CConstFloatHandle& query, const CConstFloatHandle& key,
+		const CConstFloatHandle& value, const CConstFloatHandle& mask, const CFloatHandle& result ) override;
+	void AdamStep( const CAdamStepParams& params, int dataSize, const CConstFloatHandle& paramDiff,
+		const CFloatHandle& param, const CFloatHandle& moment, const CFloatHandle& secondMoment,
+		const CFloatHandle& secondMomentMax ) override;
+	void LambUpdate( int dataSize, float gradientMult, float momentDecayRate, float secondMomentDecayRate,
+		float epsilon, float weightDecay, const CConstFloatHandle& paramDiff, const CConstFloatHandle& param,
+		const CFloatHandle& moment, const CFloatHandle& secondMoment, const CFloatHandle& update,
+		const CFloatHandle& squaredNorms ) override;
 	IPerformanceCounters* CreatePerformanceCounters() const override { 	return new CPerformanceCountersDefault(); }
 
 protected:
@@ -202,6 +202,12 @@ CMemoryHandle CMetalMathEngine::CopyFrom( const CMemoryHandle& handle, size_t si
 	return result;
 }
 
+CMemoryHandle CMetalMathEngine::GetExternalMemoryHandle( const void* )
+{
+	// The device memory can't point to the host memory
+	return CMemoryHandle();
+}
+
 void CMetalMathEngine::VectorCopy( const CFloatHandle& first, const CConstFloatHandle& second, int vectorSize )
 {
 	ASSERT_EXPR( first.GetMathEngine() == this );
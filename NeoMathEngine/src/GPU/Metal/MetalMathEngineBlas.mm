@@ -20,6 +20,7 @@ limitations under the License.
 #include <MetalMathEngine.h>
 #include <MetalKernel.h>
 #include <MathEngineCommon.h>
+#include <MathEngineActivation.h>
 #include <algorithm>
 
 @import Foundation;
@@ -678,6 +679,21 @@ void CMetalMathEngine::MultiplyMatrixByTransposedMatrix(const CConstFloatHandle&
     }
 }
 
+void CMetalMathEngine::MultiplyMatrixByTransposedMatrix( const CConstFloatHandle& firstHandle, int firstHeight,
+	int firstWidth, int firstRowSize, const CConstFloatHandle& secondHandle, int secondHeight, int secondRowSize,
+	const CConstFloatHandle* freeTermHandle, const CActivationInfo& activation,
+	const CFloatHandle& resultHandle, int resultRowSize, int resultBufferSize )
+{
+	// The free term and the activation are applied by separate kernels
+	ASSERT_EXPR( resultRowSize == secondHeight );
+	MultiplyMatrixByTransposedMatrix( firstHandle, firstHeight, firstWidth, firstRowSize, secondHandle, secondHeight,
+		secondRowSize, resultHandle, resultRowSize, resultBufferSize );
+	if( freeTermHandle != nullptr ) {
+		AddVectorToMatrixRows( 1, resultHandle, resultHandle, firstHeight, secondHeight, *freeTermHandle );
+	}
+	ApplyActivationByVectorOperations( *this, activation, resultHandle, firstHeight * secondHeight );
+}
+
 void CMetalMathEngine::MultiplyMatrixByTransposedMatrix(int batchSize, const CConstFloatHandle& firstHandle, int firstHeight,
     int firstWidth, const CConstFloatHandle& secondHandle, int secondHeight, const CFloatHandle& resultHandle, int /*resultBufferSize*/)
 {
@@ -1314,6 +1330,17 @@ void CMetalMathEngine::SumMatrixRows( int batchSize, const CFloatHandle& resultH
 	SumMatrixRowsAdd(batchSize, resultHandle, matrixHandle, matrixHeight, matrixWidth);
 }
 
+void CMetalMathEngine::QuantizeMatrixRows( const CConstFloatHandle&, int, int, const CInt8Handle&, const CFloatHandle& )
+{
+	ASSERT_EXPR( false );
+}
+
+void CMetalMathEngine::MultiplyMatrixByTransposedQuantizedMatrix( const CConstFloatHandle&, int, int, float, int,
+	const CConstInt8Handle&, const CConstFloatHandle&, int, const CConstFloatHandle*, const CActivationInfo&, const CFloatHandle& )
+{
+	ASSERT_EXPR( false );
+}
+
 } // namespace NeoML
 
 #endif // NEOML_USE_METAL
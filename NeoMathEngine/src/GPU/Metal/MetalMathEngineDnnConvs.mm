@@ -21,6 +21,7 @@ limitations under the License.
 #include <MetalMathEngine.h>
 #include <MathEngineDnnConv.h>
 #include <MathEngineCommon.h>
+#include <MathEngineActivation.h>
 #include <MetalKernel.h>
 #include <algorithm>
 
@@ -142,6 +143,16 @@ void CMetalMathEngine::BlobConvolution( const CConvolutionDesc& convDesc,
     }
 }
 
+void CMetalMathEngine::BlobConvolution( const CConvolutionDesc& convDesc,
+	const CFloatHandle& sourceData, const CFloatHandle& filterData, const CFloatHandle* freeTermData,
+	const CActivationInfo& activation, const CFloatHandle& resultData )
+{
+	// The activation is applied by separate kernels
+	BlobConvolution( convDesc, sourceData, filterData, freeTermData, resultData );
+	const int resultSize = static_cast<const CCommonConvolutionDesc&>( convDesc ).Result.BlobSize();
+	ApplyActivationByVectorOperations( *this, activation, resultData, resultSize );
+}
+
 void CMetalMathEngine::BlobConvolutionBackward( const CConvolutionDesc& convDesc, const CFloatHandle& outputDiffData,
 	const CFloatHandle& filterData, const CFloatHandle* freeTermData, const CFloatHandle& inputDiffData )
 {
@@ -663,6 +674,12 @@ void CMetalMathEngine::BlobRleConvolutionLearnAdd( const CRleConvolutionDesc&, c
 	ASSERT_EXPR( false );
 }
 
+void CMetalMathEngine::BlobQuantizedConvolution( const CConvolutionDesc&, const CConstFloatHandle&, float, int,
+	const CConstInt8Handle&, const CConstFloatHandle&, const CConstFloatHandle*, const CActivationInfo&, const CFloatHandle& )
+{
+	ASSERT_EXPR( false );
+}
+
 } // namespace NeoML
 
 #endif // NEOML_USE_METAL
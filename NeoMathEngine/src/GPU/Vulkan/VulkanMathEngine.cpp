@@ -307,6 +307,12 @@ CMemoryHandle CVulkanMathEngine::CopyFrom( const CMemoryHandle& handle, size_t s
 	return result;
 }
 
+CMemoryHandle CVulkanMathEngine::GetExternalMemoryHandle( const void* )
+{
+	// The device memory can't point to the host memory
+	return CMemoryHandle();
+}
+
 CMemoryHandle CVulkanMathEngine::Alloc( size_t size )
 {
 	VkBufferUsageFlags usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | 
@@ -25,6 +25,7 @@ limitations under the License.
 #include <MathEngineCommon.h>
 #include <VulkanShader.h>
 #include <VulkanDll.h>
+#include <MathEngineActivation.h>
 
 namespace NeoML {
 
@@ -145,6 +146,21 @@ void CVulkanMathEngine::MultiplyMatrixByTransposedMatrix( const CConstFloatHandl
 	}
 }
 
+void CVulkanMathEngine::MultiplyMatrixByTransposedMatrix( const CConstFloatHandle& firstHandle, int firstHeight,
+	int firstWidth, int firstRowSize, const CConstFloatHandle& secondHandle, int secondHeight, int secondRowSize,
+	const CConstFloatHandle* freeTermHandle, const CActivationInfo& activation,
+	const CFloatHandle& resultHandle, int resultRowSize, int resultBufferSize )
+{
+	// The free term and the activation are applied by separate kernels
+	ASSERT_EXPR( resultRowSize == secondHeight );
+	MultiplyMatrixByTransposedMatrix( firstHandle, firstHeight, firstWidth, firstRowSize, secondHandle, secondHeight,
+		secondRowSize, resultHandle, resultRowSize, resultBufferSize );
+	if( freeTermHandle != nullptr ) {
+		AddVectorToMatrixRows( 1, resultHandle, resultHandle, firstHeight, secondHeight, *freeTermHandle );
+	}
+	ApplyActivationByVectorOperations( *this, activation, resultHandle, firstHeight * secondHeight );
+}
+
 void CVulkanMathEngine::MultiplyMatrixByTransposedMatrix(int batchSize, const CConstFloatHandle& firstHandle, int firstHeight,
 	int firstWidth, const CConstFloatHandle& secondHandle, int secondHeight, const CFloatHandle& resultHandle, int resultBufferSize)
 {
@@ -1152,6 +1168,17 @@ void CVulkanMathEngine::MultiplyVectorByTransposedLookupVectorAndAddToTable( int
 	ASSERT_EXPR( false );
 }
 
+void CVulkanMathEngine::QuantizeMatrixRows( const CConstFloatHandle&, int, int, const CInt8Handle&, const CFloatHandle& )
+{
+	ASSERT_EXPR( false );
+}
+
+void CVulkanMathEngine::MultiplyMatrixByTransposedQuantizedMatrix( const CConstFloatHandle&, int, int, float, int,
+	const CConstInt8Handle&, const CConstFloatHandle&, int, const CConstFloatHandle*, const CActivationInfo&, const CFloatHandle& )
+{
+	ASSERT_EXPR( false );
+}
+
 } // namespace NeoML
 
 #endif // NEOML_USE_VULKAN
@@ -585,6 +585,44 @@ void CVulkanMathEngine::IndRnnRecurrentLearn( bool /*reverse*/, int /*sequenceLe
 	ASSERT_EXPR( false );
 }
 
+void CVulkanMathEngine::LstmRecurrent( bool /*reverse*/, int /*sequenceLength*/, int /*batchSize*/, int /*hiddenSize*/,
+	const CConstFloatHandle& /*inputGates*/, const CConstFloatHandle& /*recurWeights*/,
+	const CConstFloatHandle& /*initialOutput*/, const CConstFloatHandle& /*initialState*/,
+	const CFloatHandle& /*output*/, const CFloatHandle& /*state*/ )
+{
+	ASSERT_EXPR( false );
+}
+
+void CVulkanMathEngine::GruRecurrent( bool /*reverse*/, int /*sequenceLength*/, int /*batchSize*/, int /*hiddenSize*/,
+	const CConstFloatHandle& /*inputGates*/, const CConstFloatHandle& /*inputMain*/,
+	const CConstFloatHandle& /*gateWeights*/, const CConstFloatHandle& /*mainWeights*/, int /*weightsRowSize*/,
+	const CConstFloatHandle& /*initialOutput*/, const CFloatHandle& /*output*/ )
+{
+	ASSERT_EXPR( false );
+}
+
+void CVulkanMathEngine::ScaledDotProductAttention( int /*batchSize*/, int /*headCount*/, int /*queryLength*/, int /*keyLength*/,
+	int /*headSize*/, float /*scale*/, const CConstFloatHandle& /*query*/, const CConstFloatHandle& /*key*/,
+	const CConstFloatHandle& /*value*/, const CConstFloatHandle& /*mask*/, const CFloatHandle& /*result*/ )
+{
+	ASSERT_EXPR( false );
+}
+
+void CVulkanMathEngine::AdamStep( const CAdamStepParams& /*params*/, int /*dataSize*/, const CConstFloatHandle& /*paramDiff*/,
+	const CFloatHandle& /*param*/, const CFloatHandle& /*moment*/, const CFloatHandle& /*secondMoment*/,
+	const CFloatHandle& /*secondMomentMax*/ )
+{
+	ASSERT_EXPR( false );
+}
+
+void CVulkanMathEngine::LambUpdate( int /*dataSize*/, float /*gradientMult*/, float /*momentDecayRate*/, float /*secondMomentDecayRate*/,
+	float /*epsilon*/, float /*weightDecay*/, const CConstFloatHandle& /*paramDiff*/, const CConstFloatHandle& /*param*/,
+	const CFloatHandle& /*moment*/, const CFloatHandle& /*secondMoment*/, const CFloatHandle& /*update*/,
+	const CFloatHandle& /*squaredNorms*/ )
+{
+	ASSERT_EXPR( false );
+}
+
 } // namespace NeoML
 
 #endif // NEOML_USE_VULKAN
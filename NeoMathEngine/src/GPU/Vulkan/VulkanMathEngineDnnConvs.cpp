@@ -26,6 +26,7 @@ limitations under the License.
 #include <MathEngineCommon.h>
 #include <VulkanDll.h>
 #include <MathEngineDnnConv.h>
+#include <MathEngineActivation.h>
 
 namespace NeoML {
 
@@ -428,6 +429,16 @@ void CVulkanMathEngine::BlobConvolution( const CConvolutionDesc& convDesc,
 	}
 }
 
+void CVulkanMathEngine::BlobConvolution( const CConvolutionDesc& convDesc,
+	const CFloatHandle& sourceData, const CFloatHandle& filterData, const CFloatHandle* freeTermData,
+	const CActivationInfo& activation, const CFloatHandle& resultData )
+{
+	// The activation is applied by separate kernels
+	BlobConvolution( convDesc, sourceData, filterData, freeTermData, resultData );
+	const int resultSize = static_cast<const CCommonConvolutionDesc&>( convDesc ).Result.BlobSize();
+	ApplyActivationByVectorOperations( *this, activation, resultData, resultSize );
+}
+
 void CVulkanMathEngine::BlobConvolutionBackward( const CConvolutionDesc& convDesc, const CFloatHandle& outputDiffData,
 	const CFloatHandle& filterData, const CFloatHandle* freeTermData, const CFloatHandle& inputDiffData )
 {
@@ -1061,6 +1072,12 @@ void CVulkanMathEngine::BlobChannelwiseConvolutionLearnAdd( const CChannelwiseCo
 	ASSERT_EXPR( false );
 }
 
+void CVulkanMathEngine::BlobQuantizedConvolution( const CConvolutionDesc&, const CConstFloatHandle&, float, int,
+	const CConstInt8Handle&, const CConstFloatHandle&, const CConstFloatHandle*, const CActivationInfo&, const CFloatHandle& )
+{
+	ASSERT_EXPR( false );
+}
+
 } // namespace NeoML
 
 #endif // NEOML_USE_VULKAN
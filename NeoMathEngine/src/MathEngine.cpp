@@ -208,9 +208,9 @@ IMathEngineExceptionHandler* GetMathEngineExceptionHandler()
 	return exceptionHandler;
 }
 
-IMathEngine* CreateCpuMathEngine( int threadCount, size_t memoryLimit )
+IMathEngine* CreateCpuMathEngine( int threadCount, size_t memoryLimit, int flags )
 {
-	return new CCpuMathEngine( threadCount, memoryLimit );
+	return new CCpuMathEngine( threadCount, memoryLimit, flags );
 }
 
 IMathEngine* CreateGpuMathEngine( size_t memoryLimit, int flags )
@@ -0,0 +1,113 @@
+/* Copyright © 2017-2020 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <MathEngineActivation.h>
+
+namespace NeoML {
+
+// The maximum size of the temporary buffer used for GELU
+static const int GELUBlockSize = 64 * 1024;
+
+void ApplyActivationByVectorOperations( IMathEngine& mathEngine, const CActivationInfo& activation,
+	const CFloatHandle& data, int dataSize )
+{
+	static_assert( AF_Count == 12, "AF_Count != 12" );
+	switch( activation.Type ) {
+		case AF_Linear:
+		{
+			if( activation.Param1 != 1.f ) {
+				CFloatHandleStackVar multiplier( mathEngine );
+				multiplier.SetValue( activation.Param1 );
+				mathEngine.VectorMultiply( data, data, dataSize, multiplier );
+			}
+			if( activation.Param2 != 0.f ) {
+				CFloatHandleStackVar freeTerm( mathEngine );
+				freeTerm.SetValue( activation.Param2 );
+				mathEngine.VectorAddValue( data, data, dataSize, freeTerm );
+			}
+			break;
+		}
+		case AF_ELU:
+		{
+			CFloatHandleStackVar alpha( mathEngine );
+			alpha.SetValue( activation.Param1 );
+			mathEngine.VectorELU( data, data, dataSize, alpha );
+			break;
+		}
+		case AF_ReLU:
+		{
+			CFloatHandleStackVar threshold( mathEngine );
+			threshold.SetValue( activation.Param1 );
+			mathEngine.VectorReLU( data, data, dataSize, threshold );
+			break;
+		}
+		case AF_LeakyReLU:
+		{
+			CFloatHandleStackVar alpha( mathEngine );
+			alpha.SetValue( activation.Param1 );
+			mathEngine.VectorLeakyReLU( data, data, dataSize, alpha );
+			break;
+		}
+		case AF_Abs:
+			mathEngine.VectorAbs( data, data, dataSize );
+			break;
+		case AF_Sigmoid:
+			mathEngine.VectorSigmoid( data, data, dataSize );
+			break;
+		case AF_Tanh:
+			mathEngine.VectorTanh( data, data, dataSize );
+			break;
+		case AF_HardTanh:
+			mathEngine.VectorHardTanh( data, data, dataSize );
+			break;
+		case AF_HardSigmoid:
+		{
+			CFloatHandleStackVar slope( mathEngine );
+			slope.SetValue( activation.Param1 );
+			CFloatHandleStackVar bias( mathEngine );
+			bias.SetValue( activation.Param2 );
+			mathEngine.VectorHardSigmoid( data, data, dataSize, slope, bias );
+			break;
+		}
+		case AF_Power:
+			mathEngine.VectorPower( activation.Param1, data, data, dataSize );
+			break;
+		case AF_HSwish:
+			mathEngine.VectorHSwish( data, data, dataSize );
+			break;
+		case AF_GELU:
+		{
+			// The data is processed by blocks so that the temporary buffer does not grow with the output
+			const int blockSize = min( dataSize, GELUBlockSize );
+			CFloatHandleStackVar buffer( mathEngine, static_cast<size_t>( blockSize ) + 1 );
+			CFloatHandle multiplier = buffer.GetHandle() + blockSize;
+			multiplier.SetValue( 1.702f );
+			for( int start = 0; start < dataSize; start += blockSize ) {
+				const int size = min( dataSize - start, blockSize );
+				mathEngine.VectorMultiply( data + start, buffer.GetHandle(), size, multiplier );
+				mathEngine.VectorSigmoid( buffer.GetHandle(), buffer.GetHandle(), size );
+				mathEngine.VectorEltwiseMultiply( data + start, buffer.GetHandle(), data + start, size );
+			}
+			break;
+		}
+		default:
+			ASSERT_EXPR( false );
+	}
+}
+
+} // namespace NeoML
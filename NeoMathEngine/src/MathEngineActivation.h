@@ -0,0 +1,27 @@
+/* Copyright © 2017-2020 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <NeoMathEngine/NeoMathEngine.h>
+
+namespace NeoML {
+
+// Applies the activation function to the data in place, using the vector operations of the math engine
+// Used by the math engines that have no kernels calculating the activation together with the result
+void ApplyActivationByVectorOperations( IMathEngine& mathEngine, const CActivationInfo& activation,
+	const CFloatHandle& data, int dataSize );
+
+} // namespace NeoML
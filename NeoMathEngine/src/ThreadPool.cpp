@@ -0,0 +1,264 @@
+/* Copyright © 2017-2021 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <NeoMathEngine/ThreadPool.h>
+#include <NeoMathEngine/NeoMathEngineException.h>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace NeoML {
+
+// The task run by the current thread
+static thread_local int currentThreadNum = 0;
+static thread_local int currentThreadCount = 0;
+
+bool GetThreadPoolTaskInfo( int& threadNum, int& threadCount )
+{
+	if( currentThreadCount == 0 ) {
+		return false;
+	}
+	threadNum = currentThreadNum;
+	threadCount = currentThreadCount;
+	return true;
+}
+
+IThreadPool::~IThreadPool()
+{
+}
+
+//------------------------------------------------------------------------------------------------------------
+
+// The parallel calculation started by one RunParallel call
+struct CThreadPoolJob {
+	IThreadPool::TTask Task;
+	void* Params;
+	int ThreadCount;
+	std::atomic<int> RemainingCount; // the number of tasks not finished yet
+	std::mutex Mutex;
+	std::condition_variable Finished;
+	bool IsFinished;
+	std::exception_ptr Exception; // the first exception thrown by the tasks
+
+	CThreadPoolJob( IThreadPool::TTask task, void* params, int threadCount ) :
+		Task( task ), Params( params ), ThreadCount( threadCount ), RemainingCount( threadCount ), IsFinished( false ) {}
+};
+
+// One call of the job task
+struct CThreadPoolTask {
+	CThreadPoolJob* Job;
+	int ThreadNum;
+};
+
+// The queue of the tasks of a thread
+struct CThreadPoolQueue {
+	std::mutex Mutex;
+	std::deque<CThreadPoolTask> Tasks;
+};
+
+// The work-stealing thread pool
+class CThreadPool : public IThreadPool {
+public:
+	explicit CThreadPool( int threadCount );
+	~CThreadPool() override;
+
+	int Size() const override { return static_cast<int>( threads.size() ) + 1; }
+	void RunParallel( int threadCount, TTask task, void* params ) override;
+
+private:
+	std::vector<std::unique_ptr<CThreadPoolQueue>> queues; // the queues of the worker threads
+	std::vector<std::thread> threads; // the worker threads
+	std::mutex mutex;
+	std::condition_variable wakeUp; // signals the idle worker threads
+	int queuedTaskCount; // the number of tasks in the queues, guarded by the mutex
+	bool isStopping;
+
+	bool popTask( int queueIndex, CThreadPoolTask& task );
+	bool stealTask( int firstQueueIndex, CThreadPoolTask& task );
+	void onTaskTaken();
+	static void runTask( const CThreadPoolTask& task );
+	void workerThread( int queueIndex );
+};
+
+CThreadPool::CThreadPool( int threadCount ) :
+	queuedTaskCount( 0 ),
+	isStopping( false )
+{
+	ASSERT_EXPR( threadCount > 0 );
+	for( int i = 0; i < threadCount - 1; i++ ) {
+		queues.emplace_back( new CThreadPoolQueue() );
+	}
+	for( int i = 0; i < threadCount - 1; i++ ) {
+		threads.emplace_back( &CThreadPool::workerThread, this, i );
+	}
+}
+
+CThreadPool::~CThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock( mutex );
+		isStopping = true;
+	}
+	wakeUp.notify_all();
+	for( std::thread& thread : threads ) {
+		thread.join();
+	}
+}
+
+void CThreadPool::RunParallel( int threadCount, TTask task, void* params )
+{
+	if( threadCount <= 0 ) {
+		return;
+	}
+
+	if( currentThreadCount != 0 || threads.empty() || threadCount == 1 ) {
+		// Nested calculation or nothing to parallelize: run all the tasks on this thread
+		const int prevThreadNum = currentThreadNum;
+		const int prevThreadCount = currentThreadCount;
+		currentThreadCount = threadCount;
+		try {
+			for( int i = 0; i < threadCount; i++ ) {
+				currentThreadNum = i;
+				task( i, params );
+			}
+		} catch( ... ) {
+			currentThreadNum = prevThreadNum;
+			currentThreadCount = prevThreadCount;
+			throw;
+		}
+		currentThreadNum = prevThreadNum;
+		currentThreadCount = prevThreadCount;
+		return;
+	}
+
+	CThreadPoolJob job( task, params, threadCount );
+	// The first task is run by this thread, the rest are spread across the queues of the worker threads
+	for( int i = 1; i < threadCount; i++ ) {
+		CThreadPoolQueue& queue = *queues[( i - 1 ) % queues.size()];
+		std::lock_guard<std::mutex> lock( queue.Mutex );
+		queue.Tasks.push_back( CThreadPoolTask{ &job, i } );
+	}
+	{
+		std::lock_guard<std::mutex> lock( mutex );
+		queuedTaskCount += threadCount - 1;
+	}
+	wakeUp.notify_all();
+
+	runTask( CThreadPoolTask{ &job, 0 } );
+
+	// Help the worker threads while the job is not finished
+	CThreadPoolTask otherTask;
+	while( job.RemainingCount.load() > 0 && stealTask( 0, otherTask ) ) {
+		runTask( otherTask );
+	}
+
+	std::unique_lock<std::mutex> lock( job.Mutex );
+	job.Finished.wait( lock, [&job] { return job.IsFinished; } );
+	if( job.Exception != nullptr ) {
+		std::rethrow_exception( job.Exception );
+	}
+}
+
+// Takes the last task of the own queue of the thread
+bool CThreadPool::popTask( int queueIndex, CThreadPoolTask& task )
+{
+	CThreadPoolQueue& queue = *queues[queueIndex];
+	std::lock_guard<std::mutex> lock( queue.Mutex );
+	if( queue.Tasks.empty() ) {
+		return false;
+	}
+	task = queue.Tasks.back();
+	queue.Tasks.pop_back();
+	onTaskTaken();
+	return true;
+}
+
+// Takes the first task of another queue, starting the search with the specified one
+bool CThreadPool::stealTask( int firstQueueIndex, CThreadPoolTask& task )
+{
+	const int queueCount = static_cast<int>( queues.size() );
+	for( int i = 0; i < queueCount; i++ ) {
+		CThreadPoolQueue& queue = *queues[( firstQueueIndex + i ) % queueCount];
+		std::lock_guard<std::mutex> lock( queue.Mutex );
+		if( !queue.Tasks.empty() ) {
+			task = queue.Tasks.front();
+			queue.Tasks.pop_front();
+			onTaskTaken();
+			return true;
+		}
+	}
+	return false;
+}
+
+void CThreadPool::onTaskTaken()
+{
+	std::lock_guard<std::mutex> lock( mutex );
+	queuedTaskCount--;
+}
+
+void CThreadPool::runTask( const CThreadPoolTask& task )
+{
+	CThreadPoolJob& job = *task.Job;
+	currentThreadNum = task.ThreadNum;
+	currentThreadCount = job.ThreadCount;
+	try {
+		job.Task( task.ThreadNum, job.Params );
+	} catch( ... ) {
+		std::lock_guard<std::mutex> lock( job.Mutex );
+		if( job.Exception == nullptr ) {
+			job.Exception = std::current_exception();
+		}
+	}
+	currentThreadNum = 0;
+	currentThreadCount = 0;
+
+	if( --job.RemainingCount == 0 ) {
+		// The job object may be destroyed as soon as the mutex is released
+		std::lock_guard<std::mutex> lock( job.Mutex );
+		job.IsFinished = true;
+		job.Finished.notify_all();
+	}
+}
+
+void CThreadPool::workerThread( int queueIndex )
+{
+	while( true ) {
+		CThreadPoolTask task;
+		if( popTask( queueIndex, task ) || stealTask( queueIndex + 1, task ) ) {
+			runTask( task );
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock( mutex );
+		wakeUp.wait( lock, [this] { return isStopping || queuedTaskCount > 0; } );
+		if( isStopping && queuedTaskCount == 0 ) {
+			return;
+		}
+	}
+}
+
+IThreadPool* CreateThreadPool( int threadCount )
+{
+	return new CThreadPool( threadCount );
+}
+
+} // namespace NeoML
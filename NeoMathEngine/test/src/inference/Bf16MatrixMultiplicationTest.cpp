@@ -0,0 +1,146 @@
+/* Copyright © 2017-2020 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <TestFixture.h>
+#include <cstring>
+#include <memory>
+
+using namespace NeoML;
+using namespace NeoMLTest;
+
+// Rounds to the nearest bfloat16 value (ties to even)
+static float roundToBf16( float value )
+{
+	uint32_t bits;
+	memcpy( &bits, &value, sizeof( bits ) );
+	bits += 0x7fff + ( ( bits >> 16 ) & 1 );
+	bits &= 0xffff0000;
+	memcpy( &value, &bits, sizeof( value ) );
+	return value;
+}
+
+// result = op(first) * op(second), op(first) is height * depth, op(second) is depth * width
+static void multiplyNaive( const std::vector<float>& first, bool transFirst, const std::vector<float>& second, bool transSecond,
+	int height, int width, int depth, bool roundValues, std::vector<float>& result )
+{
+	result.assign( height * width, 0.f );
+	for( int i = 0; i < height; ++i ) {
+		for( int j = 0; j < width; ++j ) {
+			double sum = 0;
+			for( int k = 0; k < depth; ++k ) {
+				float a = transFirst ? first[k * height + i] : first[i * depth + k];
+				float b = transSecond ? second[j * depth + k] : second[k * width + j];
+				if( roundValues ) {
+					a = roundToBf16( a );
+					b = roundToBf16( b );
+				}
+				sum += static_cast<double>( a ) * b;
+			}
+			result[i * width + j] = static_cast<float>( sum );
+		}
+	}
+}
+
+static float maxDiff( const std::vector<float>& first, const std::vector<float>& second )
+{
+	float diff = 0;
+	for( size_t i = 0; i < first.size(); ++i ) {
+		diff = std::max( diff, std::fabs( first[i] - second[i] ) );
+	}
+	return diff;
+}
+
+static void bf16MatrixMultiplicationTestImpl( const CTestParams& params, int seed )
+{
+	CRandom random( seed );
+
+	const CInterval heightInterval = params.GetInterval( "Height" );
+	const CInterval widthInterval = params.GetInterval( "Width" );
+	const CInterval depthInterval = params.GetInterval( "Depth" );
+
+	const int height = random.UniformInt( heightInterval.Begin, heightInterval.End );
+	const int width = random.UniformInt( widthInterval.Begin, widthInterval.End );
+	const int depth = random.UniformInt( depthInterval.Begin, depthInterval.End );
+
+	CREATE_FILL_FLOAT_ARRAY( first, -1.f, 1.f, height * depth, random )
+	CREATE_FILL_FLOAT_ARRAY( second, -1.f, 1.f, depth * width, random )
+
+	std::unique_ptr<IMathEngine> engine( CreateCpuMathEngine( 1, 0, CpuMathEngineBf16MatrixMultiplicationFlag ) );
+
+	for( int mode = 0; mode < 3; ++mode ) {
+		const bool transFirst = mode == 1;
+		const bool transSecond = mode == 2;
+		std::vector<float> result( height * width );
+		{
+			CFloatWrapper firstWrapper( *engine, first.data(), height * depth );
+			CFloatWrapper secondWrapper( *engine, second.data(), depth * width );
+			CFloatWrapper resultWrapper( *engine, result.data(), height * width );
+			if( transFirst ) {
+				engine->MultiplyTransposedMatrixByMatrix( 1, firstWrapper, depth, height, secondWrapper, width,
+					resultWrapper, height * width );
+			} else if( transSecond ) {
+				engine->MultiplyMatrixByTransposedMatrix( 1, firstWrapper, height, depth, secondWrapper, width,
+					resultWrapper, height * width );
+			} else {
+				engine->MultiplyMatrixByMatrix( 1, firstWrapper, height, depth, secondWrapper, width,
+					resultWrapper, height * width );
+			}
+		}
+
+		std::vector<float> expected;
+		multiplyNaive( first, transFirst, second, transSecond, height, width, depth, false, expected );
+		std::vector<float> bf16Expected;
+		multiplyNaive( first, transFirst, second, transSecond, height, width, depth, true, bf16Expected );
+
+		// The flag is ignored if the CPU doesn't support bfloat16
+		const bool isBf16 = maxDiff( result, bf16Expected ) < maxDiff( result, expected );
+		for( int i = 0; i < height * width; ++i ) {
+			ASSERT_NEAR( isBf16 ? bf16Expected[i] : expected[i], result[i], 1e-3 );
+			// bfloat16 has 8 significant bits
+			ASSERT_NEAR( expected[i], result[i], 2e-2 * std::sqrt( static_cast<float>( depth ) ) );
+		}
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+class CBf16MatrixMultiplicationTest : public CTestFixtureWithParams {
+};
+
+INSTANTIATE_TEST_CASE_P( CBf16MatrixMultiplicationTestInstantiation, CBf16MatrixMultiplicationTest,
+	::testing::Values(
+		CTestParams(
+			"Height = (1..20);"
+			"Width = (1..40);"
+			"Depth = (1..40);"
+			"TestCount = 50;"
+		),
+		CTestParams(
+			"Height = (100..300);"
+			"Width = (30..100);"
+			"Depth = (500..1100);"
+			"TestCount = 3;"
+		)
+	)
+);
+
+TEST_P( CBf16MatrixMultiplicationTest, Random )
+{
+	if( MathEngine().GetType() != MET_Cpu ) {
+		return;
+	}
+
+	RUN_TEST_IMPL( bf16MatrixMultiplicationTestImpl )
+}
@@ -143,8 +143,14 @@ static void blobConvolutionImpl( const CTestParams& params, int seed )
 		paddingHeight, paddingWidth, filterCount, filterHeight, filterWidth,
 		dilationHeight, dilationWidth, strideHeight, strideWidth );
 
+	// The algorithms sum the products in different order (the Winograd algorithm also transforms them),
+	// so the error is compared with the magnitude of the whole output rather than of each element
+	float maxValue = 1.f;
 	for( int i = 0; i < outputSize; ++i ) {
-		ASSERT_TRUE( FloatEq( expectedData[i], actualData[i] ) );
+		maxValue = std::max( maxValue, std::abs( expectedData[i] ) );
+	}
+	for( int i = 0; i < outputSize; ++i ) {
+		ASSERT_NEAR( expectedData[i], actualData[i], 1e-5f * maxValue );
 	}
 }
 
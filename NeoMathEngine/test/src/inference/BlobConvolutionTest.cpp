@@ -132,7 +132,6 @@ static void blobConvolutionImpl( const CTestParams& params, int seed )
 
 	MathEngine().BlobConvolution( *convDesc, inputBlob.GetData(), filterBlob.GetData(),
 		isZeroFreeTerm ? 0 : &freeTermDataPtr, outputBlob.GetData() );
-	delete convDesc;
 
 	const int outputSize = inputLength * inputBatch * outputHeight * outputWidth * 1 * filterCount;
 	std::vector<float> expectedData( outputSize );
@@ -147,6 +146,18 @@ static void blobConvolutionImpl( const CTestParams& params, int seed )
 	for( int i = 0; i < outputSize; ++i ) {
 		ASSERT_TRUE( FloatEq( expectedData[i], actualData[i], 1e-3f ) );
 	}
+
+	// The same convolution with the activation applied inside the kernel
+	const CActivationInfo activation( AF_LeakyReLU, 0.1f );
+	MathEngine().BlobConvolution( *convDesc, inputBlob.GetData(), filterBlob.GetData(),
+		isZeroFreeTerm ? 0 : &freeTermDataPtr, activation, outputBlob.GetData() );
+	delete convDesc;
+
+	outputBlob.CopyTo( actualData.data() );
+	for( int i = 0; i < outputSize; ++i ) {
+		const float expected = expectedData[i] > 0 ? expectedData[i] : activation.Param1 * expectedData[i];
+		ASSERT_TRUE( FloatEq( expected, actualData[i], 1e-3f ) );
+	}
 }
 
 //------------------------------------------------------------------------------------------------------------
@@ -635,6 +646,26 @@ INSTANTIATE_TEST_CASE_P( CMathEngineBlobConvolutionTestInstantiation, CMathEngin
 			"IsZeroFreeTerm = 1;"
 			"Values = (-10..10);"
 			"TestCount = 1;"
+		),
+		CTestParams(
+			"InputLength = 1;"
+			"InputBatch = (1..3);"
+			"InputHeight = (4..17);"
+			"InputWidth = (4..17);"
+			"InputDepth = (1..2);"
+			"InputChannels = (8..20);"
+			"FilterCount = (8..16);"
+			"FilterHeight = 3;"
+			"FilterWidth = 3;"
+			"PaddingHeight = (0..2);"
+			"PaddingWidth = (0..2);"
+			"DilationHeight = 1;"
+			"DilationWidth = 1;"
+			"StrideHeight = 1;"
+			"StrideWidth = 1;"
+			"IsZeroFreeTerm = (0..1);"
+			"Values = (-10..10);"
+			"TestCount = 30;"
 		)
 	)
 );
@@ -643,3 +674,51 @@ TEST_P( CMathEngineBlobConvolutionTest, Random )
 {
 	RUN_TEST_IMPL( blobConvolutionImpl );
 }
+
+TEST_F( CMathEngineBlobConvolutionTest, FilterChange )
+{
+	// The same descriptor is used with different filters
+	// (the engine may keep the data calculated from the filter until ResetFilterCache is called)
+	CRandom random( 0x1234 );
+
+	const int batch = 2;
+	const int height = 9;
+	const int width = 8;
+	const int channels = 12;
+	const int filterCount = 10;
+	const int inputSize = batch * height * width * channels;
+	const int filterSize = filterCount * 3 * 3 * channels;
+	const int outputSize = batch * height * width * filterCount;
+
+	CREATE_FILL_FLOAT_ARRAY( inputData, -5.f, 5.f, inputSize, random )
+	CFloatBlob inputBlob( MathEngine(), 1, batch, 1, height, width, 1, channels );
+	inputBlob.CopyFrom( inputData.data() );
+
+	CFloatBlob filterBlob( MathEngine(), filterCount, 3, 3, 1, channels );
+	CFloatBlob outputBlob( MathEngine(), 1, batch, 1, height, width, 1, filterCount );
+
+	CConvolutionDesc* convDesc = MathEngine().InitBlobConvolution( inputBlob.GetDesc(), 1, 1, 1, 1, 1, 1,
+		filterBlob.GetDesc(), outputBlob.GetDesc() );
+
+	std::vector<float> freeTermData( filterCount, 0.f );
+	for( int run = 0; run < 3; ++run ) {
+		CREATE_FILL_FLOAT_ARRAY( filterData, -5.f, 5.f, filterSize, random )
+		filterBlob.CopyFrom( filterData.data() );
+		convDesc->ResetFilterCache();
+
+		MathEngine().BlobConvolution( *convDesc, inputBlob.GetData(), filterBlob.GetData(), 0, outputBlob.GetData() );
+
+		std::vector<float> expectedData( outputSize );
+		std::vector<float> actualData( outputSize );
+		outputBlob.CopyTo( actualData.data() );
+
+		batchConvolutionForward( inputData.data(), filterData.data(), freeTermData.data(), expectedData.data(),
+			1, batch, height, width, 1, channels, 1, 1, filterCount, 3, 3, 1, 1, 1, 1 );
+
+		for( int i = 0; i < outputSize; ++i ) {
+			ASSERT_TRUE( FloatEq( expectedData[i], actualData[i], 1e-3f ) );
+		}
+	}
+
+	delete convDesc;
+}
@@ -0,0 +1,150 @@
+/* Copyright © 2017-2021 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <TestFixture.h>
+
+using namespace NeoML;
+using namespace NeoMLTest;
+
+static inline float sigmoid( float x )
+{
+	return 1.f / ( 1.f + ::expf( -x ) );
+}
+
+static void gruRecurrentNaive( bool reverse, int seqLength, int batchSize, int hiddenSize,
+	const std::vector<float>& inputGates, const std::vector<float>& inputMain,
+	const float* gateWeights, const float* mainWeights, int weightsRowSize,
+	const float* initialOutput, std::vector<float>& output )
+{
+	const int gatesSize = 2 * hiddenSize;
+	std::vector<float> zero( batchSize * hiddenSize );
+	const float* prevOutput = initialOutput == nullptr ? zero.data() : initialOutput;
+	for( int step = 0; step < seqLength; ++step ) {
+		const int pos = reverse ? seqLength - 1 - step : step;
+		for( int b = 0; b < batchSize; ++b ) {
+			const float* prev = prevOutput + b * hiddenSize;
+			std::vector<float> gates( gatesSize );
+			for( int g = 0; g < gatesSize; ++g ) {
+				gates[g] = inputGates[( pos * batchSize + b ) * gatesSize + g];
+				for( int k = 0; k < hiddenSize; ++k ) {
+					gates[g] += prev[k] * gateWeights[g * weightsRowSize + k];
+				}
+				gates[g] = sigmoid( gates[g] );
+			}
+			for( int i = 0; i < hiddenSize; ++i ) {
+				float main = inputMain[( pos * batchSize + b ) * hiddenSize + i];
+				for( int k = 0; k < hiddenSize; ++k ) {
+					main += gates[hiddenSize + k] * prev[k] * mainWeights[i * weightsRowSize + k];
+				}
+				main = ::tanhf( main );
+				const float update = gates[i];
+				output[( pos * batchSize + b ) * hiddenSize + i] = ( 1.f - update ) * main + update * prev[i];
+			}
+		}
+		prevOutput = output.data() + pos * batchSize * hiddenSize;
+	}
+}
+
+static void gruInferenceTestImpl( const CTestParams& params, int seed )
+{
+	CRandom random( seed );
+	const CInterval batchLengthInterval = params.GetInterval( "BatchLength" );
+	const CInterval batchWidthInterval = params.GetInterval( "BatchWidth" );
+	const CInterval hiddenSizeInterval = params.GetInterval( "HiddenSize" );
+	const CInterval inputSizeInterval = params.GetInterval( "InputSize" );
+
+	const int batchLength = random.UniformInt( batchLengthInterval.Begin, batchLengthInterval.End );
+	const int batchWidth = random.UniformInt( batchWidthInterval.Begin, batchWidthInterval.End );
+	const int hiddenSize = random.UniformInt( hiddenSizeInterval.Begin, hiddenSizeInterval.End );
+	// The recurrent weights are the right parts of the [input, hidden] matrices
+	const int inputSize = random.UniformInt( inputSizeInterval.Begin, inputSizeInterval.End );
+	const int weightsRowSize = inputSize + hiddenSize;
+	const bool reverse = random.Next() % 2 == 1;
+	const bool hasInitialState = random.Next() % 2 == 1;
+
+	const int dataSize = batchLength * batchWidth * hiddenSize;
+
+	CREATE_FILL_FLOAT_ARRAY( inputGatesData, -1.f, 1.f, 2 * dataSize, random );
+	CFloatBlob inputGatesBlob( MathEngine(), batchLength, batchWidth, 1, 1, 1, 1, 2 * hiddenSize );
+	inputGatesBlob.CopyFrom( inputGatesData.data() );
+
+	CREATE_FILL_FLOAT_ARRAY( inputMainData, -1.f, 1.f, dataSize, random );
+	CFloatBlob inputMainBlob( MathEngine(), batchLength, batchWidth, 1, 1, 1, 1, hiddenSize );
+	inputMainBlob.CopyFrom( inputMainData.data() );
+
+	CREATE_FILL_FLOAT_ARRAY( gateWeightsData, -0.5f, 0.5f, 2 * hiddenSize * weightsRowSize, random );
+	CFloatBlob gateWeightsBlob( MathEngine(), 1, 2 * hiddenSize, 1, 1, 1, 1, weightsRowSize );
+	gateWeightsBlob.CopyFrom( gateWeightsData.data() );
+
+	CREATE_FILL_FLOAT_ARRAY( mainWeightsData, -0.5f, 0.5f, hiddenSize * weightsRowSize, random );
+	CFloatBlob mainWeightsBlob( MathEngine(), 1, hiddenSize, 1, 1, 1, 1, weightsRowSize );
+	mainWeightsBlob.CopyFrom( mainWeightsData.data() );
+
+	CREATE_FILL_FLOAT_ARRAY( initialOutputData, -1.f, 1.f, batchWidth * hiddenSize, random );
+	CFloatBlob initialOutputBlob( MathEngine(), 1, batchWidth, 1, 1, 1, 1, hiddenSize );
+	initialOutputBlob.CopyFrom( initialOutputData.data() );
+
+	std::vector<float> expected( dataSize );
+	gruRecurrentNaive( reverse, batchLength, batchWidth, hiddenSize, inputGatesData, inputMainData,
+		gateWeightsData.data() + inputSize, mainWeightsData.data() + inputSize, weightsRowSize,
+		hasInitialState ? initialOutputData.data() : nullptr, expected );
+
+	CFloatBlob outputBlob( MathEngine(), batchLength, batchWidth, 1, 1, 1, 1, hiddenSize );
+	MathEngine().GruRecurrent( reverse, batchLength, batchWidth, hiddenSize,
+		inputGatesBlob.GetData(), inputMainBlob.GetData(),
+		gateWeightsBlob.GetData() + inputSize, mainWeightsBlob.GetData() + inputSize, weightsRowSize,
+		hasInitialState ? initialOutputBlob.GetData() : CFloatHandle(), outputBlob.GetData() );
+
+	std::vector<float> actual( dataSize );
+	outputBlob.CopyTo( actual.data() );
+
+	for( int i = 0; i < dataSize; ++i ) {
+		EXPECT_TRUE( FloatEq( expected[i], actual[i], 1e-4f ) );
+	}
+}
+
+class CGruInferenceTest : public CTestFixtureWithParams {
+};
+
+INSTANTIATE_TEST_CASE_P( CGruInferenceTest, CGruInferenceTest,
+	::testing::Values(
+		CTestParams(
+			"BatchLength = (1..20);"
+			"BatchWidth = (1..10);"
+			"HiddenSize = (1..10);"
+			"InputSize = (0..10);"
+			"TestCount = 200;"
+		),
+		CTestParams(
+			"BatchLength = (1..10);"
+			"BatchWidth = (10..50);"
+			"HiddenSize = (50..100);"
+			"InputSize = (10..50);"
+			"TestCount = 5;"
+		)
+	)
+);
+
+TEST_P( CGruInferenceTest, Random )
+{
+	CMathEngineInfo info;
+	MathEngine().GetMathEngineInfo( info );
+	if( info.Type != MET_Cpu ) {
+		// The fused GRU is supported only on CPU
+		return;
+	}
+
+	RUN_TEST_IMPL( gruInferenceTestImpl );
+}
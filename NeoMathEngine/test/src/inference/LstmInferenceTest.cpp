@@ -0,0 +1,147 @@
+/* Copyright © 2017-2021 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <TestFixture.h>
+
+using namespace NeoML;
+using namespace NeoMLTest;
+
+static inline float sigmoid( float x )
+{
+	return 1.f / ( 1.f + ::expf( -x ) );
+}
+
+static void lstmRecurrentNaive( bool reverse, int seqLength, int batchSize, int hiddenSize,
+	const std::vector<float>& inputGates, const std::vector<float>& recurWeights,
+	const float* initialOutput, const float* initialState, std::vector<float>& output, std::vector<float>& state )
+{
+	const int gatesSize = 4 * hiddenSize;
+	const float* prevOutput = initialOutput;
+	const float* prevState = initialState;
+	for( int step = 0; step < seqLength; ++step ) {
+		const int pos = reverse ? seqLength - 1 - step : step;
+		for( int b = 0; b < batchSize; ++b ) {
+			std::vector<float> gates( gatesSize );
+			for( int g = 0; g < gatesSize; ++g ) {
+				gates[g] = inputGates[( pos * batchSize + b ) * gatesSize + g];
+				if( prevOutput != nullptr ) {
+					for( int k = 0; k < hiddenSize; ++k ) {
+						gates[g] += prevOutput[b * hiddenSize + k] * recurWeights[g * hiddenSize + k];
+					}
+				}
+			}
+			for( int i = 0; i < hiddenSize; ++i ) {
+				const float main = ::tanhf( gates[i] );
+				const float forget = sigmoid( gates[hiddenSize + i] );
+				const float input = sigmoid( gates[2 * hiddenSize + i] );
+				const float reset = sigmoid( gates[3 * hiddenSize + i] );
+				const int index = ( pos * batchSize + b ) * hiddenSize + i;
+				state[index] = input * main + ( prevState == nullptr ? 0.f : forget * prevState[b * hiddenSize + i] );
+				output[index] = reset * ::tanhf( state[index] );
+			}
+		}
+		prevOutput = output.data() + pos * batchSize * hiddenSize;
+		prevState = state.data() + pos * batchSize * hiddenSize;
+	}
+}
+
+static void lstmInferenceTestImpl( const CTestParams& params, int seed )
+{
+	CRandom random( seed );
+	const CInterval batchLengthInterval = params.GetInterval( "BatchLength" );
+	const CInterval batchWidthInterval = params.GetInterval( "BatchWidth" );
+	const CInterval hiddenSizeInterval = params.GetInterval( "HiddenSize" );
+
+	const int batchLength = random.UniformInt( batchLengthInterval.Begin, batchLengthInterval.End );
+	const int batchWidth = random.UniformInt( batchWidthInterval.Begin, batchWidthInterval.End );
+	const int hiddenSize = random.UniformInt( hiddenSizeInterval.Begin, hiddenSizeInterval.End );
+	const bool reverse = random.Next() % 2 == 1;
+	const bool hasInitialState = random.Next() % 2 == 1;
+
+	const int dataSize = batchLength * batchWidth * hiddenSize;
+	const int stateSize = batchWidth * hiddenSize;
+
+	CREATE_FILL_FLOAT_ARRAY( inputGatesData, -1.f, 1.f, 4 * dataSize, random );
+	CFloatBlob inputGatesBlob( MathEngine(), batchLength, batchWidth, 1, 1, 1, 1, 4 * hiddenSize );
+	inputGatesBlob.CopyFrom( inputGatesData.data() );
+
+	CREATE_FILL_FLOAT_ARRAY( weightsData, -0.5f, 0.5f, 4 * hiddenSize * hiddenSize, random );
+	CFloatBlob weightsBlob( MathEngine(), 1, 4 * hiddenSize, 1, 1, 1, 1, hiddenSize );
+	weightsBlob.CopyFrom( weightsData.data() );
+
+	CREATE_FILL_FLOAT_ARRAY( initialOutputData, -1.f, 1.f, stateSize, random );
+	CFloatBlob initialOutputBlob( MathEngine(), 1, batchWidth, 1, 1, 1, 1, hiddenSize );
+	initialOutputBlob.CopyFrom( initialOutputData.data() );
+
+	CREATE_FILL_FLOAT_ARRAY( initialStateData, -1.f, 1.f, stateSize, random );
+	CFloatBlob initialStateBlob( MathEngine(), 1, batchWidth, 1, 1, 1, 1, hiddenSize );
+	initialStateBlob.CopyFrom( initialStateData.data() );
+
+	std::vector<float> expectedOutput( dataSize );
+	std::vector<float> expectedState( dataSize );
+	lstmRecurrentNaive( reverse, batchLength, batchWidth, hiddenSize, inputGatesData, weightsData,
+		hasInitialState ? initialOutputData.data() : nullptr, hasInitialState ? initialStateData.data() : nullptr,
+		expectedOutput, expectedState );
+
+	CFloatBlob outputBlob( MathEngine(), batchLength, batchWidth, 1, 1, 1, 1, hiddenSize );
+	CFloatBlob stateBlob( MathEngine(), batchLength, batchWidth, 1, 1, 1, 1, hiddenSize );
+	MathEngine().LstmRecurrent( reverse, batchLength, batchWidth, hiddenSize,
+		inputGatesBlob.GetData(), weightsBlob.GetData(),
+		hasInitialState ? initialOutputBlob.GetData() : CFloatHandle(),
+		hasInitialState ? initialStateBlob.GetData() : CFloatHandle(),
+		outputBlob.GetData(), stateBlob.GetData() );
+
+	std::vector<float> actualOutput( dataSize );
+	outputBlob.CopyTo( actualOutput.data() );
+	std::vector<float> actualState( dataSize );
+	stateBlob.CopyTo( actualState.data() );
+
+	for( int i = 0; i < dataSize; ++i ) {
+		EXPECT_TRUE( FloatEq( expectedOutput[i], actualOutput[i], 1e-4f ) );
+		EXPECT_TRUE( FloatEq( expectedState[i], actualState[i], 1e-4f ) );
+	}
+}
+
+class CLstmInferenceTest : public CTestFixtureWithParams {
+};
+
+INSTANTIATE_TEST_CASE_P( CLstmInferenceTest, CLstmInferenceTest,
+	::testing::Values(
+		CTestParams(
+			"BatchLength = (1..20);"
+			"BatchWidth = (1..10);"
+			"HiddenSize = (1..10);"
+			"TestCount = 200;"
+		),
+		CTestParams(
+			"BatchLength = (1..10);"
+			"BatchWidth = (10..50);"
+			"HiddenSize = (50..100);"
+			"TestCount = 5;"
+		)
+	)
+);
+
+TEST_P( CLstmInferenceTest, Random )
+{
+	CMathEngineInfo info;
+	MathEngine().GetMathEngineInfo( info );
+	if( info.Type != MET_Cpu ) {
+		// The fused LSTM is supported only on CPU
+		return;
+	}
+
+	RUN_TEST_IMPL( lstmInferenceTestImpl );
+}
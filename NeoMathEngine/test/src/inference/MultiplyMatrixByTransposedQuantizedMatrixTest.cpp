@@ -0,0 +1,107 @@
+/* Copyright © 2017-2021 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <TestFixture.h>
+
+using namespace NeoML;
+using namespace NeoMLTest;
+
+static void multiplyMatrixByTransposedQuantizedMatrixTestImpl( const CTestParams& params, int seed )
+{
+	CRandom random( seed );
+
+	const CInterval heightInterval = params.GetInterval( "Height" );
+	const CInterval widthInterval = params.GetInterval( "Width" );
+	const CInterval valuesInterval = params.GetInterval( "Values" );
+
+	const int secondHeight = random.UniformInt( heightInterval.Begin, heightInterval.End );
+	const int firstHeight = random.UniformInt( heightInterval.Begin, heightInterval.End );
+	const int firstWidth = random.UniformInt( widthInterval.Begin, widthInterval.End );
+
+	CREATE_FILL_FLOAT_ARRAY( a, valuesInterval.Begin, valuesInterval.End, firstHeight * firstWidth, random )
+	CREATE_FILL_FLOAT_ARRAY( b, valuesInterval.Begin, valuesInterval.End, firstWidth * secondHeight, random )
+	CREATE_FILL_FLOAT_ARRAY( freeTerm, valuesInterval.Begin, valuesInterval.End, secondHeight, random )
+	const CActivationInfo activation( AF_LeakyReLU, 0.1f );
+
+	std::vector<float> exp;
+	exp.insert( exp.begin(), firstHeight * secondHeight, 0.f );
+	for( int i = 0; i < firstHeight; ++i ) {
+		for( int j = 0; j < secondHeight; ++j ) {
+			float& value = exp[i * secondHeight + j];
+			value = freeTerm[j];
+			for( int k = 0; k < firstWidth; ++k ) {
+				value += a[i * firstWidth + k] * b[j * firstWidth + k];
+			}
+			value = value > 0 ? value : activation.Param1 * value;
+		}
+	}
+
+	// The first matrix is quantized with the range of its values
+	const float firstScale = static_cast<float>( valuesInterval.End - valuesInterval.Begin ) / 255;
+	const int firstZeroPoint = static_cast<int>( -valuesInterval.Begin / firstScale + 0.5f );
+
+	CIntHandleVar quantized( MathEngine(), ( firstWidth * secondHeight + 3 ) / 4 );
+	CFloatHandleVar scales( MathEngine(), secondHeight );
+	MathEngine().QuantizeMatrixRows( CARRAY_FLOAT_WRAPPER( b ), secondHeight, firstWidth,
+		CInt8Handle( quantized.GetHandle() ), scales.GetHandle() );
+
+	std::vector<float> result;
+	result.resize( firstHeight * secondHeight );
+	CFloatWrapper freeTermWrapper( MathEngine(), freeTerm.data(), secondHeight );
+	CConstFloatHandle freeTermHandle = freeTermWrapper;
+	MathEngine().MultiplyMatrixByTransposedQuantizedMatrix( CARRAY_FLOAT_WRAPPER( a ), firstHeight, firstWidth,
+		firstScale, firstZeroPoint, CInt8Handle( quantized.GetHandle() ), scales.GetHandle(), secondHeight,
+		&freeTermHandle, activation, CARRAY_FLOAT_WRAPPER( result ) );
+
+	// The error of each product is about the quantization step
+	const float tolerance = 2e-2f * firstWidth;
+	for( int i = 0; i < firstHeight * secondHeight; ++i ) {
+		ASSERT_NEAR( exp[i], result[i], tolerance );
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+
+class CMultiplyMatrixByTransposedQuantizedMatrixTest : public CTestFixtureWithParams {
+};
+
+INSTANTIATE_TEST_CASE_P( CMultiplyMatrixByTransposedQuantizedMatrixTestInstantiation, CMultiplyMatrixByTransposedQuantizedMatrixTest,
+	::testing::Values(
+		CTestParams(
+			"Height = (1..50);"
+			"Width = (1..50);"
+			"Values = (-1..1);"
+			"TestCount = 100;"
+		),
+		CTestParams(
+			"Height = (100..300);"
+			"Width = (100..300);"
+			"Values = (-1..2);"
+			"TestCount = 5;"
+		)
+	)
+);
+
+TEST_P( CMultiplyMatrixByTransposedQuantizedMatrixTest, Random )
+{
+	CMathEngineInfo info;
+	MathEngine().GetMathEngineInfo( info );
+	if( info.Type != MET_Cpu ) {
+		// Quantized inference is supported only on CPU
+		return;
+	}
+
+	RUN_TEST_IMPL( multiplyMatrixByTransposedQuantizedMatrixTestImpl )
+}
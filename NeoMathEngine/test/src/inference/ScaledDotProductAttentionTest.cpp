@@ -0,0 +1,152 @@
+/* Copyright © 2017-2021 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <TestFixture.h>
+
+using namespace NeoML;
+using namespace NeoMLTest;
+
+static void scaledDotProductAttentionNaive( int batchSize, int headCount, int queryLength, int keyLength, int headSize,
+	float scale, const std::vector<float>& query, const std::vector<float>& key, const std::vector<float>& value,
+	const float* mask, std::vector<float>& result )
+{
+	const int rowSize = headCount * headSize;
+	std::vector<float> scores( keyLength );
+	for( int b = 0; b < batchSize; ++b ) {
+		for( int h = 0; h < headCount; ++h ) {
+			for( int i = 0; i < queryLength; ++i ) {
+				const float* q = query.data() + ( b * queryLength + i ) * rowSize + h * headSize;
+				float maxScore = -FLT_MAX;
+				for( int j = 0; j < keyLength; ++j ) {
+					const float* k = key.data() + ( b * keyLength + j ) * rowSize + h * headSize;
+					float dot = 0;
+					for( int c = 0; c < headSize; ++c ) {
+						dot += q[c] * k[c];
+					}
+					scores[j] = dot * scale + ( mask == nullptr ? 0.f : mask[i * keyLength + j] );
+					maxScore = std::max( maxScore, scores[j] );
+				}
+				float sum = 0;
+				for( int j = 0; j < keyLength; ++j ) {
+					scores[j] = ::expf( scores[j] - maxScore );
+					sum += scores[j];
+				}
+				float* res = result.data() + ( b * queryLength + i ) * rowSize + h * headSize;
+				for( int c = 0; c < headSize; ++c ) {
+					res[c] = 0;
+					for( int j = 0; j < keyLength; ++j ) {
+						res[c] += scores[j] / sum * value[( b * keyLength + j ) * rowSize + h * headSize + c];
+					}
+				}
+			}
+		}
+	}
+}
+
+static void scaledDotProductAttentionTestImpl( const CTestParams& params, int seed )
+{
+	CRandom random( seed );
+	const CInterval batchSizeInterval = params.GetInterval( "BatchSize" );
+	const CInterval headCountInterval = params.GetInterval( "HeadCount" );
+	const CInterval queryLengthInterval = params.GetInterval( "QueryLength" );
+	const CInterval keyLengthInterval = params.GetInterval( "KeyLength" );
+	const CInterval headSizeInterval = params.GetInterval( "HeadSize" );
+
+	const int batchSize = random.UniformInt( batchSizeInterval.Begin, batchSizeInterval.End );
+	const int headCount = random.UniformInt( headCountInterval.Begin, headCountInterval.End );
+	const int queryLength = random.UniformInt( queryLengthInterval.Begin, queryLengthInterval.End );
+	const int keyLength = random.UniformInt( keyLengthInterval.Begin, keyLengthInterval.End );
+	const int headSize = random.UniformInt( headSizeInterval.Begin, headSizeInterval.End );
+	const float scale = static_cast<float>( 1. / sqrt( 1. * headSize ) );
+	const bool useMask = random.Next() % 2 == 1;
+
+	const int rowSize = headCount * headSize;
+	const int querySize = batchSize * queryLength * rowSize;
+	const int keySize = batchSize * keyLength * rowSize;
+
+	CREATE_FILL_FLOAT_ARRAY( queryData, -2.f, 2.f, querySize, random );
+	CFloatBlob queryBlob( MathEngine(), 1, batchSize, queryLength, 1, 1, 1, rowSize );
+	queryBlob.CopyFrom( queryData.data() );
+
+	CREATE_FILL_FLOAT_ARRAY( keyData, -2.f, 2.f, keySize, random );
+	CFloatBlob keyBlob( MathEngine(), 1, batchSize, keyLength, 1, 1, 1, rowSize );
+	keyBlob.CopyFrom( keyData.data() );
+
+	CREATE_FILL_FLOAT_ARRAY( valueData, -1.f, 1.f, keySize, random );
+	CFloatBlob valueBlob( MathEngine(), 1, batchSize, keyLength, 1, 1, 1, rowSize );
+	valueBlob.CopyFrom( valueData.data() );
+
+	// The mask hides some of the keys, but not the first one
+	std::vector<float> maskData( queryLength * keyLength );
+	for( int i = 0; i < queryLength; ++i ) {
+		for( int j = 1; j < keyLength; ++j ) {
+			maskData[i * keyLength + j] = random.Next() % 3 == 0 ? -1e9f : 0.f;
+		}
+	}
+	CFloatBlob maskBlob( MathEngine(), 1, 1, 1, 1, 1, queryLength, keyLength );
+	maskBlob.CopyFrom( maskData.data() );
+
+	std::vector<float> expected( querySize );
+	scaledDotProductAttentionNaive( batchSize, headCount, queryLength, keyLength, headSize, scale,
+		queryData, keyData, valueData, useMask ? maskData.data() : nullptr, expected );
+
+	CFloatBlob resultBlob( MathEngine(), 1, batchSize, queryLength, 1, 1, 1, rowSize );
+	MathEngine().ScaledDotProductAttention( batchSize, headCount, queryLength, keyLength, headSize, scale,
+		queryBlob.GetData(), keyBlob.GetData(), valueBlob.GetData(),
+		useMask ? maskBlob.GetData() : CFloatHandle(), resultBlob.GetData() );
+
+	std::vector<float> actual( querySize );
+	resultBlob.CopyTo( actual.data() );
+
+	for( int i = 0; i < querySize; ++i ) {
+		EXPECT_TRUE( FloatEq( expected[i], actual[i], 1e-4f ) );
+	}
+}
+
+class CScaledDotProductAttentionTest : public CTestFixtureWithParams {
+};
+
+INSTANTIATE_TEST_CASE_P( CScaledDotProductAttentionTest, CScaledDotProductAttentionTest,
+	::testing::Values(
+		CTestParams(
+			"BatchSize = (1..4);"
+			"HeadCount = (1..4);"
+			"QueryLength = (1..20);"
+			"KeyLength = (1..20);"
+			"HeadSize = (1..16);"
+			"TestCount = 100;"
+		),
+		CTestParams(
+			"BatchSize = (1..2);"
+			"HeadCount = (1..3);"
+			"QueryLength = (60..140);"
+			"KeyLength = (250..600);"
+			"HeadSize = (8..32);"
+			"TestCount = 5;"
+		)
+	)
+);
+
+TEST_P( CScaledDotProductAttentionTest, Random )
+{
+	CMathEngineInfo info;
+	MathEngine().GetMathEngineInfo( info );
+	if( info.Type != MET_Cpu ) {
+		// The fused attention is supported only on CPU
+		return;
+	}
+
+	RUN_TEST_IMPL( scaledDotProductAttentionTestImpl );
+}
@@ -0,0 +1,129 @@
+/* Copyright © 2021 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <TestFixture.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace NeoML;
+using namespace NeoMLTest;
+
+TEST( CThreadPoolTest, RunParallel )
+{
+	const int threadCount = 4;
+	std::unique_ptr<IThreadPool> threadPool( CreateThreadPool( threadCount ) );
+	EXPECT_EQ( threadCount, threadPool->Size() );
+
+	for( int taskCount = 1; taskCount <= 2 * threadCount; ++taskCount ) {
+		std::vector<std::atomic<int>> calls( taskCount );
+		for( auto& callCount : calls ) {
+			callCount = 0;
+		}
+		std::atomic<bool> isInfoValid( true );
+		ParallelRun( *threadPool, taskCount, [&] {
+			const int threadNum = OmpGetThreadNum();
+			if( OmpGetThreadCount() != taskCount || threadNum < 0 || threadNum >= taskCount ) {
+				isInfoValid = false;
+				return;
+			}
+			calls[threadNum]++;
+		} );
+		EXPECT_TRUE( isInfoValid.load() );
+		for( int i = 0; i < taskCount; ++i ) {
+			EXPECT_EQ( 1, calls[i].load() );
+		}
+	}
+
+	int threadNum = 0;
+	int threadCountInTask = 0;
+	EXPECT_FALSE( GetThreadPoolTaskInfo( threadNum, threadCountInTask ) );
+}
+
+TEST( CThreadPoolTest, ParallelFor )
+{
+	std::unique_ptr<IThreadPool> threadPool( CreateThreadPool( 3 ) );
+
+	const int count = 1000;
+	std::vector<int> values( count, 0 );
+	ParallelFor( *threadPool, 3, count, [&]( int index ) {
+		values[index] += index;
+	} );
+	for( int i = 0; i < count; ++i ) {
+		EXPECT_EQ( i, values[i] );
+	}
+
+	// Nested calls are performed on the calling thread
+	std::atomic<int> sum( 0 );
+	ParallelFor( *threadPool, 3, 10, [&]( int ) {
+		const int outerThreadNum = OmpGetThreadNum();
+		ParallelFor( *threadPool, 3, 10, [&]( int index ) {
+			sum += index;
+		} );
+		EXPECT_EQ( outerThreadNum, OmpGetThreadNum() );
+	} );
+	EXPECT_EQ( 10 * 45, sum.load() );
+}
+
+TEST( CThreadPoolTest, ConcurrentCallers )
+{
+	std::unique_ptr<IThreadPool> threadPool( CreateThreadPool( 4 ) );
+
+	const int callerCount = 4;
+	const int count = 10000;
+	std::vector<int64_t> sums( callerCount, 0 );
+	std::vector<std::thread> callers;
+	for( int c = 0; c < callerCount; ++c ) {
+		callers.emplace_back( [&, c] {
+			for( int run = 0; run < 10; ++run ) {
+				std::atomic<int64_t> sum( 0 );
+				ParallelFor( *threadPool, 4, count, [&]( int index ) {
+					sum += index;
+				} );
+				sums[c] += sum.load();
+			}
+		} );
+	}
+	for( auto& caller : callers ) {
+		caller.join();
+	}
+	for( int c = 0; c < callerCount; ++c ) {
+		EXPECT_EQ( 10 * static_cast<int64_t>( count ) * ( count - 1 ) / 2, sums[c] );
+	}
+}
+
+TEST( CThreadPoolTest, Exception )
+{
+	std::unique_ptr<IThreadPool> threadPool( CreateThreadPool( 4 ) );
+
+	bool isThrown = false;
+	try {
+		ParallelRun( *threadPool, 4, [] {
+			if( OmpGetThreadNum() == 2 ) {
+				throw std::logic_error( "test" );
+			}
+		} );
+	} catch( const std::logic_error& ) {
+		isThrown = true;
+	}
+	EXPECT_TRUE( isThrown );
+
+	// The pool is still usable
+	std::atomic<int> callCount( 0 );
+	ParallelRun( *threadPool, 4, [&] { callCount++; } );
+	EXPECT_EQ( 4, callCount.load() );
+}
@@ -0,0 +1,124 @@
+/* Copyright © 2017-2021 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <TestFixture.h>
+
+using namespace NeoML;
+using namespace NeoMLTest;
+
+static void adamStepNaive( const CAdamStepParams& params, const std::vector<float>& paramDiff,
+	std::vector<float>& param, std::vector<float>& moment, std::vector<float>& secondMoment,
+	std::vector<float>* secondMomentMax )
+{
+	for( size_t i = 0; i < param.size(); ++i ) {
+		float diff = paramDiff[i] + params.L2Regularization * param[i];
+		if( params.L1Regularization > 0 ) {
+			diff += std::min( params.L1Regularization, std::max( -params.L1Regularization, param[i] ) );
+		}
+		moment[i] = params.MomentDecayRate * moment[i] + ( 1 - params.MomentDecayRate ) * diff;
+		secondMoment[i] = params.SecondMomentDecayRate * secondMoment[i]
+			+ ( 1 - params.SecondMomentDecayRate ) * diff * diff;
+		float average = secondMoment[i];
+		if( secondMomentMax != nullptr ) {
+			( *secondMomentMax )[i] = std::max( ( *secondMomentMax )[i], secondMoment[i] );
+			average = ( *secondMomentMax )[i];
+		}
+		param[i] -= params.Rate * ( params.GradientMult * diff + params.MomentMult * moment[i] )
+			/ ( sqrtf( params.SecondMomentMult * average ) + params.Epsilon );
+	}
+}
+
+static void adamStepTestImpl( const CTestParams& params, int seed )
+{
+	CRandom random( seed );
+	const CInterval vectorSizeInterval = params.GetInterval( "VectorSize" );
+	const int vectorSize = random.UniformInt( vectorSizeInterval.Begin, vectorSizeInterval.End );
+	const bool useMax = random.Next() % 2 == 1;
+
+	CAdamStepParams stepParams;
+	stepParams.Rate = static_cast<float>( random.Uniform( 0.001, 0.1 ) );
+	stepParams.MomentDecayRate = static_cast<float>( random.Uniform( 0.5, 0.99 ) );
+	stepParams.SecondMomentDecayRate = static_cast<float>( random.Uniform( 0.9, 0.999 ) );
+	stepParams.Epsilon = 1e-6f;
+	stepParams.L1Regularization = random.Next() % 2 == 1 ? static_cast<float>( random.Uniform( 0.01, 0.5 ) ) : 0.f;
+	stepParams.L2Regularization = random.Next() % 2 == 1 ? static_cast<float>( random.Uniform( 0.01, 0.5 ) ) : 0.f;
+	if( random.Next() % 2 == 1 ) {
+		// The Nesterov variant
+		stepParams.GradientMult = static_cast<float>( random.Uniform( 0.1, 1 ) );
+		stepParams.MomentMult = static_cast<float>( random.Uniform( 0.5, 2 ) );
+		stepParams.SecondMomentMult = static_cast<float>( random.Uniform( 1, 10 ) );
+	}
+
+	CREATE_FILL_FLOAT_ARRAY( paramDiff, -1.f, 1.f, vectorSize, random );
+	CREATE_FILL_FLOAT_ARRAY( param, -2.f, 2.f, vectorSize, random );
+	CREATE_FILL_FLOAT_ARRAY( moment, -0.5f, 0.5f, vectorSize, random );
+	CREATE_FILL_FLOAT_ARRAY( secondMoment, 0.f, 0.5f, vectorSize, random );
+	CREATE_FILL_FLOAT_ARRAY( secondMomentMax, 0.f, 0.5f, vectorSize, random );
+
+	std::vector<float> expectedParam = param;
+	std::vector<float> expectedMoment = moment;
+	std::vector<float> expectedSecondMoment = secondMoment;
+	std::vector<float> expectedSecondMomentMax = secondMomentMax;
+	adamStepNaive( stepParams, paramDiff, expectedParam, expectedMoment, expectedSecondMoment,
+		useMax ? &expectedSecondMomentMax : nullptr );
+
+	{
+		CFloatWrapper paramWrapper( MathEngine(), param.data(), vectorSize );
+		CFloatWrapper momentWrapper( MathEngine(), moment.data(), vectorSize );
+		CFloatWrapper secondMomentWrapper( MathEngine(), secondMoment.data(), vectorSize );
+		CFloatWrapper secondMomentMaxWrapper( MathEngine(), secondMomentMax.data(), vectorSize );
+		MathEngine().AdamStep( stepParams, vectorSize, CARRAY_FLOAT_WRAPPER( paramDiff ), paramWrapper,
+			momentWrapper, secondMomentWrapper, useMax ? static_cast<CFloatHandle>( secondMomentMaxWrapper ) : CFloatHandle() );
+	}
+
+	for( int i = 0; i < vectorSize; ++i ) {
+		ASSERT_TRUE( FloatEq( expectedParam[i], param[i], 1e-4f ) );
+		ASSERT_TRUE( FloatEq( expectedMoment[i], moment[i], 1e-4f ) );
+		ASSERT_TRUE( FloatEq( expectedSecondMoment[i], secondMoment[i], 1e-4f ) );
+		if( useMax ) {
+			ASSERT_TRUE( FloatEq( expectedSecondMomentMax[i], secondMomentMax[i], 1e-4f ) );
+		}
+	}
+}
+
+//------------------------------------------------------------------------------------------------------------
+
+class CAdamStepTest : public CTestFixtureWithParams {
+};
+
+INSTANTIATE_TEST_CASE_P( CAdamStepTestInstantiation, CAdamStepTest,
+	::testing::Values(
+		CTestParams(
+			"VectorSize = (1..100);"
+			"TestCount = 100;"
+		),
+		CTestParams(
+			"VectorSize = (10000..50000);"
+			"TestCount = 5;"
+		)
+	)
+);
+
+TEST_P( CAdamStepTest, Random )
+{
+	CMathEngineInfo info;
+	MathEngine().GetMathEngineInfo( info );
+	if( info.Type != MET_Cpu ) {
+		// The fused optimizer steps are supported only on CPU
+		return;
+	}
+
+	RUN_TEST_IMPL( adamStepTestImpl );
+}
@@ -309,3 +309,58 @@ TEST_P( CBlob3dConvolutionBackwardTest, Random )
 {
 	RUN_TEST_IMPL( blob3dConvolutionBackwardImpl );
 }
+
+//------------------------------------------------------------------------------------------------------------
+
+// Calculates the 3d convolution backward with padding 1 and 3x3x3 filter
+static std::vector<float> calcPadded3dConvolutionBackward( IMathEngine& engine, int batchSize, int imageSize,
+	int channels, int filterCount, const std::vector<float>& outputData, const std::vector<float>& filterData,
+	const std::vector<float>& freeTermData )
+{
+	CFloatBlob outBlob( engine, batchSize, imageSize, imageSize, imageSize, filterCount );
+	outBlob.CopyFrom( outputData.data() );
+	CFloatBlob filterBlob( engine, filterCount, 3, 3, 3, channels );
+	filterBlob.CopyFrom( filterData.data() );
+	CFloatBlob freeTermBlob( engine, 1, 1, 1, channels );
+	freeTermBlob.CopyFrom( freeTermData.data() );
+	CFloatBlob inputBlob( engine, batchSize, imageSize, imageSize, imageSize, channels );
+
+	CFloatHandle ft = freeTermBlob.GetData();
+	C3dConvolutionDesc* convDesc = engine.InitBlob3dConvolution( inputBlob.GetDesc(), 1, 1, 1, 1, 1, 1,
+		filterBlob.GetDesc(), outBlob.GetDesc() );
+	engine.Blob3dConvolutionBackward( *convDesc, outBlob.GetData(), filterBlob.GetData(), &ft, inputBlob.GetData() );
+	delete convDesc;
+
+	std::vector<float> result( batchSize * imageSize * imageSize * imageSize * channels );
+	inputBlob.CopyTo( result.data() );
+	return result;
+}
+
+// The second step of the algorithm reads the temporary matrix rows calculated by the other threads
+TEST( CBlob3dConvolutionBackwardMultiThreadTest, SameAsSingleThread )
+{
+	if( MathEngine().GetType() != MET_Cpu ) {
+		return;
+	}
+
+	std::unique_ptr<IMathEngine> singleThreadEngine( CreateCpuMathEngine( 1, 0 ) );
+	std::unique_ptr<IMathEngine> multiThreadEngine( CreateCpuMathEngine( 4, 0 ) );
+	CRandom random( 0x3D7 );
+	const int batchSize = 2;
+	const int imageSize = 9;
+	const int channels = 4;
+	const int filterCount = 6;
+	CREATE_FILL_FLOAT_ARRAY( outputData, -1.f, 1.f, batchSize * imageSize * imageSize * imageSize * filterCount, random )
+	CREATE_FILL_FLOAT_ARRAY( filterData, -1.f, 1.f, filterCount * 3 * 3 * 3 * channels, random )
+	CREATE_FILL_FLOAT_ARRAY( freeTermData, -1.f, 1.f, channels, random )
+
+	const std::vector<float> expected = calcPadded3dConvolutionBackward( *singleThreadEngine, batchSize, imageSize,
+		channels, filterCount, outputData, filterData, freeTermData );
+	for( int run = 0; run < 10; ++run ) {
+		const std::vector<float> actual = calcPadded3dConvolutionBackward( *multiThreadEngine, batchSize, imageSize,
+			channels, filterCount, outputData, filterData, freeTermData );
+		for( size_t i = 0; i < expected.size(); ++i ) {
+			ASSERT_NEAR( expected[i], actual[i], 1e-4f );
+		}
+	}
+}
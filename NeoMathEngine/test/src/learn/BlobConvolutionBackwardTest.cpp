@@ -532,3 +532,62 @@ TEST_P( CMathEngineBlobConvolutionBackwardTest, Random )
 {
 	RUN_TEST_IMPL( blobConvolutionBackwardImpl );
 }
+
+//------------------------------------------------------------------------------------------------------------
+
+// Calculates the convolution backward with padding 1 (the algorithm with the temporary matrix)
+static std::vector<float> calcPaddedConvolutionBackward( IMathEngine& engine, int dilation, int batchSize, int imageSize,
+	int channels, int filterCount, const std::vector<float>& outputData, const std::vector<float>& filterData,
+	const std::vector<float>& freeTermData )
+{
+	const int outputSize = calcConvOutputSize( imageSize, 1, 3, dilation, 1 );
+	CFloatBlob outputBlob( engine, 1, batchSize, 1, outputSize, outputSize, 1, filterCount );
+	outputBlob.CopyFrom( outputData.data() );
+	CFloatBlob filterBlob( engine, filterCount, 3, 3, 1, channels );
+	filterBlob.CopyFrom( filterData.data() );
+	CFloatBlob freeTermBlob( engine, 1, 1, 1, channels );
+	freeTermBlob.CopyFrom( freeTermData.data() );
+	CFloatBlob inputBlob( engine, 1, batchSize, 1, imageSize, imageSize, 1, channels );
+
+	CConvolutionDesc* convDesc = engine.InitBlobConvolution( inputBlob.GetDesc(), 1, 1, 1, 1, dilation, dilation,
+		filterBlob.GetDesc(), outputBlob.GetDesc() );
+	CFloatHandle freeTerm = freeTermBlob.GetData();
+	engine.BlobConvolutionBackward( *convDesc, outputBlob.GetData(), filterBlob.GetData(), &freeTerm, inputBlob.GetData() );
+	delete convDesc;
+
+	std::vector<float> result( batchSize * imageSize * imageSize * channels );
+	inputBlob.CopyTo( result.data() );
+	return result;
+}
+
+// The second step of the algorithm reads the temporary matrix rows calculated by the other threads
+TEST( CMathEngineBlobConvolutionBackwardMultiThreadTest, SameAsSingleThread )
+{
+	if( MathEngine().GetType() != MET_Cpu ) {
+		return;
+	}
+
+	std::unique_ptr<IMathEngine> singleThreadEngine( CreateCpuMathEngine( 1, 0 ) );
+	std::unique_ptr<IMathEngine> multiThreadEngine( CreateCpuMathEngine( 4, 0 ) );
+	CRandom random( 0x6F1 );
+	const int batchSize = 3;
+	const int imageSize = 21;
+	const int channels = 8;
+	const int filterCount = 16;
+	for( int dilation = 1; dilation <= 2; ++dilation ) {
+		const int outputSize = calcConvOutputSize( imageSize, 1, 3, dilation, 1 );
+		CREATE_FILL_FLOAT_ARRAY( outputData, -1.f, 1.f, batchSize * outputSize * outputSize * filterCount, random )
+		CREATE_FILL_FLOAT_ARRAY( filterData, -1.f, 1.f, filterCount * 3 * 3 * channels, random )
+		CREATE_FILL_FLOAT_ARRAY( freeTermData, -1.f, 1.f, channels, random )
+
+		const std::vector<float> expected = calcPaddedConvolutionBackward( *singleThreadEngine, dilation, batchSize,
+			imageSize, channels, filterCount, outputData, filterData, freeTermData );
+		for( int run = 0; run < 10; ++run ) {
+			const std::vector<float> actual = calcPaddedConvolutionBackward( *multiThreadEngine, dilation, batchSize,
+				imageSize, channels, filterCount, outputData, filterData, freeTermData );
+			for( size_t i = 0; i < expected.size(); ++i ) {
+				ASSERT_NEAR( expected[i], actual[i], 1e-4f );
+			}
+		}
+	}
+}
@@ -0,0 +1,103 @@
+/* Copyright © 2017-2021 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <TestFixture.h>
+
+using namespace NeoML;
+using namespace NeoMLTest;
+
+static void lambUpdateTestImpl( const CTestParams& params, int seed )
+{
+	CRandom random( seed );
+	const CInterval vectorSizeInterval = params.GetInterval( "VectorSize" );
+	const int vectorSize = random.UniformInt( vectorSizeInterval.Begin, vectorSizeInterval.End );
+
+	const float gradientMult = random.Next() % 2 == 1 ? static_cast<float>( random.Uniform( 0.1, 1 ) ) : 1.f;
+	const float momentDecayRate = static_cast<float>( random.Uniform( 0.5, 0.99 ) );
+	const float secondMomentDecayRate = static_cast<float>( random.Uniform( 0.9, 0.999 ) );
+	const float epsilon = 1e-6f;
+	const float weightDecay = random.Next() % 2 == 1 ? static_cast<float>( random.Uniform( 0.01, 0.5 ) ) : 0.f;
+
+	CREATE_FILL_FLOAT_ARRAY( paramDiff, -1.f, 1.f, vectorSize, random );
+	CREATE_FILL_FLOAT_ARRAY( param, -2.f, 2.f, vectorSize, random );
+	CREATE_FILL_FLOAT_ARRAY( moment, -0.5f, 0.5f, vectorSize, random );
+	CREATE_FILL_FLOAT_ARRAY( secondMoment, 0.f, 0.5f, vectorSize, random );
+
+	std::vector<float> expectedMoment = moment;
+	std::vector<float> expectedSecondMoment = secondMoment;
+	std::vector<float> expectedUpdate( vectorSize );
+	double expectedNorms[3] = { 0, 0, 0 };
+	for( int i = 0; i < vectorSize; ++i ) {
+		const float diff = gradientMult * paramDiff[i];
+		expectedMoment[i] = momentDecayRate * expectedMoment[i] + ( 1 - momentDecayRate ) * diff;
+		expectedSecondMoment[i] = secondMomentDecayRate * expectedSecondMoment[i]
+			+ ( 1 - secondMomentDecayRate ) * diff * diff;
+		expectedUpdate[i] = expectedMoment[i] / ( sqrtf( expectedSecondMoment[i] ) + epsilon ) + weightDecay * param[i];
+		expectedNorms[0] += diff * diff;
+		expectedNorms[1] += param[i] * param[i];
+		expectedNorms[2] += expectedUpdate[i] * expectedUpdate[i];
+	}
+
+	std::vector<float> update( vectorSize );
+	std::vector<float> norms( 3 );
+	{
+		CFloatWrapper momentWrapper( MathEngine(), moment.data(), vectorSize );
+		CFloatWrapper secondMomentWrapper( MathEngine(), secondMoment.data(), vectorSize );
+		CFloatWrapper updateWrapper( MathEngine(), update.data(), vectorSize );
+		CFloatWrapper normsWrapper( MathEngine(), norms.data(), 3 );
+		MathEngine().LambUpdate( vectorSize, gradientMult, momentDecayRate, secondMomentDecayRate, epsilon, weightDecay,
+			CARRAY_FLOAT_WRAPPER( paramDiff ), CARRAY_FLOAT_WRAPPER( param ), momentWrapper, secondMomentWrapper,
+			updateWrapper, normsWrapper );
+	}
+
+	for( int i = 0; i < vectorSize; ++i ) {
+		ASSERT_TRUE( FloatEq( expectedMoment[i], moment[i], 1e-4f ) );
+		ASSERT_TRUE( FloatEq( expectedSecondMoment[i], secondMoment[i], 1e-4f ) );
+		ASSERT_TRUE( FloatEq( expectedUpdate[i], update[i], 1e-4f ) );
+	}
+	for( int i = 0; i < 3; ++i ) {
+		ASSERT_NEAR( expectedNorms[i], norms[i], 1e-4 * expectedNorms[i] + 1e-4 );
+	}
+}
+
+//------------------------------------------------------------------------------------------------------------
+
+class CLambUpdateTest : public CTestFixtureWithParams {
+};
+
+INSTANTIATE_TEST_CASE_P( CLambUpdateTestInstantiation, CLambUpdateTest,
+	::testing::Values(
+		CTestParams(
+			"VectorSize = (1..100);"
+			"TestCount = 100;"
+		),
+		CTestParams(
+			"VectorSize = (10000..50000);"
+			"TestCount = 5;"
+		)
+	)
+);
+
+TEST_P( CLambUpdateTest, Random )
+{
+	CMathEngineInfo info;
+	MathEngine().GetMathEngineInfo( info );
+	if( info.Type != MET_Cpu ) {
+		// The fused optimizer steps are supported only on CPU
+		return;
+	}
+
+	RUN_TEST_IMPL( lambUpdateTestImpl );
+}
@@ -167,4 +167,55 @@ NEOPROXY_API const char* GetOutputName( const struct CDnnDesc* dnn, int index, s
 // If an error occurs its description will be written into the errorInfo parameter and the function will return 0
 NEOPROXY_API const struct CDnnBlobDesc* GetOutputBlob( const struct CDnnDesc* dnn, int index, struct CDnnErrorInfo* errorInfo );
 
+//------------------------------------------------------------------------------------------------------------
+// Batching executor functions
+
+// The batching executor runs the network for the requests coming from many threads
+// It collects the requests into one batch along the BatchWidth dimension, runs the network once,
+// and splits the outputs between the requests
+// The requests in one batch should have the same input sizes except BatchWidth;
+// all the network outputs should have the BatchWidth equal to the total BatchWidth of the inputs
+struct NEOPROXY_API CDnnBatchExecutorDesc {
+	const CDnnDesc* Dnn; // the network
+	int MaxBatchWidth; // the maximum total BatchWidth of the requests processed together
+	int MaxDelay; // the maximum time in microseconds a request waits for other requests to fill the batch
+};
+
+// The number of elements in the batch size histogram
+// The i-th element counts the batches with the total BatchWidth in [2^i, 2^(i+1)); the last one counts all the larger batches
+enum { DnnBatchSizeHistogramSize = 16 };
+
+// The batching executor statistics
+struct NEOPROXY_API CDnnBatchExecutorStats {
+	int QueueDepth; // the number of requests waiting in the queue
+	long long RequestCount; // the total number of processed requests
+	long long BatchCount; // the total number of network runs
+	long long BatchSizeHistogram[DnnBatchSizeHistogramSize]; // the distribution of the batch sizes
+	long long P99Latency; // the 99th percentile of the request latency in microseconds, over the last 1024 requests
+};
+
+// Creates the batching executor for the network
+// The network may not be used directly (with SetInputBlob, DnnRunOnce) or destroyed while the executor exists
+// The executor should be destroyed after use with the help of the DestroyDnnBatchExecutor function
+// If an error occurs its description will be written into the errorInfo parameter and the function will return 0
+NEOPROXY_API const struct CDnnBatchExecutorDesc* CreateDnnBatchExecutor( const struct CDnnDesc* dnn, int maxBatchWidth,
+	int maxDelay, struct CDnnErrorInfo* errorInfo );
+
+// Destroys the batching executor; the requests already in the queue are processed before that
+NEOPROXY_API void DestroyDnnBatchExecutor( const struct CDnnBatchExecutorDesc* executor );
+
+// Runs the network for one request; may be called from several threads at the same time
+// inputs are the blobs for all the network inputs (InputCount elements), in the order of GetInputName
+// outputs receive the blobs for all the network outputs (OutputCount elements), in the order of GetOutputName
+// The output blobs should be destroyed after use with the help of the DestroyDnnBlob function
+// The call returns after the request has been processed
+// If an error occurs its description will be written into the errorInfo parameter and the function will return false
+NEOPROXY_API bool DnnBatchExecutorRun( const struct CDnnBatchExecutorDesc* executor, const struct CDnnBlobDesc* const* inputs,
+	const struct CDnnBlobDesc** outputs, struct CDnnErrorInfo* errorInfo );
+
+// Retrieves the executor statistics
+// If an error occurs its description will be written into the errorInfo parameter and the function will return false
+NEOPROXY_API bool GetDnnBatchExecutorStats( const struct CDnnBatchExecutorDesc* executor, struct CDnnBatchExecutorStats* stats,
+	struct CDnnErrorInfo* errorInfo );
+
 } // extern "C"
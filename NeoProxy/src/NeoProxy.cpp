@@ -23,6 +23,11 @@ limitations under the License.
 #include <NeoOnnx/NeoOnnx.h>
 
 #include <cstdio>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 using namespace NeoML;
 
@@ -734,4 +739,410 @@ const struct CDnnBlobDesc* GetOutputBlob( const struct CDnnDesc* dnnDesc, int in
 	return nullptr;
 }
 
+//------------------------------------------------------------------------------------------------------------
+// CDnnBatchExecutorDesc implementation
+
+// A request to the batching executor
+struct CBatchRequest {
+	CObjectArray<CDnnBlob> Inputs;
+	CObjectArray<CDnnBlob> Outputs;
+	std::chrono::steady_clock::time_point StartTime; // the time the request was put into the queue
+	bool IsDone;
+	bool IsSucceeded;
+	CDnnErrorInfo ErrorInfo;
+
+	CBatchRequest() : IsDone( false ), IsSucceeded( false ) {}
+};
+
+class CDnnBatchExecutorImpl : public CDnnBatchExecutorDesc {
+public:
+	CDnnBatchExecutorImpl( const CDnnDescImpl* dnn, int maxBatchWidth, int maxDelay );
+	~CDnnBatchExecutorImpl();
+
+	// Puts the request into the queue and waits until it is processed
+	void Run( CBatchRequest& request );
+
+	void GetStats( CDnnBatchExecutorStats& stats ) const;
+
+private:
+	// The number of the last requests used for the latency percentile
+	static const int LatencyWindowSize = 1024;
+
+	const CDnnDescImpl& dnn;
+	mutable std::mutex mutex;
+	std::condition_variable queueCondition; // signals a new request or the stop
+	std::condition_variable doneCondition; // signals the processed requests
+	CArray<CBatchRequest*> queue;
+	bool isStopped;
+	// The statistics
+	long long requestCount;
+	long long batchCount;
+	long long batchSizeHistogram[DnnBatchSizeHistogramSize];
+	CArray<long long> latencies; // the ring buffer of the last latencies
+	std::thread worker;
+
+	void run();
+	int collectBatch( CArray<CBatchRequest*>& batch ) const;
+	void extractBatch( const CArray<CBatchRequest*>& batch );
+	void runBatch( const CArray<CBatchRequest*>& batch, int batchWidth );
+	void onBatchDone( const CArray<CBatchRequest*>& batch, int batchWidth );
+};
+
+CDnnBatchExecutorImpl::CDnnBatchExecutorImpl( const CDnnDescImpl* _dnn, int maxBatchWidth, int maxDelay ) :
+	dnn( *_dnn ),
+	isStopped( false ),
+	requestCount( 0 ),
+	batchCount( 0 )
+{
+	CDnnBatchExecutorDesc::Dnn = _dnn;
+	CDnnBatchExecutorDesc::MaxBatchWidth = maxBatchWidth;
+	CDnnBatchExecutorDesc::MaxDelay = maxDelay;
+	for( int i = 0; i < DnnBatchSizeHistogramSize; ++i ) {
+		batchSizeHistogram[i] = 0;
+	}
+	worker = std::thread( &CDnnBatchExecutorImpl::run, this );
+}
+
+CDnnBatchExecutorImpl::~CDnnBatchExecutorImpl()
+{
+	{
+		std::lock_guard<std::mutex> lock( mutex );
+		isStopped = true;
+	}
+	queueCondition.notify_one();
+	worker.join();
+}
+
+void CDnnBatchExecutorImpl::Run( CBatchRequest& request )
+{
+	std::unique_lock<std::mutex> lock( mutex );
+	request.StartTime = std::chrono::steady_clock::now();
+	queue.Add( &request );
+	queueCondition.notify_one();
+	doneCondition.wait( lock, [&request] { return request.IsDone; } );
+}
+
+void CDnnBatchExecutorImpl::GetStats( CDnnBatchExecutorStats& stats ) const
+{
+	CArray<long long> sortedLatencies;
+	{
+		std::lock_guard<std::mutex> lock( mutex );
+		stats.QueueDepth = queue.Size();
+		stats.RequestCount = requestCount;
+		stats.BatchCount = batchCount;
+		for( int i = 0; i < DnnBatchSizeHistogramSize; ++i ) {
+			stats.BatchSizeHistogram[i] = batchSizeHistogram[i];
+		}
+		latencies.CopyTo( sortedLatencies );
+	}
+
+	stats.P99Latency = 0;
+	if( !sortedLatencies.IsEmpty() ) {
+		const int index = ( sortedLatencies.Size() * 99 ) / 100;
+		std::nth_element( sortedLatencies.GetPtr(), sortedLatencies.GetPtr() + index,
+			sortedLatencies.GetPtr() + sortedLatencies.Size() );
+		stats.P99Latency = sortedLatencies[index];
+	}
+}
+
+// The worker thread: waits until the batch is full or its first request has waited for MaxDelay, then runs the network
+void CDnnBatchExecutorImpl::run()
+{
+	std::unique_lock<std::mutex> lock( mutex );
+	while( true ) {
+		queueCondition.wait( lock, [this] { return isStopped || !queue.IsEmpty(); } );
+		if( queue.IsEmpty() ) {
+			// Stopped and all the requests are processed
+			return;
+		}
+
+		const std::chrono::steady_clock::time_point deadline = queue[0]->StartTime + std::chrono::microseconds( MaxDelay );
+		CArray<CBatchRequest*> batch;
+		int batchWidth = collectBatch( batch );
+		while( !isStopped && batchWidth < MaxBatchWidth
+			&& queueCondition.wait_until( lock, deadline ) != std::cv_status::timeout )
+		{
+			batchWidth = collectBatch( batch );
+		}
+		batchWidth = collectBatch( batch );
+		extractBatch( batch );
+
+		lock.unlock();
+		runBatch( batch, batchWidth );
+		lock.lock();
+
+		onBatchDone( batch, batchWidth );
+		doneCondition.notify_all();
+	}
+}
+
+// Checks if the blob may be merged with another one along the BatchWidth dimension
+static bool isMergeable( const CDnnBlob& first, const CDnnBlob& second )
+{
+	if( first.GetDataType() != second.GetDataType() ) {
+		return false;
+	}
+	for( TBlobDim d = TBlobDim( 0 ); d < BD_Count; ++d ) {
+		if( d != BD_BatchWidth && first.DimSize( d ) != second.DimSize( d ) ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Selects the requests from the queue that may be processed together with the first one
+// Returns the total BatchWidth of the selected requests
+int CDnnBatchExecutorImpl::collectBatch( CArray<CBatchRequest*>& batch ) const
+{
+	batch.DeleteAll();
+	int batchWidth = 0;
+	for( int i = 0; i < queue.Size(); ++i ) {
+		CBatchRequest* request = queue[i];
+		const int requestWidth = request->Inputs.IsEmpty() ? 1 : request->Inputs[0]->GetBatchWidth();
+		if( !batch.IsEmpty() ) {
+			if( batchWidth + requestWidth > MaxBatchWidth ) {
+				continue;
+			}
+			bool isCompatible = true;
+			for( int j = 0; j < request->Inputs.Size() && isCompatible; ++j ) {
+				isCompatible = isMergeable( *batch[0]->Inputs[j], *request->Inputs[j] );
+			}
+			if( !isCompatible ) {
+				continue;
+			}
+		}
+		batch.Add( request );
+		batchWidth += requestWidth;
+		if( batchWidth >= MaxBatchWidth ) {
+			break;
+		}
+	}
+	return batchWidth;
+}
+
+// Removes the batch requests from the queue
+void CDnnBatchExecutorImpl::extractBatch( const CArray<CBatchRequest*>& batch )
+{
+	int batchIndex = 0;
+	int newSize = 0;
+	for( int i = 0; i < queue.Size(); ++i ) {
+		if( batchIndex < batch.Size() && queue[i] == batch[batchIndex] ) {
+			++batchIndex;
+		} else {
+			queue[newSize++] = queue[i];
+		}
+	}
+	queue.SetSize( newSize );
+}
+
+// Sets the error for all the requests in the batch
+static void setBatchError( const CArray<CBatchRequest*>& batch, TDnnErrorType errorType, const char* errorText )
+{
+	for( int i = 0; i < batch.Size(); ++i ) {
+		initErrorInfo( errorType, errorText, &batch[i]->ErrorInfo );
+		batch[i]->IsSucceeded = false;
+	}
+}
+
+// Runs the network for the batch; called without the lock
+void CDnnBatchExecutorImpl::runBatch( const CArray<CBatchRequest*>& batch, int batchWidth )
+{
+	try {
+		IMathEngine& mathEngine = dnn.Dnn().GetMathEngine();
+		// Merge the inputs
+		for( int i = 0; i < dnn.InputCount; ++i ) {
+			if( batch.Size() == 1 ) {
+				dnn.SetInputBlob( i, batch[0]->Inputs[i] );
+				continue;
+			}
+			CObjectArray<CDnnBlob> parts;
+			for( int j = 0; j < batch.Size(); ++j ) {
+				parts.Add( batch[j]->Inputs[i] );
+			}
+			CBlobDesc desc = parts[0]->GetDesc();
+			desc.SetDimSize( BD_BatchWidth, batchWidth );
+			CPtr<CDnnBlob> input = CDnnBlob::CreateBlob( mathEngine, parts[0]->GetDataType(), desc );
+			CDnnBlob::MergeByBatchWidth( mathEngine, parts, input );
+			dnn.SetInputBlob( i, input );
+		}
+
+		CDnnErrorInfo errorInfo;
+		if( !dnn.RunOnce( &errorInfo ) ) {
+			setBatchError( batch, errorInfo.Type, errorInfo.Description );
+			return;
+		}
+
+		// Split the outputs
+		for( int i = 0; i < dnn.GetOutputCount(); ++i ) {
+			CPtr<CDnnBlob> output = dnn.GetOutputBlob( i );
+			if( output == nullptr || output->GetBatchWidth() != batchWidth ) {
+				setBatchError( batch, DET_RunDnnError, "The output BatchWidth doesn't match the input BatchWidth." );
+				return;
+			}
+			// The sink blob is overwritten on the next run
+			CObjectArray<CDnnBlob> parts;
+			for( int j = 0; j < batch.Size(); ++j ) {
+				CBlobDesc desc = output->GetDesc();
+				desc.SetDimSize( BD_BatchWidth, batch.Size() == 1 ? batchWidth : batch[j]->Inputs[0]->GetBatchWidth() );
+				parts.Add( CDnnBlob::CreateBlob( mathEngine, output->GetDataType(), desc ) );
+				batch[j]->Outputs.Add( parts.Last() );
+			}
+			if( batch.Size() == 1 ) {
+				parts[0]->CopyFrom( output );
+			} else {
+				CDnnBlob::SplitByBatchWidth( mathEngine, output, parts );
+			}
+		}
+		for( int i = 0; i < batch.Size(); ++i ) {
+			batch[i]->IsSucceeded = true;
+		}
+#ifdef NEOML_USE_FINEOBJ
+	} catch( CException* e ) {
+		setBatchError( batch, DET_InternalError, e->MessageText().CreateString( CP_UTF8 ) );
+		delete e;
+	}
+#else
+	} catch( std::exception& e ) {
+		setBatchError( batch, DET_InternalError, e.what() );
+	}
+#endif
+}
+
+// Updates the statistics and marks the requests as processed; called under the lock
+void CDnnBatchExecutorImpl::onBatchDone( const CArray<CBatchRequest*>& batch, int batchWidth )
+{
+	++batchCount;
+	int bucket = 0;
+	while( bucket < DnnBatchSizeHistogramSize - 1 && ( batchWidth >> ( bucket + 1 ) ) > 0 ) {
+		++bucket;
+	}
+	++batchSizeHistogram[bucket];
+
+	const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	for( int i = 0; i < batch.Size(); ++i ) {
+		const long long latency = std::chrono::duration_cast<std::chrono::microseconds>( now - batch[i]->StartTime ).count();
+		if( latencies.Size() < LatencyWindowSize ) {
+			latencies.Add( latency );
+		} else {
+			latencies[requestCount % LatencyWindowSize] = latency;
+		}
+		++requestCount;
+		batch[i]->IsDone = true;
+	}
+}
+
+//------------------------------------------------------------------------------------------------------------
+// Batching executor functions
+
+const struct CDnnBatchExecutorDesc* CreateDnnBatchExecutor( const struct CDnnDesc* dnnDesc, int maxBatchWidth,
+	int maxDelay, struct CDnnErrorInfo* errorInfo )
+{
+	if( dnnDesc == 0 ) {
+		initErrorInfo( DET_InvalidParameter, "Invalid CDnnDesc parameter.", errorInfo );
+		return nullptr;
+	}
+	if( maxBatchWidth <= 0 ) {
+		initErrorInfo( DET_InvalidParameter, "Invalid maxBatchWidth parameter.", errorInfo );
+		return nullptr;
+	}
+	if( maxDelay < 0 ) {
+		initErrorInfo( DET_InvalidParameter, "Invalid maxDelay parameter.", errorInfo );
+		return nullptr;
+	}
+
+	try {
+		return FINE_DEBUG_NEW CDnnBatchExecutorImpl( static_cast<const CDnnDescImpl*>( dnnDesc ), maxBatchWidth, maxDelay );
+#ifdef NEOML_USE_FINEOBJ
+	} catch( CException* e ) {
+		initErrorInfo( DET_InternalError, e->MessageText().CreateString( CP_UTF8 ), errorInfo );
+		delete e;
+	}
+#else
+	} catch( std::exception& e ) {
+		initErrorInfo( DET_InternalError, e.what(), errorInfo );
+	}
+#endif
+	return nullptr;
+}
+
+void DestroyDnnBatchExecutor( const struct CDnnBatchExecutorDesc* executor )
+{
+	delete static_cast<const CDnnBatchExecutorImpl*>( executor );
+}
+
+bool DnnBatchExecutorRun( const struct CDnnBatchExecutorDesc* executorDesc, const struct CDnnBlobDesc* const* inputs,
+	const struct CDnnBlobDesc** outputs, struct CDnnErrorInfo* errorInfo )
+{
+	if( executorDesc == 0 ) {
+		initErrorInfo( DET_InvalidParameter, "Invalid CDnnBatchExecutorDesc parameter.", errorInfo );
+		return false;
+	}
+	const CDnnDesc* dnnDesc = executorDesc->Dnn;
+	if( ( inputs == 0 && dnnDesc->InputCount > 0 ) || ( outputs == 0 && dnnDesc->OutputCount > 0 ) ) {
+		initErrorInfo( DET_InvalidParameter, "Invalid inputs or outputs parameter.", errorInfo );
+		return false;
+	}
+
+	CBatchRequest request;
+	for( int i = 0; i < dnnDesc->InputCount; ++i ) {
+		if( inputs[i] == 0 || inputs[i]->MathEngine != dnnDesc->MathEngine ) {
+			initErrorInfo( DET_InvalidParameter, "Invalid CDnnBlobDesc parameter.", errorInfo );
+			return false;
+		}
+		const CPtr<CDnnBlob>& blob = static_cast<const CDnnBlobDescImpl*>( inputs[i] )->Blob;
+		if( i > 0 && blob->GetBatchWidth() != request.Inputs[0]->GetBatchWidth() ) {
+			initErrorInfo( DET_InvalidParameter, "All the inputs should have the same BatchWidth.", errorInfo );
+			return false;
+		}
+		request.Inputs.Add( blob );
+	}
+
+	CDnnBatchExecutorImpl* executor = const_cast<CDnnBatchExecutorImpl*>( static_cast<const CDnnBatchExecutorImpl*>( executorDesc ) );
+	executor->Run( request );
+	if( !request.IsSucceeded ) {
+		initErrorInfo( request.ErrorInfo.Type, request.ErrorInfo.Description, errorInfo );
+		return false;
+	}
+
+	const CDnnMathEngineDescImpl* mathEngineDescImpl = static_cast<const CDnnMathEngineDescImpl*>( dnnDesc->MathEngine );
+	try {
+		for( int i = 0; i < dnnDesc->OutputCount; ++i ) {
+			outputs[i] = nullptr;
+		}
+		for( int i = 0; i < dnnDesc->OutputCount; ++i ) {
+			outputs[i] = FINE_DEBUG_NEW CDnnBlobDescImpl( request.Outputs[i], mathEngineDescImpl );
+		}
+		return true;
+#ifdef NEOML_USE_FINEOBJ
+	} catch( CException* e ) {
+		initErrorInfo( DET_InternalError, e->MessageText().CreateString( CP_UTF8 ), errorInfo );
+		delete e;
+	}
+#else
+	} catch( std::exception& e ) {
+		initErrorInfo( DET_InternalError, e.what(), errorInfo );
+	}
+#endif
+	for( int i = 0; i < dnnDesc->OutputCount; ++i ) {
+		DestroyDnnBlob( outputs[i] );
+		outputs[i] = nullptr;
+	}
+	return false;
+}
+
+bool GetDnnBatchExecutorStats( const struct CDnnBatchExecutorDesc* executorDesc, struct CDnnBatchExecutorStats* stats,
+	struct CDnnErrorInfo* errorInfo )
+{
+	if( executorDesc == 0 ) {
+		initErrorInfo( DET_InvalidParameter, "Invalid CDnnBatchExecutorDesc parameter.", errorInfo );
+		return false;
+	}
+	if( stats == 0 ) {
+		initErrorInfo( DET_InvalidParameter, "Invalid CDnnBatchExecutorStats parameter.", errorInfo );
+		return false;
+	}
+	static_cast<const CDnnBatchExecutorImpl*>( executorDesc )->GetStats( *stats );
+	return true;
+}
+
 } // extern "C"
@@ -0,0 +1,169 @@
+/* Copyright © 2017-2020 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <NeoProxy/NeoProxy.h>
+#include <NeoML/NeoML.h>
+#include <NeoMathEngine/NeoMathEngine.h>
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+
+static const int InputSize = 7;
+static const int OutputSize = 5;
+
+// Stores the network with one fully connected layer into the file
+static void storeTestNetwork( const char* fileName )
+{
+	std::unique_ptr<NeoML::IMathEngine> mathEngine( NeoML::CreateCpuMathEngine( 1, 0 ) );
+	NeoML::CRandom random( 0x3F1 );
+	NeoML::CDnn dnn( random, *mathEngine );
+	NeoML::CSourceLayer* source = NeoML::Source( dnn, "in" );
+	NeoML::CFullyConnectedLayer* fc = NeoML::FullyConnected( OutputSize )( "fc", source );
+	NeoML::Sink( fc, "out" );
+	// The parameters are initialized on the first run
+	CPtr<NeoML::CDnnBlob> input = NeoML::CDnnBlob::CreateDataBlob( *mathEngine, NeoML::CT_Float, 1, 1, InputSize );
+	input->Fill( 1.f );
+	source->SetBlob( input );
+	dnn.RunOnce();
+
+	NeoML::CArchiveFile file( fileName, CArchive::store );
+	CArchive archive( &file, CArchive::SD_Storing );
+	archive.Serialize( dnn );
+}
+
+// The request of one thread
+struct CTestRequest {
+	std::vector<float> Input;
+	std::vector<float> Expected;
+	std::vector<float> Output;
+	bool Success = false;
+};
+
+static const CDnnBlobDesc* createInputBlob( const CDnnMathEngineDesc* mathEngine, const std::vector<float>& data )
+{
+	CDnnErrorInfo errorInfo;
+	const int batchWidth = static_cast<int>( data.size() ) / InputSize;
+	const CDnnBlobDesc* blob = CreateDnnBlob( mathEngine, DBT_Float, 1, batchWidth, 1, 1, 1, InputSize, &errorInfo );
+	if( blob != nullptr && !CopyToBlob( blob, data.data(), &errorInfo ) ) {
+		DestroyDnnBlob( blob );
+		return nullptr;
+	}
+	return blob;
+}
+
+static std::vector<float> readBlob( const CDnnBlobDesc* blob )
+{
+	CDnnErrorInfo errorInfo;
+	std::vector<float> result( blob->DataSize / sizeof( float ) );
+	EXPECT_TRUE( CopyFromBlob( result.data(), blob, &errorInfo ) );
+	return result;
+}
+
+// The concurrent requests processed in batches get the same outputs as the requests run one by one
+TEST( NeoProxyBatchExecutorTest, ConcurrentRequests )
+{
+	const char* fileName = "neoproxy_batch_test.arch";
+	storeTestNetwork( fileName );
+
+	CDnnErrorInfo errorInfo;
+	const CDnnMathEngineDesc* mathEngine = CreateCPUMathEngine( 1, &errorInfo );
+	ASSERT_NE( nullptr, mathEngine ) << errorInfo.Description;
+	const CDnnDesc* dnn = CreateDnnFromFile( mathEngine, fileName, &errorInfo );
+	::remove( fileName );
+	ASSERT_NE( nullptr, dnn ) << errorInfo.Description;
+	ASSERT_EQ( 1, dnn->InputCount );
+	ASSERT_EQ( 1, dnn->OutputCount );
+
+	// The requests have different BatchWidth
+	const int requestCount = 24;
+	NeoML::CRandom random( 0x51 );
+	std::vector<CTestRequest> requests( requestCount );
+	for( int i = 0; i < requestCount; ++i ) {
+		const int batchWidth = 1 + i % 3;
+		for( int j = 0; j < batchWidth * InputSize; ++j ) {
+			requests[i].Input.push_back( static_cast<float>( random.Uniform( -1, 1 ) ) );
+		}
+
+		const CDnnBlobDesc* input = createInputBlob( mathEngine, requests[i].Input );
+		ASSERT_NE( nullptr, input );
+		ASSERT_TRUE( SetInputBlob( dnn, 0, input, &errorInfo ) ) << errorInfo.Description;
+		ASSERT_TRUE( DnnRunOnce( dnn, &errorInfo ) ) << errorInfo.Description;
+		const CDnnBlobDesc* output = GetOutputBlob( dnn, 0, &errorInfo );
+		ASSERT_NE( nullptr, output ) << errorInfo.Description;
+		requests[i].Expected = readBlob( output );
+		ASSERT_EQ( static_cast<size_t>( batchWidth * OutputSize ), requests[i].Expected.size() );
+		DestroyDnnBlob( output );
+		DestroyDnnBlob( input );
+	}
+
+	const int maxBatchWidth = 8;
+	// The requests wait long enough for the others, so that some of them are processed together
+	const CDnnBatchExecutorDesc* executor = CreateDnnBatchExecutor( dnn, maxBatchWidth, 200000, &errorInfo );
+	ASSERT_NE( nullptr, executor ) << errorInfo.Description;
+
+	std::vector<std::thread> threads;
+	for( int i = 0; i < requestCount; ++i ) {
+		threads.emplace_back( [&, i] {
+			CTestRequest& request = requests[i];
+			CDnnErrorInfo threadErrorInfo;
+			const CDnnBlobDesc* input = createInputBlob( mathEngine, request.Input );
+			const CDnnBlobDesc* output = nullptr;
+			if( input != nullptr && DnnBatchExecutorRun( executor, &input, &output, &threadErrorInfo ) ) {
+				request.Output = readBlob( output );
+				request.Success = true;
+				DestroyDnnBlob( output );
+			}
+			if( input != nullptr ) {
+				DestroyDnnBlob( input );
+			}
+		} );
+	}
+	for( std::thread& thread : threads ) {
+		thread.join();
+	}
+
+	for( int i = 0; i < requestCount; ++i ) {
+		ASSERT_TRUE( requests[i].Success );
+		ASSERT_EQ( requests[i].Expected.size(), requests[i].Output.size() );
+		for( size_t j = 0; j < requests[i].Expected.size(); ++j ) {
+			EXPECT_NEAR( requests[i].Expected[j], requests[i].Output[j], 1e-5f );
+		}
+	}
+
+	CDnnBatchExecutorStats stats;
+	ASSERT_TRUE( GetDnnBatchExecutorStats( executor, &stats, &errorInfo ) ) << errorInfo.Description;
+	EXPECT_EQ( 0, stats.QueueDepth );
+	EXPECT_EQ( requestCount, stats.RequestCount );
+	// The total BatchWidth of the requests is 48, so there are at least 6 batches
+	EXPECT_LE( 6, stats.BatchCount );
+	EXPECT_GT( requestCount, stats.BatchCount );
+	long long histogramSum = 0;
+	for( int i = 0; i < DnnBatchSizeHistogramSize; ++i ) {
+		histogramSum += stats.BatchSizeHistogram[i];
+	}
+	EXPECT_EQ( stats.BatchCount, histogramSum );
+	// No batch is larger than maxBatchWidth
+	for( int i = 4; i < DnnBatchSizeHistogramSize; ++i ) {
+		EXPECT_EQ( 0, stats.BatchSizeHistogram[i] );
+	}
+	EXPECT_LE( 0, stats.P99Latency );
+
+	DestroyDnnBatchExecutor( executor );
+	DestroyDnn( dnn );
+	DestroyMathEngine( mathEngine );
+}